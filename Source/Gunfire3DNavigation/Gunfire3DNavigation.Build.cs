@@ -38,11 +38,14 @@ namespace UnrealBuildTool.Rules
 					"RHI",
 					"RenderCore",
 					"NavigationSystem",
+					"TraceLog",
 				});
 
 			if (Target.bBuildEditor == true)
 			{
 				PrivateDependencyModuleNames.Add("UnrealEd");
+				PrivateDependencyModuleNames.Add("DerivedDataCache");
+				PrivateDependencyModuleNames.Add("Gunfire3DNavigationShaders");
 			}
 		}
 	}
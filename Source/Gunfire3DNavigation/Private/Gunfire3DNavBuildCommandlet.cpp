@@ -0,0 +1,363 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "Gunfire3DNavBuildCommandlet.h"
+
+#include "Gunfire3DNavData.h"
+#include "Gunfire3DNavigationCustomVersion.h"
+#include "NavSvo/NavSvoGenerator.h"
+#include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
+
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/CustomVersion.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace Gunfire3DNavBuild
+{
+	// Identifies a shard file, and the version of its layout
+	static constexpr uint32 ShardMagic = 0x53334447; // 'GD3S'
+	static constexpr int32 ShardVersion = 1;
+}
+
+int32 UGunfire3DNavBuildCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: No map specified (-Map=<Map>)"));
+		return 1;
+	}
+
+	int32 NumShards = 1;
+	FParse::Value(*Params, TEXT("Shards="), NumShards);
+	NumShards = FMath::Max(NumShards, 1);
+
+	int32 ShardIdx = INDEX_NONE;
+	FParse::Value(*Params, TEXT("Shard="), ShardIdx);
+
+	FString OutputDir = FPaths::ProjectIntermediateDir() / TEXT("Gunfire3DNavBuild");
+	FParse::Value(*Params, TEXT("Output="), OutputDir);
+
+	const bool bIsWorker = (ShardIdx != INDEX_NONE);
+	if (bIsWorker && !ensure(ShardIdx >= 0 && ShardIdx < NumShards))
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Shard %d is out of range for %d shards"), ShardIdx, NumShards);
+		return 1;
+	}
+
+	// Launch the workers before loading the map ourselves, so we aren't holding on to
+	// its memory while they run.
+	if (!bIsWorker && NumShards > 1 && !RunWorkers(MapName, NumShards, OutputDir))
+	{
+		return 1;
+	}
+
+	UWorld* World = LoadWorld(MapName);
+	if (World == nullptr)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Failed to load map '%s'"), *MapName);
+		return 1;
+	}
+
+	// Only nav data saved in the map is built, since the workers and the merge need to
+	// agree on which actors exist.
+	if (!TActorIterator<AGunfire3DNavData>(World))
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("Gunfire3DNavBuild: No 3D nav data in map '%s'"), *MapName);
+	}
+
+	bool bSuccess = true;
+
+	if (bIsWorker)
+	{
+		BuildShard(World, NumShards, ShardIdx);
+
+		for (TActorIterator<AGunfire3DNavData> It(World); It; ++It)
+		{
+			bSuccess &= WriteShard(*It, GetShardFilename(*It, ShardIdx, OutputDir));
+		}
+	}
+	else
+	{
+		if (NumShards > 1)
+		{
+			for (TActorIterator<AGunfire3DNavData> It(World); It; ++It)
+			{
+				bSuccess &= MergeShards(*It, NumShards, OutputDir);
+			}
+		}
+		else
+		{
+			BuildShard(World, 1, 0);
+		}
+
+		bSuccess = bSuccess && SaveWorld(World);
+	}
+
+	UnloadWorld(World);
+
+	return bSuccess ? 0 : 1;
+#else
+	UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Only supported in editor builds"));
+	return 1;
+#endif // WITH_EDITOR
+}
+
+UWorld* UGunfire3DNavBuildCommandlet::LoadWorld(const FString& MapName)
+{
+	FString PackageName;
+	if (!FPackageName::SearchForPackageOnDisk(MapName, &PackageName))
+	{
+		return nullptr;
+	}
+
+	UPackage* Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+	WorldContext.SetCurrentWorld(World);
+	GWorld = World;
+
+	if (!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues IVS;
+		IVS.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(false)
+			.CreateNavigation(true)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+
+		World->InitWorld(IVS);
+		World->PersistentLevel->UpdateModelComponents();
+		World->UpdateWorldComponents(true, false);
+	}
+
+	return World;
+}
+
+void UGunfire3DNavBuildCommandlet::UnloadWorld(UWorld* World)
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+}
+
+bool UGunfire3DNavBuildCommandlet::SaveWorld(UWorld* World)
+{
+	UPackage* Package = World->GetOutermost();
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetMapPackageExtension());
+
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Standalone;
+	SaveArgs.SaveFlags = SAVE_NoError;
+
+	if (!UPackage::SavePackage(Package, World, *Filename, SaveArgs))
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Failed to save '%s'"), *Filename);
+		return false;
+	}
+
+	return true;
+}
+
+void UGunfire3DNavBuildCommandlet::BuildShard(UWorld* World, int32 NumShards, int32 ShardIdx)
+{
+	// Nothing else is running, so use as many threads as we can
+	AGunfire3DNavData::SetGenerationBoostMode(true);
+
+	for (TActorIterator<AGunfire3DNavData> It(World); It; ++It)
+	{
+		AGunfire3DNavData* NavData = *It;
+		NavData->ConditionalConstructGenerator();
+
+		if (FNavSvoGenerator* Generator = NavData->GetNavSvoGenerator())
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			Generator->SetTileShard(NumShards, ShardIdx);
+			Generator->RebuildAll();
+			NavData->EnsureBuildCompletion();
+
+			const FEditableSvo* Octree = NavData->GetOctree();
+			UE_LOG(LogNavigation, Display, TEXT("Gunfire3DNavBuild: Built %d tiles for %s (shard %d/%d) in %.2fs"),
+				Octree ? Octree->GetTiles().Num() : 0, *NavData->GetName(), ShardIdx + 1, NumShards, FPlatformTime::Seconds() - StartTime);
+		}
+	}
+
+	AGunfire3DNavData::SetGenerationBoostMode(false);
+}
+
+bool UGunfire3DNavBuildCommandlet::RunWorkers(const FString& MapName, int32 NumShards, const FString& OutputDir)
+{
+	IFileManager::Get().MakeDirectory(*OutputDir, true);
+
+	const FString ExecutablePath = FPlatformProcess::ExecutablePath();
+	const FString ProjectPath = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+
+	TArray<FProcHandle> Workers;
+	for (int32 ShardIdx = 0; ShardIdx < NumShards; ++ShardIdx)
+	{
+		const FString WorkerParams = FString::Printf(TEXT("\"%s\" -run=Gunfire3DNavBuild -Map=\"%s\" -Shards=%d -Shard=%d -Output=\"%s\" -unattended -nullrhi -nosplash"),
+			*ProjectPath, *MapName, NumShards, ShardIdx, *OutputDir);
+
+		FProcHandle Worker = FPlatformProcess::CreateProc(*ExecutablePath, *WorkerParams, true, false, false, nullptr, 0, nullptr, nullptr);
+		if (!Worker.IsValid())
+		{
+			UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Failed to launch worker for shard %d"), ShardIdx);
+		}
+
+		Workers.Add(Worker);
+	}
+
+	bool bSuccess = true;
+	for (int32 ShardIdx = 0; ShardIdx < Workers.Num(); ++ShardIdx)
+	{
+		FProcHandle& Worker = Workers[ShardIdx];
+		if (!Worker.IsValid())
+		{
+			bSuccess = false;
+			continue;
+		}
+
+		FPlatformProcess::WaitForProc(Worker);
+
+		int32 ReturnCode = 0;
+		if (!FPlatformProcess::GetProcReturnCode(Worker, &ReturnCode) || ReturnCode != 0)
+		{
+			UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Worker for shard %d failed (%d)"), ShardIdx, ReturnCode);
+			bSuccess = false;
+		}
+
+		FPlatformProcess::CloseProc(Worker);
+	}
+
+	return bSuccess;
+}
+
+bool UGunfire3DNavBuildCommandlet::WriteShard(AGunfire3DNavData* NavData, const FString& Filename)
+{
+	FEditableSvo* Octree = NavData->GetOctree();
+	if (Octree == nullptr)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: No octree was built for %s"), *NavData->GetName());
+		return false;
+	}
+
+	// The octree is serialized to memory first, since the custom versions it uses need
+	// to be written before it.
+	TArray<uint8> OctreeData;
+	FMemoryWriter OctreeWriter(OctreeData, true);
+	Octree->Serialize(OctreeWriter);
+
+	FCustomVersionContainer CustomVersions = OctreeWriter.GetCustomVersions();
+
+	TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!FileWriter)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Failed to write '%s'"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = Gunfire3DNavBuild::ShardMagic;
+	int32 Version = Gunfire3DNavBuild::ShardVersion;
+	*FileWriter << Magic;
+	*FileWriter << Version;
+	CustomVersions.Serialize(*FileWriter);
+	*FileWriter << OctreeData;
+
+	return FileWriter->Close();
+}
+
+bool UGunfire3DNavBuildCommandlet::MergeShards(AGunfire3DNavData* NavData, int32 NumShards, const FString& OutputDir)
+{
+	FEditableSvoSharedPtr MergedOctree;
+
+	for (int32 ShardIdx = 0; ShardIdx < NumShards; ++ShardIdx)
+	{
+		const FString Filename = GetShardFilename(NavData, ShardIdx, OutputDir);
+
+		TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*Filename));
+		if (!FileReader)
+		{
+			UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Missing shard '%s'"), *Filename);
+			return false;
+		}
+
+		uint32 Magic = 0;
+		int32 Version = 0;
+		*FileReader << Magic;
+		*FileReader << Version;
+
+		if (Magic != Gunfire3DNavBuild::ShardMagic || Version != Gunfire3DNavBuild::ShardVersion)
+		{
+			UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: '%s' isn't a valid shard"), *Filename);
+			return false;
+		}
+
+		FCustomVersionContainer CustomVersions;
+		CustomVersions.Serialize(*FileReader);
+
+		TArray<uint8> OctreeData;
+		*FileReader << OctreeData;
+
+		FMemoryReader OctreeReader(OctreeData, true);
+		OctreeReader.SetCustomVersions(CustomVersions);
+
+		FEditableSvoSharedPtr ShardOctree = MakeShareable(new FEditableSvo(EForceInit::ForceInit));
+		ShardOctree->Serialize(OctreeReader);
+
+		if (!MergedOctree.IsValid())
+		{
+			// The first shard becomes the merged octree, and the tiles of the others are
+			// moved into it. Linking all their neighbors is deferred until the end.
+			MergedOctree = ShardOctree;
+			MergedOctree->BeginBatchEdit();
+		}
+		else if (ShardOctree->GetConfig().IsCompatibleWith(MergedOctree->GetConfig()))
+		{
+			for (FSvoTile& Tile : ShardOctree->GetTiles())
+			{
+				MergedOctree->AssumeTile(Tile, false);
+			}
+		}
+		else
+		{
+			UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavBuild: Shard '%s' was built with a different config"), *Filename);
+			MergedOctree->EndBatchEdit();
+			return false;
+		}
+	}
+
+	if (MergedOctree.IsValid())
+	{
+		MergedOctree->EndBatchEdit();
+
+		UE_LOG(LogNavigation, Display, TEXT("Gunfire3DNavBuild: Merged %d tiles for %s from %d shards"),
+			MergedOctree->GetTiles().Num(), *NavData->GetName(), NumShards);
+
+		NavData->SetOctree(MergedOctree);
+	}
+
+	return true;
+}
+
+FString UGunfire3DNavBuildCommandlet::GetShardFilename(const AGunfire3DNavData* NavData, int32 ShardIdx, const FString& OutputDir)
+{
+	return OutputDir / FString::Printf(TEXT("%s.%s.shard%d"), *FPackageName::GetShortName(NavData->GetOutermost()), *NavData->GetName(), ShardIdx);
+}
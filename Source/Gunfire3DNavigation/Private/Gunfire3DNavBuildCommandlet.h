@@ -0,0 +1,58 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "Gunfire3DNavBuildCommandlet.generated.h"
+
+class AGunfire3DNavData;
+class UWorld;
+
+//
+// Builds the 3D navigation for a map offline, optionally splitting the tiles across
+// several worker processes and merging their results.
+//
+// Usage:
+//   -run=Gunfire3DNavBuild -Map=<Map> [-Shards=<N>] [-Output=<Dir>]
+//
+// With one shard (the default) the map is built and saved in this process. With more,
+// this process launches a worker for each shard, then merges the tiles they wrote to
+// 'Output' into the map and saves it. Workers are launched with '-Shard=<Idx>', and only
+// build and write out the tiles belonging to their shard.
+//
+UCLASS()
+class UGunfire3DNavBuildCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+	// Loads and initializes the map so its navigation can be built or queried
+	static UWorld* LoadWorld(const FString& MapName);
+
+	// Tears down a world loaded by LoadWorld
+	static void UnloadWorld(UWorld* World);
+
+private:
+
+	// Saves the map after its navigation has been built or merged
+	bool SaveWorld(UWorld* World);
+
+	// Builds the tiles of one shard (or all of them if 'NumShards' is one) in this process
+	void BuildShard(UWorld* World, int32 NumShards, int32 ShardIdx);
+
+	// Launches and waits for a worker per shard, returning false if any failed
+	bool RunWorkers(const FString& MapName, int32 NumShards, const FString& OutputDir);
+
+	// Writes the tiles built for a nav data by this shard
+	bool WriteShard(AGunfire3DNavData* NavData, const FString& Filename);
+
+	// Combines the tiles written by each worker into the nav data
+	bool MergeShards(AGunfire3DNavData* NavData, int32 NumShards, const FString& OutputDir);
+
+	static FString GetShardFilename(const AGunfire3DNavData* NavData, int32 ShardIdx, const FString& OutputDir);
+};
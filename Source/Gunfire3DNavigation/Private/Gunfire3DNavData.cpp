@@ -6,13 +6,34 @@
 #include "Gunfire3DNavigationCustomVersion.h"
 #include "Gunfire3DNavigationTypes.h"
 #include "Gunfire3DNavigationUtils.h"
+#include "NavSvo/NavSvoBenchmark.h"
+#include "NavSvo/NavSvoFlowFieldCache.h"
+#include "NavSvo/NavSvoFlowFieldQuery.h"
+#include "NavSvo/NavSvoGenerationArena.h"
+#include "NavSvo/NavSvoGenerationStats.h"
 #include "NavSvo/NavSvoGenerator.h"
+#include "NavSvo/NavSvoNodeHints.h"
+#include "NavSvo/NavSvoPathCache.h"
+#include "NavSvo/NavSvoPathRequestManager.h"
 #include "NavSvo/NavSvoPathQuery.h"
+#include "NavSvo/NavSvoQueryCapture.h"
+#include "NavSvo/NavSvoQueryContext.h"
+#include "NavSvo/NavSvoQueryStats.h"
 #include "NavSvo/NavSvoLocationQuery.h"
 #include "NavSvo/NavSvoStreamingData.h"
+#include "NavSvo/NavSvoTimeSlicedPathManager.h"
 #include "NavSvo/NavSvoUtils.h"
 #include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
-
+#include "SparseVoxelOctree/SparseVoxelOctreeSharedNodes.h"
+
+#include "Algo/Count.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "NavAreas/NavArea.h"
 #include "NavigationSystem.h"
 #if WITH_EDITOR
 #include "ObjectEditorUtils.h"
@@ -20,16 +41,122 @@
 
 // Profiling stats
 DECLARE_CYCLE_STAT(TEXT("FindPath"), STAT_FindPath, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindHierarchicalPath"), STAT_FindHierarchicalPath, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("TestPath"), STAT_TestPath, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RepairPath"), STAT_RepairPath, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("AdvancePathStart"), STAT_AdvancePathStart, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RetargetPathEnd"), STAT_RetargetPathEnd, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("InvalidateAffectedPaths"), STAT_InvalidateAffectedPaths, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindFlowField"), STAT_FindFlowField, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RequestPathBatch"), STAT_RequestPathBatch, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RequestPath"), STAT_RequestPath, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindPath (Batched)"), STAT_FindPath_Batched, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("PathBatchComplete"), STAT_PathBatchComplete, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RequestTimeSlicedPath"), STAT_RequestTimeSlicedPath, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("CalcPathLengthAndCost"), STAT_CalcPathLengthAndCost, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("Raycast"), STAT_Raycast, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("BatchRaycast"), STAT_BatchRaycast, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("ProjectPoint"), STAT_ProjectPoint, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("BatchProjectPoints"), STAT_BatchProjectPoints, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindMoveAlongSurface"), STAT_FindMoveAlongSurface, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("GetRandomPoint"), STAT_GetRandomPoint, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("GetRandomPointInNavigableRadius"), STAT_GetRandomPointInNavigableRadius, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("GetRandomReachablePointInRadius"), STAT_GetRandomReachablePointInRadius, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("TickColdTiles"), STAT_TickColdTiles, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("EnforceMemoryBudget"), STAT_EnforceMemoryBudget, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("PrefetchTiles"), STAT_PrefetchTiles, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("TickStreamingLevelMerges"), STAT_TickStreamingLevelMerges, STATGROUP_Gunfire3DNavigation);
+
+TAutoConsoleVariable<int32> CVarNavSvoParallelBatchSize(TEXT("NavSvo.ParallelBatchSize"), 256, TEXT("Batched raycasts and point projections with at least this many entries are split across worker threads. Zero keeps every batch on the calling thread."), ECVF_Cheat);
+TAutoConsoleVariable<bool> CVarNavSvoSpatialBatchOrder(TEXT("NavSvo.SpatialBatchOrder"), true, TEXT("Batched raycasts and point projections are run in order of the tile and node they start in, rather than the order they were given, so neighboring entries share tiles."), ECVF_Cheat);
+TAutoConsoleVariable<float> CVarNavSvoColdTileIdleTime(TEXT("NavSvo.ColdTileIdleTime"), 0.f, TEXT("Tiles whose nodes haven't been used for this many seconds are compressed until they're next needed. Zero keeps every tile resident."), ECVF_Cheat);
+TAutoConsoleVariable<int32> CVarNavSvoColdTilesPerTick(TEXT("NavSvo.ColdTilesPerTick"), 32, TEXT("Maximum number of tiles checked for compression or eviction each time cold tiles are ticked."), ECVF_Cheat);
+TAutoConsoleVariable<float> CVarNavSvoStreamingMergeTimePerTick(TEXT("NavSvo.StreamingMergeTimePerTick"), 1.f, TEXT("Milliseconds per frame spent merging the tiles of streamed levels into the octree. At least one tile is merged every frame. Zero merges each level all at once."), ECVF_Cheat);
+TAutoConsoleVariable<float> CVarNavSvoStreamingPriorityRadius(TEXT("NavSvo.StreamingPriorityRadius"), 10000.f, TEXT("Nav data for streamed levels within this distance of a player is read in ahead of the rest."), ECVF_Cheat);
+TAutoConsoleVariable<float> CVarNavSvoResidencyRadius(TEXT("NavSvo.ResidencyRadius"), 0.f, TEXT("Tiles farther than this from every player are evicted to disk, and read back in as players approach or queries need them. Zero keeps every tile in memory."), ECVF_Cheat);
 
 LLM_DEFINE_TAG(Gunfire3DNavData, NAME_None, NAME_None);
 
+namespace NavSvoColdTiles
+{
+	// Seconds between checks for tiles to compress
+	constexpr float TickInterval = 1.f;
+
+	// Tiles are only evicted once they're this much farther than the residency radius,
+	// so players moving along the edge of it don't keep evicting and reading back the
+	// same tiles.
+	constexpr float EvictionRadiusScale = 1.25f;
+}
+
+namespace NavSvoBatch
+{
+	// Number of entries each worker takes at a time once a batch is split
+	constexpr int32 ChunkSize = 64;
+
+	// Calls 'Func' with the range of entries for each chunk of the batch, running the
+	// chunks in parallel if the batch is large enough.
+	template<typename TFunc>
+	void ForEachChunk(int32 NumEntries, const TFunc& Func)
+	{
+		const int32 ParallelBatchSize = CVarNavSvoParallelBatchSize.GetValueOnAnyThread();
+		if (ParallelBatchSize <= 0 || NumEntries < ParallelBatchSize)
+		{
+			Func(0, NumEntries);
+			return;
+		}
+
+		const int32 NumChunks = FMath::DivideAndRoundUp(NumEntries, ChunkSize);
+		ParallelFor(NumChunks, [&Func, NumEntries](int32 ChunkIdx)
+		{
+			const int32 StartIdx = ChunkIdx * ChunkSize;
+			Func(StartIdx, FMath::Min(StartIdx + ChunkSize, NumEntries));
+		});
+	}
+
+	// Fills 'OutOrder' with the indices of the entries sorted by the tile their location
+	// is in, then by the Morton code of the leaf within it, so entries next to each other
+	// in the order read the same nodes. Locations outside of any tile go last.
+	template<typename TGetLocation>
+	void GetSpatialOrder(const FSvoConfig& Config, int32 NumEntries, const TGetLocation& GetLocation, TArray<int32>& OutOrder)
+	{
+		OutOrder.SetNumUninitialized(NumEntries);
+		for (int32 EntryIdx = 0; EntryIdx < NumEntries; ++EntryIdx)
+		{
+			OutOrder[EntryIdx] = EntryIdx;
+		}
+
+		if (NumEntries < 2 || !CVarNavSvoSpatialBatchOrder.GetValueOnAnyThread())
+		{
+			return;
+		}
+
+		TArray<uint64> Keys;
+		Keys.SetNumUninitialized(NumEntries);
+
+		for (int32 EntryIdx = 0; EntryIdx < NumEntries; ++EntryIdx)
+		{
+			const FVector& Location = GetLocation(EntryIdx);
+			const FIntVector TileCoord = Config.LocationToCoord(Location, Config.GetTileResolution());
+
+			if (FSvoTile::IsValidTileCoord(TileCoord))
+			{
+				const FBox TileBounds = Config.GetTileBounds(TileCoord);
+				const TMortonCode LeafMorton = Config.LocationToMorton(TileBounds.Min, Location, Config.GetLeafResolution());
+				Keys[EntryIdx] = ((uint64)FSvoTile::CalcTileID(TileCoord) << 32) | LeafMorton;
+			}
+			else
+			{
+				Keys[EntryIdx] = MAX_uint64;
+			}
+		}
+
+		Algo::Sort(OutOrder, [&Keys](int32 A, int32 B)
+		{
+			return Keys[A] < Keys[B];
+		});
+	}
+}
+
 bool AGunfire3DNavData::bGenerationBoostMode = false;
 
 AGunfire3DNavData::AGunfire3DNavData()
@@ -40,12 +167,9 @@ AGunfire3DNavData::AGunfire3DNavData()
 
 	if (HasAnyFlags(RF_ClassDefaultObject) == false)
 	{
-		// NAVTODO: Currently no distinct support for hierarchical path finding so just
-		// redirecting to standard path finding.
-
 		// Register path finding implementations
 		FindPathImplementation = FindPath;
-		FindHierarchicalPathImplementation = FindPath;
+		FindHierarchicalPathImplementation = FindHierarchicalPath;
 
 		// Register path testing implementations
 		TestPathImplementation = TestPath;
@@ -132,6 +256,10 @@ void AGunfire3DNavData::PostInitProperties()
 	if (HasAnyFlags(RF_ClassDefaultObject) == false)
 	{
 		RecreateDefaultFilter();
+		RecreatePathCache();
+
+		ColdTileTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &AGunfire3DNavData::TickColdTiles), NavSvoColdTiles::TickInterval);
+		StreamingMergeTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &AGunfire3DNavData::TickStreamingLevelMerges));
 	}
 
 #if WITH_EDITOR
@@ -139,6 +267,190 @@ void AGunfire3DNavData::PostInitProperties()
 #endif
 }
 
+void AGunfire3DNavData::BeginDestroy()
+{
+	if (ColdTileTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ColdTileTickerHandle);
+		ColdTileTickerHandle.Reset();
+	}
+
+	if (StreamingMergeTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(StreamingMergeTickerHandle);
+		StreamingMergeTickerHandle.Reset();
+	}
+
+	Super::BeginDestroy();
+}
+
+bool AGunfire3DNavData::TickColdTiles(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickColdTiles);
+
+	if (!HasValidOctree())
+	{
+		ColdTileFrameHistory.Reset();
+		return true;
+	}
+
+	UpdateTileResidency();
+	EnforceMemoryBudget();
+
+	const float IdleTime = CVarNavSvoColdTileIdleTime.GetValueOnGameThread();
+	if (IdleTime <= 0.f)
+	{
+		ColdTileFrameHistory.Reset();
+		return true;
+	}
+
+	// Tiles remember the frame they were last used on, so keep track of the frame at
+	// each tick to know which frame was 'IdleTime' seconds ago.
+	ColdTileFrameHistory.Add(GFrameCounter);
+
+	const int32 NumIdleTicks = FMath::CeilToInt(IdleTime / NavSvoColdTiles::TickInterval);
+	if (ColdTileFrameHistory.Num() <= NumIdleTicks)
+	{
+		return true;
+	}
+
+	ColdTileFrameHistory.RemoveAt(0, ColdTileFrameHistory.Num() - NumIdleTicks - 1);
+
+	// Compressing frees nodes, so wait until nothing could be reading them
+	if (!TryBeginFreeingNodes())
+	{
+		return true;
+	}
+
+	Octree->CompressIdleTiles(ColdTileFrameHistory[0], CVarNavSvoColdTilesPerTick.GetValueOnGameThread());
+
+	EndFreeingNodes();
+
+	return true;
+}
+
+void AGunfire3DNavData::UpdateTileResidency()
+{
+	const float Radius = CVarNavSvoResidencyRadius.GetValueOnGameThread();
+	const UWorld* World = GetWorld();
+	if (Radius <= 0.f || World == nullptr)
+	{
+		return;
+	}
+
+	TArray<FVector> PlayerLocations;
+	FGunfire3DNavigationUtils::GetPlayerLocations(World, PlayerLocations);
+
+	// Without players there's nothing to keep tiles around
+	if (PlayerLocations.Num() == 0)
+	{
+		return;
+	}
+
+	// Evicting frees nodes, so wait until nothing could be reading them
+	if (TryBeginFreeingNodes())
+	{
+		Octree->EvictDistantTiles(PlayerLocations, Radius * NavSvoColdTiles::EvictionRadiusScale, CVarNavSvoColdTilesPerTick.GetValueOnGameThread());
+		EndFreeingNodes();
+	}
+
+	// Read back evicted tiles players are approaching on a worker, so queries near them
+	// don't have to wait on the disk. The task is tracked with the path batches so
+	// nothing modifies the octree while it runs.
+	if (TilePrefetchEvent.IsValid() && !TilePrefetchEvent->IsComplete())
+	{
+		return;
+	}
+
+	TilePrefetchEvent.SafeRelease();
+
+	TArray<uint32> TileIDs;
+	Octree->GetEvictedTilesNear(PlayerLocations, Radius, TileIDs);
+
+	if (TileIDs.Num() > 0)
+	{
+		const FGraphEventArray Prerequisites = GetBackgroundReadPrerequisites();
+
+		TilePrefetchEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([SharedOctree = Octree, TileIDs = MoveTemp(TileIDs)]()
+		{
+			for (uint32 TileID : TileIDs)
+			{
+				if (const FSvoTile* Tile = SharedOctree->GetTile(TileID))
+				{
+					Tile->EnsureNodesResident();
+				}
+			}
+		}, GET_STATID(STAT_PrefetchTiles), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+
+		AddBackgroundRead(TilePrefetchEvent);
+	}
+}
+
+void AGunfire3DNavData::EnforceMemoryBudget()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnforceMemoryBudget);
+
+	if (MemoryBudgetMB <= 0)
+	{
+		Octree->SetTilePoolGrowthAllowed(true);
+		return;
+	}
+
+	const uint32 MemBudget = (uint32)FMath::Min<uint64>((uint64)MemoryBudgetMB * 1024 * 1024, MAX_uint32);
+	uint32 MemUsed = Octree->GetMemUsed();
+
+	// Freeing tiles frees nodes, so wait until nothing could be reading them
+	if (MemUsed > MemBudget && TryBeginFreeingNodes())
+	{
+		TArray<FVector> PlayerLocations;
+		FGunfire3DNavigationUtils::GetPlayerLocations(GetWorld(), PlayerLocations);
+
+		MemUsed = Octree->ShrinkToBudget(MemBudget, PlayerLocations);
+		EndFreeingNodes();
+
+		if (MemUsed > MemBudget)
+		{
+			static bool bWarned = false;
+			if (!bWarned)
+			{
+				UE_LOG(LogNavigation, Warning, TEXT("%s: Octree is using %u bytes, over its %d MB budget, with nothing left to free"), *GetName(), MemUsed, MemoryBudgetMB);
+				bWarned = true;
+			}
+		}
+	}
+
+	// Don't let generation grow the tile pool until the octree fits again
+	Octree->SetTilePoolGrowthAllowed(MemUsed <= MemBudget);
+}
+
+bool AGunfire3DNavData::HasPendingBackgroundReads() const
+{
+	if (HeldPathBatchEvents.Num() > 0)
+	{
+		return true;
+	}
+
+	for (const FGraphEventRef& Event : PendingPathBatchEvents)
+	{
+		if (!Event->IsComplete())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool AGunfire3DNavData::TryBeginFreeingNodes() const
+{
+	return !HasPendingBackgroundReads() && NodeReadersLock.TryWriteLock();
+}
+
+void AGunfire3DNavData::EndFreeingNodes() const
+{
+	NodeReadersLock.WriteUnlock();
+}
+
 #if WITH_EDITOR
 
 void AGunfire3DNavData::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
@@ -186,6 +498,7 @@ void AGunfire3DNavData::PostEditChangeProperty(struct FPropertyChangedEvent& Pro
 		else if (CategoryName == NAME_Query)
 		{
 			RecreateDefaultFilter();
+			RecreatePathCache();
 		}
 		// BEGIN: HACK
 		// NOTE: This was taken directly from 'ARecastNavMesh::PostEditChangeProperty'
@@ -234,6 +547,73 @@ void AGunfire3DNavData::RecreateDefaultFilter()
 	// these.
 	const TArray<FBox> NavigableBounds = GetNavigableBounds();
 	FilterImpl->GetConstraints().SetBoundsConstraints(NavigableBounds);
+
+	UpdateDefaultAreaCosts();
+}
+
+void AGunfire3DNavData::UpdateDefaultAreaCosts()
+{
+	FGunfire3DNavQueryFilter* FilterImpl = StaticCast<FGunfire3DNavQueryFilter*>(DefaultQueryFilter->GetImplementation());
+	if (FilterImpl == nullptr)
+	{
+		return;
+	}
+
+	FilterImpl->Reset();
+
+	for (const FSupportedAreaData& Area : SupportedAreas)
+	{
+		const UNavArea* AreaCDO = Area.AreaClass ? Area.AreaClass->GetDefaultObject<UNavArea>() : nullptr;
+		if (AreaCDO == nullptr || Area.AreaID < 0 || Area.AreaID >= NAVDATA_MAX_AREAS)
+		{
+			continue;
+		}
+
+		// Areas at the default cost don't need their nodes looked up at all
+		if (AreaCDO->DefaultCost != 1.f || AreaCDO->GetFixedAreaEnteringCost() != 0.f)
+		{
+			FilterImpl->SetAreaCost((uint8)Area.AreaID, AreaCDO->DefaultCost);
+			FilterImpl->SetFixedAreaEnteringCost((uint8)Area.AreaID, AreaCDO->GetFixedAreaEnteringCost());
+		}
+	}
+}
+
+void AGunfire3DNavData::OnNavAreaAdded(const UClass* NavAreaClass, int32 AgentIndex)
+{
+	Super::OnNavAreaAdded(NavAreaClass, AgentIndex);
+
+	UpdateDefaultAreaCosts();
+}
+
+void AGunfire3DNavData::OnNavAreaRemoved(const UClass* NavAreaClass)
+{
+	Super::OnNavAreaRemoved(NavAreaClass);
+
+	UpdateDefaultAreaCosts();
+}
+
+void AGunfire3DNavData::RecreatePathCache()
+{
+	// Path batches may be using the cache
+	WaitForPathBatches();
+
+	PathCache.Reset();
+	if (PathCacheSize > 0)
+	{
+		PathCache = MakeShareable(new FNavSvoPathCache(PathCacheSize));
+	}
+
+	FlowFieldCache.Reset();
+	if (FlowFieldCacheSize > 0)
+	{
+		FlowFieldCache = MakeShareable(new FNavSvoFlowFieldCache(FlowFieldCacheSize));
+	}
+
+	NodeHints.Reset();
+	if (NodeHintCacheSize > 0)
+	{
+		NodeHints = MakeShareable(new FNavSvoNodeHints(NodeHintCacheSize));
+	}
 }
 
 void AGunfire3DNavData::ConditionalConstructGenerator()
@@ -292,127 +672,675 @@ FPathFindingResult AGunfire3DNavData::FindPath(const FNavAgentProperties& AgentP
 {
 	SCOPE_CYCLE_COUNTER(STAT_FindPath);
 
+	return FindPathInternal(Query, false);
+}
+
+FPathFindingResult AGunfire3DNavData::FindHierarchicalPath(const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FindHierarchicalPath);
+
+	return FindPathInternal(Query, true);
+}
+
+FPathFindingResult AGunfire3DNavData::FindPathInternal(const FPathFindingQuery& Query, bool bHierarchical)
+{
 	const AGunfire3DNavData* Self = Cast<const AGunfire3DNavData>(Query.NavData.Get());
 	if (Self == nullptr || !Self->Octree.IsValid())
 	{
 		return ENavigationQueryResult::Error;
 	}
 
-	// Resolve the path to be filled. This could be an existing path that was passed along
-	// with the query however, if that is missing, a new path instance will be created.
-	FNavPathSharedPtr SharedPathPtr = Query.PathInstanceToFill;
-	FGunfire3DNavPath* NavPath = (SharedPathPtr != nullptr) ? SharedPathPtr->CastPath<FGunfire3DNavPath>() : nullptr;
-	if (NavPath != nullptr)
-	{
-		NavPath->ResetForRepath();
-	}
-	else
+	FReadScopeLock ReadersLock(Self->NodeReadersLock);
+
+	if (FNavSvoQueryCapture::IsCapturing())
 	{
-		// No path has been instance has been provided so create a new one.
-		SharedPathPtr = Self->CreatePathInstance<FGunfire3DNavPath>(Query);
-		NavPath = SharedPathPtr->CastPath<FGunfire3DNavPath>();
+		FNavSvoQueryCapture::Record(bHierarchical ? ENavSvoCapturedQueryType::FindHierarchicalPath : ENavSvoCapturedQueryType::FindPath,
+			*Self, Query.StartLocation, Query.EndLocation, Query.QueryFilter.Get(), Query.bAllowPartialPaths);
 	}
 
+	FNavPathSharedPtr SharedPathPtr = PreparePathInstance(*Self, Query);
+	FGunfire3DNavPath* NavPath = SharedPathPtr.IsValid() ? SharedPathPtr->CastPath<FGunfire3DNavPath>() : nullptr;
 	if (NavPath == nullptr)
 	{
 		return ENavigationQueryResult::Error;
 	}
 
-	const FNavigationQueryFilter& ResolvedQueryFilter = Self->ResolveFilterRef(Query.QueryFilter);
-	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
-	const FVector AdjustedEndLocation = ResolvedQueryFilter.GetAdjustedEndLocation(Query.EndLocation);
-	const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
-	const FVector NodeQueryExtent = Self->GetDefaultQueryExtent();
-
-	FVector StartLocation, EndLocation;
-
-	// Pass the query flags along to the path so we know what parameters from which it was
-	// generated.
-	NavPath->ApplyFlags(Query.NavDataFlags);
+	FGunfire3DNavPathQueryResults& PathQueryResults = NavPath->GetGenerationInfo();
+	FNavSvoScopedPathQueryStats QueryStats(Query, PathQueryResults);
 
-	// Use a node query to find the best open location for the specified start and end
-	// locations
-	FNavSvoNodeQuery NodeQuery(*Self->Octree, MaxSearchNodes, NodeQueryExtent);
-	const FSvoNodeLink StartNodeLink = NodeQuery.FindClosestNode(Query.StartLocation, &StartLocation);
-	if (!StartNodeLink.IsValid())
+	FNavSvoPathEndpoints Endpoints;
+	bool bFoundEndpoints;
 	{
-		return ENavigationQueryResult::Fail;
+		FNavSvoScopedQueryTimer QueryTimer(PathQueryResults.Timings.NodeLookupTime);
+		bFoundEndpoints = FindPathEndpoints(*Self, Query, Endpoints);
 	}
-	const FSvoNodeLink EndNodeLink = NodeQuery.FindClosestNode(AdjustedEndLocation, &EndLocation);
-	if (!EndNodeLink.IsValid())
+
+	if (!bFoundEndpoints)
 	{
 		return ENavigationQueryResult::Fail;
 	}
 
-	FGunfire3DNavPathQueryResults& PathQueryResults = NavPath->GetGenerationInfo();
-	FNavSvoPathQuery PathQuery(*Self->Octree, MaxSearchNodes);
-	const bool bPathFound = PathQuery.FindPath(StartNodeLink, EndNodeLink, Query.CostLimit, *QueryFilterImpl, PathQueryResults);
-	if (!bPathFound)
+	// If the goal is on an island the start can't reach, or is covered by an obstacle,
+	// the search would only exhaust its node budget before failing.
+	if (!Query.bAllowPartialPaths &&
+		(!Self->Octree->AreNodesConnected(Endpoints.StartNodeLink, Endpoints.EndNodeLink) || Self->Octree->IsNodeClosedByObstacle(Endpoints.EndNodeLink)))
 	{
 		return ENavigationQueryResult::Fail;
 	}
 
-	// If we were unable to reach the goal and partial path aren't allowed, return
-	// failure.
-	if (PathQueryResults.IsPartial() && !Query.bAllowPartialPaths)
+	// Reuse a previously found path between these nodes if there's one still valid.
+	if (FindCachedPath(*Self, Query, Endpoints, bHierarchical, *NavPath))
 	{
-		return ENavigationQueryResult::Fail;
+		FPathFindingResult RetVal(ENavigationQueryResult::Success);
+		RetVal.Path = SharedPathPtr;
+		return RetVal;
 	}
-	
-	// Copy all nodes of the successful path to the output path
-	TArray<FNavPathPoint>& PathPoints = NavPath->GetPathPoints();
+
+	// If this is a repath of a path which kept its corridor, only search again around the
+	// tiles which have changed.
+	bool bPathRepaired;
 	{
-		PathPoints.Reserve(FMath::Min(2u, PathQueryResults.PathNodeCount + 2));
+		FNavSvoScopedQueryTimer QueryTimer(PathQueryResults.Timings.SearchTime);
+		bPathRepaired = RepairPath(*Self, Query, Endpoints, *NavPath);
+	}
 
-		// The path query will only have the portal points along the corridor for the path
-		// so add the requested start point first.
-		PathPoints.Add(FNavPathPoint(StartLocation, StartNodeLink.GetID()));
+	if (bPathRepaired)
+	{
+		FPathFindingResult RetVal(FinishPath(*Self, Query, Endpoints, bHierarchical, *NavPath));
+		if (RetVal.IsSuccessful())
+		{
+			RetVal.Path = SharedPathPtr;
+		}
+		return RetVal;
+	}
 
-		// Add all points between the start and end location
-		PathPoints.Append(PathQueryResults.PathPortalPoints);
+	const FNavigationQueryFilter& ResolvedQueryFilter = Self->ResolveFilterRef(Query.QueryFilter);
+	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+	const FSvoNodeLink& StartNodeLink = Endpoints.StartNodeLink;
+	const FSvoNodeLink& EndNodeLink = Endpoints.EndNodeLink;
 
-		// If this is a partial path, mark it as such. Otherwise, copy the end location to
-		// the path nodes as it will not have been a part of the search query.
-		if (PathQueryResults.IsPartial())
-		{
-			NavPath->SetIsPartial(true);
+	FNavSvoPathQuery PathQuery(*Self->Octree, ResolvedQueryFilter.GetMaxSearchNodes());
 
-			// This means path finding algorithm reached node pool limit. This can mean
-			// that the resulting path is way off.
-			NavPath->SetSearchReachedLimit(PathQueryResults.RanOutOfNodes());
-		}
-		else
+	// For hierarchical queries that cross tiles, find the tiles leading to the goal first
+	// so the detailed search doesn't flood into parts of the octree it will never need.
+	TSet<uint32> TileCorridor;
+	const TSet<uint32>* TileCorridorPtr = nullptr;
+	if (bHierarchical && StartNodeLink.TileID != EndNodeLink.TileID)
+	{
+		const FSvoTileGraph& TileGraph = Self->Octree->GetTileGraph();
+		if (TileGraph.HasTile(StartNodeLink.TileID) && TileGraph.HasTile(EndNodeLink.TileID))
 		{
-			PathPoints.Add(FNavPathPoint(EndLocation, EndNodeLink.GetID()));
+			if (TileGraph.FindCorridor(StartNodeLink.TileID, EndNodeLink.TileID, 1 /* Padding */, TileCorridor))
+			{
+				TileCorridorPtr = &TileCorridor;
+			}
+			else if (!Query.bAllowPartialPaths)
+			{
+				// The tile graph never under-estimates connectivity, so there's no way
+				// to reach the goal.
+				return ENavigationQueryResult::Fail;
+			}
 		}
 	}
 
-	// Clean up the path so it no longer contains duplicate nodes along each line segment.
-	FNavSvoUtils::CleanUpPath(PathPoints);
-
-	// Tighten up the path to be more direct
-	if (NavPath->WantsStringPulling())
+	bool bPathFound;
 	{
-		FNavSvoUtils::StringPullPath(*Self->Octree, PathPoints);
+		FNavSvoScopedQueryTimer QueryTimer(PathQueryResults.Timings.SearchTime);
+		bPathFound = PathQuery.FindPath(StartNodeLink, EndNodeLink, Query.CostLimit, *QueryFilterImpl, PathQueryResults, TileCorridorPtr);
 	}
 
-	// Smooth the path
-	if (NavPath->WantsSmoothing())
+	// Tiles being connected doesn't guarantee the voxels inside them are, so if the
+	// corridor turned out to be a dead end fall back to searching without it.
+	if (TileCorridorPtr != nullptr && (!bPathFound || PathQueryResults.IsPartial()))
 	{
-		// NOTE: Hard coding these values for now until I find a good place for them to
-		// live.
-		FNavSvoUtils::SmoothPath(*Self->Octree, PathPoints, 0.5f /* Centripetal */, 3 /* Iterations */);
+		// The time spent so far still counts towards this query
+		const FGunfire3DNavQueryTimings Timings = PathQueryResults.Timings;
+		PathQueryResults.Reset();
+		PathQueryResults.Timings = Timings;
+
+		FNavSvoScopedQueryTimer QueryTimer(PathQueryResults.Timings.SearchTime);
+		bPathFound = PathQuery.FindPath(StartNodeLink, EndNodeLink, Query.CostLimit, *QueryFilterImpl, PathQueryResults);
 	}
 
-	// Mark that this path is ready to be used.
-	NavPath->MarkReady();
+	if (!bPathFound)
+	{
+		return ENavigationQueryResult::Fail;
+	}
 
-	// Build and return the final result
-	FPathFindingResult RetVal(ENavigationQueryResult::Success);
-	RetVal.Path = SharedPathPtr;
+	FPathFindingResult RetVal(FinishPath(*Self, Query, Endpoints, bHierarchical, *NavPath));
+	if (RetVal.IsSuccessful())
+	{
+		RetVal.Path = SharedPathPtr;
+	}
 	return RetVal;
 }
 
+FNavPathSharedPtr AGunfire3DNavData::PreparePathInstance(const AGunfire3DNavData& Self, const FPathFindingQuery& Query)
+{
+	// Resolve the path to be filled. This could be an existing path that was passed along
+	// with the query however, if that is missing, a new path instance will be created.
+	FNavPathSharedPtr SharedPathPtr = Query.PathInstanceToFill;
+	FGunfire3DNavPath* NavPath = (SharedPathPtr != nullptr) ? SharedPathPtr->CastPath<FGunfire3DNavPath>() : nullptr;
+	if (NavPath != nullptr)
+	{
+		NavPath->ResetForRepath();
+	}
+	else
+	{
+		// No path has been instance has been provided so create a new one.
+		SharedPathPtr = Self.CreatePathInstance<FGunfire3DNavPath>(Query);
+		NavPath = SharedPathPtr->CastPath<FGunfire3DNavPath>();
+	}
+
+	if (NavPath == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Pass the query flags along to the path so we know what parameters from which it was
+	// generated.
+	NavPath->ApplyFlags(Query.NavDataFlags);
+
+	return SharedPathPtr;
+}
+
+bool AGunfire3DNavData::FindPathEndpoints(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, FNavSvoPathEndpoints& OutEndpoints)
+{
+	const FNavigationQueryFilter& ResolvedQueryFilter = Self.ResolveFilterRef(Query.QueryFilter);
+	const FVector AdjustedEndLocation = ResolvedQueryFilter.GetAdjustedEndLocation(Query.EndLocation);
+
+	// Use a node query to find the best open location for the specified start and end
+	// locations
+	FNavSvoNodeQuery NodeQuery(*Self.Octree, ResolvedQueryFilter.GetMaxSearchNodes(), Self.GetDefaultQueryExtent());
+	OutEndpoints.StartNodeLink = Self.FindClosestNodeForQuerier(NodeQuery, Query.StartLocation, Query.Owner.Get(), &OutEndpoints.StartLocation);
+	if (!OutEndpoints.StartNodeLink.IsValid())
+	{
+		return false;
+	}
+
+	OutEndpoints.EndNodeLink = NodeQuery.FindClosestNode(AdjustedEndLocation, &OutEndpoints.EndLocation);
+	return OutEndpoints.EndNodeLink.IsValid();
+}
+
+FSvoNodeLink AGunfire3DNavData::FindClosestNodeForQuerier(FNavSvoNodeQuery& NodeQuery, const FVector& Location, const UObject* Querier, FVector* OutClosestPoint) const
+{
+	FNavSvoNodeHints* Hints = (Querier != nullptr) ? NodeHints.Get() : nullptr;
+	if (Hints == nullptr)
+	{
+		return NodeQuery.FindClosestNode(Location, OutClosestPoint);
+	}
+
+	FSvoNodeLink HintLink = Hints->Find(Querier);
+	const FSvoNodeLink NodeLink = NodeQuery.FindClosestNode(Location, OutClosestPoint, &HintLink);
+	Hints->Update(Querier, HintLink);
+
+	return NodeLink;
+}
+
+FNavSvoPathCache* AGunfire3DNavData::GetPathCacheForQuery(const FGunfire3DNavQueryFilter& QueryFilter, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, bool bHierarchical, FNavSvoPathCacheKey& OutKey) const
+{
+	// NOTE: Queries with a node visited callback are never cached since the caller is
+	// relying on the search actually running.
+	if (!PathCache.IsValid() || QueryFilter.OnNodeVisited)
+	{
+		return nullptr;
+	}
+
+	// Cached paths only know about the tiles they pass through, so they can't tell when
+	// an obstacle has moved across them.
+	if (Octree.IsValid() && Octree->GetObstacles() != nullptr)
+	{
+		return nullptr;
+	}
+
+	OutKey.StartNodeLink = Endpoints.StartNodeLink;
+	OutKey.GoalNodeLink = Endpoints.EndNodeLink;
+	OutKey.FilterHash = QueryFilter.GetHash();
+	OutKey.NavDataFlags = Query.NavDataFlags;
+	OutKey.bHierarchical = bHierarchical;
+
+	return PathCache.Get();
+}
+
+bool AGunfire3DNavData::FindCachedPath(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, bool bHierarchical, FGunfire3DNavPath& NavPath)
+{
+	const FNavigationQueryFilter& ResolvedQueryFilter = Self.ResolveFilterRef(Query.QueryFilter);
+	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+
+	FNavSvoPathCacheKey PathCacheKey;
+	FNavSvoPathCache* PathCache = Self.GetPathCacheForQuery(*QueryFilterImpl, Query, Endpoints, bHierarchical, PathCacheKey);
+	if (PathCache == nullptr)
+	{
+		return false;
+	}
+
+	TArray<FNavPathPoint>& PathPoints = NavPath.GetPathPoints();
+	if (PathCache->Find(PathCacheKey, *Self.Octree, Query.CostLimit, PathPoints) && PathPoints.Num() >= 2)
+	{
+		// The cached path may have been found from different locations within the same
+		// start and end nodes, so move the ends of the path to match this query and make
+		// sure they can still see the rest of the path.
+		PathPoints[0].Location = Endpoints.StartLocation;
+		PathPoints.Last().Location = Endpoints.EndLocation;
+
+		if (!Self.Octree->RaycastAnyHit(PathPoints[0].Location, PathPoints[1].Location) &&
+			!Self.Octree->RaycastAnyHit(PathPoints[PathPoints.Num() - 2].Location, PathPoints.Last().Location))
+		{
+			// The cached path wasn't built from the corridor this path kept
+			NavPath.GetCorridor().Reset();
+
+			NavPath.MarkReady();
+			return true;
+		}
+	}
+
+	PathPoints.Reset();
+	return false;
+}
+
+bool AGunfire3DNavData::RepairPath(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, FGunfire3DNavPath& NavPath)
+{
+	const FGunfire3DNavPathCorridor& Corridor = NavPath.GetCorridor();
+	if (!NavPath.WantsIncrementalRepair() || !Corridor.IsValid())
+	{
+		return false;
+	}
+
+	// Obstacles may have moved across the parts of the corridor that would be kept
+	if (Self.Octree->GetObstacles() != nullptr)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_RepairPath);
+
+	const FNavigationQueryFilter& ResolvedQueryFilter = Self.ResolveFilterRef(Query.QueryFilter);
+	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+
+	// The corridor can only be reused if it leads to the same goal and was searched the
+	// same way.
+	const TArray<FNavPathPoint>& Points = Corridor.Points;
+	if (FSvoNodeLink(Points.Last().NodeRef) != Endpoints.EndNodeLink ||
+		Corridor.FilterHash != QueryFilterImpl->GetHash() ||
+		Corridor.NavDataFlags != Query.NavDataFlags)
+	{
+		return false;
+	}
+
+	const int32 GoalIdx = Corridor.GetGoalIdx();
+
+	// Find how far along the corridor the start has moved
+	const int32 StartIdx = Corridor.FindNode(Endpoints.StartNodeLink.GetID());
+	if (StartIdx == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Find the span of the remaining corridor that runs through changed tiles
+	TArray<uint32, TInlineAllocator<16>> ChangedTileIDs;
+	for (const FGunfire3DNavPathCorridor::FTileVersion& TileVersion : Corridor.TileVersions)
+	{
+		const FSvoTile* Tile = Self.Octree->GetTile(TileVersion.TileID);
+		if (Tile == nullptr || Tile->GetVersion() != TileVersion.Version)
+		{
+			ChangedTileIDs.Add(TileVersion.TileID);
+		}
+	}
+
+	int32 FirstChangedIdx = INDEX_NONE;
+	int32 LastChangedIdx = INDEX_NONE;
+	for (int32 PointIdx = StartIdx; PointIdx <= GoalIdx; ++PointIdx)
+	{
+		if (ChangedTileIDs.Contains(FSvoNodeLink(Points[PointIdx].NodeRef).TileID))
+		{
+			FirstChangedIdx = (FirstChangedIdx == INDEX_NONE) ? PointIdx : FirstChangedIdx;
+			LastChangedIdx = PointIdx;
+		}
+	}
+
+	// Rejoin the corridor at the nodes on either side of the changes. Those are in tiles
+	// which haven't changed, so they're still connected to the rest of the corridor.
+	const bool bHasChanges = (FirstChangedIdx != INDEX_NONE);
+	const int32 FromIdx = bHasChanges ? FMath::Max(StartIdx, FirstChangedIdx - 1) : GoalIdx;
+	const int32 ToIdx = bHasChanges ? FMath::Min(GoalIdx, LastChangedIdx + 1) : GoalIdx;
+
+	FGunfire3DNavPathQueryResults RepairResults;
+	if (bHasChanges)
+	{
+		// The start and goal nodes have just been found in the latest navigation, so they
+		// can be searched from even if their tiles changed.
+		const FSvoNodeLink FromLink = (FromIdx == StartIdx) ? Endpoints.StartNodeLink : FSvoNodeLink(Points[FromIdx].NodeRef);
+		const FSvoNodeLink ToLink = (ToIdx == GoalIdx) ? Endpoints.EndNodeLink : FSvoNodeLink(Points[ToIdx].NodeRef);
+
+		FNavSvoPathQuery PathQuery(*Self.Octree, ResolvedQueryFilter.GetMaxSearchNodes());
+		if (!PathQuery.FindPath(FromLink, ToLink, 0.f /* CostLimit */, *QueryFilterImpl, RepairResults) ||
+			RepairResults.IsPartial() ||
+			RepairResults.PathPortalCosts.Num() != RepairResults.PathPortalPoints.Num())
+		{
+			return false;
+		}
+	}
+
+	// Splice the repaired section into the unchanged parts of the corridor. Costs are
+	// rebased so the path is measured from the current start.
+	FGunfire3DNavPathQueryResults& PathQueryResults = NavPath.GetGenerationInfo();
+	TArray<FNavPathPoint> PortalPoints;
+	TArray<float> PortalCosts;
+	PortalPoints.Reserve(GoalIdx - StartIdx + RepairResults.PathPortalPoints.Num());
+	PortalCosts.Reserve(PortalPoints.Max());
+
+	const float StartCost = Corridor.Costs[StartIdx];
+	for (int32 PointIdx = StartIdx + 1; PointIdx <= FromIdx; ++PointIdx)
+	{
+		PortalPoints.Add(Points[PointIdx]);
+		PortalCosts.Add(Corridor.Costs[PointIdx] - StartCost);
+	}
+
+	if (bHasChanges)
+	{
+		const float FromCost = Corridor.Costs[FromIdx] - StartCost;
+		for (int32 RepairIdx = 0; RepairIdx < RepairResults.PathPortalPoints.Num(); ++RepairIdx)
+		{
+			PortalPoints.Add(RepairResults.PathPortalPoints[RepairIdx]);
+			PortalCosts.Add(FromCost + RepairResults.PathPortalCosts[RepairIdx]);
+		}
+
+		const float ToCost = (PortalCosts.Num() > 0) ? PortalCosts.Last() : FromCost;
+		for (int32 PointIdx = ToIdx + 1; PointIdx <= GoalIdx; ++PointIdx)
+		{
+			PortalPoints.Add(Points[PointIdx]);
+			PortalCosts.Add(ToCost + Corridor.Costs[PointIdx] - Corridor.Costs[ToIdx]);
+		}
+	}
+
+	const float PathCost = (PortalCosts.Num() > 0) ? PortalCosts.Last() : 0.f;
+	if (Query.CostLimit > 0.f && PathCost > Query.CostLimit)
+	{
+		return false;
+	}
+
+	float PathLength = 0.f;
+	FVector PrevLocation = Endpoints.StartLocation;
+	for (const FNavPathPoint& PortalPoint : PortalPoints)
+	{
+		PathLength += FVector::Dist(PrevLocation, PortalPoint.Location);
+		PrevLocation = PortalPoint.Location;
+	}
+
+	PathQueryResults.PathPortalPoints = MoveTemp(PortalPoints);
+	PathQueryResults.PathPortalCosts = MoveTemp(PortalCosts);
+	PathQueryResults.PathNodeCount = PathQueryResults.PathPortalPoints.Num() + 1;
+	PathQueryResults.PathCost = PathCost;
+	PathQueryResults.PathLength = PathLength + FVector::Dist(PrevLocation, Endpoints.EndLocation);
+	PathQueryResults.NumNodesQueried += RepairResults.NumNodesQueried;
+	PathQueryResults.NumNodesOpened += RepairResults.NumNodesOpened;
+	PathQueryResults.NumNodesReopened += RepairResults.NumNodesReopened;
+	PathQueryResults.NumNodesVisited += RepairResults.NumNodesVisited;
+	PathQueryResults.MemUsed += RepairResults.MemUsed;
+	PathQueryResults.Status |= (uint8)EGunfire3DNavQueryFlags::Success;
+
+	return true;
+}
+
+ENavigationQueryResult::Type AGunfire3DNavData::FinishPath(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, bool bHierarchical, FGunfire3DNavPath& NavPath)
+{
+	FGunfire3DNavPathQueryResults& PathQueryResults = NavPath.GetGenerationInfo();
+
+	// If we were unable to reach the goal and partial path aren't allowed, return
+	// failure.
+	if (PathQueryResults.IsPartial() && !Query.bAllowPartialPaths)
+	{
+		return ENavigationQueryResult::Fail;
+	}
+
+	const FNavigationQueryFilter& ResolvedQueryFilter = Self.ResolveFilterRef(Query.QueryFilter);
+	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+
+	FNavSvoPathCacheKey PathCacheKey;
+	FNavSvoPathCache* PathCache = Self.GetPathCacheForQuery(*QueryFilterImpl, Query, Endpoints, bHierarchical, PathCacheKey);
+	
+	// Copy all nodes of the successful path to the output path
+	TArray<FNavPathPoint>& PathPoints = NavPath.GetPathPoints();
+	{
+		// Reserve room for the start and end as well, so the path is only ever allocated
+		// once. Post-processing only removes points in place, apart from smoothing.
+		PathPoints.Reset(PathQueryResults.PathPortalPoints.Num() + 2);
+
+		// The path query will only have the portal points along the corridor for the path
+		// so add the requested start point first.
+		PathPoints.Add(FNavPathPoint(Endpoints.StartLocation, Endpoints.StartNodeLink.GetID()));
+
+		// Add all points between the start and end location
+		PathPoints.Append(PathQueryResults.PathPortalPoints);
+
+		// If this is a partial path, mark it as such. Otherwise, copy the end location to
+		// the path nodes as it will not have been a part of the search query.
+		if (PathQueryResults.IsPartial())
+		{
+			NavPath.SetIsPartial(true);
+
+			// This means path finding algorithm reached node pool limit. This can mean
+			// that the resulting path is way off.
+			NavPath.SetSearchReachedLimit(PathQueryResults.RanOutOfNodes());
+		}
+		else
+		{
+			PathPoints.Add(FNavPathPoint(Endpoints.EndLocation, Endpoints.EndNodeLink.GetID()));
+		}
+	}
+
+	// Keep the route the path was built from so it can be repaired later
+	if (NavPath.WantsIncrementalRepair())
+	{
+		FGunfire3DNavPathCorridor& Corridor = NavPath.GetCorridor();
+		Corridor.Reset();
+
+		if (!PathQueryResults.IsPartial() && PathQueryResults.PathPortalCosts.Num() == PathQueryResults.PathPortalPoints.Num())
+		{
+			Corridor.Points = PathPoints;
+			Corridor.Costs.Reserve(PathPoints.Num());
+			Corridor.Costs.Add(0.f);
+			Corridor.Costs.Append(PathQueryResults.PathPortalCosts);
+			Corridor.Costs.Add(PathQueryResults.PathCost);
+			Corridor.FilterHash = QueryFilterImpl->GetHash();
+			Corridor.NavDataFlags = Query.NavDataFlags;
+
+			for (const FNavPathPoint& PathPoint : PathPoints)
+			{
+				const uint32 TileID = FSvoNodeLink(PathPoint.NodeRef).TileID;
+				if (!Corridor.TileVersions.ContainsByPredicate([TileID](const FGunfire3DNavPathCorridor::FTileVersion& TileVersion) { return TileVersion.TileID == TileID; }))
+				{
+					const FSvoTile* Tile = Self.Octree->GetTile(TileID);
+					Corridor.TileVersions.Add({ TileID, Tile ? Tile->GetVersion() : 0 });
+				}
+			}
+		}
+	}
+
+	// Remember which tiles the path passes through before post-processing removes
+	// points, so the cached path can be invalidated if any of them change.
+	TArray<uint32, TInlineAllocator<16>> PathTileIDs;
+	if (PathCache != nullptr && !PathQueryResults.IsPartial())
+	{
+		for (const FNavPathPoint& PathPoint : PathPoints)
+		{
+			PathTileIDs.AddUnique(FSvoNodeLink(PathPoint.NodeRef).TileID);
+		}
+	}
+
+	PostProcessPath(Self, NavPath);
+
+	if (PathTileIDs.Num() > 0)
+	{
+		PathCache->Add(PathCacheKey, *Self.Octree, PathTileIDs, PathPoints, PathQueryResults.PathCost);
+	}
+
+	// Mark that this path is ready to be used.
+	NavPath.MarkReady();
+
+	return ENavigationQueryResult::Success;
+}
+
+void AGunfire3DNavData::PostProcessPath(const AGunfire3DNavData& Self, FGunfire3DNavPath& NavPath)
+{
+	FGunfire3DNavPathQueryResults& PathQueryResults = NavPath.GetGenerationInfo();
+	TArray<FNavPathPoint>& PathPoints = NavPath.GetPathPoints();
+
+	// Tighten up the path to be more direct
+	//
+	// NOTE: This needs to happen before the path is cleaned up, since it relies on each
+	// point lying on the portal between consecutive nodes.
+	if (NavPath.WantsStringPulling())
+	{
+		FNavSvoScopedQueryTimer QueryTimer(PathQueryResults.Timings.StringPullTime);
+		FNavSvoUtils::StringPullPath(*Self.Octree, PathPoints);
+	}
+
+	// Clean up the path so it no longer contains duplicate nodes along each line segment.
+	FNavSvoUtils::CleanUpPath(PathPoints);
+
+	// Smooth the path
+	if (NavPath.WantsSmoothing())
+	{
+		FNavSvoScopedQueryTimer QueryTimer(PathQueryResults.Timings.SmoothingTime);
+
+		// NOTE: Hard coding these values for now until I find a good place for them to
+		// live.
+		FNavSvoUtils::SmoothPath(*Self.Octree, PathPoints, 0.5f /* Centripetal */, 3 /* Iterations */);
+	}
+}
+
+bool AGunfire3DNavData::CanFollowCorridor(const FGunfire3DNavPath& NavPath) const
+{
+	const FGunfire3DNavPathCorridor& Corridor = NavPath.GetCorridor();
+	if (!Octree.IsValid() || !Corridor.IsValid() || NavPath.GetPathPoints().Num() < 2)
+	{
+		return false;
+	}
+
+	// Raycasts along the path don't know about obstacles
+	if (Octree->GetObstacles() != nullptr)
+	{
+		return false;
+	}
+
+	for (const FGunfire3DNavPathCorridor::FTileVersion& TileVersion : Corridor.TileVersions)
+	{
+		const FSvoTile* Tile = Octree->GetTile(TileVersion.TileID);
+		if (Tile == nullptr || Tile->GetVersion() != TileVersion.Version)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool AGunfire3DNavData::AdvancePathStart(FGunfire3DNavPath& NavPath, const FVector& NewStart) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_AdvancePathStart);
+
+	if (!CanFollowCorridor(NavPath))
+	{
+		return false;
+	}
+
+	// Find how far along the corridor the start has moved
+	FGunfire3DNavPathCorridor& Corridor = NavPath.GetCorridor();
+	const FSvoNodeLink StartLink = Octree->GetLinkForLocation(NewStart);
+	const int32 StartIdx = StartLink.IsValid() ? Corridor.FindNode(StartLink.GetID()) : INDEX_NONE;
+	if (StartIdx == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Drop the part of the corridor behind the start. Costs are rebased so the path is
+	// measured from the new start.
+	const float StartCost = Corridor.Costs[StartIdx];
+	Corridor.Points.RemoveAt(0, StartIdx, false);
+	Corridor.Costs.RemoveAt(0, StartIdx, false);
+	for (float& Cost : Corridor.Costs)
+	{
+		Cost -= StartCost;
+	}
+
+	Corridor.Points[0] = FNavPathPoint(NewStart, StartLink.GetID());
+	NavPath.GetGenerationInfo().PathCost = Corridor.Costs.Last();
+
+	// Drop the path points the start has passed, which are the ones before the segment
+	// it's closest to
+	TArray<FNavPathPoint>& PathPoints = NavPath.GetPathPoints();
+	int32 ClosestSegmentIdx = 0;
+	double ClosestDistSq = TNumericLimits<double>::Max();
+	for (int32 PointIdx = 0; PointIdx < PathPoints.Num() - 1; ++PointIdx)
+	{
+		const FVector ClosestPoint = FMath::ClosestPointOnSegment(NewStart, PathPoints[PointIdx].Location, PathPoints[PointIdx + 1].Location);
+		const double DistSq = FVector::DistSquared(NewStart, ClosestPoint);
+		if (DistSq < ClosestDistSq)
+		{
+			ClosestDistSq = DistSq;
+			ClosestSegmentIdx = PointIdx;
+		}
+	}
+
+	PathPoints.RemoveAt(0, ClosestSegmentIdx, false);
+	PathPoints[0] = FNavPathPoint(NewStart, StartLink.GetID());
+
+	// If the agent has drifted out of sight of the rest of the path, rebuild it from the
+	// corridor instead
+	if (Octree->RaycastAnyHit(PathPoints[0].Location, PathPoints[1].Location))
+	{
+		PathPoints = Corridor.Points;
+		PostProcessPath(*this, NavPath);
+	}
+
+	return true;
+}
+
+bool AGunfire3DNavData::RetargetPathEnd(FGunfire3DNavPath& NavPath, const FVector& NewEnd, int32 MaxEndNodes) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RetargetPathEnd);
+
+	if (!CanFollowCorridor(NavPath))
+	{
+		return false;
+	}
+
+	// See if the end is still within the last few nodes of the corridor
+	FGunfire3DNavPathCorridor& Corridor = NavPath.GetCorridor();
+	const int32 GoalIdx = Corridor.GetGoalIdx();
+	const FSvoNodeLink EndLink = Octree->GetLinkForLocation(NewEnd);
+	const int32 EndIdx = EndLink.IsValid() ? Corridor.FindNode(EndLink.GetID(), FMath::Max(0, GoalIdx - MaxEndNodes + 1)) : INDEX_NONE;
+	if (EndIdx == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Drop the part of the corridor past the node the end is now in. The cost of the
+	// last stretch isn't known without searching it, so it's taken as its length.
+	Corridor.Points.SetNum(EndIdx + 1, false);
+	Corridor.Costs.SetNum(EndIdx + 1, false);
+	Corridor.Costs.Add(Corridor.Costs[EndIdx] + FVector::Dist(Corridor.Points[EndIdx].Location, NewEnd));
+	Corridor.Points.Add(FNavPathPoint(NewEnd, EndLink.GetID()));
+
+	NavPath.GetGenerationInfo().PathCost = Corridor.Costs.Last();
+
+	// If the end is still in the goal node, only the last point needs to move as long as
+	// the rest of the path can see it
+	TArray<FNavPathPoint>& PathPoints = NavPath.GetPathPoints();
+	if (EndIdx == GoalIdx && !Octree->RaycastAnyHit(PathPoints[PathPoints.Num() - 2].Location, NewEnd))
+	{
+		PathPoints.Last() = FNavPathPoint(NewEnd, EndLink.GetID());
+	}
+	else
+	{
+		PathPoints = Corridor.Points;
+		PostProcessPath(*this, NavPath);
+	}
+
+	return true;
+}
+
 bool AGunfire3DNavData::GetNodeLocation(NavNodeRef NodeRef, FVector& OutLocation) const
 {
 	if (Octree.IsValid())
@@ -435,14 +1363,21 @@ bool AGunfire3DNavData::GetNodeBounds(NavNodeRef NodeRef, FBox& OutBounds) const
 	return false;
 }
 
-bool AGunfire3DNavData::GetNodeAtLocation(const FVector& Location, NavNodeRef& OutNodeRef) const
+bool AGunfire3DNavData::GetNodeAtLocation(const FVector& Location, NavNodeRef& OutNodeRef, const UObject* Querier) const
 {
 	OutNodeRef = SVO_INVALID_NODELINK;
 
 	if (Octree.IsValid())
 	{
-		const FSvoNodeLink NodeLink = Octree->GetLinkForLocation(Location);
+		FNavSvoNodeHints* Hints = (Querier != nullptr) ? NodeHints.Get() : nullptr;
+
+		const FSvoNodeLink NodeLink = Hints ? Octree->GetLinkForLocationNearHint(Hints->Find(Querier), Location) : Octree->GetLinkForLocation(Location);
 		OutNodeRef = NodeLink.GetID();
+
+		if (Hints != nullptr)
+		{
+			Hints->Update(Querier, NodeLink);
+		}
 	}
 
 	return (OutNodeRef != SVO_INVALID_NODELINK);
@@ -486,74 +1421,406 @@ bool AGunfire3DNavData::FindClosestReachableNode(const FVector& Origin, float Ma
 		OutNodeRef = NodeLink.GetID();
 	}
 
-	return (OutNodeRef != SVO_INVALID_NODELINK);
+	return (OutNodeRef != SVO_INVALID_NODELINK);
+}
+
+bool AGunfire3DNavData::FindRandomReachableNode(const FVector& Origin, float MaxDistance, NavNodeRef& OutNodeRef, FSharedConstNavQueryFilter QueryFilter) const
+{
+	OutNodeRef = SVO_INVALID_NODELINK;
+
+	if (Octree.IsValid())
+	{
+		// Resolve the query filter
+		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
+		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
+		const FVector NodeQueryExtent = GetDefaultQueryExtent();
+
+		FGunfire3DNavQueryResults QueryResults;
+		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
+		const FSvoNodeLink NodeLink = NodeQuery.FindRandomReachableNode(Origin, MaxDistance , *QueryFilterImpl, QueryResults);
+
+		OutNodeRef = NodeLink.GetID();
+	}
+
+	return (OutNodeRef != SVO_INVALID_NODELINK);
+}
+
+bool AGunfire3DNavData::GatherReachableNodes(const FVector& Origin, float MaxDistance, TArray<NavNodeRef>& OutResult, FSharedConstNavQueryFilter QueryFilter) const
+{
+	if (Octree.IsValid())
+	{
+		// Resolve the query filter
+		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
+		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
+		const FVector NodeQueryExtent = GetDefaultQueryExtent();
+
+		auto OnChunkVisited = [&OutResult](TArrayView<const NavNodeRef> Nodes, TArrayView<const FBox> NodeBounds) -> bool
+		{
+			OutResult.Append(Nodes.GetData(), Nodes.Num());
+			return true;
+		};
+
+		FGunfire3DNavQueryResults QueryResults;
+		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
+		const bool bQueryStatus = NodeQuery.SearchReachableNodeChunks(Origin, MaxDistance, 256, OnChunkVisited, *QueryFilterImpl, QueryResults);
+		return bQueryStatus;
+	}
+	
+	return false;
+}
+
+bool AGunfire3DNavData::ForEachReachableNode(const FVector& Origin, float MaxDistance, TFunction<bool(NavNodeRef)> Lambda, FSharedConstNavQueryFilter QueryFilter) const
+{
+	if (Octree.IsValid())
+	{
+		// Resolve the query filter
+		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
+		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
+		const FVector NodeQueryExtent = GetDefaultQueryExtent();
+
+		FGunfire3DNavQueryResults QueryResults;
+		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
+		const bool bQueryStatus = NodeQuery.SearchReachableNodes(Origin, MaxDistance, Lambda, *QueryFilterImpl, QueryResults);
+
+		return bQueryStatus;
+	}
+
+	return false;
+}
+
+bool AGunfire3DNavData::ForEachReachableNodeChunk(const FVector& Origin, float MaxDistance, TFunctionRef<bool(TArrayView<const NavNodeRef> Nodes, TArrayView<const FBox> NodeBounds)> Lambda, FSharedConstNavQueryFilter QueryFilter, int32 ChunkSize) const
+{
+	if (Octree.IsValid())
+	{
+		// Resolve the query filter
+		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
+		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
+		const FVector NodeQueryExtent = GetDefaultQueryExtent();
+
+		FGunfire3DNavQueryResults QueryResults;
+		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
+		const bool bQueryStatus = NodeQuery.SearchReachableNodeChunks(Origin, MaxDistance, ChunkSize, Lambda, *QueryFilterImpl, QueryResults);
+
+		return bQueryStatus;
+	}
+
+	return false;
+}
+
+FGunfire3DNavFlowFieldPtr AGunfire3DNavData::FindFlowField(const FVector& GoalLocation, float MaxCost, FSharedConstNavQueryFilter QueryFilter) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FindFlowField);
+
+	if (!Octree.IsValid())
+	{
+		return nullptr;
+	}
+
+	const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
+	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
+	const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
+
+	// Agents move toward the goal, so the field needs to be anchored at an open node
+	FVector GoalNodeLocation;
+	FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, GetDefaultQueryExtent());
+	const FSvoNodeLink GoalNodeLink = NodeQuery.FindClosestNode(GoalLocation, &GoalNodeLocation);
+	if (!GoalNodeLink.IsValid())
+	{
+		return nullptr;
+	}
+
+	// NOTE: Queries with a node visited callback are never cached since the caller is
+	// relying on the search actually running.
+	FNavSvoFlowFieldCache* Cache = QueryFilterImpl->OnNodeVisited ? nullptr : FlowFieldCache.Get();
+	FNavSvoFlowFieldCacheKey CacheKey;
+	CacheKey.GoalNodeLink = GoalNodeLink;
+	CacheKey.FilterHash = QueryFilterImpl->GetHash();
+	CacheKey.CostLimit = MaxCost;
+
+	if (Cache != nullptr)
+	{
+		FGunfire3DNavFlowFieldPtr CachedFlowField = Cache->Find(CacheKey, *Octree);
+		if (CachedFlowField.IsValid())
+		{
+			return CachedFlowField;
+		}
+	}
+
+	TSharedRef<FGunfire3DNavFlowField, ESPMode::ThreadSafe> FlowField = MakeShared<FGunfire3DNavFlowField, ESPMode::ThreadSafe>();
+
+	FGunfire3DNavQueryResults QueryResults;
+	FNavSvoFlowFieldQuery FlowFieldQuery(*Octree, MaxSearchNodes);
+	if (!FlowFieldQuery.BuildFlowField(GoalNodeLink, GoalNodeLocation, MaxCost, *QueryFilterImpl, QueryResults, *FlowField))
+	{
+		return nullptr;
+	}
+
+	if (Cache != nullptr)
+	{
+		Cache->Add(CacheKey, *Octree, FlowField);
+	}
+
+	return FlowField;
+}
+
+bool AGunfire3DNavData::GetFlowFieldNextLocation(const FGunfire3DNavFlowField& FlowField, const FVector& Location, FVector& OutNextLocation) const
+{
+	if (!Octree.IsValid())
+	{
+		return false;
+	}
+
+	const FSvoNodeLink NodeLink = Octree->GetLinkForLocation(Location);
+	if (!NodeLink.IsValid())
+	{
+		return false;
+	}
+
+	const FGunfire3DNavFlowField::FStep* Step = FlowField.FindStep(NodeLink.GetID());
+	if (Step == nullptr)
+	{
+		return false;
+	}
+
+	OutNextLocation = Step->PortalLocation;
+	return true;
+}
+
+bool AGunfire3DNavData::GetFlowFieldRoute(const FGunfire3DNavFlowField& FlowField, const FVector& Location, float& OutCost, float& OutLength) const
+{
+	if (!Octree.IsValid())
+	{
+		return false;
+	}
+
+	const FSvoNodeLink NodeLink = Octree->GetLinkForLocation(Location);
+	if (!NodeLink.IsValid())
+	{
+		return false;
+	}
+
+	const FGunfire3DNavFlowField::FStep* Step = FlowField.FindStep(NodeLink.GetID());
+	if (Step == nullptr)
+	{
+		return false;
+	}
+
+	OutCost = Step->Cost;
+	OutLength = 0.f;
+
+	NavNodeRef NodeRef = NodeLink.GetID();
+	FVector CurLocation = Location;
+
+	// Every step moves strictly closer to the goal, so the walk can't take more steps
+	// than the field has unless it's been corrupted.
+	for (int32 NumSteps = 0; NumSteps <= FlowField.Num(); ++NumSteps)
+	{
+		OutLength += FVector::Dist(CurLocation, Step->PortalLocation);
+		CurLocation = Step->PortalLocation;
+
+		if (NodeRef == FlowField.GetGoalNodeRef())
+		{
+			return true;
+		}
+
+		NodeRef = Step->NextNodeRef;
+		Step = FlowField.FindStep(NodeRef);
+		if (Step == nullptr)
+		{
+			break;
+		}
+	}
+
+	return false;
+}
+
+FGunfire3DNavPathBatchRef AGunfire3DNavData::RequestPathBatch(TArray<FPathFindingQuery> Queries, FGunfire3DNavPathBatchDelegate OnComplete)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RequestPathBatch);
+
+	check(IsInGameThread());
+
+	FGunfire3DNavPathBatchRef Batch = MakeShared<FGunfire3DNavPathBatch, ESPMode::ThreadSafe>();
+	Batch->Queries = MoveTemp(Queries);
+	Batch->Results.SetNum(Batch->Queries.Num());
+
+	// Drop events for batches which have already finished so the list doesn't grow
+	PendingPathBatchEvents.RemoveAllSwap([](const FGraphEventRef& Event)
+	{
+		return Event->IsComplete();
+	});
+
+	// All queries in the batch are run against this nav data, regardless of what they
+	// were created with.
+	for (FPathFindingQuery& Query : Batch->Queries)
+	{
+		Query.NavData = this;
+	}
+
+	// Each path is its own task so the batch spreads across all available workers. The
+	// queries pull their search buffers from the worker's context cache, so there's no
+	// per-path allocation beyond the results.
+	FGraphEventArray PathTasks;
+	PathTasks.Reserve(Batch->Queries.Num());
+
+	// If something is waiting to modify the octree, the paths start once it's done
+	const FGraphEventArray Prerequisites = GetBackgroundReadPrerequisites();
+
+	for (int32 QueryIdx = 0; QueryIdx < Batch->Queries.Num(); ++QueryIdx)
+	{
+		PathTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([Batch, QueryIdx]()
+		{
+			const FPathFindingQuery& Query = Batch->Queries[QueryIdx];
+			Batch->Results[QueryIdx] = FindPath(Query.NavAgentProperties, Query);
+		}, GET_STATID(STAT_FindPath_Batched), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask));
+	}
+
+	// Join all the path tasks into a single event the batch can be polled on.
+	Batch->CompletionEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([]() {},
+		TStatId(), &PathTasks, ENamedThreads::AnyBackgroundThreadNormalTask);
+
+	AddBackgroundRead(Batch->CompletionEvent);
+
+	if (OnComplete.IsBound())
+	{
+		FGraphEventArray Prerequisites = { Batch->CompletionEvent };
+		FFunctionGraphTask::CreateAndDispatchWhenReady([Batch, OnComplete]()
+		{
+			OnComplete.ExecuteIfBound(Batch);
+		}, GET_STATID(STAT_PathBatchComplete), &Prerequisites, ENamedThreads::GameThread);
+	}
+
+	return Batch;
+}
+
+void AGunfire3DNavData::WaitForPathBatches()
+{
+	// We're waiting on everything anyway, so let through any reads held back by a writer
+	EndOctreeWrite();
+
+	if (PendingPathBatchEvents.Num() > 0)
+	{
+		check(IsInGameThread());
+
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(PendingPathBatchEvents, ENamedThreads::GameThread);
+		PendingPathBatchEvents.Reset();
+	}
+}
+
+bool AGunfire3DNavData::TryBeginOctreeWrite()
+{
+	check(IsInGameThread());
+
+	PendingPathBatchEvents.RemoveAllSwap([](const FGraphEventRef& Event)
+	{
+		return Event->IsComplete();
+	});
+
+	if (PendingPathBatchEvents.Num() > 0)
+	{
+		// Hold back new reads so the ones in flight can drain
+		if (!OctreeWriteGate.IsValid())
+		{
+			OctreeWriteGate = FGraphEvent::CreateGraphEvent();
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
+void AGunfire3DNavData::EndOctreeWrite()
+{
+	if (OctreeWriteGate.IsValid())
+	{
+		check(IsInGameThread());
+
+		PendingPathBatchEvents.Append(HeldPathBatchEvents);
+		HeldPathBatchEvents.Reset();
+
+		FGraphEventRef Gate = MoveTemp(OctreeWriteGate);
+		OctreeWriteGate = nullptr;
+		Gate->DispatchSubsequents();
+	}
+}
+
+FGraphEventArray AGunfire3DNavData::GetBackgroundReadPrerequisites() const
+{
+	FGraphEventArray Prerequisites;
+
+	if (OctreeWriteGate.IsValid())
+	{
+		Prerequisites.Add(OctreeWriteGate);
+	}
+
+	return Prerequisites;
 }
 
-bool AGunfire3DNavData::FindRandomReachableNode(const FVector& Origin, float MaxDistance, NavNodeRef& OutNodeRef, FSharedConstNavQueryFilter QueryFilter) const
+void AGunfire3DNavData::AddBackgroundRead(const FGraphEventRef& CompletionEvent)
 {
-	OutNodeRef = SVO_INVALID_NODELINK;
-
-	if (Octree.IsValid())
+	if (OctreeWriteGate.IsValid())
 	{
-		// Resolve the query filter
-		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
-		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
-		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
-		const FVector NodeQueryExtent = GetDefaultQueryExtent();
+		HeldPathBatchEvents.Add(CompletionEvent);
+	}
+	else
+	{
+		PendingPathBatchEvents.Add(CompletionEvent);
+	}
+}
 
-		FGunfire3DNavQueryResults QueryResults;
-		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
-		const FSvoNodeLink NodeLink = NodeQuery.FindRandomReachableNode(Origin, MaxDistance , *QueryFilterImpl, QueryResults);
+FGunfire3DNavTimeSlicedPathRef AGunfire3DNavData::RequestTimeSlicedPath(const FPathFindingQuery& Query, FGunfire3DNavTimeSlicedPathDelegate OnComplete)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RequestTimeSlicedPath);
 
-		OutNodeRef = NodeLink.GetID();
+	check(IsInGameThread());
+
+	if (!TimeSlicedPaths.IsValid())
+	{
+		TimeSlicedPaths = MakeShared<FNavSvoTimeSlicedPathManager>(*this);
 	}
 
-	return (OutNodeRef != SVO_INVALID_NODELINK);
+	FGunfire3DNavTimeSlicedPathRef Request = MakeShared<FGunfire3DNavTimeSlicedPath, ESPMode::ThreadSafe>(Query, OnComplete);
+	TimeSlicedPaths->Add(Request);
+
+	return Request;
 }
 
-bool AGunfire3DNavData::GatherReachableNodes(const FVector& Origin, float MaxDistance, TArray<NavNodeRef>& OutResult, FSharedConstNavQueryFilter QueryFilter) const
+void AGunfire3DNavData::CancelTimeSlicedPath(const FGunfire3DNavTimeSlicedPathRef& Request)
 {
-	if (Octree.IsValid())
+	if (TimeSlicedPaths.IsValid())
 	{
-		// Resolve the query filter
-		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
-		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
-		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
-		const FVector NodeQueryExtent = GetDefaultQueryExtent();
-
-		auto OnNodeVisited = [&OutResult](NavNodeRef NavNode) -> bool
-		{
-			OutResult.Add(NavNode);
-			return true;
-		};
-
-		FGunfire3DNavQueryResults QueryResults;
-		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
-		const bool bQueryStatus = NodeQuery.SearchReachableNodes(Origin, MaxDistance, OnNodeVisited, *QueryFilterImpl, QueryResults);
-		return bQueryStatus;
+		TimeSlicedPaths->Cancel(Request);
 	}
-	
-	return false;
 }
 
-bool AGunfire3DNavData::ForEachReachableNode(const FVector& Origin, float MaxDistance, TFunction<bool(NavNodeRef)> Lambda, FSharedConstNavQueryFilter QueryFilter) const
+FGunfire3DNavPathRequestRef AGunfire3DNavData::RequestPath(const FPathFindingQuery& Query, float Priority, FGunfire3DNavPathRequestDelegate OnComplete)
 {
-	if (Octree.IsValid())
-	{
-		// Resolve the query filter
-		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
-		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
-		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
-		const FVector NodeQueryExtent = GetDefaultQueryExtent();
+	SCOPE_CYCLE_COUNTER(STAT_RequestPath);
 
-		FGunfire3DNavQueryResults QueryResults;
-		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
-		const bool bQueryStatus = NodeQuery.SearchReachableNodes(Origin, MaxDistance, Lambda, *QueryFilterImpl, QueryResults);
+	check(IsInGameThread());
 
-		return bQueryStatus;
+	if (!PathRequests.IsValid())
+	{
+		PathRequests = MakeShared<FNavSvoPathRequestManager>(*this);
 	}
 
-	return false;
+	FGunfire3DNavPathRequestRef Request = MakeShared<FGunfire3DNavPathRequest, ESPMode::ThreadSafe>(Query, Priority, OnComplete);
+	PathRequests->Add(Request);
+
+	return Request;
+}
+
+void AGunfire3DNavData::CancelPathRequest(const FGunfire3DNavPathRequestRef& Request)
+{
+	if (PathRequests.IsValid())
+	{
+		PathRequests->Cancel(Request);
+	}
 }
 
 bool AGunfire3DNavData::IsLocationWithinGenerationBounds(const FVector& Location) const
@@ -611,6 +1878,13 @@ bool AGunfire3DNavData::TestPath(const FNavAgentProperties& AgentProperties, con
 		return false;
 	}
 
+	FReadScopeLock ReadersLock(Self->NodeReadersLock);
+
+	if (FNavSvoQueryCapture::IsCapturing())
+	{
+		FNavSvoQueryCapture::Record(ENavSvoCapturedQueryType::TestPath, *Self, Query.StartLocation, Query.EndLocation, Query.QueryFilter.Get());
+	}
+
 	const FNavigationQueryFilter& ResolvedQueryFilter = Self->ResolveFilterRef(Query.QueryFilter);
 	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(ResolvedQueryFilter.GetImplementation());
 	const FVector AdjustedEndLocation = ResolvedQueryFilter.GetAdjustedEndLocation(Query.EndLocation);
@@ -620,7 +1894,7 @@ bool AGunfire3DNavData::TestPath(const FNavAgentProperties& AgentProperties, con
 	// Use a node query to find the best open location for the specified start and end
 	// locations
 	FNavSvoNodeQuery NodeQuery(*Self->Octree, MaxSearchNodes, NodeQueryExtent);
-	const FSvoNodeLink StartNodeLink = NodeQuery.FindClosestNode(Query.StartLocation);
+	const FSvoNodeLink StartNodeLink = Self->FindClosestNodeForQuerier(NodeQuery, Query.StartLocation, Query.Owner.Get());
 	if (!StartNodeLink.IsValid())
 	{
 		return false;
@@ -631,6 +1905,16 @@ bool AGunfire3DNavData::TestPath(const FNavAgentProperties& AgentProperties, con
 		return false;
 	}
 
+	if (!Self->Octree->AreNodesConnected(StartNodeLink, EndNodeLink))
+	{
+		if (NumVisitedNodes != nullptr)
+		{
+			*NumVisitedNodes = 0;
+		}
+
+		return false;
+	}
+
 	FGunfire3DNavPathQueryResults PathQueryResults;
 	FNavSvoPathQuery PathQuery(*Self->Octree, MaxSearchNodes);
 	const bool bPathFound = PathQuery.TestPath(StartNodeLink, EndNodeLink, Query.CostLimit, *QueryFilterImpl, PathQueryResults);
@@ -697,10 +1981,7 @@ void AGunfire3DNavData::OnStreamingLevelAdded(ULevel* InLevel, UWorld* InWorld)
 			UNavSvoStreamingData* NavSvoStreamingData = Cast<UNavSvoStreamingData>(NavDataChunk);
 			if (ensure(NavSvoStreamingData))
 			{
-				if (FEditableSvo* StreamedSvo = NavSvoStreamingData->GetOctree())
-				{
-					//Octree->EmplaceTiles(StreamedSvo);
-				}
+				QueueStreamingLevelMerge(NavSvoStreamingData, false /* bRemove */);
 			}
 		}
 	}
@@ -718,30 +1999,384 @@ void AGunfire3DNavData::OnStreamingLevelRemoved(ULevel* InLevel, UWorld* InWorld
 			UNavSvoStreamingData* NavSvoStreamingData = Cast<UNavSvoStreamingData>(NavDataChunk);
 			if (ensure(NavSvoStreamingData))
 			{
-				if (FEditableSvo* StreamedSvo = NavSvoStreamingData->GetOctree())
+				QueueStreamingLevelMerge(NavSvoStreamingData, true /* bRemove */);
+			}
+		}
+	}
+}
+
+void AGunfire3DNavData::QueueStreamingLevelMerge(UNavSvoStreamingData* StreamingData, bool bRemove)
+{
+	check(IsInGameThread());
+
+	// Nothing has been merged yet from a level that's still being read in
+	if (bRemove)
+	{
+		PendingStreamingMerges.RemoveAll([StreamingData](const FStreamingLevelMerge& Pending)
+		{
+			return Pending.StreamingData.Get() == StreamingData && Pending.bWaitingForLoad;
+		});
+	}
+
+	// Start reading the level's octree in if it hasn't been yet, reading the levels
+	// players are closest to first
+	if (!bRemove && StreamingData->HasUnloadedOctree())
+	{
+		TArray<FVector> PlayerLocations;
+		FGunfire3DNavigationUtils::GetPlayerLocations(GetWorld(), PlayerLocations);
+
+		const double PriorityRadius = CVarNavSvoStreamingPriorityRadius.GetValueOnGameThread();
+		const bool bIsNearPlayer = PlayerLocations.ContainsByPredicate([&](const FVector& Location)
+		{
+			return StreamingData->GetBounds().ComputeSquaredDistanceToPoint(Location) <= FMath::Square(PriorityRadius);
+		});
+
+		StreamingData->RequestOctreeLoad(bIsNearPlayer ? AIOP_High : AIOP_Low);
+	}
+
+	FEditableSvo* StreamedSvo = StreamingData->GetOctree();
+	const bool bWaitForLoad = (StreamedSvo == nullptr && !bRemove && StreamingData->IsLoadingOctree());
+
+	if (!bWaitForLoad && (StreamedSvo == nullptr || (!bRemove && !StreamedSvo->GetConfig().IsCompatibleWith(Octree->GetConfig()))))
+	{
+		return;
+	}
+
+	FStreamingLevelMerge Merge;
+	Merge.StreamingData = StreamingData;
+	Merge.bRemove = bRemove;
+	Merge.bWaitingForLoad = bWaitForLoad;
+
+	// If the level is still being merged in or out, pick up from where that left off
+	const int32 PendingIdx = PendingStreamingMerges.IndexOfByPredicate([StreamingData](const FStreamingLevelMerge& Pending)
+	{
+		return Pending.StreamingData.Get() == StreamingData;
+	});
+
+	if (PendingIdx != INDEX_NONE)
+	{
+		FStreamingLevelMerge& Pending = PendingStreamingMerges[PendingIdx];
+		if (Pending.bRemove == bRemove)
+		{
+			return;
+		}
+
+		// Only the tiles the pending merge already got through need to be undone
+		Merge.TileCoords.Append(Pending.TileCoords.GetData(), Pending.NextTileIdx);
+		PendingStreamingMerges.RemoveAt(PendingIdx);
+	}
+	else if (bWaitForLoad)
+	{
+		// The tiles are filled in once the octree has been read in
+		PendingStreamingMerges.Add(MoveTemp(Merge));
+		return;
+	}
+	else
+	{
+		GetStreamingMergeOrder(*StreamedSvo, Merge.TileCoords);
+	}
+
+	if (Merge.TileCoords.Num() > 0)
+	{
+		PendingStreamingMerges.Add(MoveTemp(Merge));
+	}
+}
+
+void AGunfire3DNavData::GetStreamingMergeOrder(const FEditableSvo& StreamedSvo, TArray<FIntVector>& OutTileCoords)
+{
+	OutTileCoords.Reset(StreamedSvo.GetTiles().Num());
+
+	FIntVector MinCoord(MAX_int32);
+	for (const FSvoTile& Tile : StreamedSvo.GetTiles())
+	{
+		OutTileCoords.Add(Tile.GetCoord());
+		MinCoord = MinCoord.ComponentMin(Tile.GetCoord());
+	}
+
+	// Merge in Morton order, so each frame's batch is a compact block of tiles and as
+	// few links as possible are left pointing at tiles that aren't in yet
+	OutTileCoords.Sort([MinCoord](const FIntVector& A, const FIntVector& B)
+	{
+		return FSvoUtils::CoordToMorton(A - MinCoord) < FSvoUtils::CoordToMorton(B - MinCoord);
+	});
+}
+
+bool AGunfire3DNavData::TickStreamingLevelMerges(float DeltaTime)
+{
+	if (PendingStreamingMerges.Num() == 0 || !Octree.IsValid())
+	{
+		return true;
+	}
+
+	auto IsReadyToMerge = [](const FStreamingLevelMerge& Merge) { return !Merge.bWaitingForLoad; };
+
+	// Pick up the levels whose octrees have finished reading in
+	for (FStreamingLevelMerge& Merge : PendingStreamingMerges)
+	{
+		if (Merge.bWaitingForLoad)
+		{
+			UNavSvoStreamingData* StreamingData = Merge.StreamingData.Get();
+			if (StreamingData == nullptr || !StreamingData->IsLoadingOctree() || StreamingData->FinishOctreeLoad())
+			{
+				Merge.bWaitingForLoad = false;
+
+				const FEditableSvo* StreamedSvo = (StreamingData != nullptr) ? StreamingData->GetOctree() : nullptr;
+				if (StreamedSvo != nullptr && StreamedSvo->GetConfig().IsCompatibleWith(Octree->GetConfig()))
 				{
-					//Octree->RemoveMatchingTiles(*StreamedSvo);
+					GetStreamingMergeOrder(*StreamedSvo, Merge.TileCoords);
 				}
 			}
 		}
 	}
+
+	if (!PendingStreamingMerges.ContainsByPredicate(IsReadyToMerge))
+	{
+		return true;
+	}
+
+	// Wait for any background reads to finish before touching the octree
+	if (!TryBeginOctreeWrite())
+	{
+		return true;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TickStreamingLevelMerges);
+
+	const float MaxTimeMs = CVarNavSvoStreamingMergeTimePerTick.GetValueOnGameThread();
+	const uint64 EndCycle = FPlatformTime::Cycles64() + (uint64)(MaxTimeMs / (1000.0 * FPlatformTime::GetSecondsPerCycle64()));
+
+	TArray<uint32> ChangedTileIDs;
+
+	// Islands are only rebuilt once every pending level is in. Each batch is fully
+	// linked when it ends though, so queries between frames see a consistent octree.
+	Octree->SetDeferIslandUpdates(true);
+	Octree->BeginBatchEdit();
+
+	int32 MergeIdx = 0;
+	while (PendingStreamingMerges.IsValidIndex(MergeIdx))
+	{
+		if (ChangedTileIDs.Num() > 0 && MaxTimeMs > 0.f && FPlatformTime::Cycles64() >= EndCycle)
+		{
+			break;
+		}
+
+		FStreamingLevelMerge& Merge = PendingStreamingMerges[MergeIdx];
+		if (!IsReadyToMerge(Merge))
+		{
+			++MergeIdx;
+			continue;
+		}
+
+		UNavSvoStreamingData* StreamingData = Merge.StreamingData.Get();
+		FEditableSvo* StreamedSvo = (StreamingData != nullptr) ? StreamingData->GetOctree() : nullptr;
+
+		if (!Merge.TileCoords.IsValidIndex(Merge.NextTileIdx) || (!Merge.bRemove && StreamedSvo == nullptr))
+		{
+			PendingStreamingMerges.RemoveAt(MergeIdx);
+			continue;
+		}
+
+		// Faces whose neighbor hasn't changed since the level was built are linked from
+		// the stitches baked with it, rather than being re-linked
+		const FIntVector& TileCoord = Merge.TileCoords[Merge.NextTileIdx++];
+		const TArrayView<const FSvoFaceStitch> Stitches = (StreamingData != nullptr) ? StreamingData->GetTileStitches(TileCoord) : TArrayView<const FSvoFaceStitch>();
+
+		if (Merge.bRemove)
+		{
+			if (Octree->HasTileAtCoord(TileCoord))
+			{
+				Octree->RemoveTileWithStitches(TileCoord, Stitches);
+				ChangedTileIDs.Add(FSvoTile::CalcTileID(TileCoord));
+			}
+		}
+		else if (const FSvoTile* StreamedTile = StreamedSvo->GetTileAtCoord(TileCoord))
+		{
+			// Copy rather than take the tile, so the level's data is still intact if
+			// it's streamed out and back in
+			Octree->CopyTileWithStitches(*StreamedTile, Stitches);
+			ChangedTileIDs.Add(FSvoTile::CalcTileID(TileCoord));
+		}
+	}
+
+	Octree->EndBatchEdit();
+
+	// Levels still being read in may take a while, so don't hold the islands back for them
+	if (!PendingStreamingMerges.ContainsByPredicate(IsReadyToMerge))
+	{
+		Octree->SetDeferIslandUpdates(false);
+	}
+
+	EndOctreeWrite();
+
+	if (ChangedTileIDs.Num() > 0)
+	{
+		InvalidateAffectedPaths(ChangedTileIDs);
+		RequestDrawingUpdate();
+	}
+
+	return true;
+}
+
+UNavSvoStreamingData* AGunfire3DNavData::GetStreamingLevelData(const ULevel* InLevel) const
+{
+	FName ThisName = GetFName();
+	int32 ChunkIndex = InLevel->NavDataChunks.IndexOfByPredicate([&](UNavigationDataChunk* Chunk)
+	{
+		return Chunk->NavigationDataName == ThisName;
+	});
+
+	UNavSvoStreamingData* StreamingData = (ChunkIndex != INDEX_NONE) ? Cast<UNavSvoStreamingData>(InLevel->NavDataChunks[ChunkIndex]) : nullptr;
+	if (StreamingData != nullptr)
+	{
+		StreamingData->Level = InLevel;
+	}
+
+	return StreamingData;
+}
+
+void AGunfire3DNavData::InvalidateAffectedPaths(TArrayView<const uint32> ChangedTileIDs)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InvalidateAffectedPaths);
+
+	FScopeLock PathLock(&ActivePathsLock);
+
+	for (int32 PathIdx = ActivePaths.Num() - 1; PathIdx >= 0; --PathIdx)
+	{
+		FNavPathSharedPtr SharedPath = ActivePaths[PathIdx].Pin();
+		if (!SharedPath.IsValid())
+		{
+			ActivePaths.RemoveAtSwap(PathIdx, 1, false);
+			continue;
+		}
+
+		const FGunfire3DNavPath* NavPath = SharedPath->CastPath<FGunfire3DNavPath>();
+		if (NavPath && NavPath->IsReady() && NavPath->PassesThroughTiles(ChangedTileIDs))
+		{
+			// The path will be found again by its owner, repairing its corridor if it kept one
+			SharedPath->Invalidate();
+			ActivePaths.RemoveAtSwap(PathIdx, 1, false);
+		}
+	}
+}
+
+void AGunfire3DNavData::InvalidatePathsInBounds(const FBox& Bounds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InvalidateAffectedPaths);
+
+	FScopeLock PathLock(&ActivePathsLock);
+
+	for (int32 PathIdx = ActivePaths.Num() - 1; PathIdx >= 0; --PathIdx)
+	{
+		FNavPathSharedPtr SharedPath = ActivePaths[PathIdx].Pin();
+		if (!SharedPath.IsValid())
+		{
+			ActivePaths.RemoveAtSwap(PathIdx, 1, false);
+			continue;
+		}
+
+		if (!SharedPath->IsReady())
+		{
+			continue;
+		}
+
+		const TArray<FNavPathPoint>& PathPoints = SharedPath->GetPathPoints();
+		for (int32 PointIdx = 1; PointIdx < PathPoints.Num(); ++PointIdx)
+		{
+			const FVector& SegmentStart = PathPoints[PointIdx - 1].Location;
+			const FVector& SegmentEnd = PathPoints[PointIdx].Location;
+			if (FMath::LineBoxIntersection(Bounds, SegmentStart, SegmentEnd, SegmentEnd - SegmentStart))
+			{
+				SharedPath->Invalidate();
+				ActivePaths.RemoveAtSwap(PathIdx, 1, false);
+				break;
+			}
+		}
+	}
+}
+
+FSvoObstacles& AGunfire3DNavData::EnsureObstacles()
+{
+	if (!Obstacles.IsValid())
+	{
+		// Most obstacles will then only need to be tested by queries within a tile or two
+		// of them.
+		Obstacles = MakeShared<FSvoObstacles, ESPMode::ThreadSafe>(FSvoUtils::CalcResolutionForLayer(TileLayerIndex, VoxelSize));
+
+		if (Octree.IsValid())
+		{
+			Octree->SetObstacles(Obstacles);
+		}
+	}
+
+	return *Obstacles;
+}
+
+uint32 AGunfire3DNavData::AddObstacleBox(const FBox& Box)
+{
+	const uint32 ObstacleID = EnsureObstacles().AddBox(Box);
+	if (ObstacleID != FSvoObstacles::InvalidID)
+	{
+		InvalidatePathsInBounds(Box);
+	}
+
+	return ObstacleID;
+}
+
+uint32 AGunfire3DNavData::AddObstacleSphere(const FVector& Center, float Radius)
+{
+	const uint32 ObstacleID = EnsureObstacles().AddSphere(Center, Radius);
+	if (ObstacleID != FSvoObstacles::InvalidID)
+	{
+		InvalidatePathsInBounds(FBox(Center - FVector(Radius), Center + FVector(Radius)));
+	}
+
+	return ObstacleID;
+}
+
+bool AGunfire3DNavData::UpdateObstacleBox(uint32 ObstacleID, const FBox& Box)
+{
+	if (!Obstacles.IsValid() || !Obstacles->UpdateBox(ObstacleID, Box))
+	{
+		return false;
+	}
+
+	InvalidatePathsInBounds(Box);
+	return true;
+}
+
+bool AGunfire3DNavData::UpdateObstacleSphere(uint32 ObstacleID, const FVector& Center, float Radius)
+{
+	if (!Obstacles.IsValid() || !Obstacles->UpdateSphere(ObstacleID, Center, Radius))
+	{
+		return false;
+	}
+
+	InvalidatePathsInBounds(FBox(Center - FVector(Radius), Center + FVector(Radius)));
+	return true;
 }
 
-UNavSvoStreamingData* AGunfire3DNavData::GetStreamingLevelData(const ULevel* InLevel) const
+bool AGunfire3DNavData::RemoveObstacle(uint32 ObstacleID)
 {
-	FName ThisName = GetFName();
-	int32 ChunkIndex = InLevel->NavDataChunks.IndexOfByPredicate([&](UNavigationDataChunk* Chunk)
+	return Obstacles.IsValid() && Obstacles->Remove(ObstacleID);
+}
+
+bool AGunfire3DNavData::SweepCapsule(const FVector& Start, const FVector& End, float Radius, float HalfHeight, FVector& OutHitLocation) const
+{
+	OutHitLocation = End;
+
+	if (!HasValidOctree())
 	{
-		return Chunk->NavigationDataName == ThisName;
-	});
+		return false;
+	}
 
-	UNavSvoStreamingData* StreamingData = (ChunkIndex != INDEX_NONE) ? Cast<UNavSvoStreamingData>(InLevel->NavDataChunks[ChunkIndex]) : nullptr;
-	if (StreamingData != nullptr)
+	Gunfire3DNavigation::FRaycastResult Result;
+	if (Octree->SweepCapsule(Start, End, Radius, HalfHeight, Result))
 	{
-		StreamingData->Level = InLevel;
+		OutHitLocation = Result.HitLocation.Location;
+		return true;
 	}
 
-	return StreamingData;
+	return false;
 }
 
 void AGunfire3DNavData::OnGenerationComplete()
@@ -799,6 +2434,7 @@ void AGunfire3DNavData::OnGenerationComplete()
 							if (ensure(DestOctree))
 							{
 								DestOctree->CopyTilesFrom(*Octree, TileCoords, false /* bPreserveNeighborLinks */);
+								NavSvoStreamingData->BakeStitches(*Octree);
 							}
 						}
 
@@ -887,13 +2523,18 @@ void AGunfire3DNavData::RequestDrawingUpdate(bool bForce /* = false */)
 #endif // !UE_BUILD_SHIPPING
 }
 
-void AGunfire3DNavData::GetSupportedAreaClasses(TArray<TWeakObjectPtr<UClass>>& Areas) const
+void AGunfire3DNavData::GetSupportedAreaClasses(TArray<TWeakObjectPtr<UClass>>& Areas, TArray<int32>* OutAreaIDs) const
 {
 	for (const FSupportedAreaData& Area : SupportedAreas)
 	{
 		if (const UClass* Class = Area.AreaClass)
 		{
 			Areas.Add(const_cast<UClass*>(Class));
+
+			if (OutAreaIDs != nullptr)
+			{
+				OutAreaIDs->Add(Area.AreaID);
+			}
 		}
 	}
 }
@@ -904,11 +2545,42 @@ void AGunfire3DNavData::SetOctree(FEditableSvoSharedPtr InOctree)
 	{
 		DestroyOctree();
 		Octree = InOctree;
+
+		if (Octree.IsValid())
+		{
+			Octree->SetObstacles(Obstacles);
+		}
 	}
 }
 
 void AGunfire3DNavData::DestroyOctree()
 {
+	// Don't pull the octree out from under any batched path requests
+	WaitForPathBatches();
+
+	// Cached paths are only valid for the octree they were found in
+	if (PathCache.IsValid())
+	{
+		PathCache->Empty();
+	}
+
+	if (FlowFieldCache.IsValid())
+	{
+		FlowFieldCache->Empty();
+	}
+
+	if (NodeHints.IsValid())
+	{
+		NodeHints->Empty();
+	}
+
+	// Time-sliced searches hold onto nodes from the octree, so they'll need to start
+	// over on the new one
+	if (TimeSlicedPaths.IsValid())
+	{
+		TimeSlicedPaths->RestartAll();
+	}
+
 	Octree = nullptr;
 }
 
@@ -930,6 +2602,11 @@ bool AGunfire3DNavData::NavDataRaycast(const ANavigationData* Self, const FVecto
 		return true;
 	}
 
+	if (FNavSvoQueryCapture::IsCapturing())
+	{
+		FNavSvoQueryCapture::Record(ENavSvoCapturedQueryType::Raycast, *OurSelf, RayStart, RayEnd, QueryFilter.Get());
+	}
+
 	Gunfire3DNavigation::FRaycastResult Result;
 	OurSelf->Octree->Raycast(RayStart, RayEnd, Result);
 
@@ -946,13 +2623,48 @@ void AGunfire3DNavData::BatchRaycast(TArray<FNavigationRaycastWork>& Workload, F
 		return;
 	}
 
-	for (FNavigationRaycastWork& Work : Workload)
+	// Each ray of a batch is captured, and replayed, as a raycast of its own
+	if (FNavSvoQueryCapture::IsCapturing())
+	{
+		for (const FNavigationRaycastWork& Work : Workload)
+		{
+			FNavSvoQueryCapture::Record(ENavSvoCapturedQueryType::Raycast, *this, Work.RayStart, Work.RayEnd, QueryFilter.Get());
+		}
+	}
+
+	// Rays starting near each other are put next to each other, so they end up in the
+	// same packets and chunks
+	TArray<int32> Order;
+	NavSvoBatch::GetSpatialOrder(Octree->GetConfig(), Workload.Num(), [&Workload](int32 WorkIdx) -> const FVector& { return Workload[WorkIdx].RayStart; }, Order);
+
+	TArray<FVector> RayStarts, RayEnds;
+	RayStarts.Reserve(Workload.Num());
+	RayEnds.Reserve(Workload.Num());
+	for (int32 WorkIdx : Order)
+	{
+		RayStarts.Add(Workload[WorkIdx].RayStart);
+		RayEnds.Add(Workload[WorkIdx].RayEnd);
+	}
+
+	// Each chunk is traversed separately, so rays near each other stay in the same
+	// packets.
+	TArray<Gunfire3DNavigation::FRaycastResult> Results;
+	Results.SetNum(Workload.Num());
+	NavSvoBatch::ForEachChunk(Workload.Num(), [&](int32 StartIdx, int32 EndIdx)
 	{
-		Gunfire3DNavigation::FRaycastResult Result;
-		Octree->Raycast(Work.RayStart, Work.RayEnd, Result);
+		const int32 NumRays = EndIdx - StartIdx;
+		Octree->BatchRaycast(
+			TArrayView<const FVector>(RayStarts).Slice(StartIdx, NumRays),
+			TArrayView<const FVector>(RayEnds).Slice(StartIdx, NumRays),
+			TArrayView<Gunfire3DNavigation::FRaycastResult>(Results).Slice(StartIdx, NumRays));
+	});
 
+	for (int32 OrderIdx = 0; OrderIdx < Workload.Num(); ++OrderIdx)
+	{
+		const Gunfire3DNavigation::FRaycastResult& Result = Results[OrderIdx];
 		if (Result.HasHit())
 		{
+			FNavigationRaycastWork& Work = Workload[Order[OrderIdx]];
 			Work.bDidHit = true;
 			Work.HitLocation = Result.HitLocation;
 		}
@@ -961,33 +2673,96 @@ void AGunfire3DNavData::BatchRaycast(TArray<FNavigationRaycastWork>& Workload, F
 
 bool AGunfire3DNavData::FindMoveAlongSurface(const FNavLocation& StartLocation, const FVector& TargetPosition, FNavLocation& OutLocation, FSharedConstNavQueryFilter QueryFilter /* = nullptr */, const UObject* Querier /* = nullptr */) const
 {
-	ensureMsgf(false, TEXT("Function not implemented (%s)"), TEXT("AGunfire3DNavData::FindMoveAlongSurface"));
+	SCOPE_CYCLE_COUNTER(STAT_FindMoveAlongSurface);
 
-	return false;
+	if (!Octree.IsValid())
+	{
+		return false;
+	}
+
+	// Use the node the start was projected to if it still contains it, otherwise look it
+	// up again
+	FSvoNodeLink StartLink;
+	if (StartLocation.HasNodeRef() && StartLocation.NodeRef != SVO_INVALID_NODELINK)
+	{
+		StartLink = FSvoNodeLink(StartLocation.NodeRef);
+
+		FBox StartBounds;
+		if (!Octree->GetBoundsForLink(StartLink, StartBounds) || !StartBounds.IsInsideOrOn(StartLocation.Location))
+		{
+			StartLink = SVO_INVALID_NODELINK;
+		}
+	}
+
+	if (!StartLink.IsValid())
+	{
+		StartLink = Octree->GetLinkForLocation(StartLocation.Location);
+	}
+
+	FVector EndLocation;
+	FSvoNodeLink EndLink;
+	if (!Octree->MoveAlongOpenSpace(StartLink, StartLocation.Location, TargetPosition, EndLocation, EndLink))
+	{
+		return false;
+	}
+
+	OutLocation = FNavLocation(EndLocation, EndLink.GetID());
+
+	return true;
 }
 
 FNavLocation AGunfire3DNavData::GetRandomPoint(FSharedConstNavQueryFilter QueryFilter /* = nullptr */, const UObject* Querier /* = nullptr */) const
 {
-	ensureMsgf(false, TEXT("Function not implemented (%s)"), TEXT("AGunfire3DNavData::GetRandomPoint"));
+	SCOPE_CYCLE_COUNTER(STAT_GetRandomPoint);
+
+	FNavLocation Result;
+
+	if (Octree.IsValid())
+	{
+		FSvoNodeLink NodeLink;
+		if (Octree->GetRandomPoint(Result.Location, NodeLink))
+		{
+			Result.NodeRef = NodeLink.GetID();
+		}
+	}
 
-	return FNavLocation();
+	return Result;
 }
 
 bool AGunfire3DNavData::GetRandomPointInNavigableRadius(const FVector& Origin, float Radius, FNavLocation& OutResult, FSharedConstNavQueryFilter QueryFilter /* = nullptr */, const UObject* Querier /* = nullptr */) const
 {
-	ensureMsgf(false, TEXT("Function not implemented (%s)"), TEXT("AGunfire3DNavData::GetRandomPointInNavigableRadius"));
+	SCOPE_CYCLE_COUNTER(STAT_GetRandomPointInNavigableRadius);
+
+	if (Octree.IsValid() && Radius >= 0.f)
+	{
+		FSvoNodeLink NodeLink;
+		if (Octree->GetRandomPointInRadius(Origin, Radius, [](const FSvoNodeLink&) { return true; }, OutResult.Location, NodeLink))
+		{
+			OutResult.NodeRef = NodeLink.GetID();
+			return true;
+		}
+
+		// The open space within the radius may be too small a part of the tiles around it
+		// to land in by chance, so fall back to the node closest to the origin
+		const FNavigationQueryFilter& ResolvedQueryFilter = ResolveFilterRef(QueryFilter);
+		const FVector QueryExtent(Radius);
+
+		FNavSvoNodeQuery NodeQuery(*Octree, ResolvedQueryFilter.GetMaxSearchNodes(), QueryExtent);
+		NodeLink = NodeQuery.FindClosestNode(Origin);
+
+		const FBox QueryBounds = FBox::BuildAABB(Origin, QueryExtent);
+		if (NodeLink.IsValid() && NodeQuery.FindRandomPointInNode(NodeLink, OutResult.Location, &QueryBounds))
+		{
+			OutResult.NodeRef = NodeLink.GetID();
+			return true;
+		}
+	}
 
 	return false;
 }
 
-// TODO: There are a few things wrong with this implementation.
-//
-//		 First: This is only finding the random point inside of a single node. It, instead, needs to find a random node
-//				and then find a random point inside that node.
-//
-//       Second: There is no guarantee the the node found is reachable from the origin. We do have a function for this
-//               (see FNavSvoNodeQuery::FindRandomReachableNode) but it has not been optimized so it's safer to let the
-//               caller fail to reach the location than kill performance for now.
+// NOTE: Points are only checked to be on the same island as the origin, so while a path
+//		 to them always exists it may be longer than the radius.
 bool AGunfire3DNavData::GetRandomReachablePointInRadius(const FVector& Origin, float Radius, FNavLocation& OutResult, FSharedConstNavQueryFilter QueryFilter /* = nullptr */, const UObject* Querier /* = nullptr */) const
 {
 	SCOPE_CYCLE_COUNTER(STAT_GetRandomReachablePointInRadius);
@@ -1000,19 +2775,31 @@ bool AGunfire3DNavData::GetRandomReachablePointInRadius(const FVector& Origin, f
 		const FVector QueryExtent(Radius);
 
 		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, QueryExtent);
-		const FSvoNodeLink NodeLink = NodeQuery.FindClosestNode(Origin);
+		const FSvoNodeLink OriginNodeLink = NodeQuery.FindClosestNode(Origin);
 
-		if (NodeLink.IsValid())
+		if (OriginNodeLink.IsValid())
 		{
+			FSvoNodeLink NodeLink;
+			auto IsReachable = [this, OriginNodeLink](const FSvoNodeLink& Link)
+			{
+				return Octree->AreNodesConnected(OriginNodeLink, Link);
+			};
+
+			if (Octree->GetRandomPointInRadius(Origin, Radius, IsReachable, OutResult.Location, NodeLink))
+			{
+				OutResult.NodeRef = NodeLink.GetID();
+				return true;
+			}
+
 			// We need to pass the query bounds when finding the closest point on the node as the node could be much
 			// larger than the range were originally searching.
 			FBox QueryBounds = FBox::BuildAABB(Origin, QueryExtent);
 
 			FVector Location;
-			if (NodeQuery.FindRandomPointInNode(NodeLink, Location, &QueryBounds))
+			if (NodeQuery.FindRandomPointInNode(OriginNodeLink, Location, &QueryBounds))
 			{
 				OutResult.Location = Location;
-				OutResult.NodeRef = NodeLink.GetID();
+				OutResult.NodeRef = OriginNodeLink.GetID();
 				return true;
 			}
 		}
@@ -1025,6 +2812,11 @@ bool AGunfire3DNavData::ProjectPoint(const FVector& Point, FNavLocation& OutLoca
 {
 	SCOPE_CYCLE_COUNTER(STAT_ProjectPoint);
 
+	if (FNavSvoQueryCapture::IsCapturing() && Octree.IsValid())
+	{
+		FNavSvoQueryCapture::Record(ENavSvoCapturedQueryType::ProjectPoint, *this, Point, QueryExtent, QueryFilter.Get());
+	}
+
 	if (Octree.IsValid())
 	{
 		// Resolve the query filter
@@ -1032,7 +2824,7 @@ bool AGunfire3DNavData::ProjectPoint(const FVector& Point, FNavLocation& OutLoca
 		const uint32 MaxSearchNodes = ResolvedQueryFilter.GetMaxSearchNodes();
 
 		FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, QueryExtent);
-		const FSvoNodeLink NodeLink = NodeQuery.FindClosestNode(Point);
+		const FSvoNodeLink NodeLink = FindClosestNodeForQuerier(NodeQuery, Point, Querier);
 
 		if (NodeLink.IsValid())
 		{
@@ -1059,10 +2851,18 @@ void AGunfire3DNavData::BatchProjectPoints(TArray<FNavigationProjectionWork>& Wo
 
 	if (Octree.IsValid())
 	{
-		for (FNavigationProjectionWork& Work : Workload)
+		TArray<int32> Order;
+		NavSvoBatch::GetSpatialOrder(Octree->GetConfig(), Workload.Num(), [&Workload](int32 WorkIdx) -> const FVector& { return Workload[WorkIdx].Point; }, Order);
+
+		// NOTE: Each worker borrows its own search buffers from its query context cache
+		NavSvoBatch::ForEachChunk(Workload.Num(), [&](int32 StartIdx, int32 EndIdx)
 		{
-			Work.bResult = ProjectPoint(Work.Point, Work.OutLocation, Work.ProjectionLimit.GetExtent(), QueryFilter);
-		}
+			for (int32 OrderIdx = StartIdx; OrderIdx < EndIdx; ++OrderIdx)
+			{
+				FNavigationProjectionWork& Work = Workload[Order[OrderIdx]];
+				Work.bResult = ProjectPoint(Work.Point, Work.OutLocation, Work.ProjectionLimit.GetExtent(), QueryFilter);
+			}
+		});
 	}
 }
 
@@ -1072,10 +2872,17 @@ void AGunfire3DNavData::BatchProjectPoints(TArray<FNavigationProjectionWork>& Wo
 
 	if (Octree.IsValid())
 	{
-		for (FNavigationProjectionWork& Work : Workload)
+		TArray<int32> Order;
+		NavSvoBatch::GetSpatialOrder(Octree->GetConfig(), Workload.Num(), [&Workload](int32 WorkIdx) -> const FVector& { return Workload[WorkIdx].Point; }, Order);
+
+		NavSvoBatch::ForEachChunk(Workload.Num(), [&](int32 StartIdx, int32 EndIdx)
 		{
-			Work.bResult = ProjectPoint(Work.Point, Work.OutLocation, Extent, QueryFilter);
-		}
+			for (int32 OrderIdx = StartIdx; OrderIdx < EndIdx; ++OrderIdx)
+			{
+				FNavigationProjectionWork& Work = Workload[Order[OrderIdx]];
+				Work.bResult = ProjectPoint(Work.Point, Work.OutLocation, Extent, QueryFilter);
+			}
+		});
 	}
 }
 
@@ -1115,7 +2922,7 @@ ENavigationQueryResult::Type AGunfire3DNavData::CalcPathLengthAndCost(const FVec
 	// Use a node query to find the best open location for the specified start and end
 	// locations
 	FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
-	const FSvoNodeLink StartNodeLink = NodeQuery.FindClosestNode(PathStart, &StartLocation);
+	const FSvoNodeLink StartNodeLink = FindClosestNodeForQuerier(NodeQuery, PathStart, Querier, &StartLocation);
 	if (!StartNodeLink.IsValid())
 	{
 		return ENavigationQueryResult::Fail;
@@ -1168,9 +2975,343 @@ uint32 AGunfire3DNavData::LogMemUsed() const
 		MemUsed += Octree->GetMemUsed();
 	}
 
+	if (PathCache.IsValid())
+	{
+		MemUsed += PathCache->GetMemUsed();
+	}
+
+	if (FlowFieldCache.IsValid())
+	{
+		MemUsed += FlowFieldCache->GetMemUsed();
+	}
+
+	if (NodeHints.IsValid())
+	{
+		MemUsed += NodeHints->GetMemUsed();
+	}
+
+	if (Obstacles.IsValid())
+	{
+		MemUsed += Obstacles->GetMemUsed();
+	}
+
+	if (TimeSlicedPaths.IsValid())
+	{
+		MemUsed += TimeSlicedPaths->GetMemUsed();
+	}
+
+	if (PathRequests.IsValid())
+	{
+		MemUsed += PathRequests->GetMemUsed();
+	}
+
 	UE_LOG(LogNavigation, Warning, TEXT("%s: AGunfire3DNavData: %u\n    self: %d"), *GetName(), MemUsed, sizeof(AGunfire3DNavData));
 
 	return MemUsed + SuperMemUsed;
 }
 
-#endif // !UE_BUILD_SHIPPING
\ No newline at end of file
+void AGunfire3DNavData::LogMemUsage(int32 NumLargestTiles) const
+{
+	const double ToKB = 1.0 / 1024.0;
+
+	if (!HasValidOctree())
+	{
+		UE_LOG(LogNavigation, Display, TEXT("%s: No octree"), *GetName());
+		return;
+	}
+
+	FSparseVoxelOctree::FMemUsage Usage;
+	Octree->GetMemUsage(Usage);
+
+	UE_LOG(LogNavigation, Display, TEXT("%s: Octree %.1f KB (budget %d MB), %d tiles (%d compressed, %d evicted)"),
+		*GetName(), Octree->GetMemUsed() * ToKB, MemoryBudgetMB, Usage.NumTiles, Usage.NumCompressedTiles, Usage.NumEvictedTiles);
+
+	for (int32 LayerIdx = 0; LayerIdx < SVO_MAX_LAYERS; ++LayerIdx)
+	{
+		if (Usage.LayerMemUsed[LayerIdx] > 0)
+		{
+			UE_LOG(LogNavigation, Display, TEXT("    Layer %d: %.1f KB"), LayerIdx, Usage.LayerMemUsed[LayerIdx] * ToKB);
+		}
+	}
+
+	UE_LOG(LogNavigation, Display, TEXT("    Compressed nodes: %.1f KB"), Usage.CompressedMemUsed * ToKB);
+
+	int32 NumSharedPools;
+	uint64 SharedPoolsMemUsed;
+	FSvoSharedNodePools::GetStats(NumSharedPools, SharedPoolsMemUsed);
+
+	UE_LOG(LogNavigation, Display, TEXT("    Shared nodes (all nav data): %.1f KB in %d pools"), SharedPoolsMemUsed * ToKB, NumSharedPools);
+	UE_LOG(LogNavigation, Display, TEXT("    Path cache: %.1f KB, flow field cache: %.1f KB, node hints: %.1f KB"),
+		(PathCache.IsValid() ? PathCache->GetMemUsed() : 0) * ToKB, (FlowFieldCache.IsValid() ? FlowFieldCache->GetMemUsed() : 0) * ToKB,
+		(NodeHints.IsValid() ? NodeHints->GetMemUsed() : 0) * ToKB);
+	UE_LOG(LogNavigation, Display, TEXT("    Query contexts (all threads): %.1f KB, generation arenas (all threads): %.1f KB"),
+		FNavSvoQueryContext::GetTotalMemUsed() * ToKB, FNavSvoGenerationArena::GetTotalMemUsed() * ToKB);
+
+	// The tiles using the most memory
+	TArray<const FSvoTile*> LargestTiles;
+	for (const FSvoTile& Tile : Octree->GetTiles())
+	{
+		LargestTiles.Add(&Tile);
+	}
+
+	NumLargestTiles = FMath::Min(NumLargestTiles, LargestTiles.Num());
+	if (NumLargestTiles > 0)
+	{
+		LargestTiles.Sort([](const FSvoTile& A, const FSvoTile& B)
+		{
+			return A.GetMemUsed() > B.GetMemUsed();
+		});
+
+		UE_LOG(LogNavigation, Display, TEXT("    Largest tiles:"));
+
+		for (int32 TileIdx = 0; TileIdx < NumLargestTiles; ++TileIdx)
+		{
+			const FSvoTile& Tile = *LargestTiles[TileIdx];
+
+			uint32 LayerMemUsed[SVO_MAX_LAYERS] = {};
+			Tile.AddLayerMemUsed(LayerMemUsed);
+
+			FString LayerText;
+			for (int32 LayerIdx = 0; LayerIdx < SVO_MAX_LAYERS; ++LayerIdx)
+			{
+				if (LayerMemUsed[LayerIdx] > 0)
+				{
+					LayerText += FString::Printf(TEXT(" L%d %.1f KB"), LayerIdx, LayerMemUsed[LayerIdx] * ToKB);
+				}
+			}
+
+			UE_LOG(LogNavigation, Display, TEXT("      %s: %.1f KB%s%s"), *Tile.GetCoord().ToString(), Tile.GetMemUsed() * ToKB, *LayerText,
+				Tile.AreNodesEvicted() ? TEXT(" (evicted)") : (Tile.AreNodesCompressed() ? TEXT(" (compressed)") : TEXT("")));
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdNavSvoDumpMemory(
+	TEXT("NavSvo.DumpMemory"),
+	TEXT("Logs the memory used by each 3D navigation data in the world, by octree layer and for the largest tiles. Optional argument is how many tiles to list (default 10)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumLargestTiles = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 10;
+		for (TActorIterator<AGunfire3DNavData> It(World); It; ++It)
+		{
+			It->LogMemUsage(NumLargestTiles);
+		}
+	}));
+
+#endif // !UE_BUILD_SHIPPING
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmarking
+//////////////////////////////////////////////////////////////////////////
+#if !UE_BUILD_SHIPPING
+
+namespace NavSvoRaycastBenchmark
+{
+	void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumRays = (Args.Num() > 0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1024;
+		const float RayLength = (Args.Num() > 1) ? FMath::Max(1.f, FCString::Atof(*Args[1])) : 2000.f;
+		const int32 NumIterations = (Args.Num() > 2) ? FMath::Max(1, FCString::Atoi(*Args[2])) : 10;
+
+		TActorIterator<AGunfire3DNavData> NavDataIt(World);
+		const AGunfire3DNavData* NavData = NavDataIt ? *NavDataIt : nullptr;
+		const FBox Bounds = NavData ? NavData->GetBounds() : FBox(ForceInit);
+		if (!Bounds.IsValid)
+		{
+			UE_LOG(LogNavigation, Warning, TEXT("NavSvo raycast benchmark: no generated 3D navigation data in the world"));
+			return;
+		}
+
+		// Fan rays out from a handful of origins the way line of sight and perception
+		// tests do, keeping rays from the same origin next to each other in the batch.
+		FRandomStream RandomStream(NumRays);
+		TArray<FNavigationRaycastWork> Workload;
+		Workload.Reserve(NumRays);
+
+		FVector Origin = FVector::ZeroVector;
+		for (int32 RayIdx = 0; RayIdx < NumRays; ++RayIdx)
+		{
+			if ((RayIdx % 16) == 0)
+			{
+				Origin = Bounds.Min + FVector(RandomStream.GetFraction(), RandomStream.GetFraction(), RandomStream.GetFraction()) * Bounds.GetSize();
+			}
+
+			Workload.Emplace(Origin, Origin + RandomStream.GetUnitVector() * RayLength);
+		}
+
+		double ScalarSeconds = 0.0;
+		double BatchSeconds = 0.0;
+		int32 NumMismatches = 0;
+		int32 NumHits = 0;
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			TArray<FNavigationRaycastWork> ScalarWorkload = Workload;
+			double StartTime = FPlatformTime::Seconds();
+			for (FNavigationRaycastWork& Work : ScalarWorkload)
+			{
+				FVector HitLocation;
+				Work.bDidHit = NavData->Raycast(Work.RayStart, Work.RayEnd, HitLocation, nullptr);
+				Work.HitLocation = FNavLocation(HitLocation);
+			}
+			ScalarSeconds += FPlatformTime::Seconds() - StartTime;
+
+			TArray<FNavigationRaycastWork> BatchWorkload = Workload;
+			StartTime = FPlatformTime::Seconds();
+			NavData->BatchRaycast(BatchWorkload, nullptr);
+			BatchSeconds += FPlatformTime::Seconds() - StartTime;
+
+			if (Iteration == 0)
+			{
+				for (int32 RayIdx = 0; RayIdx < NumRays; ++RayIdx)
+				{
+					NumHits += ScalarWorkload[RayIdx].bDidHit ? 1 : 0;
+					if (ScalarWorkload[RayIdx].bDidHit != BatchWorkload[RayIdx].bDidHit ||
+						!ScalarWorkload[RayIdx].HitLocation.Location.Equals(BatchWorkload[RayIdx].HitLocation.Location, 1.f))
+					{
+						++NumMismatches;
+					}
+				}
+			}
+		}
+
+		const double NumOperations = (double)NumRays * NumIterations;
+		UE_LOG(LogNavigation, Display, TEXT("NavSvo raycasts: %d rays of length %.0f x %d iterations, %d hits, %d mismatches"), NumRays, RayLength, NumIterations, NumHits, NumMismatches);
+		UE_LOG(LogNavigation, Display, TEXT("    Raycast: %.2f K/s"), NumOperations / FMath::Max(ScalarSeconds, SMALL_NUMBER) / 1000.0);
+		UE_LOG(LogNavigation, Display, TEXT("    BatchRaycast: %.2f K/s"), NumOperations / FMath::Max(BatchSeconds, SMALL_NUMBER) / 1000.0);
+	}
+
+	static FAutoConsoleCommand CmdBenchmark(
+		TEXT("NavSvo.BenchmarkRaycasts"),
+		TEXT("Compares single raycasts against packet traversal in BatchRaycast. Usage: NavSvo.BenchmarkRaycasts [NumRays] [RayLength] [NumIterations]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
+
+namespace NavSvoQueryBenchmark
+{
+	void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumQueries = (Args.Num() > 0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 256;
+		const float RayLength = (Args.Num() > 1) ? FMath::Max(1.f, FCString::Atof(*Args[1])) : 2000.f;
+
+		TActorIterator<AGunfire3DNavData> NavDataIt(World);
+		const AGunfire3DNavData* NavData = NavDataIt ? *NavDataIt : nullptr;
+		const FBox Bounds = NavData ? NavData->GetBounds() : FBox(ForceInit);
+		if (!Bounds.IsValid)
+		{
+			UE_LOG(LogNavigation, Warning, TEXT("NavSvo benchmark: no generated 3D navigation data in the world"));
+			return;
+		}
+
+		// Pick the endpoints from a fixed seed, so runs on the same map are comparable
+		FRandomStream RandomStream(NumQueries);
+		const FVector ProjectExtent(1000.f);
+
+		TArray<FVector> Points;
+		Points.Reserve(NumQueries * 2);
+		for (int32 Attempt = 0; Attempt < NumQueries * 20 && Points.Num() < NumQueries * 2; ++Attempt)
+		{
+			const FVector Point = Bounds.Min + FVector(RandomStream.GetFraction(), RandomStream.GetFraction(), RandomStream.GetFraction()) * Bounds.GetSize();
+
+			FNavLocation ProjectedPoint;
+			if (NavData->ProjectPoint(Point, ProjectedPoint, ProjectExtent))
+			{
+				Points.Add(ProjectedPoint.Location);
+			}
+		}
+
+		if (Points.Num() < NumQueries * 2)
+		{
+			UE_LOG(LogNavigation, Warning, TEXT("NavSvo benchmark: couldn't find enough open points in the navigation data"));
+			return;
+		}
+
+		const FNavAgentProperties& AgentProperties = NavData->GetConfig();
+		FNavSvoBenchmarkReport Report;
+		FGunfire3DNavQueryTimings PathTimings;
+
+		Report.MeasureEach(TEXT("FindPath"), NumQueries, [&](int32 QueryIdx)
+		{
+			const FPathFindingQuery Query(nullptr, *NavData, Points[QueryIdx * 2], Points[QueryIdx * 2 + 1]);
+			const FPathFindingResult Result = NavData->FindPath(AgentProperties, Query);
+
+			if (const FGunfire3DNavPath* NavPath = Result.Path.IsValid() ? Result.Path->CastPath<FGunfire3DNavPath>() : nullptr)
+			{
+				const FGunfire3DNavQueryTimings& Timings = NavPath->GetGenerationInfo().Timings;
+				PathTimings.NodeLookupTime += Timings.NodeLookupTime;
+				PathTimings.SearchTime += Timings.SearchTime;
+				PathTimings.StringPullTime += Timings.StringPullTime;
+				PathTimings.SmoothingTime += Timings.SmoothingTime;
+			}
+
+			return Result.IsSuccessful();
+		});
+
+		// The stages of the paths are only timed while query timings are enabled
+		if (FNavSvoQueryStats::IsEnabled())
+		{
+			Report.AddTotal(TEXT("FindPath.NodeLookup"), NumQueries, NumQueries, PathTimings.NodeLookupTime);
+			Report.AddTotal(TEXT("FindPath.Search"), NumQueries, NumQueries, PathTimings.SearchTime);
+			Report.AddTotal(TEXT("FindPath.StringPullPath"), NumQueries, NumQueries, PathTimings.StringPullTime);
+			Report.AddTotal(TEXT("FindPath.SmoothPath"), NumQueries, NumQueries, PathTimings.SmoothingTime);
+		}
+
+		Report.MeasureEach(TEXT("TestPath"), NumQueries, [&](int32 QueryIdx)
+		{
+			const FPathFindingQuery Query(nullptr, *NavData, Points[QueryIdx * 2], Points[QueryIdx * 2 + 1]);
+			return NavData->TestPath(AgentProperties, Query, nullptr);
+		});
+
+		Report.MeasureEach(TEXT("FindClosestNode"), NumQueries, [&](int32 QueryIdx)
+		{
+			// Offset from open space, so some of the lookups start inside geometry
+			const FVector Origin = Points[QueryIdx] + RandomStream.GetUnitVector() * (RandomStream.GetFraction() * ProjectExtent.X);
+
+			NavNodeRef NodeRef;
+			return NavData->FindClosestNode(Origin, ProjectExtent, NodeRef);
+		});
+
+		TArray<FNavigationRaycastWork> Workload;
+		Workload.Reserve(NumQueries);
+		for (int32 QueryIdx = 0; QueryIdx < NumQueries; ++QueryIdx)
+		{
+			Workload.Emplace(Points[QueryIdx], Points[QueryIdx] + RandomStream.GetUnitVector() * RayLength);
+		}
+
+		Report.MeasureEach(TEXT("Raycast"), NumQueries, [&](int32 QueryIdx)
+		{
+			FVector HitLocation;
+			return NavData->Raycast(Workload[QueryIdx].RayStart, Workload[QueryIdx].RayEnd, HitLocation, nullptr);
+		});
+
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			NavData->BatchRaycast(Workload, nullptr);
+			const double BatchMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+			const int32 NumHits = Algo::CountIf(Workload, [](const FNavigationRaycastWork& Work) { return Work.bDidHit; });
+			Report.AddTotal(TEXT("BatchRaycast"), NumQueries, NumHits, BatchMs);
+		}
+
+		// Generation isn't rerun here, since it's asynchronous, but whatever was built
+		// since the generation stats were reset is reported alongside the queries.
+		const FNavSvoGenerationSummary Generation = FNavSvoGenerationStats::GetSummary();
+		if (Generation.NumTiles > 0)
+		{
+			const int32 NumBuiltTiles = Generation.NumTiles - Generation.NumCachedTiles;
+			Report.AddTotal(TEXT("GenerateTile (worker)"), Generation.NumTiles, NumBuiltTiles, FPlatformTime::ToMilliseconds64(Generation.TileTotals.GetTotalCycles()));
+			Report.AddTotal(TEXT("GenerateTile (wall)"), Generation.NumTiles, NumBuiltTiles, FPlatformTime::ToMilliseconds64(Generation.WallCycles));
+		}
+
+		const FString Title = FString::Printf(TEXT("NavSvo benchmark on %s: %d queries, rays of length %.0f"), *World->GetMapName(), NumQueries, RayLength);
+		const FString ReportFilename = (Args.Num() > 2) ? Args[2] : FNavSvoBenchmarkReport::GetDefaultFilename(World->GetMapName());
+		Report.Write(Title, ReportFilename);
+	}
+
+	static FAutoConsoleCommand CmdBenchmark(
+		TEXT("NavSvo.Benchmark"),
+		TEXT("Measures path finding, node lookups and raycasts on the world's 3D navigation data, along with the generation stats since they were last reset, and writes the results as CSV. Enable NavSvo.QueryTimings to break down the path stages. Usage: NavSvo.Benchmark [NumQueries] [RayLength] [ReportFile]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -91,9 +91,17 @@ FPrimitiveSceneProxy* UGunfire3DNavRenderingComponent::CreateSceneProxy()
 		const AGunfire3DNavData* NavData = Cast<AGunfire3DNavData>(GetOwner());
 		if (NavData && NavData->IsDrawingEnabled())
 		{
-			return new FNavSvoSceneProxy(this, NavData);
+			if (!DebugMeshCache.IsValid())
+			{
+				DebugMeshCache = MakeShared<FNavSvoDebugMeshCache>();
+			}
+
+			return new FNavSvoSceneProxy(this, NavData, *DebugMeshCache);
 		}
 	}
+
+	// Nothing is drawn, so there's nothing worth holding on to for the next proxy
+	DebugMeshCache.Reset();
 #endif //!UE_BUILD_SHIPPING && !UE_BUILD_TEST
 
 	return nullptr;
@@ -38,4 +38,7 @@ protected:
 	uint32 bCollectNavigationData : 1;
 	uint32 bForceUpdate : 1;
 	FTimerHandle TimerHandle;
+
+	// Per-tile meshes from the last scene proxy, reused for tiles that haven't changed
+	TSharedPtr<struct FNavSvoDebugMeshCache> DebugMeshCache;
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "Gunfire3DNavPath.h"
 
+#include "SparseVoxelOctree/SparseVoxelOctreeNode.h"
+
 #include "DrawDebugHelpers.h"
 #include "NavigationSystem.h"
 
@@ -25,6 +27,49 @@ void FGunfire3DNavPath::ApplyFlags(uint32 NavDataFlags)
 	{
 		bSmooth = false;
 	}
+
+	if (NavDataFlags & (uint32)EGunfire3DNavPathFlags::IncrementalRepair)
+	{
+		bIncrementalRepair = true;
+	}
+}
+
+void FGunfire3DNavPath::SetWantsIncrementalRepair(bool bValue)
+{
+	bIncrementalRepair = bValue;
+
+	if (!bIncrementalRepair)
+	{
+		Corridor.Reset();
+	}
+}
+
+bool FGunfire3DNavPath::PassesThroughTiles(TArrayView<const uint32> TileIDs) const
+{
+	// The corridor knows every tile the path was searched through, whereas the path
+	// points may have been pulled tight and skip some of them.
+	if (Corridor.IsValid())
+	{
+		for (const FGunfire3DNavPathCorridor::FTileVersion& TileVersion : Corridor.TileVersions)
+		{
+			if (TileIDs.Contains(TileVersion.TileID))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	for (const FNavPathPoint& PathPoint : PathPoints)
+	{
+		if (TileIDs.Contains(FSvoNodeLink(PathPoint.NodeRef).TileID))
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 void FGunfire3DNavPath::ResetForRepath()
@@ -63,4 +108,17 @@ void FGunfire3DNavPath::DebugDraw(const ANavigationData* NavData, const FColor P
 	}
 
 #endif
-}
\ No newline at end of file
+}
+
+bool FGunfire3DNavPathBatch::IsComplete() const
+{
+	return (!CompletionEvent.IsValid() || CompletionEvent->IsComplete());
+}
+
+void FGunfire3DNavPathBatch::Wait() const
+{
+	if (!IsComplete())
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(CompletionEvent);
+	}
+}
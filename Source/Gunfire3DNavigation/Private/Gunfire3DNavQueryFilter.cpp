@@ -5,6 +5,10 @@
 #include "Gunfire3DNavData.h"
 #include "Gunfire3DNavigationUtils.h"
 #include "NavSvo/NavSvoQuery.h"
+#include "SparseVoxelOctree/SparseVoxelOctreeCommon.h"
+
+static_assert(NAVDATA_MAX_AREAS == SVO_MAX_AREAS, "The filter needs a cost for every area code the octree can store");
+static_assert(NAVDATA_MAX_AREAS < 64, "Excluded area codes are stored in a 64-bit mask");
 
 //////////////////////////////////////////////////////////////////////////
 // Gunfire3DNavQueryConstraints
@@ -42,6 +46,116 @@ bool FGunfire3DNavQueryConstraints::ConstrainBounds(FBox& InOutBounds) const
 // Gunfire3DNavQueryFilter
 //////////////////////////////////////////////////////////////////////////
 
+void FGunfire3DNavQueryFilter::Reset()
+{
+	for (int32 AreaCode = 0; AreaCode <= NAVDATA_MAX_AREAS; ++AreaCode)
+	{
+		AreaCosts[AreaCode] = 1.f;
+		AreaEnteringCosts[AreaCode] = 0.f;
+	}
+
+	ExcludedAreaCodes = 0;
+	bHasAreaCosts = false;
+}
+
+void FGunfire3DNavQueryFilter::SetAreaCost(uint8 AreaType, float Cost)
+{
+	if (AreaType < NAVDATA_MAX_AREAS)
+	{
+		AreaCosts[AreaType + 1] = Cost;
+		bHasAreaCosts = true;
+	}
+}
+
+void FGunfire3DNavQueryFilter::SetFixedAreaEnteringCost(uint8 AreaType, float Cost)
+{
+	if (AreaType < NAVDATA_MAX_AREAS)
+	{
+		AreaEnteringCosts[AreaType + 1] = Cost;
+		bHasAreaCosts = true;
+	}
+}
+
+void FGunfire3DNavQueryFilter::SetExcludedArea(uint8 AreaType)
+{
+	if (AreaType < NAVDATA_MAX_AREAS)
+	{
+		ExcludedAreaCodes |= (1ull << (AreaType + 1));
+		bHasAreaCosts = true;
+	}
+}
+
+void FGunfire3DNavQueryFilter::SetAllAreaCosts(const float* CostArray, const int32 Count)
+{
+	const int32 NumAreas = FMath::Min(Count, NAVDATA_MAX_AREAS);
+	for (int32 AreaType = 0; AreaType < NumAreas; ++AreaType)
+	{
+		AreaCosts[AreaType + 1] = CostArray[AreaType];
+	}
+
+	bHasAreaCosts = true;
+}
+
+void FGunfire3DNavQueryFilter::GetAllAreaCosts(float* CostArray, float* FixedCostArray, const int32 Count) const
+{
+	const int32 NumAreas = FMath::Min(Count, NAVDATA_MAX_AREAS);
+	for (int32 AreaType = 0; AreaType < NumAreas; ++AreaType)
+	{
+		CostArray[AreaType] = AreaCosts[AreaType + 1];
+		FixedCostArray[AreaType] = AreaEnteringCosts[AreaType + 1];
+	}
+}
+
+bool FGunfire3DNavQueryFilter::HasAreaEnteringCosts() const
+{
+	if (!bHasAreaCosts)
+	{
+		return false;
+	}
+
+	for (int32 AreaCode = 0; AreaCode <= NAVDATA_MAX_AREAS; ++AreaCode)
+	{
+		if (AreaEnteringCosts[AreaCode] != 0.f)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FGunfire3DNavQueryFilter::CopyAreaCosts(const FGunfire3DNavQueryFilter& Other)
+{
+	FMemory::Memcpy(AreaCosts, Other.AreaCosts, sizeof(AreaCosts));
+	FMemory::Memcpy(AreaEnteringCosts, Other.AreaEnteringCosts, sizeof(AreaEnteringCosts));
+	ExcludedAreaCodes = Other.ExcludedAreaCodes;
+	bHasAreaCosts = Other.bHasAreaCosts;
+}
+
+void FGunfire3DNavQueryFilter::Serialize(FArchive& Ar)
+{
+	Ar << HeuristicScale;
+	Ar << BaseTraversalCost;
+	Ar << MinClearance;
+	Ar << CoarseSearchLayer;
+	Ar << bBidirectionalSearch;
+	Ar << bLandmarkHeuristic;
+	Ar << OpenListType;
+
+	Ar.Serialize(AreaCosts, sizeof(AreaCosts));
+	Ar.Serialize(AreaEnteringCosts, sizeof(AreaEnteringCosts));
+	Ar << ExcludedAreaCodes;
+	Ar << bHasAreaCosts;
+
+	TArray<FBox> ConstraintBounds = Constraints.GetBoundsConstraints();
+	Ar << ConstraintBounds;
+
+	if (Ar.IsLoading())
+	{
+		Constraints.SetBoundsConstraints(ConstraintBounds);
+	}
+}
+
 bool FGunfire3DNavQueryFilter::IsEqual(const INavigationQueryFilterInterface* Other) const
 {
 	// TODO: This doesn't play nice with any other filter type. Epic mentions this in
@@ -50,6 +164,40 @@ bool FGunfire3DNavQueryFilter::IsEqual(const INavigationQueryFilterInterface* Ot
 	return FMemory::Memcmp(this, Other, sizeof(FGunfire3DNavQueryFilter)) == 0;
 }
 
+uint32 FGunfire3DNavQueryFilter::GetHash() const
+{
+	// Only the settings are hashed, not the raw memory, which also holds the vtable,
+	// OnNodeVisited, padding and where the constraints happen to be allocated. Copies
+	// of a filter then hash the same, and changing the constraints changes the hash.
+	uint32 Hash = 0;
+	auto HashValue = [&Hash](const auto& Value)
+	{
+		Hash = FCrc::MemCrc32(&Value, sizeof(Value), Hash);
+	};
+
+	HashValue(HeuristicScale);
+	HashValue(BaseTraversalCost);
+	HashValue(MinClearance);
+	HashValue(CoarseSearchLayer);
+	HashValue(bBidirectionalSearch);
+	HashValue(bLandmarkHeuristic);
+	HashValue(OpenListType);
+
+	HashValue(AreaCosts);
+	HashValue(AreaEnteringCosts);
+	HashValue(ExcludedAreaCodes);
+	HashValue(bHasAreaCosts);
+
+	for (const FBox& Bounds : Constraints.GetBoundsConstraints())
+	{
+		HashValue(Bounds.Min);
+		HashValue(Bounds.Max);
+		HashValue(Bounds.IsValid);
+	}
+
+	return Hash;
+}
+
 INavigationQueryFilterInterface* FGunfire3DNavQueryFilter::CreateCopy() const
 {
 	return new FGunfire3DNavQueryFilter(*this);
@@ -69,8 +217,20 @@ void UGunfire3DNavigationQueryFilter::InitializeFilter(const ANavigationData& Na
 		Filter.SetFilterType<FGunfire3DNavQueryFilter>();
 		if (FGunfire3DNavQueryFilter* NavFilterImpl = static_cast<FGunfire3DNavQueryFilter*>(Filter.GetImplementation()))
 		{
+			// Start from the area costs of the nav data, which the area overrides of this
+			// filter are applied on top of.
+			if (const FGunfire3DNavQueryFilter* DefaultFilterImpl = static_cast<const FGunfire3DNavQueryFilter*>(NavData.GetDefaultQueryFilterImpl()))
+			{
+				NavFilterImpl->CopyAreaCosts(*DefaultFilterImpl);
+			}
+
 			NavFilterImpl->SetHeuristicScale(PathHeuristicScale);
 			NavFilterImpl->SetBaseTraversalCost(NodeBaseTraversalCost);
+			NavFilterImpl->SetMinClearance(MinClearance);
+			NavFilterImpl->SetCoarseSearchLayer(CoarseSearchLayer);
+			NavFilterImpl->SetBidirectionalSearch(bBidirectionalPathSearch);
+			NavFilterImpl->SetLandmarkHeuristic(bLandmarkPathHeuristic);
+			NavFilterImpl->SetOpenListType(OpenListType);
 		}
 
 		Filter.SetMaxSearchNodes(MaxPathSearchNodes);
@@ -0,0 +1,269 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "Gunfire3DNavQueryReplayCommandlet.h"
+
+#include "Gunfire3DNavBuildCommandlet.h"
+#include "Gunfire3DNavData.h"
+#include "NavSvo/NavSvoQueryCapture.h"
+
+#include "EngineUtils.h"
+#include "Misc/FileHelper.h"
+
+namespace Gunfire3DNavQueryReplay
+{
+	// A captured query with the nav data and filter it's replayed with, resolved up front
+	// so none of that is timed
+	struct FReplayQuery
+	{
+		const FNavSvoCapturedQuery* Query = nullptr;
+		const AGunfire3DNavData* NavData = nullptr;
+		FSharedConstNavQueryFilter Filter;
+	};
+
+	struct FMeasurement
+	{
+		int32 NumSucceeded = 0;
+		double TotalMs = 0.0;
+
+		// Time taken by each query, sorted once the replay is done
+		TArray<double> OperationMs;
+
+		double GetPercentileMs(float Percentile) const
+		{
+			if (OperationMs.Num() == 0)
+			{
+				return 0.0;
+			}
+
+			const int32 Idx = FMath::Clamp(FMath::CeilToInt(Percentile * OperationMs.Num()) - 1, 0, OperationMs.Num() - 1);
+			return OperationMs[Idx];
+		}
+
+		double GetOperationsPerSecond() const
+		{
+			return OperationMs.Num() / FMath::Max(TotalMs * 0.001, (double)SMALL_NUMBER);
+		}
+	};
+
+	bool RunQuery(const FReplayQuery& ReplayQuery)
+	{
+		const FNavSvoCapturedQuery& Query = *ReplayQuery.Query;
+		const AGunfire3DNavData& NavData = *ReplayQuery.NavData;
+
+		switch (Query.Type)
+		{
+		case ENavSvoCapturedQueryType::FindPath:
+		case ENavSvoCapturedQueryType::FindHierarchicalPath:
+		{
+			FPathFindingQuery PathQuery(nullptr, NavData, Query.Start, Query.End, ReplayQuery.Filter);
+			PathQuery.SetAllowPartialPaths(Query.bAllowPartialPaths);
+
+			const FPathFindingResult Result = (Query.Type == ENavSvoCapturedQueryType::FindHierarchicalPath) ?
+				AGunfire3DNavData::FindHierarchicalPath(NavData.GetConfig(), PathQuery) :
+				AGunfire3DNavData::FindPath(NavData.GetConfig(), PathQuery);
+
+			return Result.IsSuccessful();
+		}
+
+		case ENavSvoCapturedQueryType::TestPath:
+		{
+			const FPathFindingQuery PathQuery(nullptr, NavData, Query.Start, Query.End, ReplayQuery.Filter);
+			return AGunfire3DNavData::TestPath(NavData.GetConfig(), PathQuery, nullptr);
+		}
+
+		case ENavSvoCapturedQueryType::ProjectPoint:
+		{
+			FNavLocation ProjectedPoint;
+			return NavData.ProjectPoint(Query.Start, ProjectedPoint, Query.End, ReplayQuery.Filter);
+		}
+
+		case ENavSvoCapturedQueryType::Raycast:
+		{
+			FVector HitLocation;
+			return NavData.Raycast(Query.Start, Query.End, HitLocation, ReplayQuery.Filter);
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	const AGunfire3DNavData* FindNavData(UWorld* World, const FString& Name)
+	{
+		const AGunfire3DNavData* FirstNavData = nullptr;
+
+		for (TActorIterator<AGunfire3DNavData> It(World); It; ++It)
+		{
+			if (It->GetName() == Name)
+			{
+				return *It;
+			}
+
+			if (FirstNavData == nullptr)
+			{
+				FirstNavData = *It;
+			}
+		}
+
+		if (FirstNavData != nullptr)
+		{
+			UE_LOG(LogNavigation, Warning, TEXT("Gunfire3DNavQueryReplay: No nav data named %s, using %s instead"), *Name, *FirstNavData->GetName());
+		}
+
+		return FirstNavData;
+	}
+}
+
+int32 UGunfire3DNavQueryReplayCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	using namespace Gunfire3DNavQueryReplay;
+
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavQueryReplay: No map specified (-Map=<Map>)"));
+		return 1;
+	}
+
+	FString CaptureFilename;
+	if (!FParse::Value(*Params, TEXT("Capture="), CaptureFilename))
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavQueryReplay: No capture specified (-Capture=<File>)"));
+		return 1;
+	}
+
+	int32 NumRepeats = 1;
+	FParse::Value(*Params, TEXT("Repeat="), NumRepeats);
+	NumRepeats = FMath::Max(NumRepeats, 1);
+
+	FString ReportFilename;
+	FParse::Value(*Params, TEXT("Report="), ReportFilename);
+
+	FNavSvoQueryCaptureData Capture;
+	if (!FNavSvoQueryCapture::Load(CaptureFilename, Capture))
+	{
+		return 1;
+	}
+
+	UWorld* World = UGunfire3DNavBuildCommandlet::LoadWorld(MapName);
+	if (World == nullptr)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavQueryReplay: Failed to load map '%s'"), *MapName);
+		return 1;
+	}
+
+	TArray<const AGunfire3DNavData*> NavDatas;
+	for (const FString& NavDataName : Capture.NavDataNames)
+	{
+		NavDatas.Add(FindNavData(World, NavDataName));
+	}
+
+	// Filters are recreated for each nav data they're used with, since they start from
+	// its default filter
+	TMap<TPair<int32, int32>, FSharedConstNavQueryFilter> Filters;
+
+	TArray<FReplayQuery> ReplayQueries;
+	ReplayQueries.Reserve(Capture.Queries.Num());
+
+	for (const FNavSvoCapturedQuery& Query : Capture.Queries)
+	{
+		const AGunfire3DNavData* NavData = NavDatas.IsValidIndex(Query.NavDataIdx) ? NavDatas[Query.NavDataIdx] : nullptr;
+		if (NavData == nullptr || !NavData->HasValidOctree() || (uint8)Query.Type >= (uint8)ENavSvoCapturedQueryType::Num)
+		{
+			continue;
+		}
+
+		FReplayQuery& ReplayQuery = ReplayQueries.AddDefaulted_GetRef();
+		ReplayQuery.Query = &Query;
+		ReplayQuery.NavData = NavData;
+
+		if (Capture.Filters.IsValidIndex(Query.FilterIdx))
+		{
+			FSharedConstNavQueryFilter& Filter = Filters.FindOrAdd(TPair<int32, int32>(Query.NavDataIdx, Query.FilterIdx));
+			if (!Filter.IsValid())
+			{
+				Filter = FNavSvoQueryCapture::CreateFilter(*NavData, Capture.Filters[Query.FilterIdx]);
+			}
+
+			ReplayQuery.Filter = Filter;
+		}
+	}
+
+	if (ReplayQueries.Num() < Capture.Queries.Num())
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("Gunfire3DNavQueryReplay: Skipping %d queries with no built nav data to run on"), Capture.Queries.Num() - ReplayQueries.Num());
+	}
+
+	FMeasurement Measurements[(uint8)ENavSvoCapturedQueryType::Num];
+	for (FMeasurement& Measurement : Measurements)
+	{
+		Measurement.OperationMs.Reserve(ReplayQueries.Num() * NumRepeats);
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Repeat = 0; Repeat < NumRepeats; ++Repeat)
+	{
+		for (const FReplayQuery& ReplayQuery : ReplayQueries)
+		{
+			const uint64 QueryStartCycles = FPlatformTime::Cycles64();
+			const bool bSucceeded = RunQuery(ReplayQuery);
+			const double QueryMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - QueryStartCycles);
+
+			FMeasurement& Measurement = Measurements[(uint8)ReplayQuery.Query->Type];
+			Measurement.OperationMs.Add(QueryMs);
+			Measurement.TotalMs += QueryMs;
+			Measurement.NumSucceeded += bSucceeded ? 1 : 0;
+		}
+	}
+
+	const double ReplayMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	const double CaptureSeconds = (Capture.Queries.Num() > 0) ? Capture.Queries.Last().Time : 0.0;
+
+	UE_LOG(LogNavigation, Display, TEXT("Gunfire3DNavQueryReplay: %d queries captured over %.1fs, replayed %d times in %.1fs on %s"),
+		ReplayQueries.Num(), CaptureSeconds, NumRepeats, ReplayMs * 0.001, *MapName);
+
+	FString Report = TEXT("name,count,succeeded,total_ms,ops_per_sec,p50_ms,p90_ms,p99_ms,max_ms\n");
+	for (uint8 TypeIdx = 0; TypeIdx < (uint8)ENavSvoCapturedQueryType::Num; ++TypeIdx)
+	{
+		FMeasurement& Measurement = Measurements[TypeIdx];
+		if (Measurement.OperationMs.Num() == 0)
+		{
+			continue;
+		}
+
+		Measurement.OperationMs.Sort();
+
+		const TCHAR* Name = FNavSvoQueryCapture::GetTypeName((ENavSvoCapturedQueryType)TypeIdx);
+		UE_LOG(LogNavigation, Display, TEXT("    %-24s %8d ops (%8d succeeded) %10.3f ms %10.2f K/s   p50 %.4f ms  p90 %.4f ms  p99 %.4f ms  max %.4f ms"),
+			Name, Measurement.OperationMs.Num(), Measurement.NumSucceeded, Measurement.TotalMs, Measurement.GetOperationsPerSecond() / 1000.0,
+			Measurement.GetPercentileMs(0.5f), Measurement.GetPercentileMs(0.9f), Measurement.GetPercentileMs(0.99f), Measurement.GetPercentileMs(1.f));
+
+		Report += FString::Printf(TEXT("%s,%d,%d,%.4f,%.2f,%.4f,%.4f,%.4f,%.4f\n"),
+			Name, Measurement.OperationMs.Num(), Measurement.NumSucceeded, Measurement.TotalMs, Measurement.GetOperationsPerSecond(),
+			Measurement.GetPercentileMs(0.5f), Measurement.GetPercentileMs(0.9f), Measurement.GetPercentileMs(0.99f), Measurement.GetPercentileMs(1.f));
+	}
+
+	bool bSuccess = true;
+	if (!ReportFilename.IsEmpty())
+	{
+		if (FFileHelper::SaveStringToFile(Report, *ReportFilename))
+		{
+			UE_LOG(LogNavigation, Display, TEXT("    Report written to %s"), *ReportFilename);
+		}
+		else
+		{
+			UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavQueryReplay: Failed to write report to %s"), *ReportFilename);
+			bSuccess = false;
+		}
+	}
+
+	UGunfire3DNavBuildCommandlet::UnloadWorld(World);
+
+	return bSuccess ? 0 : 1;
+#else
+	UE_LOG(LogNavigation, Error, TEXT("Gunfire3DNavQueryReplay: Only supported in editor builds"));
+	return 1;
+#endif // WITH_EDITOR
+}
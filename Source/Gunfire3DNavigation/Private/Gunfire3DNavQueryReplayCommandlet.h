@@ -0,0 +1,32 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "Gunfire3DNavQueryReplayCommandlet.generated.h"
+
+//
+// Replays queries recorded with NavSvo.CaptureQueries (see FNavSvoQueryCapture) against
+// the 3D navigation saved in a map, and reports the throughput and latency percentiles
+// for each type of query.
+//
+// Usage:
+//   -run=Gunfire3DNavQueryReplay -Map=<Map> -Capture=<File> [-Repeat=<N>] [-Report=<File>]
+//
+// Queries are run back to back on this thread in the order they were recorded, as many
+// times over as 'Repeat' asks for, rather than at the pace they were captured. The
+// results are logged, and also written as CSV if a report file is given. Queries are
+// matched to the nav data in the map with the same name, or the first one if there's
+// none by that name.
+//
+UCLASS()
+class UGunfire3DNavQueryReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
@@ -1,6 +1,9 @@
 // Copyright Gunfire Games, LLC. All Rights Reserved.
 
 #include "Gunfire3DNavData.h"
+#include "NavSvo/NavSvoQueryCapture.h"
+#include "NavSvo/NavSvoQueryStats.h"
+#include "SparseVoxelOctree/SparseVoxelOctreeUtils.h"
 
 #include "Engine/Console.h"
 #include "EngineUtils.h"
@@ -41,6 +44,11 @@ void FGunfire3DNavigation::StartupModule()
 	// This code will execute after your module is loaded into memory (but after global variables are initialized, of course.)
 	UConsole::RegisterConsoleAutoCompleteEntries.AddRaw(this, &FGunfire3DNavigation::PopulateAutoCompleteEntries);
 
+	FNavSvoQueryStats::Startup();
+
+	FSvoUtils::InitMortonBackend();
+	FSvoUtils::InitLeafLineMasks();
+
 #if WITH_EDITOR
 	if (ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings"))
 	{
@@ -57,6 +65,9 @@ void FGunfire3DNavigation::StartupModule()
 
 void FGunfire3DNavigation::ShutdownModule()
 {
+	FNavSvoQueryStats::Shutdown();
+	FNavSvoQueryCapture::Shutdown();
+
 #if WITH_EDITOR
 	FGameDelegates::Get().GetModifyCookDelegate().Remove(CookDelegate);
 #endif
@@ -16,6 +16,24 @@ struct FGunfire3DNavigationCustomVersion
 		// Added 32-bit neighbor node links to free up some memory for other data
 		NodeLinkBaseAdded,
 
+		// Tile IDs are packed tile coordinates instead of hashes of them
+		PackedTileIDs,
+
+		// Node pools can be written as raw blocks that are read straight into place
+		BulkNodePools,
+
+		// Tiles can store the clearance of their open space
+		TileClearance,
+
+		// Streaming data stores pre-baked links to the tiles around it
+		StreamingStitches,
+
+		// Streaming data keeps its octree in bulk data, read in after the package loads
+		StreamingBulkData,
+
+		// Tiles can store the nav area of their open space
+		TileAreas,
+
 		// -----<new versions can be added above this line>-----
 		VersionPlusOne,
 		LatestVersion = VersionPlusOne - 1
@@ -5,51 +5,21 @@
 
 #include "EnvironmentQuery/Contexts/EnvQueryContext_Querier.h"
 #include "EnvironmentQuery/Items/EnvQueryItemType_Point.h"
-#include "Math/GenericOctree.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(EnvQueryGenerator_PathingGrid3D)
 
 #define LOCTEXT_NAMESPACE "Gunfire3DNavigation"
 
-//
-// Simple vector-based semantics for storing locations in the octree
-//
-struct FEQSOctreeSemantics
+namespace EnvQueryPathingGrid3D
 {
-	// When a leaf gets more than this number of elements, it will split itself into a
-	// node with multiple child leaves
-	enum { MaxElementsPerLeaf = 16 };
-
-	// This is used for incremental updates. When removing an element, larger values will
-	// cause leaves to be removed and collapsed into a parent node.
-	enum { MinInclusiveElementsPerNode = 7 };
-
-	// How deep the tree can go.
-	enum { MaxNodeDepth = 12 };
-
-	typedef TInlineAllocator<MaxElementsPerLeaf> ElementAllocator;
-
-	FORCEINLINE static FBoxCenterAndExtent GetBoundingBox(const FVector& Element)
+	// Returns the range of grid indices along one axis which fall within [Min, Max],
+	// clamped to the grid. The range is empty if MinIdx > MaxIdx.
+	FORCEINLINE void GetIndexRange(double Min, double Max, double GridMin, double Spacing, int32 NumIndices, int32& OutMinIdx, int32& OutMaxIdx)
 	{
-		return FBoxCenterAndExtent(Element, FVector::ZeroVector);
+		OutMinIdx = FMath::Max(FMath::CeilToInt((Min - GridMin) / Spacing), 0);
+		OutMaxIdx = FMath::Min(FMath::FloorToInt((Max - GridMin) / Spacing), NumIndices - 1);
 	}
-
-	FORCEINLINE static bool AreElementsEqual(const FVector& A, const FVector& B)
-	{
-		return (A == B);
-	}
-
-	FORCEINLINE static void SetElementId(const FVector& Element, FOctreeElementId2 OctreeElementID)
-	{}
-
-	FORCEINLINE static void ApplyOffset(FVector& Element, FVector Offset)
-	{
-		Element += Offset;
-	}
-};
-
-// Octree to hold all desired EQS query location for quick look-ups based on node bounds.
-typedef TOctree2<FVector, FEQSOctreeSemantics> FEQSOctree;
+}
 
 UEnvQueryGenerator_PathingGrid3D::UEnvQueryGenerator_PathingGrid3D()
 {
@@ -89,8 +59,14 @@ void UEnvQueryGenerator_PathingGrid3D::GenerateItems(FEnvQueryInstance& QueryIns
 	TArray<FVector> ContextLocations;
 	QueryInstance.PrepareContext(GenerateAround, ContextLocations);
 
-	const int32 MaxNumItems = ItemCountXY * (MaxZ - MinZ) * ContextLocations.Num();
-	QueryInstance.ReserveItemData(MaxNumItems);
+	const int32 NumItemsZ = FMath::Max(MaxZ - MinZ + 1, 0);
+	const int32 NumGridItems = ItemCountXY * ItemCountXY * NumItemsZ;
+	if (NumGridItems <= 0)
+	{
+		return;
+	}
+
+	QueryInstance.ReserveItemData(NumGridItems * ContextLocations.Num());
 
 	FSharedNavQueryFilter Filter = NavData->GetDefaultQueryFilter()->GetCopy();
 	FNavigationQueryFilter* QueryFilter = Filter.Get();
@@ -98,68 +74,75 @@ void UEnvQueryGenerator_PathingGrid3D::GenerateItems(FEnvQueryInstance& QueryIns
 	uint32 DefaultMaxSearchNodes = QueryFilter->GetMaxSearchNodes();
 	QueryFilter->SetMaxSearchNodes(DefaultMaxSearchNodes * 4);
 
-	// Keep track of all items that have been added to the results so we don't duplicate.
-	// This is necessary as we may receive multiple nodes from 3D navigation that both
-	// contain the same location.
-	TSet<FVector> AddedItemLookup;
+	// Keep track of which grid points have been added to the results so we don't
+	// duplicate, one bit per point. This is necessary as we may receive multiple nodes
+	// from 3D navigation that both contain the same location.
+	TBitArray<> AddedItems;
+
+	// Contexts which project to the same location would generate the same grid
+	TArray<FVector, TInlineAllocator<4>> GeneratedAround;
 
-	// For each context location, store all potential points within an octree then query
-	// the 3D navigation for nodes that are reachable within our radius, adding any points
-	// that are within each node bounds as results.
+	// For each context location, query the 3D navigation for nodes that are reachable
+	// within our radius, adding any grid points that are within each node bounds as
+	// results. The grid is regular, so the points within a node can be found from its
+	// bounds directly.
 	for (const FVector& ContextLocation : ContextLocations)
 	{
 		FNavLocation ContextNavLocation;
 		if (NavData->ProjectPoint(ContextLocation, ContextNavLocation, NavData->GetDefaultQueryExtent(), Filter))
 		{
-			FEQSOctree EQSOctree(ContextNavLocation.Location, RadiusValue);
-
-			// Add all test locations to the octree
-			for (int32 x = 0; x < ItemCountXY; ++x)
+			if (GeneratedAround.Contains(ContextNavLocation.Location))
 			{
-				for (int32 y = 0; y < ItemCountXY; ++y)
-				{
-					for (int32 z = MinZ; z <= MaxZ; ++z)
-					{
-						const FVector Offset(DensityValue * (x - ItemCountHalf), DensityValue * (y - ItemCountHalf), DensityValue * z);
-						const FVector TestLocation = ContextNavLocation.Location + Offset;
-
-						// Only add the location to the octree if it is within the defined
-						// navigable space.
-						if (NavData->IsLocationWithinGenerationBounds(TestLocation))
-						{
-							EQSOctree.AddElement(TestLocation);
-						}
-					}
-				}
+				continue;
 			}
 
-			// Function called on every node visited during the navigation query.
-			auto OnNodeVisited = [&NavData, &EQSOctree, &AddedItemLookup, &QueryInstance](NavNodeRef NodeRef) -> bool
+			GeneratedAround.Add(ContextNavLocation.Location);
+
+			const FVector GridMin = ContextNavLocation.Location + FVector(-DensityValue * ItemCountHalf, -DensityValue * ItemCountHalf, DensityValue * MinZ);
+			const FBox GridBounds(GridMin, GridMin + FVector(DensityValue * (ItemCountXY - 1), DensityValue * (ItemCountXY - 1), DensityValue * (NumItemsZ - 1)));
+
+			AddedItems.Init(false, NumGridItems);
+
+			// Function called with each chunk of nodes visited during the navigation query.
+			// The bounds come along with the nodes, so they don't need to be looked up.
+			auto OnNodesVisited = [&](TArrayView<const NavNodeRef> Nodes, TArrayView<const FBox> NodeBoundsList) -> bool
 			{
-				FBox NodeBounds;
-				if (NavData->GetNodeBounds(NodeRef, NodeBounds))
+				for (const FBox& NodeBounds : NodeBoundsList)
 				{
-					// If true, the specified EQS octree-node will be searched
-					auto CanOpenNode = [&NodeBounds](FEQSOctree::FNodeIndex ParentNodeIndex, FEQSOctree::FNodeIndex NodeIndex, const FBoxCenterAndExtent& OctreeNodeBounds) -> bool
+					if (!NodeBounds.Intersect(GridBounds))
 					{
-						return (OctreeNodeBounds.GetBox().Intersect(NodeBounds));
-					};
+						continue;
+					}
+
+					int32 MinX, MaxX, MinY, MaxY, MinGridZ, MaxGridZ;
+					EnvQueryPathingGrid3D::GetIndexRange(NodeBounds.Min.X, NodeBounds.Max.X, GridMin.X, DensityValue, ItemCountXY, MinX, MaxX);
+					EnvQueryPathingGrid3D::GetIndexRange(NodeBounds.Min.Y, NodeBounds.Max.Y, GridMin.Y, DensityValue, ItemCountXY, MinY, MaxY);
+					EnvQueryPathingGrid3D::GetIndexRange(NodeBounds.Min.Z, NodeBounds.Max.Z, GridMin.Z, DensityValue, NumItemsZ, MinGridZ, MaxGridZ);
 
-					// Function called on every element explored in the EQS octree
-					auto OnElementExplored = [&NodeBounds, &AddedItemLookup, &QueryInstance](FEQSOctree::FNodeIndex ParentNodeIndex, const FVector& Element)
+					for (int32 x = MinX; x <= MaxX; ++x)
 					{
-						if (NodeBounds.IsInsideOrOn(Element))
+						for (int32 y = MinY; y <= MaxY; ++y)
 						{
-							if (!AddedItemLookup.Find(Element))
+							for (int32 z = MinGridZ; z <= MaxGridZ; ++z)
 							{
-								AddedItemLookup.Add(Element);
-								QueryInstance.AddItemData<UEnvQueryItemType_Point>(Element);
+								const int32 ItemIdx = (x * ItemCountXY + y) * NumItemsZ + z;
+								if (AddedItems[ItemIdx])
+								{
+									continue;
+								}
+
+								AddedItems[ItemIdx] = true;
+
+								// Only add the location if it is within the defined
+								// navigable space.
+								const FVector TestLocation = GridMin + FVector(DensityValue * x, DensityValue * y, DensityValue * z);
+								if (NavData->IsLocationWithinGenerationBounds(TestLocation))
+								{
+									QueryInstance.AddItemData<UEnvQueryItemType_Point>(TestLocation);
+								}
 							}
 						}
-					};
-
-					// Grab all potential destination points within the node bounds
-					EQSOctree.FindElementsWithPredicate(CanOpenNode, OnElementExplored);
+					}
 				}
 
 				// Return true to keep the navigation query going.
@@ -172,7 +155,7 @@ void UEnvQueryGenerator_PathingGrid3D::GenerateItems(FEnvQueryInstance& QueryIns
 			// NOTE: The search will end if the node pool is depleted. This is controlled
 			// by the query filter. Do not make this some crazy value as it will affect
 			// performance.
-			NavData->ForEachReachableNode(ContextNavLocation.Location, 0.f, OnNodeVisited, QueryFilter->AsShared());
+			NavData->ForEachReachableNodeChunk(ContextNavLocation.Location, 0.f, OnNodesVisited, QueryFilter->AsShared());
 		}
 	}
 }
@@ -0,0 +1,143 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "EnvQueryTest_PathDistance3D.h"
+#include "Gunfire3DNavData.h"
+#include "Gunfire3DNavPath.h"
+
+#include "EnvironmentQuery/Contexts/EnvQueryContext_Querier.h"
+#include "EnvironmentQuery/Items/EnvQueryItemType_VectorBase.h"
+#include "NavFilters/NavigationQueryFilter.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(EnvQueryTest_PathDistance3D)
+
+#define LOCTEXT_NAMESPACE "Gunfire3DNavigation"
+
+DECLARE_CYCLE_STAT(TEXT("PathDistance3D Test"), STAT_EnvQueryTest_PathDistance3D, STATGROUP_Gunfire3DNavigation);
+
+UEnvQueryTest_PathDistance3D::UEnvQueryTest_PathDistance3D()
+{
+	Context = UEnvQueryContext_Querier::StaticClass();
+	Cost = EEnvTestCost::High;
+	ValidItemType = UEnvQueryItemType_VectorBase::StaticClass();
+	TestMode = EEnvTestPathfinding::PathLength;
+	MaxPathCost.DefaultValue = 0.f;
+	SkipUnreachable.DefaultValue = true;
+	FloatValueMin.DefaultValue = 1000.0f;
+	FloatValueMax.DefaultValue = 1000.0f;
+
+	SetWorkOnFloatValues(TestMode != EEnvTestPathfinding::PathExist);
+}
+
+void UEnvQueryTest_PathDistance3D::RunTest(FEnvQueryInstance& QueryInstance) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnvQueryTest_PathDistance3D);
+
+	UObject* QueryOwner = QueryInstance.Owner.Get();
+	BoolValue.BindData(QueryOwner, QueryInstance.QueryID);
+	MaxPathCost.BindData(QueryOwner, QueryInstance.QueryID);
+	SkipUnreachable.BindData(QueryOwner, QueryInstance.QueryID);
+	FloatValueMin.BindData(QueryOwner, QueryInstance.QueryID);
+	FloatValueMax.BindData(QueryOwner, QueryInstance.QueryID);
+
+	const bool bWantsPath = BoolValue.GetValue();
+	const bool bDiscardFailed = SkipUnreachable.GetValue();
+	const float MaxCost = FMath::Max(MaxPathCost.GetValue(), 0.f);
+	const float MinThresholdValue = FloatValueMin.GetValue();
+	const float MaxThresholdValue = FloatValueMax.GetValue();
+
+	const AGunfire3DNavData* NavData = Cast<AGunfire3DNavData>(FEQSHelpers::FindNavigationDataForQuery(QueryInstance));
+
+	// This is only designed to work with 3D nav data, so early out if this isn't that
+	if (NavData == nullptr)
+	{
+		return;
+	}
+
+	TArray<FVector> ContextLocations;
+	if (!QueryInstance.PrepareContext(Context, ContextLocations))
+	{
+		return;
+	}
+
+	FSharedConstNavQueryFilter NavFilter = UNavigationQueryFilter::GetQueryFilter(*NavData, QueryOwner, FilterClass);
+
+	// One search per context covers every item. Contexts which can't reach the nav data
+	// are left unset and fail every item.
+	TArray<FGunfire3DNavFlowFieldPtr, TInlineAllocator<4>> FlowFields;
+	FlowFields.Reserve(ContextLocations.Num());
+
+	for (const FVector& ContextLocation : ContextLocations)
+	{
+		FlowFields.Add(NavData->FindFlowField(ContextLocation, MaxCost, NavFilter));
+	}
+
+	for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
+	{
+		const FVector ItemLocation = GetItemLocation(QueryInstance, It.GetIndex());
+
+		for (const FGunfire3DNavFlowFieldPtr& FlowField : FlowFields)
+		{
+			float PathCost = 0.f;
+			float PathLength = 0.f;
+			const bool bFoundPath = FlowField.IsValid() && NavData->GetFlowFieldRoute(*FlowField, ItemLocation, PathCost, PathLength);
+
+			if (TestMode == EEnvTestPathfinding::PathExist)
+			{
+				It.SetScore(TestPurpose, FilterType, bFoundPath, bWantsPath);
+			}
+			else
+			{
+				const float PathValue = bFoundPath ? ((TestMode == EEnvTestPathfinding::PathCost) ? PathCost : PathLength) : BIG_NUMBER;
+				It.SetScore(TestPurpose, FilterType, PathValue, MinThresholdValue, MaxThresholdValue);
+			}
+
+			if (bDiscardFailed && !bFoundPath)
+			{
+				It.ForceItemState(EEnvItemStatus::Failed);
+			}
+		}
+	}
+}
+
+FText UEnvQueryTest_PathDistance3D::GetDescriptionTitle() const
+{
+	FString ModeDesc[] = { TEXT("PathExist"), TEXT("PathCost"), TEXT("PathLength") };
+
+	return FText::FromString(FString::Printf(TEXT("%s: %s from %s"),
+		*Super::GetDescriptionTitle().ToString(), *ModeDesc[TestMode], *UEnvQueryTypes::DescribeContext(Context).ToString()));
+}
+
+FText UEnvQueryTest_PathDistance3D::GetDescriptionDetails() const
+{
+	FText DiscardDesc = LOCTEXT("DiscardUnreachable", "discard unreachable");
+	FText Desc2 = SkipUnreachable.IsDynamic() || SkipUnreachable.DefaultValue ? DiscardDesc : FText::GetEmpty();
+
+	FText TestParamDesc = GetWorkOnFloatValues() ? DescribeFloatTestParams() : DescribeBoolTestParams("existing path");
+	if (!Desc2.IsEmpty())
+	{
+		return FText::Format(FText::FromString("{0}\n{1}"), Desc2, TestParamDesc);
+	}
+
+	return TestParamDesc;
+}
+
+#if WITH_EDITOR
+void UEnvQueryTest_PathDistance3D::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.Property && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UEnvQueryTest_PathDistance3D, TestMode))
+	{
+		SetWorkOnFloatValues(TestMode != EEnvTestPathfinding::PathExist);
+	}
+}
+#endif
+
+void UEnvQueryTest_PathDistance3D::PostLoad()
+{
+	Super::PostLoad();
+
+	SetWorkOnFloatValues(TestMode != EEnvTestPathfinding::PathExist);
+}
+
+#undef LOCTEXT_NAMESPACE
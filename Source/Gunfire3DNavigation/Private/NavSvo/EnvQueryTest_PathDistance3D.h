@@ -0,0 +1,60 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "DataProviders/AIDataProvider.h"
+#include "EnvironmentQuery/EnvQueryTest.h"
+#include "EnvironmentQuery/Tests/EnvQueryTest_Pathfinding.h"
+
+#include "EnvQueryTest_PathDistance3D.generated.h"
+
+class UNavigationQueryFilter;
+
+//
+// Pathfinding test for 3D navigation. Rather than finding a path to every item, each
+// context runs a single search outward over the octree (see AGunfire3DNavData::FindFlowField)
+// and every item reads its cost or length straight from what that search reached, so
+// scoring hundreds of items costs about as much as one path.
+//
+// NOTE: Routes are measured from the context to the items, and lengths follow the node
+// portals so they're what the paths would be before string pulling.
+//
+UCLASS(meta = (DisplayName = "Pathfinding: 3D Path Distance"))
+class GUNFIRE3DNAVIGATION_API UEnvQueryTest_PathDistance3D : public UEnvQueryTest
+{
+	GENERATED_BODY()
+
+	// Testing mode
+	UPROPERTY(EditDefaultsOnly, Category = Pathfinding)
+	TEnumAsByte<EEnvTestPathfinding::Type> TestMode;
+
+	// Context to find paths from
+	UPROPERTY(EditDefaultsOnly, Category = Pathfinding)
+	TSubclassOf<UEnvQueryContext> Context;
+
+	// If greater than zero, items with a path cost above this are treated as unreachable.
+	// This also bounds the search, so keep it as low as the query allows.
+	UPROPERTY(EditDefaultsOnly, Category = Pathfinding, AdvancedDisplay)
+	FAIDataProviderFloatValue MaxPathCost;
+
+	// If set, items with failed path will be invalidated
+	UPROPERTY(EditDefaultsOnly, Category = Pathfinding, AdvancedDisplay)
+	FAIDataProviderBoolValue SkipUnreachable;
+
+	// Navigation filter to use in pathfinding
+	UPROPERTY(EditDefaultsOnly, Category = Pathfinding)
+	TSubclassOf<UNavigationQueryFilter> FilterClass;
+
+	UEnvQueryTest_PathDistance3D();
+
+	virtual void RunTest(FEnvQueryInstance& QueryInstance) const override;
+
+	virtual FText GetDescriptionTitle() const override;
+	virtual FText GetDescriptionDetails() const override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	virtual void PostLoad() override;
+};
@@ -0,0 +1,69 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoBenchmark.h"
+
+#include "AI/Navigation/NavigationTypes.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+double FNavSvoBenchmarkMeasurement::GetPercentileMs(float Percentile) const
+{
+	if (SortedOperationMs.Num() == 0)
+	{
+		return 0.0;
+	}
+
+	const int32 Idx = FMath::Clamp(FMath::CeilToInt(Percentile * SortedOperationMs.Num()) - 1, 0, SortedOperationMs.Num() - 1);
+	return SortedOperationMs[Idx];
+}
+
+double FNavSvoBenchmarkMeasurement::GetOperationsPerSecond() const
+{
+	return NumOperations / FMath::Max(TotalMs * 0.001, (double)SMALL_NUMBER);
+}
+
+FNavSvoBenchmarkMeasurement& FNavSvoBenchmarkReport::AddTotal(const TCHAR* Name, int32 NumOperations, int32 NumSucceeded, double TotalMs)
+{
+	FNavSvoBenchmarkMeasurement& Measurement = Measurements.AddDefaulted_GetRef();
+	Measurement.Name = Name;
+	Measurement.NumOperations = NumOperations;
+	Measurement.NumSucceeded = NumSucceeded;
+	Measurement.TotalMs = TotalMs;
+	return Measurement;
+}
+
+const FNavSvoBenchmarkMeasurement* FNavSvoBenchmarkReport::Find(const TCHAR* Name) const
+{
+	return Measurements.FindByPredicate([Name](const FNavSvoBenchmarkMeasurement& Measurement) { return Measurement.Name == Name; });
+}
+
+bool FNavSvoBenchmarkReport::Write(const FString& Title, const FString& Filename) const
+{
+	UE_LOG(LogNavigation, Display, TEXT("%s"), *Title);
+
+	FString Report = TEXT("name,count,succeeded,total_ms,ops_per_sec,p50_ms,p95_ms,max_ms\n");
+	for (const FNavSvoBenchmarkMeasurement& Measurement : Measurements)
+	{
+		UE_LOG(LogNavigation, Display, TEXT("    %-24s %6d ops (%6d succeeded) %10.3f ms %10.2f K/s   p50 %.4f ms  p95 %.4f ms  max %.4f ms"),
+			*Measurement.Name, Measurement.NumOperations, Measurement.NumSucceeded, Measurement.TotalMs, Measurement.GetOperationsPerSecond() / 1000.0,
+			Measurement.GetPercentileMs(0.5f), Measurement.GetPercentileMs(0.95f), Measurement.GetPercentileMs(1.f));
+
+		Report += FString::Printf(TEXT("%s,%d,%d,%.4f,%.2f,%.4f,%.4f,%.4f\n"),
+			*Measurement.Name, Measurement.NumOperations, Measurement.NumSucceeded, Measurement.TotalMs, Measurement.GetOperationsPerSecond(),
+			Measurement.GetPercentileMs(0.5f), Measurement.GetPercentileMs(0.95f), Measurement.GetPercentileMs(1.f));
+	}
+
+	if (!FFileHelper::SaveStringToFile(Report, *Filename))
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("    Failed to write report to %s"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogNavigation, Display, TEXT("    Report written to %s"), *Filename);
+	return true;
+}
+
+FString FNavSvoBenchmarkReport::GetDefaultFilename(const FString& Name)
+{
+	return FPaths::ProfilingDir() / TEXT("NavSvo") / FString::Printf(TEXT("Benchmark-%s-%s.csv"), *Name, *FDateTime::Now().ToString());
+}
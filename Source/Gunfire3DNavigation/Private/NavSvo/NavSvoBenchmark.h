@@ -0,0 +1,75 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//
+// Timing of one kind of operation in a benchmark
+//
+struct FNavSvoBenchmarkMeasurement
+{
+	FString Name;
+	int32 NumOperations = 0;
+
+	// Operations which succeeded, or hit something for raycasts
+	int32 NumSucceeded = 0;
+
+	double TotalMs = 0.0;
+
+	// Time taken by each operation, sorted, if they were timed individually
+	TArray<double> SortedOperationMs;
+
+	double GetPercentileMs(float Percentile) const;
+	double GetOperationsPerSecond() const;
+};
+
+//
+// Measurements collected by a benchmark, which are logged and written out as CSV so
+// runs can be compared by tools. Used by the NavSvo.Benchmark command and the
+// synthetic octree benchmark tests.
+//
+class FNavSvoBenchmarkReport
+{
+public:
+	// Times each operation on its own, so the report can include percentiles. 'Func'
+	// is called with the index of each operation and returns whether it succeeded.
+	template<typename TFunc>
+	FNavSvoBenchmarkMeasurement& MeasureEach(const TCHAR* Name, int32 NumOperations, const TFunc& Func)
+	{
+		FNavSvoBenchmarkMeasurement& Measurement = Measurements.AddDefaulted_GetRef();
+		Measurement.Name = Name;
+		Measurement.NumOperations = NumOperations;
+		Measurement.SortedOperationMs.Reserve(NumOperations);
+
+		for (int32 OperationIdx = 0; OperationIdx < NumOperations; ++OperationIdx)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			const bool bSucceeded = Func(OperationIdx);
+			const double OperationMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+			Measurement.SortedOperationMs.Add(OperationMs);
+			Measurement.TotalMs += OperationMs;
+			Measurement.NumSucceeded += bSucceeded ? 1 : 0;
+		}
+
+		Measurement.SortedOperationMs.Sort();
+		return Measurement;
+	}
+
+	// Adds operations which were only timed as a whole, so have no percentiles
+	FNavSvoBenchmarkMeasurement& AddTotal(const TCHAR* Name, int32 NumOperations, int32 NumSucceeded, double TotalMs);
+
+	// Returns the measurement with the given name, or null if there isn't one
+	const FNavSvoBenchmarkMeasurement* Find(const TCHAR* Name) const;
+
+	// Logs every measurement under 'Title' and writes them to 'Filename' as CSV. Returns
+	// false if the file couldn't be written.
+	bool Write(const FString& Title, const FString& Filename) const;
+
+	// Returns where reports are written by default, named after what was measured
+	static FString GetDefaultFilename(const FString& Name);
+
+private:
+	TArray<FNavSvoBenchmarkMeasurement> Measurements;
+};
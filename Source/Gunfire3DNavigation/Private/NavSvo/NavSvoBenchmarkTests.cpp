@@ -0,0 +1,493 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "Gunfire3DNavData.h"
+#include "Gunfire3DNavigationTypes.h"
+#include "NavSvoBenchmark.h"
+#include "NavSvoGenerationStats.h"
+#include "NavSvoGeneratorConfig.h"
+#include "NavSvoLocationQuery.h"
+#include "NavSvoPathQuery.h"
+#include "NavSvoTileGenerator.h"
+#include "NavSvoUtils.h"
+#include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
+#include "SparseVoxelOctree/SparseVoxelOctreeTile.h"
+
+#include "Algo/Count.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//
+// Benchmarks generation and queries over octrees built from synthetic volumes, so the
+// results don't depend on whatever map is loaded and can be compared between runs (and
+// machines) to catch regressions. Each scenario writes its measurements as CSV, in the
+// same format as the NavSvo.Benchmark command.
+//
+namespace NavSvoBenchmarkTests
+{
+	// Size of every scenario's volume, in tiles
+	const FIntVector NumTilesPerAxis(6, 6, 3);
+
+	const int32 NumQueries = 256;
+
+	// Searches are given enough nodes to visit the whole volume, so they only come up
+	// short when the endpoints aren't connected, rather than depending on the default
+	// limit.
+	const int32 MaxSearchNodes = 1 << 18;
+
+	// Fixed so every run generates the same volumes and picks the same endpoints
+	const int32 RandomSeed = 0x5E3D;
+
+	typedef TFunction<bool(const FVector& Location)> FBlockedFunc;
+
+	struct FScenario
+	{
+		const TCHAR* Name = nullptr;
+
+		// Returns whether a voxel centered at the location is blocked
+		FBlockedFunc IsBlocked;
+
+		// Set if every open location is reachable from every other, so all paths must be
+		// found in full
+		bool bFullyConnected = false;
+
+		// Set if nothing is blocked, so no ray between open locations can hit anything
+		bool bEmpty = false;
+	};
+
+	// Returns the world bounds the scenarios fill, for the given generator config
+	FBox GetVolumeBounds(const FNavSvoGeneratorConfig& Config)
+	{
+		return FBox(Config.GetTileBounds(FIntVector::ZeroValue).Min, Config.GetTileBounds(NumTilesPerAxis - FIntVector(1)).Max);
+	}
+
+	// Open space with nothing in it, where every tile collapses to a single node
+	FScenario MakeOpenSpace(const FBox& Volume)
+	{
+		FScenario Scenario;
+		Scenario.Name = TEXT("OpenSpace");
+		Scenario.IsBlocked = [](const FVector& Location) { return false; };
+		Scenario.bFullyConnected = true;
+		Scenario.bEmpty = true;
+		return Scenario;
+	}
+
+	// A regular grid of thin columns running through the whole height of the volume
+	FScenario MakePillars(const FBox& Volume)
+	{
+		const float Spacing = 512.f;
+		const float Radius = 64.f;
+
+		FScenario Scenario;
+		Scenario.Name = TEXT("Pillars");
+		Scenario.IsBlocked = [Origin = Volume.Min, Spacing, Radius](const FVector& Location)
+		{
+			const FVector2D Offset(Location.X - Origin.X, Location.Y - Origin.Y);
+			const FVector2D ToPillar(
+				Offset.X - (FMath::FloorToFloat(Offset.X / Spacing) + 0.5f) * Spacing,
+				Offset.Y - (FMath::FloorToFloat(Offset.Y / Spacing) + 0.5f) * Spacing);
+
+			return ToPillar.SizeSquared() < FMath::Square(Radius);
+		};
+		Scenario.bFullyConnected = true;
+		return Scenario;
+	}
+
+	// Solid rock with a 3D maze of tunnels carved through it. The maze is a spanning tree
+	// over its cells, so there's exactly one way between any two locations and paths
+	// have to wind through most of the volume.
+	FScenario MakeMazeCaves(const FBox& Volume)
+	{
+		// Wide enough that the tunnels stay open once they're padded for the agent
+		const float BlockSize = 320.f;
+		const FVector VolumeSize = Volume.GetSize();
+		const FIntVector NumBlocks(
+			FMath::FloorToInt(VolumeSize.X / BlockSize),
+			FMath::FloorToInt(VolumeSize.Y / BlockSize),
+			FMath::FloorToInt(VolumeSize.Z / BlockSize));
+
+		// Cells are on the odd blocks, with the blocks between them as walls
+		const FIntVector NumCells((NumBlocks.X - 1) / 2, (NumBlocks.Y - 1) / 2, (NumBlocks.Z - 1) / 2);
+
+		auto GetBlockIdx = [NumBlocks](const FIntVector& Block)
+		{
+			return (Block.Z * NumBlocks.Y + Block.Y) * NumBlocks.X + Block.X;
+		};
+
+		auto CellToBlock = [](const FIntVector& Cell)
+		{
+			return Cell * 2 + FIntVector(1);
+		};
+
+		TSharedRef<TBitArray<>> OpenBlocks = MakeShared<TBitArray<>>(false, NumBlocks.X * NumBlocks.Y * NumBlocks.Z);
+		TBitArray<> VisitedCells(false, NumCells.X * NumCells.Y * NumCells.Z);
+
+		auto GetCellIdx = [NumCells](const FIntVector& Cell)
+		{
+			return (Cell.Z * NumCells.Y + Cell.Y) * NumCells.X + Cell.X;
+		};
+
+		// Carve the maze with a depth first walk from the first cell
+		static const FIntVector Directions[] =
+		{
+			FIntVector(1, 0, 0), FIntVector(-1, 0, 0),
+			FIntVector(0, 1, 0), FIntVector(0, -1, 0),
+			FIntVector(0, 0, 1), FIntVector(0, 0, -1),
+		};
+
+		FRandomStream RandomStream(RandomSeed);
+		TArray<FIntVector> Stack;
+		Stack.Add(FIntVector::ZeroValue);
+		VisitedCells[0] = true;
+		(*OpenBlocks)[GetBlockIdx(CellToBlock(FIntVector::ZeroValue))] = true;
+
+		while (Stack.Num() > 0)
+		{
+			const FIntVector Cell = Stack.Last();
+
+			TArray<FIntVector, TInlineAllocator<6>> Unvisited;
+			for (const FIntVector& Direction : Directions)
+			{
+				const FIntVector Neighbor = Cell + Direction;
+				if (Neighbor.X >= 0 && Neighbor.Y >= 0 && Neighbor.Z >= 0 &&
+					Neighbor.X < NumCells.X && Neighbor.Y < NumCells.Y && Neighbor.Z < NumCells.Z &&
+					!VisitedCells[GetCellIdx(Neighbor)])
+				{
+					Unvisited.Add(Neighbor);
+				}
+			}
+
+			if (Unvisited.Num() == 0)
+			{
+				Stack.Pop(false);
+				continue;
+			}
+
+			const FIntVector Next = Unvisited[RandomStream.RandHelper(Unvisited.Num())];
+			VisitedCells[GetCellIdx(Next)] = true;
+
+			// Open the cell and the wall between it and the one we came from
+			(*OpenBlocks)[GetBlockIdx(CellToBlock(Next))] = true;
+			(*OpenBlocks)[GetBlockIdx(CellToBlock(Cell) + (Next - Cell))] = true;
+
+			Stack.Add(Next);
+		}
+
+		FScenario Scenario;
+		Scenario.Name = TEXT("MazeCaves");
+		Scenario.IsBlocked = [Origin = Volume.Min, BlockSize, NumBlocks, OpenBlocks, GetBlockIdx](const FVector& Location)
+		{
+			const FVector Offset = (Location - Origin) / BlockSize;
+			const FIntVector Block(FMath::FloorToInt(Offset.X), FMath::FloorToInt(Offset.Y), FMath::FloorToInt(Offset.Z));
+
+			// Everything around the maze is solid
+			if (Block.X < 0 || Block.Y < 0 || Block.Z < 0 || Block.X >= NumBlocks.X || Block.Y >= NumBlocks.Y || Block.Z >= NumBlocks.Z)
+			{
+				return true;
+			}
+
+			return !(*OpenBlocks)[GetBlockIdx(Block)];
+		};
+		Scenario.bFullyConnected = true;
+		return Scenario;
+	}
+
+	// Solid rock riddled with bubbles of different sizes. Some bubbles overlap and some
+	// don't, so the open space is split into many pockets, and paths between them fail.
+	FScenario MakeSwissCheese(const FBox& Volume)
+	{
+		const float Spacing = 384.f;
+		const float MinRadius = 160.f;
+		const float MaxRadius = 260.f;
+		const float MaxJitter = 64.f;
+
+		const FVector VolumeSize = Volume.GetSize();
+		const FIntVector NumCells(
+			FMath::CeilToInt(VolumeSize.X / Spacing),
+			FMath::CeilToInt(VolumeSize.Y / Spacing),
+			FMath::CeilToInt(VolumeSize.Z / Spacing));
+
+		// A bubble centered near the middle of each cell, as XYZ and radius
+		TSharedRef<TArray<FVector4>> Bubbles = MakeShared<TArray<FVector4>>();
+		Bubbles->Reserve(NumCells.X * NumCells.Y * NumCells.Z);
+
+		FRandomStream RandomStream(RandomSeed);
+		for (int32 Z = 0; Z < NumCells.Z; ++Z)
+		{
+			for (int32 Y = 0; Y < NumCells.Y; ++Y)
+			{
+				for (int32 X = 0; X < NumCells.X; ++X)
+				{
+					const FVector Center = Volume.Min + (FVector(X, Y, Z) + 0.5f) * Spacing + RandomStream.GetUnitVector() * (RandomStream.GetFraction() * MaxJitter);
+					Bubbles->Emplace(Center, RandomStream.FRandRange(MinRadius, MaxRadius));
+				}
+			}
+		}
+
+		FScenario Scenario;
+		Scenario.Name = TEXT("SwissCheese");
+		Scenario.IsBlocked = [Origin = Volume.Min, Spacing, NumCells, Bubbles](const FVector& Location)
+		{
+			const FVector Offset = (Location - Origin) / Spacing;
+			const FIntVector Cell(FMath::FloorToInt(Offset.X), FMath::FloorToInt(Offset.Y), FMath::FloorToInt(Offset.Z));
+
+			// Bubbles never reach further than the next cell over
+			for (int32 Z = FMath::Max(Cell.Z - 1, 0); Z <= FMath::Min(Cell.Z + 1, NumCells.Z - 1); ++Z)
+			{
+				for (int32 Y = FMath::Max(Cell.Y - 1, 0); Y <= FMath::Min(Cell.Y + 1, NumCells.Y - 1); ++Y)
+				{
+					for (int32 X = FMath::Max(Cell.X - 1, 0); X <= FMath::Min(Cell.X + 1, NumCells.X - 1); ++X)
+					{
+						const FVector4& Bubble = (*Bubbles)[(Z * NumCells.Y + Y) * NumCells.X + X];
+						if (FVector::DistSquared(Location, FVector(Bubble)) < FMath::Square(Bubble.W))
+						{
+							return false;
+						}
+					}
+				}
+			}
+
+			return true;
+		};
+		return Scenario;
+	}
+
+	// Builds the scenario's octree and measures generating it and querying it, then
+	// writes the report. Returns false if any of the results were wrong.
+	bool RunScenario(FAutomationTestBase& Test, TFunctionRef<FScenario(const FBox& Volume)> MakeScenario)
+	{
+		const AGunfire3DNavData* NavDataDefaults = GetDefault<AGunfire3DNavData>();
+		const FNavSvoGeneratorConfig Config(FVector::ZeroVector, NavDataDefaults);
+		const FBox Volume = GetVolumeBounds(Config);
+		const FScenario Scenario = MakeScenario(Volume);
+		const int32 NumTiles = NumTilesPerAxis.X * NumTilesPerAxis.Y * NumTilesPerAxis.Z;
+
+		FNavSvoBenchmarkReport Report;
+
+		// Generation. Tiles are built one after another on this thread, so the times
+		// aren't affected by whatever else the workers are doing.
+		FNavSvoTileGenerator TileGenerator(Config);
+		FNavSvoTileGenerationStats TileTotals;
+
+		TArray<FSvoTile> Tiles;
+		Tiles.Reserve(NumTiles);
+
+		Report.MeasureEach(TEXT("GenerateTile"), NumTiles, [&](int32 TileIdx)
+		{
+			const FIntVector TileCoord(
+				TileIdx % NumTilesPerAxis.X,
+				(TileIdx / NumTilesPerAxis.X) % NumTilesPerAxis.Y,
+				TileIdx / (NumTilesPerAxis.X * NumTilesPerAxis.Y));
+
+			FSvoTile& Tile = Tiles.Add_GetRef(FSvoTile(FSvoTile::CalcTileID(TileCoord), Config.GetTileLayerIndex(), TileCoord));
+			Tile.GetNodeInfo().SetNodeState(ENodeState::Open);
+
+			FNavSvoTileGenerationStats TileStats;
+			TileGenerator.BuildTileFromVoxels(TileCoord, Scenario.IsBlocked, Tile, TileStats);
+
+			TileTotals.FillCycles += TileStats.FillCycles;
+			TileTotals.PadCycles += TileStats.PadCycles;
+			TileTotals.NodeCycles += TileStats.NodeCycles;
+			TileTotals.ClearanceCycles += TileStats.ClearanceCycles;
+
+			// Tiles that are entirely open or blocked don't have any nodes to build
+			return Tile.GetNodeInfo().HasChildren();
+		});
+
+		Report.AddTotal(TEXT("GenerateTile.Fill"), NumTiles, NumTiles, FPlatformTime::ToMilliseconds64(TileTotals.FillCycles));
+		Report.AddTotal(TEXT("GenerateTile.Pad"), NumTiles, NumTiles, FPlatformTime::ToMilliseconds64(TileTotals.PadCycles));
+		Report.AddTotal(TEXT("GenerateTile.Nodes"), NumTiles, NumTiles, FPlatformTime::ToMilliseconds64(TileTotals.NodeCycles));
+		Report.AddTotal(TEXT("GenerateTile.Clearance"), NumTiles, NumTiles, FPlatformTime::ToMilliseconds64(TileTotals.ClearanceCycles));
+
+		FNavSvoGeneratorConfig OctreeConfig = Config;
+		OctreeConfig.SetTilePoolSize(NumTiles);
+
+		FEditableSvoSharedPtr Octree = MakeShareable(new FEditableSvo(OctreeConfig));
+		{
+			// Linking the tiles to each other happens once the batch edit ends
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+
+			Octree->BeginBatchEdit();
+			for (FSvoTile& Tile : Tiles)
+			{
+				Octree->AssumeTile(Tile, true);
+			}
+			Octree->EndBatchEdit();
+
+			Report.AddTotal(TEXT("AddTiles"), NumTiles, Octree->GetNumTiles(), FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+		}
+
+		if (!Test.TestEqual(TEXT("Tiles in the octree"), Octree->GetNumTiles(), NumTiles))
+		{
+			return false;
+		}
+
+		// Queries between random open locations, weighted by volume
+		TArray<FVector> Points;
+		TArray<FSvoNodeLink> PointLinks;
+		Points.Reserve(NumQueries * 2);
+		PointLinks.Reserve(NumQueries * 2);
+
+		for (int32 Attempt = 0; Attempt < NumQueries * 4 && Points.Num() < NumQueries * 2; ++Attempt)
+		{
+			FVector Location;
+			FSvoNodeLink Link;
+			if (Octree->GetRandomPoint(Location, Link))
+			{
+				Points.Add(Location);
+				PointLinks.Add(Link);
+			}
+		}
+
+		if (!Test.TestEqual(TEXT("Open locations found"), Points.Num(), NumQueries * 2))
+		{
+			return false;
+		}
+
+		FGunfire3DNavQueryFilter Filter;
+		TArray<TArray<FNavPathPoint>> Paths;
+		Paths.SetNum(NumQueries);
+
+		const FNavSvoBenchmarkMeasurement& FindPath = Report.MeasureEach(TEXT("FindPath"), NumQueries, [&](int32 QueryIdx)
+		{
+			FGunfire3DNavPathQueryResults Results;
+			FNavSvoPathQuery PathQuery(*Octree, MaxSearchNodes);
+			if (!PathQuery.FindPath(PointLinks[QueryIdx * 2], PointLinks[QueryIdx * 2 + 1], MAX_flt, Filter, Results) || Results.IsPartial())
+			{
+				return false;
+			}
+
+			// Keep the path to string pull later, built the same way the nav data does
+			TArray<FNavPathPoint>& PathPoints = Paths[QueryIdx];
+			PathPoints.Add(FNavPathPoint(Points[QueryIdx * 2], PointLinks[QueryIdx * 2].GetID()));
+			PathPoints.Append(Results.PathPortalPoints);
+			PathPoints.Add(FNavPathPoint(Points[QueryIdx * 2 + 1], PointLinks[QueryIdx * 2 + 1].GetID()));
+			return true;
+		});
+
+		const FNavSvoBenchmarkMeasurement& TestPath = Report.MeasureEach(TEXT("TestPath"), NumQueries, [&](int32 QueryIdx)
+		{
+			FGunfire3DNavPathQueryResults Results;
+			FNavSvoPathQuery PathQuery(*Octree, MaxSearchNodes);
+			return PathQuery.TestPath(PointLinks[QueryIdx * 2], PointLinks[QueryIdx * 2 + 1], MAX_flt, Filter, Results);
+		});
+
+		Report.MeasureEach(TEXT("StringPullPath"), NumQueries, [&](int32 QueryIdx)
+		{
+			TArray<FNavPathPoint>& PathPoints = Paths[QueryIdx];
+			if (PathPoints.Num() == 0)
+			{
+				return false;
+			}
+
+			FNavSvoUtils::StringPullPath(*Octree, PathPoints);
+			return true;
+		});
+
+		// Offset from open space, so some of the lookups start inside blocked space
+		const FVector NodeQueryExtent(500.f);
+		FRandomStream RandomStream(RandomSeed);
+
+		TArray<FVector> Origins;
+		Origins.Reserve(NumQueries);
+		for (int32 QueryIdx = 0; QueryIdx < NumQueries; ++QueryIdx)
+		{
+			Origins.Add(Points[QueryIdx] + RandomStream.GetUnitVector() * (RandomStream.GetFraction() * NodeQueryExtent.X));
+		}
+
+		Report.MeasureEach(TEXT("FindClosestNode"), NumQueries, [&](int32 QueryIdx)
+		{
+			FNavSvoNodeQuery NodeQuery(*Octree, MaxSearchNodes, NodeQueryExtent);
+			return NodeQuery.FindClosestNode(Origins[QueryIdx]).IsValid();
+		});
+
+		// Rays between the same pairs of locations as the paths
+		TArray<FVector> RayStarts;
+		TArray<FVector> RayEnds;
+		RayStarts.Reserve(NumQueries);
+		RayEnds.Reserve(NumQueries);
+		for (int32 QueryIdx = 0; QueryIdx < NumQueries; ++QueryIdx)
+		{
+			RayStarts.Add(Points[QueryIdx * 2]);
+			RayEnds.Add(Points[QueryIdx * 2 + 1]);
+		}
+
+		TArray<Gunfire3DNavigation::FRaycastResult> RaycastResults;
+		RaycastResults.SetNum(NumQueries);
+
+		const FNavSvoBenchmarkMeasurement& Raycast = Report.MeasureEach(TEXT("Raycast"), NumQueries, [&](int32 QueryIdx)
+		{
+			return Octree->Raycast(RayStarts[QueryIdx], RayEnds[QueryIdx], RaycastResults[QueryIdx]);
+		});
+
+		TArray<Gunfire3DNavigation::FRaycastResult> BatchResults;
+		BatchResults.SetNum(NumQueries);
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Octree->BatchRaycast(RayStarts, RayEnds, BatchResults);
+			const double BatchMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+			const int32 NumHits = Algo::CountIf(BatchResults, [](const Gunfire3DNavigation::FRaycastResult& Result) { return Result.HasHit(); });
+			Report.AddTotal(TEXT("BatchRaycast"), NumQueries, NumHits, BatchMs);
+		}
+
+		const FString Title = FString::Printf(TEXT("NavSvo synthetic benchmark %s: %d tiles, %d queries"), Scenario.Name, NumTiles, NumQueries);
+		Test.TestTrue(TEXT("Report written"), Report.Write(Title, FNavSvoBenchmarkReport::GetDefaultFilename(FString::Printf(TEXT("Synthetic%s"), Scenario.Name))));
+
+		// Make sure the queries being timed actually did their job
+		if (Scenario.bFullyConnected)
+		{
+			Test.TestEqual(TEXT("Paths found"), FindPath.NumSucceeded, NumQueries);
+			Test.TestEqual(TEXT("Paths tested"), TestPath.NumSucceeded, NumQueries);
+		}
+
+		if (Scenario.bEmpty)
+		{
+			Test.TestEqual(TEXT("Raycasts through open space that hit"), Raycast.NumSucceeded, 0);
+		}
+
+		int32 NumMismatches = 0;
+		for (int32 QueryIdx = 0; QueryIdx < NumQueries; ++QueryIdx)
+		{
+			const Gunfire3DNavigation::FRaycastResult& Result = RaycastResults[QueryIdx];
+			const Gunfire3DNavigation::FRaycastResult& BatchResult = BatchResults[QueryIdx];
+
+			if (Result.HasHit() != BatchResult.HasHit() ||
+				(Result.HasHit() && !Result.HitLocation.Location.Equals(BatchResult.HitLocation.Location, 1.f)))
+			{
+				++NumMismatches;
+			}
+		}
+
+		Test.TestEqual(TEXT("Batch raycasts that differ from single raycasts"), NumMismatches, 0);
+
+		return !Test.HasAnyErrors();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNavSvoBenchmarkOpenSpaceTest, "Gunfire3DNavigation.Benchmark.OpenSpace", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+bool FNavSvoBenchmarkOpenSpaceTest::RunTest(const FString& Parameters)
+{
+	return NavSvoBenchmarkTests::RunScenario(*this, &NavSvoBenchmarkTests::MakeOpenSpace);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNavSvoBenchmarkPillarsTest, "Gunfire3DNavigation.Benchmark.Pillars", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+bool FNavSvoBenchmarkPillarsTest::RunTest(const FString& Parameters)
+{
+	return NavSvoBenchmarkTests::RunScenario(*this, &NavSvoBenchmarkTests::MakePillars);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNavSvoBenchmarkMazeCavesTest, "Gunfire3DNavigation.Benchmark.MazeCaves", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+bool FNavSvoBenchmarkMazeCavesTest::RunTest(const FString& Parameters)
+{
+	return NavSvoBenchmarkTests::RunScenario(*this, &NavSvoBenchmarkTests::MakeMazeCaves);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNavSvoBenchmarkSwissCheeseTest, "Gunfire3DNavigation.Benchmark.SwissCheese", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+bool FNavSvoBenchmarkSwissCheeseTest::RunTest(const FString& Parameters)
+{
+	return NavSvoBenchmarkTests::RunScenario(*this, &NavSvoBenchmarkTests::MakeSwissCheese);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -3,6 +3,7 @@
 #include "NavSvoCollider.h"
 
 #include "Gunfire3DNavigationGeometryExport.h"
+#include "NavSvoGeometryCache.h"
 
 #include "DrawDebugHelpers.h"
 #include "NavigationSystem.h"
@@ -42,64 +43,43 @@ FNavigationOctreeCollider::~FNavigationOctreeCollider()
 
 bool FNavigationOctreeCollider::HasCollisionData() const
 {
-	return (CulledTriangles.Num() > 0 || Blockers.Num() > 0) || NavigationRelevantData.Num() > 0;;
+	return (CulledTriangles.Num() > 0 || CachedGeometry.Num() > 0 || Blockers.Num() > 0) || NavigationRelevantData.Num() > 0;;
 }
 
-void FNavigationOctreeCollider::ValidateAndAppendGeometry(TSharedRef<FNavigationRelevantData, ESPMode::ThreadSafe> ElementData, const FBox& Bounds)
+uint32 FNavigationOctreeCollider::GetNumTriangles() const
 {
-	const FNavigationRelevantData& DataRef = ElementData.Get();
-	if (DataRef.IsCollisionDataValid())
-	{
-		AppendGeometry(DataRef.CollisionData, Bounds, DataRef.NavDataPerInstanceTransformDelegate);
-	}
-}
-
-void FNavigationOctreeCollider::AppendGeometry(const TNavStatArray<uint8>& RawCollisionCache, const FBox& Bounds, const FNavDataPerInstanceTransformDelegate& InTransformsDelegate)
-{
-	if (RawCollisionCache.Num() == 0)
-	{
-		return;
-	}
-
-	FGeometryCache CollisionCache(RawCollisionCache.GetData());
+	uint32 NumTriangles = CulledTriangles.Num();
 
-	TArray<FTransform> PerInstanceTransform;
-
-	// Gather per instance transforms
-	if (InTransformsDelegate.IsBound())
+	for (const FNavSvoCachedGeometryRef& Geometry : CachedGeometry)
 	{
-		InTransformsDelegate.Execute(Bounds, PerInstanceTransform);
-		if (PerInstanceTransform.Num() == 0)
-		{
-			return;
-		}
+		NumTriangles += Geometry->Triangles.Num();
 	}
 
-	if (CollisionCache.Header.NumFaces == 0)
-	{
-		return;
-	}
+	return NumTriangles;
+}
 
+bool FNavigationOctreeCollider::IsTriangleOutOfBounds(const FTriangle& Tri, const FBox& Bounds)
+{
 	// We could do a more fancy separating axis test here to check that the triangle 100%
 	// doesn't overlap the bounds, but it's a lot slower than this simple "is this
 	// triangle fully outside one of the planes of this box" check, and this will exclude
 	// the bulk of the triangles we don't care about.
-	const auto IsOutOfBounds = [Bounds](const FNavigationOctreeCollider::FTriangle& Tri) -> bool
-	{
-		return
-			(FMath::Max3(Tri.Vertices[0].X, Tri.Vertices[1].X, Tri.Vertices[2].X) < Bounds.Min.X) ||
-			(FMath::Max3(Tri.Vertices[0].Y, Tri.Vertices[1].Y, Tri.Vertices[2].Y) < Bounds.Min.Y) ||
-			(FMath::Max3(Tri.Vertices[0].Z, Tri.Vertices[1].Z, Tri.Vertices[2].Z) < Bounds.Min.Z) ||
-			(FMath::Min3(Tri.Vertices[0].X, Tri.Vertices[1].X, Tri.Vertices[2].X) > Bounds.Max.X) ||
-			(FMath::Min3(Tri.Vertices[0].Y, Tri.Vertices[1].Y, Tri.Vertices[2].Y) > Bounds.Max.Y) ||
-			(FMath::Min3(Tri.Vertices[0].Z, Tri.Vertices[1].Z, Tri.Vertices[2].Z) > Bounds.Max.Z);
-	};
+	return
+		(FMath::Max3(Tri.Vertices[0].X, Tri.Vertices[1].X, Tri.Vertices[2].X) < Bounds.Min.X) ||
+		(FMath::Max3(Tri.Vertices[0].Y, Tri.Vertices[1].Y, Tri.Vertices[2].Y) < Bounds.Min.Y) ||
+		(FMath::Max3(Tri.Vertices[0].Z, Tri.Vertices[1].Z, Tri.Vertices[2].Z) < Bounds.Min.Z) ||
+		(FMath::Min3(Tri.Vertices[0].X, Tri.Vertices[1].X, Tri.Vertices[2].X) > Bounds.Max.X) ||
+		(FMath::Min3(Tri.Vertices[0].Y, Tri.Vertices[1].Y, Tri.Vertices[2].Y) > Bounds.Max.Y) ||
+		(FMath::Min3(Tri.Vertices[0].Z, Tri.Vertices[1].Z, Tri.Vertices[2].Z) > Bounds.Max.Z);
+}
 
+// Calls 'Func' with the vertices of each triangle in a collision cache, converted back to
+// Unreal coordinates.
+template<typename TFunc>
+static void ForEachCollisionTriangle(const FGeometryCache& CollisionCache, const TFunc& Func)
+{
 	FVector TriangleVertices[3];
 
-	bool bIsInstanced = (PerInstanceTransform.Num() > 0);
-	const int32 NumInstances = FMath::Max(1, PerInstanceTransform.Num());
-
 	const FVector::FReal* VertexCoords = CollisionCache.Verts;
 
 	for (int32 Face = 0; Face < CollisionCache.Header.NumFaces; ++Face)
@@ -130,6 +110,86 @@ void FNavigationOctreeCollider::AppendGeometry(const TNavStatArray<uint8>& RawCo
 		Swap(TriangleVertices[1], TriangleVertices[2]);
 #endif // WITH_RECAST
 
+		Func(TriangleVertices);
+	}
+}
+
+void FNavigationOctreeCollider::ExtractTriangles(const TNavStatArray<uint8>& RawCollisionCache, TArray<FTriangle>& OutTriangles)
+{
+	if (RawCollisionCache.Num() == 0)
+	{
+		return;
+	}
+
+	FGeometryCache CollisionCache(RawCollisionCache.GetData());
+	OutTriangles.Reserve(OutTriangles.Num() + CollisionCache.Header.NumFaces);
+
+	ForEachCollisionTriangle(CollisionCache, [&OutTriangles](const FVector (&TriangleVertices)[3])
+	{
+		FTriangle& Triangle = OutTriangles.AddUninitialized_GetRef();
+		Triangle.Vertices[0] = TriangleVertices[0];
+		Triangle.Vertices[1] = TriangleVertices[1];
+		Triangle.Vertices[2] = TriangleVertices[2];
+	});
+}
+
+void FNavigationOctreeCollider::ValidateAndAppendGeometry(TSharedRef<FNavigationRelevantData, ESPMode::ThreadSafe> ElementData, const FBox& Bounds, bool bCanCache)
+{
+	const FNavigationRelevantData& DataRef = ElementData.Get();
+	if (DataRef.IsCollisionDataValid())
+	{
+		// Instanced geometry depends on which instances overlap the bounds, so it always
+		// has to be extracted for the bounds.
+		if (bCanCache && !DataRef.NavDataPerInstanceTransformDelegate.IsBound() && FNavSvoGeometryCache::IsEnabled())
+		{
+			FNavSvoCachedGeometryRef Geometry = FNavSvoGeometryCache::Get().FindOrAdd(ElementData);
+
+			if (Geometry->Triangles.Num() > 0 && Geometry->Bounds.Intersect(Bounds))
+			{
+				CachedGeometry.Add(Geometry);
+				CachedGeometryBounds = Bounds;
+
+				TotalTriangles += Geometry->Triangles.Num();
+				UsedTriangles += Geometry->Triangles.Num();
+			}
+
+			return;
+		}
+
+		AppendGeometry(DataRef.CollisionData, Bounds, DataRef.NavDataPerInstanceTransformDelegate);
+	}
+}
+
+void FNavigationOctreeCollider::AppendGeometry(const TNavStatArray<uint8>& RawCollisionCache, const FBox& Bounds, const FNavDataPerInstanceTransformDelegate& InTransformsDelegate)
+{
+	if (RawCollisionCache.Num() == 0)
+	{
+		return;
+	}
+
+	FGeometryCache CollisionCache(RawCollisionCache.GetData());
+
+	TArray<FTransform> PerInstanceTransform;
+
+	// Gather per instance transforms
+	if (InTransformsDelegate.IsBound())
+	{
+		InTransformsDelegate.Execute(Bounds, PerInstanceTransform);
+		if (PerInstanceTransform.Num() == 0)
+		{
+			return;
+		}
+	}
+
+	if (CollisionCache.Header.NumFaces == 0)
+	{
+		return;
+	}
+
+	bool bIsInstanced = (PerInstanceTransform.Num() > 0);
+
+	ForEachCollisionTriangle(CollisionCache, [this, &Bounds, bIsInstanced, &PerInstanceTransform](const FVector (&TriangleVertices)[3])
+	{
 		// If this geometry is instanced, we need to apply the world transforms and add
 		// each triangle.  Otherwise we just add this triangle as-is.
 		if (bIsInstanced)
@@ -141,16 +201,12 @@ void FNavigationOctreeCollider::AppendGeometry(const TNavStatArray<uint8>& RawCo
 				Triangle.Vertices[1] = InstanceTransform.TransformPosition(TriangleVertices[1]);
 				Triangle.Vertices[2] = InstanceTransform.TransformPosition(TriangleVertices[2]);
 
-#if PROFILE_SVO_GENERATION
 				++TotalTriangles;
-#endif
-				if (!IsOutOfBounds(Triangle))
+				if (!IsTriangleOutOfBounds(Triangle, Bounds))
 				{
 					CulledTriangles.AddElement(Triangle);
 
-#if PROFILE_SVO_GENERATION
 					++UsedTriangles;
-#endif
 				}
 			}
 		}
@@ -161,19 +217,15 @@ void FNavigationOctreeCollider::AppendGeometry(const TNavStatArray<uint8>& RawCo
 			Triangle.Vertices[1] = TriangleVertices[1];
 			Triangle.Vertices[2] = TriangleVertices[2];
 
-#if PROFILE_SVO_GENERATION
 			++TotalTriangles;
-#endif
-			if (!IsOutOfBounds(Triangle))
+			if (!IsTriangleOutOfBounds(Triangle, Bounds))
 			{
 				CulledTriangles.AddElement(Triangle);
 
-#if PROFILE_SVO_GENERATION
 				++UsedTriangles;
-#endif
 			}
 		}
-	}
+	});
 }
 
 void FNavigationOctreeCollider::AppendModifier(const FCompositeNavModifier& Modifier, const FBox& Bounds, const FNavDataPerInstanceTransformDelegate& InTransformsDelegate)
@@ -198,10 +250,9 @@ void FNavigationOctreeCollider::AppendModifier(const FCompositeNavModifier& Modi
 
 	ModifierElement.Areas = Modifier.GetAreas();
 
-	// We cache off info about modifiers, but we don't currently support them as a way to
-	// tag areas of flying nav. We would like to support the case of treating them as
-	// essentially blocking geo though, so if their area flags are zero (don't generate
-	// nav here), extract out some relevant info.
+	// Modifiers tag the nodes they overlap with their area (see BuildAreas in the tile
+	// generator), but if their area flags are zero (don't generate nav here) we treat
+	// them as essentially blocking geo instead, so extract out some relevant info.
 	for (int32 AreaIdx = ModifierElement.Areas.Num() - 1; AreaIdx >= 0; --AreaIdx)
 	{
 		const FAreaNavModifier& Area = ModifierElement.Areas[AreaIdx];
@@ -282,7 +333,7 @@ void FNavigationOctreeCollider::GatherGeometry(UWorld* World, const FNavDataConf
 			const bool bExportGeometry = NavData->HasGeometry();
 			if (bExportGeometry)
 			{
-				ValidateAndAppendGeometry(NavData, Bounds);
+				ValidateAndAppendGeometry(NavData, Bounds, !bDumpGeometryData);
 
 				if (bDumpGeometryData)
 				{
@@ -313,6 +364,7 @@ void FNavigationOctreeCollider::GatherGeometrySources(UWorld* World, const FNavD
 	NavigationOctreeCached = NavigationOctreeInstance->AsShared();
 
 	NavigationRelevantData.Reset();
+	NumSourceTriangles = 0;
 
 	NavDataConfigCached = NavDataConfig;
 
@@ -326,7 +378,29 @@ void FNavigationOctreeCollider::GatherGeometrySources(UWorld* World, const FNavD
 
 				if (bExportGeometry || bExportModifiers)
 				{
-					NavigationRelevantData.Add(Element.Data);
+					const TNavigationData& NavData = Element.Data;
+
+					// Lazy gathering writes to the element's data and the navigation
+					// octree, so it has to happen here on the game thread rather than
+					// on the worker, where other jobs may be reading the same element.
+					// Geometry exported as slices is the exception, since each job
+					// exports its own slice.
+					const bool bGatherLazyGeometry = NavData->IsPendingLazyGeometryGathering() && !NavData->SupportsGatheringGeometrySlices();
+					if (bGatherLazyGeometry || NavData->IsPendingLazyModifiersGathering())
+					{
+						SCOPE_CYCLE_COUNTER(STAT_FNavigationOctreeCollider_GatherGeometry_LazyGeometryExport);
+						NavigationOctreeInstance->DemandLazyDataGathering(*NavData);
+					}
+
+					// Estimate how many triangles we'll gather, so the generator can still
+					// limit the number of triangles per job.
+					if (NavData->IsCollisionDataValid() && NavData->CollisionData.Num() > 0)
+					{
+						const FGeometryCache CollisionCache(NavData->CollisionData.GetData());
+						NumSourceTriangles += CollisionCache.Header.NumFaces;
+					}
+
+					NavigationRelevantData.Add(NavData);
 				}
 			}
 		});
@@ -344,8 +418,6 @@ void FNavigationOctreeCollider::GatherGeometryFromSources(const FBox& Bounds)
 			continue;
 		}
 
-		bool bDumpGeometryData = false;
-
 		if (NavData->IsPendingLazyGeometryGathering() && NavData->SupportsGatheringGeometrySlices())
 		{
 			SCOPE_CYCLE_COUNTER(STAT_FNavigationOctreeCollider_GatherGeometryFromSources_LandscapeSlicesExporting);
@@ -355,32 +427,24 @@ void FNavigationOctreeCollider::GatherGeometryFromSources(const FBox& Bounds)
 			{
 				NavRelevant->PrepareGeometryExportSync();
 
-				FGunfire3DNavigationGeometryExport GeomExport(*NavData);
+				// Other jobs may be exporting their own slices of the same element at
+				// the same time, so export into data of our own instead of the element's.
+				TNavigationData SliceData = MakeShared<FNavigationRelevantData, ESPMode::ThreadSafe>(*NavData->GetOwner());
+
+				FGunfire3DNavigationGeometryExport GeomExport(*SliceData);
 				NavRelevant->GatherGeometrySlice(GeomExport, Bounds);
 				GeomExport.StoreCollisionCache();
 
-				bDumpGeometryData = true;
+				ValidateAndAppendGeometry(SliceData, Bounds, false);
 			}
 			else
 			{
 				UE_LOG(LogNavigation, Error, TEXT("GatherGeometry: got an invalid NavRelevant instance!"));
 			}
 		}
-
-		if (NavData->IsPendingLazyGeometryGathering() || NavData->IsPendingLazyModifiersGathering())
-		{
-			NavigationOctreeCached->DemandLazyDataGathering(*NavData);
-		}
-
-		const bool bExportGeometry = NavData->HasGeometry();
-		if (bExportGeometry)
+		else if (NavData->HasGeometry())
 		{
-			ValidateAndAppendGeometry(NavData, Bounds);
-
-			if (bDumpGeometryData)
-			{
-				const_cast<FNavigationRelevantData&>(*NavData).CollisionData.Empty();
-			}
+			ValidateAndAppendGeometry(NavData, Bounds, true);
 		}
 
 		const FCompositeNavModifier ModifierInstance = NavData->Modifiers.HasMetaAreas() ? NavData->Modifiers.GetInstantiatedMetaModifier(&NavDataConfigCached, NavData->SourceObject) : NavData->Modifiers;
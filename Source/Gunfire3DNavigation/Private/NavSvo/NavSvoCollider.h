@@ -7,6 +7,9 @@
 
 #include "AI/NavigationModifier.h"
 
+struct FNavSvoCachedGeometry;
+typedef TSharedRef<const FNavSvoCachedGeometry, ESPMode::ThreadSafe> FNavSvoCachedGeometryRef;
+
 // Collision interface that test against the nav octree
 struct FNavigationOctreeCollider
 {
@@ -28,15 +31,23 @@ struct FNavigationOctreeCollider
 	};
 	TChunkedArray<FTriangle> CulledTriangles;
 
+	// Geometry referenced from the geometry cache instead of being copied into
+	// CulledTriangles (see FNavSvoGeometryCache). Its triangles aren't culled up front, so
+	// they're culled against the bounds we gathered for as they're visited.
+	TStatArray<FNavSvoCachedGeometryRef> CachedGeometry;
+	FBox CachedGeometryBounds = FBox(ForceInit);
+
 	TStatArray<TNavigationData> NavigationRelevantData;
 
+	// Number of triangles in the collision data of NavigationRelevantData, before culling
+	uint32 NumSourceTriangles = 0;
+
 	FNavDataConfig NavDataConfigCached;
 	TSharedPtr<class FNavigationOctree, ESPMode::ThreadSafe> NavigationOctreeCached = nullptr;
 
-#if PROFILE_SVO_GENERATION
+	// Triangles gathered, and how many of them were left after culling to the bounds
 	uint32 TotalTriangles = 0;
 	uint32 UsedTriangles = 0;
-#endif
 
 public:
 	FNavigationOctreeCollider();
@@ -45,13 +56,29 @@ public:
 	// Returns whether any data exists for collision tests.
 	bool HasCollisionData() const;
 
+	// Calls 'Func' with every triangle that was gathered
+	template<typename TFunc>
+	void ForEachTriangle(const TFunc& Func) const;
+
+	// Returns the number of triangles gathered. Cached geometry is counted in full, even
+	// though some of its triangles will be culled.
+	uint32 GetNumTriangles() const;
+
+	// Quick test for whether a triangle is fully outside one of the planes of the bounds
+	static bool IsTriangleOutOfBounds(const FTriangle& Tri, const FBox& Bounds);
+
+	// Extracts all the triangles from a raw collision cache, in world space
+	static void ExtractTriangles(const TNavStatArray<uint8>& RawCollisionCache, TArray<FTriangle>& OutTriangles);
+
 protected:
 	//////////////////////////////////////////////////////////////////////////////////////
 	//
 	// The following functions are taken directly from RecastNavMeshGenerator.cpp with
 	// some modifications
 	//
-	void ValidateAndAppendGeometry(TSharedRef<FNavigationRelevantData, ESPMode::ThreadSafe> ElementData, const FBox& Bounds);
+	// If 'bCanCache' is set the geometry may be taken from the geometry cache, which is
+	// only valid if the collision data will stay around after this.
+	void ValidateAndAppendGeometry(TSharedRef<FNavigationRelevantData, ESPMode::ThreadSafe> ElementData, const FBox& Bounds, bool bCanCache);
 	void AppendGeometry(const TNavStatArray<uint8>& RawCollisionCache, const FBox& Bounds, const FNavDataPerInstanceTransformDelegate& InTransformsDelegate);
 	void AppendModifier(const FCompositeNavModifier& Modifier, const FBox& Bounds, const FNavDataPerInstanceTransformDelegate& InTransformsDelegate);
 
@@ -62,12 +89,45 @@ public:
 
 	// Used for async gathering. Call GatherGeometrySources on the main thread to cache
 	// off the sources, then GatherGeometryFromSources on the worker thread to process
-	// the sources.
+	// the sources. Any number of workers can gather from sources at once, since anything
+	// that writes to shared data is done while caching the sources.
 	void GatherGeometrySources(UWorld* World, const FNavDataConfig& NavDataConfig, const FBox& Bounds);
 	void GatherGeometryFromSources(const FBox& Bounds);
 
 public:
-	// A helper for generating the Blockers array. If we remove that and support areas
-	// fully we may not need this anymore.
+	// The areas of the nav data, for generating the Blockers array and resolving the
+	// areas of the remaining modifiers.
 	TArray<TWeakObjectPtr<UClass>> SupportedAreas;
+
+	// The ID of each of the supported areas
+	TArray<int32> SupportedAreaIDs;
 };
+
+// Triangles extracted from the collision data of a navigation relevant element
+struct FNavSvoCachedGeometry
+{
+	TArray<FNavigationOctreeCollider::FTriangle> Triangles;
+	FBox Bounds = FBox(ForceInit);
+
+	uint32 GetMemUsed() const { return sizeof(*this) + Triangles.GetAllocatedSize(); }
+};
+
+template<typename TFunc>
+void FNavigationOctreeCollider::ForEachTriangle(const TFunc& Func) const
+{
+	for (const FTriangle& Tri : CulledTriangles)
+	{
+		Func(Tri);
+	}
+
+	for (const FNavSvoCachedGeometryRef& Geometry : CachedGeometry)
+	{
+		for (const FTriangle& Tri : Geometry->Triangles)
+		{
+			if (!IsTriangleOutOfBounds(Tri, CachedGeometryBounds))
+			{
+				Func(Tri);
+			}
+		}
+	}
+}
@@ -3,6 +3,7 @@
 #include "NavSvoDebugActor.h"
 
 #include "Gunfire3DNavData.h"
+#include "NavSvoQueryHeatmap.h"
 #include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
 
 #include "DrawDebugHelpers.h"
@@ -26,6 +27,10 @@ static const FColor kVisitedNodeColor = FColor::Cyan;
 static const FColor kBlockedNodeColor = FColor::Red;
 static const FColor kErrorNodeColor = FColor::Magenta;
 
+// Heatmap Colors
+static const FLinearColor kHeatmapColdColor = FLinearColor::Blue;
+static const FLinearColor kHeatmapHotColor = FLinearColor::Red;
+
 // Layer Colors
 static const FColor kLayerColors[] =
 {
@@ -199,6 +204,10 @@ void ANavSvoDebugActor::RebuildPath()
 	FGunfire3DNavQueryFilter* NavFilterImpl = static_cast<FGunfire3DNavQueryFilter*>(NavQueryFilter->GetImplementation());
 	NavFilterImpl->SetHeuristicScale(PathHeuristicScale);
 	NavFilterImpl->SetBaseTraversalCost(NodeBaseTraversalCost);
+	NavFilterImpl->SetBidirectionalSearch(bBidirectionalPathSearch);
+	NavFilterImpl->SetLandmarkHeuristic(bLandmarkPathHeuristic);
+	NavFilterImpl->SetCoarseSearchLayer(CoarseSearchLayer);
+	NavFilterImpl->SetOpenListType(OpenListType);
 	NavFilterImpl->OnNodeVisited = [this](NavNodeRef NavNode) -> bool
 	{
 		PathSearchNodes.Add(NavNode);
@@ -280,6 +289,8 @@ void ANavSvoDebugActor::Tick(float DeltaSeconds)
 {
 	UWorld* World = GetWorld();
 
+	UpdateQueryHeatmapUser();
+
 	if (NavData == nullptr)
 	{
 		return;
@@ -304,6 +315,39 @@ void ANavSvoDebugActor::Tick(float DeltaSeconds)
 	{
 		DrawNeighbors(World);
 	}
+
+	if (bDrawQueryHeatmap)
+	{
+		DrawQueryHeatmap(World);
+	}
+}
+
+void ANavSvoDebugActor::BeginDestroy()
+{
+	if (bIsQueryHeatmapUser)
+	{
+		FNavSvoQueryHeatmap::RemoveUser();
+		bIsQueryHeatmapUser = false;
+	}
+
+	Super::BeginDestroy();
+}
+
+void ANavSvoDebugActor::UpdateQueryHeatmapUser()
+{
+	if (bDrawQueryHeatmap != bIsQueryHeatmapUser)
+	{
+		if (bDrawQueryHeatmap)
+		{
+			FNavSvoQueryHeatmap::AddUser();
+		}
+		else
+		{
+			FNavSvoQueryHeatmap::RemoveUser();
+		}
+
+		bIsQueryHeatmapUser = bDrawQueryHeatmap;
+	}
 }
 
 void ANavSvoDebugActor::DrawPath(UWorld* World) const
@@ -519,3 +563,72 @@ void ANavSvoDebugActor::DrawNeighbors(UWorld* World) const
 	}
 #endif
 }
+
+void ANavSvoDebugActor::DrawQueryHeatmap(UWorld* World) const
+{
+#if !UE_BUILD_SHIPPING
+	const FEditableSvo* Octree = NavData->GetOctree();
+	if (Octree == nullptr)
+	{
+		return;
+	}
+
+	auto GetCount = [this](const FNavSvoQueryHeatmap::FHeat& Heat)
+	{
+		return (QueryHeatmapMetric == ENavSvoQueryHeatmapMetric::Opened) ? Heat.NumOpened : Heat.NumVisited;
+	};
+
+	// Colors are relative to the hottest entry, so hot spots stand out however busy the
+	// searches are overall.
+	auto GetHeatColor = [](uint32 Count, uint32 MaxCount)
+	{
+		const float Heat = (MaxCount > 0) ? ((float)Count / (float)MaxCount) : 0.f;
+		return FLinearColor::LerpUsingHSV(kHeatmapColdColor, kHeatmapHotColor, Heat).ToFColor(true);
+	};
+
+	TMap<uint32, FNavSvoQueryHeatmap::FHeat> TileHeat;
+	FNavSvoQueryHeatmap::GetTileHeat(*Octree, TileHeat);
+
+	uint32 MaxTileCount = 0;
+	for (const TPair<uint32, FNavSvoQueryHeatmap::FHeat>& CurTileHeat : TileHeat)
+	{
+		MaxTileCount = FMath::Max(MaxTileCount, GetCount(CurTileHeat.Value));
+	}
+
+	for (const TPair<uint32, FNavSvoQueryHeatmap::FHeat>& CurTileHeat : TileHeat)
+	{
+		const uint32 Count = GetCount(CurTileHeat.Value);
+		const FSvoTile* Tile = Octree->GetTile(CurTileHeat.Key);
+		if (Count == 0 || Tile == nullptr)
+		{
+			continue;
+		}
+
+		const FBox TileBounds = Octree->GetBoundsForNode(Tile->GetNodeInfo());
+		DrawDebugBox(World, TileBounds.GetCenter(), TileBounds.GetExtent(), FQuat::Identity, GetHeatColor(Count, MaxTileCount), false, -1.f, 0, 3.f);
+	}
+
+	if (bDrawQueryHeatmapNodes)
+	{
+		TArray<TPair<uint64, FNavSvoQueryHeatmap::FHeat>> NodeHeat;
+		FNavSvoQueryHeatmap::GetHottestNodes(*Octree, MaxQueryHeatmapNodes, NodeHeat);
+
+		uint32 MaxNodeCount = 0;
+		for (const TPair<uint64, FNavSvoQueryHeatmap::FHeat>& CurNodeHeat : NodeHeat)
+		{
+			MaxNodeCount = FMath::Max(MaxNodeCount, GetCount(CurNodeHeat.Value));
+		}
+
+		FBox NodeBounds(ForceInit);
+
+		for (const TPair<uint64, FNavSvoQueryHeatmap::FHeat>& CurNodeHeat : NodeHeat)
+		{
+			const uint32 Count = GetCount(CurNodeHeat.Value);
+			if (Count > 0 && Octree->GetBoundsForLink(FSvoNodeLink(CurNodeHeat.Key), NodeBounds))
+			{
+				DrawDebugBox(World, NodeBounds.GetCenter(), NodeBounds.GetExtent(), FQuat::Identity, GetHeatColor(Count, MaxNodeCount));
+			}
+		}
+	}
+#endif
+}
@@ -8,6 +8,16 @@
 
 class UBillboardComponent;
 
+UENUM()
+enum class ENavSvoQueryHeatmapMetric : uint8
+{
+	// How many times nodes had their neighbors opened
+	Visited,
+
+	// How many times nodes were opened
+	Opened,
+};
+
 UCLASS(hidecategories = (Input, Rendering, Tags, Actor, Layers, Replication), meta = (DisplayName = "3D Navigation Debug Actor"))
 class ANavSvoDebugActor : public AActor
 {
@@ -41,6 +51,23 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Path")
 	float NodeBaseTraversalCost = NAVDATA_DEFAULT_BASE_TRAVERSAL_COST;
 
+	// Searches from both the start and the goal at once, meeting in the middle.
+	UPROPERTY(EditAnywhere, Category = "Path")
+	bool bBidirectionalPathSearch = false;
+
+	// Guides the search with distances to landmarks as well as to the goal
+	UPROPERTY(EditAnywhere, Category = "Path", AdvancedDisplay)
+	bool bLandmarkPathHeuristic = false;
+
+	// Treats cluttered space on this layer or below as blocked, away from the endpoints.
+	// -1 searches at full detail.
+	UPROPERTY(EditAnywhere, Category = "Path", AdvancedDisplay, meta = (ClampMin = "-1"))
+	int32 CoarseSearchLayer = INDEX_NONE;
+
+	// The priority queue used to order nodes while searching
+	UPROPERTY(EditAnywhere, Category = "Path", AdvancedDisplay)
+	EGunfire3DNavOpenListType OpenListType = EGunfire3DNavOpenListType::BinaryHeap;
+
 	// If greater than zero, determines the maximum traversal cost allowed for a path.
 	UPROPERTY(EditAnywhere, Category = "Path")
 	float PathCostLimit = 0.f;
@@ -172,6 +199,25 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Octree|Drawing")
 	bool bDrawNeighbors = false;
 
+	// If true, the tiles are drawn colored by how much work the searches run by gameplay
+	// have done in them recently, from blue for the least to red for the most. Searches
+	// are only collected while something is drawing the heatmap or NavSvo.QueryHeatmap
+	// is set, and NavSvo.QueryHeatmapWindow sets how many seconds they're kept for.
+	UPROPERTY(EditAnywhere, Category = "Query Heatmap|Drawing")
+	bool bDrawQueryHeatmap = false;
+
+	// Which count the heatmap is colored by
+	UPROPERTY(EditAnywhere, Category = "Query Heatmap|Drawing", meta = (EditCondition = bDrawQueryHeatmap))
+	ENavSvoQueryHeatmapMetric QueryHeatmapMetric = ENavSvoQueryHeatmapMetric::Visited;
+
+	// If true, the most visited nodes are also drawn, colored the same way as the tiles
+	UPROPERTY(EditAnywhere, Category = "Query Heatmap|Drawing", meta = (EditCondition = bDrawQueryHeatmap))
+	bool bDrawQueryHeatmapNodes = false;
+
+	// The number of nodes to draw when 'Draw Query Heatmap Nodes' is true
+	UPROPERTY(EditAnywhere, Category = "Query Heatmap|Drawing", meta = (EditCondition = bDrawQueryHeatmapNodes, ClampMin = "1"))
+	int32 MaxQueryHeatmapNodes = 256;
+
 	UPROPERTY(VisibleAnywhere, Category = "Test Locations")
 	TObjectPtr<USceneComponent> StartPosition = nullptr;
 
@@ -183,6 +229,7 @@ public:
 
 	virtual void PostRegisterAllComponents() override;
 	virtual void Tick(float DeltaSeconds) override;
+	virtual void BeginDestroy() override;
 
 #if WITH_EDITOR
 	virtual void PostEditMove(bool bFinished) override;
@@ -212,6 +259,10 @@ private:
 	void DrawPathSearch(UWorld* World, float DeltaSeconds);
 	void DrawRaycast(UWorld* World, float DeltaSeconds);
 	void DrawNeighbors(UWorld* World) const;
+	void DrawQueryHeatmap(UWorld* World) const;
+
+	// Starts or stops collecting the query heatmap as drawing it is toggled
+	void UpdateQueryHeatmapUser();
 
 private:
 	UPROPERTY()
@@ -230,4 +281,7 @@ private:
 
 	TArray<NavNodeRef> PathSearchNodes;
 	float PathSearchNodeTimer = 0.f;
+
+	// Whether this actor is counted as a user of the query heatmap
+	bool bIsQueryHeatmapUser = false;
 };
\ No newline at end of file
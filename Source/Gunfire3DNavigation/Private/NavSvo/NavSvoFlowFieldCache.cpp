@@ -0,0 +1,97 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoFlowFieldCache.h"
+
+#include "Gunfire3DNavigationUtils.h"
+#include "SparseVoxelOctree/SparseVoxelOctree.h"
+
+///> Profiling stats
+DECLARE_CYCLE_STAT(TEXT("Find (FlowFieldCache)"), STAT_FlowFieldCache_Find, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Add (FlowFieldCache)"), STAT_FlowFieldCache_Add, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Flow Field Cache Hits"), STAT_FlowFieldCache_Hits, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Flow Field Cache Misses"), STAT_FlowFieldCache_Misses, STATGROUP_Gunfire3DNavigation);
+
+FNavSvoFlowFieldCache::FNavSvoFlowFieldCache(int32 InMaxEntries)
+	: Cache(FMath::Max(1, InMaxEntries))
+	, MaxEntries(FMath::Max(1, InMaxEntries))
+{
+}
+
+FGunfire3DNavFlowFieldPtr FNavSvoFlowFieldCache::Find(const FNavSvoFlowFieldCacheKey& Key, const FSparseVoxelOctree& Octree)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldCache_Find);
+
+	FScopeLock ScopeLock(&CacheLock);
+
+	const FEntry* Entry = Cache.FindAndTouch(Key);
+	if (Entry == nullptr)
+	{
+		INC_DWORD_STAT(STAT_FlowFieldCache_Misses);
+		return nullptr;
+	}
+
+	// Throw out fields over tiles that have changed since the field was built
+	if (!Entry->TileVersions.IsCurrent(Octree))
+	{
+		Cache.Remove(Key);
+		INC_DWORD_STAT(STAT_FlowFieldCache_Misses);
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_FlowFieldCache_Hits);
+	return Entry->FlowField;
+}
+
+void FNavSvoFlowFieldCache::Add(const FNavSvoFlowFieldCacheKey& Key, const FSparseVoxelOctree& Octree, FGunfire3DNavFlowFieldPtr FlowField)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldCache_Add);
+
+	if (!FlowField.IsValid())
+	{
+		return;
+	}
+
+	TArray<uint32, TInlineAllocator<64>> TileIDs;
+	for (const TPair<NavNodeRef, FGunfire3DNavFlowField::FStep>& StepPair : FlowField->GetSteps())
+	{
+		TileIDs.AddUnique(FSvoNodeLink(StepPair.Key).TileID);
+	}
+
+	FEntry Entry;
+	Entry.FlowField = FlowField;
+
+	// Don't cache fields over tiles we can't track
+	if (!Entry.TileVersions.Capture(Octree, TileIDs))
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&CacheLock);
+	Cache.Add(Key, MoveTemp(Entry));
+}
+
+void FNavSvoFlowFieldCache::Empty()
+{
+	FScopeLock ScopeLock(&CacheLock);
+	Cache.Empty(MaxEntries);
+}
+
+int32 FNavSvoFlowFieldCache::Num() const
+{
+	FScopeLock ScopeLock(&CacheLock);
+	return Cache.Num();
+}
+
+uint32 FNavSvoFlowFieldCache::GetMemUsed() const
+{
+	FScopeLock ScopeLock(&CacheLock);
+
+	uint32 MemUsed = sizeof(*this);
+	for (auto It = Cache.CreateConstIterator(); It; ++It)
+	{
+		const FEntry& Entry = It.Value();
+		MemUsed += sizeof(FEntry) + Entry.FlowField->GetMemUsed() + Entry.TileVersions.GetAllocatedSize();
+	}
+
+	return MemUsed;
+}
@@ -0,0 +1,66 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Gunfire3DNavPath.h"
+#include "NavSvoPathCache.h"
+
+struct FNavSvoFlowFieldCacheKey
+{
+	FSvoNodeLink GoalNodeLink = SVO_INVALID_NODELINK;
+
+	// Hash of the filter used for the query (see FGunfire3DNavQueryFilter::GetHash)
+	uint32 FilterHash = 0;
+
+	float CostLimit = 0.f;
+
+	bool operator==(const FNavSvoFlowFieldCacheKey& Other) const
+	{
+		return GoalNodeLink == Other.GoalNodeLink &&
+			FilterHash == Other.FilterHash &&
+			CostLimit == Other.CostLimit;
+	}
+
+	friend uint32 GetTypeHash(const FNavSvoFlowFieldCacheKey& Key)
+	{
+		uint32 Hash = HashCombine(GetTypeHash(Key.GoalNodeLink), Key.FilterHash);
+		Hash = HashCombine(Hash, GetTypeHash(Key.CostLimit));
+		return Hash;
+	}
+};
+
+//
+// LRU cache of flow fields by goal. Like the path cache, each field remembers the version
+// of every tile it covers and is thrown out once any of them change.
+//
+// NOTE: Thread-safe, since fields may be built on background threads.
+//
+class FNavSvoFlowFieldCache
+{
+public:
+	FNavSvoFlowFieldCache(int32 InMaxEntries);
+
+	// Returns the cached field for the key if there is one that's still valid
+	FGunfire3DNavFlowFieldPtr Find(const FNavSvoFlowFieldCacheKey& Key, const FSparseVoxelOctree& Octree);
+
+	// Stores a finished field, tracking the tiles of every node it covers
+	void Add(const FNavSvoFlowFieldCacheKey& Key, const FSparseVoxelOctree& Octree, FGunfire3DNavFlowFieldPtr FlowField);
+
+	// Removes all cached fields
+	void Empty();
+
+	int32 Num() const;
+
+	uint32 GetMemUsed() const;
+
+private:
+	struct FEntry
+	{
+		FGunfire3DNavFlowFieldPtr FlowField;
+		FNavSvoTileVersions TileVersions;
+	};
+
+	mutable FCriticalSection CacheLock;
+	TLruCache<FNavSvoFlowFieldCacheKey, FEntry> Cache;
+	const int32 MaxEntries;
+};
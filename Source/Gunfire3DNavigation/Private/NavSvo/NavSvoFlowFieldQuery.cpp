@@ -0,0 +1,72 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoFlowFieldQuery.h"
+
+#include "SparseVoxelOctree/SparseVoxelOctree.h"
+
+DECLARE_CYCLE_STAT(TEXT("BuildFlowField (Query)"), STAT_BuildFlowField_Query, STATGROUP_Gunfire3DNavigation);
+
+FNavSvoFlowFieldQuery::FNavSvoFlowFieldQuery(const FSparseVoxelOctree& InOctree, int32 MaxSearchNodes)
+	: Super(InOctree, MaxSearchNodes)
+{}
+
+bool FNavSvoFlowFieldQuery::BuildFlowField(FSvoNodeLink InGoalNodeLink, const FVector& InGoalLocation, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults, FGunfire3DNavFlowField& OutFlowField)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BuildFlowField_Query);
+
+	ResetForNewQuery();
+
+	CostLimit = InCostLimit;
+
+	// With no heuristic the search runs until it's exhausted, so every node that is
+	// closed has its cheapest route back to the goal.
+	if (!SearchNodes(InGoalNodeLink, InFilter, InOutResults))
+	{
+		return false;
+	}
+
+	OutFlowField.GoalNodeRef = InGoalNodeLink.GetID();
+	OutFlowField.GoalLocation = InGoalLocation;
+	OutFlowField.bTruncated = (InOutResults.Status & (uint8)EGunfire3DNavQueryFlags::OutOfNodes) != 0;
+	OutFlowField.Steps.Reset();
+	OutFlowField.Steps.Reserve(NodePool.GetNodeCount());
+
+	for (uint32 NodeIdx = 1; NodeIdx <= NodePool.GetNodeCount(); ++NodeIdx)
+	{
+		const FNavSvoNode* SearchNode = NodePool.GetNodeAtIndex(NodeIdx);
+		if ((SearchNode->Flags & NAVSVONODE_CLOSED) == 0)
+		{
+			// Nodes still on the open list may not have their cheapest route yet
+			continue;
+		}
+
+		// A node's portal location lies on the face it shares with its parent, which is
+		// exactly where to move through to get closer to the goal.
+		const FNavSvoNode* ParentSearchNode = NodePool.GetNodeAtIndex(NodePool.GetParentIdx(*SearchNode));
+
+		FGunfire3DNavFlowField::FStep& Step = OutFlowField.Steps.Add(SearchNode->NodeLink.GetID());
+		Step.NextNodeRef = ParentSearchNode ? ParentSearchNode->NodeLink.GetID() : OutFlowField.GoalNodeRef;
+		Step.PortalLocation = ParentSearchNode ? NodePool.GetPortalLocation(*SearchNode) : InGoalLocation;
+		Step.Cost = SearchNode->GCost;
+	}
+
+	return true;
+}
+
+void FNavSvoFlowFieldQuery::ResetForNewQuery()
+{
+	Super::ResetForNewQuery();
+
+	CostLimit = 0.f;
+}
+
+bool FNavSvoFlowFieldQuery::CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd)
+{
+	// Ensure we aren't exceeding the maximum cost limit
+	if (CostLimit > 0.f && NeighborCost > CostLimit)
+	{
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,36 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Gunfire3DNavPath.h"
+#include "NavSvoQuery.h"
+
+//
+// Dijkstra search outward from a goal which records the next hop toward the goal for
+// every node it visits. Neighbor links are symmetric, so following a node's parent in
+// this search is the same as moving from the node toward the goal.
+//
+class FNavSvoFlowFieldQuery : public TNavSvoQuery<FNavSvoFlowFieldQuery>
+{
+	typedef TNavSvoQuery<FNavSvoFlowFieldQuery> Super;
+	friend class TNavSvoQuery<FNavSvoFlowFieldQuery>;
+
+public:
+	FNavSvoFlowFieldQuery(const class FSparseVoxelOctree& InOctree, int32 MaxSearchNodes);
+
+	// Searches from the goal until every node within the cost limit (if > 0) has been
+	// visited, or the node pool runs out, and fills the field with the results.
+	bool BuildFlowField(FSvoNodeLink InGoalNodeLink, const FVector& InGoalLocation, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults, FGunfire3DNavFlowField& OutFlowField);
+
+private:
+	//~ Begin TNavSvoQuery
+	virtual void ResetForNewQuery() override;
+	FSvoNodeLink GetGoal() const { return StartNodeLink; }
+	ENavSvoQueryTieBreaker GetCostTieBreaker() const { return ENavSvoQueryTieBreaker::Nearest; }
+	float GetHeuristic(FSvoNodeLink FromLink) const { return 0.f; }
+	bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd);
+	//~ End TNavSvoQuery
+
+private:
+	float CostLimit = 0.f;
+};
@@ -0,0 +1,81 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoGenerationArena.h"
+
+namespace
+{
+	thread_local FNavSvoGenerationArena ThreadArena;
+
+	// Memory used by all the arenas, for budgeting
+	std::atomic<uint64> TotalMemUsed(0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoVoxelBuffer
+//////////////////////////////////////////////////////////////////////////
+
+void FNavSvoVoxelBuffer::Reset(uint32 NumLeaves)
+{
+	if ((uint32)Leaves.Num() != NumLeaves)
+	{
+		// The grid changed size, so the dirty range doesn't mean anything any more
+		Leaves.SetNumUninitialized(NumLeaves, false);
+		FMemory::Memzero(Leaves.GetData(), NumLeaves * sizeof(uint64));
+	}
+	else if (DirtyBegin < DirtyEnd)
+	{
+		FMemory::Memzero(Leaves.GetData() + DirtyBegin, (DirtyEnd - DirtyBegin) * sizeof(uint64));
+	}
+
+	DirtyBegin = MAX_uint32;
+	DirtyEnd = 0;
+}
+
+void FNavSvoVoxelBuffer::Empty()
+{
+	Leaves.Empty();
+	DirtyBegin = MAX_uint32;
+	DirtyEnd = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoGenerationArena
+//////////////////////////////////////////////////////////////////////////
+
+FNavSvoGenerationArena::~FNavSvoGenerationArena()
+{
+	TotalMemUsed -= TrackedMemUsed;
+}
+
+FNavSvoGenerationArena& FNavSvoGenerationArena::Get()
+{
+	return ThreadArena;
+}
+
+uint64 FNavSvoGenerationArena::GetTotalMemUsed()
+{
+	return TotalMemUsed;
+}
+
+void FNavSvoGenerationArena::UpdateTotalMemUsed()
+{
+	const uint32 MemUsed = GetMemUsed();
+	if (MemUsed != TrackedMemUsed)
+	{
+		TotalMemUsed += MemUsed;
+		TotalMemUsed -= TrackedMemUsed;
+		TrackedMemUsed = MemUsed;
+	}
+}
+
+uint32 FNavSvoGenerationArena::GetMemUsed() const
+{
+	return Voxels.GetMemUsed() +
+		PaddedVoxels.GetMemUsed() +
+		PadLeaves[0].GetAllocatedSize() +
+		PadLeaves[1].GetAllocatedSize() +
+		Distances.GetAllocatedSize() +
+		TileLeaves.GetAllocatedSize() +
+		NodeStates.GetAllocatedSize() +
+		LeafAreas.GetAllocatedSize();
+}
@@ -0,0 +1,134 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctree/SparseVoxelOctreeNode.h"
+
+//
+// Voxels of a tile being generated, stored as one 64-bit word per leaf (4x4x4 voxels)
+// in Morton order. That's the same order voxel codes use, so bit (VoxelCode & 63) of
+// leaf (VoxelCode >> 6) is the voxel.
+//
+// The range of leaves written since the last reset is tracked, so clearing the buffer to
+// reuse it for another tile only touches the leaves that were actually used.
+//
+class FNavSvoVoxelBuffer
+{
+public:
+	// Sizes the buffer for the given number of leaves, with every voxel clear
+	void Reset(uint32 NumLeaves);
+
+	// Frees all memory used by the buffer
+	void Empty();
+
+	uint32 GetNumLeaves() const { return (uint32)Leaves.Num(); }
+
+	// Returns true if no voxels have been set since the last reset
+	bool IsEmpty() const { return (DirtyBegin >= DirtyEnd); }
+
+	// Range of leaves that may have voxels set, end exclusive
+	uint32 GetDirtyBegin() const { return DirtyBegin; }
+	uint32 GetDirtyEnd() const { return DirtyEnd; }
+
+	FORCEINLINE uint64 GetLeaf(uint32 LeafCode) const
+	{
+		return Leaves[LeafCode];
+	}
+
+	FORCEINLINE void SetLeaf(uint32 LeafCode, uint64 LeafVoxels)
+	{
+		Leaves[LeafCode] = LeafVoxels;
+		MarkDirty(LeafCode);
+	}
+
+	FORCEINLINE void AddLeafVoxels(uint32 LeafCode, uint64 LeafVoxels)
+	{
+		Leaves[LeafCode] |= LeafVoxels;
+		MarkDirty(LeafCode);
+	}
+
+	FORCEINLINE bool IsVoxelSet(uint32 VoxelCode) const
+	{
+		return (Leaves[VoxelCode >> 6] & (1ull << (VoxelCode & 63))) != 0;
+	}
+
+	FORCEINLINE void SetVoxel(uint32 VoxelCode)
+	{
+		AddLeafVoxels(VoxelCode >> 6, 1ull << (VoxelCode & 63));
+	}
+
+	// Calls 'Func' with the code of every set voxel, in Morton order
+	template<typename TFunc>
+	void ForEachSetVoxel(const TFunc& Func) const
+	{
+		for (uint32 LeafCode = DirtyBegin; LeafCode < DirtyEnd; ++LeafCode)
+		{
+			uint64 LeafVoxels = Leaves[LeafCode];
+			while (LeafVoxels != 0)
+			{
+				Func((LeafCode << 6) | (uint32)FMath::CountTrailingZeros64(LeafVoxels));
+				LeafVoxels &= LeafVoxels - 1;
+			}
+		}
+	}
+
+	uint32 GetMemUsed() const { return Leaves.GetAllocatedSize(); }
+
+private:
+	FORCEINLINE void MarkDirty(uint32 LeafCode)
+	{
+		DirtyBegin = FMath::Min(DirtyBegin, LeafCode);
+		DirtyEnd = FMath::Max(DirtyEnd, LeafCode + 1);
+	}
+
+	TArray<uint64> Leaves;
+
+	uint32 DirtyBegin = MAX_uint32;
+	uint32 DirtyEnd = 0;
+};
+
+//
+// Scratch memory for generating tiles. Each worker thread keeps one around and reuses it
+// for every tile and generator job it runs, so voxelizing a tile doesn't allocate once
+// the buffers have grown to fit.
+//
+// NOTE: Must only be used on the thread it was acquired on.
+//
+struct FNavSvoGenerationArena
+{
+	~FNavSvoGenerationArena();
+
+	// Returns the arena for the calling thread
+	static FNavSvoGenerationArena& Get();
+
+	// Returns the memory used by the arenas of every thread, as of the last time each
+	// one called UpdateTotalMemUsed
+	static uint64 GetTotalMemUsed();
+
+	// Voxels filled from the geometry, and the same voxels once they're padded out
+	FNavSvoVoxelBuffer Voxels;
+	FNavSvoVoxelBuffer PaddedVoxels;
+
+	// Leaves being dilated, swapped back and forth by each padding pass
+	TArray<uint64> PadLeaves[2];
+
+	// Distance grid used to build clearance
+	TArray<uint8> Distances;
+
+	// Voxels of each leaf of the tile being built (clipped to the navigation bounds), and
+	// the state of every node once collapsed, by layer then Morton code
+	TArray<uint64> TileLeaves;
+	TArray<ENodeState> NodeStates;
+
+	// Area code of each leaf of the tile being built, by Morton code
+	TArray<uint8> LeafAreas;
+
+	uint32 GetMemUsed() const;
+
+	// Updates what this arena adds to GetTotalMemUsed. Called once a tile is built, since
+	// the buffers grow all over the place while building it.
+	void UpdateTotalMemUsed();
+
+private:
+	uint32 TrackedMemUsed = 0;
+};
@@ -0,0 +1,256 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoGenerationStats.h"
+
+#include "AI/Navigation/NavigationTypes.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/IConsoleManager.h"
+#include "Trace/Trace.inl"
+
+TAutoConsoleVariable<bool> CVarNavSvoGenerationStats(TEXT("NavSvo.GenerationStats"), true, TEXT("Sends the timings for each generated tile and job to Unreal Insights, and keeps totals for NavSvo.DumpGenerationStats."), ECVF_Cheat);
+
+// Defined with the query stats
+UE_TRACE_CHANNEL_EXTERN(Gunfire3DNavChannel)
+
+UE_TRACE_EVENT_BEGIN(Gunfire3DNav, TileGenerated)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, JobID)
+	UE_TRACE_EVENT_FIELD(int32, TileX)
+	UE_TRACE_EVENT_FIELD(int32, TileY)
+	UE_TRACE_EVENT_FIELD(int32, TileZ)
+	UE_TRACE_EVENT_FIELD(uint32, TotalTriangles)
+	UE_TRACE_EVENT_FIELD(uint32, UsedTriangles)
+	UE_TRACE_EVENT_FIELD(float, GatherTime)
+	UE_TRACE_EVENT_FIELD(float, FillTime)
+	UE_TRACE_EVENT_FIELD(float, PadTime)
+	UE_TRACE_EVENT_FIELD(float, NodeTime)
+	UE_TRACE_EVENT_FIELD(float, ClearanceTime)
+	UE_TRACE_EVENT_FIELD(bool, FromCache)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(Gunfire3DNav, GenerationJob)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, JobID)
+	UE_TRACE_EVENT_FIELD(int32, NumTiles)
+	UE_TRACE_EVENT_FIELD(float, GatherTime)
+	UE_TRACE_EVENT_FIELD(float, WorkTime)
+	UE_TRACE_EVENT_FIELD(float, AddTime)
+	UE_TRACE_EVENT_FIELD(float, TotalTime)
+UE_TRACE_EVENT_END()
+
+namespace NavSvoGenerationStats
+{
+	// Only the slowest tiles are kept for the summary, so the stats don't grow while
+	// tiles are rebuilt at runtime.
+	constexpr int32 MaxSlowestTiles = 64;
+
+	std::atomic<uint32> LastJobID(0);
+
+	// Tiles are built on any thread, so everything is guarded by the lock
+	FCriticalSection Lock;
+
+	FNavSvoTileGenerationStats TileTotals;
+	FNavSvoJobGenerationStats JobTotals;
+	int32 NumTiles = 0;
+	int32 NumCachedTiles = 0;
+	int32 NumJobs = 0;
+
+	// Wall time covered by the recorded jobs
+	uint64 FirstCycle = 0;
+	uint64 LastCycle = 0;
+
+	// Kept sorted from slowest to fastest
+	TArray<FNavSvoTileGenerationStats> SlowestTiles;
+
+	float ToMs(uint64 Cycles)
+	{
+		return (float)FPlatformTime::ToMilliseconds64(Cycles);
+	}
+}
+
+bool FNavSvoGenerationStats::IsEnabled()
+{
+	return CVarNavSvoGenerationStats.GetValueOnAnyThread();
+}
+
+uint32 FNavSvoGenerationStats::NextJobID()
+{
+	return ++NavSvoGenerationStats::LastJobID;
+}
+
+void FNavSvoGenerationStats::RecordTile(uint32 JobID, const FNavSvoTileGenerationStats& TileStats)
+{
+	using namespace NavSvoGenerationStats;
+
+#if UE_TRACE_ENABLED
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(Gunfire3DNavChannel))
+	{
+		UE_TRACE_LOG(Gunfire3DNav, TileGenerated, Gunfire3DNavChannel)
+			<< TileGenerated.Cycle(FPlatformTime::Cycles64())
+			<< TileGenerated.JobID(JobID)
+			<< TileGenerated.TileX(TileStats.TileCoord.X)
+			<< TileGenerated.TileY(TileStats.TileCoord.Y)
+			<< TileGenerated.TileZ(TileStats.TileCoord.Z)
+			<< TileGenerated.TotalTriangles(TileStats.TotalTriangles)
+			<< TileGenerated.UsedTriangles(TileStats.UsedTriangles)
+			<< TileGenerated.GatherTime(ToMs(TileStats.GatherCycles))
+			<< TileGenerated.FillTime(ToMs(TileStats.FillCycles))
+			<< TileGenerated.PadTime(ToMs(TileStats.PadCycles))
+			<< TileGenerated.NodeTime(ToMs(TileStats.NodeCycles))
+			<< TileGenerated.ClearanceTime(ToMs(TileStats.ClearanceCycles))
+			<< TileGenerated.FromCache(TileStats.bFromCache);
+	}
+#endif
+
+	FScopeLock ScopeLock(&Lock);
+
+	++NumTiles;
+	NumCachedTiles += TileStats.bFromCache ? 1 : 0;
+
+	TileTotals.TotalTriangles += TileStats.TotalTriangles;
+	TileTotals.UsedTriangles += TileStats.UsedTriangles;
+	TileTotals.GatherCycles += TileStats.GatherCycles;
+	TileTotals.FillCycles += TileStats.FillCycles;
+	TileTotals.PadCycles += TileStats.PadCycles;
+	TileTotals.NodeCycles += TileStats.NodeCycles;
+	TileTotals.ClearanceCycles += TileStats.ClearanceCycles;
+
+	const uint64 TotalCycles = TileStats.GetTotalCycles();
+	if (SlowestTiles.Num() < MaxSlowestTiles || TotalCycles > SlowestTiles.Last().GetTotalCycles())
+	{
+		const int32 InsertIdx = Algo::LowerBound(SlowestTiles, TotalCycles, [](const FNavSvoTileGenerationStats& Stats, uint64 Cycles)
+		{
+			return Stats.GetTotalCycles() > Cycles;
+		});
+
+		SlowestTiles.Insert(TileStats, InsertIdx);
+
+		if (SlowestTiles.Num() > MaxSlowestTiles)
+		{
+			SlowestTiles.Pop(false);
+		}
+	}
+}
+
+void FNavSvoGenerationStats::RecordJob(const FNavSvoJobGenerationStats& JobStats)
+{
+	using namespace NavSvoGenerationStats;
+
+#if UE_TRACE_ENABLED
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(Gunfire3DNavChannel))
+	{
+		UE_TRACE_LOG(Gunfire3DNav, GenerationJob, Gunfire3DNavChannel)
+			<< GenerationJob.Cycle(FPlatformTime::Cycles64())
+			<< GenerationJob.JobID(JobStats.JobID)
+			<< GenerationJob.NumTiles(JobStats.NumTiles)
+			<< GenerationJob.GatherTime(ToMs(JobStats.GatherCycles))
+			<< GenerationJob.WorkTime(ToMs(JobStats.WorkCycles))
+			<< GenerationJob.AddTime(ToMs(JobStats.AddCycles))
+			<< GenerationJob.TotalTime(ToMs(JobStats.TotalCycles));
+	}
+#endif
+
+	FScopeLock ScopeLock(&Lock);
+
+	const uint64 EndCycle = FPlatformTime::Cycles64();
+	const uint64 StartCycle = EndCycle - JobStats.TotalCycles;
+
+	FirstCycle = (NumJobs == 0) ? StartCycle : FMath::Min(FirstCycle, StartCycle);
+	LastCycle = EndCycle;
+
+	++NumJobs;
+
+	JobTotals.NumTiles += JobStats.NumTiles;
+	JobTotals.GatherCycles += JobStats.GatherCycles;
+	JobTotals.WorkCycles += JobStats.WorkCycles;
+	JobTotals.AddCycles += JobStats.AddCycles;
+}
+
+void FNavSvoGenerationStats::Reset()
+{
+	using namespace NavSvoGenerationStats;
+
+	FScopeLock ScopeLock(&Lock);
+
+	TileTotals = FNavSvoTileGenerationStats();
+	JobTotals = FNavSvoJobGenerationStats();
+	NumTiles = 0;
+	NumCachedTiles = 0;
+	NumJobs = 0;
+	FirstCycle = 0;
+	LastCycle = 0;
+	SlowestTiles.Reset();
+}
+
+FNavSvoGenerationSummary FNavSvoGenerationStats::GetSummary()
+{
+	using namespace NavSvoGenerationStats;
+
+	FScopeLock ScopeLock(&Lock);
+
+	FNavSvoGenerationSummary Summary;
+	Summary.NumTiles = NumTiles;
+	Summary.NumCachedTiles = NumCachedTiles;
+	Summary.NumJobs = NumJobs;
+	Summary.TileTotals = TileTotals;
+	Summary.JobTotals = JobTotals;
+	Summary.WallCycles = LastCycle - FirstCycle;
+
+	return Summary;
+}
+
+void FNavSvoGenerationStats::DumpSummary(int32 NumSlowestTiles)
+{
+	using namespace NavSvoGenerationStats;
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (NumTiles == 0)
+	{
+		UE_LOG(LogNavigation, Display, TEXT("No tiles have been generated since the generation stats were reset."));
+		return;
+	}
+
+	const float FillTime = ToMs(TileTotals.FillCycles);
+	const float TrisPerSec = (FillTime > 0.f) ? (TileTotals.UsedTriangles / (FillTime * 0.001f)) : 0.f;
+
+	UE_LOG(LogNavigation, Display, TEXT("Generated %d tiles (%d from the tile cache) in %d jobs over %.2f ms"),
+		NumTiles, NumCachedTiles, NumJobs, ToMs(LastCycle - FirstCycle));
+	UE_LOG(LogNavigation, Display, TEXT("  %u triangles (%u culled), %.0f triangles/sec voxelized"),
+		TileTotals.UsedTriangles, TileTotals.TotalTriangles - TileTotals.UsedTriangles, TrisPerSec);
+	UE_LOG(LogNavigation, Display, TEXT("  Worker time: %.2f ms gather, %.2f ms fill, %.2f ms pad, %.2f ms node, %.2f ms clearance"),
+		ToMs(TileTotals.GatherCycles), FillTime, ToMs(TileTotals.PadCycles), ToMs(TileTotals.NodeCycles), ToMs(TileTotals.ClearanceCycles));
+	UE_LOG(LogNavigation, Display, TEXT("  Game thread time: %.2f ms gather, %.2f ms add"),
+		ToMs(JobTotals.GatherCycles), ToMs(JobTotals.AddCycles));
+
+	NumSlowestTiles = FMath::Min(NumSlowestTiles, SlowestTiles.Num());
+	if (NumSlowestTiles > 0)
+	{
+		UE_LOG(LogNavigation, Display, TEXT("  Slowest tiles:"));
+
+		for (int32 TileIdx = 0; TileIdx < NumSlowestTiles; ++TileIdx)
+		{
+			const FNavSvoTileGenerationStats& Tile = SlowestTiles[TileIdx];
+
+			UE_LOG(LogNavigation, Display, TEXT("    (%d, %d, %d): %.2f ms [%u tris (%u culled)] (%.2f ms gather, %.2f ms fill, %.2f ms pad, %.2f ms node, %.2f ms clearance)"),
+				Tile.TileCoord.X, Tile.TileCoord.Y, Tile.TileCoord.Z,
+				ToMs(Tile.GetTotalCycles()),
+				Tile.UsedTriangles, Tile.TotalTriangles - Tile.UsedTriangles,
+				ToMs(Tile.GatherCycles), ToMs(Tile.FillCycles), ToMs(Tile.PadCycles), ToMs(Tile.NodeCycles), ToMs(Tile.ClearanceCycles));
+		}
+	}
+}
+
+static FAutoConsoleCommand CmdDumpGenerationStats(
+	TEXT("NavSvo.DumpGenerationStats"),
+	TEXT("Logs generation times since the last full rebuild (or reset), followed by the slowest tiles. Optional argument is how many tiles to list (default 10)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumSlowestTiles = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 10;
+		FNavSvoGenerationStats::DumpSummary(NumSlowestTiles);
+	}));
+
+static FAutoConsoleCommand CmdResetGenerationStats(
+	TEXT("NavSvo.ResetGenerationStats"),
+	TEXT("Clears the generation times kept for NavSvo.DumpGenerationStats."),
+	FConsoleCommandDelegate::CreateStatic(&FNavSvoGenerationStats::Reset));
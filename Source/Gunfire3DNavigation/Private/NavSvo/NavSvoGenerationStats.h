@@ -0,0 +1,114 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//
+// Time spent building one tile, split up by stage. Cycles are measured on whichever
+// worker built the tile.
+//
+struct FNavSvoTileGenerationStats
+{
+	FIntVector TileCoord = FIntVector::ZeroValue;
+
+	// Triangles gathered for the tile, and how many were left after culling
+	uint32 TotalTriangles = 0;
+	uint32 UsedTriangles = 0;
+
+	// Geometry gathered on the worker thread (async gathering only)
+	uint64 GatherCycles = 0;
+	uint64 FillCycles = 0;
+	uint64 PadCycles = 0;
+	uint64 NodeCycles = 0;
+	uint64 ClearanceCycles = 0;
+
+	// Set if the tile was found in the tile cache instead of being built
+	bool bFromCache = false;
+
+	uint64 GetTotalCycles() const
+	{
+		return GatherCycles + FillCycles + PadCycles + NodeCycles + ClearanceCycles;
+	}
+};
+
+//
+// Time spent on one generation job (a batch of tiles built by one FNavSvoTileGenerator)
+//
+struct FNavSvoJobGenerationStats
+{
+	uint32 JobID = 0;
+	int32 NumTiles = 0;
+
+	// Geometry gathered on the game thread while the job was being filled
+	uint64 GatherCycles = 0;
+
+	// Time spent building tiles on workers, and adding them to the octree afterwards
+	uint64 WorkCycles = 0;
+	uint64 AddCycles = 0;
+
+	// Time from when the job was created until all its tiles were added
+	uint64 TotalCycles = 0;
+};
+
+//
+// Totals for everything recorded since the generation stats were last reset
+//
+struct FNavSvoGenerationSummary
+{
+	int32 NumTiles = 0;
+	int32 NumCachedTiles = 0;
+	int32 NumJobs = 0;
+
+	FNavSvoTileGenerationStats TileTotals;
+	FNavSvoJobGenerationStats JobTotals;
+
+	// Wall time covered by the recorded jobs
+	uint64 WallCycles = 0;
+};
+
+//
+// Generation profiling which doesn't need PROFILE_SVO_GENERATION. While NavSvo.GenerationStats
+// is enabled each built tile and job is sent to Unreal Insights on the Gunfire3DNav trace
+// channel, and totals are kept for the NavSvo.DumpGenerationStats summary. The totals
+// are reset whenever a full rebuild starts, or with NavSvo.ResetGenerationStats.
+//
+class FNavSvoGenerationStats
+{
+public:
+	static bool IsEnabled();
+
+	// Returns a unique ID for a job, so its trace events can be told apart
+	static uint32 NextJobID();
+
+	static void RecordTile(uint32 JobID, const FNavSvoTileGenerationStats& TileStats);
+	static void RecordJob(const FNavSvoJobGenerationStats& JobStats);
+
+	static void Reset();
+
+	static FNavSvoGenerationSummary GetSummary();
+
+	// Logs the totals since the last reset, and the slowest tiles
+	static void DumpSummary(int32 NumSlowestTiles);
+};
+
+//
+// Adds the cycles spent within the scope to one of the generation stats
+//
+class FNavSvoScopedGenerationTimer
+{
+public:
+	FNavSvoScopedGenerationTimer(uint64& InOutCycles)
+		: Cycles(InOutCycles)
+		, StartCycles(FPlatformTime::Cycles64())
+	{}
+
+	~FNavSvoScopedGenerationTimer()
+	{
+		Cycles += FPlatformTime::Cycles64() - StartCycles;
+	}
+
+private:
+	uint64& Cycles;
+	const uint64 StartCycles;
+};
@@ -3,16 +3,20 @@
 #include "NavSvoGenerator.h"
 
 #include "Gunfire3DNavigationUtils.h"
+#include "NavSvoGenerationStats.h"
+#include "NavSvoGeometryCache.h"
 #include "NavSvoTileGenerator.h"
 #include "Gunfire3DNavData.h"
 #include "SparseVoxelOctree/SparseVoxelOctreeUtils.h"
 
 #include "NavigationSystem.h"
+#include "RenderCore.h"
 
 // Profiling stats
 DECLARE_CYCLE_STAT(TEXT("ProcessTileTasks (FNavSvoGenerator)"), STAT_NavSvoGenerator_ProcessTileTasks, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("AddGeneratedTiles (FNavSvoGenerator)"), STAT_NavSvoGenerator_AddGeneratedTiles, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("MarkDirtyTiles (FNavSvoGenerator)"), STAT_NavSvoGenerator_MarkDirtyTiles, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("UpdatePendingTilePriorities (FNavSvoGenerator)"), STAT_NavSvoGenerator_UpdatePendingTilePriorities, STATGROUP_Gunfire3DNavigation);
 
 // Memory stats
 DECLARE_MEMORY_STAT(TEXT("Pending Tiles (FNavSvoGenerator)"), STAT_NavSvoGenerator_PendingTiles, STATGROUP_Gunfire3DNavigation);
@@ -55,11 +59,27 @@ TAutoConsoleVariable<int32> CVarMaxTrisPerTask(TEXT("NavSvo.MaxTrisPerTask"), 10
 TAutoConsoleVariable<float> CVarNavSvoMaxTimePerTick(TEXT("NavSvo.MaxTimePerTick"), 0.5f, TEXT("Amount of time in ms we can spend each frame doing work on the main thread."), ECVF_Cheat);
 TAutoConsoleVariable<float> CVarNavSvoBoostMaxTimePerTick(TEXT("NavSvo.BoostMaxTimePerTick"), 5.0f, TEXT("Amount of time in ms we can spend each frame doing work on the main thread when boosted."), ECVF_Cheat);
 
+// Instead of fixed limits outside of boost mode, the number of tasks and time per tick
+// can follow how much headroom there is. While the game thread is under the target time
+// and there's work waiting they're raised gradually, up to the boosted limits, and when
+// it goes over (or tasks are waiting on busy workers) they're lowered again, down to a
+// single task and NavSvo.MaxTimePerTick.
+TAutoConsoleVariable<bool> CVarNavSvoAdaptiveConcurrency(TEXT("NavSvo.AdaptiveConcurrency"), true, TEXT("Adjusts the number of tile generator tasks and time per tick based on how busy the game thread and workers are."), ECVF_Cheat);
+TAutoConsoleVariable<float> CVarNavSvoAdaptiveTargetFrameTime(TEXT("NavSvo.AdaptiveTargetFrameTime"), 16.6f, TEXT("Game thread time in ms that adaptive concurrency tries to keep the frame under."), ECVF_Cheat);
+
 // If a task has been pending for this many frames, force it to start. This is for the
 // case where we're gathering a bunch of tiles with barely any collision geo in them so
 // we're not hitting our triangle cap, so we eventually get the task started.
 TAutoConsoleVariable<int32> CVarMaxPendingTicks(TEXT("NavSvo.MaxPendingTicks"), 5, TEXT("Max number of frames a task can gather more tiles before it is forced to start"), ECVF_Cheat);
 
+// Whether the tiles within each generator task are built in parallel. When we're capped to
+// a couple of tasks that leaves most cores idle, which is fine during gameplay but not when
+// we're trying to build as fast as possible.
+// 0: Never
+// 1: When boosted or running a commandlet
+// 2: Always
+TAutoConsoleVariable<int32> CVarNavSvoParallelTileGeneration(TEXT("NavSvo.ParallelTileGeneration"), 1, TEXT("Builds the tiles within each generator task in parallel (0: never, 1: when boosted or in a commandlet, 2: always)."), ECVF_Cheat);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 FNavSvoGenerator::FNavSvoGenerator(AGunfire3DNavData* InNavDataActor)
@@ -116,6 +136,9 @@ const FEditableSvo* FNavSvoGenerator::GetOctree() const
 
 bool FNavSvoGenerator::RebuildAll()
 {
+	// Start the generation stats over, so the summary covers just this build
+	FNavSvoGenerationStats::Reset();
+
 	// Recreate octree
 	NavDataActor->DestroyOctree();
 	ConstructOctree();
@@ -159,6 +182,7 @@ void FNavSvoGenerator::CancelBuild()
 {
 	// Remove all pending tiles
 	PendingTiles.Empty();
+	PendingTileBounds.Empty();
 
 	// If we were in the process of filling a generator, delete it
 	if (PendingGenerator != nullptr)
@@ -178,6 +202,10 @@ void FNavSvoGenerator::CancelBuild()
 		}
 	}
 	RunningGenerators.Empty();
+
+	// Nothing is going to write the tiles we were waiting for, so release any path
+	// batches held back for them.
+	NavDataActor->EndOctreeWrite();
 }
 
 bool FNavSvoGenerator::IsBuildInProgressCheckDirty() const
@@ -271,6 +299,9 @@ void FNavSvoGenerator::EnsureBuildCompletion()
 
 	do
 	{
+		// We're blocking anyway, so don't let path batches hold up the build
+		NavDataActor->WaitForPathBatches();
+
 		TickBuildTasks(16);
 
 		// Block until tasks are finished
@@ -294,10 +325,10 @@ void FNavSvoGenerator::TickAsyncBuild(float DeltaSeconds)
 		return;
 	}
 
+	UpdateAdaptiveConcurrency();
+
 	// Determine the maximum allowed number of worker threads
-	const int32 MaxTileGeneratorTasks = AGunfire3DNavData::IsGenerationBoostMode() ?
-		CVarNavSvoBoostMaxTasks.GetValueOnGameThread() :
-		CVarNavSvoMaxTasks.GetValueOnGameThread();
+	const int32 MaxTileGeneratorTasks = GetMaxTasks();
 
 	const int32 NumTasksToSubmit = FMath::Max(0, MaxTileGeneratorTasks - GetNumRunningBuildTasks());
 
@@ -310,16 +341,127 @@ void FNavSvoGenerator::TickAsyncBuild(float DeltaSeconds)
 	}
 }
 
+int32 FNavSvoGenerator::GetMaxTasks() const
+{
+	if (AGunfire3DNavData::IsGenerationBoostMode())
+	{
+		return CVarNavSvoBoostMaxTasks.GetValueOnGameThread();
+	}
+
+	if (CVarNavSvoAdaptiveConcurrency.GetValueOnGameThread() && AdaptiveMaxTasks > 0.f)
+	{
+		return FMath::FloorToInt(AdaptiveMaxTasks);
+	}
+
+	return CVarNavSvoMaxTasks.GetValueOnGameThread();
+}
+
+double FNavSvoGenerator::GetMaxTimePerTick() const
+{
+	if (AGunfire3DNavData::IsGenerationBoostMode())
+	{
+		return CVarNavSvoBoostMaxTimePerTick.GetValueOnGameThread();
+	}
+
+	if (CVarNavSvoAdaptiveConcurrency.GetValueOnGameThread() && AdaptiveMaxTimePerTick > 0.f)
+	{
+		return AdaptiveMaxTimePerTick;
+	}
+
+	return CVarNavSvoMaxTimePerTick.GetValueOnGameThread();
+}
+
+void FNavSvoGenerator::UpdateAdaptiveConcurrency()
+{
+	// How quickly the limits move. Increases are small steps, so we creep up on the
+	// headroom, while decreases are a fraction of the current limit so we get out of
+	// the way quickly when the game gets busy.
+	constexpr float TaskStep = 0.1f;
+	constexpr float TimeStep = 0.05f;
+	constexpr float BackOffScale = 0.9f;
+	constexpr float Smoothing = 0.1f;
+
+	// Boost mode has fixed limits
+	if (!CVarNavSvoAdaptiveConcurrency.GetValueOnGameThread() || AGunfire3DNavData::IsGenerationBoostMode())
+	{
+		return;
+	}
+
+	const float MinTasks = 1.f;
+	const float MaxTasks = FMath::Max(MinTasks, (float)CVarNavSvoBoostMaxTasks.GetValueOnGameThread());
+	const float MinTimePerTick = CVarNavSvoMaxTimePerTick.GetValueOnGameThread();
+	const float MaxTimePerTick = FMath::Max(MinTimePerTick, CVarNavSvoBoostMaxTimePerTick.GetValueOnGameThread());
+
+	// Start from the fixed limits
+	if (AdaptiveMaxTasks <= 0.f)
+	{
+		AdaptiveMaxTasks = (float)CVarNavSvoMaxTasks.GetValueOnGameThread();
+		AdaptiveMaxTimePerTick = MinTimePerTick;
+	}
+
+	// The game thread time includes the time we spent last tick, so raising our limits
+	// pushes it towards the target on its own.
+	const float TargetFrameTime = CVarNavSvoAdaptiveTargetFrameTime.GetValueOnGameThread();
+	SmoothedGameThreadTime = FMath::Lerp(SmoothedGameThreadTime, (float)FPlatformTime::ToMilliseconds(GGameThreadTime), Smoothing);
+
+	// If tasks are waiting more than a frame to start the workers are busy with other
+	// work, and more tasks would only queue up behind it.
+	const bool bWorkersBusy = (SmoothedTaskQueueTime > TargetFrameTime);
+
+	if (SmoothedGameThreadTime > TargetFrameTime)
+	{
+		AdaptiveMaxTasks *= BackOffScale;
+		AdaptiveMaxTimePerTick *= BackOffScale;
+	}
+	else if (SmoothedGameThreadTime < TargetFrameTime * 0.8f && HasBuildWork())
+	{
+		// Only raise the limits we're actually running into
+		if (!bWorkersBusy && GetNumRunningBuildTasks() >= FMath::FloorToInt(AdaptiveMaxTasks))
+		{
+			AdaptiveMaxTasks += TaskStep;
+		}
+
+		if (bLastTickHitTimeLimit)
+		{
+			AdaptiveMaxTimePerTick += TimeStep;
+		}
+	}
+
+	if (bWorkersBusy)
+	{
+		AdaptiveMaxTasks -= TaskStep;
+	}
+
+	AdaptiveMaxTasks = FMath::Clamp(AdaptiveMaxTasks, MinTasks, MaxTasks);
+	AdaptiveMaxTimePerTick = FMath::Clamp(AdaptiveMaxTimePerTick, MinTimePerTick, MaxTimePerTick);
+}
+
 int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 {
 	SCOPE_CYCLE_COUNTER(STAT_NavSvoGenerator_ProcessTileTasks);
 
+	bLastTickHitTimeLimit = false;
+
 	FEditableSvo* Octree = GetOctree();
 	check(Octree);
 
-	// We should never be batch editing at this point.
-	ensure(Octree->IsBatchEditing() == false);
-	Octree->BeginBatchEdit();
+	if (!HasBuildWork())
+	{
+		return 0;
+	}
+
+	// Path batches read the octree from worker threads, so they need to finish before
+	// any tiles are modified. Rather than stalling on them, new batches are held back
+	// until we've had our turn and finished tiles are added next tick. Gathering and
+	// submitting new tasks doesn't touch the octree, so that carries on regardless.
+	const bool bCanWriteOctree = NavDataActor->TryBeginOctreeWrite();
+
+	if (bCanWriteOctree)
+	{
+		// We should never be batch editing at this point.
+		ensure(Octree->IsBatchEditing() == false);
+		Octree->BeginBatchEdit();
+	}
 
 	const bool bHasTasksAtStart = (GetNumRemaningBuildTasks() > 0);
 	int32 NumUpdatedTiles = 0;
@@ -329,9 +471,7 @@ int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 		++PendingGenerator->PendingTicks;
 	}
 
-	const double MaxTickMS = AGunfire3DNavData::IsGenerationBoostMode() ?
-		CVarNavSvoBoostMaxTimePerTick.GetValueOnGameThread() :
-		CVarNavSvoMaxTimePerTick.GetValueOnGameThread();
+	const double MaxTickMS = GetMaxTimePerTick();
 	const uint64 MaxCycles = FMath::CeilToInt(MaxTickMS / (FPlatformTime::GetSecondsPerCycle64() * 1000.0));
 	const uint64 EndCycle = FPlatformTime::Cycles64() + MaxCycles;
 
@@ -349,6 +489,10 @@ int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 			TSharedRef<FNavSvoTileGenerator>& TileGeneratorRef = RunningGenerator.AsyncTask->GetTask().TileGenerator;
 			CompletedGenerators.Add(TileGeneratorRef);
 
+			// How long the task sat in the queue tells us how busy the workers are
+			const float QueueTime = FPlatformTime::ToMilliseconds64(TileGeneratorRef->StartWorkCycle - TileGeneratorRef->SubmitCycle);
+			SmoothedTaskQueueTime = FMath::Lerp(SmoothedTaskQueueTime, QueueTime, 0.25f);
+
 			// Destroy the tile generator task
 			delete RunningGenerator.AsyncTask;
 			RunningGenerator.AsyncTask = nullptr;
@@ -358,7 +502,7 @@ int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 		}
 	}
 
-	const bool AddedTiles = (CompletedGenerators.Num() > 0);
+	const bool AddedTiles = bCanWriteOctree && (CompletedGenerators.Num() > 0);
 
 	// Add all completed generator data
 	if (AddedTiles)
@@ -394,11 +538,27 @@ int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 	// Submit new tasks. We do this after we've added any completed tiles since they share
 	// the same timeout, and we'd rather get completed tasks added to the octree before we
 	// kick off new ones.
-	ProcessPendingTiles(Octree, MaxTasksToSubmit, EndCycle);
+	UpdatePendingTilePriorities();
+	ProcessPendingTiles(Octree, MaxTasksToSubmit, EndCycle, bCanWriteOctree);
 
-	// If the octree has been updated, finalize the nodes to complete neighbor links, etc.
-	check(Octree->IsBatchEditing());
-	Octree->EndBatchEdit();
+	bLastTickHitTimeLimit = (FPlatformTime::Cycles64() >= EndCycle);
+
+	if (bCanWriteOctree)
+	{
+		// If the octree has been updated, finalize the nodes to complete neighbor links, etc.
+		check(Octree->IsBatchEditing());
+		Octree->EndBatchEdit();
+
+		NavDataActor->EndOctreeWrite();
+	}
+
+	// Now the links are up to date, make any paths through the changed tiles find their
+	// way again.
+	if (ChangedTileIDs.Num() > 0)
+	{
+		NavDataActor->InvalidateAffectedPaths(ChangedTileIDs);
+		ChangedTileIDs.Reset();
+	}
 
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
 	if (AddedTiles)
@@ -415,6 +575,7 @@ int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 		if (PendingTiles.Num() == 0)
 		{
 			PendingTiles.Empty(32);
+			PendingTileBounds.Empty(32);
 		}
 
 		// Notify owner once all generation has completed.
@@ -424,16 +585,37 @@ int32 FNavSvoGenerator::TickBuildTasks(const int32 MaxTasksToSubmit)
 	return NumUpdatedTiles;
 }
 
-void FNavSvoGenerator::ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksToSubmit, const uint64 EndCycle)
+bool FNavSvoGenerator::HasBuildWork() const
+{
+	if (PendingTiles.Num() > 0 || PendingGenerator != nullptr || CompletedGenerators.Num() > 0)
+	{
+		return true;
+	}
+
+	for (const FRunningGenerator& RunningGenerator : RunningGenerators)
+	{
+		if (RunningGenerator.AsyncTask->IsDone())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FNavSvoGenerator::ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksToSubmit, const uint64 EndCycle, bool bCanWriteOctree)
 {
 	int32 NumSubmittedTasks = 0;
-	int32 NumBuildingCoords = 0;
 	uint64 GatherCyclesThisTick = 0;
 
-	// Submit pending tile elements
-	for (int32 PendingTileIdx = (PendingTiles.Num() - 1); PendingTileIdx >= 0; --PendingTileIdx)
+	// Tiles we skipped because they're already building, or are empty while we can't
+	// remove them from the octree, to be put back in the queue
+	TArray<FPendingTile, TInlineAllocator<16>> BuildingTiles;
+
+	// Submit pending tile elements, nearest first
+	while (PendingTiles.Num() > 0)
 	{
-		FPendingTile& PendingTile = PendingTiles[PendingTileIdx];
+		const FPendingTile PendingTile = PendingTiles.HeapTop();
 
 		const bool PendingGeneratorFull =
 			PendingGenerator != nullptr &&
@@ -450,7 +632,8 @@ void FNavSvoGenerator::ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksT
 		// submitted after the processing task completes.
 		if (IsCoordGenerating(PendingTile, PendingTile))
 		{
-			++NumBuildingCoords;
+			PendingTiles.HeapPopDiscard();
+			BuildingTiles.Add(PendingTile);
 			continue;
 		}
 
@@ -468,26 +651,36 @@ void FNavSvoGenerator::ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksT
 		// If the pending generator isn't full, gather another tile
 		if (!PendingGeneratorFull)
 		{
+			// Pending tile will be dealt with at this point and can be removed.
+			PendingTiles.HeapPopDiscard();
+
+			FBox DirtyBounds(ForceInit);
+			PendingTileBounds.RemoveAndCopyValue(PendingTile, DirtyBounds);
+
 			const uint64 GatherStartTime = FPlatformTime::Cycles64();
 
 			// Copy all the geometry for this tile into the generator.
-			if (!PendingGenerator->AddTile(PendingTile))
+			if (!PendingGenerator->AddTile(PendingTile, DirtyBounds))
 			{
 				// In this case there isn't anything to build for this tile so we need to
 				// be sure the main octree is updated to reflect this as it may have had data
 				// previously.
-				Octree->RemoveTileAtCoord(PendingTile);
+				if (bCanWriteOctree)
+				{
+					Octree->RemoveTileAtCoord(PendingTile);
+					ChangedTileIDs.AddUnique(FSvoTile::CalcTileID(PendingTile));
+				}
+				else
+				{
+					PendingTileBounds.Add(PendingTile, DirtyBounds);
+					BuildingTiles.Add(PendingTile);
+				}
 			}
 
 			const uint64 GatherCycles = FPlatformTime::Cycles64() - GatherStartTime;
 
 			GatherCyclesThisTick += GatherCycles;
-#if PROFILE_SVO_GENERATION
 			PendingGenerator->GatherCycles += GatherCycles;
-#endif
-
-			// Pending tile should be dealt with at this point and can be removed.
-			PendingTiles.RemoveAt(PendingTileIdx);
 		}
 
 		// We've spent more than our max gather time for this frame, stop queuing more tiles.
@@ -501,6 +694,11 @@ void FNavSvoGenerator::ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksT
 		{
 			++NumSubmittedTasks;
 		}
+		else if (PendingGeneratorFull)
+		{
+			// Nothing can take the tile, so leave it for next time
+			break;
+		}
 
 		// If we've submitted the maximum number of build tasks for this update, bail.
 		if (NumSubmittedTasks >= MaxTasksToSubmit)
@@ -509,12 +707,18 @@ void FNavSvoGenerator::ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksT
 		}
 	}
 
+	// Skipping a tile doesn't change its priority, so it goes back in the same place
+	for (const FPendingTile& BuildingTile : BuildingTiles)
+	{
+		PendingTiles.HeapPush(BuildingTile);
+	}
+
 	if (NumSubmittedTasks < MaxTasksToSubmit)
 	{
 		// This is for the case where we have pending tiles, but they're all for stuff
 		// already queued up to build or building. In that case, we want to force start
 		// the current pending task, if there is one.
-		const bool AllPendingTilesBuilding = (PendingTiles.Num() == NumBuildingCoords);
+		const bool AllPendingTilesBuilding = (PendingTiles.Num() == BuildingTiles.Num());
 
 		TryRunPendingGenerator(AllPendingTilesBuilding);
 	}
@@ -543,10 +747,16 @@ bool FNavSvoGenerator::TryRunPendingGenerator(bool ForceStart)
 		TSharedRef<FNavSvoTileGenerator> TileGeneratorRef = MakeShareable(PendingGenerator);
 		PendingGenerator = nullptr;
 
+		const int32 ParallelTileGeneration = CVarNavSvoParallelTileGeneration.GetValueOnGameThread();
+		TileGeneratorRef->bParallelTiles =
+			ParallelTileGeneration >= 2 ||
+			(ParallelTileGeneration == 1 && (AGunfire3DNavData::IsGenerationBoostMode() || IsRunningCommandlet()));
+
 		if (CVarAsyncTileBuildingEnabled.GetValueOnGameThread() > 0)
 		{
 			// Create a new async task and kick it off to start the generation process
 			TUniquePtr<FNavSvoTileGeneratorTask> TileGenerationTask = MakeUnique<FNavSvoTileGeneratorTask>(TileGeneratorRef);
+			TileGeneratorRef->SubmitCycle = FPlatformTime::Cycles64();
 			TileGenerationTask->StartBackgroundTask();
 
 			// Create a build tile and cache it off so we can keep track of its progress.
@@ -584,19 +794,18 @@ bool FNavSvoGenerator::AddGeneratedTiles(FNavSvoTileGenerator& TileGenerator, co
 
 	bool AddedAllTiles = true;
 
-#if PROFILE_SVO_GENERATION
 	const uint64 AddStartCycle = FPlatformTime::Cycles64();
-#endif
 
 	FEditableSvo* Octree = GetOctree();
 
 	while (FSvoTile* Tile = TileGenerator.GetNextGeneratedTile())
 	{
 		// If filtering specific tiles, make sure we don't add any that aren't in the list
-		const bool bCanAddTile = WhitelistedTiles.Num() == 0 || IsTileWhitelisted(Tile->GetCoord());
+		const bool bCanAddTile = (WhitelistedTiles.Num() == 0 && NumTileShards <= 1) || IsTileWhitelisted(Tile->GetCoord());
 
 		if (bCanAddTile)
 		{
+			ChangedTileIDs.AddUnique(Tile->GetID());
 			Octree->AssumeTile(*Tile, true);
 
 			if (FPlatformTime::Cycles64() >= EndCycle)
@@ -607,9 +816,22 @@ bool FNavSvoGenerator::AddGeneratedTiles(FNavSvoTileGenerator& TileGenerator, co
 		}
 	}
 
-#if PROFILE_SVO_GENERATION
 	TileGenerator.AddCycles += FPlatformTime::Cycles64() - AddStartCycle;
 
+	if (AddedAllTiles && FNavSvoGenerationStats::IsEnabled())
+	{
+		FNavSvoJobGenerationStats JobStats;
+		JobStats.JobID = TileGenerator.JobID;
+		JobStats.NumTiles = TileGenerator.NumTiles();
+		JobStats.GatherCycles = TileGenerator.GatherCycles;
+		JobStats.WorkCycles = TileGenerator.WorkCycles;
+		JobStats.AddCycles = TileGenerator.AddCycles;
+		JobStats.TotalCycles = FPlatformTime::Cycles64() - TileGenerator.CreateCycle;
+
+		FNavSvoGenerationStats::RecordJob(JobStats);
+	}
+
+#if PROFILE_SVO_GENERATION
 	if (AddedAllTiles)
 	{
 		const uint64 TotalCycles = FPlatformTime::Cycles64() - TileGenerator.CreateCycle;
@@ -620,8 +842,8 @@ bool FNavSvoGenerator::AddGeneratedTiles(FNavSvoTileGenerator& TileGenerator, co
 			FPlatformTime::ToMilliseconds64(TotalCycles),
 			TileGenerator.PendingTicks,
 			TileGenerator.AddTicks,
-			TileGenerator.UsedTris,
-			TileGenerator.TotalTris - TileGenerator.UsedTris,
+			TileGenerator.UsedTris.load(),
+			TileGenerator.TotalTris.load() - TileGenerator.UsedTris.load(),
 			TileGenerator.NumTiles(),
 			FPlatformTime::ToMilliseconds64(TileGenerator.GatherCycles),
 			FPlatformTime::ToMilliseconds64(TileGenerator.GenerateCycles),
@@ -707,6 +929,16 @@ void FNavSvoGenerator::MarkDirtyTiles(const TArray<FNavigationDirtyArea>& DirtyA
 {
 	SCOPE_CYCLE_COUNTER(STAT_NavSvoGenerator_MarkDirtyTiles);
 
+	// Geometry gathered by other nav data may be out of date now
+	if (!Config.VoxelizationGroup.IsNone())
+	{
+		FNavSvoTileGenerator::ResetSharedTiles(GetWorld());
+	}
+
+	// Areas are dirtied when elements are updated in the navigation octree, which replaces
+	// their data, so this is when any geometry we've cached for them goes stale.
+	FNavSvoGeometryCache::Get().RemoveStale();
+
 	const bool bGameStaticNavData = IsGameStaticNavData();
 
 	const FEditableSvo* Octree = GetOctree();
@@ -723,8 +955,10 @@ void FNavSvoGenerator::MarkDirtyTiles(const TArray<FNavigationDirtyArea>& DirtyA
 	FBox OctreeBounds;
 	Octree->GetBounds(OctreeBounds);
 
-	// Collect all nodes that need to be regenerated
-	TSet<FPendingTile> DirtyTiles;
+	// Make sure new tiles are prioritized for where the players are now
+	UpdatePendingTilePriorities();
+
+	// Queue all tiles that need to be regenerated
 	for (const FNavigationDirtyArea& DirtyArea : DirtyAreas)
 	{
 		// Store flags for readability.
@@ -831,9 +1065,15 @@ void FNavSvoGenerator::MarkDirtyTiles(const TArray<FNavigationDirtyArea>& DirtyA
 		{
 			FIntVector TileCoord = CoordIter.GetCoord();
 
+			FVector TileLocation = FSvoUtils::CoordToLocation(Config.GetSeedLocation(), TileCoord, Config.GetTileResolution());
+			FBox TileBounds = FBox::BuildAABB(TileLocation, Config.GetTileExtent());
+
+			// Changes to the navigation bounds can affect the whole tile, but for anything
+			// else only the part of the tile the (padded) area overlaps is dirty.
+			const FBox DirtyBounds = bIsNavigationBounds ? FBox(ForceInit) : AdjustedAreaBounds.Overlap(TileBounds);
+
 			// Check if the tile is already pending.  If not, see if it passes the test to be added.
-			FPendingTile* DirtyTile = DirtyTiles.Find(TileCoord);
-			if (DirtyTile == nullptr)
+			if (!PendingTileBounds.Contains(TileCoord))
 			{
 				// Test if the if the tile is active.  It is possible that building will be restricted to only the active tiles.
 				// If not restricted then all tiles will pass this test.
@@ -847,50 +1087,50 @@ void FNavSvoGenerator::MarkDirtyTiles(const TArray<FNavigationDirtyArea>& DirtyA
 				// 'bNeedsTileTest' will always be false for areas that are not navigable bounds.
 				if (bNeedsTileIntersectionTest)
 				{
-					FVector TileLocation = FSvoUtils::CoordToLocation(Config.GetSeedLocation(), TileCoord, Config.GetTileResolution());
-					FBox TileBounds = FBox::BuildAABB(TileLocation, Config.GetTileExtent());
-
 					if (!FGunfire3DNavigationUtils::AABBIntersectsAABBs(TileBounds, InclusionBounds))
 					{
 						continue;
 					}
 				}
 
-				// Create a new pending tile entry and add it to the list of dirty tiles
-				FPendingTile NewDirtyTile(TileCoord);
-
-				FSetElementId NewDirtyTileIdx = DirtyTiles.Add(NewDirtyTile);
-				DirtyTile = &DirtyTiles[NewDirtyTileIdx];
 			}
+
+			AddPendingTile(TileCoord, DirtyBounds);
 		}
 	}
+}
 
-	if (DirtyTiles.Num() > 0)
+void FNavSvoGenerator::AddPendingTile(const FIntVector& TileCoord, const FBox& DirtyBounds)
+{
+	if (FBox* PendingBounds = PendingTileBounds.Find(TileCoord))
 	{
-		// Merge all pending tiles into one container
-		for (const FPendingTile& PendingTile : PendingTiles)
-		{
-			FPendingTile* DirtyTile = DirtyTiles.Find(PendingTile);
-			if (!DirtyTile)
-			{
-				DirtyTiles.Add(PendingTile);
-			}
-		}
+		// Grow the dirty part of the tile to include the new dirty area
+		*PendingBounds = (PendingBounds->IsValid && DirtyBounds.IsValid) ? (*PendingBounds + DirtyBounds) : FBox(ForceInit);
+		return;
+	}
 
-		// Dump results into array
-		PendingTiles.Empty(DirtyTiles.Num());
-		for (const FPendingTile& DirtyTile : DirtyTiles)
-		{
-			PendingTiles.Add(DirtyTile);
-		}
+	PendingTileBounds.Add(TileCoord, DirtyBounds);
+	PendingTiles.HeapPush(FPendingTile(TileCoord, CalcSeedDistance(TileCoord)));
+}
+
+float FNavSvoGenerator::CalcSeedDistance(const FIntVector& TileCoord) const
+{
+	const FVector TileCenter = FSvoUtils::CoordToLocation(Config.GetSeedLocation(), TileCoord, Config.GetTileResolution());
 
-		// Now sort all pending tiles based on distance from players
-		SortPendingTiles();
+	float SeedDistance = MAX_flt;
+
+	for (const FVector& SeedLocation : PendingTileSeeds)
+	{
+		SeedDistance = FMath::Min(SeedDistance, (float)FVector::DistSquared(TileCenter, SeedLocation));
 	}
+
+	return SeedDistance;
 }
 
-void FNavSvoGenerator::SortPendingTiles()
+void FNavSvoGenerator::UpdatePendingTilePriorities(bool bForce)
 {
+	SCOPE_CYCLE_COUNTER(STAT_NavSvoGenerator_UpdatePendingTilePriorities);
+
 	TArray<FVector> SeedLocations;
 
 	// Collect all player positions to be used as seeds for sorting.
@@ -905,23 +1145,30 @@ void FNavSvoGenerator::SortPendingTiles()
 		SeedLocations.Add(FVector::ZeroVector);
 	}
 
-	// Calculate shortest distances between tiles and players
-	for (FPendingTile& PendingTile : PendingTiles)
+	// Re-prioritizing touches every pending tile, so only bother once a player has moved
+	// far enough to change which tiles are nearest by a meaningful amount.
+	bool bSeedsMoved = bForce || (SeedLocations.Num() != PendingTileSeeds.Num());
+
+	const float MaxSeedMoveSq = FMath::Square(Config.GetTileResolution());
+
+	for (int32 SeedIdx = 0; SeedIdx < SeedLocations.Num() && !bSeedsMoved; ++SeedIdx)
 	{
-		FVector TileCenter = FSvoUtils::CoordToLocation(Config.GetSeedLocation(), PendingTile, Config.GetTileResolution());
+		bSeedsMoved = FVector::DistSquared(SeedLocations[SeedIdx], PendingTileSeeds[SeedIdx]) > MaxSeedMoveSq;
+	}
 
-		for (FVector SeedLocation : SeedLocations)
-		{
-			const float DistSq = FVector::DistSquared(TileCenter, SeedLocation);
-			if (DistSq < PendingTile.SeedDistance)
-			{
-				PendingTile.SeedDistance = DistSq;
-			}
-		}
+	if (!bSeedsMoved)
+	{
+		return;
+	}
+
+	PendingTileSeeds = MoveTemp(SeedLocations);
+
+	for (FPendingTile& PendingTile : PendingTiles)
+	{
+		PendingTile.SeedDistance = CalcSeedDistance(PendingTile);
 	}
 
-	// nearest tiles should be at the end of the list
-	PendingTiles.Sort();
+	PendingTiles.Heapify();
 }
 
 bool FNavSvoGenerator::IsGameStaticNavData() const
@@ -931,7 +1178,26 @@ bool FNavSvoGenerator::IsGameStaticNavData() const
 
 bool FNavSvoGenerator::IsTileWhitelisted(const FIntVector& TileCoord) const
 {
-	return (!bRestrictBuildingToActiveTiles || WhitelistedTiles.Contains(TileCoord));
+	return IsTileInShard(TileCoord) && (!bRestrictBuildingToActiveTiles || WhitelistedTiles.Contains(TileCoord));
+}
+
+void FNavSvoGenerator::SetTileShard(int32 InNumShards, int32 InShardIdx)
+{
+	NumTileShards = FMath::Max(InNumShards, 1);
+	TileShardIdx = FMath::Clamp(InShardIdx, 0, NumTileShards - 1);
+}
+
+bool FNavSvoGenerator::IsTileInShard(const FIntVector& TileCoord) const
+{
+	if (NumTileShards <= 1)
+	{
+		return true;
+	}
+
+	// Shard by 4x4x4 blocks of tiles rather than individual tiles, so the geometry
+	// gathered for a tile is mostly shared with the others in its shard.
+	const FIntVector BlockCoord(TileCoord.X >> 2, TileCoord.Y >> 2, TileCoord.Z >> 2);
+	return (int32)(GetTypeHash(BlockCoord) % (uint32)NumTileShards) == TileShardIdx;
 }
 
 void FNavSvoGenerator::RestrictBuildingToActiveTiles(bool bInRestrictBuildingToActiveTiles)
@@ -965,6 +1231,7 @@ uint32 FNavSvoGenerator::LogMemUsed() const
 	MemUsed += WhitelistedTiles.GetAllocatedSize();
 	MemUsed += InclusionBounds.GetAllocatedSize();
 	MemUsed += PendingTiles.GetAllocatedSize();
+	MemUsed += PendingTileBounds.GetAllocatedSize();
 	MemUsed += RunningGenerators.GetAllocatedSize();
 
 	UE_LOG(LogNavigation, Warning, TEXT("    FNavSvoGenerator: %u\n    self: %d"), MemUsed, sizeof(FNavSvoGenerator));
@@ -84,6 +84,15 @@ public:
 	// the ones that are already active in the octree.
 	void RestrictBuildingToActiveTiles(bool bInRestrictBuildingToActiveTiles);
 
+	// Restricts building to one shard of the tiles, so a full build can be split across
+	// several processes and merged afterwards. Tiles are assigned to shards in small
+	// blocks, so each shard builds neighboring tiles together. A 'InNumShards' of one or
+	// less builds every tile.
+	void SetTileShard(int32 InNumShards, int32 InShardIdx);
+
+	// Returns true if the tile belongs to the shard being built (see 'SetTileShard')
+	bool IsTileInShard(const FIntVector& TileCoord) const;
+
 private:
 	// Creates a new octree and assigns it to the 'Owner'
 	void ConstructOctree();
@@ -94,7 +103,23 @@ private:
 	// Starts new tasks and processes results from finished tasks
 	int32 TickBuildTasks(const int32 MaxTasksToSubmit);
 
-	void ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksToSubmit, const uint64 EndCycle);
+	// Returns how many generator tasks can run at once, and how long (in ms) we can spend
+	// on the game thread each tick
+	int32 GetMaxTasks() const;
+	double GetMaxTimePerTick() const;
+
+	// Raises or lowers the task count and time per tick used when adaptive concurrency
+	// is enabled, depending on how busy the game thread and workers were last frame.
+	void UpdateAdaptiveConcurrency();
+
+	// Returns true if ticking the build tasks would do anything, which may include
+	// modifying the octree
+	bool HasBuildWork() const;
+
+	// Gathers geometry for pending tiles and submits build tasks for them. Tiles found to
+	// have nothing to build are only removed from the octree if 'bCanWriteOctree' is set,
+	// otherwise they're left pending for next time.
+	void ProcessPendingTiles(FEditableSvo* Octree, int32 MaxTasksToSubmit, const uint64 EndCycle, bool bCanWriteOctree);
 
 	// If we have a pending generator and it's ready to go, start it
 	bool TryRunPendingGenerator(bool ForceStart = false);
@@ -108,8 +133,16 @@ private:
 	// Marks nodes within the octree that are affected by the specified areas
 	void MarkDirtyTiles(const TArray<FNavigationDirtyArea>& DirtyAreas);
 
-	// Sorts all pending tiles by distance from players
-	void SortPendingTiles();
+	// Queues a tile to be rebuilt, or grows the dirty part of it if it's already queued.
+	// An invalid 'DirtyBounds' means the whole tile is dirty.
+	void AddPendingTile(const FIntVector& TileCoord, const FBox& DirtyBounds);
+
+	// Re-prioritizes the pending tiles if the players have moved far enough since they
+	// were last prioritized (or 'bForce' is set).
+	void UpdatePendingTilePriorities(bool bForce = false);
+
+	// Returns the squared distance from a tile to the nearest player
+	float CalcSeedDistance(const FIntVector& TileCoord) const;
 
 	// Determines if the specified tile is in the set of tiles that should be built.
 	// NOTE: Can be restricted.  See 'RestrictBuildingToActiveTiles'.
@@ -133,19 +166,32 @@ private:
 	// be built.
 	TSet<FIntVector> WhitelistedTiles;
 
+	// The shard of the tiles being built, see 'SetTileShard'
+	int32 NumTileShards = 1;
+	int32 TileShardIdx = 0;
+
 	// Bounding geometry definition
 	TArray<FBox> InclusionBounds;
 
 	// Pending tiles are tiles that are in queue to be rebuilt.
 	struct FPendingTile : FIntVector
 	{
+		// Squared distance to the nearest player
 		float SeedDistance;
 
-		FPendingTile(const FIntVector& InCoord) : FIntVector(InCoord), SeedDistance(MAX_flt) {}
-		bool operator<(const FPendingTile& Other) const { return Other.SeedDistance < SeedDistance; }
+		FPendingTile(const FIntVector& InCoord, float InSeedDistance) : FIntVector(InCoord), SeedDistance(InSeedDistance) {}
+		bool operator<(const FPendingTile& Other) const { return SeedDistance < Other.SeedDistance; }
 	};
+
+	// Heap of the pending tiles, with the one nearest a player on top
 	TStatArray<FPendingTile> PendingTiles;
 
+	// Part of each pending tile that's dirty. Invalid if the whole tile needs to be rebuilt.
+	TMap<FIntVector, FBox> PendingTileBounds;
+
+	// Player locations the pending tiles were last prioritized for
+	TArray<FVector> PendingTileSeeds;
+
 	// The next generator, that we are currently gathering geometry for
 	FNavSvoTileGenerator* PendingGenerator = nullptr;
 
@@ -164,4 +210,19 @@ private:
 
 	// Tile generators which have completed
 	TArray<TSharedRef<FNavSvoTileGenerator>> CompletedGenerators;
+
+	// Tiles rebuilt or removed this tick, whose paths need to be invalidated
+	TArray<uint32> ChangedTileIDs;
+
+	// Limits picked by the adaptive concurrency. The task count is fractional so it can
+	// be raised gradually.
+	float AdaptiveMaxTasks = 0.f;
+	float AdaptiveMaxTimePerTick = 0.f;
+
+	// Smoothed game thread time, and how long finished tasks waited for a worker, in ms
+	float SmoothedGameThreadTime = 0.f;
+	float SmoothedTaskQueueTime = 0.f;
+
+	// Set if the last tick ran out of time before it finished its work
+	bool bLastTickHitTimeLimit = false;
 };
\ No newline at end of file
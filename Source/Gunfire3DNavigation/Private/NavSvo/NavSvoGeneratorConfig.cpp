@@ -15,6 +15,7 @@
 FNavSvoGeneratorConfig::FNavSvoGeneratorConfig(const FVector& InSeedLocation, const AGunfire3DNavData* InNavDataActor)
 	: FSvoConfig(InSeedLocation, InNavDataActor->VoxelSize, InNavDataActor->TilePoolSize, InNavDataActor->TileLayerIndex)
 	, bDoAsyncGeometryGathering(InNavDataActor->bDoAsyncGeometryGathering)
+	, VoxelizationGroup(InNavDataActor->VoxelizationGroup)
 {
 	float AgentHalfHeightFloat = InNavDataActor->GetConfig().AgentHeight * 0.5f;
 	float AgentRadiusFloat = InNavDataActor->GetConfig().AgentRadius;
@@ -22,13 +23,18 @@ FNavSvoGeneratorConfig::FNavSvoGeneratorConfig(const FVector& InSeedLocation, co
 	AgentHalfHeight = FMath::CeilToInt(AgentRadiusFloat / GetVoxelSize());
 	AgentRadius = FMath::CeilToInt(AgentHalfHeightFloat / GetVoxelSize());
 
+	const uint32 ActualLeafNodesPerAxis = FMath::RoundToInt(GetTileResolution() / GetLeafResolution());
+
+	// Clearance can only be measured as far as the geometry we gather around the tile,
+	// which is limited to half a tile so the padding fits in the voxel grid.
+	const uint32 MaxClearanceVoxels = FMath::Min<uint32>((ActualLeafNodesPerAxis * SVO_VOXEL_GRID_EXTENT / 2) - 1, MAX_uint8 - 1);
+	MaxClearance = FMath::Min<uint32>(FMath::CeilToInt(InNavDataActor->MaxClearance / GetVoxelSize()), MaxClearanceVoxels);
+
 	// We need enough padding to handle whichever axis needs the most, XY, or Z.
-	const uint32 NumPaddingVoxels = FMath::Max(AgentHalfHeight, AgentRadius);
+	const uint32 NumPaddingVoxels = FMath::Max3(AgentHalfHeight, AgentRadius, MaxClearance);
 	// To make all our math easier, round the number of padding voxels up to a leaf size
 	const uint32 MinNumPaddingLeaves = (NumPaddingVoxels / SVO_VOXEL_GRID_EXTENT) + 1;
 
-	const uint32 ActualLeafNodesPerAxis = FMath::RoundToInt(GetTileResolution() / GetLeafResolution());
-
 	// Round up the number of leaf nodes we need to the next power of two. This is pretty
 	// wasteful since typically we'll just need two extra leaf nodes (one to pad each
 	// side), but for the Morton code range to be contiguous we need the number to be a
@@ -38,9 +44,9 @@ FNavSvoGeneratorConfig::FNavSvoGeneratorConfig(const FVector& InSeedLocation, co
 	NumUnusedPaddingLeafNodes = ActualLeafNodesPerAxis - (MinNumPaddingLeaves * 2);
 
 	// Expand our bounds by the agent radius and half height so we'll gather data that can
-	// generate padding in our tile.
-	const float XYPadding = GetVoxelSize() * AgentRadius;
-	const float ZPadding = GetVoxelSize() * AgentHalfHeight;
+	// generate padding in our tile, or affect its clearance.
+	const float XYPadding = GetVoxelSize() * FMath::Max(AgentRadius, MaxClearance);
+	const float ZPadding = GetVoxelSize() * FMath::Max(AgentHalfHeight, MaxClearance);
 	BoundsPadding.Set(XYPadding, XYPadding, ZPadding);
 
 	const FIntVector MinLeafNode(NumUnusedPaddingLeafNodes / 2);
@@ -15,6 +15,10 @@ struct FNavSvoGeneratorConfig : FSvoConfig
 	uint32 AgentHalfHeight;
 	uint32 AgentRadius;
 
+	// The furthest clearance from geometry stored in the tiles, in voxels (see
+	// AGunfire3DNavData::MaxClearance)
+	uint32 MaxClearance;
+
 	// The total number of leaf nodes per axis, including padding nodes
 	uint32 NumLeafNodesPerAxis;
 	// The number of leaf nodes that are padding.
@@ -30,4 +34,7 @@ struct FNavSvoGeneratorConfig : FSvoConfig
 	FVector BoundsPadding;
 
 	bool bDoAsyncGeometryGathering;
+
+	// Nav data with the same group share voxelized tiles (see AGunfire3DNavData)
+	FName VoxelizationGroup;
 };
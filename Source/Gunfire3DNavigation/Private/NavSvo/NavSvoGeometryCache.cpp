@@ -0,0 +1,134 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoGeometryCache.h"
+
+#include "StatArray.h"
+
+DECLARE_CYCLE_STAT(TEXT("FindOrAdd (FNavSvoGeometryCache)"), STAT_FNavSvoGeometryCache_FindOrAdd, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RemoveStale (FNavSvoGeometryCache)"), STAT_FNavSvoGeometryCache_RemoveStale, STATGROUP_Gunfire3DNavigation);
+
+DECLARE_MEMORY_STAT(TEXT("Cached Geometry (FNavSvoGeometryCache)"), STAT_FNavSvoGeometryCache_CachedGeometry, STATGROUP_Gunfire3DNavigation);
+
+TAutoConsoleVariable<bool> CVarNavSvoGeometryCache(TEXT("NavSvo.GeometryCache"), true, TEXT("Keeps the triangles extracted from static collision geometry between tile builds."), ECVF_Cheat);
+
+FNavSvoGeometryCache::FEntry::FEntry(const TNavigationData& InElement, FNavSvoCachedGeometryRef InGeometry)
+	: Element(InElement)
+	, CollisionData(InElement->CollisionData.GetData())
+	, CollisionDataSize(InElement->CollisionData.Num())
+	, Geometry(MoveTemp(InGeometry))
+{}
+
+bool FNavSvoGeometryCache::FEntry::IsValidFor(const FNavigationRelevantData* ElementData) const
+{
+	// If the element the entry was built from is gone, this is a new element that was
+	// allocated at the same address.
+	TSharedPtr<FNavigationRelevantData, ESPMode::ThreadSafe> PinnedElement = Element.Pin();
+
+	return
+		PinnedElement.Get() == ElementData &&
+		ElementData->CollisionData.GetData() == CollisionData &&
+		ElementData->CollisionData.Num() == CollisionDataSize;
+}
+
+FNavSvoGeometryCache& FNavSvoGeometryCache::Get()
+{
+	static FNavSvoGeometryCache Cache;
+	return Cache;
+}
+
+bool FNavSvoGeometryCache::IsEnabled()
+{
+	return CVarNavSvoGeometryCache.GetValueOnAnyThread();
+}
+
+FNavSvoCachedGeometryRef FNavSvoGeometryCache::FindOrAdd(const TNavigationData& ElementData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FNavSvoGeometryCache_FindOrAdd);
+
+	const FNavigationRelevantData* Key = &ElementData.Get();
+
+	{
+		FReadScopeLock ReadLock(Lock);
+
+		const FEntry* Entry = Entries.Find(Key);
+		if (Entry && Entry->IsValidFor(Key))
+		{
+			return Entry->Geometry;
+		}
+	}
+
+	// Extract the triangles outside the lock, so other threads can keep using the cache.
+	// If two threads build the same element at once they'll both end up with the same
+	// triangles, so it doesn't matter whose are kept.
+	TSharedRef<FNavSvoCachedGeometry, ESPMode::ThreadSafe> Geometry = MakeShared<FNavSvoCachedGeometry, ESPMode::ThreadSafe>();
+	FNavigationOctreeCollider::ExtractTriangles(ElementData->CollisionData, Geometry->Triangles);
+
+	for (const FNavigationOctreeCollider::FTriangle& Tri : Geometry->Triangles)
+	{
+		Geometry->Bounds += Tri.Vertices[0];
+		Geometry->Bounds += Tri.Vertices[1];
+		Geometry->Bounds += Tri.Vertices[2];
+	}
+
+	Geometry->Triangles.Shrink();
+
+	FWriteScopeLock WriteLock(Lock);
+
+	if (const FEntry* OldEntry = Entries.Find(Key))
+	{
+		Remove(*OldEntry);
+	}
+
+	const FEntry& NewEntry = Entries.Add(Key, FEntry(ElementData, Geometry));
+
+	const uint32 EntryMemUsed = NewEntry.Geometry->GetMemUsed();
+	MemUsed += EntryMemUsed;
+	INC_DWORD_STAT_BY(STAT_FNavSvoGeometryCache_CachedGeometry, EntryMemUsed);
+	INC_DWORD_STAT_BY(STAT_Gunfire3DNavigation_TotalMemory, EntryMemUsed);
+
+	return NewEntry.Geometry;
+}
+
+void FNavSvoGeometryCache::Remove(const FEntry& Entry)
+{
+	// Tile jobs still referencing the triangles keep them alive until they're done, but
+	// they're no longer counted as part of the cache.
+	const uint32 EntryMemUsed = Entry.Geometry->GetMemUsed();
+	MemUsed -= EntryMemUsed;
+	DEC_DWORD_STAT_BY(STAT_FNavSvoGeometryCache_CachedGeometry, EntryMemUsed);
+	DEC_DWORD_STAT_BY(STAT_Gunfire3DNavigation_TotalMemory, EntryMemUsed);
+}
+
+void FNavSvoGeometryCache::RemoveStale()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FNavSvoGeometryCache_RemoveStale);
+
+	FWriteScopeLock WriteLock(Lock);
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsValidFor(It->Key))
+		{
+			Remove(It->Value);
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FNavSvoGeometryCache::Empty()
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	for (const TPair<const FNavigationRelevantData*, FEntry>& Pair : Entries)
+	{
+		Remove(Pair.Value);
+	}
+
+	Entries.Empty();
+}
+
+uint32 FNavSvoGeometryCache::GetMemUsed() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return MemUsed + Entries.GetAllocatedSize();
+}
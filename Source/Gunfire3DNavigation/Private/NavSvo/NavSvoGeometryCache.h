@@ -0,0 +1,70 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "NavSvoCollider.h"
+
+//
+// Triangles extracted from the collision data of navigation relevant elements, kept
+// between tile builds. Extracting the triangles means converting every vertex back out of
+// Recast's coordinates, so rather than doing it again for every tile an element touches
+// each time one of them is rebuilt, it's done once and every tile job references the same
+// triangles.
+//
+// Entries go stale when their element is updated in the navigation octree, since that
+// replaces the element's relevant data, or when the collision data it holds changes
+// (e.g. lazy gathering). Stale entries are rebuilt the next time they're requested, and
+// released by RemoveStale.
+//
+// NOTE: Thread-safe, since geometry may be gathered on worker threads.
+//
+class GUNFIRE3DNAVIGATION_API FNavSvoGeometryCache
+{
+public:
+	typedef TSharedRef<FNavigationRelevantData, ESPMode::ThreadSafe> TNavigationData;
+
+	static FNavSvoGeometryCache& Get();
+
+	// Returns whether gathering should use the cache (see NavSvo.GeometryCache)
+	static bool IsEnabled();
+
+	// Returns the triangles for an element's collision data, extracting them if they
+	// aren't cached or the cached ones are stale.
+	FNavSvoCachedGeometryRef FindOrAdd(const TNavigationData& ElementData);
+
+	// Releases the triangles of any elements that have been updated or removed
+	void RemoveStale();
+
+	// Releases all cached triangles
+	void Empty();
+
+	// Returns the amount of memory used by the cached triangles
+	uint32 GetMemUsed() const;
+
+private:
+	struct FEntry
+	{
+		TWeakPtr<FNavigationRelevantData, ESPMode::ThreadSafe> Element;
+
+		// Collision data the triangles were extracted from
+		const uint8* CollisionData = nullptr;
+		int32 CollisionDataSize = 0;
+
+		FNavSvoCachedGeometryRef Geometry;
+
+		FEntry(const TNavigationData& InElement, FNavSvoCachedGeometryRef InGeometry);
+
+		// Returns true if the entry was built from this element's current collision data
+		bool IsValidFor(const FNavigationRelevantData* ElementData) const;
+	};
+
+	void Remove(const FEntry& Entry);
+
+	mutable FRWLock Lock;
+
+	// Entries by the element data they were built from. The key is only used to find the
+	// entry, it's never dereferenced without pinning the entry's weak pointer first.
+	TMap<const FNavigationRelevantData*, FEntry> Entries;
+
+	uint32 MemUsed = 0;
+};
@@ -14,13 +14,14 @@ DECLARE_CYCLE_STAT(TEXT("FindReachableNodes"), STAT_FindReachableNodes, STATGROU
 DECLARE_CYCLE_STAT(TEXT("FindClosestReachableNode"), STAT_FindClosestReachableNode, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("FindRandomReachableNode"), STAT_FindRandomReachableNode, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("SearchReachableNode"), STAT_SearchReachableNodes, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("SearchReachableNodeChunks"), STAT_SearchReachableNodeChunks, STATGROUP_Gunfire3DNavigation);
 
 FNavSvoNodeQuery::FNavSvoNodeQuery(const FSparseVoxelOctree& InOctree, int32 MaxSearchNodes, const FVector& InNodeQueryExtent)
 	: Super(InOctree, MaxSearchNodes)
 	, NodeQueryExtent(InNodeQueryExtent)
 {}
 
-FSvoNodeLink FNavSvoNodeQuery::FindClosestNode(const FVector& Origin, FVector* OutClosestPointOnNode)
+FSvoNodeLink FNavSvoNodeQuery::FindClosestNode(const FVector& Origin, FVector* OutClosestPointOnNode, FSvoNodeLink* InOutLocationHint)
 {
 	SCOPE_CYCLE_COUNTER(STAT_FindClosestNode);
 
@@ -33,9 +34,14 @@ FSvoNodeLink FNavSvoNodeQuery::FindClosestNode(const FVector& Origin, FVector* O
 	}
 
 	// First, grab the node at this location and see if it is even blocked to begin with.
-	FSvoNodeLink LocationLink = Octree.GetLinkForLocation(Origin);
+	FSvoNodeLink LocationLink = InOutLocationHint ? Octree.GetLinkForLocationNearHint(*InOutLocationHint, Origin) : Octree.GetLinkForLocation(Origin);
 	if (LocationLink.IsValid())
 	{
+		if (InOutLocationHint != nullptr)
+		{
+			*InOutLocationHint = LocationLink;
+		}
+
 		if (OutClosestPointOnNode != nullptr)
 		{
 			*OutClosestPointOnNode = Origin;
@@ -46,6 +52,20 @@ FSvoNodeLink FNavSvoNodeQuery::FindClosestNode(const FVector& Origin, FVector* O
 
 	const FSvoConfig Config = Octree.GetConfig();
 	const FBox QueryBounds = FBox::BuildAABB(Origin, NodeQueryExtent);
+
+	// Most of the time the closest open space is in the same tile, which the octree may
+	// be able to look up without searching
+	FVector IndexedClosestPoint;
+	if (Octree.FindNearestOpenLink(Origin, QueryBounds, LocationLink, IndexedClosestPoint))
+	{
+		if (OutClosestPointOnNode != nullptr)
+		{
+			*OutClosestPointOnNode = IndexedClosestPoint;
+		}
+
+		return LocationLink;
+	}
+
 	const uint32 MaxSearchNodes = NodePool.GetMaxNodes();
 	uint32 NumNodesSearched = 0;
 
@@ -246,6 +266,49 @@ bool FNavSvoNodeQuery::SearchReachableNodes(const FVector& Origin, float Distanc
 	return bQueryResult;
 }
 
+bool FNavSvoNodeQuery::SearchReachableNodeChunks(const FVector& Origin, float DistanceLimit, int32 InChunkSize, FNavSvoReachableChunkCallback InChunkCallback, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SearchReachableNodeChunks);
+
+	DistanceLimitSqrd = (DistanceLimit * DistanceLimit);
+	ChunkCallback = &InChunkCallback;
+	ChunkSize = FMath::Max(InChunkSize, 1);
+	ChunkNodes.Reset(ChunkSize);
+	ChunkBounds.Reset(ChunkSize);
+
+	bool bQueryResult = SearchNodes(FindClosestNode(Origin), InFilter, InOutResults);
+
+	// Hand over whatever is left, unless the callback already asked to stop
+	if (ChunkCallback != nullptr)
+	{
+		FlushChunk();
+	}
+
+	ChunkCallback = nullptr;
+	return bQueryResult;
+}
+
+bool FNavSvoNodeQuery::FlushChunk()
+{
+	bool bContinue = true;
+
+	if (ChunkNodes.Num() > 0)
+	{
+		bContinue = (*ChunkCallback)(ChunkNodes, ChunkBounds);
+
+		ChunkNodes.Reset();
+		ChunkBounds.Reset();
+	}
+
+	// Nothing else is handed over once the callback has stopped the search
+	if (!bContinue)
+	{
+		ChunkCallback = nullptr;
+	}
+
+	return bContinue;
+}
+
 bool FNavSvoNodeQuery::FindClosestPointInNode(FSvoNodeLink NodeLink, const FVector& Origin, FVector& OutPoint, const FBox* Constraints) const
 {
 	FBox NodeBounds;
@@ -289,6 +352,10 @@ void FNavSvoNodeQuery::ResetForNewQuery()
 	DistanceLimitSqrd = 0.f;
 	bRandomizeCost = false;
 	NodeVisitedCallback.Reset();
+	ChunkCallback = nullptr;
+	ChunkSize = 0;
+	ChunkNodes.Reset();
+	ChunkBounds.Reset();
 }
 
 float FNavSvoNodeQuery::GetHeuristicScale() const
@@ -320,5 +387,17 @@ bool FNavSvoNodeQuery::OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& No
 		return false;
 	}
 
+	if (ChunkCallback != nullptr)
+	{
+		FBox& NodeBounds = ChunkBounds.AddUninitialized_GetRef();
+		Octree.GetBoundsForLink(SearchNode.NodeLink, NodeBounds);
+		ChunkNodes.Add(SearchNode.NodeLink.GetID());
+
+		if (ChunkNodes.Num() >= ChunkSize && !FlushChunk())
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
\ No newline at end of file
@@ -4,15 +4,22 @@
 
 #include "NavSvoQuery.h"
 
-class FNavSvoNodeQuery : public FNavSvoQuery
+typedef TFunctionRef<bool(TArrayView<const NavNodeRef> Nodes, TArrayView<const FBox> NodeBounds)> FNavSvoReachableChunkCallback;
+
+class FNavSvoNodeQuery : public TNavSvoQuery<FNavSvoNodeQuery>
 {
-	typedef FNavSvoQuery Super;
+	typedef TNavSvoQuery<FNavSvoNodeQuery> Super;
+	friend class TNavSvoQuery<FNavSvoNodeQuery>;
 
 public:
 	FNavSvoNodeQuery(const FSparseVoxelOctree& InOctree, int32 MaxSearchNodes, const FVector& InNodeQueryExtent);
 
 	// Finds the closest within the provided extents for the given context
-	FSvoNodeLink FindClosestNode(const FVector& Origin, FVector* OutClosestPointOnNode = nullptr);
+	//
+	// If 'InOutLocationHint' is set, the node it links to is checked first for the origin
+	// (see FSparseVoxelOctree::GetLinkForLocationNearHint), and it's updated with the node
+	// the origin was found in.
+	FSvoNodeLink FindClosestNode(const FVector& Origin, FVector* OutClosestPointOnNode = nullptr, FSvoNodeLink* InOutLocationHint = nullptr);
 
 	// Finds the closest reachable node from the supplied origin.
 	FSvoNodeLink FindClosestReachableNode(const FVector& Origin, float DistanceLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults);
@@ -23,6 +30,11 @@ public:
 	// Collects all reachable nodes from the supplied origin.
 	bool SearchReachableNodes(const FVector& Origin, float DistanceLimit, TFunction<bool(NavNodeRef)> InNodeVisitedCallback, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults);
 
+	// Same as SearchReachableNodes, but hands the visited nodes and their bounds to the
+	// callback in chunks of up to 'ChunkSize', rather than one at a time. Returning false
+	// from the callback stops the search.
+	bool SearchReachableNodeChunks(const FVector& Origin, float DistanceLimit, int32 ChunkSize, FNavSvoReachableChunkCallback InChunkCallback, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults);
+
 	// Returns the point closest to the origin within the bounds of the specified node.
 	bool FindClosestPointInNode(FSvoNodeLink NodeLink, const FVector& Origin, FVector& OutPoint, const FBox* Constraints = nullptr) const;
 
@@ -30,15 +42,19 @@ public:
 	bool FindRandomPointInNode(FSvoNodeLink NodeLink, FVector& OutPoint, const FBox* Constraints = nullptr) const;
 
 private:
-	//~ Begin FNavSvoQuery
+	//~ Begin TNavSvoQuery
 	virtual void ResetForNewQuery() override;
-	virtual FSvoNodeLink GetGoal() const override { return StartNodeLink; }
-	virtual ENavSvoQueryTieBreaker GetCostTieBreaker() const override { return ENavSvoQueryTieBreaker::Nearest; }
-	virtual float GetHeuristicScale() const override;
-	virtual float GetTraversalCost(FSvoNodeLink FromLink, FSvoNodeLink ToLink, const FVector& PortalLocation) const override;
-	virtual bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd) override;
-	virtual bool OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& Node) override;
-	//~ End FNavSvoQuery
+	FSvoNodeLink GetGoal() const { return StartNodeLink; }
+	ENavSvoQueryTieBreaker GetCostTieBreaker() const { return ENavSvoQueryTieBreaker::Nearest; }
+	float GetHeuristicScale() const;
+	float GetTraversalCost(FSvoNodeLink FromLink, FSvoNodeLink ToLink, const FVector& PortalLocation) const;
+	bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd);
+	bool OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& Node);
+	//~ End TNavSvoQuery
+
+	// Hands the nodes gathered so far to the chunk callback. Returns false if the callback
+	// wants the search stopped.
+	bool FlushChunk();
 
 private:
 	// Max distance to search for a node when calling FindClosestNode
@@ -56,4 +72,10 @@ private:
 	// prevents needing to duplicate the filter in cases where the callback is passed in
 	// directly.
 	TFunction<bool(NavNodeRef)> NodeVisitedCallback;
+
+	// Callback for nodes visited by SearchReachableNodeChunks, and the chunk being filled
+	const FNavSvoReachableChunkCallback* ChunkCallback = nullptr;
+	int32 ChunkSize = 0;
+	TArray<NavNodeRef> ChunkNodes;
+	TArray<FBox> ChunkBounds;
 };
\ No newline at end of file
@@ -21,61 +21,139 @@
 
 #include "NavSvoNode.h"
 
+#include "AI/Navigation/NavigationTypes.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
 //////////////////////////////////////////////////////////////////////////
 // NodePool
 //////////////////////////////////////////////////////////////////////////
-FNavSvoNodePool::FNavSvoNodePool(uint32 InMaxNodes, uint32 InHashSize)
-	: First(nullptr)
-	, Next(nullptr)
-	, MaxNodes(InMaxNodes)
-	, HashSize(InHashSize)
+FNavSvoNodePool::FNavSvoNodePool()
+	: Slots(nullptr)
+	, Origin(FVector::ZeroVector)
+	, Generation(1)
+	, NodeCapacity(0)
+	, MaxNodes(0)
+	, HashSize(0)
 	, NodeCount(0)
-{
-	check(FMath::RoundUpToPowerOfTwo(HashSize) == HashSize);
-	check(MaxNodes > 0);
-
-	Nodes.SetNum(MaxNodes);
-	First = static_cast<TNavSvoNodeIndex*>(FMemory::Malloc(sizeof(TNavSvoNodeIndex) * InHashSize));
-	Next = static_cast<TNavSvoNodeIndex*>(FMemory::Malloc(sizeof(TNavSvoNodeIndex) * MaxNodes));
-
-	// Halt execution if allocation fails so we don't stomp valid memory on the next few lines and corrupt memory.
-	check(Next != nullptr && First != nullptr);
+{}
 
-	FMemory::Memset(First, 0xFF, sizeof(TNavSvoNodeIndex) * HashSize);
-	FMemory::Memset(Next, 0xFF, sizeof(TNavSvoNodeIndex) * MaxNodes);
+FNavSvoNodePool::FNavSvoNodePool(uint32 InMaxNodes, uint32 InHashSize)
+	: FNavSvoNodePool()
+{
+	Init(InMaxNodes, InHashSize);
 }
 
 FNavSvoNodePool::~FNavSvoNodePool()
 {
-	FMemory::Free(Next);
-	FMemory::Free(First);
+	FMemory::Free(Slots);
+}
+
+void FNavSvoNodePool::Init(uint32 InMaxNodes, uint32 InHashSize)
+{
+	check(FMath::RoundUpToPowerOfTwo(InHashSize) == InHashSize);
+	check(InMaxNodes > 0);
+
+	if (InMaxNodes > NodeCapacity)
+	{
+		NodeCapacity = InMaxNodes;
+		Nodes.SetNum(NodeCapacity);
+		Details.SetNum(NodeCapacity);
+	}
+
+	// The hash table starts at the requested size and grows as nodes are added, so it
+	// only needs reallocating here if this query is asking for a larger initial size.
+	if (InHashSize > HashSize)
+	{
+		HashSize = InHashSize;
+
+		FMemory::Free(Slots);
+		Slots = static_cast<FHashSlot*>(FMemory::Malloc(sizeof(FHashSlot) * HashSize));
+
+		// Halt execution if allocation fails so we don't stomp valid memory on the next line and corrupt memory.
+		check(Slots != nullptr);
+
+		// Every slot gets stamped with a generation that can't match the current one so
+		// the new slots are all considered empty.
+		FMemory::Memzero(Slots, sizeof(FHashSlot) * HashSize);
+	}
+
+	MaxNodes = InMaxNodes;
+
+	Clear();
 }
 
 void FNavSvoNodePool::Clear()
 {
-	FMemory::Memset(First, 0xFF, sizeof(TNavSvoNodeIndex) * HashSize);
 	NodeCount = 0;
+
+	// Generation zero is reserved for slots that have never been written, so on wrap
+	// around we need to do a real reset of the slot stamps.
+	if (++Generation == 0)
+	{
+		FMemory::Memzero(Slots, sizeof(FHashSlot) * HashSize);
+		Generation = 1;
+	}
+}
+
+void FNavSvoNodePool::GrowHash()
+{
+	const uint32 NewHashSize = FMath::Max(HashSize * 2, 16u);
+
+	FHashSlot* NewSlots = static_cast<FHashSlot*>(FMemory::Malloc(sizeof(FHashSlot) * NewHashSize));
+	check(NewSlots != nullptr);
+	FMemory::Memzero(NewSlots, sizeof(FHashSlot) * NewHashSize);
+
+	// Only the nodes from the current generation are live, and those are exactly the
+	// first 'NodeCount' nodes, so re-insert from the node array rather than scanning
+	// the old table.
+	const uint32 HashMask = NewHashSize - 1;
+	for (uint32 NodeIdx = 0; NodeIdx < NodeCount; ++NodeIdx)
+	{
+		const FSvoNodeLink NodeLink = Nodes[NodeIdx].NodeLink;
+
+		uint32 SlotIdx = HashNodeLink(NodeLink) & HashMask;
+		while (NewSlots[SlotIdx].Generation == Generation)
+		{
+			SlotIdx = (SlotIdx + 1) & HashMask;
+		}
+
+		FHashSlot& Slot = NewSlots[SlotIdx];
+		Slot.NodeLinkID = NodeLink.GetID();
+		Slot.NodeIdx = NodeIdx;
+		Slot.Generation = Generation;
+	}
+
+	FMemory::Free(Slots);
+	Slots = NewSlots;
+	HashSize = NewHashSize;
 }
 
 uint32 FNavSvoNodePool::GetMemUsed() const
 {
-	return sizeof(FNavSvoNode) * MaxNodes
-		+ sizeof(TNavSvoNodeIndex) * MaxNodes
-		+ sizeof(TNavSvoNodeIndex) * HashSize;
+	return (sizeof(FNavSvoNode) + sizeof(FNavSvoNodeDetails)) * NodeCapacity
+		+ sizeof(FHashSlot) * HashSize;
 }
 
 //////////////////////////////////////////////////////////////////////////
 // NodeQueue
 //////////////////////////////////////////////////////////////////////////
-FNavSvoNodeQueue::FNavSvoNodeQueue(uint32 InCapacity)
-	: Heap(nullptr)
-	, Capacity(InCapacity)
+FNavSvoNodeQueue::FNavSvoNodeQueue()
+	: NodePool(nullptr)
+	, Type(EGunfire3DNavOpenListType::BinaryHeap)
+	, Heap(nullptr)
+	, InvBucketWidth(1.f)
+	, MinBucketKey(0)
+	, NumOverflowNodes(0)
+	, MinOverflowKey(MAX_uint32)
+	, Capacity(0)
 	, Size(0)
-{
-	ensureMsgf(Capacity > 0, TEXT("Attempting to create node queue with size of zero!"));
+{}
 
-	Heap = static_cast<FNavSvoNode**>(FMemory::Malloc(sizeof(FNavSvoNode*) * (Capacity + 1)));
-	checkf(Heap, TEXT("Failed to create heap for node queue!"));
+FNavSvoNodeQueue::FNavSvoNodeQueue(uint32 InCapacity, FNavSvoNodePool& InNodePool)
+	: FNavSvoNodeQueue()
+{
+	Init(InCapacity, InNodePool);
 }
 
 FNavSvoNodeQueue::~FNavSvoNodeQueue()
@@ -83,7 +161,189 @@ FNavSvoNodeQueue::~FNavSvoNodeQueue()
 	FMemory::Free(Heap);
 }
 
+void FNavSvoNodeQueue::Init(uint32 InCapacity, FNavSvoNodePool& InNodePool)
+{
+	ensureMsgf(InCapacity > 0, TEXT("Attempting to create node queue with size of zero!"));
+
+	NodePool = &InNodePool;
+
+	if (InCapacity > Capacity || Heap == nullptr)
+	{
+		Capacity = InCapacity;
+
+		Heap = static_cast<FNavSvoNode**>(FMemory::Realloc(Heap, sizeof(FNavSvoNode*) * (Capacity + 1)));
+		checkf(Heap, TEXT("Failed to create heap for node queue!"));
+
+		InitStorage();
+	}
+
+	Clear();
+}
+
+void FNavSvoNodeQueue::SetType(EGunfire3DNavOpenListType InType, float InBucketWidth)
+{
+	Type = InType;
+	InvBucketWidth = 1.f / FMath::Max(InBucketWidth, KINDA_SMALL_NUMBER);
+
+	InitStorage();
+	Clear();
+}
+
+void FNavSvoNodeQueue::Clear()
+{
+	Size = 0;
+	MinBucketKey = 0;
+	NumOverflowNodes = 0;
+	MinOverflowKey = MAX_uint32;
+
+	if (Type == EGunfire3DNavOpenListType::Buckets)
+	{
+		FMemory::Memzero(BucketHeads.GetData(), BucketHeads.Num() * sizeof(TNavSvoNodeIndex));
+	}
+}
+
+void FNavSvoNodeQueue::InitStorage()
+{
+	// Node indices from the pool start at one, since zero is used for none
+	const int32 NumNodeSlots = Capacity + 1;
+
+	// The extra buffers are only allocated once a query asks for a type which needs them,
+	// since most contexts will only ever use one type.
+	if (Type != EGunfire3DNavOpenListType::BinaryHeap && NodeSlots.Num() < NumNodeSlots)
+	{
+		NodeSlots.SetNumUninitialized(NumNodeSlots);
+	}
+
+	if (Type == EGunfire3DNavOpenListType::QuaternaryHeap && QuadHeap.Num() < (int32)Capacity)
+	{
+		QuadHeap.SetNumUninitialized(Capacity);
+	}
+
+	if (Type == EGunfire3DNavOpenListType::Buckets && BucketNext.Num() < NumNodeSlots)
+	{
+		BucketHeads.SetNumZeroed(NumBuckets + 1);
+		BucketNext.SetNumUninitialized(NumNodeSlots);
+		BucketPrev.SetNumUninitialized(NumNodeSlots);
+		BucketKeys.SetNumUninitialized(NumNodeSlots);
+	}
+}
+
+void FNavSvoNodeQueue::RefillBuckets()
+{
+	if (NumOverflowNodes == 0)
+	{
+		MinOverflowKey = MAX_uint32;
+		return;
+	}
+
+	// If the buckets have run dry, restart them from the cheapest overflow node
+	if (Size == NumOverflowNodes)
+	{
+		uint32 MinKey = MAX_uint32;
+		for (TNavSvoNodeIndex NodeIdx = BucketHeads[OverflowBucket]; NodeIdx != 0; NodeIdx = BucketNext[NodeIdx])
+		{
+			MinKey = FMath::Min(MinKey, BucketKeys[NodeIdx]);
+		}
+
+		MinBucketKey = MinKey;
+	}
+
+	// Move over everything that now falls in range of the buckets, and find the cheapest
+	// of what's left.
+	// NOTE: Overflow keys are never below MinBucketKey, since the buckets are refilled
+	// before they pass the cheapest of them.
+	MinOverflowKey = MAX_uint32;
+
+	TNavSvoNodeIndex NodeIdx = BucketHeads[OverflowBucket];
+	while (NodeIdx != 0)
+	{
+		const TNavSvoNodeIndex NextIdx = BucketNext[NodeIdx];
+		const uint32 Key = BucketKeys[NodeIdx];
+		if (Key - MinBucketKey < NumBuckets)
+		{
+			BucketRemove(NodeIdx);
+			BucketInsert(NodeIdx, Key);
+		}
+		else
+		{
+			MinOverflowKey = FMath::Min(MinOverflowKey, Key);
+		}
+		NodeIdx = NextIdx;
+	}
+}
+
 uint32 FNavSvoNodeQueue::GetMemUsed() const
 {
-	return sizeof(FNavSvoNode*) * (Capacity + 1);
-}
\ No newline at end of file
+	return sizeof(FNavSvoNode*) * (Capacity + 1)
+		+ QuadHeap.GetAllocatedSize()
+		+ NodeSlots.GetAllocatedSize()
+		+ BucketHeads.GetAllocatedSize()
+		+ BucketNext.GetAllocatedSize()
+		+ BucketPrev.GetAllocatedSize()
+		+ BucketKeys.GetAllocatedSize();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmarking
+//////////////////////////////////////////////////////////////////////////
+#if !UE_BUILD_SHIPPING
+
+namespace NavSvoNodePoolBenchmark
+{
+	void Run(const TArray<FString>& Args)
+	{
+		const uint32 NumNodes = (Args.Num() > 0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 65536;
+		const int32 NumIterations = (Args.Num() > 1) ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10;
+
+		// Scatter the links across tiles and layers the same way a search would
+		FRandomStream RandomStream(NumNodes);
+		TArray<FSvoNodeLink> NodeLinks;
+		NodeLinks.Reserve(NumNodes);
+		for (uint32 NodeIdx = 0; NodeIdx < NumNodes; ++NodeIdx)
+		{
+			FSvoNodeLink NodeLink;
+			NodeLink.TileID = RandomStream.GetUnsignedInt();
+			NodeLink.LayerIdx = RandomStream.RandRange(0, 3);
+			NodeLink.NodeIdx = RandomStream.RandRange(0, 4095);
+			NodeLink.VoxelIdx = RandomStream.RandRange(0, 63);
+			NodeLinks.Add(NodeLink);
+		}
+
+		FNavSvoNodePool NodePool(NumNodes, FMath::RoundUpToPowerOfTwo(NumNodes / 4));
+
+		double AddSeconds = 0.0;
+		double FindSeconds = 0.0;
+		uint32 NumFound = 0;
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			NodePool.Clear();
+
+			double StartTime = FPlatformTime::Seconds();
+			for (const FSvoNodeLink& NodeLink : NodeLinks)
+			{
+				NodePool.GetNode(NodeLink);
+			}
+			AddSeconds += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			for (const FSvoNodeLink& NodeLink : NodeLinks)
+			{
+				NumFound += (NodePool.FindNode(NodeLink) != nullptr) ? 1 : 0;
+			}
+			FindSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+
+		const double NumOperations = (double)NumNodes * NumIterations;
+		UE_LOG(LogNavigation, Display, TEXT("NavSvo node pool: %u nodes x %d iterations, %u found, hash size %u"), NumNodes, NumIterations, NumFound / NumIterations, NodePool.GetHashSize());
+		UE_LOG(LogNavigation, Display, TEXT("    GetNode: %.2f M/s"), NumOperations / FMath::Max(AddSeconds, SMALL_NUMBER) / 1000000.0);
+		UE_LOG(LogNavigation, Display, TEXT("    FindNode: %.2f M/s"), NumOperations / FMath::Max(FindSeconds, SMALL_NUMBER) / 1000000.0);
+	}
+
+	static FAutoConsoleCommand CmdBenchmark(
+		TEXT("NavSvo.BenchmarkNodePool"),
+		TEXT("Measures search node pool throughput. Usage: NavSvo.BenchmarkNodePool [NumNodes] [NumIterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
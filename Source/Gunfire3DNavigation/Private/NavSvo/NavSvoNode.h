@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "Gunfire3DNavQueryFilter.h"
 #include "SparseVoxelOctree/SparseVoxelOctreeNode.h"
 #include "SparseVoxelOctree/SparseVoxelOctreeUtils.h"
 
@@ -30,33 +31,33 @@ enum ENavSvoNodeFlags
 	NAVSVONODE_CLOSED = 1 << 1,
 };
 
-typedef uint16 TNavSvoNodeIndex;
+typedef uint32 TNavSvoNodeIndex;
 
+// The hot part of a search node. This is everything the open list and the open/closed
+// checks need, kept small so as many nodes as possible share a cache line.
 struct FNavSvoNode
 {
 	FSvoNodeLink NodeLink = SVO_INVALID_NODELINK;
-	uint32 ParentIdx = 0;
-	uint32 Flags = 0;
 
 	float FCost = 0.f;
 	float GCost = 0.f;
 	float Heuristic = MAX_flt;
+	uint8 Flags = 0;
 	ESvoNeighbor Neighbor = ESvoNeighbor::Front;
-	FVector PortalLocation = FVector::ZeroVector;
-	float TravelDistSqrd = 0.f;
+
+	// Area code of the node, if the filter has area costs (see FSvoTile::GetArea)
+	uint8 Area = 0;
 
 	void Reset()
 	{
 		NodeLink = SVO_INVALID_NODELINK;
-		ParentIdx = 0;
-		Flags = 0;
 
 		FCost = 0.f;
 		GCost = 0.f;
 		Heuristic = MAX_flt;
+		Flags = 0;
 		Neighbor = ESvoNeighbor::Front;
-		PortalLocation = FVector::ZeroVector;
-		TravelDistSqrd = 0.f;
+		Area = 0;
 	}
 
 	bool operator >(const FNavSvoNode& RHS) const
@@ -65,14 +66,41 @@ struct FNavSvoNode
 	}
 };
 
+// The cold part of a search node, stored in parallel to the hot nodes. This is only
+// needed once a node is expanded or when the final path is built.
+struct FNavSvoNodeDetails
+{
+	uint32 ParentIdx = 0;
+
+	// Offset of the portal location from the pool origin (see FNavSvoNodePool::SetOrigin)
+	FVector3f PortalOffset = FVector3f::ZeroVector;
+
+	float TravelDistSqrd = 0.f;
+
+	void Reset()
+	{
+		ParentIdx = 0;
+		PortalOffset = FVector3f::ZeroVector;
+		TravelDistSqrd = 0.f;
+	}
+};
+
 class FNavSvoNodePool
 {
 public:
+	FNavSvoNodePool();
 	FNavSvoNodePool(uint32 InMaxNodes, uint32 InHashSize);
 	~FNavSvoNodePool();
 
 	void operator =(const FNavSvoNodePool&) {}
 
+	// Prepares the pool for a query using up to the specified number of nodes. Storage
+	// is only reallocated if more nodes (or hash buckets) are requested than have ever
+	// been requested before.
+	void Init(uint32 InMaxNodes, uint32 InHashSize);
+
+	// Invalidates all nodes in the pool. This only bumps the generation so it's
+	// constant time, regardless of how large the pool is.
 	void Clear();
 
 	inline FNavSvoNode* GetNode(FSvoNodeLink NodeLink);
@@ -82,14 +110,25 @@ public:
 	inline FNavSvoNode* GetNodeAtIndex(uint32 Idx);
 	inline const FNavSvoNode* GetNodeAtIndex(uint32 Idx) const;
 
+	inline FNavSvoNodeDetails& GetDetails(const FNavSvoNode& Node);
+	inline const FNavSvoNodeDetails& GetDetails(const FNavSvoNode& Node) const;
+
+	// Portal locations are stored as float offsets from the origin, which should be set
+	// to somewhere near the search (e.g. the start) so they don't lose precision.
+	void SetOrigin(const FVector& InOrigin) { Origin = InOrigin; }
+	const FVector& GetOrigin() const { return Origin; }
+
+	FVector GetPortalLocation(const FNavSvoNode& Node) const { return Origin + FVector(GetDetails(Node).PortalOffset); }
+	void SetPortalLocation(const FNavSvoNode& Node, const FVector& Location) { GetDetails(Node).PortalOffset = FVector3f(Location - Origin); }
+
+	uint32 GetParentIdx(const FNavSvoNode& Node) const { return GetDetails(Node).ParentIdx; }
+
 	uint32 GetMemUsed() const;
 
 	uint32 GetMaxNodes() const { return MaxNodes; }
 	uint32 GetNodeCount() const { return NodeCount; }
 
 	uint32 GetHashSize() const { return HashSize; }
-	TNavSvoNodeIndex GetFirst(uint32 Bucket) const { return First[Bucket]; }
-	TNavSvoNodeIndex GetNext(uint32 NodeIdx) const { return Next[NodeIdx]; }
 
 private:
 	static uint32 HashNodeLink(FSvoNodeLink NodeLink)
@@ -106,40 +145,131 @@ private:
 		return static_cast<uint32>(ID);
 	}
 
+	// Doubles the size of the hash table and re-inserts every node in the pool
+	void GrowHash();
+
 private:
+	// An entry in the open-addressed hash table. The link is stored alongside the index
+	// so probing never has to touch the nodes themselves.
+	struct FHashSlot
+	{
+		uint64 NodeLinkID;
+		TNavSvoNodeIndex NodeIdx;
+
+		// The generation the slot was last written in. Slots from an older generation
+		// are treated as empty, which is what allows Clear to skip the memset.
+		uint32 Generation;
+	};
+
 	TArray<FNavSvoNode> Nodes;
-	TNavSvoNodeIndex* First;
-	TNavSvoNodeIndex* Next;
-	const uint32 MaxNodes;
-	const uint32 HashSize;
+	TArray<FNavSvoNodeDetails> Details;
+	FHashSlot* Slots;
+	FVector Origin;
+	uint32 Generation;
+
+	// Allocated number of nodes, which may be larger than what the current query is
+	// using.
+	uint32 NodeCapacity;
+
+	uint32 MaxNodes;
+	uint32 HashSize;
 	uint32 NodeCount;
 };
 
+//
+// Priority queue of open nodes, ordered by their FCost. Which implementation backs the
+// queue can be changed between searches (see EGunfire3DNavOpenListType).
+//
 class FNavSvoNodeQueue
 {
 public:
-	FNavSvoNodeQueue(uint32 InCapacity);
+	FNavSvoNodeQueue();
+	FNavSvoNodeQueue(uint32 InCapacity, FNavSvoNodePool& InNodePool);
 	~FNavSvoNodeQueue();
 	void operator =(FNavSvoNodeQueue&) {}
 
-	void Clear() { Size = 0; }
+	// Ensures the queue can hold at least the specified number of nodes from the pool.
+	// The buffers are only reallocated when they need to grow.
+	void Init(uint32 InCapacity, FNavSvoNodePool& InNodePool);
+
+	// Selects the implementation used for the next search and clears the queue. Costs
+	// within 'InBucketWidth' of each other share a bucket (Buckets only).
+	void SetType(EGunfire3DNavOpenListType InType, float InBucketWidth);
+	EGunfire3DNavOpenListType GetType() const { return Type; }
+
+	void Clear();
 	bool IsEmpty() const { return (Size == 0); }
 
-	FNavSvoNode* Top() { return Heap[0]; }
+	inline FNavSvoNode* Top();
 	inline FNavSvoNode* Pop();
 	inline void Push(FNavSvoNode* Node);
-	inline void Modify(FNavSvoNode* Node) const;
+	inline void Modify(FNavSvoNode* Node);
 
 	uint32 GetMemUsed() const;
 
 	uint32 GetCapacity() const { return Capacity; }
 
 private:
+	static constexpr uint32 NumBuckets = 1024;
+	static constexpr uint32 BucketMask = NumBuckets - 1;
+	static constexpr uint32 OverflowBucket = NumBuckets;
+
+	struct FHeapEntry
+	{
+		float FCost;
+		TNavSvoNodeIndex NodeIdx;
+	};
+
+	// Allocates the buffers needed by the current type
+	void InitStorage();
+
+	// BinaryHeap
 	inline void BubbleUp(uint32 NodeID, FNavSvoNode* Node) const;
 	inline void TrickleDown(uint32 NodeID, FNavSvoNode* Node) const;
 
+	// QuaternaryHeap
+	inline void QuadBubbleUp(uint32 HeapIdx, FHeapEntry Entry);
+	inline void QuadTrickleDown(uint32 HeapIdx, FHeapEntry Entry);
+
+	// Buckets
+	inline uint32 GetBucketKey(float FCost) const;
+	inline void BucketInsert(TNavSvoNodeIndex NodeIdx, uint32 Key);
+	inline void BucketRemove(TNavSvoNodeIndex NodeIdx);
+	inline TNavSvoNodeIndex BucketFindMin();
+
+	// Moves the overflow nodes which now fall in range of the buckets into them, first
+	// restarting the buckets from the cheapest overflow node if they've run dry
+	void RefillBuckets();
+
+	FNavSvoNodePool* NodePool;
+	EGunfire3DNavOpenListType Type;
+
 	FNavSvoNode** Heap;
-	const uint32 Capacity;
+	TArray<FHeapEntry> QuadHeap;
+
+	// Indexed by the pool's node index. Holds the node's position in the 4-ary heap, or
+	// which bucket it's in.
+	TArray<uint32> NodeSlots;
+
+	// Bucket lists, linked through the pool's node indices where zero ends the list.
+	// The heads have an extra bucket at the end for costs which are past the range the
+	// buckets currently cover.
+	TArray<TNavSvoNodeIndex> BucketHeads;
+	TArray<TNavSvoNodeIndex> BucketNext;
+	TArray<TNavSvoNodeIndex> BucketPrev;
+	TArray<uint32> BucketKeys;
+
+	float InvBucketWidth;
+
+	// The key of the cheapest bucket which may still hold nodes
+	uint32 MinBucketKey;
+	uint32 NumOverflowNodes;
+
+	// No greater than the key of any overflow node (MAX_uint32 if there are none). It isn't
+	// raised when overflow nodes are removed, which only means refilling a little early.
+	uint32 MinOverflowKey;
+
+	uint32 Capacity;
 	uint32 Size;
 };
 
@@ -154,36 +284,59 @@ FNavSvoNode* FNavSvoNodePool::GetNode(FSvoNodeLink NodeLink)
 		return nullptr;
 	}
 
-	const uint32 Bucket = HashNodeLink(NodeLink) & (HashSize - 1);
-	TNavSvoNodeIndex NodeIdx = First[Bucket];
-	FNavSvoNode* Node = nullptr;
+	// Keep the table at most half full so probe sequences stay short
+	if ((NodeCount + 1) * 2 > HashSize)
+	{
+		GrowHash();
+	}
 
-	NodeIdx = static_cast<TNavSvoNodeIndex>(NodeCount);
+	// Claim the first slot that hasn't been written since the last clear
+	const uint32 HashMask = HashSize - 1;
+	uint32 SlotIdx = HashNodeLink(NodeLink) & HashMask;
+	while (Slots[SlotIdx].Generation == Generation)
+	{
+		SlotIdx = (SlotIdx + 1) & HashMask;
+	}
+
+	const TNavSvoNodeIndex NodeIdx = NodeCount;
 	++NodeCount;
 
+	FHashSlot& Slot = Slots[SlotIdx];
+	Slot.NodeLinkID = NodeLink.GetID();
+	Slot.NodeIdx = NodeIdx;
+	Slot.Generation = Generation;
+
 	// Init node
-	Node = &Nodes[NodeIdx];
+	FNavSvoNode* Node = &Nodes[NodeIdx];
 	Node->Reset();
 	Node->NodeLink = NodeLink;
-
-	Next[NodeIdx] = First[Bucket];
-	First[Bucket] = NodeIdx;
+	Details[NodeIdx].Reset();
 
 	return Node;
 }
 
 FNavSvoNode* FNavSvoNodePool::FindNode(FSvoNodeLink NodeLink)
 {
-	const uint32 Bucket = HashNodeLink(NodeLink) & (HashSize - 1);
-	TNavSvoNodeIndex NodeIdx = First[Bucket];
-	while (NodeIdx != static_cast<TNavSvoNodeIndex>(~0))
+	if (HashSize == 0)
+	{
+		return nullptr;
+	}
+
+	// NOTE: The table is never allowed to fill up, so there's always an empty slot to end
+	// the probe on.
+	const uint64 NodeLinkID = NodeLink.GetID();
+	const uint32 HashMask = HashSize - 1;
+	uint32 SlotIdx = HashNodeLink(NodeLink) & HashMask;
+	while (Slots[SlotIdx].Generation == Generation)
 	{
-		if (Nodes[NodeIdx].NodeLink == NodeLink)
+		if (Slots[SlotIdx].NodeLinkID == NodeLinkID)
 		{
-			return &Nodes[NodeIdx];
+			return &Nodes[Slots[SlotIdx].NodeIdx];
 		}
-		NodeIdx = Next[NodeIdx];
+
+		SlotIdx = (SlotIdx + 1) & HashMask;
 	}
+
 	return nullptr;
 }
 
@@ -217,33 +370,126 @@ const FNavSvoNode* FNavSvoNodePool::GetNodeAtIndex(uint32 Idx) const
 	return &Nodes[Idx - 1];
 }
 
+FNavSvoNodeDetails& FNavSvoNodePool::GetDetails(const FNavSvoNode& Node)
+{
+	return Details[static_cast<uint32>(&Node - Nodes.GetData())];
+}
+
+const FNavSvoNodeDetails& FNavSvoNodePool::GetDetails(const FNavSvoNode& Node) const
+{
+	return Details[static_cast<uint32>(&Node - Nodes.GetData())];
+}
+
 //////////////////////////////////////////////////////////////////////////
 // NavSvoNodeQueue
 //////////////////////////////////////////////////////////////////////////
 
+FNavSvoNode* FNavSvoNodeQueue::Top()
+{
+	switch (Type)
+	{
+	case EGunfire3DNavOpenListType::QuaternaryHeap:
+		return NodePool->GetNodeAtIndex(QuadHeap[0].NodeIdx);
+
+	case EGunfire3DNavOpenListType::Buckets:
+		return NodePool->GetNodeAtIndex(BucketFindMin());
+
+	default:
+		return Heap[0];
+	}
+}
+
 FNavSvoNode* FNavSvoNodeQueue::Pop()
 {
-	FNavSvoNode* Result = Heap[0];
-	--Size;
-	TrickleDown(0, Heap[Size]);
-	return Result;
+	switch (Type)
+	{
+	case EGunfire3DNavOpenListType::QuaternaryHeap:
+	{
+		const TNavSvoNodeIndex NodeIdx = QuadHeap[0].NodeIdx;
+		--Size;
+		if (Size > 0)
+		{
+			QuadTrickleDown(0, QuadHeap[Size]);
+		}
+		return NodePool->GetNodeAtIndex(NodeIdx);
+	}
+
+	case EGunfire3DNavOpenListType::Buckets:
+	{
+		const TNavSvoNodeIndex NodeIdx = BucketFindMin();
+		BucketRemove(NodeIdx);
+		--Size;
+		return NodePool->GetNodeAtIndex(NodeIdx);
+	}
+
+	default:
+	{
+		FNavSvoNode* Result = Heap[0];
+		--Size;
+		TrickleDown(0, Heap[Size]);
+		return Result;
+	}
+	}
 }
 
 void FNavSvoNodeQueue::Push(FNavSvoNode* Node)
 {
-	++Size;
-	BubbleUp(Size - 1, Node);
+	switch (Type)
+	{
+	case EGunfire3DNavOpenListType::QuaternaryHeap:
+		++Size;
+		QuadBubbleUp(Size - 1, { Node->FCost, NodePool->GetNodeIndex(Node) });
+		break;
+
+	case EGunfire3DNavOpenListType::Buckets:
+		++Size;
+		BucketInsert(NodePool->GetNodeIndex(Node), GetBucketKey(Node->FCost));
+		break;
+
+	default:
+		++Size;
+		BubbleUp(Size - 1, Node);
+		break;
+	}
 }
 
-void FNavSvoNodeQueue::Modify(FNavSvoNode* Node) const
+void FNavSvoNodeQueue::Modify(FNavSvoNode* Node)
 {
-	for (uint32 NodeIdx = 0; NodeIdx < Size; ++NodeIdx)
+	switch (Type)
+	{
+	case EGunfire3DNavOpenListType::QuaternaryHeap:
+	{
+		const FHeapEntry Entry = { Node->FCost, NodePool->GetNodeIndex(Node) };
+		const uint32 HeapIdx = NodeSlots[Entry.NodeIdx];
+		if (HeapIdx > 0 && QuadHeap[(HeapIdx - 1) / 4].FCost > Entry.FCost)
+		{
+			QuadBubbleUp(HeapIdx, Entry);
+		}
+		else
+		{
+			QuadTrickleDown(HeapIdx, Entry);
+		}
+		break;
+	}
+
+	case EGunfire3DNavOpenListType::Buckets:
 	{
-		if (Heap[NodeIdx] == Node)
+		const TNavSvoNodeIndex NodeIdx = NodePool->GetNodeIndex(Node);
+		BucketRemove(NodeIdx);
+		BucketInsert(NodeIdx, GetBucketKey(Node->FCost));
+		break;
+	}
+
+	default:
+		for (uint32 NodeIdx = 0; NodeIdx < Size; ++NodeIdx)
 		{
-			BubbleUp(NodeIdx, Node);
-			return;
+			if (Heap[NodeIdx] == Node)
+			{
+				BubbleUp(NodeIdx, Node);
+				return;
+			}
 		}
+		break;
 	}
 }
 
@@ -275,3 +521,149 @@ void FNavSvoNodeQueue::TrickleDown(uint32 NodeID, FNavSvoNode* Node) const
 	}
 	BubbleUp(NodeID, Node);
 }
+
+void FNavSvoNodeQueue::QuadBubbleUp(uint32 HeapIdx, FHeapEntry Entry)
+{
+	while (HeapIdx > 0)
+	{
+		const uint32 Parent = (HeapIdx - 1) / 4;
+		if (QuadHeap[Parent].FCost <= Entry.FCost)
+		{
+			break;
+		}
+
+		QuadHeap[HeapIdx] = QuadHeap[Parent];
+		NodeSlots[QuadHeap[HeapIdx].NodeIdx] = HeapIdx;
+		HeapIdx = Parent;
+	}
+
+	QuadHeap[HeapIdx] = Entry;
+	NodeSlots[Entry.NodeIdx] = HeapIdx;
+}
+
+void FNavSvoNodeQueue::QuadTrickleDown(uint32 HeapIdx, FHeapEntry Entry)
+{
+	for (;;)
+	{
+		const uint32 FirstChild = (HeapIdx * 4) + 1;
+		if (FirstChild >= Size)
+		{
+			break;
+		}
+
+		// All four children are next to each other, so finding the cheapest only touches
+		// a single cache line.
+		const uint32 LastChild = FMath::Min(FirstChild + 4, Size);
+		uint32 BestChild = FirstChild;
+		for (uint32 Child = FirstChild + 1; Child < LastChild; ++Child)
+		{
+			if (QuadHeap[Child].FCost < QuadHeap[BestChild].FCost)
+			{
+				BestChild = Child;
+			}
+		}
+
+		if (QuadHeap[BestChild].FCost >= Entry.FCost)
+		{
+			break;
+		}
+
+		QuadHeap[HeapIdx] = QuadHeap[BestChild];
+		NodeSlots[QuadHeap[HeapIdx].NodeIdx] = HeapIdx;
+		HeapIdx = BestChild;
+	}
+
+	QuadHeap[HeapIdx] = Entry;
+	NodeSlots[Entry.NodeIdx] = HeapIdx;
+}
+
+uint32 FNavSvoNodeQueue::GetBucketKey(float FCost) const
+{
+	return static_cast<uint32>(FMath::Clamp(FCost * InvBucketWidth, 0.f, static_cast<float>(MAX_uint32 - NumBuckets)));
+}
+
+void FNavSvoNodeQueue::BucketInsert(TNavSvoNodeIndex NodeIdx, uint32 Key)
+{
+	// Scaled heuristics aren't consistent, so a node can end up cheaper than the bucket
+	// being drained. Those just join the current bucket.
+	Key = FMath::Max(Key, MinBucketKey);
+
+	uint32 Bucket = OverflowBucket;
+	if (Key - MinBucketKey < NumBuckets)
+	{
+		Bucket = Key & BucketMask;
+	}
+	else
+	{
+		++NumOverflowNodes;
+		MinOverflowKey = FMath::Min(MinOverflowKey, Key);
+	}
+
+	const TNavSvoNodeIndex HeadIdx = BucketHeads[Bucket];
+	BucketNext[NodeIdx] = HeadIdx;
+	BucketPrev[NodeIdx] = 0;
+	if (HeadIdx != 0)
+	{
+		BucketPrev[HeadIdx] = NodeIdx;
+	}
+
+	BucketHeads[Bucket] = NodeIdx;
+	BucketKeys[NodeIdx] = Key;
+	NodeSlots[NodeIdx] = Bucket;
+}
+
+void FNavSvoNodeQueue::BucketRemove(TNavSvoNodeIndex NodeIdx)
+{
+	const uint32 Bucket = NodeSlots[NodeIdx];
+	const TNavSvoNodeIndex NextIdx = BucketNext[NodeIdx];
+	const TNavSvoNodeIndex PrevIdx = BucketPrev[NodeIdx];
+
+	if (PrevIdx != 0)
+	{
+		BucketNext[PrevIdx] = NextIdx;
+	}
+	else
+	{
+		BucketHeads[Bucket] = NextIdx;
+	}
+
+	if (NextIdx != 0)
+	{
+		BucketPrev[NextIdx] = PrevIdx;
+	}
+
+	if (Bucket == OverflowBucket)
+	{
+		--NumOverflowNodes;
+	}
+}
+
+TNavSvoNodeIndex FNavSvoNodeQueue::BucketFindMin()
+{
+	if (Size == 0)
+	{
+		return 0;
+	}
+
+	if (Size == NumOverflowNodes)
+	{
+		RefillBuckets();
+	}
+
+	// NOTE: Every node outside the overflow has a key within NumBuckets of the minimum,
+	// so this will always find one before wrapping around.
+	while (BucketHeads[MinBucketKey & BucketMask] == 0)
+	{
+		++MinBucketKey;
+
+		// Overflow nodes have to be moved in as soon as the buckets reach their keys,
+		// otherwise nodes pushed later with higher keys would be popped before them.
+		if (MinBucketKey + NumBuckets > MinOverflowKey)
+		{
+			RefillBuckets();
+		}
+	}
+
+	return BucketHeads[MinBucketKey & BucketMask];
+}
+
@@ -0,0 +1,62 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoNodeHints.h"
+
+///> Profiling stats
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Node Hint Hits"), STAT_NodeHints_Hits, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Node Hint Misses"), STAT_NodeHints_Misses, STATGROUP_Gunfire3DNavigation);
+
+FNavSvoNodeHints::FNavSvoNodeHints(int32 InMaxEntries)
+	: Cache(FMath::Max(1, InMaxEntries))
+	, MaxEntries(FMath::Max(1, InMaxEntries))
+{
+}
+
+FSvoNodeLink FNavSvoNodeHints::Find(const UObject* Querier)
+{
+	if (Querier == nullptr)
+	{
+		return SVO_INVALID_NODELINK;
+	}
+
+	FScopeLock ScopeLock(&CacheLock);
+
+	const FSvoNodeLink* NodeLink = Cache.FindAndTouch(FObjectKey(Querier));
+	if (NodeLink == nullptr)
+	{
+		INC_DWORD_STAT(STAT_NodeHints_Misses);
+		return SVO_INVALID_NODELINK;
+	}
+
+	INC_DWORD_STAT(STAT_NodeHints_Hits);
+	return *NodeLink;
+}
+
+void FNavSvoNodeHints::Update(const UObject* Querier, FSvoNodeLink NodeLink)
+{
+	if (Querier == nullptr || !NodeLink.IsValid())
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&CacheLock);
+	Cache.Add(FObjectKey(Querier), NodeLink);
+}
+
+void FNavSvoNodeHints::Empty()
+{
+	FScopeLock ScopeLock(&CacheLock);
+	Cache.Empty(MaxEntries);
+}
+
+int32 FNavSvoNodeHints::Num() const
+{
+	FScopeLock ScopeLock(&CacheLock);
+	return Cache.Num();
+}
+
+uint32 FNavSvoNodeHints::GetMemUsed() const
+{
+	FScopeLock ScopeLock(&CacheLock);
+	return sizeof(*this) + Cache.Num() * (sizeof(FObjectKey) + sizeof(FSvoNodeLink));
+}
@@ -0,0 +1,43 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctree/SparseVoxelOctreeNode.h"
+
+#include "Containers/LruCache.h"
+#include "UObject/ObjectKey.h"
+
+//
+// LRU cache of the node each querier was last found in. Agents tend to query from about
+// the same place every tick, so looking up their node again usually only needs a bounds
+// check against this one or one of its neighbors (see
+// FSparseVoxelOctree::GetLinkForLocationNearHint).
+//
+// Hints are only a starting point for the lookup and are checked against the octree
+// before they're used, so they don't need to be thrown out when it changes.
+//
+// NOTE: Thread-safe, since queries may run on background threads.
+//
+class FNavSvoNodeHints
+{
+public:
+	FNavSvoNodeHints(int32 InMaxEntries);
+
+	// Returns the node the querier was last found in, or an invalid link
+	FSvoNodeLink Find(const UObject* Querier);
+
+	// Remembers the node the querier was found in
+	void Update(const UObject* Querier, FSvoNodeLink NodeLink);
+
+	// Removes all hints
+	void Empty();
+
+	int32 Num() const;
+
+	uint32 GetMemUsed() const;
+
+private:
+	mutable FCriticalSection CacheLock;
+	TLruCache<FObjectKey, FSvoNodeLink> Cache;
+	const int32 MaxEntries;
+};
@@ -0,0 +1,135 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoPathCache.h"
+
+#include "Gunfire3DNavigationUtils.h"
+#include "SparseVoxelOctree/SparseVoxelOctree.h"
+
+///> Profiling stats
+DECLARE_CYCLE_STAT(TEXT("Find (PathCache)"), STAT_PathCache_Find, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Add (PathCache)"), STAT_PathCache_Add, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Cache Hits"), STAT_PathCache_Hits, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Cache Misses"), STAT_PathCache_Misses, STATGROUP_Gunfire3DNavigation);
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoTileVersions
+//////////////////////////////////////////////////////////////////////////
+
+bool FNavSvoTileVersions::Capture(const FSparseVoxelOctree& Octree, TArrayView<const uint32> TileIDs)
+{
+	TileVersions.Reset(TileIDs.Num());
+
+	for (uint32 TileID : TileIDs)
+	{
+		const FSvoTile* Tile = Octree.GetTile(TileID);
+		if (Tile == nullptr)
+		{
+			return false;
+		}
+
+		TileVersions.Add({ TileID, Tile->GetVersion() });
+	}
+
+	return true;
+}
+
+bool FNavSvoTileVersions::IsCurrent(const FSparseVoxelOctree& Octree) const
+{
+	for (const FTileVersion& TileVersion : TileVersions)
+	{
+		const FSvoTile* Tile = Octree.GetTile(TileVersion.TileID);
+		if (Tile == nullptr || Tile->GetVersion() != TileVersion.Version)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoPathCache
+//////////////////////////////////////////////////////////////////////////
+
+FNavSvoPathCache::FNavSvoPathCache(int32 InMaxEntries)
+	: Cache(FMath::Max(1, InMaxEntries))
+	, MaxEntries(FMath::Max(1, InMaxEntries))
+{
+}
+
+bool FNavSvoPathCache::Find(const FNavSvoPathCacheKey& Key, const FSparseVoxelOctree& Octree, float CostLimit, TArray<FNavPathPoint>& OutPathPoints)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PathCache_Find);
+
+	FScopeLock ScopeLock(&CacheLock);
+
+	const FEntry* Entry = Cache.FindAndTouch(Key);
+	if (Entry == nullptr)
+	{
+		INC_DWORD_STAT(STAT_PathCache_Misses);
+		return false;
+	}
+
+	// Throw out paths through tiles that have changed since the path was found
+	if (!Entry->TileVersions.IsCurrent(Octree))
+	{
+		Cache.Remove(Key);
+		INC_DWORD_STAT(STAT_PathCache_Misses);
+		return false;
+	}
+
+	if (CostLimit > 0.f && Entry->PathCost > CostLimit)
+	{
+		INC_DWORD_STAT(STAT_PathCache_Misses);
+		return false;
+	}
+
+	OutPathPoints = Entry->PathPoints;
+
+	INC_DWORD_STAT(STAT_PathCache_Hits);
+	return true;
+}
+
+void FNavSvoPathCache::Add(const FNavSvoPathCacheKey& Key, const FSparseVoxelOctree& Octree, TArrayView<const uint32> TileIDs, const TArray<FNavPathPoint>& PathPoints, float PathCost)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PathCache_Add);
+
+	FEntry Entry;
+	Entry.PathPoints = PathPoints;
+	Entry.PathCost = PathCost;
+
+	// Don't cache paths through tiles we can't track
+	if (!Entry.TileVersions.Capture(Octree, TileIDs))
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&CacheLock);
+	Cache.Add(Key, MoveTemp(Entry));
+}
+
+void FNavSvoPathCache::Empty()
+{
+	FScopeLock ScopeLock(&CacheLock);
+	Cache.Empty(MaxEntries);
+}
+
+int32 FNavSvoPathCache::Num() const
+{
+	FScopeLock ScopeLock(&CacheLock);
+	return Cache.Num();
+}
+
+uint32 FNavSvoPathCache::GetMemUsed() const
+{
+	FScopeLock ScopeLock(&CacheLock);
+
+	uint32 MemUsed = sizeof(*this);
+	for (auto It = Cache.CreateConstIterator(); It; ++It)
+	{
+		const FEntry& Entry = It.Value();
+		MemUsed += sizeof(FEntry) + Entry.PathPoints.GetAllocatedSize() + Entry.TileVersions.GetAllocatedSize();
+	}
+
+	return MemUsed;
+}
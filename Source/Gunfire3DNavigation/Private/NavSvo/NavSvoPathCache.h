@@ -0,0 +1,106 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctree/SparseVoxelOctreeNode.h"
+
+#include "AI/Navigation/NavigationTypes.h"
+#include "Containers/LruCache.h"
+
+class FSparseVoxelOctree;
+
+//
+// Snapshot of the versions of a set of tiles, used to tell whether anything derived from
+// them is out of date.
+//
+struct FNavSvoTileVersions
+{
+	// Records the current version of each tile. Returns false if any of them aren't in
+	// the octree.
+	bool Capture(const FSparseVoxelOctree& Octree, TArrayView<const uint32> TileIDs);
+
+	// Returns true if none of the tiles have been rebuilt or removed since the capture
+	bool IsCurrent(const FSparseVoxelOctree& Octree) const;
+
+	uint32 GetAllocatedSize() const { return TileVersions.GetAllocatedSize(); }
+
+private:
+	struct FTileVersion
+	{
+		uint32 TileID;
+		uint32 Version;
+	};
+
+	TArray<FTileVersion> TileVersions;
+};
+
+struct FNavSvoPathCacheKey
+{
+	FSvoNodeLink StartNodeLink = SVO_INVALID_NODELINK;
+	FSvoNodeLink GoalNodeLink = SVO_INVALID_NODELINK;
+
+	// Hash of the filter used for the query (see FGunfire3DNavQueryFilter::GetHash)
+	uint32 FilterHash = 0;
+
+	// Query flags which change how the path is post-processed (e.g. string pulling)
+	uint32 NavDataFlags = 0;
+
+	bool bHierarchical = false;
+
+	bool operator==(const FNavSvoPathCacheKey& Other) const
+	{
+		return StartNodeLink == Other.StartNodeLink &&
+			GoalNodeLink == Other.GoalNodeLink &&
+			FilterHash == Other.FilterHash &&
+			NavDataFlags == Other.NavDataFlags &&
+			bHierarchical == Other.bHierarchical;
+	}
+
+	friend uint32 GetTypeHash(const FNavSvoPathCacheKey& Key)
+	{
+		uint32 Hash = HashCombine(GetTypeHash(Key.StartNodeLink), GetTypeHash(Key.GoalNodeLink));
+		Hash = HashCombine(Hash, Key.FilterHash);
+		Hash = HashCombine(Hash, HashCombine(Key.NavDataFlags, (uint32)Key.bHierarchical));
+		return Hash;
+	}
+};
+
+//
+// LRU cache of finished paths between pairs of nodes. Each path remembers the version of
+// every tile it passes through, so any path through a tile that has since been rebuilt
+// or removed is discarded the next time it's looked up.
+//
+// NOTE: Thread-safe, since paths may be found on background threads.
+//
+class FNavSvoPathCache
+{
+public:
+	FNavSvoPathCache(int32 InMaxEntries);
+
+	// Copies the cached path for the key into 'OutPathPoints' if there is one that is
+	// still valid and within the cost limit (if > 0).
+	bool Find(const FNavSvoPathCacheKey& Key, const FSparseVoxelOctree& Octree, float CostLimit, TArray<FNavPathPoint>& OutPathPoints);
+
+	// Stores a finished path. 'TileIDs' should contain every tile the path passes
+	// through, their current versions will be looked up from the octree.
+	void Add(const FNavSvoPathCacheKey& Key, const FSparseVoxelOctree& Octree, TArrayView<const uint32> TileIDs, const TArray<FNavPathPoint>& PathPoints, float PathCost);
+
+	// Removes all cached paths
+	void Empty();
+
+	int32 Num() const;
+
+	uint32 GetMemUsed() const;
+
+private:
+	struct FEntry
+	{
+		TArray<FNavPathPoint> PathPoints;
+		FNavSvoTileVersions TileVersions;
+		float PathCost = 0.f;
+	};
+
+	mutable FCriticalSection CacheLock;
+	TLruCache<FNavSvoPathCacheKey, FEntry> Cache;
+	const int32 MaxEntries;
+};
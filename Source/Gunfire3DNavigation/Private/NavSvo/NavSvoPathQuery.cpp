@@ -8,13 +8,16 @@
 #define SVO_NEIGHBOR_MASK 0x7
 
 DECLARE_CYCLE_STAT(TEXT("FindPath (Query)"), STAT_FindPath_Query, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindPath Bidirectional (Query)"), STAT_FindPath_Bidirectional, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("BeginFindPath (Query)"), STAT_BeginFindPath_Query, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("ContinueFindPath (Query)"), STAT_ContinueFindPath_Query, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("TestPath (Query)"), STAT_TestPath_Query, STATGROUP_Gunfire3DNavigation);
 
 FNavSvoPathQuery::FNavSvoPathQuery(const FSparseVoxelOctree& InOctree, int32 MaxSearchNodes)
 	: Super(InOctree, MaxSearchNodes)
 {}
 
-bool FNavSvoPathQuery::FindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults)
+bool FNavSvoPathQuery::FindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults, const TSet<uint32>* InTileCorridor)
 {
 	SCOPE_CYCLE_COUNTER(STAT_FindPath_Query);
 
@@ -29,6 +32,7 @@ bool FNavSvoPathQuery::FindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoa
 	StartNodeLink = InStartNodeLink;
 	GoalNodeLink = InGoalNodeLink;
 	CostLimit = InCostLimit;
+	TileCorridor = InTileCorridor;
 
 	// If the start and end node are the same, just add the end node to the pool
 	if (InStartNodeLink == InGoalNodeLink)
@@ -45,55 +49,262 @@ bool FNavSvoPathQuery::FindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoa
 		return false;
 	}
 
-	// Run query
+	// Run query. Entering costs are charged for whichever area is on the far side of a
+	// change of area, so the reverse search would charge the other area's, and its half
+	// of the path can't be corrected to the forward cost (see GetReverseCostToGoal).
+	if (InFilter.IsBidirectionalSearch() && !InFilter.HasAreaEnteringCosts())
+	{
+		return FindPathBidirectional(InFilter, InOutResults);
+	}
+
 	const bool QueryResult = SearchNodes(InStartNodeLink, InFilter, InOutResults);
 	if (QueryResult)
 	{
-		// If the end was not found, mark that this is only a partial path.
-		if (BestSearchNode->NodeLink != GoalNodeLink)
+		FinishFindPath(InOutResults);
+		return true;
+	}
+
+	return false;
+}
+
+bool FNavSvoPathQuery::BeginFindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults, const TSet<uint32>* InTileCorridor)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BeginFindPath_Query);
+
+	ResetForNewQuery();
+
+	if (!InStartNodeLink.IsValid() || !InGoalNodeLink.IsValid())
+	{
+		InOutResults.Status = (uint8)(EGunfire3DNavQueryFlags::Failure | EGunfire3DNavQueryFlags::InvalidParam);
+		return false;
+	}
+
+	StartNodeLink = InStartNodeLink;
+	GoalNodeLink = InGoalNodeLink;
+	CostLimit = InCostLimit;
+	TileCorridor = InTileCorridor;
+
+	// If the start and end node are the same there's nothing to search, so the path is
+	// already finished.
+	if (InStartNodeLink == InGoalNodeLink)
+	{
+		BestSearchNode = NodePool.GetNode(InGoalNodeLink);
+		if (BestSearchNode != nullptr)
+		{
+			InOutResults.PathNodeCount = 1;
+			InOutResults.Status |= (uint8)EGunfire3DNavQueryFlags::Success;
+			return true;
+		}
+
+		InOutResults.Status |= (uint8)EGunfire3DNavQueryFlags::Failure;
+		return false;
+	}
+
+	if (!BeginSearch(InStartNodeLink, InFilter, InOutResults))
+	{
+		return false;
+	}
+
+	PathResults = &InOutResults;
+	return true;
+}
+
+bool FNavSvoPathQuery::ContinueFindPath(uint32 MaxNodeVisits, uint64 EndCycle)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ContinueFindPath_Query);
+
+	if (PathResults == nullptr)
+	{
+		return true;
+	}
+
+	// Reading the clock is cheap but not free, so only check it every few nodes
+	const uint32 TimeCheckInterval = 16;
+
+	bool bSearching = true;
+	for (uint32 NumNodeVisits = 1; NumNodeVisits <= MaxNodeVisits; ++NumNodeVisits)
+	{
+		bSearching = StepSearch();
+		if (!bSearching)
+		{
+			break;
+		}
+
+		if (EndCycle != 0 && (NumNodeVisits % TimeCheckInterval) == 0 && FPlatformTime::Cycles64() >= EndCycle)
+		{
+			break;
+		}
+	}
+
+	if (bSearching)
+	{
+		return false;
+	}
+
+	FGunfire3DNavPathQueryResults& InOutResults = *PathResults;
+	PathResults = nullptr;
+
+	InOutResults.Status |= (uint8)EGunfire3DNavQueryFlags::Success;
+	FinishFindPath(InOutResults);
+	return true;
+}
+
+bool FNavSvoPathQuery::FindPathBidirectional(const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FindPath_Bidirectional);
+
+	// The reverse search runs from the goal back to the start. Neighbor links are
+	// symmetric so it can walk the octree the same way the forward search does.
+	FNavSvoPathQuery ReverseQuery(Octree, NodePool.GetMaxNodes());
+	ReverseQuery.ResetForNewQuery();
+	ReverseQuery.GoalNodeLink = StartNodeLink;
+	ReverseQuery.CostLimit = CostLimit;
+	ReverseQuery.TileCorridor = TileCorridor;
+	ReverseQuery.bReverseSearch = true;
+
+	FGunfire3DNavQueryResults ReverseResults;
+	FMeetingPoint Meeting;
+
+	OppositeQuery = &ReverseQuery;
+	MeetingPoint = &Meeting;
+	ReverseQuery.OppositeQuery = this;
+	ReverseQuery.MeetingPoint = &Meeting;
+
+	bool bQueryResult = BeginSearch(StartNodeLink, InFilter, InOutResults);
+	if (bQueryResult && !ReverseQuery.BeginSearch(GoalNodeLink, InFilter, ReverseResults))
+	{
+		InOutResults.Status |= ReverseResults.Status;
+		bQueryResult = false;
+	}
+
+	if (bQueryResult)
+	{
+		Meeting.GoalStepCost = GetStepCost(GoalNodeLink, (AreaCosts != nullptr) ? Octree.GetArea(GoalNodeLink) : SVO_NO_AREA);
+
+		// Alternate between the searches until they meet. Once they have, keep going
+		// only while one of the frontiers could still produce a cheaper connection.
+		bool bSearching = true;
+		while (bSearching)
 		{
-			InOutResults.Status |= (uint16)EGunfire3DNavPathQueryFlags::PartialPath;
+			bSearching = StepSearch();
+			bSearching &= ReverseQuery.StepSearch();
+
+			if (bSearching && Meeting.NodeLink.IsValid())
+			{
+				const float ForwardMinCost = OpenList.IsEmpty() ? MAX_flt : OpenList.Top()->FCost;
+				const float ReverseMinCost = ReverseQuery.OpenList.IsEmpty() ? MAX_flt : ReverseQuery.OpenList.Top()->FCost;
+				bSearching = (FMath::Max(ForwardMinCost, ReverseMinCost) < Meeting.Cost);
+			}
 		}
 
-		InOutResults.PathCost = BestSearchNode->FCost;
-		InOutResults.PathLength = FMath::Sqrt(BestSearchNode->TravelDistSqrd);
+		InOutResults.Status |= (uint8)EGunfire3DNavQueryFlags::Success;
+		InOutResults.Status |= (ReverseResults.Status & (uint8)EGunfire3DNavQueryFlags::OutOfNodes);
+		InOutResults.NumNodesQueried += ReverseResults.NumNodesQueried;
+		InOutResults.NumNodesOpened += ReverseResults.NumNodesOpened;
+		InOutResults.NumNodesReopened += ReverseResults.NumNodesReopened;
+		InOutResults.NumNodesVisited += ReverseResults.NumNodesVisited;
+		InOutResults.MemUsed += ReverseResults.MemUsed;
+
+		FNavSvoNode* ForwardMeetingNode = Meeting.NodeLink.IsValid() ? NodePool.FindNode(Meeting.NodeLink) : nullptr;
+		const FNavSvoNode* ReverseMeetingNode = Meeting.NodeLink.IsValid() ? ReverseQuery.NodePool.FindNode(Meeting.NodeLink) : nullptr;
 
-		// Reverse the found path to get the result from start to finish and count the
-		// number of nodes which make up the path.
-		FNavSvoNode* PrevSearchNode = nullptr;
-		FNavSvoNode* SearchNode = BestSearchNode;
-		do
+		if (ForwardMeetingNode != nullptr && ReverseMeetingNode != nullptr)
 		{
-			FNavSvoNode* NextSearchNode = NodePool.GetNodeAtIndex(SearchNode->ParentIdx);
-			SearchNode->ParentIdx = NodePool.GetNodeIndex(PrevSearchNode);
-			PrevSearchNode = SearchNode;
-			SearchNode = NextSearchNode;
-
-			// If there are more nodes than the loop limit then we've likely got a
-			// cyclical path
-			if (++InOutResults.PathNodeCount >= NodeVisitationLimit)
+			// Build the forward half of the path up to the meeting node
+			BestSearchNode = ForwardMeetingNode;
+			BuildPathToBestNode(InOutResults);
+
+			// Then follow the reverse search's parents from the meeting node to the
+			// goal. Each node's portal is the one shared with its parent, which is the
+			// next node along the path.
+			const FNavSvoNode* ReverseSearchNode = ReverseMeetingNode;
+			const FNavSvoNode* ReverseParentNode = ReverseQuery.NodePool.GetNodeAtIndex(ReverseQuery.NodePool.GetParentIdx(*ReverseSearchNode));
+			while (ReverseParentNode != nullptr)
 			{
-				InOutResults.Status |= (uint16)EGunfire3DNavPathQueryFlags::CyclicalPath;
-				break;
+				InOutResults.PathPortalPoints.Add(FNavPathPoint(ReverseQuery.NodePool.GetPortalLocation(*ReverseSearchNode), ReverseParentNode->NodeLink.GetID()));
+				InOutResults.PathPortalCosts.Add(Meeting.Cost - ReverseQuery.GetReverseCostToGoal(*ReverseParentNode));
+
+				if (++InOutResults.PathNodeCount >= NodeVisitationLimit)
+				{
+					InOutResults.Status |= (uint16)EGunfire3DNavPathQueryFlags::CyclicalPath;
+					break;
+				}
+
+				ReverseSearchNode = ReverseParentNode;
+				ReverseParentNode = ReverseQuery.NodePool.GetNodeAtIndex(ReverseQuery.NodePool.GetParentIdx(*ReverseSearchNode));
 			}
-		} while (SearchNode != nullptr);
 
-		// Store the path points in the results
+			InOutResults.PathCost = Meeting.Cost;
+			InOutResults.PathLength = FMath::Sqrt(NodePool.GetDetails(*ForwardMeetingNode).TravelDistSqrd + ReverseQuery.NodePool.GetDetails(*ReverseMeetingNode).TravelDistSqrd);
+		}
+		else
+		{
+			// The searches never met, so fall back to the best the forward search found
+			if (BestSearchNode->NodeLink != GoalNodeLink)
+			{
+				InOutResults.Status |= (uint16)EGunfire3DNavPathQueryFlags::PartialPath;
+			}
 
-		InOutResults.PathPortalPoints.Reserve(InOutResults.PathNodeCount);
+			BuildPathToBestNode(InOutResults);
+		}
+	}
 
-		// NOTE: We skip the first node as there is no portal location yet.
-		const FNavSvoNode* PathSearchNode = NodePool.GetNodeAtIndex(PrevSearchNode->ParentIdx);
-		while (PathSearchNode != nullptr && (uint32)InOutResults.PathPortalPoints.Num() < InOutResults.PathNodeCount)
+	OppositeQuery = nullptr;
+	MeetingPoint = nullptr;
+
+	return bQueryResult;
+}
+
+void FNavSvoPathQuery::BuildPathToBestNode(FGunfire3DNavPathQueryResults& InOutResults)
+{
+	InOutResults.PathCost = BestSearchNode->FCost;
+	InOutResults.PathLength = FMath::Sqrt(NodePool.GetDetails(*BestSearchNode).TravelDistSqrd);
+
+	// Reverse the found path to get the result from start to finish and count the
+	// number of nodes which make up the path.
+	FNavSvoNode* PrevSearchNode = nullptr;
+	FNavSvoNode* SearchNode = BestSearchNode;
+	do
+	{
+		FNavSvoNodeDetails& SearchNodeDetails = NodePool.GetDetails(*SearchNode);
+		FNavSvoNode* NextSearchNode = NodePool.GetNodeAtIndex(SearchNodeDetails.ParentIdx);
+		SearchNodeDetails.ParentIdx = NodePool.GetNodeIndex(PrevSearchNode);
+		PrevSearchNode = SearchNode;
+		SearchNode = NextSearchNode;
+
+		// If there are more nodes than the loop limit then we've likely got a
+		// cyclical path
+		if (++InOutResults.PathNodeCount >= NodeVisitationLimit)
 		{
-			InOutResults.PathPortalPoints.Add(FNavPathPoint(PathSearchNode->PortalLocation, PathSearchNode->NodeLink.GetID()));
-			PathSearchNode = NodePool.GetNodeAtIndex(PathSearchNode->ParentIdx);
+			InOutResults.Status |= (uint16)EGunfire3DNavPathQueryFlags::CyclicalPath;
+			break;
 		}
+	} while (SearchNode != nullptr);
 
-		return true;
+	// Store the path points in the results
+
+	InOutResults.PathPortalPoints.Reserve(InOutResults.PathNodeCount);
+	InOutResults.PathPortalCosts.Reserve(InOutResults.PathNodeCount);
+
+	// NOTE: We skip the first node as there is no portal location yet.
+	const FNavSvoNode* PathSearchNode = NodePool.GetNodeAtIndex(NodePool.GetParentIdx(*PrevSearchNode));
+	while (PathSearchNode != nullptr && (uint32)InOutResults.PathPortalPoints.Num() < InOutResults.PathNodeCount)
+	{
+		InOutResults.PathPortalPoints.Add(FNavPathPoint(NodePool.GetPortalLocation(*PathSearchNode), PathSearchNode->NodeLink.GetID()));
+		InOutResults.PathPortalCosts.Add(PathSearchNode->GCost);
+		PathSearchNode = NodePool.GetNodeAtIndex(NodePool.GetParentIdx(*PathSearchNode));
 	}
+}
 
-	return false;
+void FNavSvoPathQuery::FinishFindPath(FGunfire3DNavPathQueryResults& InOutResults)
+{
+	// If the end was not found, mark that this is only a partial path.
+	if (BestSearchNode->NodeLink != GoalNodeLink)
+	{
+		InOutResults.Status |= (uint16)EGunfire3DNavPathQueryFlags::PartialPath;
+	}
+
+	BuildPathToBestNode(InOutResults);
 }
 
 bool FNavSvoPathQuery::TestPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults)
@@ -131,6 +342,11 @@ void FNavSvoPathQuery::ResetForNewQuery()
 
 	GoalNodeLink = SVO_INVALID_NODELINK;
 	CostLimit = 0.f;
+	TileCorridor = nullptr;
+	PathResults = nullptr;
+	OppositeQuery = nullptr;
+	MeetingPoint = nullptr;
+	bReverseSearch = false;
 }
 
 bool FNavSvoPathQuery::CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd)
@@ -141,6 +357,12 @@ bool FNavSvoPathQuery::CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink Neigh
 		return false;
 	}
 
+	// Stay within the corridor found by the hierarchical search
+	if (TileCorridor != nullptr && !TileCorridor->Contains(NeighborLink.TileID))
+	{
+		return false;
+	}
+
 	return true;
 }
 
@@ -154,4 +376,26 @@ bool FNavSvoPathQuery::OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& No
 	}
 
 	return true;
+}
+
+void FNavSvoPathQuery::OnOpenNeighbor(FNavSvoNode& FromSearchNode, FNavSvoNode& NeighborSearchNode)
+{
+	// During a bidirectional search, check whether the other search has already reached
+	// this node. If so, the two halves can be joined here.
+	if (OppositeQuery != nullptr)
+	{
+		if (const FNavSvoNode* OppositeSearchNode = OppositeQuery->NodePool.FindNode(NeighborSearchNode.NodeLink))
+		{
+			// Both searches charged the meeting node's step cost, and neither charged the
+			// goal's, so the reverse half is corrected to what it costs going forward.
+			const float MeetingCost = bReverseSearch ?
+				(OppositeSearchNode->GCost + GetReverseCostToGoal(NeighborSearchNode)) :
+				(NeighborSearchNode.GCost + OppositeQuery->GetReverseCostToGoal(*OppositeSearchNode));
+			if (MeetingCost < MeetingPoint->Cost)
+			{
+				MeetingPoint->NodeLink = NeighborSearchNode.NodeLink;
+				MeetingPoint->Cost = MeetingCost;
+			}
+		}
+	}
 }
\ No newline at end of file
@@ -5,29 +5,115 @@
 #include "Gunfire3DNavPath.h"
 #include "NavSvoQuery.h"
 
-class FNavSvoPathQuery : public FNavSvoQuery
+// The open nodes a path runs between, and the locations within them closest to what was
+// requested.
+struct FNavSvoPathEndpoints
 {
-	typedef FNavSvoQuery Super;
+	FSvoNodeLink StartNodeLink = SVO_INVALID_NODELINK;
+	FVector StartLocation = FVector::ZeroVector;
+	FSvoNodeLink EndNodeLink = SVO_INVALID_NODELINK;
+	FVector EndLocation = FVector::ZeroVector;
+};
+
+class FNavSvoPathQuery : public TNavSvoQuery<FNavSvoPathQuery>
+{
+	typedef TNavSvoQuery<FNavSvoPathQuery> Super;
+	friend class TNavSvoQuery<FNavSvoPathQuery>;
 
 public:
 	FNavSvoPathQuery(const class FSparseVoxelOctree& InOctree, int32 MaxSearchNodes);
 
-	// Attempts to find a path to the specified goal.
-	bool FindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InParams, FGunfire3DNavPathQueryResults& InOutResults);
+	// Attempts to find a path to the specified goal. If a tile corridor is supplied, the
+	// search won't leave the tiles within it.
+	bool FindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InParams, FGunfire3DNavPathQueryResults& InOutResults, const TSet<uint32>* InTileCorridor = nullptr);
+
+	// Resumable version of FindPath, which seeds the search without running it.
+	// ContinueFindPath should then be called until it returns true. The filter, results
+	// and corridor must outlive the search.
+	//
+	// NOTE: Bidirectional searches can't be resumed, so the filter's setting is ignored.
+	bool BeginFindPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults, const TSet<uint32>* InTileCorridor = nullptr);
+
+	// Advances a search started with BeginFindPath by visiting at most 'MaxNodeVisits'
+	// nodes, stopping early if 'EndCycle' is non-zero and has passed. Returns true once
+	// the search has finished and the path has been stored in the results.
+	bool ContinueFindPath(uint32 MaxNodeVisits, uint64 EndCycle = 0);
+
+	// Returns true if a search started with BeginFindPath hasn't finished yet
+	bool IsSearchInProgress() const { return PathResults != nullptr; }
 
 	// Checks if a path exists to the specified goal.
 	bool TestPath(FSvoNodeLink InStartNodeLink, FSvoNodeLink InGoalNodeLink, float InCostLimit, const FGunfire3DNavQueryFilter& InParams, FGunfire3DNavPathQueryResults& InOutResults);
 
 private:
-	//~ Begin FNavSvoQuery
+	// Searches from the start and the goal at the same time, joining the two searches
+	// where they meet.
+	bool FindPathBidirectional(const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavPathQueryResults& InOutResults);
+
+	// Fills the results with the path from the start to the best search node
+	void BuildPathToBestNode(FGunfire3DNavPathQueryResults& InOutResults);
+
+	// Flags partial paths and fills the results once a single direction search ends
+	void FinishFindPath(FGunfire3DNavPathQueryResults& InOutResults);
+
+	//~ Begin TNavSvoQuery
 	virtual void ResetForNewQuery() override;
-	virtual FSvoNodeLink GetGoal() const override { return GoalNodeLink; }
-	virtual ENavSvoQueryTieBreaker GetCostTieBreaker() const override { return ENavSvoQueryTieBreaker::Nearest; }
-	virtual bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd) override;
-	virtual bool OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& Node) override;
-	//~ End FNavSvoQuery
+	FSvoNodeLink GetGoal() const { return GoalNodeLink; }
+	ENavSvoQueryTieBreaker GetCostTieBreaker() const { return ENavSvoQueryTieBreaker::Nearest; }
+	bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd);
+	bool OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& Node);
+	void OnOpenNeighbor(FNavSvoNode& FromSearchNode, FNavSvoNode& NeighborSearchNode);
+	//~ End TNavSvoQuery
+
+	// The cost charged for stepping into a node, including its area's multiplier.
+	// NOTE: Entering costs aren't included, bidirectional searches aren't run with them.
+	inline float GetStepCost(FSvoNodeLink NodeLink, uint8 Area) const;
+
+	// The cost of the path from a node the reverse search reached on to the goal
+	inline float GetReverseCostToGoal(const FNavSvoNode& ReverseSearchNode) const;
 
 private:
 	FSvoNodeLink GoalNodeLink = SVO_INVALID_NODELINK;
 	float CostLimit = 0.f;
-};
\ No newline at end of file
+	const TSet<uint32>* TileCorridor = nullptr;
+
+	// Only set while a resumable search is in progress
+	FGunfire3DNavPathQueryResults* PathResults = nullptr;
+
+	// The cheapest node reached by both halves of a bidirectional search
+	struct FMeetingPoint
+	{
+		FSvoNodeLink NodeLink = SVO_INVALID_NODELINK;
+		float Cost = MAX_flt;
+
+		// The step cost of the goal (see GetReverseCostToGoal)
+		float GoalStepCost = 0.f;
+	};
+
+	// Only set while running a bidirectional search
+	FNavSvoPathQuery* OppositeQuery = nullptr;
+	FMeetingPoint* MeetingPoint = nullptr;
+
+	// Set on the half of a bidirectional search which runs from the goal to the start
+	bool bReverseSearch = false;
+};
+
+float FNavSvoPathQuery::GetStepCost(FSvoNodeLink NodeLink, uint8 Area) const
+{
+	// NOTE: The traversal cost only depends on the node being stepped into
+	float StepCost = GetTraversalCost(SVO_INVALID_NODELINK, NodeLink, FVector::ZeroVector);
+	if (AreaCosts != nullptr)
+	{
+		StepCost *= AreaCosts[Area];
+	}
+
+	return StepCost;
+}
+
+float FNavSvoPathQuery::GetReverseCostToGoal(const FNavSvoNode& ReverseSearchNode) const
+{
+	// Step costs are charged to the node being stepped into, so the reverse search's
+	// cost includes the node itself but not the goal. Going forward it's the other
+	// way around.
+	return ReverseSearchNode.GCost - GetStepCost(ReverseSearchNode.NodeLink, ReverseSearchNode.Area) + MeetingPoint->GoalStepCost;
+}
\ No newline at end of file
@@ -0,0 +1,333 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoPathRequestManager.h"
+
+#include "Gunfire3DNavData.h"
+#include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+///> Profiling stats
+DECLARE_CYCLE_STAT(TEXT("Tick (PathRequests)"), STAT_PathRequests_Tick, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindPaths (PathRequests)"), STAT_PathRequests_FindPaths, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Complete (PathRequests)"), STAT_PathRequests_Complete, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending Path Requests"), STAT_PathRequests_Pending, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shared Path Requests"), STAT_PathRequests_Shared, STATGROUP_Gunfire3DNavigation);
+
+TAutoConsoleVariable<int32> CVarNavSvoPathRequestsPerTick(TEXT("NavSvo.PathRequestsPerTick"), 64, TEXT("Maximum number of coalesced path requests started each tick, highest priority first. The rest wait for the next tick. Zero starts every pending request."), ECVF_Cheat);
+
+FNavSvoPathRequestManager::FNavSvoPathRequestManager(AGunfire3DNavData& InNavData)
+	: NavData(InNavData)
+{
+}
+
+FNavSvoPathRequestManager::~FNavSvoPathRequestManager()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	}
+}
+
+void FNavSvoPathRequestManager::Add(const FGunfire3DNavPathRequestRef& Request)
+{
+	check(IsInGameThread());
+
+	// The query is run against this nav data, regardless of what it was created with
+	Request->Query.NavData = &NavData;
+
+	DropQuerierRequest(Request->Query);
+
+	if (const UObject* Querier = Request->Query.Owner.Get())
+	{
+		QuerierRequests.Add(Querier, Request);
+	}
+
+	Request->Sequence = NextSequence++;
+	PendingRequests.Add(Request);
+	UpdateTicker();
+}
+
+void FNavSvoPathRequestManager::Cancel(const FGunfire3DNavPathRequestRef& Request)
+{
+	check(IsInGameThread());
+
+	if (!Request->bComplete)
+	{
+		Request->bDropped = true;
+		PendingRequests.RemoveSingle(Request);
+	}
+
+	UpdateTicker();
+}
+
+uint32 FNavSvoPathRequestManager::GetMemUsed() const
+{
+	return sizeof(*this) +
+		PendingRequests.GetAllocatedSize() +
+		PendingRequests.Num() * sizeof(FGunfire3DNavPathRequest) +
+		QuerierRequests.GetAllocatedSize();
+}
+
+bool FNavSvoPathRequestManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PathRequests_Tick);
+
+	// Forget the queriers whose latest request has been answered or dropped
+	for (auto It = QuerierRequests.CreateIterator(); It; ++It)
+	{
+		TSharedPtr<FGunfire3DNavPathRequest, ESPMode::ThreadSafe> Request = It.Value().Pin();
+		if (!Request.IsValid() || Request->bComplete || Request->bDropped)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (NavData.GetOctree() == nullptr)
+	{
+		// Wait for an octree to search
+		return true;
+	}
+
+	if (PendingRequests.Num() > 0)
+	{
+		// Highest priority first, then in the order they were made
+		PendingRequests.Sort([](const FGunfire3DNavPathRequestRef& A, const FGunfire3DNavPathRequestRef& B)
+		{
+			return (A->Priority != B->Priority) ? (A->Priority > B->Priority) : (A->Sequence < B->Sequence);
+		});
+
+		const int32 MaxRequests = CVarNavSvoPathRequestsPerTick.GetValueOnGameThread();
+		const int32 NumRequests = (MaxRequests > 0) ? FMath::Min(MaxRequests, PendingRequests.Num()) : PendingRequests.Num();
+
+		TSharedRef<TArray<FGunfire3DNavPathRequestRef>, ESPMode::ThreadSafe> Requests = MakeShared<TArray<FGunfire3DNavPathRequestRef>, ESPMode::ThreadSafe>();
+		Requests->Append(PendingRequests.GetData(), NumRequests);
+		PendingRequests.RemoveAt(0, NumRequests, false);
+
+		// If something is waiting to modify the octree, the paths start once it's done
+		const FGraphEventArray Prerequisites = NavData.GetBackgroundReadPrerequisites();
+
+		FGraphEventRef SearchEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Requests]()
+		{
+			FindPaths(*Requests);
+		}, GET_STATID(STAT_PathRequests_FindPaths), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+
+		NavData.AddBackgroundRead(SearchEvent);
+
+		FGraphEventArray CompletionPrerequisites = { SearchEvent };
+		FFunctionGraphTask::CreateAndDispatchWhenReady([Requests]()
+		{
+			SCOPE_CYCLE_COUNTER(STAT_PathRequests_Complete);
+
+			// Anything dropped while it was being searched is thrown away. Every request
+			// is completed before any are notified, in case the callbacks make new
+			// requests.
+			for (const FGunfire3DNavPathRequestRef& Request : *Requests)
+			{
+				if (Request->bDropped)
+				{
+					Request->Result = FPathFindingResult();
+				}
+				else
+				{
+					Request->bComplete = true;
+				}
+			}
+
+			for (const FGunfire3DNavPathRequestRef& Request : *Requests)
+			{
+				if (Request->bComplete)
+				{
+					Request->OnComplete.ExecuteIfBound(Request);
+				}
+			}
+		}, GET_STATID(STAT_PathRequests_Complete), &CompletionPrerequisites, ENamedThreads::GameThread);
+	}
+
+	SET_DWORD_STAT(STAT_PathRequests_Pending, PendingRequests.Num());
+
+	if (PendingRequests.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FNavSvoPathRequestManager::FindPaths(TArrayView<const FGunfire3DNavPathRequestRef> Requests)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PathRequests_FindPaths);
+
+	if (Requests.Num() == 0)
+	{
+		return;
+	}
+
+	// Every request is for the nav data that made it
+	const AGunfire3DNavData* NavData = Cast<const AGunfire3DNavData>(Requests[0]->Query.NavData.Get());
+	if (NavData == nullptr || NavData->GetOctree() == nullptr)
+	{
+		for (const FGunfire3DNavPathRequestRef& Request : Requests)
+		{
+			Request->Result = FPathFindingResult(ENavigationQueryResult::Error);
+		}
+		return;
+	}
+
+	// Find the nodes each request starts and ends in, so we know which can be grouped
+	TArray<FNavSvoPathEndpoints> Endpoints;
+	Endpoints.SetNum(Requests.Num());
+
+	TArray<bool> FoundEndpoints;
+	FoundEndpoints.Init(false, Requests.Num());
+
+	ParallelFor(Requests.Num(), [&](int32 RequestIdx)
+	{
+		FoundEndpoints[RequestIdx] = AGunfire3DNavData::FindPathEndpoints(*NavData, Requests[RequestIdx]->Query, Endpoints[RequestIdx]);
+	});
+
+	// The first request in each group is searched for, and the rest share its path.
+	// Requests that can't be grouped get a group to themselves, so they're processed
+	// exactly like FindPath.
+	TArray<TArray<int32, TInlineAllocator<4>>> Groups;
+	TMap<FGroupKey, int32> GroupIndices;
+
+	for (int32 RequestIdx = 0; RequestIdx < Requests.Num(); ++RequestIdx)
+	{
+		const FPathFindingQuery& Query = Requests[RequestIdx]->Query;
+		const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(NavData->ResolveFilterRef(Query.QueryFilter).GetImplementation());
+
+		if (!FoundEndpoints[RequestIdx] || QueryFilterImpl == nullptr || QueryFilterImpl->OnNodeVisited)
+		{
+			Groups.AddDefaulted_GetRef().Add(RequestIdx);
+			continue;
+		}
+
+		FGroupKey Key;
+		Key.PathKey.StartNodeLink = Endpoints[RequestIdx].StartNodeLink;
+		Key.PathKey.GoalNodeLink = Endpoints[RequestIdx].EndNodeLink;
+		Key.PathKey.FilterHash = QueryFilterImpl->GetHash();
+		Key.PathKey.NavDataFlags = Query.NavDataFlags;
+		Key.CostLimit = Query.CostLimit;
+		Key.bAllowPartialPaths = Query.bAllowPartialPaths;
+
+		int32& GroupIdx = GroupIndices.FindOrAdd(Key, INDEX_NONE);
+		if (GroupIdx == INDEX_NONE)
+		{
+			GroupIdx = Groups.Num();
+			Groups.AddDefaulted();
+		}
+
+		Groups[GroupIdx].Add(RequestIdx);
+	}
+
+	INC_DWORD_STAT_BY(STAT_PathRequests_Shared, Requests.Num() - Groups.Num());
+
+	ParallelFor(Groups.Num(), [&](int32 GroupIdx)
+	{
+		const TArray<int32, TInlineAllocator<4>>& Group = Groups[GroupIdx];
+
+		FGunfire3DNavPathRequest& Leader = *Requests[Group[0]];
+		Leader.Result = AGunfire3DNavData::FindPath(Leader.Query.NavAgentProperties, Leader.Query);
+
+		const FGunfire3DNavPath* LeaderPath = (Leader.Result.IsSuccessful() && Leader.Result.Path.IsValid()) ? Leader.Result.Path->CastPath<FGunfire3DNavPath>() : nullptr;
+
+		for (int32 MemberIdx = 1; MemberIdx < Group.Num(); ++MemberIdx)
+		{
+			FGunfire3DNavPathRequest& Request = *Requests[Group[MemberIdx]];
+
+			if (LeaderPath != nullptr)
+			{
+				if (CopyPath(*NavData, Endpoints[Group[MemberIdx]], *LeaderPath, Request))
+				{
+					continue;
+				}
+			}
+			else if (!Leader.Result.IsSuccessful())
+			{
+				// Any search between the same nodes with the same settings would fail too
+				Request.Result = FPathFindingResult(Leader.Result.Result);
+				Request.bShared = true;
+				continue;
+			}
+
+			Request.Result = AGunfire3DNavData::FindPath(Request.Query.NavAgentProperties, Request.Query);
+		}
+	}, EParallelForFlags::Unbalanced);
+}
+
+bool FNavSvoPathRequestManager::CopyPath(const AGunfire3DNavData& NavData, const FNavSvoPathEndpoints& Endpoints, const FGunfire3DNavPath& SourcePath, FGunfire3DNavPathRequest& Request)
+{
+	const TArray<FNavPathPoint>& SourcePoints = SourcePath.GetPathPoints();
+	if (SourcePoints.Num() < 2)
+	{
+		return false;
+	}
+
+	FNavPathSharedPtr SharedPathPtr = AGunfire3DNavData::PreparePathInstance(NavData, Request.Query);
+	FGunfire3DNavPath* NavPath = SharedPathPtr.IsValid() ? SharedPathPtr->CastPath<FGunfire3DNavPath>() : nullptr;
+	if (NavPath == nullptr)
+	{
+		return false;
+	}
+
+	// The path was found from different locations within the same start and end nodes,
+	// so move the ends to match this request and make sure they can still see the rest
+	// of the path.
+	TArray<FNavPathPoint>& PathPoints = NavPath->GetPathPoints();
+	PathPoints = SourcePoints;
+	PathPoints[0].Location = Endpoints.StartLocation;
+	PathPoints.Last().Location = Endpoints.EndLocation;
+
+	const FEditableSvo& Octree = *NavData.GetOctree();
+	if (Octree.RaycastAnyHit(PathPoints[0].Location, PathPoints[1].Location) ||
+		Octree.RaycastAnyHit(PathPoints[PathPoints.Num() - 2].Location, PathPoints.Last().Location))
+	{
+		PathPoints.Reset();
+		return false;
+	}
+
+	// The copied path wasn't built from the corridor this path kept
+	NavPath->GetCorridor().Reset();
+	NavPath->SetIsPartial(SourcePath.IsPartial());
+	NavPath->MarkReady();
+
+	Request.Result = FPathFindingResult(ENavigationQueryResult::Success);
+	Request.Result.Path = SharedPathPtr;
+	Request.bShared = true;
+	return true;
+}
+
+void FNavSvoPathRequestManager::DropQuerierRequest(const FPathFindingQuery& Query)
+{
+	const UObject* Querier = Query.Owner.Get();
+	if (Querier == nullptr)
+	{
+		return;
+	}
+
+	const TWeakPtr<FGunfire3DNavPathRequest, ESPMode::ThreadSafe>* PreviousRequestPtr = QuerierRequests.Find(Querier);
+	TSharedPtr<FGunfire3DNavPathRequest, ESPMode::ThreadSafe> PreviousRequest = (PreviousRequestPtr != nullptr) ? PreviousRequestPtr->Pin() : nullptr;
+
+	// If it's already being searched, the search still runs but its result is thrown away
+	if (PreviousRequest.IsValid() && !PreviousRequest->bComplete)
+	{
+		PreviousRequest->bDropped = true;
+		PendingRequests.RemoveSingle(PreviousRequest.ToSharedRef());
+	}
+}
+
+void FNavSvoPathRequestManager::UpdateTicker()
+{
+	if (PendingRequests.Num() > 0 && !TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FNavSvoPathRequestManager::Tick));
+	}
+	else if (PendingRequests.Num() == 0 && TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+}
@@ -0,0 +1,92 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Gunfire3DNavPath.h"
+#include "NavSvoPathCache.h"
+#include "NavSvoPathQuery.h"
+
+#include "Containers/Ticker.h"
+#include "UObject/ObjectKey.h"
+
+class AGunfire3DNavData;
+
+//
+// Answers path requests for a single navigation data instance. Every tick the highest
+// priority pending requests are sent off to worker threads, where the ones looking for
+// the same path (same start node, goal node, filter and flags) are grouped so only one
+// of them is searched and the rest copy its path.
+//
+// Each querier only ever has one request waiting for an answer. A newer request drops
+// the older one, whether it's still pending or already being searched, so agents
+// repathing faster than paths come back don't pile up work nobody will use.
+//
+// NOTE: Game thread only, other than the searches themselves.
+//
+class FNavSvoPathRequestManager
+{
+public:
+	FNavSvoPathRequestManager(AGunfire3DNavData& InNavData);
+	~FNavSvoPathRequestManager();
+
+	FNavSvoPathRequestManager(const FNavSvoPathRequestManager&) = delete;
+	FNavSvoPathRequestManager& operator=(const FNavSvoPathRequestManager&) = delete;
+
+	// Queues a request to be started next tick, dropping any earlier unanswered request
+	// from the same querier
+	void Add(const FGunfire3DNavPathRequestRef& Request);
+
+	// Drops a request without completing it
+	void Cancel(const FGunfire3DNavPathRequestRef& Request);
+
+	int32 Num() const { return PendingRequests.Num(); }
+
+	uint32 GetMemUsed() const;
+
+private:
+	// Requests which can share a search. Queries with a node visited callback rely on
+	// their own search running, so they're never grouped.
+	struct FGroupKey
+	{
+		FNavSvoPathCacheKey PathKey;
+		float CostLimit = 0.f;
+		bool bAllowPartialPaths = false;
+
+		bool operator==(const FGroupKey& Other) const
+		{
+			return PathKey == Other.PathKey && CostLimit == Other.CostLimit && bAllowPartialPaths == Other.bAllowPartialPaths;
+		}
+
+		friend uint32 GetTypeHash(const FGroupKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.PathKey), HashCombine(GetTypeHash(Key.CostLimit), (uint32)Key.bAllowPartialPaths));
+		}
+	};
+
+	bool Tick(float DeltaTime);
+
+	// Finds the paths for a tick's worth of requests. Runs on a worker thread.
+	static void FindPaths(TArrayView<const FGunfire3DNavPathRequestRef> Requests);
+
+	// Gives a request a copy of the path found for another request in its group, moving
+	// the ends to its own endpoints. Returns false if the copied ends can't see the
+	// rest of the path, in which case the request needs its own search.
+	static bool CopyPath(const AGunfire3DNavData& NavData, const FNavSvoPathEndpoints& Endpoints, const FGunfire3DNavPath& SourcePath, FGunfire3DNavPathRequest& Request);
+
+	// Drops the unanswered request from the querier, if it has one
+	void DropQuerierRequest(const FPathFindingQuery& Query);
+
+	void UpdateTicker();
+
+	AGunfire3DNavData& NavData;
+
+	// Requests waiting to be started
+	TArray<FGunfire3DNavPathRequestRef> PendingRequests;
+
+	// The latest request from each querier, until it's answered
+	TMap<TObjectKey<UObject>, TWeakPtr<FGunfire3DNavPathRequest, ESPMode::ThreadSafe>> QuerierRequests;
+
+	uint64 NextSequence = 0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -4,6 +4,17 @@
 
 #include "Gunfire3DNavQueryFilter.h"
 #include "NavSvoNode.h"
+#include "NavSvoQueryContext.h"
+#include "SparseVoxelOctree/SparseVoxelOctreeLandmarks.h"
+#include "StatArray.h"
+
+// Used by the search in NavSvoQuery.inl, which is compiled into every query type's
+// translation unit, so they're defined once in NavSvoQuery.cpp.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SearchNodes"), STAT_SearchNodes, STATGROUP_Gunfire3DNavigation, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OpenNeighbor"), STAT_OpenNeighbor, STATGROUP_Gunfire3DNavigation, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OpenNeighborChildren"), STAT_OpenNeighborChildren, STATGROUP_Gunfire3DNavigation, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OpenVoxelsOnNeighborNode"), STAT_OpenVoxelsOnNeighborNode, STATGROUP_Gunfire3DNavigation, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OpenNeighbors"), STAT_OpenNeighbors, STATGROUP_Gunfire3DNavigation, );
 
 enum class ENavSvoQueryTieBreaker
 {
@@ -11,47 +22,86 @@ enum class ENavSvoQueryTieBreaker
 	Furthest,
 };
 
+//
+// Shared state and helpers for all octree searches. The search itself lives in
+// TNavSvoQuery so it can be specialized for each query type at compile time.
+//
 class FNavSvoQuery
 {
 public:
 	FNavSvoQuery(const class FSparseVoxelOctree& InOctree, int32 MaxSearchNodes);
-	virtual ~FNavSvoQuery() {}
+	virtual ~FNavSvoQuery();
 
 protected:
-	bool SearchNodes(FSvoNodeLink StartNodeLink, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults);
-
 	virtual void ResetForNewQuery();
 
 	bool GetPortalLocation(FSvoNodeLink FromLink, FSvoNodeLink ToLink, ESvoNeighbor Neighbor, FVector& OutLocation) const;
 
-	virtual float GetHeuristic(FSvoNodeLink FromLink) const;
-	virtual float GetHeuristicScale() const;
-	virtual float GetTraversalCost(FSvoNodeLink FromLink, FSvoNodeLink ToLink, const FVector& PortalLocation) const;
+	// Converts the filter's minimum clearance to voxels
+	void CacheMinClearance();
 
-	virtual FSvoNodeLink GetGoal() const = 0;
-	virtual ENavSvoQueryTieBreaker GetCostTieBreaker() const = 0;
+	// Grabs the filter's area cost tables, if it has any area costs
+	void CacheAreaCosts();
 
-	virtual bool OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& Node) { return true; }
-	virtual bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd) { return true; }
-	virtual void OnOpenNeighbor(FNavSvoNode& FromSearchNode, FNavSvoNode& NeighborSearchNode) {}
+	// Resolves the filter's coarse search layer and the cells the start and goal are in,
+	// which are still searched at full detail
+	void CacheCoarseSearch(FSvoNodeLink GoalLink);
 
-	virtual uint32 GetMemUsed() const;
+	// Returns true if a partially blocked node is too fine for the coarse search and
+	// should be treated as blocked
+	inline bool IsBelowCoarseSearch(FSvoNodeLink NodeLink) const;
 
-private:
-	inline FNavSvoNode* TryAddSearchNode(FSvoNodeLink NodeLink);
+	// Returns a key for the node on the coarse search layer containing a node, or
+	// MAX_uint64 if the node is larger than that
+	inline uint64 GetCoarseSearchCell(FSvoNodeLink NodeLink) const;
 
-	bool OpenNeighbor(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode);
-	bool OpenNeighbors(FNavSvoNode& SearchNode, const FSvoNode& Node);
+	// Resolves the location of a node about to have its neighbors opened, so portals to
+	// neighbors at least as large as it don't need to look it up again.
+	void CacheExpandingNode(FSvoNodeLink NodeLink);
 
-	bool OpenNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode);
-	bool OpenChildrenOnNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, const FSvoNode& NeighborNode);
-	bool OpenVoxelsOnNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode);
+	// Resolves the location of the goal once so the heuristic doesn't need to find the
+	// goal node for every neighbor that's opened. Also grabs the landmark distances of
+	// the goal's tile, if the filter wants them.
+	void CacheGoal(FSvoNodeLink GoalLink);
+
+	// Returns the lower bound from the landmarks on the voxels between a tile and the
+	// goal's tile (see FSvoLandmarks)
+	inline float GetLandmarkHeuristic(uint32 TileID) const;
+
+	// Sets up the open list with the type requested by the filter
+	void InitOpenList();
+
+	// Adds the nodes from the last search to the query heatmap, if it was being collected
+	// when the search began. This needs to happen before the pool is cleared.
+	void RecordHeatmap();
+
+	//~ Begin default query policy
+	//
+	// Derived queries can hide any of these with their own version, TNavSvoQuery will
+	// call whichever is most derived without going through a virtual call.
+	inline float GetHeuristic(FSvoNodeLink FromLink) const;
+	inline float GetHeuristicScale() const;
+	inline float GetTraversalCost(FSvoNodeLink FromLink, FSvoNodeLink ToLink, const FVector& PortalLocation) const;
+
+	bool OnNodeVisited(FNavSvoNode& SearchNode, const FSvoNode& Node) { return true; }
+	bool CanOpenNeighbor(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode, float NeighborCost, float NeighborDistanceSqrd) { return true; }
+	void OnOpenNeighbor(FNavSvoNode& FromSearchNode, FNavSvoNode& NeighborSearchNode) {}
+	//~ End default query policy
+
+	virtual uint32 GetMemUsed() const;
+
+	inline FNavSvoNode* TryAddSearchNode(FSvoNodeLink NodeLink);
 
 protected:
 	const class FSparseVoxelOctree& Octree;
 
-	FNavSvoNodePool NodePool;
-	FNavSvoNodeQueue OpenList;
+	// Search buffers borrowed from the thread's context cache for the lifetime of the
+	// query.
+	FNavSvoScopedQueryContext Context;
+
+	FNavSvoNodePool& NodePool;
+	FNavSvoNodeQueue& OpenList;
+	TMap<FSvoNodeLink, uint64>& ClosedLeafVoxels;
 		
 	// The starting location of the search
 	FSvoNodeLink StartNodeLink = SVO_INVALID_NODELINK;
@@ -62,6 +112,85 @@ protected:
 	// Maximum number of nodes to visit while searching the open node list.
 	uint32 NodeVisitationLimit = 0.f;
 
+	// Cached voxel coordinate of the goal's center (see CacheGoal)
+	FIntVector GoalCoord = FIntVector::ZeroValue;
+
+	// Landmark distances and the goal tile's row in them, or null if the filter doesn't
+	// use them (see CacheGoal)
+	FSvoLandmarks::FTablePtr Landmarks;
+	const uint16* GoalLandmarkDistances = nullptr;
+
+	// Neighbors are mostly opened within the same tile, so the last tile's landmark
+	// heuristic is kept around
+	mutable uint32 LandmarkHeuristicTileID = 0;
+	mutable float LandmarkHeuristic = 0.f;
+
+	// Cached node whose neighbors are being opened (see CacheExpandingNode)
+	FSvoNodeLink ExpandingNodeLink = SVO_INVALID_NODELINK;
+	FVector ExpandingNodeLocation = FVector::ZeroVector;
+	float ExpandingNodeResolution = 0.f;
+
 	const FGunfire3DNavQueryFilter* Filter = nullptr;
 	FGunfire3DNavQueryResults* Results = nullptr;
-};
\ No newline at end of file
+
+	// Runtime obstacles to avoid, or null if there are none
+	const class FSvoObstacles* Obstacles = nullptr;
+
+	// Clearance in voxels that nodes need to be opened, or zero if any will do
+	uint8 MinClearance = 0;
+
+	// Layer partially blocked nodes aren't searched into past, or INDEX_NONE for full
+	// detail, and the cells on that layer the endpoints are in (see CacheCoarseSearch)
+	int32 CoarseSearchLayer = INDEX_NONE;
+	uint64 CoarseStartCell = MAX_uint64;
+	uint64 CoarseGoalCell = MAX_uint64;
+
+	// The filter's area cost tables (see FGunfire3DNavQueryFilter::GetAreaCostTable), or
+	// null if every area costs the same.
+	const float* AreaCosts = nullptr;
+	const float* AreaEnteringCosts = nullptr;
+
+	// The nodes in the pool still need to be added to the query heatmap
+	bool bPendingHeatmap = false;
+};
+
+//
+// A* search over the octree, specialized on the derived query type. The derived type
+// must provide GetGoal() and GetCostTieBreaker() and may hide any of the default policy
+// functions in FNavSvoQuery. Since every call is resolved at compile time, the policy
+// functions can be inlined into the inner loop.
+//
+template<typename TQueryPolicy>
+class TNavSvoQuery : public FNavSvoQuery
+{
+	typedef FNavSvoQuery Super;
+
+public:
+	TNavSvoQuery(const class FSparseVoxelOctree& InOctree, int32 MaxSearchNodes)
+		: Super(InOctree, MaxSearchNodes)
+	{}
+
+protected:
+	// Runs the search from the start node until it's exhausted or cancelled
+	bool SearchNodes(FSvoNodeLink InStartNodeLink, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults);
+
+	// Seeds a search from the start node without running it. Use StepSearch to advance
+	// the search, which allows multiple searches to be interleaved.
+	bool BeginSearch(FSvoNodeLink InStartNodeLink, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults);
+
+	// Visits the next node on the open list. Returns false once the search is finished.
+	bool StepSearch();
+
+private:
+	FORCEINLINE TQueryPolicy& GetPolicy() { return static_cast<TQueryPolicy&>(*this); }
+	FORCEINLINE const TQueryPolicy& GetPolicy() const { return static_cast<const TQueryPolicy&>(*this); }
+
+	bool OpenNeighbor(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode);
+	bool OpenNeighbors(FNavSvoNode& SearchNode, const FSvoNode& Node);
+
+	bool OpenNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode);
+	bool OpenChildrenOnNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, const FSvoNode& NeighborNode);
+	bool OpenVoxelsOnNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode);
+};
+
+#include "NavSvoQuery.inl"
@@ -0,0 +1,593 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Gunfire3DNavigationUtils.h"
+#include "NavSvoQueryHeatmap.h"
+#include "SparseVoxelOctree/SparseVoxelOctree.h"
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoQuery
+//////////////////////////////////////////////////////////////////////////
+
+FNavSvoNode* FNavSvoQuery::TryAddSearchNode(FSvoNodeLink NodeLink)
+{
+	FNavSvoNode* NewNode = NodePool.GetNode(NodeLink);
+
+	// If unable to get this node then the pool has been exhausted.
+	if (NewNode == nullptr)
+	{
+		Results->Status |= (uint8)EGunfire3DNavQueryFlags::OutOfNodes;
+	}
+
+	return NewNode;
+}
+
+float FNavSvoQuery::GetHeuristic(FSvoNodeLink FromLink) const
+{
+	// Calculate the Manhattan distance, in voxels, between the portal location and
+	// the end location. This will provide a stable heuristic amongst all nodes,
+	// regardless of size.
+	//
+	// If the filter uses landmarks, whichever of the two is larger is used, since both
+	// are lower bounds on the distance left.
+	//
+	// NOTE: The goal is resolved once per query in CacheGoal and the scale is applied
+	// by the caller. Everything here is in whole voxels, so it's exact however far the
+	// node is from the origin and doesn't go through world space at all.
+
+	FIntVector FromMinCoord, FromMaxCoord;
+	Octree.GetVoxelCoordBoundsForLink(FromLink, FromMinCoord, FromMaxCoord);
+
+	const FIntVector FromCoord(
+		FMath::Clamp(GoalCoord.X, FromMinCoord.X, FromMaxCoord.X),
+		FMath::Clamp(GoalCoord.Y, FromMinCoord.Y, FromMaxCoord.Y),
+		FMath::Clamp(GoalCoord.Z, FromMinCoord.Z, FromMaxCoord.Z));
+
+	const float Heuristic = FGunfire3DNavigationUtils::GetManhattanDistance(FromCoord, GoalCoord);
+
+	if (GoalLandmarkDistances != nullptr)
+	{
+		return FMath::Max(Heuristic, GetLandmarkHeuristic(FromLink.TileID));
+	}
+
+	return Heuristic;
+}
+
+float FNavSvoQuery::GetLandmarkHeuristic(uint32 TileID) const
+{
+	if (TileID != LandmarkHeuristicTileID)
+	{
+		LandmarkHeuristicTileID = TileID;
+		LandmarkHeuristic = 0.f;
+
+		if (const uint16* TileDistances = Landmarks->FindTileDistances(TileID))
+		{
+			// The steps only bound how many tiles a path has to pass through, and a step
+			// can cost next to nothing (e.g. cutting across the edge two tiles share), so
+			// they can't be taken as a tile width each. Any stretch of path no longer than
+			// a tile spans at most two tiles along each axis though, so it can pass
+			// through at most eight tiles. Each eight steps past the first tile then need
+			// at least a tile width of path, which keeps this a lower bound.
+			const int32 Steps = Landmarks->GetStepsLowerBound(TileDistances, GoalLandmarkDistances);
+			const int32 TileVoxels = SVO_VOXEL_GRID_EXTENT << Octree.GetConfig().GetTileLayerIndex();
+			LandmarkHeuristic = (float)((Steps / 8) * TileVoxels);
+		}
+	}
+
+	return LandmarkHeuristic;
+}
+
+bool FNavSvoQuery::IsBelowCoarseSearch(FSvoNodeLink NodeLink) const
+{
+	if ((int32)NodeLink.LayerIdx > CoarseSearchLayer)
+	{
+		return false;
+	}
+
+	// The endpoints may be in cluttered space themselves, so the cells around them are
+	// searched in full to find a way out
+	const uint64 Cell = GetCoarseSearchCell(NodeLink);
+	return (Cell != CoarseStartCell && Cell != CoarseGoalCell);
+}
+
+uint64 FNavSvoQuery::GetCoarseSearchCell(FSvoNodeLink NodeLink) const
+{
+	if ((int32)NodeLink.LayerIdx > CoarseSearchLayer)
+	{
+		return MAX_uint64;
+	}
+
+	// Each layer up is another three bits off the Morton code
+	const uint32 CellMortonCode = NodeLink.NodeIdx >> (3 * (CoarseSearchLayer - NodeLink.LayerIdx));
+	return ((uint64)NodeLink.TileID << 32) | CellMortonCode;
+}
+
+float FNavSvoQuery::GetHeuristicScale() const
+{
+	return Filter->GetHeuristicScale();
+}
+
+float FNavSvoQuery::GetTraversalCost(FSvoNodeLink FromLink, FSvoNodeLink ToLink, const FVector& PortalLocation) const
+{
+	// We use the same unit for every node->node traversal cost so that larger nodes
+	// don't incur a higher penalty than smaller ones. We basically want all open
+	// space neighbors to be considered equal, distance-traveled-wise.
+	//
+	// NOTE: Designer costs (e.g. avoid fire, water, etc.) come from the area of the node
+	// and are applied on top of this when the neighbor is opened.
+	float TraversalCost = Filter->GetBaseTraversalCost();
+	TraversalCost *= (1.f - (Octree.GetConfig().GetResolutionForLink(ToLink) / Octree.GetConfig().GetTileResolution()));
+	return TraversalCost;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// TNavSvoQuery
+//////////////////////////////////////////////////////////////////////////
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::SearchNodes(FSvoNodeLink InStartNodeLink, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SearchNodes);
+
+	if (!BeginSearch(InStartNodeLink, InFilter, InOutResults))
+	{
+		return false;
+	}
+
+	while (StepSearch())
+	{
+	}
+
+	Results->Status |= (uint8)EGunfire3DNavQueryFlags::Success;
+	return true;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::BeginSearch(FSvoNodeLink InStartNodeLink, const FGunfire3DNavQueryFilter& InFilter, FGunfire3DNavQueryResults& InOutResults)
+{
+	StartNodeLink = InStartNodeLink;
+	BestSearchNode = nullptr;
+	Filter = &InFilter;
+	Results = &InOutResults;
+
+	// Everything is pre-allocated prior to the query to just assign the mem allocation value now.
+	Results->MemUsed = GetMemUsed();
+
+	// Bail if the node pool or open list failed to instantiate
+	if (NodePool.GetMaxNodes() == 0)
+	{
+		Results->Status = (uint8)(EGunfire3DNavQueryFlags::Failure | EGunfire3DNavQueryFlags::OutOfMemory);
+		return false;
+	}
+
+	// Don't continue if the octree is empty
+	if (!Octree.IsValid())
+	{
+		Results->Status = (uint8)(EGunfire3DNavQueryFlags::Failure | EGunfire3DNavQueryFlags::InvalidParam);
+		return false;
+	}
+
+	if (!StartNodeLink.IsValid())
+	{
+		Results->Status = (uint8)(EGunfire3DNavQueryFlags::Failure | EGunfire3DNavQueryFlags::InvalidParam);
+		return false;
+	}
+
+	// Resolve the goal up front so it isn't looked up for every neighbor
+	CacheGoal(GetPolicy().GetGoal());
+
+	CacheMinClearance();
+	CacheAreaCosts();
+	CacheCoarseSearch(GetPolicy().GetGoal());
+
+	// Reset pool and open list
+	RecordHeatmap();
+	NodePool.Clear();
+	ClosedLeafVoxels.Reset();
+	InitOpenList();
+
+	bPendingHeatmap = FNavSvoQueryHeatmap::IsEnabled();
+
+	// Portal locations are stored relative to the start node. This also makes the start
+	// node its own portal, so travel distances are measured from it.
+	FVector StartLocation;
+	Octree.GetLocationForLink(StartNodeLink, StartLocation);
+	NodePool.SetOrigin(StartLocation);
+
+	// Create starting node to seed the process
+	FNavSvoNode* StartSearchNode = TryAddSearchNode(StartNodeLink);
+	if (StartSearchNode == nullptr)
+	{
+		Results->Status |= (uint8)EGunfire3DNavQueryFlags::Failure;
+		return false;
+	}
+
+	// Mark the start node as open for posterity
+	StartSearchNode->Flags = NAVSVONODE_OPEN;
+
+	// The start node is always searched from, even if the filter excludes its area
+	StartSearchNode->Area = (AreaCosts != nullptr) ? Octree.GetArea(StartNodeLink) : SVO_NO_AREA;
+
+	// Seed the initial heuristic
+	StartSearchNode->Heuristic = MAX_flt;
+
+	// Seed the best search node with the start search node
+	BestSearchNode = StartSearchNode;
+
+	// Add the starting search node to the open list so iteration can begin
+	OpenList.Push(StartSearchNode);
+
+	return true;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::StepSearch()
+{
+	if (OpenList.IsEmpty())
+	{
+		return false;
+	}
+
+	FNavSvoNode& SearchNode = *OpenList.Pop();
+	SearchNode.Flags &= ~NAVSVONODE_OPEN;
+	SearchNode.Flags |= NAVSVONODE_CLOSED;
+
+	const FSvoNodeLink& NodeLink = SearchNode.NodeLink;
+	const FSvoNode& Node = *(Octree.GetNodeFromLink(NodeLink));
+
+	if (NodeLink.IsVoxelNode())
+	{
+		FSvoNodeLink LeafLink = NodeLink;
+		LeafLink.VoxelIdx = SVO_NO_VOXEL;
+		ClosedLeafVoxels.FindOrAdd(LeafLink) |= (1ull << NodeLink.VoxelIdx);
+	}
+
+	// Notify derivative that a node is being visited and optionally cancel the
+	// search.
+	if (!GetPolicy().OnNodeVisited(SearchNode, Node))
+	{
+		return false;
+	}
+
+	// Notify caller that a node is being visited and optionally cancel the
+	// search.
+	if (Filter->OnNodeVisited && !Filter->OnNodeVisited(SearchNode.NodeLink.GetID()))
+	{
+		return false;
+	}
+
+	OpenNeighbors(SearchNode, Node);
+
+	// Failsafe for cycles in navigation graph resulting in infinite loop
+	if (++Results->NumNodesVisited == NodeVisitationLimit)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::OpenNeighbor(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OpenNeighbor);
+
+	// Do not process invalid neighbors
+	if (!NeighborLink.IsValid())
+	{
+		return false;
+	}
+
+	// Do not backtrack to self
+	if (FromSearchNode.NodeLink == NeighborLink)
+	{
+		return false;
+	}
+
+	// Do not backtrack to the parent node that we're coming from
+	FNavSvoNode* ParentSearchNode = NodePool.GetNodeAtIndex(NodePool.GetParentIdx(FromSearchNode));
+	if (ParentSearchNode != nullptr && ParentSearchNode->NodeLink == NeighborLink)
+	{
+		return false;
+	}
+
+	FNavSvoNode* NeighborSearchNode = NodePool.FindNode(NeighborLink);
+	const bool bIsNeighborAlreadyOpen = (NeighborSearchNode != nullptr && (NeighborSearchNode->Flags & NAVSVONODE_OPEN) != 0);
+	const bool bIsNeighborAlreadyClosed = (NeighborSearchNode != nullptr && (NeighborSearchNode->Flags & NAVSVONODE_CLOSED) != 0);
+
+	// Don't process already closed nodes
+	//
+	// NOTE: Nodes are closed once they are visited on the open-list.
+	if (bIsNeighborAlreadyClosed)
+	{
+		return false;
+	}
+
+	// Don't open nodes too close to geometry for the filter
+	if (MinClearance > 0 && Octree.GetClearance(NeighborLink) < MinClearance)
+	{
+		return false;
+	}
+
+	// Don't open nodes in areas the filter excludes
+	uint8 NeighborArea = SVO_NO_AREA;
+	if (AreaCosts != nullptr)
+	{
+		NeighborArea = Octree.GetArea(NeighborLink);
+		if (Filter->IsAreaCodeExcluded(NeighborArea))
+		{
+			return false;
+		}
+	}
+
+	// Find the portal location between the two nodes
+	FVector NeighborPortalLocation;
+	const bool bPortalLocationValid = GetPortalLocation(FromSearchNode.NodeLink, NeighborLink, Neighbor, NeighborPortalLocation);
+	if (!bPortalLocationValid)
+	{
+		return false;
+	}
+
+	// Calculate the linear distance to this node
+	const FNavSvoNodeDetails& FromSearchNodeDetails = NodePool.GetDetails(FromSearchNode);
+	const float TraversalDeltaToNeighborSqrd = FVector::DistSquared(NodePool.GetPortalLocation(FromSearchNode), NeighborPortalLocation);
+	const float NeighborTotalTravelDistSqrd = FromSearchNodeDetails.TravelDistSqrd + TraversalDeltaToNeighborSqrd;
+
+	// Calculate the cost of this node
+	const float NeighborHeuristic = GetPolicy().GetHeuristic(NeighborLink) * GetPolicy().GetHeuristicScale();
+	float NeighborStepCost = GetPolicy().GetTraversalCost(FromSearchNode.NodeLink, NeighborLink, NeighborPortalLocation);
+	if (AreaCosts != nullptr)
+	{
+		// Areas scale the cost of moving through them, and can cost extra to enter
+		NeighborStepCost *= AreaCosts[NeighborArea];
+		if (NeighborArea != FromSearchNode.Area)
+		{
+			NeighborStepCost += AreaEnteringCosts[NeighborArea];
+		}
+	}
+
+	const float NeighborTraversalCost = FromSearchNode.GCost + NeighborStepCost;
+	const float NeighborTotalCost = NeighborTraversalCost + NeighborHeuristic;
+	bool bIsNeighborCheaper = true;
+
+	// If the neighbor node is currently on the open-list, we need to decide whether
+	// to keep the existing node cost or update it with this new path.
+	if (bIsNeighborAlreadyOpen)
+	{
+		const float ExistingNeighborCost = NeighborSearchNode->FCost;
+		if (ExistingNeighborCost == NeighborTotalCost)
+		{
+			ENavSvoQueryTieBreaker TieBreaker = GetPolicy().GetCostTieBreaker();
+			switch (TieBreaker)
+			{
+			case ENavSvoQueryTieBreaker::Nearest:
+				bIsNeighborCheaper = (NeighborTraversalCost < NeighborSearchNode->GCost);
+				break;
+
+			case ENavSvoQueryTieBreaker::Furthest:
+				bIsNeighborCheaper = (NeighborTraversalCost > NeighborSearchNode->GCost);
+				break;
+			}
+		}
+		else if (ExistingNeighborCost < NeighborTotalCost)
+		{
+			bIsNeighborCheaper = true;
+		}
+		else
+		{
+			bIsNeighborCheaper = false;
+		}
+	}
+
+	// Don't open this node again if the existing cost is better
+	if (!bIsNeighborCheaper)
+	{
+		return false;
+	}
+
+	// Runtime obstacles close the nodes they block, without the tiles being rebuilt.
+	// Large open nodes stay open while an obstacle only covers part of them, so the way
+	// into the neighbor has to be clear too (see FSvoObstacles).
+	if (Obstacles != nullptr)
+	{
+		float ObstacleHitTime;
+		if (Octree.IsNodeClosedByObstacle(NeighborLink) ||
+			Obstacles->Raycast(NodePool.GetPortalLocation(FromSearchNode), NeighborPortalLocation, ObstacleHitTime))
+		{
+			return false;
+		}
+	}
+
+	// As a final check, allow derivative queries a chance to prevent a neighbor from
+	// opening.
+	const bool bCanOpenNeighbor = GetPolicy().CanOpenNeighbor(Neighbor, NeighborLink, NeighborNode, NeighborTotalCost, NeighborTotalTravelDistSqrd);
+	if (!bCanOpenNeighbor)
+	{
+		return false;
+	}
+
+	// If this is the first time visiting this node, add it to the pool so we can
+	// track its cost.
+	if (NeighborSearchNode == nullptr)
+	{
+		NeighborSearchNode = TryAddSearchNode(NeighborLink);
+
+		// If unable to get this node then the pool has been exhausted.
+		if (NeighborSearchNode == nullptr)
+		{
+			return false;
+		}
+	}
+
+	// In this case, the node can be put on the frontier and explored
+
+	NeighborSearchNode->FCost = NeighborTotalCost;
+	NeighborSearchNode->GCost = NeighborTraversalCost;
+	NeighborSearchNode->Heuristic = NeighborHeuristic;
+	NeighborSearchNode->Neighbor = Neighbor;
+	NeighborSearchNode->Area = NeighborArea;
+	NeighborSearchNode->Flags &= ~NAVSVONODE_CLOSED;
+
+	FNavSvoNodeDetails& NeighborSearchNodeDetails = NodePool.GetDetails(*NeighborSearchNode);
+	NeighborSearchNodeDetails.ParentIdx = NodePool.GetNodeIndex(&FromSearchNode);
+	NeighborSearchNodeDetails.TravelDistSqrd = NeighborTotalTravelDistSqrd;
+	NodePool.SetPortalLocation(*NeighborSearchNode, NeighborPortalLocation);
+
+	// If this node is already in queue to be processed, update its position.
+	// Otherwise, add it to the frontier for the first time.
+	if (NeighborSearchNode->Flags & NAVSVONODE_OPEN)
+	{
+		OpenList.Modify(NeighborSearchNode);
+		++Results->NumNodesReopened;
+	}
+	else
+	{
+		NeighborSearchNode->Flags |= NAVSVONODE_OPEN;
+		OpenList.Push(NeighborSearchNode);
+		++Results->NumNodesOpened;
+	}
+
+	// If this is the closest node to the goal, store it as the last best-known
+	// node. This is how partial searches are determined.
+	if (BestSearchNode == nullptr || NeighborSearchNode->Heuristic < BestSearchNode->Heuristic)
+	{
+		BestSearchNode = NeighborSearchNode;
+	}
+
+	// Update stats
+	Results->NumNodesQueried = NodePool.GetNodeCount();
+
+	// Allow the implementation to handle nodes being opened.
+	GetPolicy().OnOpenNeighbor(FromSearchNode, *NeighborSearchNode);
+
+	return true;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::OpenNeighbors(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OpenNeighbors);
+
+	bool bNeighborsOpened = false;
+
+	CacheExpandingNode(FromSearchNode.NodeLink);
+
+	// Iterate over each neighbor and open them if they are not blocked
+	for (FSvoNeighborConstIterator NeighborIter(Octree, FromSearchNode.NodeLink); NeighborIter; ++NeighborIter)
+	{
+		const ESvoNeighbor Neighbor = NeighborIter.GetNeighbor();
+		const FSvoNode& NeighborNode = NeighborIter.GetNeighborNodeChecked();
+		const FSvoNodeLink NeighborLink = NeighborIter.GetNeighborLink();
+
+		bNeighborsOpened |= OpenNeighborNode(FromSearchNode, FromNode, Neighbor, NeighborLink, NeighborNode);
+	}
+
+	return bNeighborsOpened;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::OpenNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode)
+{
+	bool bNeighborOpened = false;
+
+	// 1.) If the neighbor node is completely empty, then we can just open directly
+	// 
+	// 2.) If this is a leaf node that is partially blocked, we need to check each
+	// voxel on the neighboring face and open the non-blocked nodes.
+	// 
+	// 3.) If this is a regular node that has children, we need to go deeper into the
+	// node until we reach an open child without any children that are on the
+	// neighboring face and open those node.
+	if (NeighborLink.IsVoxelNode())
+	{
+		if (NeighborNode.IsVoxelBlocked(NeighborLink.VoxelIdx))
+		{
+			// Don't open blocked voxels
+			return false;
+		}
+		else
+		{
+			// Open empty voxels
+			bNeighborOpened = OpenNeighbor(FromSearchNode, FromNode, Neighbor, NeighborLink, NeighborNode);
+		}
+	}
+	else if (NeighborNode.GetNodeState() == ENodeState::Blocked)
+	{
+		// Don't open blocked nodes
+		return false;
+	}
+	else if (NeighborNode.GetNodeState() == ENodeState::Open)
+	{
+		// Open empty nodes
+		bNeighborOpened = OpenNeighbor(FromSearchNode, FromNode, Neighbor, NeighborLink, NeighborNode);
+	}
+	else if (IsBelowCoarseSearch(NeighborLink))
+	{
+		// Don't search through clutter finer than the filter wants
+		return false;
+	}
+	else if (NeighborLink.IsLeafNode())
+	{
+		bNeighborOpened = OpenVoxelsOnNeighborNode(FromSearchNode, FromNode, Neighbor, NeighborLink, NeighborNode);
+	}
+	else // Parent node with children
+	{
+		bNeighborOpened = OpenChildrenOnNeighborNode(FromSearchNode, FromNode, Neighbor, NeighborNode);
+	}
+
+	return bNeighborOpened;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::OpenChildrenOnNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, const FSvoNode& NeighborNode)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OpenNeighborChildren);
+
+	bool bNeighborsOpened = false;
+
+	// We need the opposite neighbor, since we're looking for nodes in the neighbor
+	// that touch us.
+	const ESvoNeighbor OppositeNeighbor = FSvoUtils::GetOppositeNeighbor(Neighbor);
+
+	// Add each child that has the parent as a neighbor
+	for (uint8 NeighborChildIdx : FSvoUtils::GetChildrenTouchingNeighbor(OppositeNeighbor))
+	{
+		const FSvoNodeLink NeighborChildLink = NeighborNode.GetChildLink(NeighborChildIdx);
+		const FSvoNode* NeighborChildNode = Octree.GetNodeFromLink(NeighborChildLink);
+		check(NeighborChildNode);
+
+		bNeighborsOpened |= OpenNeighborNode(FromSearchNode, FromNode, Neighbor, NeighborChildLink, *NeighborChildNode);
+	}
+
+	return bNeighborsOpened;
+}
+
+template<typename TQueryPolicy>
+bool TNavSvoQuery<TQueryPolicy>::OpenVoxelsOnNeighborNode(FNavSvoNode& FromSearchNode, const FSvoNode& FromNode, ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink, const FSvoNode& NeighborNode)
+{
+	SCOPE_CYCLE_COUNTER(STAT_OpenVoxelsOnNeighborNode);
+
+	bool bNeighborOpened = false;
+	FSvoNodeLink NeighborVoxelLink = NeighborLink;
+
+	// Add all face voxels that aren't blocked, skipping any that have already been
+	// closed since OpenNeighbor would just find them in the pool and turn them away
+	uint64 FaceVoxels = NeighborNode.GetOpenVoxels(FSvoUtils::GetTouchingNeighborVoxelMask(Neighbor));
+
+	FSvoNodeLink LeafLink = NeighborLink;
+	LeafLink.VoxelIdx = SVO_NO_VOXEL;
+	if (const uint64* ClosedVoxels = ClosedLeafVoxels.Find(LeafLink))
+	{
+		FaceVoxels &= ~(*ClosedVoxels);
+	}
+
+	while (FaceVoxels != 0)
+	{
+		NeighborVoxelLink.VoxelIdx = (uint8)FMath::CountTrailingZeros64(FaceVoxels);
+		bNeighborOpened |= OpenNeighbor(FromSearchNode, FromNode, Neighbor, NeighborVoxelLink, NeighborNode);
+		FaceVoxels &= FaceVoxels - 1;
+	}
+
+	return bNeighborOpened;
+}
@@ -0,0 +1,323 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoQueryCapture.h"
+
+#include "Gunfire3DNavQueryFilter.h"
+
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "NavigationData.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/ObjectKey.h"
+
+namespace NavSvoQueryCapture
+{
+	// Identifies a capture file, and the version of its layout
+	static constexpr uint32 FileMagic = 0x51334447; // 'GD3Q'
+	static constexpr int32 FileVersion = 1;
+
+	enum class ERecordType : uint8
+	{
+		NavData,
+		Filter,
+		Query,
+	};
+
+	std::atomic<bool> bCapturing(false);
+
+	// Everything below is only touched while holding the lock
+	FCriticalSection Lock;
+
+	TUniquePtr<FArchive> Writer;
+	FString Filename;
+	double StartTime = 0.0;
+	int32 NumQueries = 0;
+
+	TMap<FObjectKey, int32> NavDataIndices;
+
+	// Filters written so far, keyed by a hash of their data
+	TMultiMap<uint32, int32> FilterIndices;
+	TArray<TArray<uint8>> Filters;
+
+	int32 FindOrWriteNavData(const ANavigationData& NavData)
+	{
+		if (const int32* NavDataIdx = NavDataIndices.Find(&NavData))
+		{
+			return *NavDataIdx;
+		}
+
+		const int32 NavDataIdx = NavDataIndices.Num();
+		NavDataIndices.Add(&NavData, NavDataIdx);
+
+		ERecordType RecordType = ERecordType::NavData;
+		FString Name = NavData.GetName();
+		*Writer << RecordType;
+		*Writer << Name;
+
+		return NavDataIdx;
+	}
+
+	int32 FindOrWriteFilter(TArray<uint8>&& FilterData)
+	{
+		const uint32 Hash = FCrc::MemCrc32(FilterData.GetData(), FilterData.Num());
+		for (auto It = FilterIndices.CreateConstKeyIterator(Hash); It; ++It)
+		{
+			if (Filters[It.Value()] == FilterData)
+			{
+				return It.Value();
+			}
+		}
+
+		ERecordType RecordType = ERecordType::Filter;
+		*Writer << RecordType;
+		*Writer << FilterData;
+
+		const int32 FilterIdx = Filters.Add(MoveTemp(FilterData));
+		FilterIndices.Add(Hash, FilterIdx);
+
+		return FilterIdx;
+	}
+
+	void SerializeQuery(FArchive& Ar, FNavSvoCapturedQuery& Query)
+	{
+		Ar << Query.Type;
+		Ar << Query.bAllowPartialPaths;
+		Ar << Query.Time;
+		Ar << Query.Start;
+		Ar << Query.End;
+		Ar << Query.NavDataIdx;
+		Ar << Query.FilterIdx;
+	}
+}
+
+void FNavSvoQueryCapture::Shutdown()
+{
+	End();
+}
+
+bool FNavSvoQueryCapture::Begin(const FString& Filename)
+{
+	End();
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("NavSvo query capture: Failed to write '%s'"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = NavSvoQueryCapture::FileMagic;
+	int32 Version = NavSvoQueryCapture::FileVersion;
+	*Writer << Magic;
+	*Writer << Version;
+
+	FScopeLock Lock(&NavSvoQueryCapture::Lock);
+
+	NavSvoQueryCapture::Writer = MoveTemp(Writer);
+	NavSvoQueryCapture::Filename = Filename;
+	NavSvoQueryCapture::StartTime = FPlatformTime::Seconds();
+	NavSvoQueryCapture::NumQueries = 0;
+	NavSvoQueryCapture::bCapturing = true;
+
+	UE_LOG(LogNavigation, Display, TEXT("NavSvo query capture: Recording queries to '%s'"), *Filename);
+	return true;
+}
+
+void FNavSvoQueryCapture::End()
+{
+	FScopeLock Lock(&NavSvoQueryCapture::Lock);
+
+	if (!NavSvoQueryCapture::Writer)
+	{
+		return;
+	}
+
+	NavSvoQueryCapture::bCapturing = false;
+
+	if (NavSvoQueryCapture::Writer->Close())
+	{
+		UE_LOG(LogNavigation, Display, TEXT("NavSvo query capture: Recorded %d queries over %.1fs to '%s'"),
+			NavSvoQueryCapture::NumQueries, FPlatformTime::Seconds() - NavSvoQueryCapture::StartTime, *NavSvoQueryCapture::Filename);
+	}
+	else
+	{
+		UE_LOG(LogNavigation, Error, TEXT("NavSvo query capture: Failed to finish writing '%s'"), *NavSvoQueryCapture::Filename);
+	}
+
+	NavSvoQueryCapture::Writer.Reset();
+	NavSvoQueryCapture::NavDataIndices.Empty();
+	NavSvoQueryCapture::FilterIndices.Empty();
+	NavSvoQueryCapture::Filters.Empty();
+}
+
+bool FNavSvoQueryCapture::IsCapturing()
+{
+	return NavSvoQueryCapture::bCapturing.load(std::memory_order_relaxed);
+}
+
+void FNavSvoQueryCapture::Record(ENavSvoCapturedQueryType Type, const ANavigationData& NavData, const FVector& Start, const FVector& End, const FNavigationQueryFilter* Filter, bool bAllowPartialPaths /* = false */)
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	// Flatten the filter before taking the lock, since it's the bulk of the work
+	TArray<uint8> FilterData;
+	if (Filter != nullptr && Filter->GetImplementation() != nullptr)
+	{
+		FMemoryWriter FilterWriter(FilterData);
+
+		uint32 MaxSearchNodes = Filter->GetMaxSearchNodes();
+		FilterWriter << MaxSearchNodes;
+
+		FGunfire3DNavQueryFilter FilterImpl(*StaticCast<const FGunfire3DNavQueryFilter*>(Filter->GetImplementation()));
+		FilterImpl.Serialize(FilterWriter);
+	}
+
+	FNavSvoCapturedQuery Query;
+	Query.Type = Type;
+	Query.bAllowPartialPaths = bAllowPartialPaths;
+	Query.Start = Start;
+	Query.End = End;
+
+	FScopeLock Lock(&NavSvoQueryCapture::Lock);
+
+	// The capture may have ended while we were getting ready
+	if (!NavSvoQueryCapture::Writer)
+	{
+		return;
+	}
+
+	Query.Time = FPlatformTime::Seconds() - NavSvoQueryCapture::StartTime;
+	Query.NavDataIdx = NavSvoQueryCapture::FindOrWriteNavData(NavData);
+	Query.FilterIdx = (FilterData.Num() > 0) ? NavSvoQueryCapture::FindOrWriteFilter(MoveTemp(FilterData)) : INDEX_NONE;
+
+	NavSvoQueryCapture::ERecordType RecordType = NavSvoQueryCapture::ERecordType::Query;
+	*NavSvoQueryCapture::Writer << RecordType;
+	NavSvoQueryCapture::SerializeQuery(*NavSvoQueryCapture::Writer, Query);
+
+	++NavSvoQueryCapture::NumQueries;
+}
+
+bool FNavSvoQueryCapture::Load(const FString& Filename, FNavSvoQueryCaptureData& OutData)
+{
+	OutData = FNavSvoQueryCaptureData();
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("NavSvo query capture: Failed to read '%s'"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+
+	if (Magic != NavSvoQueryCapture::FileMagic || Version != NavSvoQueryCapture::FileVersion)
+	{
+		UE_LOG(LogNavigation, Error, TEXT("NavSvo query capture: '%s' isn't a valid capture"), *Filename);
+		return false;
+	}
+
+	while (!Reader->AtEnd() && !Reader->IsError())
+	{
+		NavSvoQueryCapture::ERecordType RecordType;
+		*Reader << RecordType;
+
+		switch (RecordType)
+		{
+		case NavSvoQueryCapture::ERecordType::NavData:
+			*Reader << OutData.NavDataNames.AddDefaulted_GetRef();
+			break;
+
+		case NavSvoQueryCapture::ERecordType::Filter:
+			*Reader << OutData.Filters.AddDefaulted_GetRef();
+			break;
+
+		case NavSvoQueryCapture::ERecordType::Query:
+		{
+			FNavSvoCapturedQuery Query;
+			NavSvoQueryCapture::SerializeQuery(*Reader, Query);
+
+			if (!Reader->IsError())
+			{
+				OutData.Queries.Add(Query);
+			}
+			break;
+		}
+
+		default:
+			Reader->SetError();
+			break;
+		}
+	}
+
+	// A capture that wasn't ended cleanly (e.g. the process crashed) is cut off part way
+	// through a record, but everything before that is still good.
+	if (Reader->IsError())
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("NavSvo query capture: '%s' is truncated, replaying the first %d queries"), *Filename, OutData.Queries.Num());
+	}
+
+	return true;
+}
+
+FSharedConstNavQueryFilter FNavSvoQueryCapture::CreateFilter(const ANavigationData& NavData, TArrayView<const uint8> FilterData)
+{
+	FSharedNavQueryFilter Filter = NavData.GetDefaultQueryFilter()->GetCopy();
+
+	FMemoryReaderView FilterReader(FilterData);
+
+	uint32 MaxSearchNodes = 0;
+	FilterReader << MaxSearchNodes;
+	Filter->SetMaxSearchNodes(MaxSearchNodes);
+
+	if (FGunfire3DNavQueryFilter* FilterImpl = StaticCast<FGunfire3DNavQueryFilter*>(Filter->GetImplementation()))
+	{
+		FilterImpl->Serialize(FilterReader);
+	}
+
+	return Filter;
+}
+
+const TCHAR* FNavSvoQueryCapture::GetTypeName(ENavSvoCapturedQueryType Type)
+{
+	switch (Type)
+	{
+	case ENavSvoCapturedQueryType::FindPath: return TEXT("FindPath");
+	case ENavSvoCapturedQueryType::FindHierarchicalPath: return TEXT("FindHierarchicalPath");
+	case ENavSvoCapturedQueryType::TestPath: return TEXT("TestPath");
+	case ENavSvoCapturedQueryType::ProjectPoint: return TEXT("ProjectPoint");
+	case ENavSvoCapturedQueryType::Raycast: return TEXT("Raycast");
+	default: return TEXT("Unknown");
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand CmdNavSvoCaptureQueries(
+	TEXT("NavSvo.CaptureQueries"),
+	TEXT("Starts or stops recording every query made on the 3D navigation data, for replaying with the Gunfire3DNavQueryReplay commandlet. Usage: NavSvo.CaptureQueries [Filename]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (FNavSvoQueryCapture::IsCapturing())
+		{
+			FNavSvoQueryCapture::End();
+			return;
+		}
+
+		const FString Filename = (Args.Num() > 0) ? Args[0] :
+			FPaths::ProfilingDir() / TEXT("NavSvo") / FString::Printf(TEXT("Queries-%s-%s.navq"), World ? *World->GetMapName() : TEXT("None"), *FDateTime::Now().ToString());
+
+		FNavSvoQueryCapture::Begin(Filename);
+	}));
+
+#endif // !UE_BUILD_SHIPPING
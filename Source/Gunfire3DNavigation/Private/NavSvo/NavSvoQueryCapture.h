@@ -0,0 +1,92 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "NavFilters/NavigationQueryFilter.h"
+
+class ANavigationData;
+
+enum class ENavSvoCapturedQueryType : uint8
+{
+	FindPath,
+	FindHierarchicalPath,
+	TestPath,
+	ProjectPoint,
+	Raycast,
+
+	Num
+};
+
+struct FNavSvoCapturedQuery
+{
+	ENavSvoCapturedQueryType Type = ENavSvoCapturedQueryType::FindPath;
+	bool bAllowPartialPaths = false;
+
+	// Seconds since the capture began
+	double Time = 0.0;
+
+	FVector Start = FVector::ZeroVector;
+
+	// The end of paths and rays, or the extent of point projections
+	FVector End = FVector::ZeroVector;
+
+	// Index of the nav data the query was made on, in FNavSvoQueryCaptureData::NavDataNames
+	int32 NavDataIdx = INDEX_NONE;
+
+	// Index of the filter in FNavSvoQueryCaptureData::Filters, or INDEX_NONE if the query
+	// used the default filter of the nav data
+	int32 FilterIdx = INDEX_NONE;
+};
+
+//
+// The contents of a capture file, as read back by FNavSvoQueryCapture::Load.
+//
+struct FNavSvoQueryCaptureData
+{
+	TArray<FString> NavDataNames;
+
+	// The serialized settings of each distinct filter used (see FNavSvoQueryCapture::CreateFilter)
+	TArray<TArray<uint8>> Filters;
+
+	TArray<FNavSvoCapturedQuery> Queries;
+};
+
+//
+// Records path finding, path tests, point projections and raycasts made on the 3D nav data
+// to a file, so real query loads can be replayed offline against the same octree (see
+// UGunfire3DNavQueryReplayCommandlet) when comparing changes to the query code.
+//
+// The file is a header followed by a stream of records. Nav data names and filters are
+// written once, the first time a query uses them, and queries refer back to them by index.
+//
+// NOTE: Thread-safe. Queries made on any thread are recorded, in the order they finish
+// being recorded.
+//
+class FNavSvoQueryCapture
+{
+public:
+	// Ends any capture in progress
+	static void Shutdown();
+
+	// Starts recording queries to a file, ending any capture already in progress. Returns
+	// false if the file couldn't be written.
+	static bool Begin(const FString& Filename);
+
+	// Stops recording and closes the file
+	static void End();
+
+	// Cheap enough to check before every query
+	static bool IsCapturing();
+
+	// Records a query, if capturing. 'End' is the extent for point projections, and a null
+	// filter means the default filter of the nav data.
+	static void Record(ENavSvoCapturedQueryType Type, const ANavigationData& NavData, const FVector& Start, const FVector& End, const FNavigationQueryFilter* Filter, bool bAllowPartialPaths = false);
+
+	// Reads a capture file, returning false if it isn't one
+	static bool Load(const FString& Filename, FNavSvoQueryCaptureData& OutData);
+
+	// Recreates a captured filter for a nav data
+	static FSharedConstNavQueryFilter CreateFilter(const ANavigationData& NavData, TArrayView<const uint8> FilterData);
+
+	static const TCHAR* GetTypeName(ENavSvoCapturedQueryType Type);
+};
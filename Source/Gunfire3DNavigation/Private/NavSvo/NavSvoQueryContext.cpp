@@ -0,0 +1,91 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoQueryContext.h"
+
+namespace
+{
+	// Upper bound on idle contexts kept around per thread. Queries only nest a couple
+	// deep so anything past this is just wasted memory.
+	const int32 kMaxCachedContextsPerThread = 4;
+
+	typedef TArray<FNavSvoQueryContext*, TInlineAllocator<kMaxCachedContextsPerThread>> FContextArray;
+
+	struct FThreadContextCache
+	{
+		~FThreadContextCache()
+		{
+			for (FNavSvoQueryContext* Context : FreeContexts)
+			{
+				delete Context;
+			}
+		}
+
+		FContextArray FreeContexts;
+	};
+
+	thread_local FThreadContextCache ThreadContextCache;
+
+	// Memory used by all the contexts, for budgeting
+	std::atomic<uint64> TotalMemUsed(0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoQueryContext
+//////////////////////////////////////////////////////////////////////////
+
+FNavSvoQueryContext::~FNavSvoQueryContext()
+{
+	TotalMemUsed -= TrackedMemUsed;
+}
+
+void FNavSvoQueryContext::Init(uint32 MaxSearchNodes)
+{
+	NodePool.Init(MaxSearchNodes, FMath::RoundUpToPowerOfTwo(MaxSearchNodes / 4));
+	OpenList.Init(MaxSearchNodes, NodePool);
+
+	// The buffers only ever grow here, so this is the only place the total can change
+	const uint32 MemUsed = GetMemUsed();
+	if (MemUsed != TrackedMemUsed)
+	{
+		TotalMemUsed += MemUsed;
+		TotalMemUsed -= TrackedMemUsed;
+		TrackedMemUsed = MemUsed;
+	}
+}
+
+uint32 FNavSvoQueryContext::GetMemUsed() const
+{
+	return sizeof(*this) +
+		NodePool.GetMemUsed() +
+		OpenList.GetMemUsed() +
+		ClosedLeafVoxels.GetAllocatedSize();
+}
+
+uint64 FNavSvoQueryContext::GetTotalMemUsed()
+{
+	return TotalMemUsed;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NavSvoScopedQueryContext
+//////////////////////////////////////////////////////////////////////////
+
+FNavSvoScopedQueryContext::FNavSvoScopedQueryContext(uint32 MaxSearchNodes)
+{
+	FContextArray& FreeContexts = ThreadContextCache.FreeContexts;
+	Context = (FreeContexts.Num() > 0) ? FreeContexts.Pop(false) : new FNavSvoQueryContext();
+	Context->Init(MaxSearchNodes);
+}
+
+FNavSvoScopedQueryContext::~FNavSvoScopedQueryContext()
+{
+	FContextArray& FreeContexts = ThreadContextCache.FreeContexts;
+	if (FreeContexts.Num() < kMaxCachedContextsPerThread)
+	{
+		FreeContexts.Push(Context);
+	}
+	else
+	{
+		delete Context;
+	}
+}
@@ -0,0 +1,57 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "NavSvoNode.h"
+
+//
+// Search buffers used by a single query. Contexts are cached per-thread and handed out
+// through FNavSvoScopedQueryContext so repeated queries don't need to reallocate the
+// node pool and open list every time.
+//
+class FNavSvoQueryContext
+{
+public:
+	~FNavSvoQueryContext();
+
+	// Prepares the context for a query with the specified node limit, growing the
+	// buffers if this is the largest query it's been used for.
+	void Init(uint32 MaxSearchNodes);
+
+	uint32 GetMemUsed() const;
+
+	// Returns the memory used by every context on every thread
+	static uint64 GetTotalMemUsed();
+
+	FNavSvoNodePool NodePool;
+	FNavSvoNodeQueue OpenList;
+
+	// Mask of the voxels closed so far in each leaf, so opening a leaf's face voxels
+	// doesn't need to look each of them up in the pool
+	TMap<FSvoNodeLink, uint64> ClosedLeafVoxels;
+
+private:
+	// What this context last added to the total
+	uint32 TrackedMemUsed = 0;
+};
+
+//
+// Acquires a query context from the calling thread's cache for the lifetime of the
+// scope. Nested scopes on the same thread each get their own context.
+//
+// NOTE: Must be released on the thread it was acquired on.
+//
+class FNavSvoScopedQueryContext
+{
+public:
+	FNavSvoScopedQueryContext(uint32 MaxSearchNodes);
+	~FNavSvoScopedQueryContext();
+
+	FNavSvoScopedQueryContext(const FNavSvoScopedQueryContext&) = delete;
+	FNavSvoScopedQueryContext& operator=(const FNavSvoScopedQueryContext&) = delete;
+
+	FNavSvoQueryContext& Get() const { return *Context; }
+
+private:
+	FNavSvoQueryContext* Context = nullptr;
+};
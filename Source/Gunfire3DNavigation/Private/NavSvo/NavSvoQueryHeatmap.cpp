@@ -0,0 +1,234 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoQueryHeatmap.h"
+
+#include "NavSvoNode.h"
+#include "SparseVoxelOctree/SparseVoxelOctree.h"
+
+#include "HAL/IConsoleManager.h"
+
+#include <atomic>
+
+DECLARE_CYCLE_STAT(TEXT("RecordSearchHeatmap"), STAT_RecordSearchHeatmap, STATGROUP_Gunfire3DNavigation);
+
+TAutoConsoleVariable<bool> CVarNavSvoQueryHeatmap(TEXT("NavSvo.QueryHeatmap"), false, TEXT("Collects how many times each tile and node is opened or visited by searches, for the query heatmap on the debug actor."), ECVF_Cheat);
+TAutoConsoleVariable<float> CVarNavSvoQueryHeatmapWindow(TEXT("NavSvo.QueryHeatmapWindow"), 10.f, TEXT("How many seconds of searches the query heatmap covers."), ECVF_Cheat);
+
+namespace NavSvoQueryHeatmap
+{
+	typedef FNavSvoQueryHeatmap::FHeat FHeat;
+
+	// The window slides in steps of a bucket, so older searches drop off a bucket at a
+	// time instead of needing a timestamp per search.
+	static constexpr int32 NumBuckets = 8;
+
+	struct FBucket
+	{
+		double StartTime = 0.0;
+		TMap<uint32, FHeat> Tiles;
+		TMap<uint64, FHeat> Nodes;
+
+		void Reset(double InStartTime)
+		{
+			StartTime = InStartTime;
+			Tiles.Reset();
+			Nodes.Reset();
+		}
+	};
+
+	struct FOctreeHeatmap
+	{
+		FBucket Buckets[NumBuckets];
+		int32 CurrentBucket = 0;
+	};
+
+	std::atomic<int32> NumUsers(0);
+
+	FCriticalSection Lock;
+
+	// Octrees are only used as keys, never dereferenced
+	TMap<const FSparseVoxelOctree*, FOctreeHeatmap> Octrees;
+
+	// Drops the buckets which have slid out of the window. Must be called with the lock
+	// held.
+	void AdvanceBuckets(FOctreeHeatmap& Heatmap, double Now)
+	{
+		const double WindowDuration = FMath::Max(CVarNavSvoQueryHeatmapWindow.GetValueOnAnyThread(), 0.1f);
+		const double BucketDuration = WindowDuration / NumBuckets;
+
+		FBucket& Current = Heatmap.Buckets[Heatmap.CurrentBucket];
+
+		// If nothing has been recorded for the whole window, start over
+		if ((Now - Current.StartTime) >= WindowDuration)
+		{
+			for (FBucket& Bucket : Heatmap.Buckets)
+			{
+				Bucket.Reset(Now);
+			}
+
+			return;
+		}
+
+		while ((Now - Heatmap.Buckets[Heatmap.CurrentBucket].StartTime) >= BucketDuration)
+		{
+			const double NextStartTime = Heatmap.Buckets[Heatmap.CurrentBucket].StartTime + BucketDuration;
+
+			Heatmap.CurrentBucket = (Heatmap.CurrentBucket + 1) % NumBuckets;
+			Heatmap.Buckets[Heatmap.CurrentBucket].Reset(NextStartTime);
+		}
+	}
+}
+
+bool FNavSvoQueryHeatmap::IsEnabled()
+{
+	return NavSvoQueryHeatmap::NumUsers.load(std::memory_order_relaxed) > 0 || CVarNavSvoQueryHeatmap.GetValueOnAnyThread();
+}
+
+void FNavSvoQueryHeatmap::AddUser()
+{
+	++NavSvoQueryHeatmap::NumUsers;
+}
+
+void FNavSvoQueryHeatmap::RemoveUser()
+{
+	const int32 NumUsers = --NavSvoQueryHeatmap::NumUsers;
+	ensure(NumUsers >= 0);
+}
+
+void FNavSvoQueryHeatmap::RecordSearch(const FSparseVoxelOctree& Octree, const FNavSvoNodePool& NodePool)
+{
+	using namespace NavSvoQueryHeatmap;
+
+	SCOPE_CYCLE_COUNTER(STAT_RecordSearchHeatmap);
+
+	const uint32 NodeCount = NodePool.GetNodeCount();
+	if (NodeCount == 0)
+	{
+		return;
+	}
+
+	// Sum up the tiles first, since a search usually only touches a few of them and
+	// this keeps the time spent holding the lock down.
+	TMap<uint32, FHeat, TInlineSetAllocator<16>> SearchTiles;
+	uint32 LastTileID = SVO_INVALID_ID;
+	FHeat* LastTileHeat = nullptr;
+
+	for (uint32 NodeIdx = 0; NodeIdx < NodeCount; ++NodeIdx)
+	{
+		const FNavSvoNode* SearchNode = NodePool.GetNodeAtIndex(NodeIdx);
+
+		if (SearchNode->NodeLink.TileID != LastTileID)
+		{
+			LastTileID = SearchNode->NodeLink.TileID;
+			LastTileHeat = &SearchTiles.FindOrAdd(LastTileID);
+		}
+
+		++LastTileHeat->NumOpened;
+		if (SearchNode->Flags & NAVSVONODE_CLOSED)
+		{
+			++LastTileHeat->NumVisited;
+		}
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FOctreeHeatmap& Heatmap = Octrees.FindOrAdd(&Octree);
+	AdvanceBuckets(Heatmap, FPlatformTime::Seconds());
+
+	FBucket& Bucket = Heatmap.Buckets[Heatmap.CurrentBucket];
+
+	for (const TPair<uint32, FHeat>& SearchTile : SearchTiles)
+	{
+		Bucket.Tiles.FindOrAdd(SearchTile.Key) += SearchTile.Value;
+	}
+
+	for (uint32 NodeIdx = 0; NodeIdx < NodeCount; ++NodeIdx)
+	{
+		const FNavSvoNode* SearchNode = NodePool.GetNodeAtIndex(NodeIdx);
+
+		FHeat& NodeHeat = Bucket.Nodes.FindOrAdd(SearchNode->NodeLink.GetID());
+		++NodeHeat.NumOpened;
+		if (SearchNode->Flags & NAVSVONODE_CLOSED)
+		{
+			++NodeHeat.NumVisited;
+		}
+	}
+}
+
+void FNavSvoQueryHeatmap::GetTileHeat(const FSparseVoxelOctree& Octree, TMap<uint32, FHeat>& OutTileHeat)
+{
+	using namespace NavSvoQueryHeatmap;
+
+	OutTileHeat.Reset();
+
+	FScopeLock ScopeLock(&Lock);
+
+	FOctreeHeatmap* Heatmap = Octrees.Find(&Octree);
+	if (Heatmap == nullptr)
+	{
+		return;
+	}
+
+	AdvanceBuckets(*Heatmap, FPlatformTime::Seconds());
+
+	for (const FBucket& Bucket : Heatmap->Buckets)
+	{
+		for (const TPair<uint32, FHeat>& TileHeat : Bucket.Tiles)
+		{
+			OutTileHeat.FindOrAdd(TileHeat.Key) += TileHeat.Value;
+		}
+	}
+}
+
+void FNavSvoQueryHeatmap::GetHottestNodes(const FSparseVoxelOctree& Octree, int32 MaxNodes, TArray<TPair<uint64, FHeat>>& OutNodeHeat)
+{
+	using namespace NavSvoQueryHeatmap;
+
+	OutNodeHeat.Reset();
+
+	TMap<uint64, FHeat> NodeHeat;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		FOctreeHeatmap* Heatmap = Octrees.Find(&Octree);
+		if (Heatmap == nullptr)
+		{
+			return;
+		}
+
+		AdvanceBuckets(*Heatmap, FPlatformTime::Seconds());
+
+		for (const FBucket& Bucket : Heatmap->Buckets)
+		{
+			for (const TPair<uint64, FHeat>& BucketNodeHeat : Bucket.Nodes)
+			{
+				NodeHeat.FindOrAdd(BucketNodeHeat.Key) += BucketNodeHeat.Value;
+			}
+		}
+	}
+
+	OutNodeHeat = NodeHeat.Array();
+	OutNodeHeat.Sort([](const TPair<uint64, FHeat>& A, const TPair<uint64, FHeat>& B)
+	{
+		return A.Value.NumVisited > B.Value.NumVisited;
+	});
+
+	if (OutNodeHeat.Num() > MaxNodes)
+	{
+		OutNodeHeat.SetNum(FMath::Max(MaxNodes, 0));
+	}
+}
+
+void FNavSvoQueryHeatmap::Reset()
+{
+	FScopeLock ScopeLock(&NavSvoQueryHeatmap::Lock);
+	NavSvoQueryHeatmap::Octrees.Reset();
+}
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommand CmdNavSvoResetQueryHeatmap(
+	TEXT("NavSvo.ResetQueryHeatmap"),
+	TEXT("Discards everything collected for the query heatmap."),
+	FConsoleCommandDelegate::CreateStatic(&FNavSvoQueryHeatmap::Reset));
+#endif
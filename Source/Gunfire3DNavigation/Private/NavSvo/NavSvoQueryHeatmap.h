@@ -0,0 +1,54 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FNavSvoNodePool;
+class FSparseVoxelOctree;
+
+//
+// Optional profiling of where searches spend their time. While NavSvo.QueryHeatmap is
+// enabled (or something is drawing the heatmap), every search adds how many times each
+// tile and node was opened or visited to a sliding window, which the debug actor can draw
+// to find the geometry causing search floods.
+//
+// NOTE: Searches can finish on any thread, so everything here is guarded by a lock.
+//
+class FNavSvoQueryHeatmap
+{
+public:
+	struct FHeat
+	{
+		uint32 NumOpened = 0;
+		uint32 NumVisited = 0;
+
+		FHeat& operator+=(const FHeat& Other)
+		{
+			NumOpened += Other.NumOpened;
+			NumVisited += Other.NumVisited;
+			return *this;
+		}
+	};
+
+	static bool IsEnabled();
+
+	// Adds or removes something that needs the heatmap collected, so drawing it doesn't
+	// also require the console variable to be set.
+	static void AddUser();
+	static void RemoveUser();
+
+	// Adds the nodes touched by a finished search. Every node in the pool was opened, and
+	// the closed ones were visited.
+	static void RecordSearch(const FSparseVoxelOctree& Octree, const FNavSvoNodePool& NodePool);
+
+	// Gathers the heat of each tile (by ID) within the window
+	static void GetTileHeat(const FSparseVoxelOctree& Octree, TMap<uint32, FHeat>& OutTileHeat);
+
+	// Gathers the heat of up to 'MaxNodes' of the most visited nodes (by link ID) within
+	// the window, hottest first.
+	static void GetHottestNodes(const FSparseVoxelOctree& Octree, int32 MaxNodes, TArray<TPair<uint64, FHeat>>& OutNodeHeat);
+
+	// Discards everything collected so far
+	static void Reset();
+};
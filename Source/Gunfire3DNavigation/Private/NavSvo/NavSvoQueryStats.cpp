@@ -0,0 +1,144 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoQueryStats.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "NavigationData.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Trace/Trace.inl"
+
+TAutoConsoleVariable<bool> CVarNavSvoQueryTimings(TEXT("NavSvo.QueryTimings"), false, TEXT("Captures per-query timings, sends each path query to Unreal Insights and writes per-frame latency percentiles to the CSV profiler."), ECVF_Cheat);
+
+CSV_DEFINE_CATEGORY(Gunfire3DNav, true);
+
+UE_TRACE_CHANNEL_DEFINE(Gunfire3DNavChannel)
+
+UE_TRACE_EVENT_BEGIN(Gunfire3DNav, PathQuery)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, QueryID)
+	UE_TRACE_EVENT_FIELD(uint16, Status)
+	UE_TRACE_EVENT_FIELD(uint32, NumNodesVisited)
+	UE_TRACE_EVENT_FIELD(uint32, NumNodesOpened)
+	UE_TRACE_EVENT_FIELD(float, Latency)
+	UE_TRACE_EVENT_FIELD(float, NodeLookupTime)
+	UE_TRACE_EVENT_FIELD(float, SearchTime)
+	UE_TRACE_EVENT_FIELD(float, StringPullTime)
+	UE_TRACE_EVENT_FIELD(float, SmoothingTime)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Agent)
+UE_TRACE_EVENT_END()
+
+namespace NavSvoQueryStats
+{
+	std::atomic<uint32> LastQueryID(0);
+
+	FDelegateHandle EndFrameHandle;
+
+	// Queries recorded since the end of the last frame. Paths can be found on any
+	// thread so these are guarded by the lock.
+	FCriticalSection FrameLock;
+	TArray<float> FrameLatencies;
+	TArray<float> FrameNodeCounts;
+
+	// Swapped with the frame arrays at the end of each frame, so neither needs to be
+	// reallocated every frame.
+	TArray<float> SortedLatencies;
+	TArray<float> SortedNodeCounts;
+
+	float GetPercentile(const TArray<float>& SortedValues, float Percentile)
+	{
+		const int32 ValueIdx = FMath::CeilToInt(Percentile * SortedValues.Num()) - 1;
+		return SortedValues[FMath::Clamp(ValueIdx, 0, SortedValues.Num() - 1)];
+	}
+}
+
+void FNavSvoQueryStats::Startup()
+{
+	NavSvoQueryStats::EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&FNavSvoQueryStats::OnEndFrame);
+}
+
+void FNavSvoQueryStats::Shutdown()
+{
+	FCoreDelegates::OnEndFrame.Remove(NavSvoQueryStats::EndFrameHandle);
+	NavSvoQueryStats::EndFrameHandle.Reset();
+}
+
+bool FNavSvoQueryStats::IsEnabled()
+{
+	return CVarNavSvoQueryTimings.GetValueOnAnyThread();
+}
+
+uint32 FNavSvoQueryStats::NextQueryID()
+{
+	// NOTE: Zero is reserved for queries which weren't timed
+	uint32 QueryID = ++NavSvoQueryStats::LastQueryID;
+	if (QueryID == 0)
+	{
+		QueryID = ++NavSvoQueryStats::LastQueryID;
+	}
+
+	return QueryID;
+}
+
+void FNavSvoQueryStats::RecordPathQuery(const FPathFindingQuery& Query, const FGunfire3DNavQueryResults& Results, float Latency)
+{
+	const FGunfire3DNavQueryTimings& Timings = Results.Timings;
+
+#if UE_TRACE_ENABLED
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(Gunfire3DNavChannel))
+	{
+		const FString AgentName = GetNameSafe(Query.Owner.Get());
+
+		UE_TRACE_LOG(Gunfire3DNav, PathQuery, Gunfire3DNavChannel)
+			<< PathQuery.Cycle(FPlatformTime::Cycles64())
+			<< PathQuery.QueryID(Timings.QueryID)
+			<< PathQuery.Status(Results.Status)
+			<< PathQuery.NumNodesVisited(Results.NumNodesVisited)
+			<< PathQuery.NumNodesOpened(Results.NumNodesOpened)
+			<< PathQuery.Latency(Latency)
+			<< PathQuery.NodeLookupTime(Timings.NodeLookupTime)
+			<< PathQuery.SearchTime(Timings.SearchTime)
+			<< PathQuery.StringPullTime(Timings.StringPullTime)
+			<< PathQuery.SmoothingTime(Timings.SmoothingTime)
+			<< PathQuery.Agent(*AgentName, AgentName.Len());
+	}
+#endif
+
+#if CSV_PROFILER
+	FScopeLock ScopeLock(&NavSvoQueryStats::FrameLock);
+	NavSvoQueryStats::FrameLatencies.Add(Latency);
+	NavSvoQueryStats::FrameNodeCounts.Add((float)Results.NumNodesVisited);
+#endif
+}
+
+void FNavSvoQueryStats::OnEndFrame()
+{
+#if CSV_PROFILER
+	using namespace NavSvoQueryStats;
+
+	{
+		FScopeLock ScopeLock(&FrameLock);
+		Swap(FrameLatencies, SortedLatencies);
+		Swap(FrameNodeCounts, SortedNodeCounts);
+	}
+
+	if (SortedLatencies.Num() == 0)
+	{
+		return;
+	}
+
+	SortedLatencies.Sort();
+	SortedNodeCounts.Sort();
+
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathQueries, SortedLatencies.Num(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathLatencyP50, GetPercentile(SortedLatencies, 0.50f), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathLatencyP95, GetPercentile(SortedLatencies, 0.95f), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathLatencyP99, GetPercentile(SortedLatencies, 0.99f), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathNodesP50, GetPercentile(SortedNodeCounts, 0.50f), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathNodesP95, GetPercentile(SortedNodeCounts, 0.95f), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(Gunfire3DNav, PathNodesP99, GetPercentile(SortedNodeCounts, 0.99f), ECsvCustomStatOp::Set);
+
+	SortedLatencies.Reset();
+	SortedNodeCounts.Reset();
+#endif
+}
@@ -0,0 +1,90 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Gunfire3DNavQueryFilter.h"
+
+struct FPathFindingQuery;
+
+//
+// Optional per-query profiling. While NavSvo.QueryTimings is enabled, queries fill in the
+// timings on their results, every finished path query is sent to Unreal Insights on the
+// Gunfire3DNav trace channel, and the latency and node count percentiles for each frame
+// are written to the Gunfire3DNav CSV profiler category.
+//
+class FNavSvoQueryStats
+{
+public:
+	static void Startup();
+	static void Shutdown();
+
+	static bool IsEnabled();
+
+	// Returns a unique ID for a query, so its trace events can be told apart
+	static uint32 NextQueryID();
+
+	// Records a finished path query. 'Latency' is the total time spent on the query in
+	// milliseconds, which may include work that isn't part of any timed stage.
+	static void RecordPathQuery(const FPathFindingQuery& Query, const FGunfire3DNavQueryResults& Results, float Latency);
+
+private:
+	static void OnEndFrame();
+};
+
+//
+// Adds the time spent within the scope to one of the query timings, if enabled.
+//
+class FNavSvoScopedQueryTimer
+{
+public:
+	FNavSvoScopedQueryTimer(float& InOutTime)
+		: Time(FNavSvoQueryStats::IsEnabled() ? &InOutTime : nullptr)
+		, StartCycles(Time != nullptr ? FPlatformTime::Cycles64() : 0)
+	{}
+
+	~FNavSvoScopedQueryTimer()
+	{
+		if (Time != nullptr)
+		{
+			*Time += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	float* Time;
+	uint64 StartCycles;
+};
+
+//
+// Assigns an ID to a path query for the lifetime of the scope and records it once the
+// scope ends, if timings are enabled.
+//
+class FNavSvoScopedPathQueryStats
+{
+public:
+	FNavSvoScopedPathQueryStats(const FPathFindingQuery& InQuery, FGunfire3DNavQueryResults& InResults)
+		: Query(InQuery)
+		, Results(InResults)
+		, bEnabled(FNavSvoQueryStats::IsEnabled())
+		, StartCycles(bEnabled ? FPlatformTime::Cycles64() : 0)
+	{
+		if (bEnabled)
+		{
+			Results.Timings.QueryID = FNavSvoQueryStats::NextQueryID();
+		}
+	}
+
+	~FNavSvoScopedPathQueryStats()
+	{
+		if (bEnabled)
+		{
+			FNavSvoQueryStats::RecordPathQuery(Query, Results, FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+		}
+	}
+
+private:
+	const FPathFindingQuery& Query;
+	FGunfire3DNavQueryResults& Results;
+	const bool bEnabled;
+	const uint64 StartCycles;
+};
@@ -6,6 +6,7 @@
 #include "NavSvoGenerator.h"
 #include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
 
+#include "Async/ParallelFor.h"
 #include "Misc/EngineVersionComparison.h"
 
 const FColor FNavSvoSceneProxy::LayerColors[] =
@@ -19,20 +20,103 @@ const FColor FNavSvoSceneProxy::LayerColors[] =
 	FColor::Yellow
 };
 
-FNavSvoSceneProxy::FNavSvoSceneProxy(const UPrimitiveComponent* InComponent, const AGunfire3DNavData* NavData)
-	: FPrimitiveSceneProxy(InComponent)
-	, VertexFactory(GetScene().GetFeatureLevel(), "FNavSvoSceneProxy")
+FNavSvoDebugMeshChunk::FNavSvoDebugMeshChunk(ERHIFeatureLevel::Type FeatureLevel)
+	: VertexFactory(FeatureLevel, "FNavSvoDebugMeshChunk")
 {
-	NavDebugMaterial = LoadObject<UMaterial>(nullptr, TEXT("/Gunfire3DNavigation/VertexColorWireframeMaterial"));
-	NavDebugMaterial->AddToRoot();
+}
 
-	TArray<FTileBuildData> BuildTiles;
-	GatherData(NavData, BuildTiles);
+FNavSvoDebugMeshChunkPtr FNavSvoDebugMeshChunk::Create(ERHIFeatureLevel::Type FeatureLevel, const FBox& Bounds, TArrayView<const FLine> Lines)
+{
+	FNavSvoDebugMeshChunk* Chunk = new FNavSvoDebugMeshChunk(FeatureLevel);
+	Chunk->Bounds = Bounds;
+	Chunk->NumLines = Lines.Num();
+
+	const uint32 NumVerts = Chunk->NumLines * 2;
 
-	InitRenderData(BuildTiles);
+	// The vertices are never read back, so let the buffers drop their copies once
+	// they've been uploaded
+	Chunk->VertexBuffers.PositionVertexBuffer.Init(NumVerts, false /* bInNeedsCPUAccess */);
+	// We don't use the tangents or UV's from the static mesh, but we need something
+	// there to bind so we just make 1 element buffers.
+	Chunk->VertexBuffers.StaticMeshVertexBuffer.Init(1, 1);
+	Chunk->VertexBuffers.ColorVertexBuffer.Init(NumVerts, false /* bNeedsCPUAccess */);
+	Chunk->IndexBuffer.Indices.SetNumUninitialized(NumVerts);
+
+	uint32 CurVert = 0;
+
+	for (const FLine& Line : Lines)
+	{
+		Chunk->VertexBuffers.PositionVertexBuffer.VertexPosition(CurVert + 0) = FVector3f(Line.A.X, Line.A.Y, Line.A.Z);
+		Chunk->VertexBuffers.PositionVertexBuffer.VertexPosition(CurVert + 1) = FVector3f(Line.B.X, Line.B.Y, Line.B.Z);
+		Chunk->VertexBuffers.ColorVertexBuffer.VertexColor(CurVert + 0) = Line.Color;
+		Chunk->VertexBuffers.ColorVertexBuffer.VertexColor(CurVert + 1) = Line.Color;
+
+		Chunk->IndexBuffer.Indices[CurVert + 0] = CurVert + 0;
+		Chunk->IndexBuffer.Indices[CurVert + 1] = CurVert + 1;
+
+		CurVert += 2;
+	}
+
+	ENQUEUE_RENDER_COMMAND(NavSvoDebugMeshChunkInit)(
+		[Chunk](FRHICommandListImmediate& RHICmdList)
+		{
+			Chunk->InitResources(RHICmdList);
+		});
+
+	// Proxies holding the chunk are destroyed on the render thread, but the cache can
+	// drop it on the game thread, so always hand the release over to the render thread
+	return FNavSvoDebugMeshChunkPtr(Chunk, [](FNavSvoDebugMeshChunk* ChunkToRelease)
+	{
+		ENQUEUE_RENDER_COMMAND(NavSvoDebugMeshChunkRelease)(
+			[ChunkToRelease](FRHICommandListImmediate& RHICmdList)
+			{
+				ChunkToRelease->ReleaseResources();
+				delete ChunkToRelease;
+			});
+	});
 }
 
-FNavSvoSceneProxy::~FNavSvoSceneProxy()
+uint32 FNavSvoDebugMeshChunk::GetMemoryFootprint() const
+{
+	return sizeof(*this) + IndexBuffer.Indices.GetAllocatedSize() +
+		VertexBuffers.PositionVertexBuffer.GetNumVertices() * VertexBuffers.PositionVertexBuffer.GetStride() +
+		VertexBuffers.ColorVertexBuffer.GetNumVertices() * VertexBuffers.ColorVertexBuffer.GetStride();
+}
+
+void FNavSvoDebugMeshChunk::InitResources(FRHICommandListImmediate& RHICmdList)
+{
+#if UE_VERSION_OLDER_THAN(5, 4, 0)
+	VertexBuffers.PositionVertexBuffer.InitResource();
+	VertexBuffers.StaticMeshVertexBuffer.InitResource();
+	VertexBuffers.ColorVertexBuffer.InitResource();
+#else
+	VertexBuffers.PositionVertexBuffer.InitResource(RHICmdList);
+	VertexBuffers.StaticMeshVertexBuffer.InitResource(RHICmdList);
+	VertexBuffers.ColorVertexBuffer.InitResource(RHICmdList);
+#endif
+
+	FLocalVertexFactory::FDataType Data;
+	VertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer(&VertexFactory, Data);
+	VertexBuffers.StaticMeshVertexBuffer.BindTangentVertexBuffer(&VertexFactory, Data);
+	VertexBuffers.StaticMeshVertexBuffer.BindTexCoordVertexBuffer(&VertexFactory, Data);
+	VertexBuffers.ColorVertexBuffer.BindColorVertexBuffer(&VertexFactory, Data);
+#if UE_VERSION_OLDER_THAN(5, 4, 0)
+	VertexFactory.SetData(Data);
+
+	VertexFactory.InitResource();
+	IndexBuffer.InitResource();
+#else
+	VertexFactory.SetData(RHICmdList, Data);
+
+	VertexFactory.InitResource(RHICmdList);
+	IndexBuffer.InitResource(RHICmdList);
+#endif
+
+	// The indices have been uploaded, and aren't needed on the CPU anymore
+	IndexBuffer.Indices.Empty();
+}
+
+void FNavSvoDebugMeshChunk::ReleaseResources()
 {
 	VertexBuffers.PositionVertexBuffer.ReleaseResource();
 	VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
@@ -41,6 +125,31 @@ FNavSvoSceneProxy::~FNavSvoSceneProxy()
 	VertexFactory.ReleaseResource();
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+
+FNavSvoSceneProxy::FNavSvoSceneProxy(const UPrimitiveComponent* InComponent, const AGunfire3DNavData* NavData, FNavSvoDebugMeshCache& MeshCache)
+	: FPrimitiveSceneProxy(InComponent)
+{
+	NavDebugMaterial = LoadObject<UMaterial>(nullptr, TEXT("/Gunfire3DNavigation/VertexColorWireframeMaterial"));
+	NavDebugMaterial->AddToRoot();
+
+	GatherData(NavData, MeshCache);
+
+#if WITH_EDITOR
+	ENQUEUE_RENDER_COMMAND(NavSvoSceneProxyInit)(
+		[this](FRHICommandListImmediate& RHICmdList)
+		{
+			// We don't use any one-frame proxy materials, so make sure to register our
+			// core material as being used, otherwise the editor verification will fail.
+			SetUsedMaterialForVerification({ NavDebugMaterial });
+		});
+#endif
+}
+
+FNavSvoSceneProxy::~FNavSvoSceneProxy()
+{
+}
+
 SIZE_T FNavSvoSceneProxy::GetTypeHash() const
 {
 	static size_t UniquePointer;
@@ -49,7 +158,14 @@ SIZE_T FNavSvoSceneProxy::GetTypeHash() const
 
 uint32 FNavSvoSceneProxy::GetMemoryFootprint() const
 {
-	return sizeof(*this) + FPrimitiveSceneProxy::GetAllocatedSize();
+	uint32 MemUsed = sizeof(*this) + FPrimitiveSceneProxy::GetAllocatedSize() + Chunks.GetAllocatedSize();
+
+	for (const FNavSvoDebugMeshChunkPtr& Chunk : Chunks)
+	{
+		MemUsed += Chunk->GetMemoryFootprint();
+	}
+
+	return MemUsed;
 }
 
 void FNavSvoSceneProxy::GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const
@@ -65,23 +181,24 @@ void FNavSvoSceneProxy::GetDynamicMeshElements(const TArray<const FSceneView*>&
 				continue;
 			}
 
-			for (const FTileData& TileData : Tiles)
+			for (const FNavSvoDebugMeshChunkPtr& Chunk : Chunks)
 			{
-				if (View->ViewFrustum.IntersectBox(TileData.Bounds.GetCenter(), TileData.Bounds.GetExtent()))
+				const FBox& Bounds = Chunk->GetBounds();
+				if (View->ViewFrustum.IntersectBox(Bounds.GetCenter(), Bounds.GetExtent()))
 				{
 					FMeshBatch& Mesh = Collector.AllocateMesh();
 					FMeshBatchElement& BatchElement = Mesh.Elements[0];
 
-					Mesh.VertexFactory = &VertexFactory;
+					Mesh.VertexFactory = &Chunk->GetVertexFactory();
 					Mesh.MaterialRenderProxy = NavDebugMaterial->GetRenderProxy();
 					Mesh.Type = PT_LineList;
 
-					BatchElement.IndexBuffer = &IndexBuffer;
+					BatchElement.IndexBuffer = &Chunk->GetIndexBuffer();
 					BatchElement.PrimitiveUniformBufferResource = &GIdentityPrimitiveUniformBuffer;
-					BatchElement.FirstIndex = TileData.StartVert;
-					BatchElement.NumPrimitives = TileData.NumLines;
-					BatchElement.MinVertexIndex = TileData.StartVert;
-					BatchElement.MaxVertexIndex = TileData.StartVert + (TileData.NumLines * 2) - 1;
+					BatchElement.FirstIndex = 0;
+					BatchElement.NumPrimitives = Chunk->GetNumLines();
+					BatchElement.MinVertexIndex = 0;
+					BatchElement.MaxVertexIndex = (Chunk->GetNumLines() * 2) - 1;
 
 					Collector.AddMesh(ViewIndex, Mesh);
 				}
@@ -101,140 +218,151 @@ FPrimitiveViewRelevance FNavSvoSceneProxy::GetViewRelevance(const FSceneView* Vi
 	return Result;
 }
 
-void FNavSvoSceneProxy::InitRenderData(const TArray<FTileBuildData>& BuildData)
+void FNavSvoSceneProxy::GatherData(const AGunfire3DNavData* NavData, FNavSvoDebugMeshCache& MeshCache)
 {
-	uint32 NumUsedTiles = 0;
-	uint32 NumLines = 0;
+	const FEditableSvo* Octree = nullptr;
 
-	for (const FTileBuildData& Build : BuildData)
+	if (NavData)
 	{
-		NumLines += Build.Lines.Num();
-
-		if (Build.Lines.Num() > 0)
+		if (const FNavSvoGenerator* Generator = (FNavSvoGenerator*)NavData->GetGenerator())
 		{
-			NumUsedTiles++;
+			Octree = Generator->GetOctree();
+		}
+		else
+		{
+			Octree = NavData->GetOctree();
 		}
 	}
 
-	if (NumLines == 0)
+	if (Octree == nullptr)
 	{
+		MeshCache.Tiles.Empty();
 		return;
 	}
 
-	VertexBuffers.PositionVertexBuffer.Init(NumLines * 2);
-	// We don't use the tangents or UV's from the static mesh, but we need something
-	// there to bind so we just make 1 element buffers.
-	VertexBuffers.StaticMeshVertexBuffer.Init(1, 1);
-	VertexBuffers.ColorVertexBuffer.Init(NumLines * 2);
-	IndexBuffer.Indices.SetNumUninitialized(NumLines * 2);
+	// Chunks built for another octree or with other settings can't be reused at all
+	const uint32 SettingsHash = CalcSettingsHash(NavData, Octree);
+	if (SettingsHash != MeshCache.SettingsHash)
+	{
+		MeshCache.Tiles.Empty();
+		MeshCache.SettingsHash = SettingsHash;
+	}
 
-	uint32 CurVert = 0;
+	TArray<FTileBuildData> BuildTiles;
+	TArray<uint32> BuildSourceHashes;
+	TSet<uint32> TileIDs;
 
-	Tiles.Reserve(NumUsedTiles);
+	TileIDs.Reserve(Octree->GetNumTiles());
+	Chunks.Reserve(Octree->GetNumTiles());
 
-	for (const FTileBuildData& Build : BuildData)
+	for (const FSvoTile& Tile : Octree->GetTiles())
 	{
-		// Only add tiles that have something to draw
-		if (Build.Lines.Num() == 0)
-			continue;
+		TileIDs.Add(Tile.GetID());
 
-		FTileData& TileData = Tiles.AddDefaulted_GetRef();
-		TileData.Bounds = Build.Octree->GetBoundsForNode(Build.Tile.GetNodeInfo());
-		TileData.StartVert = CurVert;
-		TileData.NumLines = Build.Lines.Num();
+		const uint32 SourceHash = CalcTileSourceHash(NavData, Octree, Tile);
 
-		for (const FLine& Line : Build.Lines)
+		const FNavSvoDebugMeshCache::FTileEntry* Entry = MeshCache.Tiles.Find(Tile.GetID());
+		if (Entry != nullptr && Entry->SourceHash == SourceHash)
 		{
-			VertexBuffers.PositionVertexBuffer.VertexPosition(CurVert + 0) = FVector3f(Line.A.X, Line.A.Y, Line.A.Z);
-			VertexBuffers.PositionVertexBuffer.VertexPosition(CurVert + 1) = FVector3f(Line.B.X, Line.B.Y, Line.B.Z);
-			VertexBuffers.ColorVertexBuffer.VertexColor(CurVert + 0) = Line.Color;
-			VertexBuffers.ColorVertexBuffer.VertexColor(CurVert + 1) = Line.Color;
-
-			IndexBuffer.Indices[CurVert + 0] = CurVert + 0;
-			IndexBuffer.Indices[CurVert + 1] = CurVert + 1;
-
-			CurVert += 2;
+			if (Entry->Chunk.IsValid())
+			{
+				Chunks.Add(Entry->Chunk);
+			}
+		}
+		else
+		{
+			BuildTiles.Add({ NavData, Octree, Tile });
+			BuildSourceHashes.Add(SourceHash);
 		}
 	}
 
-	ENQUEUE_RENDER_COMMAND(LineSetVertexBuffersInit)(
-		[this](FRHICommandListImmediate& RHICmdList)
+	// Forget the tiles which have been removed
+	for (auto It = MeshCache.Tiles.CreateIterator(); It; ++It)
+	{
+		if (!TileIDs.Contains(It.Key()))
 		{
-#if UE_VERSION_OLDER_THAN(5, 4, 0)
-			VertexBuffers.PositionVertexBuffer.InitResource();
-			VertexBuffers.StaticMeshVertexBuffer.InitResource();
-			VertexBuffers.ColorVertexBuffer.InitResource();
-#else
-			VertexBuffers.PositionVertexBuffer.InitResource(RHICmdList);
-			VertexBuffers.StaticMeshVertexBuffer.InitResource(RHICmdList);
-			VertexBuffers.ColorVertexBuffer.InitResource(RHICmdList);
-#endif
+			It.RemoveCurrent();
+		}
+	}
 
-			FLocalVertexFactory::FDataType Data;
-			VertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer(&VertexFactory, Data);
-			VertexBuffers.StaticMeshVertexBuffer.BindTangentVertexBuffer(&VertexFactory, Data);
-			VertexBuffers.StaticMeshVertexBuffer.BindTexCoordVertexBuffer(&VertexFactory, Data);
-			VertexBuffers.ColorVertexBuffer.BindColorVertexBuffer(&VertexFactory, Data);
-#if UE_VERSION_OLDER_THAN(5, 4, 0)
-			VertexFactory.SetData(Data);
+	// Building the lines only reads from the octree, so the changed tiles can be split
+	// across the workers
+	ParallelFor(BuildTiles.Num(), [this, &BuildTiles](int32 BuildIdx)
+	{
+		BuildTileLines(BuildTiles[BuildIdx]);
+	});
 
-			VertexFactory.InitResource();
-			IndexBuffer.InitResource();
-#else
-			VertexFactory.SetData(RHICmdList, Data);
+	const ERHIFeatureLevel::Type FeatureLevel = GetScene().GetFeatureLevel();
 
-			VertexFactory.InitResource(RHICmdList);
-			IndexBuffer.InitResource(RHICmdList);
-#endif
+	for (int32 BuildIdx = 0; BuildIdx < BuildTiles.Num(); ++BuildIdx)
+	{
+		const FTileBuildData& Build = BuildTiles[BuildIdx];
 
-#if WITH_EDITOR
-			// We don't use any one-frame proxy materials, so make sure to register our
-			// core material as being used, otherwise the editor verification will fail.
-			SetUsedMaterialForVerification({ NavDebugMaterial });
-#endif
-		});
+		FNavSvoDebugMeshCache::FTileEntry& Entry = MeshCache.Tiles.FindOrAdd(Build.Tile.GetID());
+		Entry.SourceHash = BuildSourceHashes[BuildIdx];
+		Entry.Chunk.Reset();
+
+		// Only add tiles that have something to draw
+		if (Build.Lines.Num() > 0)
+		{
+			Entry.Chunk = FNavSvoDebugMeshChunk::Create(FeatureLevel, Octree->GetBoundsForNode(Build.Tile.GetNodeInfo()), Build.Lines);
+			Chunks.Add(Entry.Chunk);
+		}
+	}
 }
 
-void FNavSvoSceneProxy::GatherData(const AGunfire3DNavData* NavData, TArray<FTileBuildData>& TilesOut) const
+uint32 FNavSvoSceneProxy::CalcSettingsHash(const AGunfire3DNavData* NavData, const FEditableSvo* Octree)
 {
-	if (NavData)
-	{
-		const FEditableSvo* Octree = nullptr;
+	uint32 Hash = PointerHash(Octree);
+	Hash = HashCombine(Hash, ::GetTypeHash(NavData->bDrawShell));
+	Hash = HashCombine(Hash, ::GetTypeHash(NavData->bDrawOctree));
+	Hash = HashCombine(Hash, ::GetTypeHash((uint8)NavData->DrawType));
+	Hash = HashCombine(Hash, ::GetTypeHash(NavData->bIncludeVoxelAreas));
+	Hash = HashCombine(Hash, ::GetTypeHash(NavData->bDrawSingleLayer));
+	Hash = HashCombine(Hash, ::GetTypeHash(NavData->DrawLayerIndex));
+	return Hash;
+}
 
-		if (const FNavSvoGenerator* Generator = (FNavSvoGenerator*)NavData->GetGenerator())
-		{
-			Octree = Generator->GetOctree();
-		}
-		else
+uint32 FNavSvoSceneProxy::CalcTileSourceHash(const AGunfire3DNavData* NavData, const FEditableSvo* Octree, const FSvoTile& Tile)
+{
+	uint32 Hash = ::GetTypeHash(Tile.GetVersion());
+
+	if (NavData->bDrawShell)
+	{
+		for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
 		{
-			Octree = NavData->GetOctree();
+			const FSvoTile* NeighborTile = Octree->GetTileAtCoord(Tile.GetCoord() + FSvoUtils::GetNeighborDirection(Neighbor));
+			Hash = HashCombine(Hash, ::GetTypeHash((NeighborTile != nullptr) ? NeighborTile->GetVersion() : 0));
 		}
+	}
 
-		if (Octree)
-		{
-			TilesOut.Reserve(Octree->GetNumTiles());
+	return Hash;
+}
 
-			for (const FSvoTile& Tile : Octree->GetTiles())
-			{
-				FTileBuildData& TileData = TilesOut.Add_GetRef({ NavData, Octree, Tile });
+void FNavSvoSceneProxy::BuildTileLines(FTileBuildData& Build) const
+{
+	const FSvoConfig& Config = Build.Octree->GetConfig();
 
-				// Collect obstructed voxels
-				if (NavData->bDrawShell)
-				{
-					if (Tile.HasNodesAllocated())
-					{
-						GatherExternalFaces(TileData, Tile.GetNodeInfo());
-					}
-				}
+	Build.GridOrigin = Build.Octree->GetBoundsForNode(Build.Tile.GetNodeInfo()).Min;
+	Build.VoxelSize = Config.GetVoxelSize();
+	Build.GridSize = FMath::RoundToInt(Config.GetResolutionForLayer(Config.GetTileLayerIndex()) / Build.VoxelSize);
 
-				// Collect obstructed areas
-				if (NavData->bDrawOctree)
-				{
-					GatherNodes(TileData);
-				}
-			}
+	// Collect obstructed voxels
+	if (Build.NavData->bDrawShell)
+	{
+		if (Build.Tile.HasNodesAllocated())
+		{
+			GatherExternalFaces(Build, Build.Tile.GetNodeInfo());
+			MergeShellFaces(Build);
 		}
 	}
+
+	// Collect obstructed areas
+	if (Build.NavData->bDrawOctree)
+	{
+		GatherNodes(Build);
+		AddBoxEdges(Build);
+	}
 }
 
 bool FNavSvoSceneProxy::ShouldDraw(const AGunfire3DNavData* NavData, bool bIsBlocked) const
@@ -367,43 +495,107 @@ bool FNavSvoSceneProxy::IsNeighborBlocked(FTileBuildData& Build, const FSvoNode&
 
 void FNavSvoSceneProxy::AddNeighborFace(FTileBuildData& Build, ESvoNeighbor Neighbor, const FVector& Center, FVector::FReal Extent) const
 {
-	const FIntVector Coord = FSvoUtils::GetNeighborDirection(Neighbor);
-	const FVector Offset(Coord.X, Coord.Y, Coord.Z);
-	const FVector FaceCenter = Center + (Offset * Extent);
-
-	switch (Neighbor)
-	{
-	case ESvoNeighbor::Front:
-	case ESvoNeighbor::Back:
-		AddFace(Build,
-			FaceCenter + FVector(0.0f, Extent, Extent),
-			FaceCenter + FVector(0.0f, Extent, -Extent),
-			FaceCenter + FVector(0.0f, -Extent, -Extent),
-			FaceCenter + FVector(0.0f, -Extent, Extent),
-			LayerColors[0]);
-		break;
-
-	case ESvoNeighbor::Right:
-	case ESvoNeighbor::Left:
-		AddFace(Build,
-			FaceCenter + FVector(Extent, 0.0f, Extent),
-			FaceCenter + FVector(Extent, 0.0f, -Extent),
-			FaceCenter + FVector(-Extent, 0.0f, -Extent),
-			FaceCenter + FVector(-Extent, 0.0f, Extent),
-			LayerColors[0]);
-		break;
-
-	case ESvoNeighbor::Top:
-	case ESvoNeighbor::Bottom:
-		AddFace(Build,
-			FaceCenter + FVector(Extent, Extent, 0.0f),
-			FaceCenter + FVector(Extent, -Extent, 0.0f),
-			FaceCenter + FVector(-Extent, -Extent, 0.0f),
-			FaceCenter + FVector(-Extent, Extent, 0.0f),
-			LayerColors[0]);
-		break;
+	const FIntVector Direction = FSvoUtils::GetNeighborDirection(Neighbor);
+	const int32 Axis = (Direction.X != 0) ? 0 : ((Direction.Y != 0) ? 1 : 2);
+	const int32 AxisU = (Axis + 1) % 3;
+	const int32 AxisV = (Axis + 2) % 3;
+	const bool bPositive = (Direction[Axis] > 0);
+
+	// Work in voxels from the corner of the tile, so faces of nodes of any size line up
+	// with each other
+	const FVector LocalMin = (Center - FVector(Extent) - Build.GridOrigin) / Build.VoxelSize;
+	const int32 Size = FMath::RoundToInt((Extent * 2.0) / Build.VoxelSize);
+	const int32 Plane = FMath::RoundToInt(LocalMin[Axis]) + (bPositive ? Size : 0);
+	const int32 MinU = FMath::Max(FMath::RoundToInt(LocalMin[AxisU]), 0);
+	const int32 MinV = FMath::Max(FMath::RoundToInt(LocalMin[AxisV]), 0);
+	const int32 MaxU = FMath::Min(MinU + Size, Build.GridSize);
+	const int32 MaxV = FMath::Min(MinV + Size, Build.GridSize);
+
+	if (Plane < 0 || Plane > Build.GridSize)
+	{
+		return;
+	}
+
+	// Faces pointing opposite ways are kept apart, so the outlines of two blocked areas
+	// touching at a plane aren't merged together
+	const uint32 PlaneKey = ((uint32)Plane << 3) | ((uint32)Axis << 1) | (bPositive ? 1 : 0);
+
+	TBitArray<>& Faces = Build.ShellFaces.FindOrAdd(PlaneKey);
+	if (Faces.Num() == 0)
+	{
+		Faces.Init(false, Build.GridSize * Build.GridSize);
+	}
+
+	for (int32 V = MinV; V < MaxV; ++V)
+	{
+		Faces.SetRange(V * Build.GridSize + MinU, MaxU - MinU, true);
+	}
+}
+
+void FNavSvoSceneProxy::MergeShellFaces(FTileBuildData& Build) const
+{
+	const int32 GridSize = Build.GridSize;
+
+	for (TPair<uint32, TBitArray<>>& PlaneFaces : Build.ShellFaces)
+	{
+		const int32 Plane = (int32)(PlaneFaces.Key >> 3);
+		const int32 Axis = (int32)((PlaneFaces.Key >> 1) & 0x3);
+		const int32 AxisU = (Axis + 1) % 3;
+		const int32 AxisV = (Axis + 2) % 3;
+
+		auto GetCorner = [&Build, Plane, Axis, AxisU, AxisV](int32 U, int32 V)
+		{
+			FVector Corner;
+			Corner[Axis] = Plane;
+			Corner[AxisU] = U;
+			Corner[AxisV] = V;
+			return Build.GridOrigin + (Corner * Build.VoxelSize);
+		};
+
+		TBitArray<>& Faces = PlaneFaces.Value;
+
+		// Greedily grow a rectangle from the first face left, first along the row and
+		// then down as many rows as are entirely covered, until all are used up
+		for (int32 FaceIdx = Faces.Find(true); FaceIdx != INDEX_NONE; FaceIdx = Faces.FindFrom(true, FaceIdx))
+		{
+			const int32 MinU = FaceIdx % GridSize;
+			const int32 MinV = FaceIdx / GridSize;
+
+			int32 MaxU = MinU + 1;
+			while (MaxU < GridSize && Faces[MinV * GridSize + MaxU])
+			{
+				++MaxU;
+			}
+
+			int32 MaxV = MinV + 1;
+			while (MaxV < GridSize)
+			{
+				const int32 RowStart = MaxV * GridSize;
+
+				bool bRowCovered = true;
+				for (int32 U = MinU; U < MaxU && bRowCovered; ++U)
+				{
+					bRowCovered = Faces[RowStart + U];
+				}
+
+				if (!bRowCovered)
+				{
+					break;
+				}
+
+				++MaxV;
+			}
+
+			for (int32 V = MinV; V < MaxV; ++V)
+			{
+				Faces.SetRange(V * GridSize + MinU, MaxU - MinU, false);
+			}
+
+			AddFace(Build, GetCorner(MinU, MinV), GetCorner(MaxU, MinV), GetCorner(MaxU, MaxV), GetCorner(MinU, MaxV), LayerColors[0]);
+		}
 	}
 
+	Build.ShellFaces.Empty();
 }
 
 void FNavSvoSceneProxy::GatherNodes(FTileBuildData& Build) const
@@ -488,18 +680,54 @@ void FNavSvoSceneProxy::AddFace(FTileBuildData& Build, const FVector& A, const F
 
 void FNavSvoSceneProxy::AddBox(FTileBuildData& Build, const FVector& Center, const FVector& Extent, const FColor& Color) const
 {
-	Build.Lines.Add({ Center + FVector(Extent.X, Extent.Y, Extent.Z), Center + FVector(Extent.X, -Extent.Y, Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(Extent.X, -Extent.Y, Extent.Z), Center + FVector(-Extent.X, -Extent.Y, Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(-Extent.X, -Extent.Y, Extent.Z), Center + FVector(-Extent.X, Extent.Y, Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(-Extent.X, Extent.Y, Extent.Z), Center + FVector(Extent.X, Extent.Y, Extent.Z), Color });
-
-	Build.Lines.Add({ Center + FVector(Extent.X, Extent.Y, -Extent.Z), Center + FVector(Extent.X, -Extent.Y, -Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(Extent.X, -Extent.Y, -Extent.Z), Center + FVector(-Extent.X, -Extent.Y, -Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(-Extent.X, -Extent.Y, -Extent.Z), Center + FVector(-Extent.X, Extent.Y, -Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(-Extent.X, Extent.Y, -Extent.Z), Center + FVector(Extent.X, Extent.Y, -Extent.Z), Color });
-
-	Build.Lines.Add({ Center + FVector(Extent.X, Extent.Y, Extent.Z), Center + FVector(Extent.X, Extent.Y, -Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(Extent.X, -Extent.Y, Extent.Z), Center + FVector(Extent.X, -Extent.Y, -Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(-Extent.X, -Extent.Y, Extent.Z), Center + FVector(-Extent.X, -Extent.Y, -Extent.Z), Color });
-	Build.Lines.Add({ Center + FVector(-Extent.X, Extent.Y, Extent.Z), Center + FVector(-Extent.X, Extent.Y, -Extent.Z), Color });
+	// Corners are snapped to half voxels from the corner of the tile, so the edges of
+	// neighboring boxes compare equal
+	const double HalfVoxelSize = Build.VoxelSize * 0.5;
+
+	auto GetCorner = [&Build, &Center, &Extent, HalfVoxelSize](double X, double Y, double Z)
+	{
+		const FVector Corner = (Center + FVector(Extent.X * X, Extent.Y * Y, Extent.Z * Z) - Build.GridOrigin) / HalfVoxelSize;
+		return FIntVector(FMath::RoundToInt(Corner.X), FMath::RoundToInt(Corner.Y), FMath::RoundToInt(Corner.Z));
+	};
+
+	const FIntVector Corners[8] =
+	{
+		GetCorner(1, 1, 1), GetCorner(1, -1, 1), GetCorner(-1, -1, 1), GetCorner(-1, 1, 1),
+		GetCorner(1, 1, -1), GetCorner(1, -1, -1), GetCorner(-1, -1, -1), GetCorner(-1, 1, -1),
+	};
+
+	static const uint8 Edges[12][2] =
+	{
+		{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+		{ 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+	};
+
+	for (const uint8 (&Edge)[2] : Edges)
+	{
+		FIntVector A = Corners[Edge[0]];
+		FIntVector B = Corners[Edge[1]];
+
+		// Order the ends so an edge is the same whichever box adds it
+		if (A.X > B.X || (A.X == B.X && (A.Y > B.Y || (A.Y == B.Y && A.Z > B.Z))))
+		{
+			Swap(A, B);
+		}
+
+		Build.BoxEdges.Add({ A, B, Color });
+	}
+}
+
+void FNavSvoSceneProxy::AddBoxEdges(FTileBuildData& Build) const
+{
+	const double HalfVoxelSize = Build.VoxelSize * 0.5;
+
+	Build.Lines.Reserve(Build.Lines.Num() + Build.BoxEdges.Num());
+
+	for (const FBoxEdge& Edge : Build.BoxEdges)
+	{
+		Build.Lines.Add({ Build.GridOrigin + FVector(Edge.A) * HalfVoxelSize, Build.GridOrigin + FVector(Edge.B) * HalfVoxelSize, Edge.Color });
+	}
+
+	Build.BoxEdges.Empty();
 }
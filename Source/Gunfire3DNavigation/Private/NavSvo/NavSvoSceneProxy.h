@@ -11,10 +11,76 @@ class FSvoNode;
 class FSvoTile;
 enum class ESvoNeighbor : uint8;
 
+class FNavSvoDebugMeshChunk;
+typedef TSharedPtr<const FNavSvoDebugMeshChunk, ESPMode::ThreadSafe> FNavSvoDebugMeshChunkPtr;
+
+//
+// Line mesh for the debug drawing of a single tile. Chunks are shared between scene
+// proxies through FNavSvoDebugMeshCache, so only tiles which changed since the last proxy
+// have to be rebuilt and uploaded.
+//
+class FNavSvoDebugMeshChunk
+{
+public:
+	struct FLine
+	{
+		FVector A;
+		FVector B;
+		FColor Color;
+	};
+
+	// Creates a chunk for the lines of a tile and queues its buffers to be uploaded. The
+	// chunk's resources are released on the render thread once the last reference to it
+	// is dropped.
+	static FNavSvoDebugMeshChunkPtr Create(ERHIFeatureLevel::Type FeatureLevel, const FBox& Bounds, TArrayView<const FLine> Lines);
+
+	const FBox& GetBounds() const { return Bounds; }
+	uint32 GetNumLines() const { return NumLines; }
+
+	const FLocalVertexFactory& GetVertexFactory() const { return VertexFactory; }
+	const FDynamicMeshIndexBuffer32& GetIndexBuffer() const { return IndexBuffer; }
+
+	uint32 GetMemoryFootprint() const;
+
+private:
+	FNavSvoDebugMeshChunk(ERHIFeatureLevel::Type FeatureLevel);
+
+	void InitResources(FRHICommandListImmediate& RHICmdList);
+	void ReleaseResources();
+
+	FBox Bounds;
+	uint32 NumLines = 0;
+
+	FLocalVertexFactory VertexFactory;
+	FStaticMeshVertexBuffers VertexBuffers;
+	FDynamicMeshIndexBuffer32 IndexBuffer;
+};
+
+//
+// Debug mesh chunks built by the last scene proxy, kept by the rendering component so the
+// next proxy can reuse the ones whose tiles haven't changed.
+//
+struct FNavSvoDebugMeshCache
+{
+	struct FTileEntry
+	{
+		// Identifies the tile data the chunk was built from (see CalcTileSourceHash)
+		uint32 SourceHash = 0;
+
+		// Unset if the tile had nothing to draw
+		FNavSvoDebugMeshChunkPtr Chunk;
+	};
+
+	TMap<uint32, FTileEntry> Tiles;
+
+	// Identifies the octree and draw settings the chunks were built for
+	uint32 SettingsHash = 0;
+};
+
 class GUNFIRE3DNAVIGATION_API FNavSvoSceneProxy : public FPrimitiveSceneProxy
 {
 public:
-	FNavSvoSceneProxy(const UPrimitiveComponent* InComponent, const AGunfire3DNavData* NavData);
+	FNavSvoSceneProxy(const UPrimitiveComponent* InComponent, const AGunfire3DNavData* NavData, FNavSvoDebugMeshCache& MeshCache);
 	virtual ~FNavSvoSceneProxy();
 
 	// Begin FPrimitiveSceneProxy overrides
@@ -25,18 +91,21 @@ public:
 	// End FPrimitiveSceneProxy overrides
 
 protected:
-	struct FTileData
-	{
-		FBox Bounds;
-		uint32 StartVert;
-		uint32 NumLines;
-	};
+	typedef FNavSvoDebugMeshChunk::FLine FLine;
 
-	struct FLine
+	// Edge of an octree box, in half voxels from the corner of the tile
+	struct FBoxEdge
 	{
-		FVector A;
-		FVector B;
+		FIntVector A;
+		FIntVector B;
 		FColor Color;
+
+		bool operator==(const FBoxEdge& Other) const { return A == Other.A && B == Other.B && Color == Other.Color; }
+
+		friend uint32 GetTypeHash(const FBoxEdge& Edge)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Edge.A), GetTypeHash(Edge.B)), GetTypeHash(Edge.Color));
+		}
 	};
 
 	struct FTileBuildData
@@ -45,15 +114,41 @@ protected:
 		const FEditableSvo* Octree;
 		const FSvoTile& Tile;
 		TArray<FLine> Lines;
+
+		// Corner of the tile, and its size in voxels
+		FVector GridOrigin = FVector::ZeroVector;
+		float VoxelSize = 0.f;
+		int32 GridSize = 0;
+
+		// Exposed shell faces on each plane through the tile, one bit per voxel face.
+		// Keyed by the plane index, axis and facing (see AddNeighborFace).
+		TMap<uint32, TBitArray<>> ShellFaces;
+
+		// Edges of the octree boxes, so edges shared by neighboring boxes are only drawn
+		// once
+		TSet<FBoxEdge> BoxEdges;
 	};
 
-	void InitRenderData(const TArray<FTileBuildData>& BuildData);
+	// Reuses the cached chunks of unchanged tiles, and rebuilds the rest
+	void GatherData(const AGunfire3DNavData* NavData, FNavSvoDebugMeshCache& MeshCache);
+
+	static uint32 CalcSettingsHash(const AGunfire3DNavData* NavData, const FEditableSvo* Octree);
+
+	// The shell of a tile depends on whether the nodes across its faces are blocked, so
+	// when it's drawn the hash also covers the versions of the neighboring tiles
+	static uint32 CalcTileSourceHash(const AGunfire3DNavData* NavData, const FEditableSvo* Octree, const FSvoTile& Tile);
 
-	void GatherData(const AGunfire3DNavData* NavData, TArray<FTileBuildData>& TilesOut) const;
+	void BuildTileLines(FTileBuildData& Build) const;
 	bool ShouldDraw(const AGunfire3DNavData* NavData, bool bIsBlocked) const;
 	void GatherExternalFaces(FTileBuildData& Build, const FSvoNode& Node) const;
 	bool IsNeighborBlocked(FTileBuildData& Build, const FSvoNode& Node, ESvoNeighbor Neighbor) const;
 	void AddNeighborFace(FTileBuildData& Build, ESvoNeighbor Neighbor, const FVector& Center, FVector::FReal Extent) const;
+
+	// Merges the exposed faces on each plane into as few rectangles as it can and adds
+	// their outlines
+	void MergeShellFaces(FTileBuildData& Build) const;
+
+	void AddBoxEdges(FTileBuildData& Build) const;
 	void GatherNodes(FTileBuildData& Build) const;
 	void AddNode(FTileBuildData& Build, const FSvoNode& Node) const;
 
@@ -61,12 +156,10 @@ protected:
 	void AddBox(FTileBuildData& Build, const FVector& Center, const FVector& Extent, const FColor& Color) const;
 
 protected:
-	TArray<FTileData> Tiles;
+	// Chunks of all tiles with something to draw
+	TArray<FNavSvoDebugMeshChunkPtr> Chunks;
 
 	UMaterial* NavDebugMaterial;
-	FLocalVertexFactory VertexFactory;
-	FStaticMeshVertexBuffers VertexBuffers;
-	FDynamicMeshIndexBuffer32 IndexBuffer;
 
 	static const FColor LayerColors[];
 };
@@ -4,6 +4,10 @@
 
 #include "Gunfire3DNavigationCustomVersion.h"
 
+#include "AI/NavigationSystemBase.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NavSvoStreamingData)
 
 void UNavSvoStreamingData::Serialize(FArchive& Ar)
@@ -13,6 +17,8 @@ void UNavSvoStreamingData::Serialize(FArchive& Ar)
 
 	Super::Serialize(Ar);
 
+	const int32 Version = Ar.CustomVer(FGunfire3DNavigationCustomVersion::GUID);
+
 	if (Ar.IsLoading())
 	{
 		ReleaseData();
@@ -21,25 +27,75 @@ void UNavSvoStreamingData::Serialize(FArchive& Ar)
 		Ar << bHasOctree;
 		if (bHasOctree)
 		{
-			Octree = MakeShareable(new FEditableSvo(EForceInit::ForceInit));
-			Octree->Serialize(Ar);
+			if (Version >= FGunfire3DNavigationCustomVersion::StreamingBulkData)
+			{
+				// The octree is read in later (see RequestOctreeLoad)
+				Ar << Bounds;
+				OctreeBulkData.Serialize(Ar, this);
+				bHasOctreeData = true;
+			}
+			else
+			{
+				Octree = MakeShareable(new FEditableSvo(EForceInit::ForceInit));
+				Octree->Serialize(Ar);
+
+				if (Version >= FGunfire3DNavigationCustomVersion::StreamingStitches)
+				{
+					Ar << TileStitches;
+				}
+
+				Octree->GetBounds(Bounds);
+				bHasOctreeData = true;
+			}
 		}
 	}
 	else if (Ar.IsSaving())
 	{
-		bool bHasOctree = (Octree.IsValid());
+		bool bHasOctree = (Octree.IsValid() || bHasOctreeData);
 		Ar << bHasOctree;
 
 		if (bHasOctree)
 		{
-			Octree->Serialize(Ar);
+			// If the octree was never read in, the payload it was loaded with is still
+			// current and is saved back out as is
+			if (Octree.IsValid())
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter Writer(Payload, true /* bIsPersistent */);
+
+				int32 PayloadVersion = FGunfire3DNavigationCustomVersion::LatestVersion;
+				Writer << PayloadVersion;
+
+				Octree->Serialize(Writer);
+				Writer << TileStitches;
+
+				Octree->GetBounds(Bounds);
+
+				OctreeBulkData.Lock(LOCK_READ_WRITE);
+				FMemory::Memcpy(OctreeBulkData.Realloc(Payload.Num()), Payload.GetData(), Payload.Num());
+				OctreeBulkData.Unlock();
+
+				// Keep the payload out of the package's export data, so loading the
+				// package doesn't read it
+				OctreeBulkData.SetBulkDataFlags(BULKDATA_Force_NOT_InlinePayload);
+			}
+
+			Ar << Bounds;
+			OctreeBulkData.Serialize(Ar, this);
 		}
 	}
 }
 
 void UNavSvoStreamingData::ReleaseData()
 {
+	CancelOctreeLoad();
+
 	Octree.Reset();
+	TileStitches.Empty();
+
+	OctreeBulkData.RemoveBulkData();
+	bHasOctreeData = false;
+	Bounds.Init();
 }
 
 FEditableSvo* UNavSvoStreamingData::GetOctree()
@@ -47,8 +103,104 @@ FEditableSvo* UNavSvoStreamingData::GetOctree()
 	return Octree.Get();
 }
 
+void UNavSvoStreamingData::RequestOctreeLoad(EAsyncIOPriorityAndFlags Priority)
+{
+	if (!HasUnloadedOctree() || IsLoadingOctree())
+	{
+		return;
+	}
+
+	// If there's no reading to wait on, just build the octree now
+	if (OctreeBulkData.IsBulkDataLoaded() || !OctreeBulkData.CanLoadFromDisk())
+	{
+		const int64 PayloadSize = OctreeBulkData.GetBulkDataSize();
+		const uint8* PayloadData = (const uint8*)OctreeBulkData.LockReadOnly();
+		if (PayloadData != nullptr)
+		{
+			LoadOctreeFromPayload(TArrayView<const uint8>(PayloadData, PayloadSize));
+		}
+		OctreeBulkData.Unlock();
+		return;
+	}
+
+	LoadRequest = OctreeBulkData.CreateStreamingRequest(Priority, nullptr /* CompleteCallback */, nullptr /* UserSuppliedMemory */);
+	if (LoadRequest == nullptr)
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("UNavSvoStreamingData::RequestOctreeLoad : Unable to read nav data for %s"), *GetPathName());
+	}
+}
+
+bool UNavSvoStreamingData::FinishOctreeLoad()
+{
+	check(IsInGameThread());
+
+	if (LoadRequest == nullptr || !LoadRequest->PollCompletion())
+	{
+		return false;
+	}
+
+	uint8* PayloadData = LoadRequest->GetReadResults();
+	const int64 PayloadSize = LoadRequest->GetSize();
+
+	delete LoadRequest;
+	LoadRequest = nullptr;
+
+	if (PayloadData == nullptr)
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("UNavSvoStreamingData::FinishOctreeLoad : Reading nav data for %s failed"), *GetPathName());
+		return false;
+	}
+
+	LoadOctreeFromPayload(TArrayView<const uint8>(PayloadData, PayloadSize));
+	FMemory::Free(PayloadData);
+
+	return Octree.IsValid();
+}
+
+void UNavSvoStreamingData::LoadOctreeFromPayload(TArrayView<const uint8> Payload)
+{
+	FMemoryReaderView Reader(Payload, true /* bIsPersistent */);
+
+	int32 PayloadVersion = 0;
+	Reader << PayloadVersion;
+	Reader.SetCustomVersion(FGunfire3DNavigationCustomVersion::GUID, PayloadVersion, TEXT("Gunfire3DNavigation"));
+
+	Octree = MakeShareable(new FEditableSvo(EForceInit::ForceInit));
+	Octree->Serialize(Reader);
+	Reader << TileStitches;
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("UNavSvoStreamingData::LoadOctreeFromPayload : Nav data for %s is corrupt"), *GetPathName());
+
+		Octree.Reset();
+		TileStitches.Empty();
+	}
+}
+
+void UNavSvoStreamingData::CancelOctreeLoad()
+{
+	if (LoadRequest != nullptr)
+	{
+		LoadRequest->Cancel();
+		LoadRequest->WaitCompletion();
+
+		if (uint8* PayloadData = LoadRequest->GetReadResults())
+		{
+			FMemory::Free(PayloadData);
+		}
+
+		delete LoadRequest;
+		LoadRequest = nullptr;
+	}
+}
+
 FEditableSvo* UNavSvoStreamingData::EnsureOctree(const FSvoConfig& SourceConfig)
 {
+	// Whatever was being read in is about to be replaced
+	CancelOctreeLoad();
+	bHasOctreeData = true;
+
 	if (Octree.IsValid())
 	{
 		// If the destination octree is compatible with this octree, just reset the contained
@@ -60,6 +212,7 @@ FEditableSvo* UNavSvoStreamingData::EnsureOctree(const FSvoConfig& SourceConfig)
 		if (bCanReset)
 		{
 			Octree->Reset();
+			TileStitches.Empty();
 		}
 		else
 		{
@@ -70,8 +223,33 @@ FEditableSvo* UNavSvoStreamingData::EnsureOctree(const FSvoConfig& SourceConfig)
 	// Create the octree if one does not already exist or the existing one was incompatible.
 	if (!Octree.IsValid())
 	{
-		//Octree = MakeShareable(new FEditableSvo(SourceConfig));
+		Octree = MakeShareable(new FEditableSvo(SourceConfig));
 	}
 
 	return Octree.Get();
+}
+
+void UNavSvoStreamingData::BakeStitches(const FEditableSvo& SourceOctree)
+{
+	TileStitches.Empty();
+
+	if (Octree.IsValid())
+	{
+		for (const FSvoTile& Tile : Octree->GetTiles())
+		{
+			TArray<FSvoFaceStitch> Stitches;
+			SourceOctree.BakeTileStitches(Tile.GetCoord(), Stitches);
+
+			if (Stitches.Num() > 0)
+			{
+				TileStitches.Add(Tile.GetCoord(), MoveTemp(Stitches));
+			}
+		}
+	}
+}
+
+TArrayView<const FSvoFaceStitch> UNavSvoStreamingData::GetTileStitches(const FIntVector& TileCoord) const
+{
+	const TArray<FSvoFaceStitch>* Stitches = TileStitches.Find(TileCoord);
+	return (Stitches != nullptr) ? TArrayView<const FSvoFaceStitch>(*Stitches) : TArrayView<const FSvoFaceStitch>();
 }
\ No newline at end of file
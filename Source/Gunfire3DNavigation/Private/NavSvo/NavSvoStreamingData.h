@@ -5,6 +5,7 @@
 #include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
 
 #include "AI/Navigation/NavigationDataChunk.h"
+#include "Serialization/BulkData.h"
 
 #include "NavSvoStreamingData.generated.h"
 
@@ -29,14 +30,56 @@ public:
 	// Gets the current octree if it exists
 	FEditableSvo* GetOctree();
 
+	// Returns true if the package has an octree which hasn't been read in yet
+	bool HasUnloadedOctree() const { return bHasOctreeData && !Octree.IsValid(); }
+
+	// Starts reading the octree in from bulk data, if it isn't already. The package loads
+	// without it, so streaming in a level doesn't stall on its nav data.
+	void RequestOctreeLoad(EAsyncIOPriorityAndFlags Priority);
+
+	// Returns true while a read started by RequestOctreeLoad is in flight
+	bool IsLoadingOctree() const { return LoadRequest != nullptr; }
+
+	// Builds the octree once its read has completed, returning true if it did. Octrees
+	// are only deserialized on the game thread (see FGunfire3DNavigationCustomVersion).
+	bool FinishOctreeLoad();
+
+	// Returns the bounds of the tiles in this chunk, known before the octree is read in
+	const FBox& GetBounds() const { return Bounds; }
+
 	// Gets and potentially creates/resets the octree of a specified tile type
 	FEditableSvo* EnsureOctree(const FSvoConfig& SourceConfig);
 
+	// Bakes the links between each of our tiles and its neighbors in the full octree, so
+	// they don't all have to be re-linked when the level is streamed in or out
+	void BakeStitches(const FEditableSvo& SourceOctree);
+
+	// Returns the baked links across the faces of one of our tiles
+	TArrayView<const FSvoFaceStitch> GetTileStitches(const FIntVector& TileCoord) const;
+
 	// Level associated with this streaming data.
 	UPROPERTY(Transient)
 	TObjectPtr<const ULevel> Level = nullptr;
 
 private:
+	// Builds the octree (and stitches) from a payload written by Serialize
+	void LoadOctreeFromPayload(TArrayView<const uint8> Payload);
+
+	void CancelOctreeLoad();
+
 	// Octree containing all relevant tiles/data
 	FEditableSvoSharedPtr Octree = nullptr;
+
+	// The octree and stitches, serialized separately from the rest of the package
+	FByteBulkData OctreeBulkData;
+
+	// Set if the package was saved with an octree
+	bool bHasOctreeData = false;
+
+	class IBulkDataIORequest* LoadRequest = nullptr;
+
+	FBox Bounds = FBox(ForceInit);
+
+	// See BakeStitches
+	TMap<FIntVector, TArray<FSvoFaceStitch>> TileStitches;
 };
\ No newline at end of file
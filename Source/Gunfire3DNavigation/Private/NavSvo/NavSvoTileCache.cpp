@@ -0,0 +1,175 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoTileCache.h"
+
+#include "Gunfire3DNavigationCustomVersion.h"
+#include "SparseVoxelOctree/SparseVoxelOctreeTile.h"
+#include "StatArray.h"
+
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#if WITH_EDITOR
+#include "DerivedDataCacheInterface.h"
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("Find (FNavSvoTileCache)"), STAT_FNavSvoTileCache_Find, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Add (FNavSvoTileCache)"), STAT_FNavSvoTileCache_Add, STATGROUP_Gunfire3DNavigation);
+
+DECLARE_MEMORY_STAT(TEXT("Cached Tiles (FNavSvoTileCache)"), STAT_FNavSvoTileCache_CachedTiles, STATGROUP_Gunfire3DNavigation);
+
+TAutoConsoleVariable<bool> CVarNavSvoTileCache(TEXT("NavSvo.TileCache"), true, TEXT("Reuses previously built tiles when a tile is rebuilt with the same geometry and settings."), ECVF_Cheat);
+TAutoConsoleVariable<int32> CVarNavSvoTileCacheSizeMB(TEXT("NavSvo.TileCacheSizeMB"), 32, TEXT("Most memory (in MB) used to keep built tiles in memory for reuse."), ECVF_Cheat);
+
+FNavSvoTileCache& FNavSvoTileCache::Get()
+{
+	static FNavSvoTileCache Cache;
+	return Cache;
+}
+
+bool FNavSvoTileCache::IsEnabled()
+{
+	return CVarNavSvoTileCache.GetValueOnAnyThread();
+}
+
+bool FNavSvoTileCache::Find(const FSHAHash& InputHash, FSvoTile& OutTile)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FNavSvoTileCache_Find);
+
+	TArray<uint8> Data;
+
+	{
+		// Finding an entry updates when it was last used, so this needs the write lock
+		FWriteScopeLock WriteLock(Lock);
+
+		if (FEntry* Entry = Entries.Find(InputHash))
+		{
+			Entry->LastUsed = ++UseCounter;
+			Data = Entry->Data;
+		}
+	}
+
+#if WITH_EDITOR
+	if (Data.Num() == 0)
+	{
+		if (GetDerivedDataCacheRef().GetSynchronous(*GetDerivedDataKey(InputHash), Data, TEXT("FNavSvoTileCache")))
+		{
+			FWriteScopeLock WriteLock(Lock);
+			AddEntry(InputHash, CopyTemp(Data));
+		}
+	}
+#endif
+
+	return Data.Num() > 0 && LoadTile(Data, OutTile);
+}
+
+void FNavSvoTileCache::Add(const FSHAHash& InputHash, FSvoTile& Tile)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FNavSvoTileCache_Add);
+
+	TArray<uint8> Data;
+	SaveTile(Tile, Data);
+
+#if WITH_EDITOR
+	GetDerivedDataCacheRef().Put(*GetDerivedDataKey(InputHash), Data, TEXT("FNavSvoTileCache"));
+#endif
+
+	FWriteScopeLock WriteLock(Lock);
+	AddEntry(InputHash, MoveTemp(Data));
+}
+
+void FNavSvoTileCache::AddEntry(const FSHAHash& InputHash, TArray<uint8>&& Data)
+{
+	if (const FEntry* OldEntry = Entries.Find(InputHash))
+	{
+		RemoveEntry(*OldEntry);
+	}
+
+	FEntry& NewEntry = Entries.Add(InputHash);
+	NewEntry.Data = MoveTemp(Data);
+	NewEntry.LastUsed = ++UseCounter;
+
+	const uint32 EntryMemUsed = NewEntry.Data.GetAllocatedSize();
+	MemUsed += EntryMemUsed;
+	INC_DWORD_STAT_BY(STAT_FNavSvoTileCache_CachedTiles, EntryMemUsed);
+	INC_DWORD_STAT_BY(STAT_Gunfire3DNavigation_TotalMemory, EntryMemUsed);
+
+	// Evict the least recently used tiles until we're back under budget. Evicting is
+	// rare next to finding and adding tiles, so it just searches all the entries.
+	const uint32 MaxMemUsed = (uint32)FMath::Max(CVarNavSvoTileCacheSizeMB.GetValueOnAnyThread(), 0) * 1024 * 1024;
+
+	while (MemUsed > MaxMemUsed && Entries.Num() > 0)
+	{
+		auto OldestIt = Entries.CreateIterator();
+		for (auto It = Entries.CreateIterator(); It; ++It)
+		{
+			if (It->Value.LastUsed < OldestIt->Value.LastUsed)
+			{
+				OldestIt = It;
+			}
+		}
+
+		RemoveEntry(OldestIt->Value);
+		OldestIt.RemoveCurrent();
+	}
+}
+
+void FNavSvoTileCache::RemoveEntry(const FEntry& Entry)
+{
+	const uint32 EntryMemUsed = Entry.Data.GetAllocatedSize();
+	MemUsed -= EntryMemUsed;
+	DEC_DWORD_STAT_BY(STAT_FNavSvoTileCache_CachedTiles, EntryMemUsed);
+	DEC_DWORD_STAT_BY(STAT_Gunfire3DNavigation_TotalMemory, EntryMemUsed);
+}
+
+void FNavSvoTileCache::Empty()
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	for (const TPair<FSHAHash, FEntry>& Pair : Entries)
+	{
+		RemoveEntry(Pair.Value);
+	}
+
+	Entries.Empty();
+}
+
+uint32 FNavSvoTileCache::GetMemUsed() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return MemUsed + Entries.GetAllocatedSize();
+}
+
+void FNavSvoTileCache::SaveTile(FSvoTile& Tile, TArray<uint8>& OutData)
+{
+	// The node layout is part of the input hash, so the nodes can always be written as
+	// a raw block.
+	FMemoryWriter Writer(OutData);
+	Writer.UsingCustomVersion(FGunfire3DNavigationCustomVersion::GUID);
+	Tile.Serialize(Writer, sizeof(FSvoNode));
+}
+
+bool FNavSvoTileCache::LoadTile(const TArray<uint8>& Data, FSvoTile& OutTile)
+{
+	FMemoryReader Reader(Data);
+	Reader.SetCustomVersion(FGunfire3DNavigationCustomVersion::GUID, FGunfire3DNavigationCustomVersion::LatestVersion, TEXT("Gunfire3DNavigationVer"));
+
+	FSvoTile Tile;
+	Tile.Serialize(Reader, sizeof(FSvoNode));
+
+	if (Reader.IsError() || !ensure(Reader.AtEnd()))
+	{
+		return false;
+	}
+
+	OutTile = MoveTemp(Tile);
+	return true;
+}
+
+#if WITH_EDITOR
+FString FNavSvoTileCache::GetDerivedDataKey(const FSHAHash& InputHash)
+{
+	// The cache version and everything the tile data depends on are already part of the
+	// input hash, so it doesn't need a version of its own.
+	return FDerivedDataCacheInterface::BuildCacheKey(TEXT("G3DNAVTILE"), TEXT("1"), *InputHash.ToString());
+}
+#endif
@@ -0,0 +1,74 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
+
+class FSvoTile;
+
+//
+// Built tiles keyed by a hash of everything that went into building them (the gathered
+// triangles and blockers, the generation config and the tile's bounds). When a tile is
+// rebuilt with the same inputs it can be copied from here instead of being voxelized
+// again, so rebuilding an area only costs the tiles whose geometry actually changed.
+//
+// Tiles are kept in memory up to NavSvo.TileCacheSizeMB, evicting the least recently used
+// first. In the editor they're also stored in the derived data cache, so they're shared
+// between sessions (and with anyone else using a shared cache).
+//
+// NOTE: Thread-safe, since tiles are built on worker threads.
+//
+class GUNFIRE3DNAVIGATION_API FNavSvoTileCache
+{
+public:
+	// Bump this whenever a change to generation means the same inputs can build a
+	// different tile, so tiles built by older code aren't used.
+	static constexpr uint32 Version = 1;
+
+	static FNavSvoTileCache& Get();
+
+	// Returns whether tile builds should use the cache (see NavSvo.TileCache)
+	static bool IsEnabled();
+
+	// Copies the tile built from the inputs with this hash, returning false if there
+	// isn't one.
+	bool Find(const FSHAHash& InputHash, FSvoTile& OutTile);
+
+	// Stores a tile built from the inputs with this hash
+	void Add(const FSHAHash& InputHash, FSvoTile& Tile);
+
+	// Releases all tiles cached in memory
+	void Empty();
+
+	// Returns the amount of memory used by the tiles cached in memory
+	uint32 GetMemUsed() const;
+
+private:
+	struct FEntry
+	{
+		TArray<uint8> Data;
+		uint64 LastUsed = 0;
+	};
+
+	// Adds an entry for the tile data, evicting old entries until we're under budget.
+	// Must be called with the write lock held.
+	void AddEntry(const FSHAHash& InputHash, TArray<uint8>&& Data);
+	void RemoveEntry(const FEntry& Entry);
+
+	static void SaveTile(FSvoTile& Tile, TArray<uint8>& OutData);
+	static bool LoadTile(const TArray<uint8>& Data, FSvoTile& OutTile);
+
+#if WITH_EDITOR
+	static FString GetDerivedDataKey(const FSHAHash& InputHash);
+#endif
+
+	mutable FRWLock Lock;
+
+	TMap<FSHAHash, FEntry> Entries;
+
+	// Incremented on every use, to find the least recently used entries
+	uint64 UseCounter = 0;
+
+	uint32 MemUsed = 0;
+};
@@ -3,25 +3,177 @@
 #include "NavSvoTileGenerator.h"
 
 #include "Gunfire3DNavData.h"
+#include "Gunfire3DNavigationCustomVersion.h"
 #include "Gunfire3DNavigationUtils.h"
+#include "NavSvoGenerationStats.h"
 #include "NavSvoGenerator.h"
+#include "NavSvoTileCache.h"
 
 #include "AI/Navigation/NavigationRelevantData.h"
+#include "Algo/StableSort.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "NavAreas/NavArea.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "UObject/ObjectKey.h"
+
+#if WITH_EDITOR
+#include "NavSvoGPUVoxelizer.h"
+#endif
+
+// If a tile that's already built only has some of its leaves dirtied, and they're at most
+// this fraction of the tile, only those leaves are rebuilt. Zero always rebuilds whole tiles.
+TAutoConsoleVariable<float> CVarNavSvoMaxPartialRebuildFraction(TEXT("NavSvo.MaxPartialRebuildFraction"), 0.25f, TEXT("Largest fraction of a tile's leaves that can be dirty for them to be rebuilt without rebuilding the whole tile (0 to disable)."), ECVF_Cheat);
+
+TAutoConsoleVariable<bool> CVarNavSvoLegacyRasterizer(TEXT("NavSvo.LegacyRasterizer"), false, TEXT("Voxelizes triangles by walking their edges one voxel at a time, instead of testing whole leaves at once."), ECVF_Cheat);
+
+#if WITH_EDITOR
+TAutoConsoleVariable<bool> CVarNavSvoGPUVoxelization(TEXT("NavSvo.GPUVoxelization"), false, TEXT("Voxelizes and pads tiles with compute shaders when building in the editor, falling back to the CPU if the GPU can't be used."), ECVF_Cheat);
+#endif
+
+struct FNavSvoTileGenerator::FSharedTileRegistry
+{
+	struct FSharedTile
+	{
+		TWeakPtr<FTileGenerationData> Tile;
+
+		// Voxel grid the tile was gathered for
+		float VoxelSize;
+		uint32 NumLeafNodesPerAxis;
+		uint32 NumPaddingLeafNodesPerAxis;
+	};
+
+	typedef TPair<TObjectKey<UWorld>, FName> FGroupKey;
+
+	TMap<FGroupKey, TMap<FIntVector, FSharedTile>> Groups;
+};
+
+FNavSvoTileGenerator::FSharedTileRegistry& FNavSvoTileGenerator::GetSharedTileRegistry()
+{
+	// Only accessed while adding tiles, on the game thread
+	check(IsInGameThread());
+
+	static FSharedTileRegistry Registry;
+	return Registry;
+}
+
+void FNavSvoTileGenerator::ResetSharedTiles(const UWorld* World)
+{
+	FSharedTileRegistry& Registry = GetSharedTileRegistry();
+
+	for (auto It = Registry.Groups.CreateIterator(); It; ++It)
+	{
+		if (It->Key.Key == TObjectKey<UWorld>(World) || It->Key.Key.ResolveObjectPtr() == nullptr)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+TSharedPtr<FNavSvoTileGenerator::FTileGenerationData> FNavSvoTileGenerator::FindSharedTile(const UWorld* World, const FTileGenerationData& Tile) const
+{
+	FSharedTileRegistry& Registry = GetSharedTileRegistry();
+
+	TMap<FIntVector, FSharedTileRegistry::FSharedTile>* Group = Registry.Groups.Find(FSharedTileRegistry::FGroupKey(TObjectKey<UWorld>(World), Config.VoxelizationGroup));
+	if (Group == nullptr)
+	{
+		return nullptr;
+	}
+
+	const FSharedTileRegistry::FSharedTile* SharedTile = Group->Find(Tile.TileCoord);
+	if (SharedTile == nullptr)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FTileGenerationData> Source = SharedTile->Tile.Pin();
+	if (!Source.IsValid())
+	{
+		Group->Remove(Tile.TileCoord);
+		return nullptr;
+	}
+
+	// The voxels need to line up with ours
+	if (SharedTile->VoxelSize != Config.GetVoxelSize() ||
+		SharedTile->NumLeafNodesPerAxis != Config.NumLeafNodesPerAxis ||
+		SharedTile->NumPaddingLeafNodesPerAxis != Config.NumPaddingLeafNodesPerAxis)
+	{
+		return nullptr;
+	}
+
+	// They also need to cover all the space our padding can reach. Any extra space they
+	// cover is too far away to pad into our tile.
+	if (!Source->FillBounds.IsInsideOrOn(Tile.FillBounds.Min) || !Source->FillBounds.IsInsideOrOn(Tile.FillBounds.Max))
+	{
+		return nullptr;
+	}
+
+	if (Source->CollisionInterface.SupportedAreas != Tile.CollisionInterface.SupportedAreas)
+	{
+		return nullptr;
+	}
+
+	return Source;
+}
+
+void FNavSvoTileGenerator::RegisterSharedTile(const UWorld* World, const TSharedRef<FTileGenerationData>& TileRef) const
+{
+	FSharedTileRegistry& Registry = GetSharedTileRegistry();
+
+	TileRef->bIsShared = true;
+
+	FSharedTileRegistry::FSharedTile& SharedTile = Registry.Groups.FindOrAdd(FSharedTileRegistry::FGroupKey(TObjectKey<UWorld>(World), Config.VoxelizationGroup)).FindOrAdd(TileRef->TileCoord);
+	SharedTile.Tile = TileRef;
+	SharedTile.VoxelSize = Config.GetVoxelSize();
+	SharedTile.NumLeafNodesPerAxis = Config.NumLeafNodesPerAxis;
+	SharedTile.NumPaddingLeafNodesPerAxis = Config.NumPaddingLeafNodesPerAxis;
+}
+
+bool FNavSvoTileGenerator::FillSharedVoxels(FTileGenerationData& Tile) const
+{
+	// Whichever generator gets to the tile first fills it, and any others wait for it to
+	// finish.
+	FScopeLock Lock(&Tile.SharedVoxelsLock);
+
+	if (!Tile.bSharedVoxelsFilled)
+	{
+		const uint32 NumLeafNodes = Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis;
+
+		Tile.SharedVoxels.Reset(NumLeafNodes);
+		Tile.bSharedVoxelsBlocked = FillVoxels(Tile, Tile.SharedVoxels);
+		Tile.bSharedVoxelsFilled = true;
+	}
+
+	return Tile.bSharedVoxelsBlocked;
+}
 
 FNavSvoTileGenerator::FNavSvoTileGenerator(const FNavSvoGenerator& InParent, const FNavSvoGeneratorConfig& InConfig)
 	: Config(InConfig)
 	, bIsComplete(false)
 {
-#if PROFILE_SVO_GENERATION
+	JobID = FNavSvoGenerationStats::NextJobID();
 	CreateCycle = FPlatformTime::Cycles64();
-#endif
 
 	// Store a weak ptr to the parent
 	ParentWeakPtr = InParent.AsShared();
 }
 
+FNavSvoTileGenerator::FNavSvoTileGenerator(const FNavSvoGeneratorConfig& InConfig)
+	: Config(InConfig)
+	, bIsComplete(false)
+{
+	JobID = FNavSvoGenerationStats::NextJobID();
+	CreateCycle = FPlatformTime::Cycles64();
+
+	// We only ever build one tile at a time into the temporary SVO used for linking
+	Config.SetTilePoolSize(1);
+	Config.SetTilePoolSizeFixed(true);
+}
+
 void FNavSvoTileGenerator::DoWork()
 {
+	StartWorkCycle = FPlatformTime::Cycles64();
+
 	TSharedPtr<const FNavDataGenerator, ESPMode::ThreadSafe> ParentSharedPtr = ParentWeakPtr.Pin();
 
 	if (!ParentSharedPtr.IsValid())
@@ -38,53 +190,259 @@ void FNavSvoTileGenerator::DoWork()
 	const FNavSvoGenerator* Parent = static_cast<const FNavSvoGenerator*>(ParentSharedPtr.Get());
 	ensure(Parent);
 
+	// Add an SVO tile for each tile and initialize it to open up front, so the array
+	// doesn't move while the tiles are being built. We always need to return a tile, even
+	// if it just represents empty space.
+	GeneratedTiles.Reserve(Tiles.Num());
+
+	for (const TSharedRef<FTileGenerationData>& TileRef : Tiles)
+	{
+		FSvoTile& BuiltTile = GeneratedTiles.Add_GetRef(FSvoTile(FSvoTile::CalcTileID(TileRef->TileCoord), Config.GetTileLayerIndex(), TileRef->TileCoord));
+		BuiltTile.GetNodeInfo().SetNodeState(ENodeState::Open);
+	}
+
+	// Generate the tiles. Each tile only touches its own data (and shared voxels, which are
+	// locked), so they can be built on any thread. The buffers we use during generation
+	// are per thread, and kept around by each worker between jobs.
+	{
+		FNavSvoScopedGenerationTimer WorkTimer(WorkCycles);
+
+		ParallelFor(Tiles.Num(), [this](int32 TileIdx)
+		{
+			GenerateTile(Tiles[TileIdx].Get(), GeneratedTiles[TileIdx], FNavSvoGenerationArena::Get());
+		},
+		bParallelTiles ? EParallelForFlags::Unbalanced : EParallelForFlags::ForceSingleThread);
+	}
+
+	bIsComplete = true;
+}
+
+void FNavSvoTileGenerator::GenerateTile(FTileGenerationData& Tile, FSvoTile& BuiltTile, FNavSvoGenerationArena& Arena) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_GenerateTile);
+
+	FNavSvoTileGenerationStats TileStats;
+	TileStats.TileCoord = Tile.TileCoord;
+
+	BuildTile(Tile, BuiltTile, Arena, TileStats);
+	Arena.UpdateTotalMemUsed();
+
+	if (FNavSvoGenerationStats::IsEnabled())
+	{
+		// Tiles using the voxels of another generator's tile didn't gather any geometry
+		// of their own.
+		const FTileGenerationData& GeometryTile = Tile.VoxelSource.IsValid() ? *Tile.VoxelSource : Tile;
+		TileStats.TotalTriangles = GeometryTile.CollisionInterface.TotalTriangles;
+		TileStats.UsedTriangles = GeometryTile.CollisionInterface.UsedTriangles;
+
+		// Gathering happens as part of filling, so take it out of the fill time
+		TileStats.GatherCycles = Tile.GatherCycles;
+		TileStats.FillCycles -= FMath::Min(TileStats.FillCycles, Tile.GatherCycles);
+
+		FNavSvoGenerationStats::RecordTile(JobID, TileStats);
+	}
+}
+
+void FNavSvoTileGenerator::BuildTile(FTileGenerationData& Tile, FSvoTile& BuiltTile, FNavSvoGenerationArena& Arena, FNavSvoTileGenerationStats& OutStats) const
+{
 	const uint32 NumLeafNodes = Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis;
 
-	const uint32 NumVoxels = NumLeafNodes * SVO_VOXELS_PER_LEAF;
+	// Convert our input triangles into voxels. If this returns false there weren't any
+	// triangles that actually overlapped our navigable space so we're done. The voxels
+	// don't depend on the agent size, so if the tile is shared with other nav data
+	// they're only filled once for all of us.
+	const FNavSvoVoxelBuffer* TileVoxels = &Arena.Voxels;
+	bool bFilledVoxel = false;
 
-	GeneratedTiles.Reserve(Tiles.Num());
+	FSHAHash InputHash;
+	bool bUseTileCache = false;
+	bool bPaddedOnGPU = false;
 
-	BuildPaddingOffsetCodes();
+	Arena.PaddedVoxels.Reset(NumLeafNodes);
 
-	// Buffers we use during generation
-	TBitArray<> Voxels;
-	TBitArray<> PaddedVoxels;
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_FillVoxels);
+		FNavSvoScopedGenerationTimer FillTimer(OutStats.FillCycles);
 
-	// Generate the tiles
-	for (TSharedRef<FTileGenerationData>& TileRef : Tiles)
+		if (Tile.VoxelSource.IsValid())
+		{
+			bFilledVoxel = FillSharedVoxels(*Tile.VoxelSource);
+			TileVoxels = &Tile.VoxelSource->SharedVoxels;
+		}
+		else if (Tile.bIsShared)
+		{
+			bFilledVoxel = FillSharedVoxels(Tile);
+			TileVoxels = &Tile.SharedVoxels;
+		}
+		else
+		{
+			// If nothing that goes into the tile has changed since it was last built we
+			// can reuse that tile. Partial rebuilds are cheap already, and their inputs
+			// include the rest of the tile, so they're always built.
+			if (FNavSvoTileCache::IsEnabled() && !Tile.bPartialRebuild)
+			{
+				GatherTileGeometry(Tile);
+				InputHash = CalcTileInputHash(Tile);
+				bUseTileCache = true;
+
+				if (FNavSvoTileCache::Get().Find(InputHash, BuiltTile))
+				{
+					OutStats.bFromCache = true;
+					return;
+				}
+			}
+
+			Arena.Voxels.Reset(NumLeafNodes);
+
+#if WITH_EDITOR
+			// Large tiles with lots of geometry can be much faster to voxelize on the GPU
+			// when building in the editor. Padding is done there too, so it doesn't have
+			// to be sent back and forth.
+			if (CVarNavSvoGPUVoxelization.GetValueOnAnyThread() && !Tile.bPartialRebuild)
+			{
+				bPaddedOnGPU = VoxelizeOnGPU(Tile, Arena, bFilledVoxel);
+			}
+#endif
+
+			if (!bPaddedOnGPU)
+			{
+				bFilledVoxel = FillVoxels(Tile, Arena.Voxels);
+			}
+		}
+	}
+
+	// The voxel data currently represents the exact blocked space, i.e., a voxel could be
+	// marked as clear when the voxel next to it is completely filled with collision. We
+	// need it to represent a space where an agent could be centered at any location in
+	// the voxel and not be colliding. So, we pad out the voxels by however many we need
+	// to ensure that an agent with the specified radius can fit.
+	if (bFilledVoxel && !bPaddedOnGPU)
 	{
-		FTileGenerationData& Tile = TileRef.Get();
+		TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_PadVoxels);
+		FNavSvoScopedGenerationTimer PadTimer(OutStats.PadCycles);
 
-		// Add an SVO tile for this tile and initialize it to open. We always need to
-		// return a tile, even if it just represents empty space.
-		FSvoTile& BuiltTile = GeneratedTiles.Add_GetRef(FSvoTile(FSvoTile::CalcTileID(Tile.TileCoord), Config.GetTileLayerIndex(), Tile.TileCoord));
-		BuiltTile.GetNodeInfo().SetNodeState(ENodeState::Open);
+		PadVoxels(Tile, *TileVoxels, Arena.PaddedVoxels, Arena);
+	}
+
+	// If we only rebuilt some of the leaves, fill in the rest from the existing tile
+	if (Tile.bPartialRebuild)
+	{
+		CopyBaseLeaves(Tile, Arena.PaddedVoxels);
+		bFilledVoxel = !Arena.PaddedVoxels.IsEmpty();
+	}
+
+	if (bFilledVoxel)
+	{
+		// Now that we have all the voxelized space generated convert it into a tile we
+		// can add to the octree.
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_CreateTileFromVoxels);
+			FNavSvoScopedGenerationTimer NodeTimer(OutStats.NodeCycles);
+
+			CreateTileFromVoxels(Tile, Arena.PaddedVoxels, BuiltTile, Arena);
+		}
+
+		if (Config.MaxClearance > 0)
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_BuildClearance);
+			FNavSvoScopedGenerationTimer ClearanceTimer(OutStats.ClearanceCycles);
 
-		Voxels.Init(false, NumVoxels);
+			BuildClearance(*TileVoxels, BuiltTile, Arena);
+		}
 
-		// Convert our input triangles into voxels. If this returns false there weren't
-		// any triangles that actually overlapped our navigable space so we're done.
-		if (FillVoxels(Tile, Voxels))
 		{
-			// The voxel data currently represents the exact blocked space, i.e., a voxel
-			// could be marked as clear when the voxel next to it is completely filled
-			// with collision. We need it to represent a space where an agent could be
-			// centered at any location in the voxel and not be colliding. So, we pad out
-			// the voxels by however many we need to ensure that an agent with the
-			// specified radius can fit.
-			PaddedVoxels.Init(false, NumVoxels);
-			PadVoxels(Tile, Voxels, PaddedVoxels);
+			TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_BuildAreas);
+			FNavSvoScopedGenerationTimer AreaTimer(OutStats.NodeCycles);
 
-			// Now that we have all the voxelized space generated convert it into a tile
-			// we can add to the octree.
-			CreateTileFromVoxels(Tile, PaddedVoxels, BuiltTile);
+			BuildAreas(Tile, BuiltTile, Arena);
 		}
 	}
 
-	bIsComplete = true;
+	if (bUseTileCache)
+	{
+		FNavSvoTileCache::Get().Add(InputHash, BuiltTile);
+	}
+}
+
+void FNavSvoTileGenerator::BuildTileFromVoxels(const FIntVector& TileCoord, TFunctionRef<bool(const FVector& VoxelCenter)> IsVoxelBlocked, FSvoTile& BuiltTile, FNavSvoTileGenerationStats& OutStats) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_BuildTileFromVoxels);
+
+	FNavSvoGenerationArena& Arena = FNavSvoGenerationArena::Get();
+
+	const uint32 NumLeafNodes = Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis;
+	const float VoxelSize = Config.GetVoxelSize();
+
+	const FVector& TileCenter = Config.TileCoordToLocation(TileCoord);
+	const FBox TileBounds = FBox::BuildAABB(TileCenter, Config.GetTileExtent());
+	const FVector PaddedTileMin = TileCenter - (Config.NumLeafNodesPerAxis * Config.GetLeafResolution() * 0.5f);
+
+	// The whole tile is navigable, as if it were inside a single navigation bounds
+	FTileGenerationData Tile;
+	Tile.TileCoord = TileCoord;
+	Tile.TileMin = TileBounds.Min;
+	Tile.GatherBounds = TileBounds.ExpandBy(Config.BoundsPadding);
+	Tile.FillBounds.Min = FSvoUtils::LocationToCoord(PaddedTileMin, Tile.GatherBounds.Min, VoxelSize);
+	Tile.FillBounds.Max = FSvoUtils::LocationToCoord(PaddedTileMin, Tile.GatherBounds.Max, VoxelSize);
+
+	FIntBox& VoxelBounds = Tile.VoxelBounds.AddDefaulted_GetRef();
+	FSvoUtils::GetCoordsForBounds(TileBounds.Min, TileBounds, VoxelSize, VoxelBounds.Min, VoxelBounds.Max);
+
+	bool bFilledVoxel = false;
+
+	Arena.Voxels.Reset(NumLeafNodes);
+	Arena.PaddedVoxels.Reset(NumLeafNodes);
+
+	{
+		FNavSvoScopedGenerationTimer FillTimer(OutStats.FillCycles);
+
+		// Fill the same range of leaves geometry would be voxelized into, a leaf at a time
+		for (const uint32 LeafCode : FMortonIterator(Config.MinPaddedLeafCode, Config.MaxPaddedLeafCode))
+		{
+			uint64 LeafVoxels = 0;
+
+			for (uint32 VoxelIdx = 0; VoxelIdx < 64; ++VoxelIdx)
+			{
+				const FIntVector VoxelCoord = FSvoUtils::MortonToCoord((LeafCode << 6) | VoxelIdx);
+				const FVector VoxelCenter = PaddedTileMin + (FVector(VoxelCoord) + 0.5f) * VoxelSize;
+
+				if (IsVoxelBlocked(VoxelCenter))
+				{
+					LeafVoxels |= (1ull << VoxelIdx);
+				}
+			}
+
+			if (LeafVoxels != 0)
+			{
+				Arena.Voxels.SetLeaf(LeafCode, LeafVoxels);
+				bFilledVoxel = true;
+			}
+		}
+	}
+
+	if (!bFilledVoxel)
+	{
+		return;
+	}
+
+	{
+		FNavSvoScopedGenerationTimer PadTimer(OutStats.PadCycles);
+		PadVoxels(Tile, Arena.Voxels, Arena.PaddedVoxels, Arena);
+	}
+
+	{
+		FNavSvoScopedGenerationTimer NodeTimer(OutStats.NodeCycles);
+		CreateTileFromVoxels(Tile, Arena.PaddedVoxels, BuiltTile, Arena);
+	}
+
+	if (Config.MaxClearance > 0)
+	{
+		FNavSvoScopedGenerationTimer ClearanceTimer(OutStats.ClearanceCycles);
+		BuildClearance(Arena.Voxels, BuiltTile, Arena);
+	}
 }
 
-bool FNavSvoTileGenerator::AddTile(const FIntVector& TileCoord)
+bool FNavSvoTileGenerator::AddTile(const FIntVector& TileCoord, const FBox& DirtyBounds)
 {
 	TSharedPtr<const FNavDataGenerator, ESPMode::ThreadSafe> ParentSharedPtr = ParentWeakPtr.Pin();
 	if (!ParentSharedPtr.IsValid())
@@ -138,15 +496,33 @@ bool FNavSvoTileGenerator::AddTile(const FIntVector& TileCoord)
 		return false;
 	}
 
+	TSharedRef<FTileGenerationData> TileRef = MakeShareable(new FTileGenerationData);
+	FTileGenerationData& Tile = TileRef.Get();
+
+	// If only part of a tile we've already built is dirty, we only need the geometry that
+	// can affect the dirty leaves.
+	const bool bIsGroupShared = !Config.VoxelizationGroup.IsNone();
+	if (DirtyBounds.IsValid && !bIsGroupShared)
+	{
+		const FEditableSvo* Octree = Parent->GetOctree();
+		const FSvoTile* ExistingTile = Octree ? Octree->GetTile(FSvoTile::CalcTileID(TileCoord)) : nullptr;
+
+		if (ExistingTile && InitPartialRebuild(*ExistingTile, TileBounds, DirtyBounds, Tile))
+		{
+			const FBox DirtyLeafBounds(
+				TileBounds.Min + FVector(Tile.DirtyLeaves.Min) * Config.GetLeafResolution(),
+				TileBounds.Min + FVector(Tile.DirtyLeaves.Max + FIntVector(1)) * Config.GetLeafResolution());
+
+			GatherBounds = GatherBounds.Overlap(DirtyLeafBounds.ExpandBy(Config.BoundsPadding));
+		}
+	}
+
 	// Generate a voxel-space version of the gather bounds, for use by the generation code
 	// to determine if a voxel should be filled in.
 	FIntBox FillBounds;
 	FillBounds.Min = FSvoUtils::LocationToCoord(PaddedTileMin, GatherBounds.Min, Config.GetVoxelSize());
 	FillBounds.Max = FSvoUtils::LocationToCoord(PaddedTileMin, GatherBounds.Max, Config.GetVoxelSize());
 
-	TSharedRef<FTileGenerationData> TileRef = MakeShareable(new FTileGenerationData);
-	FTileGenerationData& Tile = TileRef.Get();
-
 	Tile.TileCoord = TileCoord;
 	Tile.TileMin = TileBounds.Min;
 	Tile.GatherBounds = GatherBounds;
@@ -161,7 +537,18 @@ bool FNavSvoTileGenerator::AddTile(const FIntVector& TileCoord)
 	const FNavDataConfig& NavDataConfig = Parent->GetNavDataActor()->GetConfig();
 
 	// Cache off the supported area types for this nav volume
-	Parent->GetNavDataActor()->GetSupportedAreaClasses(Tile.CollisionInterface.SupportedAreas);
+	Parent->GetNavDataActor()->GetSupportedAreaClasses(Tile.CollisionInterface.SupportedAreas, &Tile.CollisionInterface.SupportedAreaIDs);
+
+	// If another nav data in our voxelization group has already gathered this tile we
+	// can use its voxels, and skip gathering entirely.
+	if (bIsGroupShared)
+	{
+		Tile.VoxelSource = FindSharedTile(World, Tile);
+		if (Tile.VoxelSource.IsValid())
+		{
+			return true;
+		}
+	}
 
 	if (Config.bDoAsyncGeometryGathering)
 	{
@@ -172,8 +559,16 @@ bool FNavSvoTileGenerator::AddTile(const FIntVector& TileCoord)
 		Tile.CollisionInterface.GatherGeometry(World, NavDataConfig, GatherBounds);
 	}
 
-	// TODO: This isn't accurate if we're doing async gathering, although we currently never do that
-	TriCount += Tile.CollisionInterface.CulledTriangles.Num();
+	// With async gathering we don't know how many triangles there are until the worker
+	// culls them, but the total in the sources is close enough to size the job.
+	TriCount += Config.bDoAsyncGeometryGathering ?
+		Tile.CollisionInterface.NumSourceTriangles :
+		Tile.CollisionInterface.GetNumTriangles();
+
+	if (bIsGroupShared)
+	{
+		RegisterSharedTile(World, TileRef);
+	}
 
 	return true;
 }
@@ -205,9 +600,12 @@ FSvoTile* FNavSvoTileGenerator::GetNextGeneratedTile()
 
 void FNavSvoTileGenerator::AddReferencedObjects(FReferenceCollector& Collector)
 {
-	for (TSharedRef<FTileGenerationData>& Tile : Tiles)
+	for (TSharedRef<FTileGenerationData>& TileRef : Tiles)
 	{
-		for (FNavigationOctreeCollider::TNavigationData& RelevantData : Tile->CollisionInterface.NavigationRelevantData)
+		// Keep the geometry of any tiles we're voxelizing from alive too
+		FTileGenerationData& Tile = TileRef->VoxelSource.IsValid() ? *TileRef->VoxelSource : TileRef.Get();
+
+		for (FNavigationOctreeCollider::TNavigationData& RelevantData : Tile.CollisionInterface.NavigationRelevantData)
 		{
 			TObjectPtr<UObject> Owner = RelevantData->GetOwner();
 			if (Owner)
@@ -218,17 +616,13 @@ void FNavSvoTileGenerator::AddReferencedObjects(FReferenceCollector& Collector)
 	}
 }
 
-bool FNavSvoTileGenerator::FillVoxels(FTileGenerationData& Tile, TBitArray<>& Voxels) const
+bool FNavSvoTileGenerator::FillVoxels(FTileGenerationData& Tile, FNavSvoVoxelBuffer& Voxels) const
 {
 #if PROFILE_SVO_GENERATION
 	const uint64 StartCycle = FPlatformTime::Cycles64();
 #endif
 
-	if (Tile.CollisionInterface.HasCollisionData())
-	{
-		// If geometry needs to be gathered on the worker thread, do so now.
-		Tile.CollisionInterface.GatherGeometryFromSources(Tile.GatherBounds);
-	}
+	GatherTileGeometry(Tile);
 
 	bool FilledVoxel = false;
 
@@ -251,6 +645,104 @@ bool FNavSvoTileGenerator::FillVoxels(FTileGenerationData& Tile, TBitArray<>& Vo
 	return FilledVoxel;
 }
 
+void FNavSvoTileGenerator::GatherTileGeometry(FTileGenerationData& Tile) const
+{
+	if (!Tile.bGeometryGathered && Tile.CollisionInterface.HasCollisionData())
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(NavSvo_GatherTileGeometry);
+		FNavSvoScopedGenerationTimer GatherTimer(Tile.GatherCycles);
+
+		// If geometry needs to be gathered on the worker thread, do so now.
+		Tile.CollisionInterface.GatherGeometryFromSources(Tile.GatherBounds);
+	}
+
+	Tile.bGeometryGathered = true;
+}
+
+FSHAHash FNavSvoTileGenerator::CalcTileInputHash(const FTileGenerationData& Tile) const
+{
+	FSHA1 Hash;
+
+	const auto HashValue = [&Hash](const auto& Value)
+	{
+		Hash.Update(reinterpret_cast<const uint8*>(&Value), sizeof(Value));
+	};
+
+	const auto HashBox = [&HashValue](const FIntBox& Box)
+	{
+		HashValue(Box.Min);
+		HashValue(Box.Max);
+	};
+
+	// Anything that changes how tiles are built or stored
+	HashValue(FNavSvoTileCache::Version);
+	HashValue(FGunfire3DNavigationCustomVersion::LatestVersion);
+	HashValue(FSvoNode::GetLayoutSignature());
+	HashValue(CVarNavSvoLegacyRasterizer.GetValueOnAnyThread());
+
+	// The generation config
+	HashValue(Config.GetVoxelSize());
+	HashValue(Config.GetTileLayerIndex());
+	HashValue(Config.AgentHalfHeight);
+	HashValue(Config.AgentRadius);
+	HashValue(Config.MaxClearance);
+	HashValue(Config.NumLeafNodesPerAxis);
+	HashValue(Config.NumPaddingLeafNodesPerAxis);
+	HashValue(Config.BoundsPadding);
+
+	// Where the tile is, and which parts of it are navigable
+	HashValue(Tile.TileCoord);
+	HashValue(Tile.TileMin);
+	HashValue(Tile.GatherBounds.Min);
+	HashValue(Tile.GatherBounds.Max);
+	HashBox(Tile.FillBounds);
+
+	HashValue(Tile.VoxelBounds.Num());
+	for (const FIntBox& Box : Tile.VoxelBounds)
+	{
+		HashBox(Box);
+	}
+
+	// What's blocking it
+	const FNavigationOctreeCollider& Collider = Tile.CollisionInterface;
+
+	HashValue(Collider.GetNumTriangles());
+	Collider.ForEachTriangle([&Hash](const FNavigationOctreeCollider::FTriangle& Tri)
+	{
+		Hash.Update(reinterpret_cast<const uint8*>(Tri.Vertices), sizeof(Tri.Vertices));
+	});
+
+	HashValue(Collider.Blockers.Num());
+	for (const FConvexNavAreaData& Blocker : Collider.Blockers)
+	{
+		Hash.Update(reinterpret_cast<const uint8*>(Blocker.Points.GetData()), Blocker.Points.Num() * Blocker.Points.GetTypeSize());
+		HashValue(Blocker.MinZ);
+		HashValue(Blocker.MaxZ);
+	}
+
+	// And which areas it's in
+	TArray<FAreaShape> AreaShapes;
+	GatherAreaShapes(Tile, AreaShapes);
+
+	HashValue(AreaShapes.Num());
+	for (const FAreaShape& Shape : AreaShapes)
+	{
+		HashValue(Shape.Bounds.Min);
+		HashValue(Shape.Bounds.Max);
+		Hash.Update(reinterpret_cast<const uint8*>(Shape.Points.GetData()), Shape.Points.Num() * Shape.Points.GetTypeSize());
+		HashValue(Shape.Center);
+		HashValue(Shape.Radius);
+		HashValue(Shape.AreaCode);
+		HashValue(Shape.Priority);
+	}
+
+	Hash.Final();
+
+	FSHAHash InputHash;
+	Hash.GetHash(InputHash.Hash);
+	return InputHash;
+}
+
 //
 // Based on https://github.com/ramakarl/voxelizer/ with a lot of modifications
 //
@@ -276,7 +768,7 @@ bool FNavSvoTileGenerator::FillVoxels(FTileGenerationData& Tile, TBitArray<>& Vo
 // small triangles. It would be nice if we could figure out a way to just handle more
 // things in a single algorithm vs having all these special cases bloating things up.
 //
-bool FNavSvoTileGenerator::FillTriangles(FTileGenerationData& Tile, const FVector& TileMin, TBitArray<>& Voxels) const
+bool FNavSvoTileGenerator::FillTriangles(FTileGenerationData& Tile, const FVector& TileMin, FNavSvoVoxelBuffer& Voxels) const
 {
 	bool FilledVoxel = false;
 
@@ -288,12 +780,20 @@ bool FNavSvoTileGenerator::FillTriangles(FTileGenerationData& Tile, const FVecto
 		return (Pos - TileMin) / VoxelSize;
 	};
 
-	for (const FNavigationOctreeCollider::FTriangle& Tri : Tile.CollisionInterface.CulledTriangles)
+	const bool bUseLegacyRasterizer = CVarNavSvoLegacyRasterizer.GetValueOnAnyThread();
+
+	Tile.CollisionInterface.ForEachTriangle([&](const FNavigationOctreeCollider::FTriangle& Tri)
 	{
 		const FVector V0 = ToVoxelSpace(Tri.Vertices[0]);
 		const FVector V1 = ToVoxelSpace(Tri.Vertices[1]);
 		const FVector V2 = ToVoxelSpace(Tri.Vertices[2]);
 
+		if (!bUseLegacyRasterizer)
+		{
+			FilledVoxel |= RasterizeTriangleSAT(Tile, V0, V1, V2, Voxels);
+			return;
+		}
+
 		const FVector E0 = V1 - V0;
 		const FVector E1 = V2 - V0;
 		const FVector E2 = V2 - V1;
@@ -345,12 +845,12 @@ bool FNavSvoTileGenerator::FillTriangles(FTileGenerationData& Tile, const FVecto
 			});
 
 		FilledVoxel |= RasterizeTriangle(Tile, Verts, AxisMap, Voxels);
-	}
+	});
 
 	return FilledVoxel;
 }
 
-bool FNavSvoTileGenerator::RasterizeTriangle(FTileGenerationData& Tile, TArrayView<FVector> Verts, FIntVector AxisMap, TBitArray<>& Voxels) const
+bool FNavSvoTileGenerator::RasterizeTriangle(FTileGenerationData& Tile, TArrayView<FVector> Verts, FIntVector AxisMap, FNavSvoVoxelBuffer& Voxels) const
 {
 	bool DidSetVoxel = false;
 
@@ -361,7 +861,7 @@ bool FNavSvoTileGenerator::RasterizeTriangle(FTileGenerationData& Tile, TArrayVi
 		if (Tile.FillBounds.IsInsideOrOn(VoxelCoord))
 		{
 			const TMortonCode VoxelMorton = FSvoUtils::CoordToMorton(VoxelCoord);
-			Voxels[VoxelMorton] = true;
+			Voxels.SetVoxel(VoxelMorton);
 			DidSetVoxel = true;
 		}
 	};
@@ -599,18 +1099,219 @@ bool FNavSvoTileGenerator::RasterizeTriangle(FTileGenerationData& Tile, TArrayVi
 	return DidSetVoxel;
 }
 
-bool FNavSvoTileGenerator::FillBlockers(const FTileGenerationData& Tile, const FVector& TileMin, TBitArray<>& Voxels) const
+namespace NavSvoRasterizer
 {
-	const double VoxelSize = Config.GetVoxelSize();
+	// Voxels are treated as half-open boxes, so a triangle exactly on the boundary
+	// between two voxels only fills the one above it, the same as flooring a point.
+	constexpr float BoxEpsilon = 1e-3f;
 
-	const auto ToVoxelSpace = [&TileMin, &VoxelSize](const FVector& Pos) -> FVector
+	// Separating axes for a triangle against axis aligned boxes: the three box normals,
+	// the triangle normal, and the cross products of each box normal with each edge.
+	constexpr int32 NumAxes = 13;
+
+	struct FTriangleAxes
 	{
-		return (Pos - TileMin) / VoxelSize;
-	};
+		VectorRegister4Float AxisX[NumAxes];
+		float AxisY[NumAxes];
+		float AxisZ[NumAxes];
 
-	FConvexVolume ConvexVol;
+		// The triangle's range along each axis
+		VectorRegister4Float MinProj[NumAxes];
+		VectorRegister4Float MaxProj[NumAxes];
 
-	const FBox VoxelBounds(FVector::ZeroVector, ToVoxelSpace(Tile.GatherBounds.Max));
+		// Projected radius along each axis of a box with a half size of one
+		float Radius[NumAxes];
+
+		FTriangleAxes(const FVector3f& V0, const FVector3f& V1, const FVector3f& V2)
+		{
+			const FVector3f Edges[3] = { V1 - V0, V2 - V1, V0 - V2 };
+
+			FVector3f Axes[NumAxes];
+			int32 NumAdded = 0;
+			Axes[NumAdded++] = FVector3f::XAxisVector;
+			Axes[NumAdded++] = FVector3f::YAxisVector;
+			Axes[NumAdded++] = FVector3f::ZAxisVector;
+			Axes[NumAdded++] = FVector3f::CrossProduct(Edges[0], Edges[1]);
+
+			for (const FVector3f& Edge : Edges)
+			{
+				Axes[NumAdded++] = FVector3f(0.f, -Edge.Z, Edge.Y);
+				Axes[NumAdded++] = FVector3f(Edge.Z, 0.f, -Edge.X);
+				Axes[NumAdded++] = FVector3f(-Edge.Y, Edge.X, 0.f);
+			}
+
+			check(NumAdded == NumAxes);
+
+			// Degenerate axes (an edge parallel to a box normal) come out as zero, which
+			// never separates anything, so they don't need special handling.
+			for (int32 AxisIdx = 0; AxisIdx < NumAxes; ++AxisIdx)
+			{
+				const FVector3f& Axis = Axes[AxisIdx];
+
+				const float P0 = Axis | V0;
+				const float P1 = Axis | V1;
+				const float P2 = Axis | V2;
+
+				AxisX[AxisIdx] = VectorSetFloat1(Axis.X);
+				AxisY[AxisIdx] = Axis.Y;
+				AxisZ[AxisIdx] = Axis.Z;
+				MinProj[AxisIdx] = VectorSetFloat1(FMath::Min3(P0, P1, P2));
+				MaxProj[AxisIdx] = VectorSetFloat1(FMath::Max3(P0, P1, P2));
+				Radius[AxisIdx] = FMath::Abs(Axis.X) + FMath::Abs(Axis.Y) + FMath::Abs(Axis.Z);
+			}
+		}
+
+		// Tests four boxes in a row along the x axis, returning a bit for each box the
+		// triangle overlaps.
+		FORCEINLINE uint32 TestRow(const VectorRegister4Float& CenterX, float CenterY, float CenterZ, float HalfSize) const
+		{
+			VectorRegister4Float Overlaps = TestAxis(0, CenterX, CenterY, CenterZ, HalfSize);
+
+			for (int32 AxisIdx = 1; AxisIdx < NumAxes; ++AxisIdx)
+			{
+				Overlaps = VectorBitwiseAnd(Overlaps, TestAxis(AxisIdx, CenterX, CenterY, CenterZ, HalfSize));
+			}
+
+			return (uint32)VectorMaskBits(Overlaps);
+		}
+
+		FORCEINLINE VectorRegister4Float TestAxis(int32 AxisIdx, const VectorRegister4Float& CenterX, float CenterY, float CenterZ, float HalfSize) const
+		{
+			const VectorRegister4Float Dist = VectorMultiplyAdd(AxisX[AxisIdx], CenterX, VectorSetFloat1((AxisY[AxisIdx] * CenterY) + (AxisZ[AxisIdx] * CenterZ)));
+			const VectorRegister4Float BoxRadius = VectorSetFloat1(Radius[AxisIdx] * HalfSize);
+
+			return VectorBitwiseAnd(
+				VectorCompareGE(VectorAdd(Dist, BoxRadius), MinProj[AxisIdx]),
+				VectorCompareLE(VectorSubtract(Dist, BoxRadius), MaxProj[AxisIdx]));
+		}
+	};
+
+	// Morton bits within a leaf for each combination of the four voxels in a row
+	const uint64 RowMortonBits[16] =
+	{
+		0x000, 0x001, 0x002, 0x003, 0x100, 0x101, 0x102, 0x103,
+		0x200, 0x201, 0x202, 0x203, 0x300, 0x301, 0x302, 0x303,
+	};
+
+	// Returns a mask of the x values from 'StartX' to 'StartX + 3' that are in the range
+	FORCEINLINE uint32 GetRowMask(int32 StartX, int32 MinX, int32 MaxX)
+	{
+		uint32 Mask = 0;
+		for (int32 LaneIdx = 0; LaneIdx < 4; ++LaneIdx)
+		{
+			const int32 X = StartX + LaneIdx;
+			Mask |= (X >= MinX && X <= MaxX) ? (1u << LaneIdx) : 0;
+		}
+		return Mask;
+	}
+}
+
+bool FNavSvoTileGenerator::RasterizeTriangleSAT(const FTileGenerationData& Tile, const FVector& V0, const FVector& V1, const FVector& V2, FNavSvoVoxelBuffer& Voxels) const
+{
+	using namespace NavSvoRasterizer;
+
+	// Clip the triangle's bounds to the voxels we're allowed to fill
+	const FVector TriMin = V0.ComponentMin(V1).ComponentMin(V2);
+	const FVector TriMax = V0.ComponentMax(V1).ComponentMax(V2);
+
+	const FIntVector TriVoxelMin = FSvoUtils::CoordToFixed(TriMin);
+	const FIntVector TriVoxelMax = FSvoUtils::CoordToFixed(TriMax);
+
+	const FIntVector VoxelMin(
+		FMath::Max(TriVoxelMin.X, Tile.FillBounds.Min.X),
+		FMath::Max(TriVoxelMin.Y, Tile.FillBounds.Min.Y),
+		FMath::Max(TriVoxelMin.Z, Tile.FillBounds.Min.Z));
+	const FIntVector VoxelMax(
+		FMath::Min(TriVoxelMax.X, Tile.FillBounds.Max.X),
+		FMath::Min(TriVoxelMax.Y, Tile.FillBounds.Max.Y),
+		FMath::Min(TriVoxelMax.Z, Tile.FillBounds.Max.Z));
+
+	if (VoxelMin.X > VoxelMax.X || VoxelMin.Y > VoxelMax.Y || VoxelMin.Z > VoxelMax.Z)
+	{
+		return false;
+	}
+
+	const FTriangleAxes Axes{ FVector3f(V0), FVector3f(V1), FVector3f(V2) };
+
+	const FIntVector LeafMin(VoxelMin.X >> 2, VoxelMin.Y >> 2, VoxelMin.Z >> 2);
+	const FIntVector LeafMax(VoxelMax.X >> 2, VoxelMax.Y >> 2, VoxelMax.Z >> 2);
+
+	constexpr float LeafHalfSize = (SVO_VOXEL_GRID_EXTENT - BoxEpsilon) * 0.5f;
+	constexpr float VoxelHalfSize = (1.f - BoxEpsilon) * 0.5f;
+	const VectorRegister4Float LaneOffsets = MakeVectorRegisterFloat(0.f, 1.f, 2.f, 3.f);
+	const VectorRegister4Float LeafLaneOffsets = VectorMultiply(LaneOffsets, VectorSetFloat1((float)SVO_VOXEL_GRID_EXTENT));
+
+	bool DidSetVoxel = false;
+
+	for (int32 LeafZ = LeafMin.Z; LeafZ <= LeafMax.Z; ++LeafZ)
+	{
+		for (int32 LeafY = LeafMin.Y; LeafY <= LeafMax.Y; ++LeafY)
+		{
+			for (int32 LeafStartX = LeafMin.X; LeafStartX <= LeafMax.X; LeafStartX += 4)
+			{
+				// Find which of the next four leaves the triangle touches at all
+				const VectorRegister4Float LeafCenterX = VectorAdd(VectorSetFloat1(LeafStartX * SVO_VOXEL_GRID_EXTENT + LeafHalfSize), LeafLaneOffsets);
+				uint32 LeafOverlaps = Axes.TestRow(LeafCenterX, LeafY * SVO_VOXEL_GRID_EXTENT + LeafHalfSize, LeafZ * SVO_VOXEL_GRID_EXTENT + LeafHalfSize, LeafHalfSize);
+				LeafOverlaps &= GetRowMask(LeafStartX, LeafMin.X, LeafMax.X);
+
+				while (LeafOverlaps != 0)
+				{
+					const int32 LaneIdx = FMath::CountTrailingZeros(LeafOverlaps);
+					LeafOverlaps &= LeafOverlaps - 1;
+
+					const FIntVector LeafCoord(LeafStartX + LaneIdx, LeafY, LeafZ);
+					const FIntVector LeafVoxel = LeafCoord * SVO_VOXEL_GRID_EXTENT;
+
+					const VectorRegister4Float VoxelCenterX = VectorAdd(VectorSetFloat1(LeafVoxel.X + VoxelHalfSize), LaneOffsets);
+					const uint32 ValidX = GetRowMask(LeafVoxel.X, VoxelMin.X, VoxelMax.X);
+
+					// Build up the voxels for the whole leaf, one row at a time
+					uint64 LeafVoxels = 0;
+
+					const int32 MinZ = FMath::Max(VoxelMin.Z - LeafVoxel.Z, 0);
+					const int32 MaxZ = FMath::Min(VoxelMax.Z - LeafVoxel.Z, SVO_VOXEL_GRID_EXTENT - 1);
+					const int32 MinY = FMath::Max(VoxelMin.Y - LeafVoxel.Y, 0);
+					const int32 MaxY = FMath::Min(VoxelMax.Y - LeafVoxel.Y, SVO_VOXEL_GRID_EXTENT - 1);
+
+					for (int32 Z = MinZ; Z <= MaxZ; ++Z)
+					{
+						for (int32 Y = MinY; Y <= MaxY; ++Y)
+						{
+							const uint32 RowOverlaps = Axes.TestRow(VoxelCenterX, LeafVoxel.Y + Y + VoxelHalfSize, LeafVoxel.Z + Z + VoxelHalfSize, VoxelHalfSize) & ValidX;
+							if (RowOverlaps != 0)
+							{
+								// Morton offset of the first voxel in the row
+								const uint32 RowShift = ((Y & 1) << 1) | ((Y & 2) << 3) | ((Z & 1) << 2) | ((Z & 2) << 4);
+								LeafVoxels |= RowMortonBits[RowOverlaps] << RowShift;
+							}
+						}
+					}
+
+					if (LeafVoxels != 0)
+					{
+						Voxels.AddLeafVoxels(FSvoUtils::CoordToMorton(LeafCoord), LeafVoxels);
+						DidSetVoxel = true;
+					}
+				}
+			}
+		}
+	}
+
+	return DidSetVoxel;
+}
+
+bool FNavSvoTileGenerator::FillBlockers(const FTileGenerationData& Tile, const FVector& TileMin, FNavSvoVoxelBuffer& Voxels) const
+{
+	const double VoxelSize = Config.GetVoxelSize();
+
+	const auto ToVoxelSpace = [&TileMin, &VoxelSize](const FVector& Pos) -> FVector
+	{
+		return (Pos - TileMin) / VoxelSize;
+	};
+
+	FConvexVolume ConvexVol;
+
+	const FBox VoxelBounds(FVector::ZeroVector, ToVoxelSpace(Tile.GatherBounds.Max));
 
 	bool FilledVoxel = false;
 
@@ -661,7 +1362,7 @@ bool FNavSvoTileGenerator::FillBlockers(const FTileGenerationData& Tile, const F
 			{
 				if (Tile.FillBounds.IsInsideOrOn(VoxelCoord))
 				{
-					Voxels[CurCode] = true;
+					Voxels.SetVoxel(CurCode);
 					FilledVoxel = true;
 				}
 			}
@@ -671,81 +1372,148 @@ bool FNavSvoTileGenerator::FillBlockers(const FTileGenerationData& Tile, const F
 	return FilledVoxel;
 }
 
-void FNavSvoTileGenerator::BuildPaddingOffsetCodes()
+namespace NavSvoPadding
 {
-	const uint32 PaddingXY = Config.AgentRadius;
-	const uint32 PaddingZ = Config.AgentHalfHeight;
-	const uint32 MaxPadExtent = FMath::Max(PaddingXY, PaddingZ);
+	// Shifts for moving every voxel in a leaf one voxel along an axis. Within a leaf the
+	// two bits of a voxel's coordinate on an axis are interleaved at (1 << Axis) and
+	// (8 << Axis) in its Morton code, so each coordinate moves by a different amount.
+	struct FAxisShifts
+	{
+		// Voxels of the leaf at each coordinate (0-3) along the axis
+		uint64 CoordMasks[SVO_VOXEL_GRID_EXTENT];
 
-	TArray<FIntVector> Offsets;
+		uint32 Bit0;
+		uint32 Bit1;
 
-	// Seed our offsets with the origin
-	Offsets.Add(FIntVector(0));
+		// Bits of the axis in a leaf's Morton code
+		uint32 LeafAxisMask;
 
-	// Brute force all the padding offsets
-	for (uint32 CurPadding = 0; CurPadding < MaxPadExtent; ++CurPadding)
-	{
-		int32 StartNumOffsets = Offsets.Num();
-
-		for (int32 j = 0; j < StartNumOffsets; ++j)
+		FAxisShifts(int32 Axis, uint32 InLeafAxisMask)
+			: Bit0(1u << Axis)
+			, Bit1(8u << Axis)
+			, LeafAxisMask(InLeafAxisMask)
 		{
-			if (CurPadding < PaddingXY)
+			for (uint64& CoordMask : CoordMasks)
 			{
-				Offsets.AddUnique(Offsets[j] + FIntVector(1, 0, 0));
-				Offsets.AddUnique(Offsets[j] - FIntVector(1, 0, 0));
-				Offsets.AddUnique(Offsets[j] + FIntVector(0, 1, 0));
-				Offsets.AddUnique(Offsets[j] - FIntVector(0, 1, 0));
+				CoordMask = 0;
 			}
 
-			if (CurPadding < PaddingZ)
+			for (uint32 VoxelIdx = 0; VoxelIdx < SVO_VOXELS_PER_LEAF; ++VoxelIdx)
 			{
-				Offsets.AddUnique(Offsets[j] + FIntVector(0, 0, 1));
-				Offsets.AddUnique(Offsets[j] - FIntVector(0, 0, 1));
+				const uint32 Coord = ((VoxelIdx & Bit0) ? 1 : 0) | ((VoxelIdx & Bit1) ? 2 : 0);
+				CoordMasks[Coord] |= (1ull << VoxelIdx);
 			}
 		}
-	}
 
-	// Remove the origin now that we've generated the offsets
-	Offsets.RemoveAtSwap(0);
+		// Moves the voxels one step in the positive direction, returning the voxels that
+		// stay in the leaf and filling 'OutSpill' with the ones that move into the next.
+		FORCEINLINE uint64 ShiftPositive(uint64 Voxels, uint64& OutSpill) const
+		{
+			OutSpill = (Voxels & CoordMasks[3]) >> (Bit0 + Bit1);
+			return ((Voxels & CoordMasks[0]) << Bit0) | ((Voxels & CoordMasks[1]) << (Bit1 - Bit0)) | ((Voxels & CoordMasks[2]) << Bit0);
+		}
 
-	PaddingOffsetCodes.Reserve(Offsets.Num());
+		FORCEINLINE uint64 ShiftNegative(uint64 Voxels, uint64& OutSpill) const
+		{
+			OutSpill = (Voxels & CoordMasks[0]) << (Bit0 + Bit1);
+			return ((Voxels & CoordMasks[1]) >> Bit0) | ((Voxels & CoordMasks[2]) >> (Bit1 - Bit0)) | ((Voxels & CoordMasks[3]) >> Bit0);
+		}
+	};
 
-	for (const FIntVector& Offset : Offsets)
+	const FAxisShifts AxisShifts[3] =
 	{
-		PaddingOffsetCodes.Add(FSvoUtils::CalculateMortonOffset(Offset));
-	}
+		FAxisShifts(0, MORTON_X_MASK),
+		FAxisShifts(1, MORTON_Y_MASK),
+		FAxisShifts(2, MORTON_Z_MASK),
+	};
 
-	PaddingOffsetCodes.Sort();
+	const ESvoNeighbor PositiveNeighbors[3] = { ESvoNeighbor::Front, ESvoNeighbor::Right, ESvoNeighbor::Top };
+	const ESvoNeighbor NegativeNeighbors[3] = { ESvoNeighbor::Back, ESvoNeighbor::Left, ESvoNeighbor::Bottom };
 }
 
-void FNavSvoTileGenerator::PadVoxels(const FTileGenerationData& Tile, const TBitArray<>& Voxels, TBitArray<>& PaddedVoxels) const
+void FNavSvoTileGenerator::PadVoxels(const FTileGenerationData& Tile, const FNavSvoVoxelBuffer& Voxels, FNavSvoVoxelBuffer& PaddedVoxels, FNavSvoGenerationArena& Arena) const
 {
+	using namespace NavSvoPadding;
+
 #if PROFILE_SVO_GENERATION
 	const uint64 StartCycle = FPlatformTime::Cycles64();
 #endif
 
-	// Walk through every leaf in our padded range and for each voxel in the leaf, set
-	// every voxel in our input array, and set all the padding voxels. Since we're setting
-	// the values on a different array we don't have to worry about over-padding by
-	// thinking a padding voxel is a collision voxel. Since we're doing this in Morton
-	// order it should be relatively cache efficient.
+	const uint32 NumLeafNodes = Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis * Config.NumLeafNodesPerAxis;
+	const uint32 MaxLeafCode = FSvoUtils::CoordToMorton(FIntVector(Config.NumLeafNodesPerAxis - 1));
+
+	check(Voxels.GetNumLeaves() == NumLeafNodes);
+	check(PaddedVoxels.GetNumLeaves() == NumLeafNodes);
+
+	// Work on a whole leaf (4x4x4 voxels) at a time. Only the voxels inside our padded
+	// range are padded out, same as they'd be generated.
+	TArray<uint64>* CurLeaves = &Arena.PadLeaves[0];
+	TArray<uint64>* NextLeaves = &Arena.PadLeaves[1];
+
+	CurLeaves->SetNumUninitialized(NumLeafNodes, false);
+	FMemory::Memzero(CurLeaves->GetData(), NumLeafNodes * sizeof(uint64));
+
 	for (const uint32 LeafCode : FMortonIterator(Config.MinPaddedLeafCode, Config.MaxPaddedLeafCode))
 	{
-		const uint32 FirstVoxel = LeafCode << 6;
-		const uint32 LastVoxel = FirstVoxel + SVO_VOXELS_PER_LEAF;
+		(*CurLeaves)[LeafCode] = Voxels.GetLeaf(LeafCode);
+	}
+
+	// The padding is the set of voxels an agent can reach by moving up to AgentRadius
+	// voxels horizontally and AgentHalfHeight voxels vertically, one voxel per step. We
+	// build it by dilating all the voxels by one step along each axis that still has
+	// padding left, so each pass costs the same no matter what the agent size is, and
+	// processes 64 voxels at once.
+	const uint32 PaddingXY = Config.AgentRadius;
+	const uint32 PaddingZ = Config.AgentHalfHeight;
+	const uint32 MaxPadExtent = FMath::Max(PaddingXY, PaddingZ);
+
+	for (uint32 CurPadding = 0; CurPadding < MaxPadExtent; ++CurPadding)
+	{
+		const int32 FirstAxis = (CurPadding < PaddingXY) ? 0 : 2;
+		const int32 LastAxis = (CurPadding < PaddingZ) ? 2 : 1;
 
-		for (uint32 VoxelCode = FirstVoxel; VoxelCode < LastVoxel; ++VoxelCode)
+		*NextLeaves = *CurLeaves;
+
+		for (uint32 LeafCode = 0; LeafCode < NumLeafNodes; ++LeafCode)
 		{
-			if (Voxels[VoxelCode])
+			const uint64 LeafVoxels = (*CurLeaves)[LeafCode];
+			if (LeafVoxels == 0)
+			{
+				continue;
+			}
+
+			uint64 Dilated = 0;
+
+			for (int32 Axis = FirstAxis; Axis <= LastAxis; ++Axis)
 			{
-				PaddedVoxels[VoxelCode] = true;
+				const FAxisShifts& Shifts = AxisShifts[Axis];
+				const uint32 LeafAxis = (LeafCode & Shifts.LeafAxisMask);
 
-				for (const uint32 OffsetCode : PaddingOffsetCodes)
+				uint64 Spill;
+				Dilated |= Shifts.ShiftPositive(LeafVoxels, Spill);
+				if (Spill != 0 && LeafAxis != (MaxLeafCode & Shifts.LeafAxisMask))
 				{
-					const uint32 VoxelNeighbor = FSvoUtils::OffsetMorton(VoxelCode, OffsetCode);
-					PaddedVoxels[VoxelNeighbor] = true;
+					(*NextLeaves)[FSvoUtils::MortonNeighbor(LeafCode, PositiveNeighbors[Axis])] |= Spill;
+				}
+
+				Dilated |= Shifts.ShiftNegative(LeafVoxels, Spill);
+				if (Spill != 0 && LeafAxis != 0)
+				{
+					(*NextLeaves)[FSvoUtils::MortonNeighbor(LeafCode, NegativeNeighbors[Axis])] |= Spill;
 				}
 			}
+
+			(*NextLeaves)[LeafCode] |= Dilated;
+		}
+
+		Swap(CurLeaves, NextLeaves);
+	}
+
+	for (uint32 LeafCode = 0; LeafCode < NumLeafNodes; ++LeafCode)
+	{
+		if ((*CurLeaves)[LeafCode] != 0)
+		{
+			PaddedVoxels.SetLeaf(LeafCode, (*CurLeaves)[LeafCode]);
 		}
 	}
 
@@ -754,7 +1522,269 @@ void FNavSvoTileGenerator::PadVoxels(const FTileGenerationData& Tile, const TBit
 #endif
 }
 
-void FNavSvoTileGenerator::CreateTileFromVoxels(const FTileGenerationData& Tile, const TBitArray<>& Voxels, FSvoTile& TileOut) const
+namespace NavSvoLeafVoxels
+{
+	// Maps the Morton index of a voxel within a leaf to the linear index leaf nodes store
+	// their voxels in.
+	struct FMortonToLinearLUT
+	{
+		uint8 Indices[SVO_VOXELS_PER_LEAF];
+
+		FMortonToLinearLUT()
+		{
+			for (uint32 VoxelCode = 0; VoxelCode < SVO_VOXELS_PER_LEAF; ++VoxelCode)
+			{
+				Indices[VoxelCode] = FSvoUtils::GetVoxelIndexForCoord(FSvoUtils::MortonToCoord(VoxelCode));
+			}
+		}
+	};
+
+	const FMortonToLinearLUT& GetMortonToLinearLUT()
+	{
+		static const FMortonToLinearLUT LUT;
+		return LUT;
+	}
+}
+
+#if WITH_EDITOR
+namespace NavSvoGPUVoxels
+{
+	// The GPU works on voxels in linear order, so convert the voxels in a leaf between
+	// the two orders.
+	uint64 MortonToLinear(uint64 LeafVoxels)
+	{
+		const NavSvoLeafVoxels::FMortonToLinearLUT& LUT = NavSvoLeafVoxels::GetMortonToLinearLUT();
+
+		uint64 Result = 0;
+		while (LeafVoxels != 0)
+		{
+			Result |= (1ull << LUT.Indices[FMath::CountTrailingZeros64(LeafVoxels)]);
+			LeafVoxels &= LeafVoxels - 1;
+		}
+
+		return Result;
+	}
+
+	uint64 LinearToMorton(uint64 LeafVoxels)
+	{
+		uint64 Result = 0;
+		while (LeafVoxels != 0)
+		{
+			const uint32 VoxelIdx = (uint32)FMath::CountTrailingZeros64(LeafVoxels);
+			Result |= (1ull << FSvoUtils::CoordToMorton(FIntVector(VoxelIdx & 3, (VoxelIdx >> 2) & 3, VoxelIdx >> 4)));
+			LeafVoxels &= LeafVoxels - 1;
+		}
+
+		return Result;
+	}
+}
+
+bool FNavSvoTileGenerator::VoxelizeOnGPU(FTileGenerationData& Tile, FNavSvoGenerationArena& Arena, bool& bOutFilledVoxel) const
+{
+	using namespace NavSvoGPUVoxels;
+
+	if (!FNavSvoGPUVoxelizer::IsSupported())
+	{
+		return false;
+	}
+
+	GatherTileGeometry(Tile);
+
+	const int32 NumLeavesPerAxis = Config.NumLeafNodesPerAxis;
+	const uint32 NumLeafNodes = NumLeavesPerAxis * NumLeavesPerAxis * NumLeavesPerAxis;
+
+	const FVector PaddingOffset(Config.NumPaddingLeafNodesPerAxis * Config.GetLeafResolution() * 0.5);
+	const FVector TileMin(Tile.TileMin - PaddingOffset);
+	const float VoxelSize = Config.GetVoxelSize();
+
+	// Blockers are rare and cheap, so they're still filled on the CPU and uploaded as the
+	// starting voxels.
+	const bool bFilledBlockers = (Tile.CollisionInterface.Blockers.Num() > 0) && FillBlockers(Tile, TileMin, Arena.Voxels);
+
+	FNavSvoGPUVoxelizeParams Params;
+	Params.NumLeavesPerAxis = NumLeavesPerAxis;
+	Params.FillMin = Tile.FillBounds.Min;
+	Params.FillMax = Tile.FillBounds.Max;
+	Params.PadLeafMin = FSvoUtils::MortonToCoord(Config.MinPaddedLeafCode);
+	Params.PadLeafMax = FSvoUtils::MortonToCoord(Config.MaxPaddedLeafCode);
+	Params.PaddingXY = Config.AgentRadius;
+	Params.PaddingZ = Config.AgentHalfHeight;
+
+	Params.Vertices.Reserve(Tile.CollisionInterface.GetNumTriangles() * 3);
+	Tile.CollisionInterface.ForEachTriangle([&Params, &TileMin, VoxelSize](const FNavigationOctreeCollider::FTriangle& Tri)
+	{
+		for (const FVector& Vertex : Tri.Vertices)
+		{
+			Params.Vertices.Emplace((Vertex - TileMin) / VoxelSize);
+		}
+	});
+
+	if (Params.Vertices.Num() == 0 && !bFilledBlockers)
+	{
+		bOutFilledVoxel = false;
+		return true;
+	}
+
+	if (bFilledBlockers)
+	{
+		Params.BaseVoxels.SetNumZeroed(NumLeafNodes);
+
+		for (uint32 LeafCode = Arena.Voxels.GetDirtyBegin(); LeafCode < Arena.Voxels.GetDirtyEnd(); ++LeafCode)
+		{
+			if (const uint64 LeafVoxels = Arena.Voxels.GetLeaf(LeafCode))
+			{
+				const FIntVector LeafCoord = FSvoUtils::MortonToCoord(LeafCode);
+				Params.BaseVoxels[LeafCoord.X + (LeafCoord.Y + LeafCoord.Z * NumLeavesPerAxis) * NumLeavesPerAxis] = MortonToLinear(LeafVoxels);
+			}
+		}
+	}
+
+	TArray<uint64> GPUVoxels;
+	TArray<uint64> GPUPaddedVoxels;
+
+	if (!FNavSvoGPUVoxelizer::Voxelize(Params, GPUVoxels, GPUPaddedVoxels))
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("Failed to voxelize tile (%d, %d, %d) on the GPU, falling back to the CPU."), Tile.TileCoord.X, Tile.TileCoord.Y, Tile.TileCoord.Z);
+
+		Arena.Voxels.Reset(NumLeafNodes);
+		return false;
+	}
+
+	for (uint32 LeafIdx = 0; LeafIdx < NumLeafNodes; ++LeafIdx)
+	{
+		if (GPUVoxels[LeafIdx] == 0 && GPUPaddedVoxels[LeafIdx] == 0)
+		{
+			continue;
+		}
+
+		const FIntVector LeafCoord(LeafIdx % NumLeavesPerAxis, (LeafIdx / NumLeavesPerAxis) % NumLeavesPerAxis, LeafIdx / (NumLeavesPerAxis * NumLeavesPerAxis));
+		const uint32 LeafCode = FSvoUtils::CoordToMorton(LeafCoord);
+
+		if (GPUVoxels[LeafIdx] != 0)
+		{
+			Arena.Voxels.SetLeaf(LeafCode, LinearToMorton(GPUVoxels[LeafIdx]));
+		}
+
+		if (GPUPaddedVoxels[LeafIdx] != 0)
+		{
+			Arena.PaddedVoxels.SetLeaf(LeafCode, LinearToMorton(GPUPaddedVoxels[LeafIdx]));
+		}
+	}
+
+	bOutFilledVoxel = !Arena.Voxels.IsEmpty();
+	return true;
+}
+#endif
+
+bool FNavSvoTileGenerator::InitPartialRebuild(const FSvoTile& ExistingTile, const FBox& TileBounds, const FBox& DirtyBounds, FTileGenerationData& Tile) const
+{
+	// Clearance is measured across the whole tile, so it can't be patched. Neither can
+	// areas, since only the modifiers around the dirty leaves would be gathered.
+	const float MaxFraction = CVarNavSvoMaxPartialRebuildFraction.GetValueOnGameThread();
+	if (MaxFraction <= 0.0f || Config.MaxClearance > 0 || ExistingTile.HasClearance() || ExistingTile.HasAreas())
+	{
+		return false;
+	}
+
+	const FBox ClippedBounds = DirtyBounds.Overlap(TileBounds);
+	if (!ClippedBounds.IsValid)
+	{
+		return false;
+	}
+
+	const int32 NumTileLeavesPerAxis = int32(Config.NumLeafNodesPerAxis - Config.NumPaddingLeafNodesPerAxis);
+	const FIntVector MaxLeafCoord(NumTileLeavesPerAxis - 1);
+
+	FIntBox DirtyLeaves;
+	DirtyLeaves.Min = FSvoUtils::LocationToCoord(TileBounds.Min, ClippedBounds.Min, Config.GetLeafResolution());
+	DirtyLeaves.Max = FSvoUtils::LocationToCoord(TileBounds.Min, ClippedBounds.Max, Config.GetLeafResolution());
+	DirtyLeaves.Min = FIntVector(FMath::Clamp(DirtyLeaves.Min.X, 0, MaxLeafCoord.X), FMath::Clamp(DirtyLeaves.Min.Y, 0, MaxLeafCoord.Y), FMath::Clamp(DirtyLeaves.Min.Z, 0, MaxLeafCoord.Z));
+	DirtyLeaves.Max = FIntVector(FMath::Clamp(DirtyLeaves.Max.X, 0, MaxLeafCoord.X), FMath::Clamp(DirtyLeaves.Max.Y, 0, MaxLeafCoord.Y), FMath::Clamp(DirtyLeaves.Max.Z, 0, MaxLeafCoord.Z));
+
+	const FIntVector DirtySize = DirtyLeaves.Max - DirtyLeaves.Min + FIntVector(1);
+	const uint32 NumTileLeaves = uint32(NumTileLeavesPerAxis * NumTileLeavesPerAxis * NumTileLeavesPerAxis);
+	const uint32 NumDirtyLeaves = uint32(DirtySize.X * DirtySize.Y * DirtySize.Z);
+
+	if (NumDirtyLeaves > NumTileLeaves * MaxFraction)
+	{
+		return false;
+	}
+
+	// Copy out the voxels of every leaf of the existing tile. Leaves that were collapsed
+	// take the state of the first ancestor that's still around.
+	const NavSvoLeafVoxels::FMortonToLinearLUT& MortonToLinear = NavSvoLeafVoxels::GetMortonToLinearLUT();
+	const FSvoNode& TileNode = ExistingTile.GetNodeInfo();
+	const uint8 TileLayerIdx = TileNode.GetSelfLink().LayerIdx;
+
+	Tile.BaseLeaves.SetNumUninitialized(NumTileLeaves);
+
+	for (uint32 LeafCode = 0; LeafCode < NumTileLeaves; ++LeafCode)
+	{
+		ENodeState State = TileNode.GetNodeState();
+
+		if (State == ENodeState::PartiallyBlocked)
+		{
+			for (uint8 LayerIdx = SVO_LEAF_LAYER; LayerIdx < TileLayerIdx; ++LayerIdx)
+			{
+				if (const FSvoNode* Node = ExistingTile.GetNode(LayerIdx, LeafCode >> (LayerIdx * 3)))
+				{
+					State = Node->GetNodeState();
+
+					if (LayerIdx == SVO_LEAF_LAYER && State == ENodeState::PartiallyBlocked)
+					{
+						uint64 LeafVoxels = 0;
+						for (uint32 VoxelCode = 0; VoxelCode < SVO_VOXELS_PER_LEAF; ++VoxelCode)
+						{
+							if (Node->IsVoxelBlocked(MortonToLinear.Indices[VoxelCode]))
+							{
+								LeafVoxels |= 1ull << VoxelCode;
+							}
+						}
+
+						Tile.BaseLeaves[LeafCode] = LeafVoxels;
+					}
+
+					break;
+				}
+			}
+		}
+
+		if (State != ENodeState::PartiallyBlocked)
+		{
+			Tile.BaseLeaves[LeafCode] = (State == ENodeState::Blocked) ? ~0ull : 0ull;
+		}
+	}
+
+	Tile.bPartialRebuild = true;
+	Tile.DirtyLeaves = DirtyLeaves;
+
+	return true;
+}
+
+void FNavSvoTileGenerator::CopyBaseLeaves(const FTileGenerationData& Tile, FNavSvoVoxelBuffer& PaddedVoxels) const
+{
+	const uint32 LeafOffsetCode = FSvoUtils::CalculateMortonOffset(FIntVector(int32(Config.NumPaddingLeafNodesPerAxis / 2)));
+
+	for (uint32 LeafCode = 0; LeafCode < (uint32)Tile.BaseLeaves.Num(); ++LeafCode)
+	{
+		if (Tile.DirtyLeaves.IsInsideOrOn(FSvoUtils::MortonToCoord(LeafCode)))
+		{
+			continue;
+		}
+
+		// Anything the padding spilled outside the dirty leaves is replaced too, since
+		// the dirty bounds already include the padding of whatever changed.
+		const uint32 PaddedLeafCode = FSvoUtils::OffsetMorton(LeafCode, LeafOffsetCode);
+		const uint64 BaseLeaf = Tile.BaseLeaves[LeafCode];
+
+		if (BaseLeaf != 0 || PaddedVoxels.GetLeaf(PaddedLeafCode) != 0)
+		{
+			PaddedVoxels.SetLeaf(PaddedLeafCode, BaseLeaf);
+		}
+	}
+}
+
+void FNavSvoTileGenerator::CreateTileFromVoxels(const FTileGenerationData& Tile, const FNavSvoVoxelBuffer& Voxels, FSvoTile& TileOut, FNavSvoGenerationArena& Arena) const
 {
 	LLM_SCOPE_BYTAG(Gunfire3DNavData)
 
@@ -766,84 +1796,185 @@ void FNavSvoTileGenerator::CreateTileFromVoxels(const FTileGenerationData& Tile,
 	const uint32 VoxelOffsetCode = FSvoUtils::CalculateMortonOffset(FIntVector(int32(Config.NumPaddingLeafNodesPerAxis / 2) * -SVO_VOXEL_GRID_EXTENT));
 
 	const uint32 TileID = TileOut.GetID();
-	TileOut.AllocateNodes(Config.GetNumNodesPerTile(), Config.GetTileLayerIndex());
+	const int32 NumLayers = Config.GetTileLayerIndex();
+	const uint32 NumLeaves = 1u << (3 * NumLayers);
 
-	TArrayView<FSvoNode> Leaves(TileOut.GetNode(SVO_LEAF_LAYER, 0, false), TileOut.GetMaxNodes(SVO_LEAF_LAYER));
+	// Rather than allocating every node the tile could have and collapsing them after,
+	// we work out which nodes will be left from the voxels first and only allocate
+	// those. Start by grabbing the voxels of each leaf (in Morton order), clipped to the
+	// navigation bounds.
+	TArray<uint64>& TileLeaves = Arena.TileLeaves;
+	TileLeaves.SetNumUninitialized(NumLeaves, false);
 
-	FSvoTile::FSvoLayer& LeafLayer = TileOut.Layers[SVO_LEAF_LAYER];
-
-	// Iterate through our destination leaf nodes and fill them in from our padded data
-	for (uint32 LeafCode = 0; LeafCode < (uint32)Leaves.Num(); ++LeafCode)
+	for (uint32 LeafCode = 0; LeafCode < NumLeaves; ++LeafCode)
 	{
-		FSvoNode& Leaf = Leaves[LeafCode];
-
-		Leaf.Init(FSvoNodeLink(TileID, SVO_LEAF_LAYER, LeafCode), false);
-		++LeafLayer.NumNodes;
-
 		// Offset the Morton code for the leaf we're interested in so the unpadded coord
 		// we're building references the correct leaf in the padded data we're reading from.
 		const uint32 PaddedLeafCode = FSvoUtils::OffsetMorton(LeafCode, LeafOffsetCode);
 
-		const uint32 FirstVoxelCode = PaddedLeafCode << 6;
-		const uint32 LastVoxelCode = FirstVoxelCode + SVO_VOXELS_PER_LEAF;
+		uint64 LeafVoxels = Voxels.GetLeaf(PaddedLeafCode);
+		TileLeaves[LeafCode] = LeafVoxels;
 
-		for (TBitArray<>::FConstIterator It(Voxels, FirstVoxelCode); It && uint32(It.GetIndex()) < LastVoxelCode; ++It)
+		if (LeafVoxels == 0)
 		{
-			if (It.GetValue())
+			continue;
+		}
+
+		// If the whole leaf is inside the navigation bounds we can skip checking each
+		// voxel, which is almost always the case.
+		const FIntVector LeafMinCoord = FSvoUtils::MortonToCoord(FSvoUtils::OffsetMorton(PaddedLeafCode << 6, VoxelOffsetCode));
+		const FIntVector LeafMaxCoord = LeafMinCoord + FIntVector(SVO_VOXEL_GRID_EXTENT - 1);
+
+		const bool LeafInBounds = Tile.VoxelBounds.ContainsByPredicate(
+			[&LeafMinCoord, &LeafMaxCoord](const FIntBox& Bounds)
 			{
-				const uint32 CurrentVoxelCode = It.GetIndex();
+				return Bounds.IsInsideOrOn(LeafMinCoord) && Bounds.IsInsideOrOn(LeafMaxCoord);
+			});
 
-				const uint32 UnpaddedVoxelCode = FSvoUtils::OffsetMorton(CurrentVoxelCode, VoxelOffsetCode);
-				const FIntVector VoxelCoord = FSvoUtils::MortonToCoord(UnpaddedVoxelCode);
+		if (LeafInBounds)
+		{
+			continue;
+		}
 
-				const bool InBounds = Tile.VoxelBounds.ContainsByPredicate(
-					[&VoxelCoord](const FIntBox& Bounds)
-					{
-						return Bounds.IsInsideOrOn(VoxelCoord);
-					});
+		while (LeafVoxels != 0)
+		{
+			const uint32 VoxelCode = (uint32)FMath::CountTrailingZeros64(LeafVoxels);
+			LeafVoxels &= LeafVoxels - 1;
 
-				if (!InBounds)
-				{
-					continue;
-				}
+			const FIntVector VoxelCoord = LeafMinCoord + FSvoUtils::MortonToCoord(VoxelCode);
 
-				// TEMP - convert Morton back to linear. If we rework the voxel bits so
-				// they're stored in Morton order we can just do something like this:
-				// Voxels.GetRange(FirstVoxel, SVO_VOXELS_PER_LEAF, Leaves[Code].Voxels)
-				uint32 VoxelCode = CurrentVoxelCode & 0x3f;
-				FIntVector VoxelLoc = FSvoUtils::MortonToCoord(VoxelCode);
-				uint32 VoxelIndex = FSvoUtils::GetVoxelIndexForCoord(VoxelLoc);
+			const bool InBounds = Tile.VoxelBounds.ContainsByPredicate(
+				[&VoxelCoord](const FIntBox& Bounds)
+				{
+					return Bounds.IsInsideOrOn(VoxelCoord);
+				});
 
-				Leaf.SetVoxelBlocked(VoxelIndex);
+			if (!InBounds)
+			{
+				TileLeaves[LeafCode] &= ~(1ull << VoxelCode);
 			}
 		}
 	}
 
-#if PROFILE_SVO_GENERATION
-	const uint64 FillCycle = FPlatformTime::Cycles64();
-#endif
+	// Work out the state of every node from the bottom up. A node whose children are all
+	// open (or all blocked) collapses into an open (or blocked) node.
+	TArray<ENodeState>& NodeStates = Arena.NodeStates;
+	TArray<uint32, TInlineAllocator<SVO_MAX_LAYERS>> LayerStartIdx;
+
+	uint32 NumNodeStates = 0;
+	for (int32 LayerIdx = 0; LayerIdx < NumLayers; ++LayerIdx)
+	{
+		LayerStartIdx.Add(NumNodeStates);
+		NumNodeStates += NumLeaves >> (3 * LayerIdx);
+	}
+
+	NodeStates.SetNumUninitialized(NumNodeStates, false);
+
+	for (uint32 LeafCode = 0; LeafCode < NumLeaves; ++LeafCode)
+	{
+		const uint64 LeafVoxels = TileLeaves[LeafCode];
+		NodeStates[LeafCode] = (LeafVoxels == 0) ? ENodeState::Open : (LeafVoxels == MAX_uint64) ? ENodeState::Blocked : ENodeState::PartiallyBlocked;
+	}
+
+	const auto CollapseChildren = [&NodeStates](uint32 FirstChildIdx) -> ENodeState
+	{
+		const ENodeState FirstState = NodeStates[FirstChildIdx];
+		if (FirstState == ENodeState::PartiallyBlocked)
+		{
+			return ENodeState::PartiallyBlocked;
+		}
+
+		for (uint32 ChildIdx = 1; ChildIdx < 8; ++ChildIdx)
+		{
+			if (NodeStates[FirstChildIdx + ChildIdx] != FirstState)
+			{
+				return ENodeState::PartiallyBlocked;
+			}
+		}
 
-	if (LeafLayer.NumNodes > 0)
+		return FirstState;
+	};
+
+	for (int32 LayerIdx = 1; LayerIdx < NumLayers; ++LayerIdx)
 	{
-		TileOut.GetNodeInfo().SetNodeState(ENodeState::PartiallyBlocked);
+		const uint32 NumLayerNodes = NumLeaves >> (3 * LayerIdx);
+
+		for (uint32 NodeIdx = 0; NodeIdx < NumLayerNodes; ++NodeIdx)
+		{
+			NodeStates[LayerStartIdx[LayerIdx] + NodeIdx] = CollapseChildren(LayerStartIdx[LayerIdx - 1] + NodeIdx * 8);
+		}
 	}
 
-	// Now that we've filled in the voxel data for all the leaf nodes, mark which ones are used
-	for (const FSvoNode& Leaf : Leaves)
+	const ENodeState TileState = CollapseChildren(LayerStartIdx[NumLayers - 1]);
+	TileOut.GetNodeInfo().SetNodeState(TileState);
+
+	if (TileState == ENodeState::PartiallyBlocked)
 	{
-		for (int32 l = 1; l < Config.GetTileLayerIndex(); ++l)
+		// A node only exists if its parent is partially blocked. Nodes are addressed by
+		// their Morton code, so each layer needs to be allocated up to the children of
+		// its last partially blocked parent.
+		TArray<uint32, TInlineAllocator<SVO_MAX_LAYERS>> LayerMaxNodes;
+		LayerMaxNodes.SetNumZeroed(NumLayers);
+		LayerMaxNodes[NumLayers - 1] = 8;
+
+		for (int32 LayerIdx = NumLayers - 1; LayerIdx > 0; --LayerIdx)
+		{
+			for (int32 NodeIdx = (int32)LayerMaxNodes[LayerIdx] - 1; NodeIdx >= 0; --NodeIdx)
+			{
+				if (NodeStates[LayerStartIdx[LayerIdx] + NodeIdx] == ENodeState::PartiallyBlocked)
+				{
+					LayerMaxNodes[LayerIdx - 1] = (NodeIdx + 1) * 8;
+					break;
+				}
+			}
+		}
+
+		TileOut.AllocateNodes(LayerMaxNodes);
+
+		const NavSvoLeafVoxels::FMortonToLinearLUT& MortonToLinear = NavSvoLeafVoxels::GetMortonToLinearLUT();
+
+		for (int32 LayerIdx = 0; LayerIdx < NumLayers; ++LayerIdx)
 		{
-			bool bCreated;
-			FSvoNode* ParentNode = TileOut.EnsureNodeExists(l, Leaf.GetSelfLink().NodeIdx >> (l * 3), bCreated);
+			FSvoTile::FSvoLayer& Layer = TileOut.Layers[LayerIdx];
 
-			if (Leaf.GetNodeState() != ENodeState::Open)
+			for (uint32 NodeIdx = 0; NodeIdx < Layer.MaxNodes; ++NodeIdx)
 			{
-				ParentNode->SetNodeState(ENodeState::PartiallyBlocked);
+				const bool bParentPartial = (LayerIdx == NumLayers - 1) || (NodeStates[LayerStartIdx[LayerIdx + 1] + (NodeIdx >> 3)] == ENodeState::PartiallyBlocked);
+				if (!bParentPartial)
+				{
+					continue;
+				}
+
+				FSvoNode& Node = TileOut.NodePool[Layer.StartNode + NodeIdx];
+				Node.Init(FSvoNodeLink(TileID, LayerIdx, NodeIdx), false);
+				++Layer.NumNodes;
+
+				if (LayerIdx == SVO_LEAF_LAYER)
+				{
+					uint64 LeafVoxels = TileLeaves[NodeIdx];
+					while (LeafVoxels != 0)
+					{
+						const uint32 VoxelCode = (uint32)FMath::CountTrailingZeros64(LeafVoxels);
+						LeafVoxels &= LeafVoxels - 1;
+
+						Node.SetVoxelBlocked(MortonToLinear.Indices[VoxelCode]);
+					}
+				}
+				else
+				{
+					Node.SetNodeState(NodeStates[LayerStartIdx[LayerIdx] + NodeIdx]);
+				}
 			}
 		}
 	}
+	else
+	{
+		TileOut.ReleaseMemory();
+	}
 
-	CollapseUnneededNodes(TileOut, TileOut.NodeInfo);
+#if PROFILE_SVO_GENERATION
+	const uint64 FillCycle = FPlatformTime::Cycles64();
+#endif
 
 	// TEMP - To create all the internal neighbor links we have to call LinkNeighbors on
 	// an octree, so we create a temporary one here to do it. It would be nice to
@@ -862,61 +1993,377 @@ void FNavSvoTileGenerator::CreateTileFromVoxels(const FTileGenerationData& Tile,
 #endif
 }
 
-ENodeState FNavSvoTileGenerator::CollapseUnneededNodes(FSvoTile& Tile, FSvoNode& Node) const
+void FNavSvoTileGenerator::BuildClearance(const FNavSvoVoxelBuffer& Voxels, FSvoTile& TileOut, FNavSvoGenerationArena& Arena) const
+{
+	const int32 GridSize = Config.NumLeafNodesPerAxis * SVO_VOXEL_GRID_EXTENT;
+	const int32 TileSize = (Config.NumLeafNodesPerAxis - Config.NumPaddingLeafNodesPerAxis) * SVO_VOXEL_GRID_EXTENT;
+	const FIntVector TileOffset(int32(Config.NumPaddingLeafNodesPerAxis / 2) * SVO_VOXEL_GRID_EXTENT);
+
+	// Anything further than this from the blocked voxels is past what we gathered
+	// geometry for, so we can't say how clear it is.
+	const int32 Unmeasured = Config.MaxClearance + 1;
+
+	const auto GetGridIndex = [GridSize](int32 X, int32 Y, int32 Z)
+	{
+		return (Z * GridSize + Y) * GridSize + X;
+	};
+
+	// Distance transform of the voxels. Since we measure along the axes (which is how the
+	// padding grows too), one pass forward and one back gives the exact distances.
+	TArray<uint8>& Distances = Arena.Distances;
+	Distances.Init((uint8)Unmeasured, GridSize * GridSize * GridSize);
+
+	Voxels.ForEachSetVoxel([&Distances, &GetGridIndex](uint32 VoxelCode)
+	{
+		const FIntVector Coord = FSvoUtils::MortonToCoord(VoxelCode);
+		Distances[GetGridIndex(Coord.X, Coord.Y, Coord.Z)] = 0;
+	});
+
+	for (int32 Z = 0; Z < GridSize; ++Z)
+	{
+		for (int32 Y = 0; Y < GridSize; ++Y)
+		{
+			for (int32 X = 0; X < GridSize; ++X)
+			{
+				const int32 Index = GetGridIndex(X, Y, Z);
+				int32 Distance = Distances[Index];
+
+				if (Distance > 0)
+				{
+					if (X > 0) { Distance = FMath::Min(Distance, Distances[Index - 1] + 1); }
+					if (Y > 0) { Distance = FMath::Min(Distance, Distances[Index - GridSize] + 1); }
+					if (Z > 0) { Distance = FMath::Min(Distance, Distances[Index - GridSize * GridSize] + 1); }
+
+					Distances[Index] = (uint8)FMath::Min(Distance, Unmeasured);
+				}
+			}
+		}
+	}
+
+	for (int32 Z = GridSize - 1; Z >= 0; --Z)
+	{
+		for (int32 Y = GridSize - 1; Y >= 0; --Y)
+		{
+			for (int32 X = GridSize - 1; X >= 0; --X)
+			{
+				const int32 Index = GetGridIndex(X, Y, Z);
+				int32 Distance = Distances[Index];
+
+				if (Distance > 0)
+				{
+					if (X < GridSize - 1) { Distance = FMath::Min(Distance, Distances[Index + 1] + 1); }
+					if (Y < GridSize - 1) { Distance = FMath::Min(Distance, Distances[Index + GridSize] + 1); }
+					if (Z < GridSize - 1) { Distance = FMath::Min(Distance, Distances[Index + GridSize * GridSize] + 1); }
+
+					Distances[Index] = (uint8)FMath::Min(Distance, Unmeasured);
+				}
+			}
+		}
+	}
+
+	const auto ToClearance = [Unmeasured](int32 Distance) -> uint8
+	{
+		return (Distance >= Unmeasured) ? MAX_uint8 : (uint8)Distance;
+	};
+
+	// Returns the clearance of a cube of voxels in tile space
+	const auto GetMinClearance = [&](const FIntVector& Min, int32 Size) -> uint8
+	{
+		int32 MinDistance = Unmeasured;
+
+		for (int32 Z = Min.Z; Z < Min.Z + Size && MinDistance > 0; ++Z)
+		{
+			for (int32 Y = Min.Y; Y < Min.Y + Size; ++Y)
+			{
+				const int32 RowIndex = GetGridIndex(TileOffset.X + Min.X, TileOffset.Y + Y, TileOffset.Z + Z);
+
+				for (int32 X = 0; X < Size; ++X)
+				{
+					MinDistance = FMath::Min<int32>(MinDistance, Distances[RowIndex + X]);
+				}
+			}
+		}
+
+		return ToClearance(MinDistance);
+	};
+
+	TileOut.ResetClearance();
+	TileOut.bHasClearance = true;
+
+	if (TileOut.NodeInfo.GetNodeState() == ENodeState::Open)
+	{
+		TileOut.TileClearance = GetMinClearance(FIntVector::ZeroValue, TileSize);
+	}
+	else
+	{
+		TileOut.TileClearance = 0;
+	}
+
+	TileOut.NodeClearance.SetNumZeroed(TileOut.NodePool.Num());
+
+	for (int32 LayerIdx = 0; LayerIdx < TileOut.Layers.Num(); ++LayerIdx)
+	{
+		const FSvoTile::FSvoLayer& Layer = TileOut.Layers[LayerIdx];
+		const int32 NodeSize = SVO_VOXEL_GRID_EXTENT << LayerIdx;
+
+		for (uint32 NodeIdx = 0; NodeIdx < Layer.MaxNodes; ++NodeIdx)
+		{
+			const FSvoNode& Node = TileOut.NodePool[Layer.StartNode + NodeIdx];
+			if (!Node.IsActive())
+			{
+				continue;
+			}
+
+			const FIntVector NodeMin = FSvoUtils::MortonToCoord(NodeIdx) * NodeSize;
+
+			if (Node.GetNodeState() == ENodeState::Open)
+			{
+				TileOut.NodeClearance[Layer.StartNode + NodeIdx] = GetMinClearance(NodeMin, NodeSize);
+			}
+			else if (Node.IsLeafNode() && Node.GetNodeState() == ENodeState::PartiallyBlocked)
+			{
+				FSvoTile::FLeafClearance& Leaf = TileOut.LeafClearance.AddDefaulted_GetRef();
+				Leaf.LeafIdx = NodeIdx;
+
+				for (uint8 VoxelIdx = 0; VoxelIdx < SVO_VOXELS_PER_LEAF; ++VoxelIdx)
+				{
+					if (Node.IsVoxelBlocked(VoxelIdx))
+					{
+						Leaf.Voxels[VoxelIdx] = 0;
+						continue;
+					}
+
+					FIntVector VoxelCoord;
+					FSvoUtils::GetVoxelCoordFromIndex(VoxelIdx, VoxelCoord);
+
+					Leaf.Voxels[VoxelIdx] = GetMinClearance(NodeMin + VoxelCoord, 1);
+				}
+			}
+		}
+	}
+}
+
+bool FNavSvoTileGenerator::FAreaShape::Contains(const FVector& Location) const
 {
-	ENodeState NodeState = Node.GetNodeState();
+	if (!Bounds.IsInsideOrOn(Location))
+	{
+		return false;
+	}
+
+	const FVector2D Location2D(Location.X, Location.Y);
 
-	// If this node isn't collapsible (leaf node or already open or blocked), just return
-	// the node state.
-	if (Node.IsLeafNode() || NodeState != ENodeState::PartiallyBlocked)
+	if (Radius > 0.f)
 	{
-		return NodeState;
+		return FVector2D::DistSquared(Location2D, Center) <= FMath::Square(Radius);
 	}
 
-	// Otherwise, the node is partially blocked with children. Collapse all the children
-	// and see if all their states match.
-	for (uint8 i = 0; i < 8; ++i)
+	// Inside a convex hull the location is on the same side of every edge, whichever way
+	// the hull winds.
+	if (Points.Num() >= 3)
 	{
-		FSvoNodeLink ChildLink = Node.GetChildLink(i);
-		FSvoNode* ChildNode = Tile.GetNode(ChildLink.LayerIdx, ChildLink.NodeIdx);
-		ENodeState ChildState = CollapseUnneededNodes(Tile, *ChildNode);
+		bool bHasPositive = false;
+		bool bHasNegative = false;
+
+		for (int32 PointIdx = 0; PointIdx < Points.Num(); ++PointIdx)
+		{
+			const FVector2D& EdgeStart = Points[PointIdx];
+			const FVector2D& EdgeEnd = Points[(PointIdx + 1) % Points.Num()];
+
+			const float Side = FVector2D::CrossProduct(EdgeEnd - EdgeStart, Location2D - EdgeStart);
+			bHasPositive |= (Side > 0.f);
+			bHasNegative |= (Side < 0.f);
+
+			if (bHasPositive && bHasNegative)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void FNavSvoTileGenerator::GatherAreaShapes(const FTileGenerationData& Tile, TArray<FAreaShape>& OutShapes) const
+{
+	OutShapes.Reset();
 
-		// If this is our first child, seed the node state with its state
-		if (i == 0)
+	// Tiles sharing another generator's voxels didn't gather any modifiers of their own,
+	// but the area IDs are still ours.
+	const FTileGenerationData& GeometryTile = Tile.VoxelSource.IsValid() ? *Tile.VoxelSource : Tile;
+	const FNavigationOctreeCollider& Collider = Tile.CollisionInterface;
+
+	const FBox TileBounds(Tile.TileMin, Tile.TileMin + (Config.GetTileExtent() * 2.f));
+
+	for (const FNavigationOctreeCollider::FModifier& Modifier : GeometryTile.CollisionInterface.Modifiers)
+	{
+		if (Modifier.PerInstanceTransform.Num() > 0)
 		{
-			NodeState = ChildState;
+			continue;
 		}
 
-		// If we find any nodes that don't match our node state we can't collapse this
-		// node, so set it to partially blocked.
-		if (ChildState != NodeState)
+		for (const FAreaNavModifier& Area : Modifier.Areas)
 		{
-			NodeState = ENodeState::PartiallyBlocked;
+			const UNavArea* NavArea = Cast<UNavArea>(Area.GetAreaClass().GetDefaultObject());
+			if (NavArea == nullptr || !Area.GetBounds().Intersect(TileBounds))
+			{
+				continue;
+			}
+
+			const UClass* AreaClass = NavArea->GetClass();
+			const int32 SupportedIdx = Collider.SupportedAreas.IndexOfByPredicate([AreaClass](const TWeakObjectPtr<UClass>& SupportedArea)
+			{
+				return SupportedArea.Get() == AreaClass;
+			});
+
+			if (!Collider.SupportedAreaIDs.IsValidIndex(SupportedIdx))
+			{
+				continue;
+			}
+
+			const int32 AreaID = Collider.SupportedAreaIDs[SupportedIdx];
+			if (AreaID < 0 || AreaID >= SVO_MAX_AREAS)
+			{
+				continue;
+			}
+
+			FAreaShape& Shape = OutShapes.AddDefaulted_GetRef();
+			Shape.Bounds = Area.GetBounds();
+			Shape.AreaCode = (uint8)(AreaID + 1);
+			Shape.Priority = NavArea->DefaultCost;
+
+			if (Area.GetShapeType() == ENavigationShapeType::Convex)
+			{
+				FConvexNavAreaData ConvexData;
+				Area.GetConvex(ConvexData);
+
+				for (const FVector& Point : ConvexData.Points)
+				{
+					Shape.Points.Emplace(Point.X, Point.Y);
+				}
+			}
+			else if (Area.GetShapeType() == ENavigationShapeType::Cylinder)
+			{
+				FCylinderNavAreaData CylinderData;
+				Area.GetCylinder(CylinderData);
+
+				Shape.Center = FVector2D(CylinderData.Origin.X, CylinderData.Origin.Y);
+				Shape.Radius = CylinderData.Radius;
+			}
 		}
 	}
 
-	// We collapsed all our children and we're still partially blocked, we can't be
-	// collapsed.
-	if (NodeState == ENodeState::PartiallyBlocked)
+	// Stable, so overlapping areas of the same priority resolve the same way every build
+	Algo::StableSortBy(OutShapes, &FAreaShape::Priority);
+}
+
+void FNavSvoTileGenerator::BuildAreas(const FTileGenerationData& Tile, FSvoTile& TileOut, FNavSvoGenerationArena& Arena) const
+{
+	TileOut.ResetAreas();
+
+	TArray<FAreaShape> Shapes;
+	GatherAreaShapes(Tile, Shapes);
+
+	if (Shapes.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 NumTileLeavesPerAxis = int32(Config.NumLeafNodesPerAxis - Config.NumPaddingLeafNodesPerAxis);
+	const int32 NumTileLeaves = NumTileLeavesPerAxis * NumTileLeavesPerAxis * NumTileLeavesPerAxis;
+	const float LeafResolution = Config.GetLeafResolution();
+	const FIntVector MaxLeafCoord(NumTileLeavesPerAxis - 1);
+
+	// Mark the leaves whose center is in each area. The shapes are sorted by priority,
+	// so anything overlapping is overwritten by the higher priority area.
+	TArray<uint8>& LeafAreas = Arena.LeafAreas;
+	LeafAreas.Init(SVO_NO_AREA, NumTileLeaves);
+
+	float CodePriority[SVO_MAX_AREAS + 1];
+	CodePriority[SVO_NO_AREA] = -MAX_flt;
+
+	bool bAnyLeafInArea = false;
+
+	for (const FAreaShape& Shape : Shapes)
 	{
-		return NodeState;
+		CodePriority[Shape.AreaCode] = Shape.Priority;
+
+		const FIntVector MinCoord = FSvoUtils::LocationToCoord(Tile.TileMin, Shape.Bounds.Min, LeafResolution).ComponentMax(FIntVector::ZeroValue);
+		const FIntVector MaxCoord = FSvoUtils::LocationToCoord(Tile.TileMin, Shape.Bounds.Max, LeafResolution).ComponentMin(MaxLeafCoord);
+
+		for (int32 Z = MinCoord.Z; Z <= MaxCoord.Z; ++Z)
+		{
+			for (int32 Y = MinCoord.Y; Y <= MaxCoord.Y; ++Y)
+			{
+				for (int32 X = MinCoord.X; X <= MaxCoord.X; ++X)
+				{
+					const FVector LeafCenter = Tile.TileMin + (FVector(X, Y, Z) + 0.5f) * LeafResolution;
+					if (Shape.Contains(LeafCenter))
+					{
+						LeafAreas[FSvoUtils::CoordToMorton(FIntVector(X, Y, Z))] = Shape.AreaCode;
+						bAnyLeafInArea = true;
+					}
+				}
+			}
+		}
 	}
 
-	// We're either open or blocked after our children have been collapsed. Reset the
-	// children to an unused state and update our node status to the new state.
-	FSvoTile::FSvoLayer& ChildLayer = Tile.Layers[Node.GetChildLink(0).LayerIdx];
-	ChildLayer.NumNodes -= 8;
+	if (!bAnyLeafInArea)
+	{
+		return;
+	}
 
-	for (uint8 i = 0; i < 8; ++i)
+	// The leaves under a node are a contiguous run of Morton codes, so the area of any
+	// node is the highest priority one over that run.
+	const auto GetAreaForLeaves = [&LeafAreas, &CodePriority](int32 FirstLeaf, int32 NumLeaves) -> uint8
 	{
-		FSvoNodeLink ChildLink = Node.GetChildLink(i);
+		uint8 AreaCode = SVO_NO_AREA;
+
+		for (int32 LeafIdx = FirstLeaf; LeafIdx < FirstLeaf + NumLeaves; ++LeafIdx)
+		{
+			const uint8 LeafArea = LeafAreas[LeafIdx];
+			if (LeafArea != AreaCode && CodePriority[LeafArea] > CodePriority[AreaCode])
+			{
+				AreaCode = LeafArea;
+			}
+		}
+
+		return AreaCode;
+	};
 
-		// Reset the child node so it is no longer active
-		FSvoNode* ChildNode = Tile.GetNode(ChildLink.LayerIdx, ChildLink.NodeIdx);
-		ChildNode->Reset();
+	TileOut.bHasAreas = true;
+
+	if (TileOut.NodeInfo.GetNodeState() == ENodeState::Open)
+	{
+		TileOut.TileArea = GetAreaForLeaves(0, NumTileLeaves);
 	}
 
-	Node.SetNodeState(NodeState);
+	TileOut.NodeAreas.SetNumZeroed(TileOut.NodePool.Num());
+
+	for (int32 LayerIdx = 0; LayerIdx < TileOut.Layers.Num(); ++LayerIdx)
+	{
+		const FSvoTile::FSvoLayer& Layer = TileOut.Layers[LayerIdx];
+		const int32 NumNodeLeaves = 1 << (3 * LayerIdx);
+
+		for (uint32 NodeIdx = 0; NodeIdx < Layer.MaxNodes; ++NodeIdx)
+		{
+			const FSvoNode& Node = TileOut.NodePool[Layer.StartNode + NodeIdx];
+			if (!Node.IsActive() || Node.GetNodeState() == ENodeState::Blocked)
+			{
+				continue;
+			}
 
-	return NodeState;
+			// Non-leaf nodes which are partially blocked are never searched, only their
+			// children are.
+			if (Node.GetNodeState() == ENodeState::PartiallyBlocked && !Node.IsLeafNode())
+			{
+				continue;
+			}
+
+			const int32 FirstLeaf = int32(NodeIdx) * NumNodeLeaves;
+			if (ensure(FirstLeaf + NumNodeLeaves <= NumTileLeaves))
+			{
+				TileOut.NodeAreas[Layer.StartNode + NodeIdx] = GetAreaForLeaves(FirstLeaf, NumNodeLeaves);
+			}
+		}
+	}
 }
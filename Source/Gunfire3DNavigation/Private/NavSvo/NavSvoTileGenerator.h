@@ -4,30 +4,53 @@
 
 #include "NavSvoGeneratorConfig.h"
 #include "NavSvoCollider.h"
+#include "NavSvoGenerationArena.h"
 #include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
 
+#include "Misc/SecureHash.h"
+
+#include <atomic>
+
 class FNavDataGenerator;
 class FNavSvoGenerator;
+struct FNavSvoTileGenerationStats;
 
 class GUNFIRE3DNAVIGATION_API FNavSvoTileGenerator : public FNoncopyable, public FGCObject
 {
 public:
 	FNavSvoTileGenerator(const class FNavSvoGenerator& InParent, const FNavSvoGeneratorConfig& InConfig);
 
+	// Creates a generator without a parent, which can't gather geometry and can only
+	// build tiles with BuildTileFromVoxels.
+	explicit FNavSvoTileGenerator(const FNavSvoGeneratorConfig& InConfig);
+
 	// Builds the octree for the tile
 	void DoWork();
 
 	// Returns whether 'DoWork' has completed
 	bool IsWorkComplete() const { return bIsComplete; }
 
-	// Adds a tile to the list of tiles to be built
-	bool AddTile(const FIntVector& TileCoord);
+	// Adds a tile to the list of tiles to be built. If 'DirtyBounds' is valid only the
+	// leaves it overlaps may have changed, so if the tile is already in the octree just
+	// those leaves are rebuilt.
+	bool AddTile(const FIntVector& TileCoord, const FBox& DirtyBounds = FBox(ForceInit));
 
 	// Determines whether this task has any tiles to build.
 	bool HasTiles() const { return (Tiles.Num() > 0); }
 
 	int32 NumTiles() const { return Tiles.Num(); }
 
+	// Builds a tile from a function telling which voxels are blocked rather than from
+	// gathered geometry, so octrees can be generated without a world, e.g. for tests.
+	// The voxels are padded for the agent and collapsed into nodes the same as they are
+	// for geometry. 'BuiltTile' should be a new open tile for the coord. Nav areas
+	// aren't applied, since there's no world to gather them from.
+	void BuildTileFromVoxels(const FIntVector& TileCoord, TFunctionRef<bool(const FVector& VoxelCenter)> IsVoxelBlocked, FSvoTile& BuiltTile, FNavSvoTileGenerationStats& OutStats) const;
+
+	// Forgets all tiles shared between generators in a world. Must be called whenever
+	// the world's geometry changes, so nothing is voxelized from stale geometry.
+	static void ResetSharedTiles(const UWorld* World);
+
 	bool ContainsTileInBounds(const FIntVector& MinTileCoord, const FIntVector& MaxTileCoord) const;
 
 	// Used after work is complete on this generator to get tiles one by one. When this
@@ -76,14 +99,100 @@ private:
 
 		// Interface the octree uses to gather collision data
 		FNavigationOctreeCollider CollisionInterface;
+
+		// Set once any geometry that's gathered on the worker thread has been
+		bool bGeometryGathered = false;
+
+		// Time spent gathering geometry on the worker thread
+		uint64 GatherCycles = 0;
+
+		// Set if the geometry was gathered by another generator in our voxelization
+		// group, in which case we use its voxels instead of filling our own.
+		TSharedPtr<FTileGenerationData> VoxelSource;
+
+		// Voxels filled from the geometry, kept for tiles other generators can use
+		FNavSvoVoxelBuffer SharedVoxels;
+		bool bIsShared = false;
+		bool bSharedVoxelsFilled = false;
+		bool bSharedVoxelsBlocked = false;
+		FCriticalSection SharedVoxelsLock;
+
+		// Set if only some leaves of the tile are being rebuilt. The geometry is only
+		// gathered around the dirty leaves, and every other leaf is copied from the
+		// tile as it was in the octree.
+		bool bPartialRebuild = false;
+
+		// Leaf coordinates (in the unpadded tile) being rebuilt
+		FIntBox DirtyLeaves;
+
+		// Voxels of each leaf of the existing tile, by leaf code in Morton order
+		TArray<uint64> BaseLeaves;
+	};
+
+	// The shape of a nav modifier area, resolved to the area code it stores on nodes
+	struct FAreaShape
+	{
+		FBox Bounds;
+
+		// Hull of a convex area in XY, or the center and radius of a cylinder. Other
+		// shapes are just their bounds.
+		TArray<FVector2D> Points;
+		FVector2D Center = FVector2D::ZeroVector;
+		float Radius = 0.f;
+
+		uint8 AreaCode = 0;
+
+		// Where areas overlap, the one with the highest priority (its default cost) wins
+		float Priority = 0.f;
+
+		bool Contains(const FVector& Location) const;
 	};
 
-	void BuildPaddingOffsetCodes();
+	// Tiles gathered by generators in each voxelization group
+	struct FSharedTileRegistry;
+	static FSharedTileRegistry& GetSharedTileRegistry();
+
+	// Finds a tile gathered by another generator in our voxelization group whose voxels
+	// can be used for 'Tile', or null if there isn't one.
+	TSharedPtr<FTileGenerationData> FindSharedTile(const UWorld* World, const FTileGenerationData& Tile) const;
+
+	// Lets other generators in our voxelization group use the voxels for a tile
+	void RegisterSharedTile(const UWorld* World, const TSharedRef<FTileGenerationData>& TileRef) const;
+
+	// Fills the voxels of a shared tile if no other generator has yet. Returns false if
+	// there weren't any blocked voxels.
+	bool FillSharedVoxels(FTileGenerationData& Tile) const;
+
+	// Voxelizes, pads and builds a single tile. May be called for several tiles at once
+	// from different threads.
+	void GenerateTile(FTileGenerationData& Tile, FSvoTile& BuiltTile, FNavSvoGenerationArena& Arena) const;
+
+	// Does the work for GenerateTile, adding the time spent in each stage to 'OutStats'
+	void BuildTile(FTileGenerationData& Tile, FSvoTile& BuiltTile, FNavSvoGenerationArena& Arena, FNavSvoTileGenerationStats& OutStats) const;
+
+	// Decides whether only the dirty leaves of a tile need to be rebuilt, and if so
+	// copies the leaves of the existing tile. Returns true if the rebuild is partial.
+	bool InitPartialRebuild(const FSvoTile& ExistingTile, const FBox& TileBounds, const FBox& DirtyBounds, FTileGenerationData& Tile) const;
+
+	// Copies the leaves of the existing tile outside the dirty leaves into the padded voxels
+	void CopyBaseLeaves(const FTileGenerationData& Tile, FNavSvoVoxelBuffer& PaddedVoxels) const;
+
+	// Gathers the geometry for a tile on the worker thread, if it wasn't gathered when
+	// the tile was added
+	void GatherTileGeometry(FTileGenerationData& Tile) const;
+
+	// Hashes all the inputs a tile is built from, for looking it up in the tile cache.
+	// Must be called after the tile's geometry has been gathered.
+	FSHAHash CalcTileInputHash(const FTileGenerationData& Tile) const;
+
+	// Gathers the shapes of the modifier areas which overlap the tile, lowest priority
+	// first. Areas with instance transforms aren't supported.
+	void GatherAreaShapes(const FTileGenerationData& Tile, TArray<FAreaShape>& OutShapes) const;
 
 	// Builds the tile
-	bool FillVoxels(FTileGenerationData& Tile, TBitArray<>& Voxels) const;
-	bool FillTriangles(FTileGenerationData& Tile, const FVector& TileMin, TBitArray<>& Voxels) const;
-	bool FillBlockers(const FTileGenerationData& Tile, const FVector& TileMin, TBitArray<>& Voxels) const;
+	bool FillVoxels(FTileGenerationData& Tile, FNavSvoVoxelBuffer& Voxels) const;
+	bool FillTriangles(FTileGenerationData& Tile, const FVector& TileMin, FNavSvoVoxelBuffer& Voxels) const;
+	bool FillBlockers(const FTileGenerationData& Tile, const FVector& TileMin, FNavSvoVoxelBuffer& Voxels) const;
 
 	template<typename VectorType>
 	VectorType SwizzleCoord(const VectorType& Coord, const FIntVector& AxisMap) const
@@ -101,15 +210,34 @@ private:
 		return Ret;
 	};
 
-	bool RasterizeTriangle(FTileGenerationData& Tile, TArrayView<FVector> Verts, FIntVector AxisMap, TBitArray<>& Voxels) const;
+	bool RasterizeTriangle(FTileGenerationData& Tile, TArrayView<FVector> Verts, FIntVector AxisMap, FNavSvoVoxelBuffer& Voxels) const;
+
+	// Sets every voxel the triangle (in voxel space) overlaps, testing a row of four
+	// leaves or voxels at a time with a vectorized separating axis test. Voxels are
+	// written a whole leaf at a time.
+	bool RasterizeTriangleSAT(const FTileGenerationData& Tile, const FVector& V0, const FVector& V1, const FVector& V2, FNavSvoVoxelBuffer& Voxels) const;
+
+#if WITH_EDITOR
+	// Fills and pads the voxels for the tile with compute shaders instead of on the CPU.
+	// Returns false if the GPU couldn't be used, in which case nothing is filled.
+	bool VoxelizeOnGPU(FTileGenerationData& Tile, FNavSvoGenerationArena& Arena, bool& bOutFilledVoxel) const;
+#endif
 
 	// Pads out all existing voxels by a specified amount
-	void PadVoxels(const FTileGenerationData& Tile, const TBitArray<>& Voxels, TBitArray<>& PaddedVoxels) const;
+	void PadVoxels(const FTileGenerationData& Tile, const FNavSvoVoxelBuffer& Voxels, FNavSvoVoxelBuffer& PaddedVoxels, FNavSvoGenerationArena& Arena) const;
 
-	void CreateTileFromVoxels(const FTileGenerationData& Tile, const TBitArray<>& Voxels, FSvoTile& TileOut) const;
+	// Builds the nodes of the tile from the padded voxels. Only the nodes left once the
+	// tile is collapsed are allocated.
+	void CreateTileFromVoxels(const FTileGenerationData& Tile, const FNavSvoVoxelBuffer& Voxels, FSvoTile& TileOut, FNavSvoGenerationArena& Arena) const;
 
-	// Helper for OptimizeTiles
-	ENodeState CollapseUnneededNodes(FSvoTile& Tile, FSvoNode& Node) const;
+	// Stores how far every open node and voxel of the tile is from the unpadded voxels,
+	// up to the configured max clearance.
+	void BuildClearance(const FNavSvoVoxelBuffer& Voxels, FSvoTile& TileOut, FNavSvoGenerationArena& Arena) const;
+
+	// Stores the nav area every open node of the tile is in, from the center of each of
+	// its leaves. Nodes covering more than one area take the one with highest priority,
+	// since the tile isn't split up along area boundaries.
+	void BuildAreas(const FTileGenerationData& Tile, FSvoTile& TileOut, FNavSvoGenerationArena& Arena) const;
 
 private:
 	// SVO generator that called this tile generator
@@ -121,8 +249,6 @@ private:
 	// Flag is set once 'DoWork' completes
 	FThreadSafeBool bIsComplete;
 
-	TArray<uint32> PaddingOffsetCodes;
-
 	TStatArray<TSharedRef<FTileGenerationData>> Tiles;
 
 	TStatArray<FSvoTile> GeneratedTiles;
@@ -133,17 +259,29 @@ public:
 	uint32 PendingTicks = 0;
 	uint32 TriCount = 0;
 
-#if PROFILE_SVO_GENERATION
+	// If set, the tiles of this generator are built in parallel across the task graph
+	// workers, instead of one after another on the thread running the generator.
+	bool bParallelTiles = false;
+
+	// Generation stats for the job (see FNavSvoGenerationStats)
+	uint32 JobID = 0;
 	uint64 CreateCycle = 0;
+	uint64 SubmitCycle = 0;
+	uint64 StartWorkCycle = 0;
 	uint64 GatherCycles = 0;
+	uint64 WorkCycles = 0;
 	uint64 AddCycles = 0;
+
+#if PROFILE_SVO_GENERATION
 	uint64 AddTicks = 0;
-	mutable uint32 TotalTris = 0;
-	mutable uint32 UsedTris = 0;
-	mutable uint64 GenerateCycles = 0;
-	mutable uint64 PadCycles = 0;
-	mutable uint64 FillCycles = 0;
-	mutable uint64 NodeCycles = 0;
+	// Atomic since tiles may be built in parallel, in which case these are summed across
+	// threads rather than wall time.
+	mutable std::atomic<uint32> TotalTris = 0;
+	mutable std::atomic<uint32> UsedTris = 0;
+	mutable std::atomic<uint64> GenerateCycles = 0;
+	mutable std::atomic<uint64> PadCycles = 0;
+	mutable std::atomic<uint64> FillCycles = 0;
+	mutable std::atomic<uint64> NodeCycles = 0;
 #endif
 };
 
@@ -0,0 +1,309 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoTimeSlicedPathManager.h"
+
+#include "Gunfire3DNavData.h"
+#include "NavSvoQueryStats.h"
+#include "SparseVoxelOctree/EditableSparseVoxelOctree.h"
+
+#include "HAL/IConsoleManager.h"
+
+///> Profiling stats
+DECLARE_CYCLE_STAT(TEXT("Tick (TimeSlicedPaths)"), STAT_TimeSlicedPaths_Tick, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("BeginPath (TimeSlicedPaths)"), STAT_TimeSlicedPaths_BeginPath, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FinishPath (TimeSlicedPaths)"), STAT_TimeSlicedPaths_FinishPath, STATGROUP_Gunfire3DNavigation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending Time-Sliced Paths"), STAT_TimeSlicedPaths_Pending, STATGROUP_Gunfire3DNavigation);
+
+TAutoConsoleVariable<float> CVarNavSvoTimeSlicedPathBudget(TEXT("NavSvo.TimeSlicedPathBudget"), 0.5f, TEXT("Amount of time in ms that time-sliced path queries can spend searching each frame."), ECVF_Cheat);
+TAutoConsoleVariable<int32> CVarNavSvoTimeSlicedPathNodesPerSlice(TEXT("NavSvo.TimeSlicedPathNodesPerSlice"), 256, TEXT("Number of nodes a time-sliced path query visits before letting the next query have a turn."), ECVF_Cheat);
+TAutoConsoleVariable<int32> CVarNavSvoMaxActiveTimeSlicedPaths(TEXT("NavSvo.MaxActiveTimeSlicedPaths"), 8, TEXT("Maximum number of time-sliced path queries that can be searching at once. Each one holds its own search buffers until it finishes."), ECVF_Cheat);
+
+FNavSvoTimeSlicedPathManager::FNavSvoTimeSlicedPathManager(AGunfire3DNavData& InNavData)
+	: NavData(InNavData)
+{
+}
+
+FNavSvoTimeSlicedPathManager::~FNavSvoTimeSlicedPathManager()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	}
+}
+
+void FNavSvoTimeSlicedPathManager::Add(const FGunfire3DNavTimeSlicedPathRef& Request)
+{
+	check(IsInGameThread());
+
+	PendingPaths.Add(MakeUnique<FPendingPath>(Request));
+	UpdateTicker();
+}
+
+void FNavSvoTimeSlicedPathManager::Cancel(const FGunfire3DNavTimeSlicedPathRef& Request)
+{
+	check(IsInGameThread());
+
+	for (int32 PathIdx = 0; PathIdx < PendingPaths.Num(); ++PathIdx)
+	{
+		if (PendingPaths[PathIdx]->Request == Request)
+		{
+			ResetSearch(*PendingPaths[PathIdx]);
+			PendingPaths.RemoveAt(PathIdx);
+
+			if (NextPathIdx > PathIdx)
+			{
+				--NextPathIdx;
+			}
+			break;
+		}
+	}
+
+	UpdateTicker();
+}
+
+void FNavSvoTimeSlicedPathManager::RestartAll()
+{
+	for (TUniquePtr<FPendingPath>& PendingPath : PendingPaths)
+	{
+		ResetSearch(*PendingPath);
+	}
+}
+
+uint32 FNavSvoTimeSlicedPathManager::GetMemUsed() const
+{
+	uint32 MemUsed = sizeof(*this) + PendingPaths.GetAllocatedSize();
+
+	for (const TUniquePtr<FPendingPath>& PendingPath : PendingPaths)
+	{
+		MemUsed += sizeof(FPendingPath);
+
+		if (PendingPath->PathQuery.IsValid())
+		{
+			MemUsed += PendingPath->PathQuery->GetMemUsed();
+		}
+	}
+
+	return MemUsed;
+}
+
+bool FNavSvoTimeSlicedPathManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TimeSlicedPaths_Tick);
+
+	const FEditableSvo* Octree = NavData.GetOctree();
+	if (Octree == nullptr)
+	{
+		// Wait for an octree to search
+		return true;
+	}
+
+	const double MaxTickMS = CVarNavSvoTimeSlicedPathBudget.GetValueOnGameThread();
+	const uint64 MaxCycles = FMath::CeilToInt(MaxTickMS / (FPlatformTime::GetSecondsPerCycle64() * 1000.0));
+	const uint64 EndCycle = FPlatformTime::Cycles64() + MaxCycles;
+	const uint32 NodesPerSlice = FMath::Max(1, CVarNavSvoTimeSlicedPathNodesPerSlice.GetValueOnGameThread());
+	const int32 MaxActiveSearches = FMath::Max(1, CVarNavSvoMaxActiveTimeSlicedPaths.GetValueOnGameThread());
+
+	// Any search that began before the octree was last edited may be holding nodes
+	// which no longer exist, so those need to start over.
+	for (TUniquePtr<FPendingPath>& PendingPath : PendingPaths)
+	{
+		if (PendingPath->PathQuery.IsValid() && PendingPath->OctreeEditVersion != Octree->GetEditVersion())
+		{
+			ResetSearch(*PendingPath);
+		}
+	}
+
+	TArray<FGunfire3DNavTimeSlicedPathRef, TInlineAllocator<8>> CompletedRequests;
+
+	// Take turns searching until the budget has been spent, or there's nothing left
+	// that can be worked on.
+	int32 NumSkippedPaths = 0;
+	while (PendingPaths.Num() > 0 && NumSkippedPaths < PendingPaths.Num() && FPlatformTime::Cycles64() < EndCycle)
+	{
+		if (NextPathIdx >= PendingPaths.Num())
+		{
+			NextPathIdx = 0;
+		}
+
+		FPendingPath& PendingPath = *PendingPaths[NextPathIdx];
+
+		// Waiting for another search to finish
+		if (!PendingPath.PathQuery.IsValid() && NumActiveSearches >= MaxActiveSearches)
+		{
+			++NextPathIdx;
+			++NumSkippedPaths;
+			continue;
+		}
+
+		NumSkippedPaths = 0;
+
+		if (PendingPath.LastSliceFrame != GFrameCounter)
+		{
+			PendingPath.LastSliceFrame = GFrameCounter;
+			++PendingPath.Request->NumSlices;
+		}
+
+		if (ContinuePath(PendingPath, NodesPerSlice, EndCycle))
+		{
+			CompletedRequests.Add(PendingPath.Request);
+			PendingPaths.RemoveAt(NextPathIdx);
+		}
+		else
+		{
+			++NextPathIdx;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_TimeSlicedPaths_Pending, PendingPaths.Num());
+
+	// Notify once all the searching is done, in case any of the callbacks submit new
+	// requests.
+	for (const FGunfire3DNavTimeSlicedPathRef& Request : CompletedRequests)
+	{
+		Request->OnComplete.ExecuteIfBound(Request);
+	}
+
+	if (PendingPaths.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FNavSvoTimeSlicedPathManager::BeginPath(FPendingPath& PendingPath)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TimeSlicedPaths_BeginPath);
+
+	const FPathFindingQuery& Query = PendingPath.Request->Query;
+
+	// Hold onto the filter for the duration of the search
+	PendingPath.QueryFilter = Query.QueryFilter.IsValid() ? Query.QueryFilter : NavData.GetDefaultQueryFilter();
+
+	PendingPath.Path = AGunfire3DNavData::PreparePathInstance(NavData, Query);
+	FGunfire3DNavPath* NavPath = PendingPath.Path.IsValid() ? PendingPath.Path->CastPath<FGunfire3DNavPath>() : nullptr;
+	if (NavPath == nullptr || !PendingPath.QueryFilter.IsValid())
+	{
+		CompletePath(PendingPath, ENavigationQueryResult::Error);
+		return false;
+	}
+
+	FGunfire3DNavQueryTimings& Timings = NavPath->GetGenerationInfo().Timings;
+	if (FNavSvoQueryStats::IsEnabled())
+	{
+		Timings.QueryID = FNavSvoQueryStats::NextQueryID();
+	}
+
+	bool bFoundEndpoints;
+	{
+		FNavSvoScopedQueryTimer QueryTimer(Timings.NodeLookupTime);
+		bFoundEndpoints = AGunfire3DNavData::FindPathEndpoints(NavData, Query, PendingPath.Endpoints);
+	}
+
+	if (!bFoundEndpoints)
+	{
+		CompletePath(PendingPath, ENavigationQueryResult::Fail);
+		return false;
+	}
+
+	// Don't spend any slices on a goal the start can never reach
+	if (!Query.bAllowPartialPaths && !NavData.GetOctree()->AreNodesConnected(PendingPath.Endpoints.StartNodeLink, PendingPath.Endpoints.EndNodeLink))
+	{
+		CompletePath(PendingPath, ENavigationQueryResult::Fail);
+		return false;
+	}
+
+	if (AGunfire3DNavData::FindCachedPath(NavData, Query, PendingPath.Endpoints, false /* bHierarchical */, *NavPath))
+	{
+		CompletePath(PendingPath, ENavigationQueryResult::Success);
+		return false;
+	}
+
+	const FEditableSvo& Octree = *NavData.GetOctree();
+	const FNavigationQueryFilter& QueryFilter = *PendingPath.QueryFilter;
+	const FGunfire3DNavQueryFilter* QueryFilterImpl = StaticCast<const FGunfire3DNavQueryFilter*>(QueryFilter.GetImplementation());
+
+	PendingPath.PathQuery = MakeUnique<FNavSvoPathQuery>(Octree, QueryFilter.GetMaxSearchNodes());
+	PendingPath.OctreeEditVersion = Octree.GetEditVersion();
+	++NumActiveSearches;
+
+	const FNavSvoPathEndpoints& Endpoints = PendingPath.Endpoints;
+	if (!PendingPath.PathQuery->BeginFindPath(Endpoints.StartNodeLink, Endpoints.EndNodeLink, Query.CostLimit, *QueryFilterImpl, NavPath->GetGenerationInfo()))
+	{
+		CompletePath(PendingPath, ENavigationQueryResult::Fail);
+		return false;
+	}
+
+	return true;
+}
+
+bool FNavSvoTimeSlicedPathManager::ContinuePath(FPendingPath& PendingPath, uint32 MaxNodeVisits, uint64 EndCycle)
+{
+	if (!PendingPath.PathQuery.IsValid() && !BeginPath(PendingPath))
+	{
+		return true;
+	}
+
+	bool bSearchFinished;
+	{
+		FGunfire3DNavPath* NavPath = PendingPath.Path->CastPath<FGunfire3DNavPath>();
+		FNavSvoScopedQueryTimer QueryTimer(NavPath->GetGenerationInfo().Timings.SearchTime);
+		bSearchFinished = PendingPath.PathQuery->ContinueFindPath(MaxNodeVisits, EndCycle);
+	}
+
+	if (!bSearchFinished)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_TimeSlicedPaths_FinishPath);
+
+	FGunfire3DNavPath* NavPath = PendingPath.Path->CastPath<FGunfire3DNavPath>();
+	CompletePath(PendingPath, AGunfire3DNavData::FinishPath(NavData, PendingPath.Request->Query, PendingPath.Endpoints, false /* bHierarchical */, *NavPath));
+	return true;
+}
+
+void FNavSvoTimeSlicedPathManager::CompletePath(FPendingPath& PendingPath, ENavigationQueryResult::Type Result)
+{
+	FGunfire3DNavTimeSlicedPath& Request = *PendingPath.Request;
+	Request.Result = FPathFindingResult(Result);
+	if (Request.Result.IsSuccessful())
+	{
+		Request.Result.Path = PendingPath.Path;
+	}
+	Request.bComplete = true;
+
+	// The search is spread over multiple frames, so the latency only counts the time
+	// actually spent working on it.
+	FGunfire3DNavPath* NavPath = PendingPath.Path.IsValid() ? PendingPath.Path->CastPath<FGunfire3DNavPath>() : nullptr;
+	if (NavPath != nullptr && NavPath->GetGenerationInfo().Timings.QueryID != 0)
+	{
+		const FGunfire3DNavPathQueryResults& Results = NavPath->GetGenerationInfo();
+		FNavSvoQueryStats::RecordPathQuery(Request.Query, Results, Results.Timings.GetTotalTime());
+	}
+
+	ResetSearch(PendingPath);
+}
+
+void FNavSvoTimeSlicedPathManager::ResetSearch(FPendingPath& PendingPath)
+{
+	if (PendingPath.PathQuery.IsValid())
+	{
+		PendingPath.PathQuery.Reset();
+		--NumActiveSearches;
+	}
+}
+
+void FNavSvoTimeSlicedPathManager::UpdateTicker()
+{
+	if (PendingPaths.Num() > 0 && !TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FNavSvoTimeSlicedPathManager::Tick));
+	}
+	else if (PendingPaths.Num() == 0 && TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+}
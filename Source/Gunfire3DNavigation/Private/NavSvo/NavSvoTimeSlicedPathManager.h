@@ -0,0 +1,96 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Gunfire3DNavPath.h"
+#include "NavSvoPathQuery.h"
+
+#include "Containers/Ticker.h"
+
+class AGunfire3DNavData;
+
+//
+// Runs time-sliced path requests for a single navigation data instance. Every frame the
+// pending searches take turns visiting a slice of nodes until the shared frame budget
+// is spent, then pick up where they left off on the next frame.
+//
+// NOTE: Game thread only.
+//
+class FNavSvoTimeSlicedPathManager
+{
+public:
+	FNavSvoTimeSlicedPathManager(AGunfire3DNavData& InNavData);
+	~FNavSvoTimeSlicedPathManager();
+
+	FNavSvoTimeSlicedPathManager(const FNavSvoTimeSlicedPathManager&) = delete;
+	FNavSvoTimeSlicedPathManager& operator=(const FNavSvoTimeSlicedPathManager&) = delete;
+
+	// Queues a request to be searched starting next tick
+	void Add(const FGunfire3DNavTimeSlicedPathRef& Request);
+
+	// Removes a request without completing it
+	void Cancel(const FGunfire3DNavTimeSlicedPathRef& Request);
+
+	// Throws away all search progress so every request starts over. Must be called
+	// before the octree is destroyed, since the searches reference it.
+	void RestartAll();
+
+	int32 Num() const { return PendingPaths.Num(); }
+
+	uint32 GetMemUsed() const;
+
+private:
+	struct FPendingPath
+	{
+		FPendingPath(const FGunfire3DNavTimeSlicedPathRef& InRequest)
+			: Request(InRequest)
+		{}
+
+		FGunfire3DNavTimeSlicedPathRef Request;
+
+		// Keeps the filter alive while the search is referencing it
+		FSharedConstNavQueryFilter QueryFilter;
+
+		FNavPathSharedPtr Path;
+		FNavSvoPathEndpoints Endpoints;
+
+		// Only valid while the search is in progress
+		TUniquePtr<FNavSvoPathQuery> PathQuery;
+
+		// The octree's edit version when the search began
+		uint32 OctreeEditVersion = 0;
+
+		// The last frame the request was given a turn, for counting its slices
+		uint64 LastSliceFrame = MAX_uint64;
+	};
+
+	bool Tick(float DeltaTime);
+
+	// Starts the search for a path, returning false if the request was completed
+	// without needing one (e.g. a failure or cache hit).
+	bool BeginPath(FPendingPath& PendingPath);
+
+	// Advances the search for a path. Returns true once the request is complete.
+	bool ContinuePath(FPendingPath& PendingPath, uint32 MaxNodeVisits, uint64 EndCycle);
+
+	void CompletePath(FPendingPath& PendingPath, ENavigationQueryResult::Type Result);
+
+	void ResetSearch(FPendingPath& PendingPath);
+
+	void UpdateTicker();
+
+	AGunfire3DNavData& NavData;
+
+	// Requests in the order they were submitted. Held by pointer since the searches
+	// can't be moved once they've started.
+	TArray<TUniquePtr<FPendingPath>> PendingPaths;
+
+	// The request to resume from next, so every request gets a turn even when the
+	// budget runs out part way through the list.
+	int32 NextPathIdx = 0;
+
+	// The number of requests with a search in progress
+	int32 NumActiveSearches = 0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -18,13 +18,23 @@ void FNavSvoUtils::CleanUpPath(TArray<FNavPathPoint>& InOutPathPoints)
 {
 	SCOPE_CYCLE_COUNTER(STAT_CleanUpPath);
 
+	const int32 NumPathPoints = InOutPathPoints.Num();
+	if (NumPathPoints < 3)
+	{
+		return;
+	}
+
 	// For each node B with neighbors A and C: Remove if the direction of AB is the same
-	// as BC as this means that B is in the middle of the line from A to C.
-	for (int32 PathPointIdx = 0; PathPointIdx < InOutPathPoints.Num() - 2; ++PathPointIdx)
+	// as BC as this means that B is in the middle of the line from A to C. A is the last
+	// point kept, so the kept points are compacted towards the front as we go instead of
+	// removing each point from the middle of the array.
+	int32 WriteIdx = 0;
+
+	for (int32 ReadIdx = 1; ReadIdx < NumPathPoints - 1; ++ReadIdx)
 	{
-		FNavPathPoint& PathPointA = InOutPathPoints[PathPointIdx];
-		FNavPathPoint& PathPointB = InOutPathPoints[PathPointIdx + 1];
-		FNavPathPoint& PathPointC = InOutPathPoints[PathPointIdx + 2];
+		const FNavPathPoint& PathPointA = InOutPathPoints[WriteIdx];
+		const FNavPathPoint& PathPointB = InOutPathPoints[ReadIdx];
+		const FNavPathPoint& PathPointC = InOutPathPoints[ReadIdx + 1];
 
 		FVector DirAB = (PathPointB.Location - PathPointA.Location);
 		DirAB.Normalize();
@@ -32,44 +42,143 @@ void FNavSvoUtils::CleanUpPath(TArray<FNavPathPoint>& InOutPathPoints)
 		FVector DirBC = (PathPointC.Location - PathPointB.Location);
 		DirBC.Normalize();
 
-		if (DirAB.Equals(DirBC))
+		if (!DirAB.Equals(DirBC))
+		{
+			++WriteIdx;
+			if (WriteIdx != ReadIdx)
+			{
+				InOutPathPoints[WriteIdx] = InOutPathPoints[ReadIdx];
+			}
+		}
+	}
+
+	InOutPathPoints[++WriteIdx] = InOutPathPoints[NumPathPoints - 1];
+	InOutPathPoints.SetNum(WriteIdx + 1, false);
+}
+
+namespace NavSvoStringPull
+{
+	// Returns true if the segment crosses the portal at or beyond 'InOutMinTime' along
+	// the segment, updating the time to where it crossed.
+	bool SegmentCrossesPortal(const FVector& SegmentStart, const FVector& SegmentDelta, const FBox& Portal, float& InOutMinTime)
+	{
+		static const float Tolerance = KINDA_SMALL_NUMBER * 100.f;
+
+		// Portals are flat on the axis they face
+		const FVector PortalExtent = Portal.GetExtent();
+		const int32 PortalAxis = (PortalExtent.X <= PortalExtent.Y && PortalExtent.X <= PortalExtent.Z) ? 0 : (PortalExtent.Y <= PortalExtent.Z ? 1 : 2);
+
+		if (FMath::IsNearlyZero(SegmentDelta[PortalAxis]))
+		{
+			return false;
+		}
+
+		const float Time = (Portal.Min[PortalAxis] - SegmentStart[PortalAxis]) / SegmentDelta[PortalAxis];
+		if (Time < InOutMinTime - Tolerance || Time > 1.f + Tolerance)
+		{
+			return false;
+		}
+
+		const FVector CrossingPoint = SegmentStart + (SegmentDelta * Time);
+		for (int32 Axis = 0; Axis < 3; ++Axis)
 		{
-			InOutPathPoints.RemoveAt(PathPointIdx + 1);
-			--PathPointIdx;
+			if (Axis != PortalAxis && (CrossingPoint[Axis] < Portal.Min[Axis] - Tolerance || CrossingPoint[Axis] > Portal.Max[Axis] + Tolerance))
+			{
+				return false;
+			}
 		}
+
+		InOutMinTime = Time;
+		return true;
 	}
 }
 
-// TODO: This isn't really string pulling and is just an algorithm which raycast between
-// path nodes to remove redundant points. This is fine for now however we should implement
-// a funnel algorithm which should yield better results.
 void FNavSvoUtils::StringPullPath(const FSparseVoxelOctree& Octree, TArray<FNavPathPoint>& InOutPathPoints)
 {
 	SCOPE_CYCLE_COUNTER(STAT_StringPullPath);
 
-	Gunfire3DNavigation::FRaycastResult RaycastResult;
-	int32 LastPathPointIdx = InOutPathPoints.Num() - 1;
+	const int32 NumPathPoints = InOutPathPoints.Num();
+	if (NumPathPoints < 3)
+	{
+		return;
+	}
 
-	for (int32 PathPointIdx = 0; PathPointIdx < LastPathPointIdx; ++PathPointIdx)
+	// Each path point lies on the face shared by its node and the node of the previous
+	// point. Find those faces so we can tell which shortcuts stay inside the corridor of
+	// nodes the search found. An invalid portal means the two points share a node.
+	TArray<FBox, TInlineAllocator<64>> Portals;
+	Portals.SetNum(NumPathPoints);
 	{
-		const FNavPathPoint& PathPointA = InOutPathPoints[PathPointIdx];
-		const int32 NextPathPointIdx = PathPointIdx + 1;
+		FBox PrevNodeBounds(ForceInit);
+		Octree.GetBoundsForLink(FSvoNodeLink(InOutPathPoints[0].NodeRef), PrevNodeBounds);
 
-		// Find the last node we can raycast against
-		for (int32 FuturePathPointIdx = LastPathPointIdx; FuturePathPointIdx > NextPathPointIdx; --FuturePathPointIdx)
+		for (int32 PathPointIdx = 1; PathPointIdx < NumPathPoints; ++PathPointIdx)
 		{
-			const FNavPathPoint& PathPointB = InOutPathPoints[FuturePathPointIdx];
+			FBox NodeBounds(ForceInit);
+			Octree.GetBoundsForLink(FSvoNodeLink(InOutPathPoints[PathPointIdx].NodeRef), NodeBounds);
 
-			// If we successfully ray cast to this node then we need to remove all
-			// other nodes in between.
-			if (!Octree.Raycast(PathPointA.Location, PathPointB.Location, RaycastResult))
+			const bool bSameNode = (InOutPathPoints[PathPointIdx].NodeRef == InOutPathPoints[PathPointIdx - 1].NodeRef);
+			Portals[PathPointIdx] = (!bSameNode && NodeBounds.Intersect(PrevNodeBounds)) ? NodeBounds.Overlap(PrevNodeBounds) : FBox(ForceInit);
+			PrevNodeBounds = NodeBounds;
+		}
+	}
+
+	// Every node in the corridor is convex, so a segment which passes through each
+	// portal in order never leaves the corridor and can't be blocked. That lets us pull
+	// the path taut without raycasting. Each corner that is kept gets a single raycast
+	// to see if it can be skipped by cutting through open space outside the corridor.
+	//
+	// The corners are compacted towards the front of the array as they're found. A
+	// corner is never written past its own index, so every point still to be read is
+	// untouched.
+	int32 WriteIdx = 0;
+	int32 AnchorIdx = 0;
+	FVector AnchorLocation = InOutPathPoints[0].Location;
+	bool bAnchorRaycastUsed = false;
+
+	for (int32 PathPointIdx = 1; PathPointIdx < NumPathPoints - 1; ++PathPointIdx)
+	{
+		const int32 TargetIdx = PathPointIdx + 1;
+		const FVector SegmentDelta = InOutPathPoints[TargetIdx].Location - AnchorLocation;
+
+		bool bCanSkip = !bAnchorRaycastUsed;
+		if (bCanSkip)
+		{
+			float MinTime = 0.f;
+			for (int32 PortalIdx = AnchorIdx + 1; PortalIdx <= TargetIdx && bCanSkip; ++PortalIdx)
+			{
+				if (Portals[PortalIdx].IsValid)
+				{
+					bCanSkip = NavSvoStringPull::SegmentCrossesPortal(AnchorLocation, SegmentDelta, Portals[PortalIdx], MinTime);
+				}
+			}
+		}
+
+		if (!bCanSkip && !bAnchorRaycastUsed)
+		{
+			// Once a shortcut leaves the corridor the portals can no longer vouch for
+			// it, so later candidates from this anchor aren't considered.
+			bAnchorRaycastUsed = true;
+			bCanSkip = !Octree.RaycastAnyHit(AnchorLocation, InOutPathPoints[TargetIdx].Location);
+		}
+
+		if (!bCanSkip)
+		{
+			// The current point is a corner, start pulling from there
+			AnchorIdx = PathPointIdx;
+			AnchorLocation = InOutPathPoints[PathPointIdx].Location;
+			bAnchorRaycastUsed = false;
+
+			++WriteIdx;
+			if (WriteIdx != PathPointIdx)
 			{
-				InOutPathPoints.RemoveAt(NextPathPointIdx, FuturePathPointIdx - NextPathPointIdx);
-				LastPathPointIdx = InOutPathPoints.Num() - 1;
-				break;
+				InOutPathPoints[WriteIdx] = InOutPathPoints[PathPointIdx];
 			}
 		}
 	}
+
+	InOutPathPoints[++WriteIdx] = InOutPathPoints[NumPathPoints - 1];
+	InOutPathPoints.SetNum(WriteIdx + 1, false);
 }
 
 void FNavSvoUtils::SmoothPath(const FSparseVoxelOctree& Octree, TArray<FNavPathPoint>& InOutPathPoints, float Alpha, uint8 Iterations)
@@ -109,9 +218,8 @@ void FNavSvoUtils::SmoothPath(const FSparseVoxelOctree& Octree, TArray<FNavPathP
 	const float LastSegmentDist = LastSegmentDelta.Length();
 	const FVector LastPathPointNext = InOutPathPoints[LastPathPointIdx].Location + LastSegmentDelta.GetSafeNormal() * LastSegmentDist;
 
-	Gunfire3DNavigation::FRaycastResult RaycastResult;
 	TArray<FNavPathPoint> NewPathPoints;
-	NewPathPoints.Reserve(NumPathPoints * Iterations);
+	NewPathPoints.Reserve(NumPathPoints * (Iterations + 1));
 
 	for (int32 PathPointIdx = 0; PathPointIdx < LastPathPointIdx; ++PathPointIdx)
 	{
@@ -125,33 +233,72 @@ void FNavSvoUtils::SmoothPath(const FSparseVoxelOctree& Octree, TArray<FNavPathP
 		// NOTE: The end handle will be added when processing the next path point.
 		NewPathPoints.Add(P1);
 
-		// Add all smoothing nodes between the start and end handles
+		// The knots only depend on the control points, so they're the same for every
+		// point along the segment
+		const float T0 = 0.f;
+		const float T1 = T0 + FMath::Pow(FVector::Distance(P0, P1), Alpha);
+		const float T2 = T1 + FMath::Pow(FVector::Distance(P1, P2), Alpha);
+		const float T3 = T2 + FMath::Pow(FVector::Distance(P2, P3), Alpha);
+
+		// Find all the smoothing points between the start and end handles first, so the
+		// whole curve can be checked at once
+		TArray<FNavPathPoint, TInlineAllocator<8>> SegmentPoints;
+		bool bSegmentValid = true;
+
 		for (uint8 Iteration = 1; Iteration < (Iterations + 1); ++Iteration)
 		{
 			const float T = (float)Iteration / (float)(Iterations + 1);
 
-			const float T0 = 0.f;
-			const float T1 = T0 + FMath::Pow(FVector::Distance(P0, P1), Alpha);
-			const float T2 = T1 + FMath::Pow(FVector::Distance(P1, P2), Alpha);
-			const float T3 = T2 + FMath::Pow(FVector::Distance(P2, P3), Alpha);
-
 			const FVector NewPoint = FMath::CubicCRSplineInterpSafe(P0, P1, P2, P3, T0, T1, T2, T3, FMath::Lerp(T1, T2, T));
 			const FSvoNodeLink NodeLink = Octree.GetLinkForLocation(NewPoint);
 
-			// Ensure the new path point is a valid point on the octree and that it can be
-			// accessed by the start and end points of the segment without running into
-			// anything.
-			if (NodeLink.IsValid() &&
-				!Octree.Raycast(NewPoint, P1, RaycastResult) &&
-				!Octree.Raycast(NewPoint, P2, RaycastResult))
+			SegmentPoints.Add(FNavPathPoint(NewPoint, NodeLink.GetID()));
+			bSegmentValid &= NodeLink.IsValid();
+		}
+
+		// Most curves are clear, which only takes a raycast for each piece of the curve
+		// to tell
+		if (bSegmentValid)
+		{
+			FVector PrevPoint = P1;
+			for (const FNavPathPoint& SegmentPoint : SegmentPoints)
+			{
+				if (Octree.RaycastAnyHit(PrevPoint, SegmentPoint.Location))
+				{
+					bSegmentValid = false;
+					break;
+				}
+
+				PrevPoint = SegmentPoint.Location;
+			}
+
+			bSegmentValid = bSegmentValid && !Octree.RaycastAnyHit(PrevPoint, P2);
+		}
+
+		if (bSegmentValid)
+		{
+			NewPathPoints.Append(SegmentPoints);
+		}
+		else
+		{
+			// Otherwise only keep the points which can be reached from the last point
+			// kept and can reach the end of the segment without running into anything
+			FVector PrevPoint = P1;
+			for (const FNavPathPoint& SegmentPoint : SegmentPoints)
 			{
-				NewPathPoints.Add(FNavPathPoint(NewPoint, NodeLink.GetID()));
+				if (FSvoNodeLink(SegmentPoint.NodeRef).IsValid() &&
+					!Octree.RaycastAnyHit(PrevPoint, SegmentPoint.Location) &&
+					!Octree.RaycastAnyHit(SegmentPoint.Location, P2))
+				{
+					NewPathPoints.Add(SegmentPoint);
+					PrevPoint = SegmentPoint.Location;
+				}
 			}
 		}
 	}
 
-	// Now add the destination and update the original path points.
+	// Now add the destination and hand the new points over to the path
 	NewPathPoints.Add(InOutPathPoints[NumPathPoints - 1]);
 
-	InOutPathPoints = NewPathPoints;
+	InOutPathPoints = MoveTemp(NewPathPoints);
 }
\ No newline at end of file
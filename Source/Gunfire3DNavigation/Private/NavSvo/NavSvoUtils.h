@@ -11,7 +11,8 @@ public:
 	static void CleanUpPath(TArray<FNavPathPoint>& InOutPathPoints);
 
 	// Strips a path of all nodes that are between nodes which have direct line of sight
-	// to one another.
+	// to one another. Expects the unmodified path from the search, where each point lies
+	// on the portal between its node and the previous point's node.
 	static void StringPullPath(const class FSparseVoxelOctree& Octree, TArray<FNavPathPoint>& InOutPathPoints);
 
 	// Smooths the path to remove any harsh angles via Catmull-Rom
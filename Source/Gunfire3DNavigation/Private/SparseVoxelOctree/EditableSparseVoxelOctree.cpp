@@ -7,6 +7,7 @@
 #include "SparseVoxelOctreeUtils.h"
 
 #include "AI/NavigationSystemBase.h"
+#include "Async/ParallelFor.h"
 
 // Profiling stats
 DECLARE_CYCLE_STAT(TEXT("CopyTile (FEditableSvo)"), STAT_FEditableSvo_CopyTile, STATGROUP_Gunfire3DNavigation);
@@ -14,8 +15,41 @@ DECLARE_CYCLE_STAT(TEXT("AssumeTile (FEditableSvo)"), STAT_FEditableSvo_AssumeTi
 DECLARE_CYCLE_STAT(TEXT("RemoveTile (FEditableSvo)"), STAT_FEditableSvo_RemoveTile, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("EnsureNodeExistsAtLocation (FEditableSvo)"), STAT_FEditableSvo_EnsureNodeExistsAtLocation, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("FinalizeNodes (FEditableSvo)"), STAT_FEditableSvo_FinalizeNodes, STATGROUP_Gunfire3DNavigation);
-DECLARE_CYCLE_STAT(TEXT("FinalizeNodes : Sort (FEditableSvo)"), STAT_FEditableSvo_FinalizeNodes_Sort, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("PadVoxels (FEditableSvo)"), STAT_FEditableSvo_PadVoxels, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("ApplyStitch (FEditableSvo)"), STAT_FEditableSvo_ApplyStitch, STATGROUP_Gunfire3DNavigation);
+
+static TAutoConsoleVariable<int32> CVarNavSvoShareTileNodes(TEXT("NavSvo.ShareTileNodes"), 1, TEXT("If set, loaded tiles share their nodes with identical tiles loaded elsewhere in the process (e.g. the same level in several worlds). Only affects octrees loaded afterwards."), ECVF_Cheat);
+
+namespace EditableSvoStitches
+{
+	// Calls 'Func' with every node of a tile touching one of its faces, parents first
+	template<typename TFunc>
+	void ForEachNodeOnFace(const FSvoTile& Tile, ESvoNeighbor Face, const TFunc& Func)
+	{
+		TArray<FSvoNodeLink, TInlineAllocator<64>> Stack;
+		Stack.Add(Tile.GetSelfLink());
+
+		while (Stack.Num() > 0)
+		{
+			const FSvoNodeLink NodeLink = Stack.Pop(false);
+			const FSvoNode* Node = Tile.GetNode(NodeLink.LayerIdx, NodeLink.NodeIdx);
+			if (Node == nullptr)
+			{
+				continue;
+			}
+
+			Func(*Node);
+
+			if (Node->HasChildren())
+			{
+				for (uint8 ChildIdx : FSvoUtils::GetChildrenTouchingNeighbor(Face))
+				{
+					Stack.Add(Node->GetChildLink(ChildIdx));
+				}
+			}
+		}
+	}
+}
 
 FEditableSvo::FEditableSvo(const FSvoConfig& InConfig)
 	: Super(InConfig)
@@ -29,6 +63,16 @@ void FEditableSvo::Reset()
 
 	// Clear all dirty nodes
 	DirtyNodes.Empty();
+
+	TileGraph.Reset();
+	Islands.Reset();
+	RandomPoints.Reset();
+	NearestOpen.Reset();
+	Landmarks.Reset();
+
+	// Keep counting from the current version so anything tracking the old tiles can
+	// tell they're gone
+	++TileVersionCounter;
 }
 
 void FEditableSvo::Serialize(FArchive& Ar)
@@ -43,6 +87,37 @@ void FEditableSvo::Serialize(FArchive& Ar)
 	}
 
 	Super::Serialize(Ar);
+
+	if (Ar.IsLoading())
+	{
+		// The tile graph, islands and versions aren't saved, so rebuild them for the
+		// loaded tiles
+		TileGraph.Reset();
+		Islands.Reset();
+
+		TArray<FSvoTile*> LoadedTiles;
+		LoadedTiles.Reserve(GetNumTiles());
+
+		for (FSvoTile& Tile : GetTiles())
+		{
+			Tile.SetVersion(++TileVersionCounter);
+			Islands.MarkTileDirty(Tile.GetCoord());
+			LoadedTiles.Add(&Tile);
+		}
+
+		// Anything that modifies the tile later on takes its own copy of the nodes. Most of
+		// the cost is hashing the nodes, so it's done on the workers.
+		if (CVarNavSvoShareTileNodes.GetValueOnAnyThread() != 0)
+		{
+			ParallelFor(LoadedTiles.Num(), [&LoadedTiles](int32 TileIdx)
+			{
+				LoadedTiles[TileIdx]->ShareNodes();
+			}, (LoadedTiles.Num() > 1) ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+		}
+
+		TileGraph.AddTiles(MakeArrayView<const FSvoTile* const>(LoadedTiles.GetData(), LoadedTiles.Num()), Config);
+		Islands.Update(*this);
+	}
 }
 
 void FEditableSvo::CopyTile(const FSvoTile& SourceTile, bool bPreserveNeighborLinks)
@@ -58,6 +133,9 @@ void FEditableSvo::CopyTile(const FSvoTile& SourceTile, bool bPreserveNeighborLi
 
 			// Copy tile data
 			DestTile->Copy(SourceTile);
+			DestTile->SetVersion(++TileVersionCounter);
+			TileGraph.AddTile(*DestTile, Config);
+			Islands.MarkTileDirty(DestTile->GetCoord());
 
 			// Link the neighbors for the source tile so we can mark them as dirty
 			LinkNeighborsForNodeHierarchically(TileNodeLink, bPreserveNeighborLinks);
@@ -101,6 +179,9 @@ void FEditableSvo::AssumeTile(FSvoTile& SourceTile, bool bPreserveNeighborLinks)
 
 			// Take the data from the source tile and store it in our tree
 			DestTile->Assume(SourceTile);
+			DestTile->SetVersion(++TileVersionCounter);
+			TileGraph.AddTile(*DestTile, Config);
+			Islands.MarkTileDirty(DestTile->GetCoord());
 
 			// Link the neighbors for the source tile so we can mark them as dirty
 			LinkNeighborsForNodeHierarchically(TileNodeLink, bPreserveNeighborLinks);
@@ -146,6 +227,14 @@ void FEditableSvo::RemoveTile(const FSvoNodeLink& NodeLink)
 				// we don't bother trying to update it.
 				DirtyNodes.Remove(NodeLink);
 
+				TileGraph.RemoveTile(NodeLink.TileID);
+				++TileVersionCounter;
+
+				if (const FSvoTile* Tile = GetTile(NodeLink.TileID))
+				{
+					Islands.RemoveTile(Tile->GetCoord());
+				}
+
 				// Release the tile's memory
 				ReleaseTileByLink(NodeLink);
 			}
@@ -175,6 +264,174 @@ void FEditableSvo::RemoveMatchingTiles(const FSparseVoxelOctree& Source)
 	}
 }
 
+void FEditableSvo::BakeTileStitches(const FIntVector& TileCoord, TArray<FSvoFaceStitch>& OutStitches) const
+{
+	const FSvoTile* Tile = GetTileAtCoord(TileCoord);
+	if (Tile == nullptr)
+	{
+		return;
+	}
+
+	for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+	{
+		const FSvoTile* NeighborTile = GetTileAtCoord(TileCoord + FSvoUtils::GetNeighborDirection(Face));
+		if (NeighborTile == nullptr)
+		{
+			continue;
+		}
+
+		const ESvoNeighbor NeighborFace = FSvoUtils::GetOppositeNeighbor(Face);
+
+		FSvoFaceStitch& Stitch = OutStitches.AddDefaulted_GetRef();
+		Stitch.Face = Face;
+		Stitch.NeighborFaceHash = CalcFaceHash(*NeighborTile, NeighborFace);
+
+		EditableSvoStitches::ForEachNodeOnFace(*Tile, Face, [Tile, Face, &Stitch](const FSvoNode& Node)
+		{
+			Stitch.OutLinks.Add({ Node.GetSelfLink(), Node.GetNeighborLink(*Tile, Face) });
+		});
+
+		EditableSvoStitches::ForEachNodeOnFace(*NeighborTile, NeighborFace, [NeighborTile, NeighborFace, &Stitch](const FSvoNode& Node)
+		{
+			Stitch.InLinks.Add({ Node.GetSelfLink(), Node.GetNeighborLink(*NeighborTile, NeighborFace) });
+		});
+	}
+}
+
+void FEditableSvo::CopyTileWithStitches(const FSvoTile& SourceTile, TArrayView<const FSvoFaceStitch> Stitches)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FEditableSvo_CopyTile);
+
+	FSvoTile* DestTile = EnsureTileActiveAtCoord(SourceTile.GetCoord());
+	if (DestTile != nullptr)
+	{
+		BeginBatchEdit();
+		{
+			const FSvoNodeLink TileNodeLink = DestTile->GetSelfLink();
+
+			// Copy tile data
+			DestTile->Copy(SourceTile);
+			DestTile->SetVersion(++TileVersionCounter);
+			TileGraph.AddTile(*DestTile, Config);
+			Islands.MarkTileDirty(DestTile->GetCoord());
+
+			for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+			{
+				// Faces that can't be stitched are linked the same way CopyTile does
+				if (!ApplyStitch(*DestTile, Face, Stitches, false /* bUnlink */))
+				{
+					LinkNeighborForNodeHierarchically(TileNodeLink, Face);
+					MarkNeighborDirty(TileNodeLink, Face);
+				}
+			}
+		}
+		EndBatchEdit();
+	}
+}
+
+void FEditableSvo::RemoveTileWithStitches(const FIntVector& Coord, TArrayView<const FSvoFaceStitch> Stitches)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FEditableSvo_RemoveTile);
+
+	const FSvoTile* Tile = GetTileAtCoord(Coord);
+	if (Tile != nullptr)
+	{
+		const FSvoNodeLink NodeLink = Tile->GetSelfLink();
+
+		BeginBatchEdit();
+		{
+			for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+			{
+				if (!ApplyStitch(*Tile, Face, Stitches, true /* bUnlink */))
+				{
+					MarkNeighborDirty(NodeLink, Face);
+				}
+			}
+
+			DirtyNodes.Remove(NodeLink);
+
+			TileGraph.RemoveTile(NodeLink.TileID);
+			++TileVersionCounter;
+
+			Islands.RemoveTile(Coord);
+
+			// Release the tile's memory
+			ReleaseTileByLink(NodeLink);
+		}
+		EndBatchEdit();
+	}
+}
+
+uint32 FEditableSvo::CalcFaceHash(const FSvoTile& Tile, ESvoNeighbor Face)
+{
+	uint32 Hash = 0;
+
+	EditableSvoStitches::ForEachNodeOnFace(Tile, Face, [&Hash](const FSvoNode& Node)
+	{
+		Hash = HashCombine(Hash, GetTypeHash(Node.GetSelfLink().NodeID));
+		Hash = HashCombine(Hash, Node.HasChildren() ? 1 : 0);
+	});
+
+	return Hash;
+}
+
+bool FEditableSvo::ApplyStitch(const FSvoTile& Tile, ESvoNeighbor Face, TArrayView<const FSvoFaceStitch> Stitches, bool bUnlink)
+{
+	const FSvoFaceStitch* Stitch = Stitches.FindByPredicate([Face](const FSvoFaceStitch& FaceStitch)
+	{
+		return FaceStitch.Face == Face;
+	});
+
+	if (Stitch == nullptr)
+	{
+		return false;
+	}
+
+	const FSvoTile* NeighborTile = GetTileAtCoord(Tile.GetCoord() + FSvoUtils::GetNeighborDirection(Face));
+	const ESvoNeighbor NeighborFace = FSvoUtils::GetOppositeNeighbor(Face);
+
+	// The stitch only holds if the neighbor is laid out along the face the same way it
+	// was when it was baked
+	if (NeighborTile == nullptr || CalcFaceHash(*NeighborTile, NeighborFace) != Stitch->NeighborFaceHash)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FEditableSvo_ApplyStitch);
+
+	const uint32 TileID = Tile.GetID();
+	const uint32 NeighborTileID = NeighborTile->GetID();
+
+	if (!bUnlink)
+	{
+		for (const FSvoFaceStitch::FLink& Link : Stitch->OutLinks)
+		{
+			SetNeighborLinkForNode(FSvoNodeLink(TileID, Link.Node), Face, Link.Neighbor.IsValid() ? FSvoNodeLink(NeighborTileID, Link.Neighbor) : FSvoNodeLink());
+		}
+	}
+
+	for (const FSvoFaceStitch::FLink& Link : Stitch->InLinks)
+	{
+		const bool bLinked = (!bUnlink && Link.Neighbor.IsValid());
+		SetNeighborLinkForNode(FSvoNodeLink(NeighborTileID, Link.Node), NeighborFace, bLinked ? FSvoNodeLink(TileID, Link.Neighbor) : FSvoNodeLink());
+	}
+
+	return true;
+}
+
+void FEditableSvo::MarkNeighborDirty(const FSvoNodeLink& Link, ESvoNeighbor Neighbor)
+{
+	const FSvoNode* Node = GetNodeFromLink(Link);
+	const FSvoNodeLink NeighborLink = (Node != nullptr) ? Node->GetNeighborLink(*this, Neighbor) : FSvoNodeLink();
+
+	// Same as MarkNeighborsDirty, only neighbors at our resolution can link back to us
+	if (NeighborLink.IsValid() && NeighborLink.LayerIdx == Link.LayerIdx)
+	{
+		const ESvoNeighborFlags OppositeNeighborFlag = (ESvoNeighborFlags)(1 << (uint8)FSvoUtils::GetOppositeNeighbor(Neighbor));
+		EnumAddFlags(DirtyNodes.FindOrAdd(NeighborLink), OppositeNeighborFlag);
+	}
+}
+
 void FEditableSvo::MarkNeighborsDirty(const FSvoNodeLink& Link)
 {
 	// We need to mark all neighbors as dirty so they (and possibly their children) can have
@@ -212,40 +469,18 @@ void FEditableSvo::FinalizeNodes()
 	{
 		SCOPE_CYCLE_COUNTER(STAT_FEditableSvo_FinalizeNodes);
 
-		// Sort so we operate on nodes from the top down. Note that this is necessary for
-		// LinkNeighborForNode to work correctly as it expects the parent neighbors to
-		// already have been linked before linking a child's neighbors.
-		{
-			SCOPE_CYCLE_COUNTER(STAT_FEditableSvo_FinalizeNodes_Sort);
-			DirtyNodes.KeySort([](const FSvoNodeLink& A, const FSvoNodeLink& B)
-			{
-				return (A.LayerIdx > B.LayerIdx);
-			});
-		}
-
-		// Iterate over each dirty node and update their neighbor links
-		for (TPair<FSvoNodeLink, ESvoNeighborFlags>& DirtyNode : DirtyNodes)
-		{
-			// When adding a new node, we need to first link the node to its neighbors and
-			// then take each neighbor and re-link any of their neighbors links that point
-			// back towards this node. We have to start at the first node that is at or
-			// below the layer level of this node's parent.  This is because a
-			// higher-resolution node can link to a lower-resolution node but not
-			// vice-versa so it's possible that the neighbor node should now link to this
-			// node instead of the lower-resolution node that used to be empty but now
-			// contains this new node.
-
-			ensureAlways(DirtyNode.Value != ESvoNeighborFlags::None);
-
-			for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
-			{
-				const ESvoNeighborFlags NeighborFlag = (ESvoNeighborFlags)(1 << (uint8)Neighbor);
-				if (EnumHasAnyFlags(DirtyNode.Value, NeighborFlag))
-				{
-					LinkNeighborForNodeHierarchically(DirtyNode.Key, Neighbor);
-				}
-			}
-		}
+		// When adding a new node, we need to first link the node to its neighbors and
+		// then take each neighbor and re-link any of their neighbors links that point
+		// back towards this node. We have to start at the first node that is at or
+		// below the layer level of this node's parent.  This is because a
+		// higher-resolution node can link to a lower-resolution node but not
+		// vice-versa so it's possible that the neighbor node should now link to this
+		// node instead of the lower-resolution node that used to be empty but now
+		// contains this new node.
+		//
+		// The links are found in parallel a layer at a time from the top down, then
+		// written out serially, since a child's links depend on its parent's.
+		LinkNeighborsForNodesHierarchically(DirtyNodes);
 
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
 		VerifyNodeData();
@@ -254,6 +489,26 @@ void FEditableSvo::FinalizeNodes()
 		// Free up the memory from the set before processing.
 		DirtyNodes.Empty();
 	}
+
+	// Islands are labeled from the neighbor links, so they can only be updated once all
+	// nodes have been re-linked.
+	if (!bDeferIslandUpdates)
+	{
+		Islands.Update(*this);
+	}
+}
+
+void FEditableSvo::SetDeferIslandUpdates(bool bDefer)
+{
+	if (bDeferIslandUpdates != bDefer)
+	{
+		bDeferIslandUpdates = bDefer;
+
+		if (!bDeferIslandUpdates && !IsBatchEditing() && AreNodesFinalized())
+		{
+			Islands.Update(*this);
+		}
+	}
 }
 
 uint32 FEditableSvo::GetMemUsed() const
@@ -262,6 +517,11 @@ uint32 FEditableSvo::GetMemUsed() const
 
 	uint32 MemUsed = 0;
 	MemUsed += DirtyNodes.GetAllocatedSize();
+	MemUsed += TileGraph.GetMemUsed();
+	MemUsed += Islands.GetMemUsed();
+	MemUsed += RandomPoints.GetMemUsed();
+	MemUsed += NearestOpen.GetMemUsed();
+	MemUsed += Landmarks.GetMemUsed();
 
 	return SuperMemUsed + MemUsed;
 }
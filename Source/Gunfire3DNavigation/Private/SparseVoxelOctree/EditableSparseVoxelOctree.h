@@ -3,11 +3,55 @@
 #pragma once
 
 #include "SparseVoxelOctree.h"
+#include "SparseVoxelOctreeIslands.h"
+#include "SparseVoxelOctreeNearestOpen.h"
+#include "SparseVoxelOctreeRandomPoints.h"
+#include "SparseVoxelOctreeTileGraph.h"
 
 #include "Containers/StaticBitArray.h"
 
 class FSvoTile;
 
+//
+// Pre-baked neighbor links across one face of a tile, in both directions, against the
+// neighboring tile as it was when they were baked. Lets a tile be added or removed
+// without re-linking that face, so long as the neighbor hasn't changed since.
+//
+struct FSvoFaceStitch
+{
+	struct FLink
+	{
+		FSvoNodeLinkBase Node;
+		FSvoNodeLinkBase Neighbor;
+
+		friend FArchive& operator<<(FArchive& Ar, FLink& Link)
+		{
+			return Ar << Link.Node << Link.Neighbor;
+		}
+	};
+
+	// Direction from the tile to the neighbor
+	ESvoNeighbor Face = ESvoNeighbor::Self;
+
+	// Identifies the nodes along the neighbor's face (see FEditableSvo::CalcFaceHash)
+	uint32 NeighborFaceHash = 0;
+
+	// Links from every node along the tile's face into the neighbor
+	TArray<FLink> OutLinks;
+
+	// Links from every node along the neighbor's face back into the tile
+	TArray<FLink> InLinks;
+
+	friend FArchive& operator<<(FArchive& Ar, FSvoFaceStitch& Stitch)
+	{
+		uint8 Face = (uint8)Stitch.Face;
+		Ar << Face;
+		Stitch.Face = (ESvoNeighbor)Face;
+
+		return Ar << Stitch.NeighborFaceHash << Stitch.OutLinks << Stitch.InLinks;
+	}
+};
+
 class GUNFIRE3DNAVIGATION_API FEditableSvo : public FSparseVoxelOctree, public TSharedFromThis<FEditableSvo, ESPMode::ThreadSafe>
 {
 	typedef FSparseVoxelOctree Super;
@@ -40,12 +84,74 @@ public:
 	void RemoveTileAtCoord(const FIntVector& Coord);
 	void RemoveMatchingTiles(const FSparseVoxelOctree& Source);
 
+	// Bakes the links across every face of a tile that has a neighbor
+	void BakeTileStitches(const FIntVector& TileCoord, TArray<FSvoFaceStitch>& OutStitches) const;
+
+	// Same as CopyTile (without preserving links), except that faces whose neighbor
+	// still matches a stitch are linked straight from it instead of being re-linked
+	void CopyTileWithStitches(const FSvoTile& SourceTile, TArrayView<const FSvoFaceStitch> Stitches);
+
+	// Same as RemoveTile, except that neighbors which still match a stitch are unlinked
+	// directly instead of being re-linked
+	void RemoveTileWithStitches(const FIntVector& Coord, TArrayView<const FSvoFaceStitch> Stitches);
+
+	// Returns a hash of the nodes along one face of a tile. The links across a face only
+	// depend on which of these nodes have children, so two tiles with the same hash link
+	// to a neighbor the same way.
+	static uint32 CalcFaceHash(const FSvoTile& Tile, ESvoNeighbor Face);
+
 	void BeginBatchEdit() { ++BatchEditRefCounter; }
 	void EndBatchEdit();
 	bool IsBatchEditing() const { return (BatchEditRefCounter > 0); }
 
+	// While deferred, island labels aren't rebuilt when a batch edit ends, so an edit
+	// spread over many frames only pays for the rebuild once it's done. Until then every
+	// location is treated as connected. Clearing the flag rebuilds the labels.
+	void SetDeferIslandUpdates(bool bDefer);
+	bool AreIslandUpdatesDeferred() const { return bDeferIslandUpdates; }
+
+	// Returns the tile-level connectivity graph, used for hierarchical pathfinding
+	const FSvoTileGraph& GetTileGraph() const { return TileGraph; }
+
+	// Returns the connected-component labels of the open space, used to reject queries
+	// between locations that can never reach each other.
+	const FSvoIslands& GetIslands() const { return Islands; }
+
+	// Returns false only if both links are known to be on islands that aren't connected
+	bool AreNodesConnected(const FSvoNodeLink& LinkA, const FSvoNodeLink& LinkB) const { return Islands.AreConnected(*this, LinkA, LinkB); }
+
+	// Returns a value that changes whenever any tile is added, replaced or removed. Used
+	// by work spanning multiple frames to detect that the octree changed underneath it.
+	uint32 GetEditVersion() const { return TileVersionCounter; }
+
+	// Picks random points uniformly over the open space (see FSvoRandomPoints)
+	bool GetRandomPoint(FVector& OutLocation, FSvoNodeLink& OutLink) const
+	{
+		return RandomPoints.GetRandomPoint(*this, TileVersionCounter, OutLocation, OutLink);
+	}
+
+	bool GetRandomPointInRadius(const FVector& Origin, float Radius, TFunctionRef<bool(const FSvoNodeLink&)> Filter, FVector& OutLocation, FSvoNodeLink& OutLink) const
+	{
+		return RandomPoints.GetRandomPointInRadius(*this, TileVersionCounter, Origin, Radius, Filter, OutLocation, OutLink);
+	}
+
+	virtual bool FindNearestOpenLink(const FVector& Origin, const FBox& QueryBounds, FSvoNodeLink& OutLink, FVector& OutClosestPoint) const override
+	{
+		return NearestOpen.FindNearestOpenLink(*this, Origin, QueryBounds, OutLink, OutClosestPoint);
+	}
+
+	virtual FSvoLandmarks::FTablePtr GetLandmarks() const override
+	{
+		return Landmarks.GetTable(TileGraph, TileVersionCounter);
+	}
+
 protected:
 	void MarkNeighborsDirty(const FSvoNodeLink& Link);
+	void MarkNeighborDirty(const FSvoNodeLink& Link, ESvoNeighbor Neighbor);
+
+	// Links both sides of a face from a stitch, if the neighbor across it still matches.
+	// If 'bUnlink' is set, the neighbor's links back into the tile are cleared instead.
+	bool ApplyStitch(const FSvoTile& Tile, ESvoNeighbor Face, TArrayView<const FSvoFaceStitch> Stitches, bool bUnlink);
 
 	// Validates all nodes in the 'DirtyNodes' array.  This will handle re-linking neighbors,
 	// etc. for any modified nodes.
@@ -61,7 +167,29 @@ protected:
 	// completed.
 	TMap<FSvoNodeLink, ESvoNeighborFlags> DirtyNodes;
 
+	// Abstract graph of which tiles can be moved between. Kept up to date as tiles are
+	// added and removed.
+	FSvoTileGraph TileGraph;
+
+	// Island labels for all open space. Kept up to date as tiles are added and removed.
+	FSvoIslands Islands;
+
+	// Volume weighted tables of the open space, rebuilt as needed when sampled
+	FSvoRandomPoints RandomPoints;
+
+	// Distance grids of the blocked space in each tile, rebuilt as needed when queried
+	FSvoNearestOpen NearestOpen;
+
+	// Landmark distances over the tile graph, rebuilt as needed when queried
+	FSvoLandmarks Landmarks;
+
 	int32 BatchEditRefCounter;
+
+	bool bDeferIslandUpdates = false;
+
+	// Source of tile versions. Versions are unique across the whole octree so a tile
+	// that is removed and later re-added never repeats a previous version.
+	uint32 TileVersionCounter = 0;
 };
 
 typedef TSharedPtr<FEditableSvo, ESPMode::ThreadSafe> FEditableSvoSharedPtr;
\ No newline at end of file
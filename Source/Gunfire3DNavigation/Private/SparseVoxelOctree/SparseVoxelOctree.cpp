@@ -7,19 +7,34 @@
 #include "SparseVoxelOctreeUtils.h"
 
 #include "AI/NavigationSystemBase.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
 #include "Containers/CircularQueue.h"
+#include "Math/VectorRegister.h"
+
+#include <atomic>
 
 // Profiling stats
 DECLARE_CYCLE_STAT(TEXT("Generate (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_Generate, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("PopulateNode (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_PopulateNode, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("EnsureChildrenForNode (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_EnsureChildrenForNode, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("LinkNeighbors (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_LinkNeighbors, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("LinkNeighborsForNodesHierarchically (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_LinkNeighborsForNodesHierarchically, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("EnsureNodeExists (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_EnsureNodeExists, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("EnsureTileActiveAtCoord (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_EnsureTileActiveAtCoord, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("ReleaseTile (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_ReleaseTile, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("FindNodeLinkForLocation (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_FindNodeLinkForLocation, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("GetLinkForLocationNearHint (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_GetLinkForLocationNearHint, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("Raycast (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_Raycast, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RaycastAnyHit (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_RaycastAnyHit, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Sweep (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_Sweep, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("MoveAlongOpenSpace (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_MoveAlongOpenSpace, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("BatchRaycast (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_BatchRaycast, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("CompressIdleTiles (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_CompressIdleTiles, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("EvictDistantTiles (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_EvictDistantTiles, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("ShrinkToBudget (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_ShrinkToBudget, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("GetActiveTileCoords (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_GetActiveTileCoords, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Serialize (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_Serialize, STATGROUP_Gunfire3DNavigation);
 
 // We use this epsilon to push/pull the ray intersect values as needed to ensure
 // overlaps
@@ -45,13 +60,20 @@ void FSparseVoxelOctree::Reset()
 {
 	// Reset active tiles and look up tables
 	Tiles.Reset();
+	ResetTileIndex();
+
+	TileStore.Reset();
 }
 
 void FSparseVoxelOctree::Serialize(FArchive& Ar)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_Serialize);
+
 	// Write our custom version to the archive.  This will only occur during a save.
 	Ar.UsingCustomVersion(FGunfire3DNavigationCustomVersion::GUID);
 
+	const int32 Version = Ar.CustomVer(FGunfire3DNavigationCustomVersion::GUID);
+
 	if (Ar.IsLoading())
 	{
 		Reset();
@@ -62,7 +84,58 @@ void FSparseVoxelOctree::Serialize(FArchive& Ar)
 		Ar << MaxTiles;
 		Tiles.Reserve(MaxTiles);
 
-		Ar << Tiles;
+		// Node pools are read straight into place if they were written as raw blocks by a
+		// build with the same node layout. Otherwise the data needs to be rebuilt.
+		uint32 NodeLayout = 0;
+		uint32 BulkNodeSize = 0;
+		if (Version >= FGunfire3DNavigationCustomVersion::BulkNodePools)
+		{
+			Ar << NodeLayout;
+			Ar << BulkNodeSize;
+		}
+
+		const bool bLayoutMatches = (BulkNodeSize == 0 || (NodeLayout == FSvoNode::GetLayoutSignature() && !Ar.IsByteSwapping()));
+
+		// Tiles are stored as pairs of ID and tile, matching the map they used to be kept
+		// in. The ID is ignored, since older ones were hashes of the coordinate.
+		int32 NumTiles = 0;
+		Ar << NumTiles;
+
+		// Tiles are variable sized, so they have to be read one after the other. Upgrading
+		// and verifying them doesn't touch the archive though, so that's done on the
+		// workers afterwards, and the finished tiles are then added to the index.
+		TArray<FSvoTile> LoadedTiles;
+		LoadedTiles.SetNum(FMath::Max(NumTiles, 0));
+
+		for (FSvoTile& Tile : LoadedTiles)
+		{
+			uint32 TileID;
+			Ar << TileID;
+
+			Tile.Serialize(Ar, BulkNodeSize, !bLayoutMatches, true);
+		}
+
+		if (bLayoutMatches)
+		{
+			ParallelFor(LoadedTiles.Num(), [&LoadedTiles, Version](int32 TileIdx)
+			{
+				LoadedTiles[TileIdx].PostLoad(Version);
+			}, (LoadedTiles.Num() > 1) ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+			for (FSvoTile& Tile : LoadedTiles)
+			{
+				const FIntVector Coord = Tile.GetCoord();
+				if (ensure(FindTileSlot(Coord) == INDEX_NONE))
+				{
+					SetTileSlot(Coord, Tiles.Add(MoveTemp(Tile)));
+				}
+			}
+		}
+		else
+		{
+			UE_LOG(LogNavigation, Error, TEXT("FSparseVoxelOctree::Serialize : Saved node layout doesn't match this build; navigation needs to be rebuilt."));
+			Reset();
+		}
 
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
 		VerifyNodeData();
@@ -73,7 +146,23 @@ void FSparseVoxelOctree::Serialize(FArchive& Ar)
 		Config.Serialize(Ar);
 
 		Ar << MaxTiles;
-		Ar << Tiles;
+
+		// Node pools are written as raw blocks unless the target needs its bytes swapped,
+		// in which case they're written node by node.
+		uint32 NodeLayout = FSvoNode::GetLayoutSignature();
+		uint32 BulkNodeSize = Ar.IsByteSwapping() ? 0 : sizeof(FSvoNode);
+		Ar << NodeLayout;
+		Ar << BulkNodeSize;
+
+		int32 NumTiles = Tiles.Num();
+		Ar << NumTiles;
+
+		for (FSvoTile& Tile : Tiles)
+		{
+			uint32 TileID = Tile.GetID();
+			Ar << TileID;
+			Tile.Serialize(Ar, BulkNodeSize);
+		}
 	}
 }
 
@@ -104,21 +193,116 @@ void FSparseVoxelOctree::LinkNeighbors()
 	if (!IsValid())
 		return;
 
-	// Link all tiles first so the nodes can link to other tiles if needed.
+	TArray<const FSvoTile*, TInlineAllocator<64>> TileList;
+	TileList.Reserve(GetNumTiles());
 	for (const FSvoTile& Tile : GetTiles())
 	{
-		LinkNeighborsForNode(Tile.GetSelfLink());
+		TileList.Add(&Tile);
 	}
 
-	// Now link all nodes for each tile, from the lowest resolution to the highest
-	for (const FSvoTile& Tile : GetTiles())
+	// Link all tiles first so the nodes can link to other tiles if needed.
+	for (const FSvoTile* Tile : TileList)
+	{
+		LinkNeighborsForNode(Tile->GetSelfLink());
+	}
+
+	// Now link all nodes, from the lowest resolution to the highest. A node's links only
+	// depend on its parent's links and the structure of the nodes around it, so once a
+	// layer is done every tile can link its nodes in the next layer at the same time.
+	// Each task only writes to the nodes of its own tile.
+	for (int8 LayerIdx = (int8)Config.GetTileLayerIndex() - 1; LayerIdx >= SVO_LEAF_LAYER; --LayerIdx)
 	{
-		for (int8 LayerIdx = (int8)Config.GetTileLayerIndex() - 1; LayerIdx >= SVO_LEAF_LAYER; --LayerIdx)
+		ParallelFor(TileList.Num(), [this, &TileList, LayerIdx](int32 TileIdx)
 		{
-			for (const FSvoNode& Node : Tile.GetNodesForLayer(LayerIdx))
+			for (const FSvoNode& Node : TileList[TileIdx]->GetNodesForLayer(LayerIdx))
 			{
 				LinkNeighborsForNode(Node.GetSelfLink());
 			}
+		}, (TileList.Num() > 1) ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+	}
+}
+
+void FSparseVoxelOctree::LinkNeighborsForNodesHierarchically(const TMap<FSvoNodeLink, ESvoNeighborFlags>& Nodes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_LinkNeighborsForNodesHierarchically);
+
+	// Below this many nodes in a layer it's cheaper to just link them on this thread
+	static constexpr int32 MinParallelNodes = 256;
+
+	// Bucket the nodes by layer, so each layer can be linked once the one above it is
+	TStaticArray<TMap<FSvoNodeLink, ESvoNeighborFlags>, SVO_MAX_LAYERS + 1> LayerNodes;
+	for (const TPair<FSvoNodeLink, ESvoNeighborFlags>& Node : Nodes)
+	{
+		EnumAddFlags(LayerNodes[Node.Key.LayerIdx].FindOrAdd(Node.Key), Node.Value);
+	}
+
+	TArray<TPair<FSvoNodeLink, ESvoNeighborFlags>> WorkNodes;
+	TArray<FSvoNodeLink> NewLinks;
+
+	for (int8 LayerIdx = (int8)Config.GetTileLayerIndex(); LayerIdx >= SVO_LEAF_LAYER; --LayerIdx)
+	{
+		TMap<FSvoNodeLink, ESvoNeighborFlags>& CurLayerNodes = LayerNodes[LayerIdx];
+		if (CurLayerNodes.Num() == 0)
+		{
+			continue;
+		}
+
+		WorkNodes.Reset(CurLayerNodes.Num());
+		for (const TPair<FSvoNodeLink, ESvoNeighborFlags>& Node : CurLayerNodes)
+		{
+			// Do not process inactive nodes
+			const FSvoNode* CurNode = GetNodeFromLink(Node.Key);
+			if (CurNode != nullptr && CurNode->IsActive())
+			{
+				WorkNodes.Add(Node);
+			}
+		}
+		CurLayerNodes.Empty();
+
+		// Find all the new links for the layer. This only reads from the octree, so it
+		// can be split up however we like.
+		NewLinks.SetNumUninitialized(WorkNodes.Num() * 6);
+
+		ParallelFor(WorkNodes.Num(), [this, &WorkNodes, &NewLinks](int32 WorkIdx)
+		{
+			const TPair<FSvoNodeLink, ESvoNeighborFlags>& WorkNode = WorkNodes[WorkIdx];
+
+			for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+			{
+				const ESvoNeighborFlags NeighborFlag = (ESvoNeighborFlags)(1 << (uint8)Neighbor);
+				if (EnumHasAnyFlags(WorkNode.Value, NeighborFlag))
+				{
+					NewLinks[WorkIdx * 6 + (uint8)Neighbor] = FindNeighborLinkForNode(WorkNode.Key, Neighbor);
+				}
+			}
+		}, (WorkNodes.Num() >= MinParallelNodes) ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+		// Write the links out, and queue up the children touching each re-linked face so
+		// they get re-linked against the new links in the next layer.
+		TMap<FSvoNodeLink, ESvoNeighborFlags>* ChildLayerNodes = (LayerIdx > SVO_LEAF_LAYER) ? &LayerNodes[LayerIdx - 1] : nullptr;
+
+		for (int32 WorkIdx = 0; WorkIdx < WorkNodes.Num(); ++WorkIdx)
+		{
+			const TPair<FSvoNodeLink, ESvoNeighborFlags>& WorkNode = WorkNodes[WorkIdx];
+			const FSvoNode* Node = GetNodeFromLink(WorkNode.Key);
+			const bool bHasChildren = (ChildLayerNodes != nullptr && Node->HasChildren());
+
+			for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+			{
+				const ESvoNeighborFlags NeighborFlag = (ESvoNeighborFlags)(1 << (uint8)Neighbor);
+				if (EnumHasAnyFlags(WorkNode.Value, NeighborFlag))
+				{
+					SetNeighborLinkForNode(WorkNode.Key, Neighbor, NewLinks[WorkIdx * 6 + (uint8)Neighbor]);
+
+					if (bHasChildren)
+					{
+						for (uint8 ChildIdx : FSvoUtils::GetChildrenTouchingNeighbor(Neighbor))
+						{
+							EnumAddFlags(ChildLayerNodes->FindOrAdd(Node->GetChildLink(ChildIdx)), NeighborFlag);
+						}
+					}
+				}
+			}
 		}
 	}
 }
@@ -133,6 +317,29 @@ void FSparseVoxelOctree::LinkNeighborsForNode(const FSvoNodeLink& NodeLink)
 }
 
 void FSparseVoxelOctree::LinkNeighborForNode(const FSvoNodeLink& NodeLink, ESvoNeighbor Neighbor)
+{
+	SetNeighborLinkForNode(NodeLink, Neighbor, FindNeighborLinkForNode(NodeLink, Neighbor));
+}
+
+void FSparseVoxelOctree::SetNeighborLinkForNode(const FSvoNodeLink& NodeLink, ESvoNeighbor Neighbor, const FSvoNodeLink& NeighborLink)
+{
+	FSvoTile* Tile = GetTile(NodeLink.TileID);
+	ensure(Tile != nullptr && Tile->GetNodeInfo().IsActive());
+
+	if (NodeLink.LayerIdx == Config.GetTileLayerIndex())
+	{
+		Tile->GetNodeInfo().SetNeighborLink(Neighbor, NeighborLink);
+	}
+	else
+	{
+		FSvoNode* Node = Tile->GetNode(NodeLink.LayerIdx, NodeLink.NodeIdx);
+		ensure(Node != nullptr && Node->IsActive());
+
+		Node->SetNeighborLink(Neighbor, NeighborLink);
+	}
+}
+
+FSvoNodeLink FSparseVoxelOctree::FindNeighborLinkForNode(const FSvoNodeLink& NodeLink, ESvoNeighbor Neighbor) const
 {
 	// Mapping from a child node index (0-7) and neighbor to the corresponding parent
 	// neighbor. This will return either the same neighbor that's passed in if it's an
@@ -167,7 +374,7 @@ void FSparseVoxelOctree::LinkNeighborForNode(const FSvoNodeLink& NodeLink, ESvoN
 		{ 6,		5,		3,		6,		5,		3		},	// Node 7
 	};
 
-	FSvoTile* Tile = GetTile(NodeLink.TileID);
+	const FSvoTile* Tile = GetTile(NodeLink.TileID);
 	ensure(Tile != nullptr && Tile->GetNodeInfo().IsActive());
 
 	if (NodeLink.LayerIdx == Config.GetTileLayerIndex())
@@ -177,69 +384,59 @@ void FSparseVoxelOctree::LinkNeighborForNode(const FSvoNodeLink& NodeLink, ESvoN
 		const FIntVector NeighborTileCoord = Tile->GetCoord() + FSvoUtils::GetNeighborDirection(Neighbor);
 
 		const FSvoNodeLink NeighborLink = GetTileLinkAtCoord(NeighborTileCoord);
-		if (GetTileForLink(NeighborLink) != nullptr)
-		{
-			Tile->GetNodeInfo().SetNeighborLink(Neighbor, NeighborLink);
-		}
-		else
-		{
-			Tile->GetNodeInfo().SetNeighborLink(Neighbor, SVO_INVALID_NODELINK);
-		}
+		return (GetTileForLink(NeighborLink) != nullptr) ? NeighborLink : FSvoNodeLink(SVO_INVALID_NODELINK);
 	}
-	else
-	{
-		FSvoNode* Node = Tile->GetNode(NodeLink.LayerIdx, NodeLink.NodeIdx);
-		ensure(Node != nullptr && Node->IsActive());
 
-		// By default set the neighbor link to invalid. The only time it should actually
-		// stay that way is if a node is touching the face of a tile and there's no other
-		// tile in that direction.
-		Node->SetNeighborLink(Neighbor, SVO_INVALID_NODELINK);
+	const FSvoNode* Node = Tile->GetNode(NodeLink.LayerIdx, NodeLink.NodeIdx);
+	ensure(Node != nullptr && Node->IsActive());
 
-		// There should always be 8 children for every node so we can quickly calculate
-		// the sibling idx from the modulo
-		const uint8 SiblingIdx = (NodeLink.NodeIdx % 8);
+	// There should always be 8 children for every node so we can quickly calculate
+	// the sibling idx from the modulo
+	const uint8 SiblingIdx = (NodeLink.NodeIdx % 8);
 
-		// Look up which parent neighbor contains this nodes neighbor
-		const ESvoNeighbor ParentNeighborDir = ChildToParentNeighborLUT[SiblingIdx][(uint8)Neighbor];
+	// Look up which parent neighbor contains this nodes neighbor
+	const ESvoNeighbor ParentNeighborDir = ChildToParentNeighborLUT[SiblingIdx][(uint8)Neighbor];
 
-		// Look up sibling index for neighbor
-		const uint8 NeighborSiblingIdx = ChildNeighborLUT[SiblingIdx][(uint8)Neighbor];
+	// Look up sibling index for neighbor
+	const uint8 NeighborSiblingIdx = ChildNeighborLUT[SiblingIdx][(uint8)Neighbor];
 
-		// 'Self' is a special case to handle neighbors that are siblings of the node
-		// currently being processed.
-		if (ParentNeighborDir == ESvoNeighbor::Self)
-		{
-			Node->SetNeighborLink(Neighbor, FSvoNodeLink(NodeLink.TileID, NodeLink.LayerIdx, (NodeLink.NodeIdx - SiblingIdx) + NeighborSiblingIdx));
-		}
-		// Otherwise, consider all surrounding parent-neighbor nodes if this node has a
-		// parent. NOTE: Only the top most layer and the tile should be parent-less during
-		// this process. Later, the tile will become the parent of the top layer.
-		else if (FSvoNode* ParentNode = GetNodeFromLink(Node->GetParentLink()))
+	// 'Self' is a special case to handle neighbors that are siblings of the node
+	// currently being processed.
+	if (ParentNeighborDir == ESvoNeighbor::Self)
+	{
+		return FSvoNodeLink(NodeLink.TileID, NodeLink.LayerIdx, (NodeLink.NodeIdx - SiblingIdx) + NeighborSiblingIdx);
+	}
+	// Otherwise, consider all surrounding parent-neighbor nodes if this node has a
+	// parent. NOTE: Only the top most layer and the tile should be parent-less during
+	// this process. Later, the tile will become the parent of the top layer.
+	else if (const FSvoNode* ParentNode = GetNodeFromLink(Node->GetParentLink()))
+	{
+		const FSvoNodeLink ParentNeighborLink = ParentNode->GetNeighborLink(*this, ParentNeighborDir);
+		if (ParentNeighborLink.IsValid())
 		{
-			const FSvoNodeLink ParentNeighborLink = ParentNode->GetNeighborLink(*this, ParentNeighborDir);
-			if (ParentNeighborLink.IsValid())
-			{
-				const FSvoNode* ParentNeighborNode = GetNodeFromLink(ParentNeighborLink);
+			const FSvoNode* ParentNeighborNode = GetNodeFromLink(ParentNeighborLink);
 
-				// This node should *always* be valid.  If this assert is popping, *do not
-				// ignore it*!
-				if (ensureAlways(ParentNeighborNode))
+			// This node should *always* be valid.  If this assert is popping, *do not
+			// ignore it*!
+			if (ensureAlways(ParentNeighborNode))
+			{
+				// If this parent-neighbor node has children, assign this child
+				if (ParentNeighborNode->HasChildren())
 				{
-					// If this parent-neighbor node has children, assign this child
-					if (ParentNeighborNode->HasChildren())
-					{
-						Node->SetNeighborLink(Neighbor, ParentNeighborNode->GetChildLink(NeighborSiblingIdx));
-					}
-					// Otherwise, assign this neighbor to the parent neighbor
-					else
-					{
-						Node->SetNeighborLink(Neighbor, ParentNeighborLink);
-					}
+					return ParentNeighborNode->GetChildLink(NeighborSiblingIdx);
+				}
+				// Otherwise, assign this neighbor to the parent neighbor
+				else
+				{
+					return ParentNeighborLink;
 				}
 			}
 		}
 	}
+
+	// The only time a node should have no neighbor is if it's touching the face of a
+	// tile and there's no other tile in that direction.
+	return SVO_INVALID_NODELINK;
 }
 
 void FSparseVoxelOctree::LinkNeighborsForNodeHierarchically(const FSvoNodeLink& NodeLink, bool bInvalidOnly)
@@ -286,9 +483,21 @@ FSvoTile* FSparseVoxelOctree::EnsureTileActiveAtCoord(const FIntVector& Coord)
 	FSvoTile* Tile = GetTileAtCoord(Coord);
 	if (Tile == nullptr)
 	{
+		if (!FSvoTile::IsValidTileCoord(Coord))
+		{
+			// Can be reached from more than one thread
+			static std::atomic<bool> bWarnedCoord(false);
+			if (!bWarnedCoord.exchange(true))
+			{
+				UE_LOG(LogNavigation, Warning, TEXT("FSparseVoxelOctree::EnsureTileActiveAtCoord : Tile coordinate %s is out of range; Aborting!"), *Coord.ToString());
+			}
+
+			return nullptr;
+		}
+
 		if (Tiles.Num() == MaxTiles)
 		{
-			if (!Config.IsTilePoolSizeFixed())
+			if (!Config.IsTilePoolSizeFixed() && bAllowTilePoolGrowth)
 			{
 				// If the tile pool is full and we're allowed to expand it, increment the
 				// number of tiles.
@@ -314,7 +523,10 @@ FSvoTile* FSparseVoxelOctree::EnsureTileActiveAtCoord(const FIntVector& Coord)
 
 		const uint32 TileID = FSvoTile::CalcTileID(Coord);
 
-		Tile = &Tiles.Add(TileID, FSvoTile(TileID, Config.GetTileLayerIndex(), Coord));
+		const int32 Slot = Tiles.Add(FSvoTile(TileID, Config.GetTileLayerIndex(), Coord));
+		SetTileSlot(Coord, Slot);
+
+		Tile = &Tiles[Slot];
 
 		ensureAlways(!Tile->GetNodeInfo().HasChildren());
 
@@ -347,12 +559,18 @@ void FSparseVoxelOctree::ReleaseTile(FSvoTile* Tile)
 		Tile->Verify();
 #endif
 
-		const uint32 TileID = Tile->GetID();
+		const FIntVector Coord = Tile->GetCoord();
+		const int32 Slot = FindTileSlot(Coord);
 
 		// Reset the tile to prevent errant data the next time it's used.
 		Tile->Reset();
 
-		const bool bWasRemoved = (Tiles.Remove(TileID) > 0);
+		const bool bWasRemoved = (Slot != INDEX_NONE);
+		if (bWasRemoved)
+		{
+			Tiles.RemoveAt(Slot);
+			SetTileSlot(Coord, INDEX_NONE);
+		}
 
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
 		VerifyNodeData();
@@ -376,123 +594,452 @@ void FSparseVoxelOctree::ReleaseTileByLink(const FSvoNodeLink& Link)
 
 const FSvoTile* FSparseVoxelOctree::GetTileAtCoord(const FIntVector& Coord) const
 {
-	const uint32 TileID = FSvoTile::CalcTileID(Coord);
-	return GetTile(TileID);
+	const int32 Slot = FindTileSlot(Coord);
+	return (Slot != INDEX_NONE) ? &Tiles[Slot] : nullptr;
 }
 
-const FSvoTile* FSparseVoxelOctree::GetTileAtLocation(const FVector& Location) const
+int32 FSparseVoxelOctree::CompressIdleTiles(uint64 IdleSinceFrame, int32 MaxTilesToCheck)
 {
-	const FIntVector TileCoord = Config.LocationToCoord(Location, Config.GetTileResolution());
-	return GetTileAtCoord(TileCoord);
-}
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_CompressIdleTiles);
 
-const FSvoTile* FSparseVoxelOctree::GetTileForLink(const FSvoNodeLink& NodeLink) const
-{
-	return GetTile(NodeLink.TileID);
-}
+	const int32 NumSlots = Tiles.GetMaxIndex();
+	const int32 NumToCheck = FMath::Min(MaxTilesToCheck, NumSlots);
 
-FSvoNodeLink FSparseVoxelOctree::GetTileLinkAtCoord(const FIntVector& Coord) const
-{
-	const uint32 TileID = FSvoTile::CalcTileID(Coord);
-	return FSvoNodeLink(TileID, Config.GetTileLayerIndex(), 0);
-}
+	int32 NumCompressed = 0;
+	for (int32 CheckIdx = 0; CheckIdx < NumToCheck; ++CheckIdx)
+	{
+		ColdTileCursor = (ColdTileCursor + 1) % NumSlots;
 
-FSvoNodeLink FSparseVoxelOctree::GetTileLinkAtLocation(const FVector& Location) const
-{
-	const FIntVector TileCoord = Config.LocationToCoord(Location, Config.GetTileResolution());
-	return GetTileLinkAtCoord(TileCoord);
-}
+		if (Tiles.IsAllocated(ColdTileCursor))
+		{
+			FSvoTile& Tile = Tiles[ColdTileCursor];
+			if (Tile.GetLastAccessFrame() < IdleSinceFrame && Tile.CompressNodes())
+			{
+				++NumCompressed;
+			}
+		}
+	}
 
-bool FSparseVoxelOctree::ContainsLocation(const FVector& Location) const
-{
-	return (GetTileAtLocation(Location) != nullptr);
+	return NumCompressed;
 }
 
-bool FSparseVoxelOctree::GetLocationForLink(const FSvoNodeLink& Link, FVector& OutLocation) const
+int32 FSparseVoxelOctree::EvictDistantTiles(TArrayView<const FVector> Locations, float Radius, int32 MaxTilesToCheck)
 {
-	if (!Link.IsValid())
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_EvictDistantTiles);
+
+	if (Locations.Num() == 0)
 	{
-		return false;
+		return 0;
 	}
 
-	if (const FSvoTile* Tile = GetTile(Link.TileID))
+	if (!TileStore.IsValid())
 	{
-		if (Link.LayerIdx == Config.GetTileLayerIndex())
+		TileStore = MakeShared<FSvoTileStore, ESPMode::ThreadSafe>();
+	}
+
+	const float RadiusSq = FMath::Square(Radius);
+	const int32 NumSlots = Tiles.GetMaxIndex();
+	const int32 NumToCheck = FMath::Min(MaxTilesToCheck, NumSlots);
+
+	int32 NumEvicted = 0;
+	for (int32 CheckIdx = 0; CheckIdx < NumToCheck; ++CheckIdx)
+	{
+		EvictionCursor = (EvictionCursor + 1) % NumSlots;
+
+		if (!Tiles.IsAllocated(EvictionCursor))
 		{
-			OutLocation = Config.TileCoordToLocation(Tile->GetCoord());
-			return true;
+			continue;
 		}
-		else
+
+		FSvoTile& Tile = Tiles[EvictionCursor];
+		if (!Tile.HasNodesAllocated() || Tile.AreNodesEvicted())
 		{
-			if (const FSvoNode* Node = Tile->GetNode(Link.LayerIdx, Link.NodeIdx))
-			{
-				OutLocation = GetLocationForNode(*Node, *Tile);
+			continue;
+		}
 
-				if (Link.IsVoxelNode())
-				{
-					OutLocation = Config.GetVoxelLocation(Link.VoxelIdx, OutLocation);
-				}
+		const FBox TileBounds = Config.GetTileBounds(Tile.GetCoord());
 
-				return true;
+		bool bIsDistant = true;
+		for (const FVector& Location : Locations)
+		{
+			if (TileBounds.ComputeSquaredDistanceToPoint(Location) <= RadiusSq)
+			{
+				bIsDistant = false;
+				break;
 			}
 		}
+
+		if (bIsDistant && Tile.EvictNodes(*TileStore))
+		{
+			++NumEvicted;
+		}
 	}
 
-	return false;
+	return NumEvicted;
 }
 
-FVector FSparseVoxelOctree::GetLocationForNode(const FSvoNode& Node, const FSvoTile& Tile) const
+uint32 FSparseVoxelOctree::ShrinkToBudget(uint32 MemBudget, TArrayView<const FVector> Locations)
 {
-	const FSvoNodeLink NodeLink = Node.GetSelfLink();
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_ShrinkToBudget);
 
-	const FVector TileLocation = Config.TileCoordToLocation(Tile.GetCoord());
-	const FBox TileBounds = Config.GetTileBounds(TileLocation);
-	const float NodeSize = Config.GetResolutionForLink(NodeLink);
+	uint32 MemUsed = GetMemUsed();
+	if (MemUsed <= MemBudget)
+	{
+		return MemUsed;
+	}
 
-	FVector Location = Config.MortonToLocation(TileBounds.Min, NodeLink.NodeIdx, NodeSize);
+	struct FCandidate
+	{
+		int32 Slot;
 
-	if (NodeLink.IsVoxelNode())
+		// Higher scores are freed first
+		double Score;
+	};
+
+	TArray<FCandidate> Candidates;
+	for (auto TileIt = Tiles.CreateConstIterator(); TileIt; ++TileIt)
 	{
-		Location = Config.GetVoxelLocation(NodeLink.VoxelIdx, Location);
-	}
+		const FSvoTile& Tile = *TileIt;
+		if (!Tile.HasNodesAllocated() || Tile.AreNodesEvicted())
+		{
+			continue;
+		}
 
-	return Location;
-}
+		double Score = -(double)Tile.GetLastAccessFrame();
+		if (Locations.Num() > 0)
+		{
+			const FBox TileBounds = Config.GetTileBounds(Tile.GetCoord());
 
-FSvoNodeLink FSparseVoxelOctree::GetLinkForLocation(const FVector& Location, bool AllowBlocked) const
-{
-	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_FindNodeLinkForLocation);
+			Score = TNumericLimits<double>::Max();
+			for (const FVector& Location : Locations)
+			{
+				Score = FMath::Min(Score, TileBounds.ComputeSquaredDistanceToPoint(Location));
+			}
+		}
 
-	// If the tree hasn't been generated, bail
-	if (!IsValid())
+		Candidates.Add({ TileIt.GetIndex(), Score });
+	}
+
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B)
 	{
-		return SVO_INVALID_NODELINK;
+		return A.Score > B.Score;
+	});
+
+	// Reading back a compressed tile is much cheaper than going to disk, so everything
+	// gets a chance to be compressed before anything is evicted
+	for (int32 Pass = 0; Pass < 2 && MemUsed > MemBudget; ++Pass)
+	{
+		const bool bEvict = (Pass == 1);
+		if (bEvict && !TileStore.IsValid())
+		{
+			TileStore = MakeShared<FSvoTileStore, ESPMode::ThreadSafe>();
+		}
+
+		for (const FCandidate& Candidate : Candidates)
+		{
+			if (MemUsed <= MemBudget)
+			{
+				break;
+			}
+
+			FSvoTile& Tile = Tiles[Candidate.Slot];
+			const uint32 TileMemUsed = Tile.GetMemUsed();
+
+			if (bEvict ? Tile.EvictNodes(*TileStore) : Tile.CompressNodes())
+			{
+				const uint32 NewTileMemUsed = Tile.GetMemUsed();
+				MemUsed -= FMath::Min(MemUsed, (TileMemUsed > NewTileMemUsed) ? TileMemUsed - NewTileMemUsed : 0);
+			}
+		}
 	}
 
-	// First determine if the location is even within the a tile of the octree.
-	const FSvoNodeLink TileLink = GetTileLinkAtLocation(Location);
-	const FSvoTile* Tile = GetTileForLink(TileLink);
+	return MemUsed;
+}
 
-	if (Tile == nullptr)
+void FSparseVoxelOctree::GetEvictedTilesNear(TArrayView<const FVector> Locations, float Radius, TArray<uint32>& OutTileIDs) const
+{
+	for (const FVector& Location : Locations)
 	{
-		return SVO_INVALID_NODELINK;
+		GetTilesInBounds(FBox(Location - FVector(Radius), Location + FVector(Radius)), [&](const FSvoTile& Tile)
+		{
+			if (Tile.AreNodesEvicted())
+			{
+				OutTileIDs.AddUnique(Tile.GetID());
+			}
+
+			return true;
+		});
 	}
+}
 
-	// Starting at the tile, work our way down into the tree until we either the desired
-	// layer, find an empty node or reach the leaf layer.
-	FSvoNodeLink CurNodeLink = TileLink;
-	const FSvoNode* CurNode = &Tile->GetNodeInfo();
+void FSparseVoxelOctree::SetTileSlot(const FIntVector& Coord, int32 Slot)
+{
+	const FIntVector BrickCoord(Coord.X >> TileBrickShift, Coord.Y >> TileBrickShift, Coord.Z >> TileBrickShift);
+	FIntVector GridCoord = BrickCoord - TileBrickGridMin;
 
-	while (CurNodeLink.IsValid())
+	const bool bInGrid =
+		(uint32)GridCoord.X < (uint32)TileBrickGridSize.X &&
+		(uint32)GridCoord.Y < (uint32)TileBrickGridSize.Y &&
+		(uint32)GridCoord.Z < (uint32)TileBrickGridSize.Z;
+
+	if (!bInGrid)
 	{
-		// If this is the tile layer we already looked up the node info, otherwise look it
-		// up
-		if (CurNodeLink.LayerIdx != Config.GetTileLayerIndex())
+		// Nothing to remove outside the grid
+		if (Slot == INDEX_NONE)
 		{
-			CurNode = Tile->GetNode(CurNodeLink.LayerIdx, CurNodeLink.NodeIdx);
+			return;
 		}
 
-		if (!ensure(CurNode))
+		GrowTileBrickGrid(BrickCoord);
+		GridCoord = BrickCoord - TileBrickGridMin;
+	}
+
+	int32& BrickIdx = TileBrickGrid[GridCoord.X + TileBrickGridSize.X * (GridCoord.Y + TileBrickGridSize.Y * GridCoord.Z)];
+	if (BrickIdx == INDEX_NONE)
+	{
+		if (Slot == INDEX_NONE)
+		{
+			return;
+		}
+
+		BrickIdx = TileBricks.AddUninitialized();
+		for (int32& BrickSlot : TileBricks[BrickIdx].Slots)
+		{
+			BrickSlot = INDEX_NONE;
+		}
+	}
+
+	const int32 CellIdx = (Coord.X & TileBrickMask) | ((Coord.Y & TileBrickMask) << TileBrickShift) | ((Coord.Z & TileBrickMask) << (TileBrickShift * 2));
+	TileBricks[BrickIdx].Slots[CellIdx] = Slot;
+}
+
+void FSparseVoxelOctree::GrowTileBrickGrid(const FIntVector& BrickCoord)
+{
+	FIntVector NewMin = BrickCoord;
+	FIntVector NewMax = BrickCoord;
+
+	if (TileBrickGrid.Num() > 0)
+	{
+		const FIntVector OldMax = TileBrickGridMin + TileBrickGridSize - FIntVector(1);
+		NewMin = FIntVector(FMath::Min(NewMin.X, TileBrickGridMin.X), FMath::Min(NewMin.Y, TileBrickGridMin.Y), FMath::Min(NewMin.Z, TileBrickGridMin.Z));
+		NewMax = FIntVector(FMath::Max(NewMax.X, OldMax.X), FMath::Max(NewMax.Y, OldMax.Y), FMath::Max(NewMax.Z, OldMax.Z));
+	}
+
+	const FIntVector NewSize = NewMax - NewMin + FIntVector(1);
+
+	TArray<int32> NewGrid;
+	NewGrid.Init(INDEX_NONE, NewSize.X * NewSize.Y * NewSize.Z);
+
+	// Copy over the bricks from the old grid
+	for (int32 Z = 0; Z < TileBrickGridSize.Z; ++Z)
+	{
+		for (int32 Y = 0; Y < TileBrickGridSize.Y; ++Y)
+		{
+			for (int32 X = 0; X < TileBrickGridSize.X; ++X)
+			{
+				const FIntVector NewCoord = FIntVector(X, Y, Z) + TileBrickGridMin - NewMin;
+				NewGrid[NewCoord.X + NewSize.X * (NewCoord.Y + NewSize.Y * NewCoord.Z)] = TileBrickGrid[X + TileBrickGridSize.X * (Y + TileBrickGridSize.Y * Z)];
+			}
+		}
+	}
+
+	TileBrickGrid = MoveTemp(NewGrid);
+	TileBrickGridMin = NewMin;
+	TileBrickGridSize = NewSize;
+}
+
+void FSparseVoxelOctree::ResetTileIndex()
+{
+	TileBricks.Reset();
+	TileBrickGrid.Reset();
+	TileBrickGridMin = FIntVector::ZeroValue;
+	TileBrickGridSize = FIntVector::ZeroValue;
+}
+
+const FSvoTile* FSparseVoxelOctree::GetTileAtLocation(const FVector& Location) const
+{
+	const FIntVector TileCoord = Config.LocationToCoord(Location, Config.GetTileResolution());
+	return GetTileAtCoord(TileCoord);
+}
+
+const FSvoTile* FSparseVoxelOctree::GetTileForLink(const FSvoNodeLink& NodeLink) const
+{
+	return GetTile(NodeLink.TileID);
+}
+
+FSvoNodeLink FSparseVoxelOctree::GetTileLinkAtCoord(const FIntVector& Coord) const
+{
+	const uint32 TileID = FSvoTile::CalcTileID(Coord);
+	return FSvoNodeLink(TileID, Config.GetTileLayerIndex(), 0);
+}
+
+FSvoNodeLink FSparseVoxelOctree::GetTileLinkAtLocation(const FVector& Location) const
+{
+	const FIntVector TileCoord = Config.LocationToCoord(Location, Config.GetTileResolution());
+	return GetTileLinkAtCoord(TileCoord);
+}
+
+bool FSparseVoxelOctree::ContainsLocation(const FVector& Location) const
+{
+	return (GetTileAtLocation(Location) != nullptr);
+}
+
+bool FSparseVoxelOctree::GetLocationForLink(const FSvoNodeLink& Link, FVector& OutLocation) const
+{
+	if (!Link.IsValid())
+	{
+		return false;
+	}
+
+	if (const FSvoTile* Tile = GetTile(Link.TileID))
+	{
+		if (Link.LayerIdx == Config.GetTileLayerIndex())
+		{
+			OutLocation = Config.TileCoordToLocation(Tile->GetCoord());
+			return true;
+		}
+		else
+		{
+			if (const FSvoNode* Node = Tile->GetNode(Link.LayerIdx, Link.NodeIdx))
+			{
+				OutLocation = GetLocationForNode(*Node, *Tile);
+
+				if (Link.IsVoxelNode())
+				{
+					OutLocation = Config.GetVoxelLocation(Link.VoxelIdx, OutLocation);
+				}
+
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+FVector FSparseVoxelOctree::GetLocationForNode(const FSvoNode& Node, const FSvoTile& Tile) const
+{
+	const FSvoNodeLink NodeLink = Node.GetSelfLink();
+
+	const FVector TileLocation = Config.TileCoordToLocation(Tile.GetCoord());
+	const FBox TileBounds = Config.GetTileBounds(TileLocation);
+	const float NodeSize = Config.GetResolutionForLink(NodeLink);
+
+	FVector Location = Config.MortonToLocation(TileBounds.Min, NodeLink.NodeIdx, NodeSize);
+
+	if (NodeLink.IsVoxelNode())
+	{
+		Location = Config.GetVoxelLocation(NodeLink.VoxelIdx, Location);
+	}
+
+	return Location;
+}
+
+FSvoNodeLink FSparseVoxelOctree::GetLinkForLocation(const FVector& Location, bool AllowBlocked) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_FindNodeLinkForLocation);
+
+	// If the tree hasn't been generated, bail
+	if (!IsValid())
+	{
+		return SVO_INVALID_NODELINK;
+	}
+
+	// First determine if the location is even within the a tile of the octree.
+	const FSvoNodeLink TileLink = GetTileLinkAtLocation(Location);
+	const FSvoTile* Tile = GetTileForLink(TileLink);
+
+	if (Tile == nullptr)
+	{
+		return SVO_INVALID_NODELINK;
+	}
+
+	// Starting at the tile, work our way down into the tree
+	return FindLinkForLocationInTile(*Tile, TileLink, Location, AllowBlocked);
+}
+
+FSvoNodeLink FSparseVoxelOctree::GetLinkForLocationInNode(const FSvoNodeLink& NodeLink, const FVector& Location, bool AllowBlocked) const
+{
+	const FSvoTile* Tile = NodeLink.IsValid() ? GetTile(NodeLink.TileID) : nullptr;
+
+	if (Tile == nullptr)
+	{
+		return SVO_INVALID_NODELINK;
+	}
+
+	// Voxels are found again from their leaf node
+	FSvoNodeLink StartLink = NodeLink;
+	StartLink.VoxelIdx = SVO_NO_VOXEL;
+	StartLink.UserData = 0;
+
+	return FindLinkForLocationInTile(*Tile, StartLink, Location, AllowBlocked);
+}
+
+FSvoNodeLink FSparseVoxelOctree::GetLinkForLocationNearHint(const FSvoNodeLink& HintLink, const FVector& Location, bool AllowBlocked) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_GetLinkForLocationNearHint);
+
+	// Voxels are found again from their leaf node
+	FSvoNodeLink NodeLink = HintLink;
+	NodeLink.VoxelIdx = SVO_NO_VOXEL;
+	NodeLink.UserData = 0;
+
+	// The hint may be from before the octree last changed, in which case the node may be
+	// gone
+	const FSvoTile* Tile = NodeLink.IsValid() ? GetTile(NodeLink.TileID) : nullptr;
+	const FSvoNode* Node = nullptr;
+	if (Tile != nullptr)
+	{
+		Node = (NodeLink.LayerIdx == Config.GetTileLayerIndex()) ? &Tile->GetNodeInfo() : Tile->GetNode(NodeLink.LayerIdx, NodeLink.NodeIdx);
+	}
+
+	if (Node != nullptr && Node->GetSelfLink() == NodeLink)
+	{
+		// Locations on the surface of a node are left to the regular lookup, since which
+		// side they fall on depends on how they round.
+		auto ContainsLocation = [this, &Location](const FSvoNodeLink& Link)
+		{
+			FBox Bounds;
+			return GetBoundsForLink(Link, Bounds) && Bounds.IsInside(Location);
+		};
+
+		if (ContainsLocation(NodeLink))
+		{
+			return GetLinkForLocationInNode(NodeLink, Location, AllowBlocked);
+		}
+
+		for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+		{
+			const FSvoNodeLink NeighborLink = Node->GetNeighborLink(*Tile, Neighbor);
+			if (NeighborLink.IsValid() && ContainsLocation(NeighborLink))
+			{
+				return GetLinkForLocationInNode(NeighborLink, Location, AllowBlocked);
+			}
+		}
+	}
+
+	return GetLinkForLocation(Location, AllowBlocked);
+}
+
+FSvoNodeLink FSparseVoxelOctree::FindLinkForLocationInTile(const FSvoTile& InTile, const FSvoNodeLink& StartLink, const FVector& Location, bool AllowBlocked) const
+{
+	const FSvoTile* Tile = &InTile;
+
+	// Work our way down into the tree until we either the desired layer, find an empty
+	// node or reach the leaf layer.
+	FSvoNodeLink CurNodeLink = StartLink;
+	const FSvoNode* CurNode = &Tile->GetNodeInfo();
+
+	while (CurNodeLink.IsValid())
+	{
+		// If this is the tile layer we already looked up the node info, otherwise look it
+		// up
+		if (CurNodeLink.LayerIdx != Config.GetTileLayerIndex())
+		{
+			CurNode = Tile->GetNode(CurNodeLink.LayerIdx, CurNodeLink.NodeIdx);
+		}
+
+		if (!ensure(CurNode))
 		{
 			UE_LOG(LogNavigation, Warning, TEXT("FSparseVoxelOctree::GetLinkForLocation : Failed to find node; Aborting\n"
 				"    TileID: %d\n"
@@ -502,276 +1049,957 @@ FSvoNodeLink FSparseVoxelOctree::GetLinkForLocation(const FVector& Location, boo
 				"    UserData: %d"),
 				CurNodeLink.TileID, CurNodeLink.LayerIdx, CurNodeLink.NodeIdx, CurNodeLink.VoxelIdx, CurNodeLink.UserData);
 
-			return SVO_INVALID_NODELINK;
-		}
+			return SVO_INVALID_NODELINK;
+		}
+
+		ensure(CurNode->GetSelfLink() == CurNodeLink);
+
+		// If at the leaf layer we either:
+		//	Return an invalid link id if fully blocked.
+		//	Search for the overlapping voxel and return its state
+		if (CurNodeLink.IsLeafNode())
+		{
+			FVector VoxelLocation;
+
+			if (CurNode->GetNodeState() == ENodeState::Open)
+			{
+				return CurNode->GetSelfLink();
+			}
+			else if (CurNode->GetNodeState() == ENodeState::Blocked)
+			{
+				// If we're returning blocked nodes, since this one is fully blocked the
+				// highest resolution node is the leaf.
+				if (AllowBlocked)
+				{
+					return CurNode->GetSelfLink();
+				}
+				// If fully blocked, no voxel will be valid so return an invalid link
+				else
+				{
+					return SVO_INVALID_NODELINK;
+				}
+			}
+			else
+			{
+				// Knowing that the location is within the bounds of this leaf node, we
+				// can deduce the voxel location easily via coords.
+				FIntVector VoxelCoord = GetRelativeChildCoord(CurNodeLink, Location);
+
+				// This can happen due to floating point errors.  To fix this, we just
+				// increment the negative values by one.
+				// NOTE: There should *never* be an error greater than 1!
+				if (!FSvoUtils::IsVoxelCoordValid(VoxelCoord))
+				{
+					if (VoxelCoord.X < 0) ++VoxelCoord.X;
+					if (VoxelCoord.Y < 0) ++VoxelCoord.Y;
+					if (VoxelCoord.Z < 0) ++VoxelCoord.Z;
+
+					// The voxel coord should definitely be valid at this point
+					ensure(FSvoUtils::IsVoxelCoordValid(VoxelCoord));
+				}
+
+				CurNodeLink.VoxelIdx = FSvoUtils::GetVoxelIndexForCoord(VoxelCoord);
+
+				const bool bVoxelIsBlocked = CurNode->IsVoxelBlocked(CurNodeLink.VoxelIdx);
+
+				if (!bVoxelIsBlocked || AllowBlocked)
+				{
+					return CurNodeLink;
+				}
+				else
+				{
+					return SVO_INVALID_NODELINK;
+				}
+			}
+		}
+		// If at a normal layer, we either:
+		//		a.) Descend to the next layer if children exist
+		//		b.) Return this node for it is just open space
+		else if (CurNode->GetNodeState() == ENodeState::PartiallyBlocked)
+		{
+			static const FIntVector ChildCoordExtents(SVO_OCTANT_GRID_EXTENT);
+
+			const FIntVector ChildCoord = GetRelativeChildCoord(CurNodeLink, Location);
+			if (ensure(FSvoUtils::IsCoordValid(ChildCoord, ChildCoordExtents)))
+			{
+				const uint32 CoordIdx = FSvoUtils::GetIndexForCoord(ChildCoord, ChildCoordExtents);
+				CurNodeLink = CurNode->GetChildLink(CoordIdx);
+			}
+			else
+			{
+				return SVO_INVALID_NODELINK;
+			}
+		}
+		else
+		{
+			// This node has no children. If it's open it's the highest resolution link
+			// we can find for this coordinate.
+			return (CurNode->GetNodeState() == ENodeState::Open) ? CurNodeLink : SVO_INVALID_NODELINK;
+		}
+	}
+
+	return SVO_INVALID_NODELINK;
+}
+
+FBox FSparseVoxelOctree::GetBoundsForNode(const FSvoNode& Node) const
+{
+	const FSvoNodeLink NodeLink = Node.GetSelfLink();
+	const FSvoTile* Tile = GetTile(NodeLink.TileID);
+	check(Tile);
+
+	const FVector NodeLocation = GetLocationForNode(Node, *Tile);
+
+	const float NodeResolution = Config.GetResolutionForLayer(NodeLink.LayerIdx);
+	return FBox::BuildAABB(NodeLocation, FVector(NodeResolution * 0.5f));
+}
+
+bool FSparseVoxelOctree::GetBoundsForLink(const FSvoNodeLink& Link, FBox& OutBounds) const
+{
+	if (Link.IsValid())
+	{
+		// Ensure the bounds are zeroed out
+		OutBounds.Init();
+
+		FVector NodeLocation;
+		if (GetLocationForLink(Link, NodeLocation))
+		{
+			const float NodeResolution = Config.GetResolutionForLink(Link);
+			OutBounds = FBox::BuildAABB(NodeLocation, FVector(NodeResolution * 0.5f));
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FSparseVoxelOctree::GetVoxelCoordBoundsForLink(const FSvoNodeLink& Link, FIntVector& OutMinCoord, FIntVector& OutMaxCoord) const
+{
+	if (!Link.IsValid())
+	{
+		return false;
+	}
+
+	const uint8 TileLayerIdx = Config.GetTileLayerIndex();
+	const int32 TileVoxels = (SVO_VOXEL_GRID_EXTENT << TileLayerIdx);
+
+	OutMinCoord = FSvoTile::CalcTileCoord(Link.TileID) * TileVoxels;
+
+	if (Link.LayerIdx == TileLayerIdx)
+	{
+		OutMaxCoord = OutMinCoord + FIntVector(TileVoxels);
+		return true;
+	}
+
+	const int32 NodeVoxels = (SVO_VOXEL_GRID_EXTENT << Link.LayerIdx);
+	OutMinCoord += FSvoUtils::MortonToCoord(Link.NodeIdx) * NodeVoxels;
+
+	if (Link.IsVoxelNode())
+	{
+		FIntVector VoxelCoord;
+		FSvoUtils::GetVoxelCoordFromIndex(Link.VoxelIdx, VoxelCoord);
+
+		OutMinCoord += VoxelCoord;
+		OutMaxCoord = OutMinCoord + FIntVector(1);
+	}
+	else
+	{
+		OutMaxCoord = OutMinCoord + FIntVector(NodeVoxels);
+	}
+
+	return true;
+}
+
+void FSparseVoxelOctree::GetFirstChildLocation(FSvoNodeLink NodeLink, ECellOffset Offset, FVector& OutLocation) const
+{
+	// Clear the voxel index so we don't attempt to find the child of a voxel, which isn't
+	// valid.  This means that this effectively finds the first sibling for voxel node
+	// links but ensures that we don't end up with a strange offset.
+	NodeLink.VoxelIdx = SVO_NO_VOXEL;
+
+	// Grab the location for the parent node which we will use in the next step as the
+	// base for finding the child.
+	FVector NodeLocation;
+	GetLocationForLink(NodeLink, NodeLocation);
+
+	Config.GetFirstChildLocation(NodeLocation, NodeLink.LayerIdx, Offset, OutLocation);
+}
+
+FIntVector FSparseVoxelOctree::GetRelativeChildCoord(const FSvoNodeLink& NodeLink, const FVector& Location) const
+{
+	// Get the location of the first child to allow us to find its coords
+	//
+	// NOTE: If the node link is pointing to a voxel, the leaf node will be used.
+	FVector FirstChildLocation;
+	GetFirstChildLocation(NodeLink, ECellOffset::Center, FirstChildLocation);
+
+	// Get the resolution of the child layer of the node
+	const float ChildResolution = Config.GetChildResolutionForLayer(NodeLink.LayerIdx);
+
+	// Get the world-space coordinates of the first child location and the desired
+	// location in terms of the child resolution.
+	const FIntVector FirstChildCoord = Config.LocationToCoord(FirstChildLocation, ChildResolution);
+	const FIntVector LocationCoord = Config.LocationToCoord(Location, ChildResolution);
+
+	// Now find the difference between the two coordinates to determine the relative
+	// coordinate offset from the first child node.
+	//
+	// NOTE: It is expected that this will potentially return an invalid coordinate (e.g.
+	// outside of the bounds of a voxel grid).  It is the onus of the caller to handle
+	// this case.
+	return (LocationCoord - FirstChildCoord);
+}
+
+struct FTileIntersection
+{
+	float MinT;
+	float MaxT;
+	FVector MinLocation;
+	FSvoNodeLink TileNodeLink;
+	FVector TileMinLocation;
+};
+
+struct FTileRaycastInfo
+{
+	FVector RayStart;
+	FVector RayEnd;
+	FVector RaySegment;
+	FVector RayDir;
+	float RayLength;
+
+	FTileIntersection TileInfo;
+
+	// Set to stop at the first blocked node without resolving where it was hit
+	bool bAnyHit = false;
+
+#if !UE_BUILD_SHIPPING
+	// Only raycasts on the game thread step the debug state, since batches may be split
+	// across workers.
+	bool bRecordDebug;
+#endif
+};
+
+bool FSparseVoxelOctree::IsNodeBlockedByObstacle(const FSvoNodeLink& Link) const
+{
+	const FSvoObstacles* ObstaclesPtr = GetObstacles();
+	if (ObstaclesPtr == nullptr)
+	{
+		return false;
+	}
+
+	FBox NodeBounds;
+	return GetBoundsForLink(Link, NodeBounds) && ObstaclesPtr->OverlapsBox(NodeBounds);
+}
+
+bool FSparseVoxelOctree::IsNodeClosedByObstacle(const FSvoNodeLink& Link) const
+{
+	const FSvoObstacles* ObstaclesPtr = GetObstacles();
+	if (ObstaclesPtr == nullptr)
+	{
+		return false;
+	}
+
+	FBox NodeBounds;
+	if (!GetBoundsForLink(Link, NodeBounds))
+	{
+		return false;
+	}
+
+	return Link.IsLeafNode() ? ObstaclesPtr->OverlapsBox(NodeBounds) : ObstaclesPtr->CoversBox(NodeBounds);
+}
+
+uint8 FSparseVoxelOctree::GetClearance(const FSvoNodeLink& Link) const
+{
+	const FSvoTile* Tile = GetTileForLink(Link);
+	return (Tile != nullptr) ? Tile->GetClearance(Link) : MAX_uint8;
+}
+
+uint8 FSparseVoxelOctree::GetArea(const FSvoNodeLink& Link) const
+{
+	const FSvoTile* Tile = GetTileForLink(Link);
+	return (Tile != nullptr) ? Tile->GetArea(Link) : SVO_NO_AREA;
+}
+
+bool FSparseVoxelOctree::Raycast(const FVector& RayStart, const FVector& RayEnd, Gunfire3DNavigation::FRaycastResult& Result) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_Raycast);
+
+	// Runtime obstacles aren't part of the nodes, so find the first one the ray hits and
+	// use whichever hit is closer.
+	float ObstacleHitTime;
+	const FSvoObstacles* ObstaclesPtr = GetObstacles();
+	if (ObstaclesPtr != nullptr && ObstaclesPtr->Raycast(RayStart, RayEnd, ObstacleHitTime))
+	{
+		const FVector ObstacleHitLocation = FMath::Lerp(RayStart, RayEnd, ObstacleHitTime);
+		if (ObstacleHitTime <= 0.f || !RaycastNodes(RayStart, ObstacleHitLocation, Result))
+		{
+			Result.HitTime = ObstacleHitTime;
+			Result.HitLocation = FNavLocation(ObstacleHitLocation, GetLinkForLocation(ObstacleHitLocation).GetID());
+		}
+		else
+		{
+			// The hit was found on the shortened ray, so rescale it to the full one
+			Result.HitTime *= ObstacleHitTime;
+		}
+
+		return true;
+	}
+
+	return RaycastNodes(RayStart, RayEnd, Result);
+}
+
+bool FSparseVoxelOctree::RaycastAnyHit(const FVector& RayStart, const FVector& RayEnd) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_RaycastAnyHit);
+
+	float ObstacleHitTime;
+	const FSvoObstacles* ObstaclesPtr = GetObstacles();
+	if (ObstaclesPtr != nullptr && ObstaclesPtr->Raycast(RayStart, RayEnd, ObstacleHitTime))
+	{
+		return true;
+	}
+
+	Gunfire3DNavigation::FRaycastResult Result;
+	return RaycastNodes(RayStart, RayEnd, Result, true /* bAnyHit */);
+}
+
+bool FSparseVoxelOctree::RaycastNodes(const FVector& RayStart, const FVector& RayEnd, Gunfire3DNavigation::FRaycastResult& Result, bool bAnyHit) const
+{
+	// Initialize to the end to represent no point found.
+	Result.HitLocation.Location = FNavLocation(RayEnd, SVO_INVALID_NODELINK);
+
+	// If the tree hasn't been generated, bail
+	if (!IsValid())
+	{
+		return false;
+	}
+
+	// Setup a few ray helpers
+	FTileRaycastInfo Info;
+	Info.RayStart = RayStart;
+	Info.RayEnd = RayEnd;
+	Info.RaySegment = (RayEnd - RayStart);
+	Info.RayDir = Info.RaySegment.GetSafeNormal();
+	Info.RayLength = Info.RaySegment.Size();
+	Info.bAnyHit = bAnyHit;
+
+#if !UE_BUILD_SHIPPING
+	Info.bRecordDebug = !bAnyHit && IsInGameThread();
+	if (Info.bRecordDebug)
+	{
+		RaycastDebug.NumSteps = 0;
+		RaycastDebug.State = EDebugState::Error;
+	}
+#endif
+
+	// Walk the tile grid along the ray (Amanatides & Woo), so tiles are visited in the
+	// order the ray passes through them and the walk can stop at the first hit.
+	const float TileResolution = Config.GetTileResolution();
+	const FIntVector EndCoord = Config.LocationToCoord(RayEnd, TileResolution);
+	FIntVector TileCoord = Config.LocationToCoord(RayStart, TileResolution);
+	const FBox StartTileBounds = Config.GetTileBounds(TileCoord);
+
+	FIntVector Step;
+	FVector NextT, DeltaT;
+	for (int32 AxisIdx = 0; AxisIdx < 3; ++AxisIdx)
+	{
+		const float Dir = Info.RayDir[AxisIdx];
+		if (Dir > 0.f)
+		{
+			Step[AxisIdx] = 1;
+			NextT[AxisIdx] = (StartTileBounds.Max[AxisIdx] - RayStart[AxisIdx]) / Dir;
+			DeltaT[AxisIdx] = TileResolution / Dir;
+		}
+		else if (Dir < 0.f)
+		{
+			Step[AxisIdx] = -1;
+			NextT[AxisIdx] = (StartTileBounds.Min[AxisIdx] - RayStart[AxisIdx]) / Dir;
+			DeltaT[AxisIdx] = -TileResolution / Dir;
+		}
+		else
+		{
+			Step[AxisIdx] = 0;
+			NextT[AxisIdx] = MAX_flt;
+			DeltaT[AxisIdx] = MAX_flt;
+		}
+	}
+
+	// The walk can never cross more tiles than lie between the end points, which also
+	// guards against stepping forever on degenerate rays.
+	const FIntVector CoordDelta = EndCoord - TileCoord;
+	int32 NumStepsLeft = FMath::Abs(CoordDelta.X) + FMath::Abs(CoordDelta.Y) + FMath::Abs(CoordDelta.Z) + 1;
+
+	while (NumStepsLeft-- > 0)
+	{
+		if (const FSvoTile* Tile = GetTileAtCoord(TileCoord))
+		{
+			const FBox TileBounds = Config.GetTileBounds(TileCoord);
+
+			float TileMinT, TileMaxT;
+			if (FGunfire3DNavigationUtils::RayAABBIntersect(RayStart, Info.RayDir, TileBounds, TileMinT, TileMaxT))
+			{
+				// The intersection test can return parameter outside of the line segment
+				// we're testing so clamp them here.
+				TileMinT = FMath::Max(kRaycastEpsilon, TileMinT + kRaycastEpsilon);
+				TileMaxT = FMath::Clamp(TileMaxT - kRaycastEpsilon, kRaycastEpsilon, Info.RayLength);
+
+				if (TileMaxT > 0.0f && (TileMaxT - TileMinT) > kRaycastEpsilon)
+				{
+					const FVector MinLocation = RayStart + (Info.RayDir * TileMinT);
+					Info.TileInfo = { TileMinT, TileMaxT, MinLocation, Tile->GetSelfLink(), TileBounds.Min };
+
+					// If this returns true we got a hit in this tile and we're done.
+					// Otherwise, continue into the next tile.
+					if (RaycastTile(Info, Result))
+					{
+						return true;
+					}
+				}
+			}
+		}
+
+		// Step into the next tile along whichever axis the ray leaves through first
+		const int32 AxisIdx = (NextT.X < NextT.Y) ? ((NextT.X < NextT.Z) ? 0 : 2) : ((NextT.Y < NextT.Z) ? 1 : 2);
+		if (NextT[AxisIdx] > Info.RayLength)
+		{
+			break;
+		}
+
+		TileCoord[AxisIdx] += Step[AxisIdx];
+		NextT[AxisIdx] += DeltaT[AxisIdx];
+	}
+
+	return false;
+}
+
+bool FSparseVoxelOctree::RaycastTileIntersections(const FVector& RayStart, const FVector& RayEnd, TArrayView<FTileIntersection> TileIntersections, Gunfire3DNavigation::FRaycastResult& Result) const
+{
+	// Sort intersections by distance along the ray
+	Algo::Sort(TileIntersections, [](const FTileIntersection& A, const FTileIntersection& B)
+	{
+		return A.MinT < B.MinT;
+	});
+
+	FTileRaycastInfo Info;
+	Info.RayStart = RayStart;
+	Info.RayEnd = RayEnd;
+	Info.RaySegment = (RayEnd - RayStart);
+	Info.RayDir = Info.RaySegment.GetSafeNormal();
+	Info.RayLength = Info.RaySegment.Size();
+
+#if !UE_BUILD_SHIPPING
+	Info.bRecordDebug = IsInGameThread();
+	if (Info.bRecordDebug)
+	{
+		RaycastDebug.NumSteps = 0;
+		RaycastDebug.State = EDebugState::Error;
+	}
+#endif
+
+	// Test the ray against each tile.
+	for (const FTileIntersection& TileIntersection : TileIntersections)
+	{
+		Info.TileInfo = TileIntersection;
+
+		// If this returns true we got a hit in this tile and we're done. Otherwise,
+		// continue into the next tile.
+		if (RaycastTile(Info, Result))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+namespace SvoSweep
+{
+	// Sweeps are tested as overlaps spaced this fraction of the radius apart, which keeps
+	// the gaps between samples to a few percent of the radius.
+	constexpr float StepScale = 0.5f;
+
+	// Limits the number of overlaps tested for long sweeps of small shapes
+	constexpr int32 MaxSteps = 1024;
+
+	// Returns true if the box is closer than 'Radius' to the vertical segment through
+	// 'Location'. Touching the box doesn't count.
+	bool CapsuleOverlapsBox(const FVector& Location, float Radius, float SegmentHalfHeight, const FBox& Box)
+	{
+		const float DistX = FMath::Max3(Box.Min.X - Location.X, 0.f, Location.X - Box.Max.X);
+		const float DistY = FMath::Max3(Box.Min.Y - Location.Y, 0.f, Location.Y - Box.Max.Y);
+		const float DistZ = FMath::Max3(Box.Min.Z - (Location.Z + SegmentHalfHeight), 0.f, (Location.Z - SegmentHalfHeight) - Box.Max.Z);
+		return (FMath::Square(DistX) + FMath::Square(DistY) + FMath::Square(DistZ)) < FMath::Square(Radius);
+	}
+}
+
+bool FSparseVoxelOctree::SweepCapsule(const FVector& Start, const FVector& End, float Radius, float HalfHeight, Gunfire3DNavigation::FRaycastResult& Result) const
+{
+	using namespace SvoSweep;
+
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_Sweep);
+
+	// Initialize to the end to represent no point found.
+	Result.HitLocation.Location = End;
+
+	if (!ensure(Radius > 0.f) || !IsValid())
+	{
+		return false;
+	}
+
+	const float SweepLength = FVector::Dist(Start, End);
+	const int32 NumSteps = FMath::Clamp(FMath::CeilToInt(SweepLength / (Radius * StepScale)), 1, MaxSteps);
+
+	float LastClearTime = 0.f;
+	for (int32 StepIdx = 0; StepIdx <= NumSteps; ++StepIdx)
+	{
+		const float Time = (float)StepIdx / NumSteps;
+		const FVector Location = FMath::Lerp(Start, End, Time);
+
+		if (OverlapCapsule(Location, Radius, HalfHeight))
+		{
+			const FVector HitLocation = FMath::Lerp(Start, End, LastClearTime);
+			Result.HitTime = LastClearTime;
+			Result.HitLocation = FNavLocation(HitLocation, GetLinkForLocation(HitLocation).GetID());
+			return true;
+		}
+
+		LastClearTime = Time;
+	}
+
+	return false;
+}
+
+bool FSparseVoxelOctree::OverlapCapsule(const FVector& Location, float Radius, float HalfHeight) const
+{
+	const FVector Extent(Radius, Radius, FMath::Max(HalfHeight, Radius));
+	const FBox CapsuleBounds(Location - Extent, Location + Extent);
+	const float SegmentHalfHeight = Extent.Z - Radius;
+
+	// Obstacles are only tested against the capsule's bounds
+	const FSvoObstacles* ObstaclesPtr = GetObstacles();
+	if (ObstaclesPtr != nullptr && ObstaclesPtr->OverlapsBox(CapsuleBounds))
+	{
+		return true;
+	}
+
+	bool bOverlaps = false;
+	GetTilesInBounds(CapsuleBounds, [&](const FSvoTile& Tile)
+	{
+		bOverlaps = NodeOverlapsCapsule(Tile.GetSelfLink(), Location, Radius, SegmentHalfHeight);
+		return !bOverlaps;
+	});
+
+	return bOverlaps;
+}
+
+bool FSparseVoxelOctree::NodeOverlapsCapsule(const FSvoNodeLink& NodeLink, const FVector& Location, float Radius, float SegmentHalfHeight) const
+{
+	using namespace SvoSweep;
+
+	const FSvoNode* Node = GetNodeFromLink(NodeLink);
+	FBox NodeBounds;
+	if (Node == nullptr || !GetBoundsForLink(NodeLink, NodeBounds) || !CapsuleOverlapsBox(Location, Radius, SegmentHalfHeight, NodeBounds))
+	{
+		return false;
+	}
+
+	switch (Node->GetNodeState())
+	{
+	case ENodeState::Open:
+		return false;
+
+	case ENodeState::Blocked:
+		return true;
+
+	default:
+		break;
+	}
+
+	// Test each blocked voxel of a partially blocked leaf
+	if (NodeLink.IsLeafNode())
+	{
+		const float VoxelSize = Config.GetVoxelSize();
+		for (uint8 VoxelIdx = 0; VoxelIdx < 64; ++VoxelIdx)
+		{
+			if (Node->IsVoxelBlocked(VoxelIdx))
+			{
+				FIntVector VoxelCoord;
+				FSvoUtils::GetVoxelCoordFromIndex(VoxelIdx, VoxelCoord);
+
+				const FVector VoxelMin = NodeBounds.Min + FVector(VoxelCoord) * VoxelSize;
+				if (CapsuleOverlapsBox(Location, Radius, SegmentHalfHeight, FBox(VoxelMin, VoxelMin + FVector(VoxelSize))))
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	for (uint8 ChildIdx = 0; ChildIdx < 8; ++ChildIdx)
+	{
+		if (NodeOverlapsCapsule(Node->GetChildLink(ChildIdx), Location, Radius, SegmentHalfHeight))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+namespace SvoRaycastPacket
+{
+	// Number of rays traversed together, one per SIMD lane
+	constexpr int32 PacketSize = 4;
+
+	// A packet's tile range may cover at most this many times the tiles its rays would
+	// have looked at on their own, otherwise the rays aren't coherent enough to share.
+	constexpr int64 MaxTileRangeGrowth = 2;
+
+	int64 GetNumCoords(const FIntVector& MinCoord, const FIntVector& MaxCoord)
+	{
+		const FIntVector Count = (MaxCoord - MinCoord) + FIntVector(1);
+		return (int64)Count.X * Count.Y * Count.Z;
+	}
+
+	// Intersects one slab of a box with every ray in the packet
+	FORCEINLINE void SlabTest(const VectorRegister4Float& BoundsMin, const VectorRegister4Float& BoundsMax, const VectorRegister4Float& Origin, const VectorRegister4Float& InvDir, const VectorRegister4Float& Parallel, const VectorRegister4Float& Lowest, const VectorRegister4Float& Highest, VectorRegister4Float& OutMinT, VectorRegister4Float& OutMaxT)
+	{
+		const VectorRegister4Float T1 = VectorMultiply(VectorSubtract(BoundsMin, Origin), InvDir);
+		const VectorRegister4Float T2 = VectorMultiply(VectorSubtract(BoundsMax, Origin), InvDir);
+		OutMinT = VectorSelect(Parallel, Lowest, VectorMin(T1, T2));
+		OutMaxT = VectorSelect(Parallel, Highest, VectorMax(T1, T2));
+	}
+}
+
+bool FSparseVoxelOctree::MoveAlongOpenSpace(const FSvoNodeLink& StartLink, const FVector& Start, const FVector& Target, FVector& OutLocation, FSvoNodeLink& OutLink) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_MoveAlongOpenSpace);
+
+	// Moves are meant to be short, so rather than searching this just follows the
+	// segment from node to node and gives up if it takes too long.
+	static constexpr int32 MaxSteps = 64;
+
+	if (!StartLink.IsValid())
+	{
+		return false;
+	}
+
+	// How far across a face the node on the other side is looked up, so the point used
+	// isn't on the boundary of both
+	const FVector::FReal FaceOffset = Config.GetVoxelSize() * 0.01f;
 
-		ensure(CurNode->GetSelfLink() == CurNodeLink);
+	const bool bHasObstacles = (GetObstacles() != nullptr);
 
-		// If at the leaf layer we either:
-		//	Return an invalid link id if fully blocked.
-		//	Search for the overlapping voxel and return its state
-		if (CurNodeLink.IsLeafNode())
+	FSvoNodeLink CurLink = StartLink;
+	FVector CurLocation = Start;
+	FVector CurTarget = Target;
+
+	for (int32 Step = 0; Step < MaxSteps; ++Step)
+	{
+		FBox Bounds;
+		if (!GetBoundsForLink(CurLink, Bounds))
 		{
-			FVector VoxelLocation;
+			break;
+		}
 
-			if (CurNode->GetNodeState() == ENodeState::Open)
+		if (Bounds.IsInsideOrOn(CurTarget))
+		{
+			CurLocation = CurTarget;
+			break;
+		}
+
+		// Find the face of the node the rest of the move leaves through
+		const FVector Delta = CurTarget - CurLocation;
+
+		int32 ExitAxis = INDEX_NONE;
+		FVector::FReal ExitTime = 1.0;
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (FMath::IsNearlyZero(Delta[Axis]))
 			{
-				return CurNode->GetSelfLink();
+				continue;
 			}
-			else if (CurNode->GetNodeState() == ENodeState::Blocked)
+
+			const FVector::FReal FacePos = (Delta[Axis] > 0.0) ? Bounds.Max[Axis] : Bounds.Min[Axis];
+			const FVector::FReal Time = FMath::Max<FVector::FReal>((FacePos - CurLocation[Axis]) / Delta[Axis], 0.0);
+
+			if (Time < ExitTime)
 			{
-				// If we're returning blocked nodes, since this one is fully blocked the
-				// highest resolution node is the leaf.
-				if (AllowBlocked)
-				{
-					return CurNode->GetSelfLink();
-				}
-				// If fully blocked, no voxel will be valid so return an invalid link
-				else
-				{
-					return SVO_INVALID_NODELINK;
-				}
+				ExitTime = Time;
+				ExitAxis = Axis;
 			}
-			else
-			{
-				// Knowing that the location is within the bounds of this leaf node, we
-				// can deduce the voxel location easily via coords.
-				FIntVector VoxelCoord = GetRelativeChildCoord(CurNodeLink, Location);
+		}
 
-				// This can happen due to floating point errors.  To fix this, we just
-				// increment the negative values by one.
-				// NOTE: There should *never* be an error greater than 1!
-				if (!FSvoUtils::IsVoxelCoordValid(VoxelCoord))
-				{
-					if (VoxelCoord.X < 0) ++VoxelCoord.X;
-					if (VoxelCoord.Y < 0) ++VoxelCoord.Y;
-					if (VoxelCoord.Z < 0) ++VoxelCoord.Z;
+		// The target is only outside the node by floating point error
+		if (ExitAxis == INDEX_NONE)
+		{
+			break;
+		}
 
-					// The voxel coord should definitely be valid at this point
-					ensure(FSvoUtils::IsVoxelCoordValid(VoxelCoord));
-				}
+		const bool bExitPositive = (Delta[ExitAxis] > 0.0);
 
-				CurNodeLink.VoxelIdx = FSvoUtils::GetVoxelIndexForCoord(VoxelCoord);
+		FVector ExitLocation = (CurLocation + (Delta * ExitTime)).ComponentMax(Bounds.Min).ComponentMin(Bounds.Max);
+		ExitLocation[ExitAxis] = bExitPositive ? Bounds.Max[ExitAxis] : Bounds.Min[ExitAxis];
 
-				const bool bVoxelIsBlocked = CurNode->IsVoxelBlocked(CurNodeLink.VoxelIdx);
+		FVector ProbeLocation = ExitLocation;
+		ProbeLocation[ExitAxis] += bExitPositive ? FaceOffset : -FaceOffset;
 
-				if (!bVoxelIsBlocked || AllowBlocked)
-				{
-					return CurNodeLink;
-				}
-				else
-				{
-					return SVO_INVALID_NODELINK;
-				}
-			}
+		// Voxels have no neighbor links of their own, so moves between voxels of the
+		// same leaf are found from the leaf, and the rest through its neighbor.
+		const FSvoNode* CurNode = GetNodeFromLink(CurLink);
+		if (!ensure(CurNode))
+		{
+			break;
 		}
-		// If at a normal layer, we either:
-		//		a.) Descend to the next layer if children exist
-		//		b.) Return this node for it is just open space
-		else if (CurNode->GetNodeState() == ENodeState::PartiallyBlocked)
+
+		FSvoNodeLink NextLink = SVO_INVALID_NODELINK;
+
+		if (CurLink.IsVoxelNode() && GetBoundsForNode(*CurNode).IsInside(ProbeLocation))
 		{
-			static const FIntVector ChildCoordExtents(SVO_OCTANT_GRID_EXTENT);
+			NextLink = GetLinkForLocationInNode(CurLink, ProbeLocation);
+		}
+		else
+		{
+			const ESvoNeighbor Neighbor = (ESvoNeighbor)(ExitAxis + (bExitPositive ? 0 : 3));
+			const FSvoNodeLink NeighborLink = CurNode->GetNeighborLink(*this, Neighbor);
 
-			const FIntVector ChildCoord = GetRelativeChildCoord(CurNodeLink, Location);
-			if (ensure(FSvoUtils::IsCoordValid(ChildCoord, ChildCoordExtents)))
-			{
-				const uint32 CoordIdx = FSvoUtils::GetIndexForCoord(ChildCoord, ChildCoordExtents);
-				CurNodeLink = CurNode->GetChildLink(CoordIdx);
-			}
-			else
+			if (NeighborLink.IsValid())
 			{
-				return SVO_INVALID_NODELINK;
+				NextLink = GetLinkForLocationInNode(NeighborLink, ProbeLocation);
 			}
 		}
+
+		if (NextLink.IsValid() && !(bHasObstacles && IsNodeBlockedByObstacle(NextLink)))
+		{
+			CurLink = NextLink;
+			CurLocation = ExitLocation;
+		}
 		else
 		{
-			// This node has no children. If it's open it's the highest resolution link
-			// we can find for this coordinate.
-			return (CurNode->GetNodeState() == ENodeState::Open) ? CurNodeLink : SVO_INVALID_NODELINK;
+			// The face is blocked, so drop the part of the move into it and slide along
+			// the face with what's left. Each slide removes an axis, so this can't get
+			// stuck sliding.
+			CurLocation = ExitLocation;
+			CurTarget[ExitAxis] = ExitLocation[ExitAxis];
 		}
 	}
 
-	return SVO_INVALID_NODELINK;
+	OutLocation = CurLocation;
+	OutLink = CurLink;
+
+	return true;
 }
 
-FBox FSparseVoxelOctree::GetBoundsForNode(const FSvoNode& Node) const
+void FSparseVoxelOctree::BatchRaycast(TArrayView<const FVector> RayStarts, TArrayView<const FVector> RayEnds, TArrayView<Gunfire3DNavigation::FRaycastResult> OutResults) const
 {
-	const FSvoNodeLink NodeLink = Node.GetSelfLink();
-	const FSvoTile* Tile = GetTile(NodeLink.TileID);
-	check(Tile);
+	using namespace SvoRaycastPacket;
 
-	const FVector NodeLocation = GetLocationForNode(Node, *Tile);
+	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_BatchRaycast);
 
-	const float NodeResolution = Config.GetResolutionForLayer(NodeLink.LayerIdx);
-	return FBox::BuildAABB(NodeLocation, FVector(NodeResolution * 0.5f));
-}
+	check(RayStarts.Num() == RayEnds.Num() && RayStarts.Num() == OutResults.Num());
 
-bool FSparseVoxelOctree::GetBoundsForLink(const FSvoNodeLink& Link, FBox& OutBounds) const
-{
-	if (Link.IsValid())
-	{
-		// Ensure the bounds are zeroed out
-		OutBounds.Init();
+	const int32 NumRays = RayStarts.Num();
 
-		FVector NodeLocation;
-		if (GetLocationForLink(Link, NodeLocation))
+	// Obstacles aren't part of the tiles, so leave those rays to the regular raycast
+	if (!IsValid() || GetObstacles() != nullptr)
+	{
+		for (int32 RayIdx = 0; RayIdx < NumRays; ++RayIdx)
 		{
-			const float NodeResolution = Config.GetResolutionForLink(Link);
-			OutBounds = FBox::BuildAABB(NodeLocation, FVector(NodeResolution * 0.5f));
-
-			return true;
+			Raycast(RayStarts[RayIdx], RayEnds[RayIdx], OutResults[RayIdx]);
 		}
+
+		return;
 	}
 
-	return false;
-}
+	const float TileResolution = Config.GetTileResolution();
+	const FVector& SeedLocation = Config.GetSeedLocation();
 
-void FSparseVoxelOctree::GetFirstChildLocation(FSvoNodeLink NodeLink, ECellOffset Offset, FVector& OutLocation) const
-{
-	// Clear the voxel index so we don't attempt to find the child of a voxel, which isn't
-	// valid.  This means that this effectively finds the first sibling for voxel node
-	// links but ensures that we don't end up with a strange offset.
-	NodeLink.VoxelIdx = SVO_NO_VOXEL;
+	// Scratch space reused by every packet
+	TArray<FTileIntersection, TInlineAllocator<16>> RayTileIntersections[PacketSize];
+	TArray<const FSvoTile*, TInlineAllocator<32>> PacketTiles;
 
-	// Grab the location for the parent node which we will use in the next step as the
-	// base for finding the child.
-	FVector NodeLocation;
-	GetLocationForLink(NodeLink, NodeLocation);
+	int32 RayIdx = 0;
+	while (RayIdx < NumRays)
+	{
+		// Grow the packet with the following rays for as long as they stay close enough
+		// to share the tiles they test against.
+		FIntVector PacketMinCoord, PacketMaxCoord;
+		FSvoUtils::GetCoordsForBounds(SeedLocation, FBox(ForceInit) + RayStarts[RayIdx] + RayEnds[RayIdx], TileResolution, PacketMinCoord, PacketMaxCoord);
+		int64 NumRayCoords = GetNumCoords(PacketMinCoord, PacketMaxCoord);
+
+		int32 NumPacketRays = 1;
+		while (NumPacketRays < PacketSize && (RayIdx + NumPacketRays) < NumRays)
+		{
+			const int32 NextRayIdx = RayIdx + NumPacketRays;
 
-	Config.GetFirstChildLocation(NodeLocation, NodeLink.LayerIdx, Offset, OutLocation);
-}
+			FIntVector RayMinCoord, RayMaxCoord;
+			FSvoUtils::GetCoordsForBounds(SeedLocation, FBox(ForceInit) + RayStarts[NextRayIdx] + RayEnds[NextRayIdx], TileResolution, RayMinCoord, RayMaxCoord);
 
-FIntVector FSparseVoxelOctree::GetRelativeChildCoord(const FSvoNodeLink& NodeLink, const FVector& Location) const
-{
-	// Get the location of the first child to allow us to find its coords
-	//
-	// NOTE: If the node link is pointing to a voxel, the leaf node will be used.
-	FVector FirstChildLocation;
-	GetFirstChildLocation(NodeLink, ECellOffset::Center, FirstChildLocation);
+			const FIntVector GrownMinCoord = FIntVector(FMath::Min(PacketMinCoord.X, RayMinCoord.X), FMath::Min(PacketMinCoord.Y, RayMinCoord.Y), FMath::Min(PacketMinCoord.Z, RayMinCoord.Z));
+			const FIntVector GrownMaxCoord = FIntVector(FMath::Max(PacketMaxCoord.X, RayMaxCoord.X), FMath::Max(PacketMaxCoord.Y, RayMaxCoord.Y), FMath::Max(PacketMaxCoord.Z, RayMaxCoord.Z));
+			const int64 GrownNumRayCoords = NumRayCoords + GetNumCoords(RayMinCoord, RayMaxCoord);
+			if (GetNumCoords(GrownMinCoord, GrownMaxCoord) > GrownNumRayCoords * MaxTileRangeGrowth)
+			{
+				break;
+			}
 
-	// Get the resolution of the child layer of the node
-	const float ChildResolution = Config.GetChildResolutionForLayer(NodeLink.LayerIdx);
+			PacketMinCoord = GrownMinCoord;
+			PacketMaxCoord = GrownMaxCoord;
+			NumRayCoords = GrownNumRayCoords;
+			++NumPacketRays;
+		}
 
-	// Get the world-space coordinates of the first child location and the desired
-	// location in terms of the child resolution.
-	const FIntVector FirstChildCoord = Config.LocationToCoord(FirstChildLocation, ChildResolution);
-	const FIntVector LocationCoord = Config.LocationToCoord(Location, ChildResolution);
+		// A lone ray gains nothing from the packet
+		if (NumPacketRays == 1)
+		{
+			RaycastNodes(RayStarts[RayIdx], RayEnds[RayIdx], OutResults[RayIdx]);
+			++RayIdx;
+			continue;
+		}
 
-	// Now find the difference between the two coordinates to determine the relative
-	// coordinate offset from the first child node.
-	//
-	// NOTE: It is expected that this will potentially return an invalid coordinate (e.g.
-	// outside of the bounds of a voxel grid).  It is the onus of the caller to handle
-	// this case.
-	return (LocationCoord - FirstChildCoord);
-}
+		// Load the packet into SIMD lanes, one component per register. Unused lanes
+		// repeat the first ray and are ignored.
+		alignas(16) float OriginX[PacketSize], OriginY[PacketSize], OriginZ[PacketSize];
+		alignas(16) float InvDirX[PacketSize], InvDirY[PacketSize], InvDirZ[PacketSize];
+		alignas(16) float ParallelX[PacketSize], ParallelY[PacketSize], ParallelZ[PacketSize];
+		FVector RayDirs[PacketSize];
+		float RayLengths[PacketSize];
 
-struct FTileIntersection
-{
-	float MinT;
-	float MaxT;
-	FVector MinLocation;
-	FSvoNodeLink TileNodeLink;
-	FVector TileMinLocation;
-};
+		for (int32 LaneIdx = 0; LaneIdx < PacketSize; ++LaneIdx)
+		{
+			const int32 LaneRayIdx = RayIdx + ((LaneIdx < NumPacketRays) ? LaneIdx : 0);
+			const FVector RaySegment = (RayEnds[LaneRayIdx] - RayStarts[LaneRayIdx]);
+			RayDirs[LaneIdx] = RaySegment.GetSafeNormal();
+			RayLengths[LaneIdx] = RaySegment.Size();
+
+			OriginX[LaneIdx] = RayStarts[LaneRayIdx].X;
+			OriginY[LaneIdx] = RayStarts[LaneRayIdx].Y;
+			OriginZ[LaneIdx] = RayStarts[LaneRayIdx].Z;
+
+			// Like RayAABBIntersect, slabs the ray runs parallel to don't constrain it
+			const FVector& Dir = RayDirs[LaneIdx];
+			InvDirX[LaneIdx] = (Dir.X != 0.f) ? 1.f / Dir.X : 0.f;
+			InvDirY[LaneIdx] = (Dir.Y != 0.f) ? 1.f / Dir.Y : 0.f;
+			InvDirZ[LaneIdx] = (Dir.Z != 0.f) ? 1.f / Dir.Z : 0.f;
+			ParallelX[LaneIdx] = (Dir.X != 0.f) ? 0.f : 1.f;
+			ParallelY[LaneIdx] = (Dir.Y != 0.f) ? 0.f : 1.f;
+			ParallelZ[LaneIdx] = (Dir.Z != 0.f) ? 0.f : 1.f;
+
+			RayTileIntersections[LaneIdx].Reset();
+		}
 
-struct FTileRaycastInfo
-{
-	FVector RayStart;
-	FVector RayEnd;
-	FVector RaySegment;
-	FVector RayDir;
-	float RayLength;
+		const VectorRegister4Float VecOriginX = VectorLoadAligned(OriginX);
+		const VectorRegister4Float VecOriginY = VectorLoadAligned(OriginY);
+		const VectorRegister4Float VecOriginZ = VectorLoadAligned(OriginZ);
+		const VectorRegister4Float VecInvDirX = VectorLoadAligned(InvDirX);
+		const VectorRegister4Float VecInvDirY = VectorLoadAligned(InvDirY);
+		const VectorRegister4Float VecInvDirZ = VectorLoadAligned(InvDirZ);
+		const VectorRegister4Float VecZero = VectorZeroFloat();
+		const VectorRegister4Float VecParallelX = VectorCompareGT(VectorLoadAligned(ParallelX), VecZero);
+		const VectorRegister4Float VecParallelY = VectorCompareGT(VectorLoadAligned(ParallelY), VecZero);
+		const VectorRegister4Float VecParallelZ = VectorCompareGT(VectorLoadAligned(ParallelZ), VecZero);
+		const VectorRegister4Float VecLowest = VectorSetFloat1(-MAX_flt);
+		const VectorRegister4Float VecHighest = VectorSetFloat1(MAX_flt);
+
+		// Collect the tiles once for the whole packet
+		PacketTiles.Reset();
+		FCoordIterator TileCoordIter(PacketMinCoord, PacketMaxCoord);
+		while (TileCoordIter)
+		{
+			if (const FSvoTile* Tile = GetTileAtCoord(TileCoordIter.GetCoord()))
+			{
+				PacketTiles.Add(Tile);
+			}
 
-	FTileIntersection TileInfo;
-};
+			++TileCoordIter;
+		}
 
-bool FSparseVoxelOctree::Raycast(const FVector& RayStart, const FVector& RayEnd, Gunfire3DNavigation::FRaycastResult& Result) const
-{
-	SCOPE_CYCLE_COUNTER(STAT_FSparseVoxelOctree_Raycast);
+		// Test every ray in the packet against each tile at once
+		for (const FSvoTile* Tile : PacketTiles)
+		{
+			const FBox TileBounds = Config.GetTileBounds(Config.TileCoordToLocation(Tile->GetCoord()));
 
-	// Initialize to the end to represent no point found.
-	Result.HitLocation.Location = FNavLocation(RayEnd, SVO_INVALID_NODELINK);
+			VectorRegister4Float MinTX, MaxTX, MinTY, MaxTY, MinTZ, MaxTZ;
+			SlabTest(VectorSetFloat1(TileBounds.Min.X), VectorSetFloat1(TileBounds.Max.X), VecOriginX, VecInvDirX, VecParallelX, VecLowest, VecHighest, MinTX, MaxTX);
+			SlabTest(VectorSetFloat1(TileBounds.Min.Y), VectorSetFloat1(TileBounds.Max.Y), VecOriginY, VecInvDirY, VecParallelY, VecLowest, VecHighest, MinTY, MaxTY);
+			SlabTest(VectorSetFloat1(TileBounds.Min.Z), VectorSetFloat1(TileBounds.Max.Z), VecOriginZ, VecInvDirZ, VecParallelZ, VecLowest, VecHighest, MinTZ, MaxTZ);
 
-	// If the tree hasn't been generated, bail
-	if (!IsValid())
-	{
-		return false;
-	}
+			const VectorRegister4Float MinT = VectorMax(MinTX, VectorMax(MinTY, MinTZ));
+			const VectorRegister4Float MaxT = VectorMin(MaxTX, VectorMin(MaxTY, MaxTZ));
+			const uint32 HitMask = VectorMaskBits(VectorCompareGT(MaxT, VectorMax(MinT, VecZero))) & ((1u << NumPacketRays) - 1);
+			if (HitMask == 0)
+			{
+				continue;
+			}
 
-	// Setup a few ray helpers
-	const FVector RaySegment = (RayEnd - RayStart);
-	const FVector RayDir = RaySegment.GetSafeNormal();
-	const float RayLength = RaySegment.Size();
-	const FBox RayBounds = FBox(ForceInit) + RayStart + RayEnd;
+			alignas(16) float LaneMinT[PacketSize], LaneMaxT[PacketSize];
+			VectorStoreAligned(MinT, LaneMinT);
+			VectorStoreAligned(MaxT, LaneMaxT);
 
-	TArray<FTileIntersection> TileIntersections;
+			for (int32 LaneIdx = 0; LaneIdx < NumPacketRays; ++LaneIdx)
+			{
+				if ((HitMask & (1u << LaneIdx)) == 0)
+				{
+					continue;
+				}
 
-	// Collect all tile nodes that the ray intersects
-	GetTilesInBounds(RayBounds, [&](const FSvoTile& Tile)
-	{
-		const FVector TileLocation = Config.TileCoordToLocation(Tile.GetCoord());
-		const FBox TileBounds = Config.GetTileBounds(TileLocation);
+				// Clamp to the segment the same way as a single raycast
+				const float TileMinT = FMath::Max(kRaycastEpsilon, LaneMinT[LaneIdx] + kRaycastEpsilon);
+				const float TileMaxT = FMath::Clamp(LaneMaxT[LaneIdx] - kRaycastEpsilon, kRaycastEpsilon, RayLengths[LaneIdx]);
 
-		float TileMinT, TileMaxT;
+				if (TileMaxT > 0.0f && (TileMaxT - TileMinT) > kRaycastEpsilon)
+				{
+					const FVector MinLocation = RayStarts[RayIdx + LaneIdx] + (RayDirs[LaneIdx] * TileMinT);
+					RayTileIntersections[LaneIdx].Add({ TileMinT, TileMaxT, MinLocation, Tile->GetSelfLink(), TileBounds.Min });
+				}
+			}
+		}
 
-		if (FGunfire3DNavigationUtils::RayAABBIntersect(RayStart, RayDir, TileBounds, TileMinT, TileMaxT))
+		// Walk each ray through the tiles it hit
+		for (int32 LaneIdx = 0; LaneIdx < NumPacketRays; ++LaneIdx)
 		{
-			// The intersection test can return parameter outside of the line segment
-			// we're testing so clamp them here.
-			TileMinT = FMath::Max(kRaycastEpsilon, TileMinT + kRaycastEpsilon);
-			TileMaxT = FMath::Clamp(TileMaxT - kRaycastEpsilon, kRaycastEpsilon, RayLength);
+			const int32 LaneRayIdx = RayIdx + LaneIdx;
+			Gunfire3DNavigation::FRaycastResult& Result = OutResults[LaneRayIdx];
+			Result.HitLocation.Location = RayEnds[LaneRayIdx];
 
-			if (TileMaxT > 0.0f && (TileMaxT - TileMinT) > kRaycastEpsilon)
+			if (RayTileIntersections[LaneIdx].Num() > 0)
 			{
-				const FVector MaxLocation = RayStart + (RayDir * TileMaxT);
-				const FVector MinLocation = RayStart + (RayDir * TileMinT);
-
-				TileIntersections.Add({ TileMinT, TileMaxT, MinLocation, Tile.GetSelfLink(), TileBounds.Min });
+				RaycastTileIntersections(RayStarts[LaneRayIdx], RayEnds[LaneRayIdx], RayTileIntersections[LaneIdx], Result);
 			}
 		}
 
-		return true;
-	});
+		RayIdx += NumPacketRays;
+	}
+}
 
-	// If the ray does not intersect a tile volume then there is no intersection
-	if (TileIntersections.Num() == 0)
+bool FSparseVoxelOctree::GetLeafExitVoxel(const FTileRaycastInfo& Info, const FSvoNodeLink& LeafLink, uint8& OutVoxelIdx) const
+{
+	FBox LeafBounds;
+	if (!GetBoundsForLink(LeafLink, LeafBounds))
 	{
 		return false;
 	}
 
-	// Sort intersections by distance along the ray
-	TileIntersections.Sort([](const FTileIntersection& A, const FTileIntersection& B)
+	float LeafMinT, LeafMaxT;
+	if (!FGunfire3DNavigationUtils::RayAABBIntersect(Info.RayStart, Info.RayDir, LeafBounds, LeafMinT, LeafMaxT))
 	{
-		return A.MinT < B.MinT;
-	});
-
-	FTileRaycastInfo Info;
-	Info.RayStart = RayStart;
-	Info.RayEnd = RayEnd;
-	Info.RaySegment = RaySegment;
-	Info.RayDir = RayDir;
-	Info.RayLength = RayLength;
-
-#if !UE_BUILD_SHIPPING
-	RaycastDebug.NumSteps = 0;
-	RaycastDebug.State = EDebugState::Error;
-#endif
+		return false;
+	}
 
-	// Test the ray against each tile.
-	for (const FTileIntersection& TileIntersection : TileIntersections)
-	{
-		Info.TileInfo = TileIntersection;
+	const float ExitT = FMath::Min3(LeafMaxT, Info.TileInfo.MaxT, Info.RayLength);
+	const FVector ExitLocation = Info.RayStart + (Info.RayDir * ExitT);
 
-		// If this returns true we got a hit in this tile and we're done. Otherwise,
-		// continue into the next tile.
-		if (RaycastTile(Info, Result))
-		{
-			return true;
-		}
-	}
+	// The exit is on the surface of the leaf, which may round to the voxel past it
+	FIntVector ExitCoord = GetRelativeChildCoord(LeafLink, ExitLocation);
+	ExitCoord.X = FMath::Clamp(ExitCoord.X, 0, SVO_VOXEL_GRID_EXTENT - 1);
+	ExitCoord.Y = FMath::Clamp(ExitCoord.Y, 0, SVO_VOXEL_GRID_EXTENT - 1);
+	ExitCoord.Z = FMath::Clamp(ExitCoord.Z, 0, SVO_VOXEL_GRID_EXTENT - 1);
 
-	return false;
+	OutVoxelIdx = FSvoUtils::GetVoxelIndexForCoord(ExitCoord);
+	return true;
 }
 
 bool FSparseVoxelOctree::RaycastTile(const FTileRaycastInfo& Info, Gunfire3DNavigation::FRaycastResult& Result) const
@@ -784,7 +2012,7 @@ bool FSparseVoxelOctree::RaycastTile(const FTileRaycastInfo& Info, Gunfire3DNavi
 #if !UE_BUILD_SHIPPING
 	auto DebugRay = [this, &CurNodeLink, &Info, &CurrentRayT, &CurrentRayLocation](EDebugState State)
 	{
-		if (RaycastDebug.DebugStep == (RaycastDebug.NumSteps - 1))
+		if (Info.bRecordDebug && RaycastDebug.DebugStep == (RaycastDebug.NumSteps - 1))
 		{
 			RaycastDebug.State = State;
 			RaycastDebug.RayStart = Info.RayStart;
@@ -799,8 +2027,11 @@ bool FSparseVoxelOctree::RaycastTile(const FTileRaycastInfo& Info, Gunfire3DNavi
 	while (CurNodeLink.IsValid())
 	{
 #if !UE_BUILD_SHIPPING
-		RaycastDebug.NumSteps++;
-		DebugRay(EDebugState::Step);
+		if (Info.bRecordDebug)
+		{
+			RaycastDebug.NumSteps++;
+			DebugRay(EDebugState::Step);
+		}
 #endif
 
 		// We exited the tile bounds without a hit, let the next tile have a try
@@ -871,6 +2102,11 @@ bool FSparseVoxelOctree::RaycastTile(const FTileRaycastInfo& Info, Gunfire3DNavi
 		// If this entire node is blocked we're done, return the hit.
 		if (Node->GetNodeState() == ENodeState::Blocked)
 		{
+			if (Info.bAnyHit)
+			{
+				return true;
+			}
+
 			DebugRay(EDebugState::Hit);
 			Result.HitTime = (CurrentRayT / Info.RayLength);
 			Result.HitLocation.Location = (Info.RayStart + (Info.RayEnd - Info.RayStart) * Result.HitTime);
@@ -901,7 +2137,21 @@ bool FSparseVoxelOctree::RaycastTile(const FTileRaycastInfo& Info, Gunfire3DNavi
 				{
 					// If this coord is valid, then the location lies within this node
 					// so calculate the voxel index.
-					CurNodeLink.VoxelIdx = FSvoUtils::GetVoxelIndexForCoord(VoxelCoord);
+					const uint8 EntryVoxelIdx = FSvoUtils::GetVoxelIndexForCoord(VoxelCoord);
+
+					// Before stepping through the voxels one at a time, check if any of
+					// the ones the ray could cross on its way through the leaf are
+					// blocked. If not, it's treated like an open node.
+					uint8 ExitVoxelIdx;
+					if (GetLeafExitVoxel(Info, CurNodeLink, ExitVoxelIdx) &&
+						!Node->AreAnyVoxelsBlocked(FSvoUtils::GetLeafLineMask(EntryVoxelIdx, ExitVoxelIdx)))
+					{
+						bAdvanceRay = true;
+					}
+					else
+					{
+						CurNodeLink.VoxelIdx = EntryVoxelIdx;
+					}
 				}
 
 				// Continue if we're processing a voxel within this leaf.  Otherwise
@@ -912,6 +2162,11 @@ bool FSparseVoxelOctree::RaycastTile(const FTileRaycastInfo& Info, Gunfire3DNavi
 					// If this voxel is blocked then return the hit
 					if (Node->IsVoxelBlocked(CurNodeLink.VoxelIdx))
 					{
+						if (Info.bAnyHit)
+						{
+							return true;
+						}
+
 						DebugRay(EDebugState::Hit);
 						Result.HitTime = (CurrentRayT / Info.RayLength);
 						Result.HitLocation.Location = (Info.RayStart + (Info.RaySegment * Result.HitTime));
@@ -1134,14 +2389,31 @@ uint32 FSparseVoxelOctree::GetMemUsed() const
 	uint32 MemUsed = sizeof(this);
 
 	MemUsed += Tiles.GetAllocatedSize();
-	for (auto& Tile : Tiles)
+	MemUsed += TileBricks.GetAllocatedSize();
+	MemUsed += TileBrickGrid.GetAllocatedSize();
+	for (const FSvoTile& Tile : Tiles)
 	{
-		MemUsed += Tile.Value.GetMemUsed();
+		MemUsed += Tile.GetMemUsed();
 	}
 
 	return MemUsed;
 }
 
+void FSparseVoxelOctree::GetMemUsage(FMemUsage& OutUsage) const
+{
+	OutUsage = FMemUsage();
+
+	for (const FSvoTile& Tile : Tiles)
+	{
+		Tile.AddLayerMemUsed(OutUsage.LayerMemUsed);
+		OutUsage.CompressedMemUsed += Tile.GetCompressedMemUsed();
+
+		++OutUsage.NumTiles;
+		OutUsage.NumCompressedTiles += (Tile.AreNodesCompressed() && !Tile.AreNodesEvicted()) ? 1 : 0;
+		OutUsage.NumEvictedTiles += Tile.AreNodesEvicted() ? 1 : 0;
+	}
+}
+
 void FSparseVoxelOctree::VerifyNodeData(bool VerifyExternalLinks) const
 {
 	ensureAlways(Tiles.Num() <= MaxTiles);
@@ -1160,5 +2432,6 @@ void FSparseVoxelOctree::VerifyNodeData(bool VerifyExternalLinks) const
 
 		const FIntVector& Coord = Tile.GetCoord();
 		ensure(FSvoTile::CalcTileID(Coord) == Tile.GetID());
+		ensure(GetTileAtCoord(Coord) == &Tile);
 	}
 }
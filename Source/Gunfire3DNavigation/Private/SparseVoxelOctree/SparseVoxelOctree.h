@@ -5,6 +5,9 @@
 #include "SparseVoxelOctreeNode.h"
 #include "SparseVoxelOctreeTile.h"
 #include "SparseVoxelOctreeConfig.h"
+#include "SparseVoxelOctreeLandmarks.h"
+#include "SparseVoxelOctreeObstacles.h"
+#include "SparseVoxelOctreeTileStore.h"
 #include "StatArray.h"
 #include "IteratorHelpers.h"
 
@@ -97,13 +100,37 @@ public:
 	// mostly for debugging.
 	FSvoNodeLink GetLinkForLocation(const FVector& Location, bool AllowBlocked = false) const;
 
+	// Same as GetLinkForLocation, but descends from a node already known to contain the
+	// location instead of from its tile.
+	FSvoNodeLink GetLinkForLocationInNode(const FSvoNodeLink& NodeLink, const FVector& Location, bool AllowBlocked = false) const;
+
+	// Same as GetLinkForLocation, but first checks if the location is in the hinted node
+	// or one of its neighbors, like the node it was in a moment ago. Falls back on the
+	// regular lookup if the hint is stale or the location has moved further than that.
+	FSvoNodeLink GetLinkForLocationNearHint(const FSvoNodeLink& HintLink, const FVector& Location, bool AllowBlocked = false) const;
+
+	// Finds the open node closest to a location in blocked space from a precomputed
+	// index, if the octree keeps one (see FEditableSvo). Returns false if there's no
+	// index or it can't answer for this location, in which case the caller has to search.
+	virtual bool FindNearestOpenLink(const FVector& Origin, const FBox& QueryBounds, FSvoNodeLink& OutLink, FVector& OutClosestPoint) const { return false; }
+
+	// Returns the landmark distances between tiles used to tighten the search heuristic,
+	// if the octree keeps them (see FEditableSvo).
+	virtual FSvoLandmarks::FTablePtr GetLandmarks() const { return nullptr; }
+
 	// Returns the bounds for a node
 	FBox GetBoundsForNode(const FSvoNode& Node) const;
 	bool GetBoundsForLink(const FSvoNodeLink& Link, FBox& OutBounds) const;
 
+	// Returns the bounds for a link in whole voxels, relative to the seed location like
+	// FSvoConfig::LocationToCoord at the voxel size. 'OutMaxCoord' is one past the last
+	// voxel, the coordinate of the max corner. This is worked out from the link alone, so
+	// it stays exact in large worlds and doesn't need the node to be loaded.
+	bool GetVoxelCoordBoundsForLink(const FSvoNodeLink& Link, FIntVector& OutMinCoord, FIntVector& OutMaxCoord) const;
+
 	// Returns a tile by index
-	const FSvoTile* GetTile(uint32 TileID) const { return Tiles.Find(TileID); }
-	FSvoTile* GetTile(uint32 TileID) { return Tiles.Find(TileID); }
+	FORCEINLINE const FSvoTile* GetTile(uint32 TileID) const;
+	FORCEINLINE FSvoTile* GetTile(uint32 TileID);
 
 	// Returns the tile if it exists.  Otherwise, returns nullptr.
 	const FSvoTile* GetTileAtCoord(const FIntVector& Coord) const;
@@ -115,17 +142,35 @@ public:
 	const FSvoTile* GetTileForLink(const FSvoNodeLink& NodeLink) const;
 	FORCEINLINE FSvoTile* GetTileForLink(const FSvoNodeLink& NodeLink);
 
-	typedef FMapValueIterator<TMap<uint32, FSvoTile>, TMap<uint32, FSvoTile>::TRangedForIterator> FTileIterator;
-	typedef FMapValueIterator<const TMap<uint32, FSvoTile>, TMap<uint32, FSvoTile>::TRangedForConstIterator> FTileConstIterator;
+	typedef TSparseArray<FSvoTile> FTileArray;
 
-	// Returns all the active tiles in an iterator you can use with a ranged for
+	// Returns all the active tiles, which you can use with a ranged for
 	//  Ex: for (FSvoTile& CurTile : GetTiles())
-	FTileIterator GetTiles() { return Tiles; }
-	FTileConstIterator GetTiles() const { return Tiles; }
+	FTileArray& GetTiles() { return Tiles; }
+	const FTileArray& GetTiles() const { return Tiles; }
 
 	// Returns the number of active tiles
 	int32 GetNumTiles() const {	return Tiles.Num(); }
 
+	// Compresses the nodes of tiles which haven't been looked up since 'IdleSinceFrame'
+	// (see FSvoTile::CompressNodes). At most 'MaxTilesToCheck' tiles are checked, picking
+	// up where the last call left off. Returns the number of tiles compressed.
+	//
+	// NOTE: Nothing may be reading the octree while this runs.
+	int32 CompressIdleTiles(uint64 IdleSinceFrame, int32 MaxTilesToCheck);
+
+	// Evicts the nodes of tiles farther than 'Radius' from all of 'Locations' to a disk
+	// backed tile store (see FSvoTile::EvictNodes). At most 'MaxTilesToCheck' tiles are
+	// checked, picking up where the last call left off. Returns the number of tiles
+	// evicted.
+	//
+	// NOTE: Nothing may be reading the octree while this runs.
+	int32 EvictDistantTiles(TArrayView<const FVector> Locations, float Radius, int32 MaxTilesToCheck);
+
+	// Collects the IDs of evicted tiles within 'Radius' of any of 'Locations', so they
+	// can be read back in before anything needs them.
+	void GetEvictedTilesNear(TArrayView<const FVector> Locations, float Radius, TArray<uint32>& OutTileIDs) const;
+
 	// Returns the node link for a tile at a given location
 	FSvoNodeLink GetTileLinkAtCoord(const FIntVector& Coord) const;
 	FSvoNodeLink GetTileLinkAtLocation(const FVector& Location) const;
@@ -139,19 +184,102 @@ public:
 	// Calls the given callback for each active tile in the specified bounds
 	void GetTilesInBounds(const FBox& QueryBounds, TFunctionRef<bool(const FSvoTile& CurTile)> TileFunc) const;
 
+	// Sets the runtime obstacles which queries should treat as blocked on top of the
+	// octree's own nodes.
+	void SetObstacles(FSvoObstaclesSharedPtr InObstacles) { Obstacles = InObstacles; }
+
+	// Returns the runtime obstacles, or null if there aren't any to test against
+	const FSvoObstacles* GetObstacles() const { return (Obstacles.IsValid() && !Obstacles->IsEmpty()) ? Obstacles.Get() : nullptr; }
+
+	// Returns true if a runtime obstacle overlaps the node
+	bool IsNodeBlockedByObstacle(const FSvoNodeLink& Link) const;
+
+	// Returns true if runtime obstacles close the node to searches. Leaf nodes and voxels
+	// are closed by any overlap, larger open nodes only once an obstacle covers them (see
+	// FSvoObstacles).
+	bool IsNodeClosedByObstacle(const FSvoNodeLink& Link) const;
+
+	// Returns the clearance of an open node in voxels (see FSvoTile::GetClearance)
+	uint8 GetClearance(const FSvoNodeLink& Link) const;
+
+	// Returns the area code of an open node (see FSvoTile::GetArea)
+	uint8 GetArea(const FSvoNodeLink& Link) const;
+
 	// Casts a ray through the octree, returning true and filling out 'OutT' with the parameter along the ray
 	bool Raycast(const FVector& RayStart, const FVector& RayEnd, Gunfire3DNavigation::FRaycastResult& Result) const;
 
+	// Returns true if anything blocks the segment. Cheaper than Raycast when only line of
+	// sight matters, since it stops at the first blocked node it finds without resolving
+	// the hit.
+	bool RaycastAnyHit(const FVector& RayStart, const FVector& RayEnd) const;
+
+	// Sweeps an upright capsule along the segment, returning true and filling out the hit
+	// with the last location the capsule fit if it touches anything blocked. This allows
+	// clearance beyond what was padded into the voxels to be checked, e.g. for agents
+	// larger than the one the octree was generated for. Use a half height equal to the
+	// radius to sweep a sphere.
+	bool SweepCapsule(const FVector& Start, const FVector& End, float Radius, float HalfHeight, Gunfire3DNavigation::FRaycastResult& Result) const;
+
+	// Returns true if an upright capsule at the location overlaps anything blocked
+	bool OverlapCapsule(const FVector& Location, float Radius, float HalfHeight) const;
+
+	// Moves a point from 'Start' towards 'Target' through open space, walking the
+	// neighbor links from the node it starts in. When the move runs into a blocked face
+	// it slides along it, like a character against a wall. Fills out where the move
+	// ended and the node it ended in, which may stop short of the target if it gets
+	// stuck or takes too many steps. 'StartLink' must be the open node containing
+	// 'Start'.
+	bool MoveAlongOpenSpace(const FSvoNodeLink& StartLink, const FVector& Start, const FVector& Target, FVector& OutLocation, FSvoNodeLink& OutLink) const;
+
+	// Casts a batch of rays, filling out the result at the same index as each ray. Rays
+	// near each other are traversed in packets which share the work of finding the tiles
+	// they cross, so batches should be ordered with nearby rays together.
+	void BatchRaycast(TArrayView<const FVector> RayStarts, TArrayView<const FVector> RayEnds, TArrayView<Gunfire3DNavigation::FRaycastResult> OutResults) const;
+
 	// Returns the amount of memory used by the octree
 	virtual uint32 GetMemUsed() const;
 
+	// Breakdown of the memory used by the tiles
+	struct FMemUsage
+	{
+		// Node pools and the data kept for their nodes, by layer
+		uint32 LayerMemUsed[SVO_MAX_LAYERS] = {};
+
+		// Node pools held compressed while their tiles are cold
+		uint32 CompressedMemUsed = 0;
+
+		int32 NumTiles = 0;
+		int32 NumCompressedTiles = 0;
+		int32 NumEvictedTiles = 0;
+	};
+
+	void GetMemUsage(FMemUsage& OutUsage) const;
+
+	// Frees tiles until the octree uses no more than 'MemBudget' bytes, starting with the
+	// ones farthest from all of 'Locations', or the least recently used without any.
+	// Tiles are compressed first, and only evicted to the tile store once compressing
+	// everything isn't enough. Returns the memory used afterwards, which is still over
+	// budget if nothing more could be freed.
+	//
+	// NOTE: Nothing may be reading the octree while this runs.
+	uint32 ShrinkToBudget(uint32 MemBudget, TArrayView<const FVector> Locations);
+
+	// If false, a full tile pool isn't expanded even if its size isn't fixed, so no more
+	// tiles can be added until some are removed.
+	void SetTilePoolGrowthAllowed(bool bAllowed) { bAllowTilePoolGrowth = bAllowed; }
+
 	// Ensures all node data within the octree is valid
 	void VerifyNodeData(bool VerifyExternalLinks = false) const;
 
 protected:
 	FVector GetLocationForNode(const FSvoNode& Node, const FSvoTile& Tile) const;
 
-	// Links all nodes to their appropriate neighbors for all layers
+	// Descends from a node of a tile to the highest resolution node containing the
+	// location (see GetLinkForLocation)
+	FSvoNodeLink FindLinkForLocationInTile(const FSvoTile& Tile, const FSvoNodeLink& StartLink, const FVector& Location, bool AllowBlocked) const;
+
+	// Links all nodes to their appropriate neighbors for all layers. Each layer is linked
+	// across all tiles in parallel, since a node's links only depend on its parent's.
 	void LinkNeighbors();
 
 	//
@@ -165,6 +293,19 @@ protected:
 	// Links the specified neighbor for a given node
 	void LinkNeighborForNode(const FSvoNodeLink& NodeLink, ESvoNeighbor Neighbor);
 
+	// Returns the link the specified neighbor for a given node should have, without
+	// modifying anything. Only depends on the parent's neighbor links, so it's safe to
+	// call for every node in a layer at once.
+	FSvoNodeLink FindNeighborLinkForNode(const FSvoNodeLink& NodeLink, ESvoNeighbor Neighbor) const;
+
+	// Sets a neighbor link for a given node found with FindNeighborLinkForNode
+	void SetNeighborLinkForNode(const FSvoNodeLink& NodeLink, ESvoNeighbor Neighbor, const FSvoNodeLink& NeighborLink);
+
+	// Links the flagged neighbors for a set of nodes, along with the children of each node
+	// that touch those neighbors. The new links for each layer are found in parallel and
+	// then written in a serial pass, from the lowest resolution layer to the highest.
+	void LinkNeighborsForNodesHierarchically(const TMap<FSvoNodeLink, ESvoNeighborFlags>& Nodes);
+
 	// Links all neighbors for a given node and its children. If bInvalidOnly is true,
 	// only neighbor links that have not yet been assigned will be linked.
 	void LinkNeighborsForNodeHierarchically(const FSvoNodeLink& NodeLink, bool bInvalidOnly);
@@ -198,16 +339,79 @@ protected:
 	// NOTE: If a voxel node link is supplied, its leaf node will be used instead.
 	FIntVector GetRelativeChildCoord(const FSvoNodeLink& NodeLink, const FVector& Location) const;
 
+	// Casts a ray through the nodes of the octree only, ignoring any runtime obstacles
+	bool RaycastNodes(const FVector& RayStart, const FVector& RayEnd, Gunfire3DNavigation::FRaycastResult& Result, bool bAnyHit = false) const;
+
+	// Returns true if a blocked part of the node (or its children) overlaps the capsule
+	bool NodeOverlapsCapsule(const FSvoNodeLink& NodeLink, const FVector& Location, float Radius, float SegmentHalfHeight) const;
+
+	// Casts a ray through the tiles it's known to intersect
+	bool RaycastTileIntersections(const FVector& RayStart, const FVector& RayEnd, TArrayView<struct FTileIntersection> TileIntersections, Gunfire3DNavigation::FRaycastResult& Result) const;
+
 	bool RaycastTile(const struct FTileRaycastInfo& Info, Gunfire3DNavigation::FRaycastResult& Result) const;
 
+	// Finds the voxel the ray leaves a leaf node through, or where it ends if that's
+	// within the leaf. Returns false if the ray misses the leaf.
+	bool GetLeafExitVoxel(const struct FTileRaycastInfo& Info, const FSvoNodeLink& LeafLink, uint8& OutVoxelIdx) const;
+
+	// Returns the slot in 'Tiles' of the tile at a coordinate, or INDEX_NONE
+	FORCEINLINE int32 FindTileSlot(const FIntVector& Coord) const;
+
+	// Adds or removes a tile from the tile index
+	void SetTileSlot(const FIntVector& Coord, int32 Slot);
+
+	// Grows the brick grid of the tile index to include the brick
+	void GrowTileBrickGrid(const FIntVector& BrickCoord);
+
+	// Clears the tile index
+	void ResetTileIndex();
+
 protected:
 	// Configuration that defines this octree
 	FSvoConfig Config;
 
-	// All available tiles
-	TMap<uint32, FSvoTile> Tiles;
+	// Storage for evicted tiles. Declared before the tiles, since they point into it.
+	FSvoTileStoreSharedPtr TileStore;
+
+	// All available tiles. Slots are stable while a tile is active, so the tile index can
+	// refer to them directly.
+	FTileArray Tiles;
 	int32 MaxTiles = 0;
 
+	// See SetTilePoolGrowthAllowed
+	bool bAllowTilePoolGrowth = true;
+
+	// Slot the last call to CompressIdleTiles stopped at
+	int32 ColdTileCursor = 0;
+
+	// Slot the last call to EvictDistantTiles stopped at
+	int32 EvictionCursor = 0;
+
+	///> Tile Index
+	//
+	// Maps tile coordinates to their slot in 'Tiles' with a couple of indexed loads, since
+	// every neighbor step of a query needs a tile lookup. Coordinates are grouped into
+	// bricks of 4x4x4 tiles, and a flat grid over the bounds of the active tiles points
+	// to the brick for each group, so empty space only costs one entry per brick.
+
+	static constexpr int32 TileBrickShift = 2;
+	static constexpr int32 TileBrickMask = (1 << TileBrickShift) - 1;
+
+	struct FTileBrick
+	{
+		int32 Slots[1 << (TileBrickShift * 3)];
+	};
+
+	TArray<FTileBrick> TileBricks;
+
+	// Index into 'TileBricks' for each brick within the grid bounds, or INDEX_NONE
+	TArray<int32> TileBrickGrid;
+	FIntVector TileBrickGridMin = FIntVector::ZeroValue;
+	FIntVector TileBrickGridSize = FIntVector::ZeroValue;
+
+	// Runtime obstacles (see SetObstacles)
+	FSvoObstaclesSharedPtr Obstacles;
+
 	static const float kRaycastEpsilon;
 
 #if !UE_BUILD_SHIPPING
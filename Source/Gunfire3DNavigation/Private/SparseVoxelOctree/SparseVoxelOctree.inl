@@ -7,6 +7,46 @@
 DECLARE_CYCLE_STAT(TEXT("QueryNodes (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_QueryNodes, STATGROUP_Gunfire3DNavigation);
 DECLARE_CYCLE_STAT(TEXT("GetAllActiveTileCoords (FSparseVoxelOctree)"), STAT_FSparseVoxelOctree_GetAllActiveTileCoords, STATGROUP_Gunfire3DNavigation);
 
+int32 FSparseVoxelOctree::FindTileSlot(const FIntVector& Coord) const
+{
+	const FIntVector BrickCoord(Coord.X >> TileBrickShift, Coord.Y >> TileBrickShift, Coord.Z >> TileBrickShift);
+	const FIntVector GridCoord = BrickCoord - TileBrickGridMin;
+
+	// Negative coordinates wrap around to large unsigned values, so one compare per axis
+	// covers both ends of the grid.
+	if ((uint32)GridCoord.X >= (uint32)TileBrickGridSize.X ||
+		(uint32)GridCoord.Y >= (uint32)TileBrickGridSize.Y ||
+		(uint32)GridCoord.Z >= (uint32)TileBrickGridSize.Z)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 BrickIdx = TileBrickGrid[GridCoord.X + TileBrickGridSize.X * (GridCoord.Y + TileBrickGridSize.Y * GridCoord.Z)];
+	if (BrickIdx == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 CellIdx = (Coord.X & TileBrickMask) | ((Coord.Y & TileBrickMask) << TileBrickShift) | ((Coord.Z & TileBrickMask) << (TileBrickShift * 2));
+	return TileBricks[BrickIdx].Slots[CellIdx];
+}
+
+const FSvoTile* FSparseVoxelOctree::GetTile(uint32 TileID) const
+{
+	if (TileID == SVO_INVALID_ID)
+	{
+		return nullptr;
+	}
+
+	const int32 Slot = FindTileSlot(FSvoTile::CalcTileCoord(TileID));
+	return (Slot != INDEX_NONE) ? &Tiles[Slot] : nullptr;
+}
+
+FSvoTile* FSparseVoxelOctree::GetTile(uint32 TileID)
+{
+	return MUTABLE_ACCESSOR(FSvoTile*, GetTile(TileID));
+}
+
 const FSvoNode* FSparseVoxelOctree::GetNodeFromLink(const FSvoNodeLink& Link) const
 {
 	const FSvoNode* FoundNode = nullptr;
@@ -41,6 +81,15 @@ const FSvoNode* FSparseVoxelOctree::GetNodeFromLink(const FSvoNodeLink& Link) co
 
 FSvoNode* FSparseVoxelOctree::GetNodeFromLink(const FSvoNodeLink& Link)
 {
+	// Nodes handed out for writing can't be in a shared pool
+	if (Link.IsValid() && Link.LayerIdx != Config.GetTileLayerIndex())
+	{
+		if (FSvoTile* Tile = GetTile(Link.TileID))
+		{
+			Tile->EnsureNodesUnique();
+		}
+	}
+
 	return MUTABLE_ACCESSOR(FSvoNode*, GetNodeFromLink(Link));
 }
 
@@ -18,12 +18,16 @@
 #define SVO_MIN_NODECOORD 0
 // Maximum allowed node coordinate value (64*64*64 = 262,144)
 #define SVO_MAX_NODECOORD 63
+// Number of nav area IDs that can be stored on nodes. Nodes store the ID plus one, so
+// zero can mean the node isn't in any area.
+#define SVO_MAX_AREAS 32
 
 ///> Values signifying invalid or unitialized data
 
 #define SVO_INVALID_ID 0xFFFFFFFF
 #define SVO_INVALID_NODELINK 0xFFFFFFFFFFFFFFFF
 #define SVO_NO_VOXEL 0x7F
+#define SVO_NO_AREA 0
 
 // Masks out the voxel of a Node ID or Link ID
 #define SVO_NODE_VOXEL_MASK 0x000000000FE00000
@@ -33,6 +37,15 @@
 // If set, SVO nodes, tiles, layers, etc. will be verified after various operations
 #define SVO_VERIFY_NODES 0
 
+// If set, Morton codes are encoded and decoded with BMI2 (pdep/pext) when the CPU
+// supports it, picked at startup. Not needed if we're already compiling for BMI2, since
+// libmorton will use it directly.
+#if PLATFORM_CPU_X86_FAMILY && PLATFORM_64BITS && !defined(__BMI2__) && !defined(__AVX2__)
+#define SVO_MORTON_DISPATCH 1
+#else
+#define SVO_MORTON_DISPATCH 0
+#endif
+
 // A helper for functions that implement a non-const getter function by calling a const
 // getter function. Avoids duplicating all the const lookup code just to get a non-const
 // return value.
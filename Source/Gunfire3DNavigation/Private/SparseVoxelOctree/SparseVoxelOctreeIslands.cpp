@@ -0,0 +1,682 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeIslands.h"
+
+#include "SparseVoxelOctree.h"
+#include "SparseVoxelOctreeTile.h"
+#include "SparseVoxelOctreeUtils.h"
+
+#include "Algo/BinarySearch.h"
+
+// Profiling stats
+DECLARE_CYCLE_STAT(TEXT("Update (FSvoIslands)"), STAT_FSvoIslands_Update, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Update : Regions (FSvoIslands)"), STAT_FSvoIslands_Update_Regions, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Update : Islands (FSvoIslands)"), STAT_FSvoIslands_Update_Islands, STATGROUP_Gunfire3DNavigation);
+
+namespace SvoIslands
+{
+	// Minimal union-find over a contiguous range of elements
+	struct FDisjointSet
+	{
+		void Reset(int32 NumElements)
+		{
+			Parents.SetNumUninitialized(NumElements);
+			for (int32 ElementIdx = 0; ElementIdx < NumElements; ++ElementIdx)
+			{
+				Parents[ElementIdx] = ElementIdx;
+			}
+		}
+
+		int32 Add()
+		{
+			return Parents.Add(Parents.Num());
+		}
+
+		int32 Find(int32 ElementIdx)
+		{
+			while (Parents[ElementIdx] != ElementIdx)
+			{
+				// Path halving
+				Parents[ElementIdx] = Parents[Parents[ElementIdx]];
+				ElementIdx = Parents[ElementIdx];
+			}
+
+			return ElementIdx;
+		}
+
+		void Union(int32 ElementA, int32 ElementB)
+		{
+			ElementA = Find(ElementA);
+			ElementB = Find(ElementB);
+			if (ElementA != ElementB)
+			{
+				// Always keep the lowest element as the root so labels are assigned in a
+				// stable order.
+				if (ElementA < ElementB)
+				{
+					Parents[ElementB] = ElementA;
+				}
+				else
+				{
+					Parents[ElementA] = ElementB;
+				}
+			}
+		}
+
+		int32 Num() const { return Parents.Num(); }
+
+		TArray<int32> Parents;
+	};
+}
+
+template<typename TFunc>
+void FSvoIslands::ForEachTouchingCell(const FSvoTile& Tile, const FSvoNode& Node, ESvoNeighbor Neighbor, uint8 SourceVoxelIdx, const TFunc& Func)
+{
+	const ENodeState NodeState = Node.GetNodeState();
+	if (NodeState == ENodeState::Blocked)
+	{
+		return;
+	}
+
+	const int32 PoolIdx = GetPoolIndex(Tile, Node.GetSelfLink());
+
+	if (NodeState == ENodeState::Open)
+	{
+		Func(PoolIdx, SVO_NO_VOXEL);
+	}
+	else if (Node.IsLeafNode())
+	{
+		if (SourceVoxelIdx != SVO_NO_VOXEL)
+		{
+			// Coming from a voxel in a neighboring leaf, so only one voxel can be touched
+			const uint8 VoxelIdx = FSvoUtils::GetNeighborVoxel(SourceVoxelIdx, Neighbor);
+			if (!Node.IsVoxelBlocked(VoxelIdx))
+			{
+				Func(PoolIdx, VoxelIdx);
+			}
+		}
+		else
+		{
+			for (uint8 VoxelIdx : FSvoUtils::GetTouchingNeighborVoxels(Neighbor))
+			{
+				if (!Node.IsVoxelBlocked(VoxelIdx))
+				{
+					Func(PoolIdx, VoxelIdx);
+				}
+			}
+		}
+	}
+	else
+	{
+		for (uint8 ChildIdx : FSvoUtils::GetChildrenTouchingNeighbor(FSvoUtils::GetOppositeNeighbor(Neighbor)))
+		{
+			const FSvoNodeLink ChildLink = Node.GetChildLink(ChildIdx);
+			if (const FSvoNode* ChildNode = Tile.GetNode(ChildLink.LayerIdx, ChildLink.NodeIdx))
+			{
+				// A voxel can only touch a single one of the children, but since we don't
+				// know which one, be pessimistic and treat it as touching them all.
+				ForEachTouchingCell(Tile, *ChildNode, Neighbor, SVO_NO_VOXEL, Func);
+			}
+		}
+	}
+}
+
+void FSvoIslands::Reset()
+{
+	Tiles.Empty();
+	DirtyTiles.Empty();
+	NumIslands = 0;
+}
+
+void FSvoIslands::MarkTileDirty(const FIntVector& TileCoord)
+{
+	DirtyTiles.Add(FSvoTile::CalcTileID(TileCoord));
+
+	// The links from the neighbors into this tile need to be refreshed as well
+	for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+	{
+		DirtyTiles.Add(FSvoTile::CalcTileID(TileCoord + FSvoUtils::GetNeighborDirection(Neighbor)));
+	}
+}
+
+void FSvoIslands::RemoveTile(const FIntVector& TileCoord)
+{
+	Tiles.Remove(FSvoTile::CalcTileID(TileCoord));
+
+	// The next update will notice that the tile is gone and clean up after it
+	MarkTileDirty(TileCoord);
+}
+
+void FSvoIslands::Update(const FSparseVoxelOctree& Octree)
+{
+	if (!IsDirty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FSvoIslands_Update);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FSvoIslands_Update_Regions);
+
+		struct FBuiltTile
+		{
+			uint32 TileID;
+			int32 FirstLink;
+			int32 NumLinks;
+		};
+
+		TArray<FBuiltTile> BuiltTiles;
+		TArray<FPendingLink> PendingLinks;
+
+		// Label the regions within each dirty tile first, so the links between them can
+		// be resolved regardless of the order they were built in. Rebuilding a tile whose
+		// contents haven't changed always produces the same regions, so links from clean
+		// tiles into rebuilt neighbors remain valid.
+		for (uint32 TileID : DirtyTiles)
+		{
+			const FSvoTile* Tile = Octree.GetTile(TileID);
+			if (Tile == nullptr)
+			{
+				Tiles.Remove(TileID);
+				continue;
+			}
+
+			const int32 FirstLink = PendingLinks.Num();
+			BuildTileRegions(*Tile, Tiles.FindOrAdd(TileID), PendingLinks);
+			BuiltTiles.Add({ TileID, FirstLink, PendingLinks.Num() - FirstLink });
+		}
+
+		for (const FBuiltTile& BuiltTile : BuiltTiles)
+		{
+			TArrayView<const FPendingLink> TileLinks(PendingLinks.GetData() + BuiltTile.FirstLink, BuiltTile.NumLinks);
+			ResolveTileLinks(Octree, TileLinks, Tiles.FindChecked(BuiltTile.TileID));
+		}
+
+		DirtyTiles.Empty();
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FSvoIslands_Update_Islands);
+		BuildIslands();
+	}
+}
+
+uint32 FSvoIslands::GetIsland(const FSparseVoxelOctree& Octree, const FSvoNodeLink& Link) const
+{
+	if (!Link.IsValid())
+	{
+		return 0;
+	}
+
+	const FTileIslands* TileIslands = Tiles.Find(Link.TileID);
+	const FSvoTile* Tile = Octree.GetTile(Link.TileID);
+	if (TileIslands == nullptr || Tile == nullptr || TileIslands->TileVersion != Tile->GetVersion())
+	{
+		return 0;
+	}
+
+	const uint16 Region = GetRegion(*Tile, *TileIslands, Link);
+	return TileIslands->RegionIslands.IsValidIndex(Region) ? TileIslands->RegionIslands[Region] : 0;
+}
+
+bool FSvoIslands::AreConnected(const FSparseVoxelOctree& Octree, const FSvoNodeLink& LinkA, const FSvoNodeLink& LinkB) const
+{
+	if (IsDirty())
+	{
+		return true;
+	}
+
+	const uint32 IslandA = GetIsland(Octree, LinkA);
+	const uint32 IslandB = GetIsland(Octree, LinkB);
+	return (IslandA == 0 || IslandB == 0 || IslandA == IslandB);
+}
+
+uint32 FSvoIslands::GetMemUsed() const
+{
+	uint32 MemUsed = Tiles.GetAllocatedSize() + DirtyTiles.GetAllocatedSize();
+
+	for (const TPair<uint32, FTileIslands>& TilePair : Tiles)
+	{
+		const FTileIslands& TileIslands = TilePair.Value;
+		MemUsed += TileIslands.NodeRegions.GetAllocatedSize();
+		MemUsed += TileIslands.LeafRegions.GetAllocatedSize();
+		MemUsed += TileIslands.Links.GetAllocatedSize();
+		MemUsed += TileIslands.RegionIslands.GetAllocatedSize();
+	}
+
+	return MemUsed;
+}
+
+void FSvoIslands::BuildTileRegions(const FSvoTile& Tile, FTileIslands& TileIslands, TArray<FPendingLink>& OutPendingLinks) const
+{
+	const TArrayView<const FSvoNode> NodePool = Tile.GetNodePool();
+
+	TileIslands.TileVersion = Tile.GetVersion();
+	TileIslands.TileRegion = NoRegion;
+	TileIslands.NodeRegions.Reset();
+	TileIslands.LeafRegions.Reset();
+	TileIslands.Links.Reset();
+	TileIslands.RegionIslands.Reset();
+
+	const FSvoNode& TileNode = Tile.GetNodeInfo();
+	const ENodeState TileState = TileNode.GetNodeState();
+
+	if (TileState == ENodeState::Blocked)
+	{
+		return;
+	}
+
+	if (TileState == ENodeState::Open)
+	{
+		// The whole tile is a single region
+		TileIslands.TileRegion = 0;
+		TileIslands.RegionIslands.SetNumZeroed(1);
+
+		for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+		{
+			const FSvoNodeLink NeighborLink = TileNode.GetNeighborLink(Tile, Neighbor);
+			if (NeighborLink.IsValid())
+			{
+				OutPendingLinks.Add({ NeighborLink, 0, Neighbor, SVO_NO_VOXEL });
+			}
+		}
+
+		return;
+	}
+
+	//
+	// Create an element for every open node, along with a block of 64 elements for every
+	// partially blocked leaf so voxels can be addressed directly.
+	//
+
+	SvoIslands::FDisjointSet Elements;
+	TArray<int32> NodeElements;
+	NodeElements.Init(INDEX_NONE, NodePool.Num());
+
+	for (int32 PoolIdx = 0; PoolIdx < NodePool.Num(); ++PoolIdx)
+	{
+		const FSvoNode& Node = NodePool[PoolIdx];
+		if (!Node.IsActive())
+		{
+			continue;
+		}
+
+		const ENodeState NodeState = Node.GetNodeState();
+		if (NodeState == ENodeState::Open)
+		{
+			NodeElements[PoolIdx] = Elements.Add();
+		}
+		else if (NodeState == ENodeState::PartiallyBlocked && Node.IsLeafNode())
+		{
+			NodeElements[PoolIdx] = Elements.Num();
+			for (uint8 VoxelIdx = 0; VoxelIdx < SVO_VOXELS_PER_LEAF; ++VoxelIdx)
+			{
+				Elements.Add();
+			}
+		}
+	}
+
+	auto GetElement = [&NodeElements](int32 PoolIdx, uint8 VoxelIdx)
+	{
+		if (!NodeElements.IsValidIndex(PoolIdx) || NodeElements[PoolIdx] == INDEX_NONE)
+		{
+			return (int32)INDEX_NONE;
+		}
+
+		return NodeElements[PoolIdx] + ((VoxelIdx != SVO_NO_VOXEL) ? VoxelIdx : 0);
+	};
+
+	const int32 FirstPendingLink = OutPendingLinks.Num();
+
+	// Joins an element to everything it touches in a direction. Anything in another tile
+	// is saved off to be resolved later.
+	auto LinkElement = [&](int32 Element, const FSvoNode& Node, uint8 VoxelIdx, ESvoNeighbor Neighbor)
+	{
+		const FSvoNodeLink NeighborLink = Node.GetNeighborLink(Tile, Neighbor);
+		if (!NeighborLink.IsValid())
+		{
+			return;
+		}
+
+		if (NeighborLink.TileID != Tile.GetID())
+		{
+			OutPendingLinks.Add({ NeighborLink, Element, Neighbor, VoxelIdx });
+			return;
+		}
+
+		if (const FSvoNode* NeighborNode = Tile.GetNode(NeighborLink.LayerIdx, NeighborLink.NodeIdx))
+		{
+			ForEachTouchingCell(Tile, *NeighborNode, Neighbor, VoxelIdx, [&](int32 NeighborPoolIdx, uint8 NeighborVoxelIdx)
+			{
+				const int32 NeighborElement = GetElement(NeighborPoolIdx, NeighborVoxelIdx);
+				if (NeighborElement != INDEX_NONE)
+				{
+					Elements.Union(Element, NeighborElement);
+				}
+			});
+		}
+	};
+
+	//
+	// Join each element to its neighbors. Nodes only ever link to neighbors at the same
+	// resolution or lower, so every pair of touching elements is found from at least one
+	// side.
+	//
+
+	static const FIntVector PositiveAxes[] = { FIntVector(1, 0, 0), FIntVector(0, 1, 0), FIntVector(0, 0, 1) };
+
+	for (int32 PoolIdx = 0; PoolIdx < NodePool.Num(); ++PoolIdx)
+	{
+		const int32 NodeElement = NodeElements[PoolIdx];
+		if (NodeElement == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FSvoNode& Node = NodePool[PoolIdx];
+
+		if (Node.GetNodeState() == ENodeState::Open)
+		{
+			for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+			{
+				LinkElement(NodeElement, Node, SVO_NO_VOXEL, Neighbor);
+			}
+
+			continue;
+		}
+
+		// Join the free voxels within the leaf
+		for (uint8 VoxelIdx = 0; VoxelIdx < SVO_VOXELS_PER_LEAF; ++VoxelIdx)
+		{
+			if (Node.IsVoxelBlocked(VoxelIdx))
+			{
+				continue;
+			}
+
+			FIntVector VoxelCoord;
+			FSvoUtils::GetVoxelCoordFromIndex(VoxelIdx, VoxelCoord);
+
+			for (const FIntVector& Axis : PositiveAxes)
+			{
+				const FIntVector NeighborCoord = VoxelCoord + Axis;
+				if (FSvoUtils::IsVoxelCoordValid(NeighborCoord))
+				{
+					const uint8 NeighborVoxelIdx = FSvoUtils::GetVoxelIndexForCoord(NeighborCoord);
+					if (!Node.IsVoxelBlocked(NeighborVoxelIdx))
+					{
+						Elements.Union(NodeElement + VoxelIdx, NodeElement + NeighborVoxelIdx);
+					}
+				}
+			}
+		}
+
+		// Join the free voxels on each face with whatever they touch outside the leaf
+		for (ESvoNeighbor Neighbor : FSvoUtils::GetAllNeighbors())
+		{
+			// The leaf face voxels are listed from the perspective of the opposite neighbor
+			for (uint8 VoxelIdx : FSvoUtils::GetTouchingNeighborVoxels(FSvoUtils::GetOppositeNeighbor(Neighbor)))
+			{
+				if (!Node.IsVoxelBlocked(VoxelIdx))
+				{
+					LinkElement(NodeElement + VoxelIdx, Node, VoxelIdx, Neighbor);
+				}
+			}
+		}
+	}
+
+	//
+	// Number the regions in the order they're first found. If there are too many to
+	// store, merge them all into one, which is pessimistic but still correct.
+	//
+
+	TArray<int32> RootRegions;
+	RootRegions.Init(INDEX_NONE, Elements.Num());
+	int32 NumRegions = 0;
+
+	auto ForEachOpenElement = [&](auto&& Func)
+	{
+		for (int32 PoolIdx = 0; PoolIdx < NodePool.Num(); ++PoolIdx)
+		{
+			const int32 NodeElement = NodeElements[PoolIdx];
+			if (NodeElement == INDEX_NONE)
+			{
+				continue;
+			}
+
+			const FSvoNode& Node = NodePool[PoolIdx];
+			if (Node.GetNodeState() == ENodeState::Open)
+			{
+				Func(PoolIdx, SVO_NO_VOXEL, NodeElement);
+			}
+			else
+			{
+				for (uint8 VoxelIdx = 0; VoxelIdx < SVO_VOXELS_PER_LEAF; ++VoxelIdx)
+				{
+					if (!Node.IsVoxelBlocked(VoxelIdx))
+					{
+						Func(PoolIdx, VoxelIdx, NodeElement + VoxelIdx);
+					}
+				}
+			}
+		}
+	};
+
+	ForEachOpenElement([&](int32 PoolIdx, uint8 VoxelIdx, int32 Element)
+	{
+		int32& RootRegion = RootRegions[Elements.Find(Element)];
+		if (RootRegion == INDEX_NONE)
+		{
+			RootRegion = NumRegions++;
+		}
+	});
+
+	if (NumRegions > MaxRegions)
+	{
+		for (int32& RootRegion : RootRegions)
+		{
+			RootRegion = (RootRegion != INDEX_NONE) ? 0 : INDEX_NONE;
+		}
+
+		NumRegions = 1;
+	}
+
+	TileIslands.NodeRegions.Init(NoRegion, NodePool.Num());
+	TileIslands.RegionIslands.SetNumZeroed(NumRegions);
+
+	ForEachOpenElement([&](int32 PoolIdx, uint8 VoxelIdx, int32 Element)
+	{
+		const uint16 Region = (uint16)RootRegions[Elements.Find(Element)];
+
+		if (VoxelIdx == SVO_NO_VOXEL)
+		{
+			TileIslands.NodeRegions[PoolIdx] = Region;
+			return;
+		}
+
+		// Voxels are visited in pool order, so the leaf regions stay sorted as long as we
+		// only ever search the regions of the current leaf.
+		int32 LeafRegionIdx = TileIslands.LeafRegions.Num() - 1;
+		for (; LeafRegionIdx >= 0 && TileIslands.LeafRegions[LeafRegionIdx].PoolIdx == PoolIdx; --LeafRegionIdx)
+		{
+			if (TileIslands.LeafRegions[LeafRegionIdx].Region == Region)
+			{
+				break;
+			}
+		}
+
+		if (LeafRegionIdx < 0 || TileIslands.LeafRegions[LeafRegionIdx].PoolIdx != PoolIdx)
+		{
+			LeafRegionIdx = TileIslands.LeafRegions.Add({ PoolIdx, 0ull, Region });
+		}
+
+		TileIslands.LeafRegions[LeafRegionIdx].VoxelMask |= (1ull << VoxelIdx);
+	});
+
+	// Pending links were recorded with the element they leave from, swap those out for
+	// the region.
+	for (int32 LinkIdx = FirstPendingLink; LinkIdx < OutPendingLinks.Num(); ++LinkIdx)
+	{
+		FPendingLink& PendingLink = OutPendingLinks[LinkIdx];
+		PendingLink.Region = RootRegions[Elements.Find(PendingLink.Region)];
+	}
+
+	TileIslands.NodeRegions.Shrink();
+	TileIslands.LeafRegions.Shrink();
+}
+
+void FSvoIslands::ResolveTileLinks(const FSparseVoxelOctree& Octree, TArrayView<const FPendingLink> PendingLinks, FTileIslands& TileIslands) const
+{
+	TSet<uint64> AddedLinks;
+
+	for (const FPendingLink& PendingLink : PendingLinks)
+	{
+		const FSvoNodeLink& NeighborLink = PendingLink.NeighborLink;
+
+		const FSvoTile* NeighborTile = Octree.GetTile(NeighborLink.TileID);
+		const FTileIslands* NeighborIslands = Tiles.Find(NeighborLink.TileID);
+		if (NeighborTile == nullptr || NeighborIslands == nullptr)
+		{
+			continue;
+		}
+
+		const FSvoNode* NeighborNode = NeighborTile->GetNode(NeighborLink.LayerIdx, NeighborLink.NodeIdx);
+		if (NeighborNode == nullptr)
+		{
+			continue;
+		}
+
+		ForEachTouchingCell(*NeighborTile, *NeighborNode, PendingLink.Neighbor, PendingLink.VoxelIdx, [&](int32 NeighborPoolIdx, uint8 NeighborVoxelIdx)
+		{
+			const uint16 NeighborRegion = GetRegion(*NeighborIslands, NeighborPoolIdx, NeighborVoxelIdx);
+			if (NeighborRegion == NoRegion)
+			{
+				return;
+			}
+
+			const uint64 LinkKey = ((uint64)NeighborLink.TileID << 32) | ((uint64)PendingLink.Region << 16) | NeighborRegion;
+
+			bool bAlreadyAdded = false;
+			AddedLinks.Add(LinkKey, &bAlreadyAdded);
+			if (!bAlreadyAdded)
+			{
+				TileIslands.Links.Add({ NeighborLink.TileID, (uint16)PendingLink.Region, NeighborRegion });
+			}
+		});
+	}
+
+	TileIslands.Links.Shrink();
+}
+
+void FSvoIslands::BuildIslands()
+{
+	// Give every region in the octree a global index
+	TMap<uint32, int32> TileOffsets;
+	TileOffsets.Reserve(Tiles.Num());
+
+	int32 NumRegions = 0;
+	for (const TPair<uint32, FTileIslands>& TilePair : Tiles)
+	{
+		TileOffsets.Add(TilePair.Key, NumRegions);
+		NumRegions += TilePair.Value.RegionIslands.Num();
+	}
+
+	SvoIslands::FDisjointSet Regions;
+	Regions.Reset(NumRegions);
+
+	for (const TPair<uint32, FTileIslands>& TilePair : Tiles)
+	{
+		const int32 TileOffset = TileOffsets.FindChecked(TilePair.Key);
+
+		for (const FRegionLink& Link : TilePair.Value.Links)
+		{
+			const int32* NeighborOffset = TileOffsets.Find(Link.NeighborTileID);
+			const FTileIslands* NeighborIslands = Tiles.Find(Link.NeighborTileID);
+			if (NeighborOffset != nullptr && NeighborIslands->RegionIslands.IsValidIndex(Link.NeighborRegion))
+			{
+				Regions.Union(TileOffset + Link.Region, *NeighborOffset + Link.NeighborRegion);
+			}
+		}
+	}
+
+	// Number the islands, starting at one since zero means unknown
+	TArray<uint32> RootIslands;
+	RootIslands.SetNumZeroed(NumRegions);
+	NumIslands = 0;
+
+	for (TPair<uint32, FTileIslands>& TilePair : Tiles)
+	{
+		const int32 TileOffset = TileOffsets.FindChecked(TilePair.Key);
+		TArray<uint32>& RegionIslands = TilePair.Value.RegionIslands;
+
+		for (int32 RegionIdx = 0; RegionIdx < RegionIslands.Num(); ++RegionIdx)
+		{
+			uint32& RootIsland = RootIslands[Regions.Find(TileOffset + RegionIdx)];
+			if (RootIsland == 0)
+			{
+				RootIsland = ++NumIslands;
+			}
+
+			RegionIslands[RegionIdx] = RootIsland;
+		}
+	}
+}
+
+uint16 FSvoIslands::GetRegion(const FSvoTile& Tile, const FTileIslands& TileIslands, const FSvoNodeLink& Link)
+{
+	const int32 PoolIdx = GetPoolIndex(Tile, Link);
+	if (PoolIdx == INDEX_NONE)
+	{
+		return (Link.LayerIdx == Tile.GetSelfLink().LayerIdx) ? TileIslands.TileRegion : NoRegion;
+	}
+
+	const FSvoNode& Node = Tile.GetNodePool()[PoolIdx];
+	if (Node.IsLeafNode() && Node.GetNodeState() == ENodeState::PartiallyBlocked)
+	{
+		// Without a voxel there's no telling which region of the leaf we're in
+		return Link.IsVoxelNode() ? GetRegion(TileIslands, PoolIdx, Link.VoxelIdx) : NoRegion;
+	}
+
+	return GetRegion(TileIslands, PoolIdx, SVO_NO_VOXEL);
+}
+
+uint16 FSvoIslands::GetRegion(const FTileIslands& TileIslands, int32 PoolIdx, uint8 VoxelIdx)
+{
+	if (PoolIdx == INDEX_NONE)
+	{
+		return TileIslands.TileRegion;
+	}
+
+	if (VoxelIdx == SVO_NO_VOXEL)
+	{
+		return TileIslands.NodeRegions.IsValidIndex(PoolIdx) ? TileIslands.NodeRegions[PoolIdx] : NoRegion;
+	}
+
+	const uint64 VoxelMask = (1ull << VoxelIdx);
+	for (int32 LeafRegionIdx = Algo::LowerBoundBy(TileIslands.LeafRegions, PoolIdx, &FLeafRegion::PoolIdx); LeafRegionIdx < TileIslands.LeafRegions.Num(); ++LeafRegionIdx)
+	{
+		const FLeafRegion& LeafRegion = TileIslands.LeafRegions[LeafRegionIdx];
+		if (LeafRegion.PoolIdx != PoolIdx)
+		{
+			break;
+		}
+
+		if ((LeafRegion.VoxelMask & VoxelMask) != 0)
+		{
+			return LeafRegion.Region;
+		}
+	}
+
+	return NoRegion;
+}
+
+int32 FSvoIslands::GetPoolIndex(const FSvoTile& Tile, const FSvoNodeLink& Link)
+{
+	if (!Tile.Layers.IsValidIndex(Link.LayerIdx))
+	{
+		return INDEX_NONE;
+	}
+
+	const FSvoTile::FSvoLayer& Layer = Tile.Layers[Link.LayerIdx];
+	return (Link.NodeIdx < Layer.MaxNodes) ? (int32)(Layer.StartNode + Link.NodeIdx) : INDEX_NONE;
+}
@@ -0,0 +1,136 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctreeNode.h"
+
+class FSparseVoxelOctree;
+class FSvoTile;
+
+//
+// Labels every open node and voxel in the octree with the island (connected component of
+// open space) it belongs to, so queries can tell in constant time that two locations can
+// never reach each other.
+//
+// Each tile is split into regions of connected open space, stored compactly next to the
+// tile's nodes. Whenever a tile changes only it and its direct neighbors are re-labeled,
+// after which the regions of all tiles are joined together into islands.
+//
+// Labels may over-estimate connectivity (e.g. regions are merged when a tile has more of
+// them than can be stored), but never under-estimate it.
+//
+class GUNFIRE3DNAVIGATION_API FSvoIslands
+{
+public:
+	// Destroys all island data
+	void Reset();
+
+	// Marks a tile as needing to be re-labeled, along with its neighbors since the links
+	// between them may have changed.
+	void MarkTileDirty(const FIntVector& TileCoord);
+
+	// Removes a tile's labels, marking its neighbors as needing to be re-labeled
+	void RemoveTile(const FIntVector& TileCoord);
+
+	// Returns true if any tiles need to be re-labeled
+	bool IsDirty() const { return DirtyTiles.Num() > 0; }
+
+	// Re-labels all dirty tiles and rebuilds the islands. Should be called once all
+	// neighbor links in the octree are up to date.
+	void Update(const FSparseVoxelOctree& Octree);
+
+	// Returns the island for an open node (or voxel), or zero if it isn't known
+	uint32 GetIsland(const FSparseVoxelOctree& Octree, const FSvoNodeLink& Link) const;
+
+	// Returns false only if both links are known to be on different islands. Everything
+	// is treated as connected while tiles are waiting to be re-labeled, since labels
+	// from before the edit may no longer be correct.
+	bool AreConnected(const FSparseVoxelOctree& Octree, const FSvoNodeLink& LinkA, const FSvoNodeLink& LinkB) const;
+
+	// Returns the number of islands found by the last update
+	uint32 GetNumIslands() const { return NumIslands; }
+
+	// Returns the amount of memory used by the labels
+	uint32 GetMemUsed() const;
+
+private:
+	static constexpr uint16 NoRegion = MAX_uint16;
+	static constexpr int32 MaxRegions = MAX_uint16 - 1;
+
+	// One connected set of free voxels within a partially blocked leaf
+	struct FLeafRegion
+	{
+		int32 PoolIdx;
+		uint64 VoxelMask;
+		uint16 Region;
+	};
+
+	// Connection from a region in one tile to a region in a neighboring tile
+	struct FRegionLink
+	{
+		uint32 NeighborTileID;
+		uint16 Region;
+		uint16 NeighborRegion;
+	};
+
+	// Link leaving a tile which hasn't been resolved to a region in the neighboring tile
+	struct FPendingLink
+	{
+		FSvoNodeLink NeighborLink;
+		int32 Region;
+		ESvoNeighbor Neighbor;
+
+		// Set if the link leaves from a voxel of a partially blocked leaf
+		uint8 VoxelIdx;
+	};
+
+	struct FTileIslands
+	{
+		// Version of the tile the labels were built from
+		uint32 TileVersion = 0;
+
+		// Region of the tile node itself, if it's open with no children
+		uint16 TileRegion = NoRegion;
+
+		// Region of each open node, parallel to the tile's node pool
+		TArray<uint16> NodeRegions;
+
+		// Regions within partially blocked leaves, sorted by pool index
+		TArray<FLeafRegion> LeafRegions;
+
+		TArray<FRegionLink> Links;
+
+		// Island of each region in the tile
+		TArray<uint32> RegionIslands;
+	};
+
+	// Splits the open space of a tile into connected regions. Links across tile faces are
+	// returned unresolved, since the neighboring tile may not have been labeled yet.
+	void BuildTileRegions(const FSvoTile& Tile, FTileIslands& TileIslands, TArray<FPendingLink>& OutPendingLinks) const;
+
+	// Resolves the links leaving a tile to regions within the neighboring tiles
+	void ResolveTileLinks(const FSparseVoxelOctree& Octree, TArrayView<const FPendingLink> PendingLinks, FTileIslands& TileIslands) const;
+
+	// Joins the regions of all tiles into islands
+	void BuildIslands();
+
+	// Returns the region of an open node (or voxel) within a tile
+	static uint16 GetRegion(const FSvoTile& Tile, const FTileIslands& TileIslands, const FSvoNodeLink& Link);
+	static uint16 GetRegion(const FTileIslands& TileIslands, int32 PoolIdx, uint8 VoxelIdx);
+
+	// Returns the index of a node within the tile's node pool, or INDEX_NONE for the tile
+	// node itself.
+	static int32 GetPoolIndex(const FSvoTile& Tile, const FSvoNodeLink& Link);
+
+	// Calls 'Func' with the pool index and voxel of every open node (or voxel) of 'Node'
+	// that touches the node it was reached from in the direction of 'Neighbor'.
+	template<typename TFunc>
+	static void ForEachTouchingCell(const FSvoTile& Tile, const FSvoNode& Node, ESvoNeighbor Neighbor, uint8 SourceVoxelIdx, const TFunc& Func);
+
+	TMap<uint32, FTileIslands> Tiles;
+
+	// Tiles which need to be re-labeled
+	TSet<uint32> DirtyTiles;
+
+	uint32 NumIslands = 0;
+};
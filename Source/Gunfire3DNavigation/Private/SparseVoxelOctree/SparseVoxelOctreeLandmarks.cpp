@@ -0,0 +1,231 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeLandmarks.h"
+
+#include "SparseVoxelOctreeTileGraph.h"
+
+DECLARE_CYCLE_STAT(TEXT("SvoLandmarks Build"), STAT_SvoLandmarks_Build, STATGROUP_Gunfire3DNavigation);
+
+//////////////////////////////////////////////////////////////////////////
+// FSvoLandmarks::FTable
+//////////////////////////////////////////////////////////////////////////
+
+int32 FSvoLandmarks::FTable::GetStepsLowerBound(const uint16* DistancesA, const uint16* DistancesB) const
+{
+	int32 LowerBound = 0;
+
+	for (int32 LandmarkIdx = 0; LandmarkIdx < GetNumLandmarks(); ++LandmarkIdx)
+	{
+		const uint16 DistanceA = DistancesA[LandmarkIdx];
+		const uint16 DistanceB = DistancesB[LandmarkIdx];
+
+		// A landmark that can't reach both tiles says nothing about the distance between
+		// them. Whether they're connected at all is left to the islands.
+		if (DistanceA == Unreachable || DistanceB == Unreachable)
+		{
+			continue;
+		}
+
+		LowerBound = FMath::Max(LowerBound, FMath::Abs((int32)DistanceA - (int32)DistanceB));
+	}
+
+	return LowerBound;
+}
+
+uint32 FSvoLandmarks::FTable::GetMemUsed() const
+{
+	return sizeof(*this) + LandmarkTileIDs.GetAllocatedSize() + TileRows.GetAllocatedSize() + Distances.GetAllocatedSize();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSvoLandmarks
+//////////////////////////////////////////////////////////////////////////
+
+FSvoLandmarks::FTablePtr FSvoLandmarks::GetTable(const FSvoTileGraph& TileGraph, uint32 EditVersion) const
+{
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (bBuilt && BuiltEditVersion == EditVersion)
+		{
+			return Table;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have rebuilt the table while we waited for the lock
+	if (bBuilt && BuiltEditVersion == EditVersion)
+	{
+		return Table;
+	}
+
+	if (TileGraph.GetNumTiles() > 0)
+	{
+		TSharedRef<FTable, ESPMode::ThreadSafe> NewTable = MakeShared<FTable, ESPMode::ThreadSafe>();
+		BuildTable(TileGraph, NewTable.Get());
+		Table = NewTable;
+	}
+	else
+	{
+		Table.Reset();
+	}
+
+	BuiltEditVersion = EditVersion;
+	bBuilt = true;
+
+	return Table;
+}
+
+void FSvoLandmarks::Reset()
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	Table.Reset();
+	bBuilt = false;
+}
+
+uint32 FSvoLandmarks::GetMemUsed() const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	return Table.IsValid() ? Table->GetMemUsed() : 0;
+}
+
+void FSvoLandmarks::BuildTable(const FSvoTileGraph& TileGraph, FTable& OutTable)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SvoLandmarks_Build);
+
+	TArray<uint32> TileIDs;
+	TileGraph.GetTileIDs(TileIDs);
+
+	const int32 NumTiles = TileIDs.Num();
+
+	OutTable.TileRows.Reserve(NumTiles);
+	for (int32 Row = 0; Row < NumTiles; ++Row)
+	{
+		OutTable.TileRows.Add(TileIDs[Row], Row);
+	}
+
+	// Landmarks are only placed in the largest group of connected tiles. Smaller groups
+	// are usually sealed off pockets, which would waste a landmark each, so searches in
+	// them fall back to the regular heuristic.
+	int32 SeedRow = INDEX_NONE;
+	{
+		TBitArray<> Visited(false, NumTiles);
+		TArray<int32> Queue;
+		TArray<uint32, TInlineAllocator<6>> ConnectedTileIDs;
+		int32 LargestGroupSize = 0;
+
+		for (int32 GroupRow = 0; GroupRow < NumTiles; ++GroupRow)
+		{
+			if (Visited[GroupRow])
+			{
+				continue;
+			}
+
+			Queue.Reset();
+			Queue.Add(GroupRow);
+			Visited[GroupRow] = true;
+
+			for (int32 QueueIdx = 0; QueueIdx < Queue.Num(); ++QueueIdx)
+			{
+				TileGraph.GetConnectedTileIDs(TileIDs[Queue[QueueIdx]], ConnectedTileIDs);
+				for (uint32 ConnectedTileID : ConnectedTileIDs)
+				{
+					const int32* ConnectedRow = OutTable.TileRows.Find(ConnectedTileID);
+					if (ConnectedRow && !Visited[*ConnectedRow])
+					{
+						Visited[*ConnectedRow] = true;
+						Queue.Add(*ConnectedRow);
+					}
+				}
+			}
+
+			if (Queue.Num() > LargestGroupSize)
+			{
+				LargestGroupSize = Queue.Num();
+				SeedRow = GroupRow;
+			}
+		}
+	}
+
+	// Pick the landmarks furthest from each other, starting from the far edge of the
+	// group. Landmarks on the edges give the tightest bounds for searches heading towards
+	// or away from them.
+	TArray<TArray<uint16>> LandmarkDistances;
+	TArray<uint16> MinDistances;
+	TArray<uint16> SeedDistances;
+
+	int32 LandmarkRow = CalcDistances(TileGraph, TileIDs, OutTable.TileRows, SeedRow, SeedDistances);
+	MinDistances.Init(Unreachable, NumTiles);
+
+	while (LandmarkRow != INDEX_NONE && LandmarkDistances.Num() < MaxLandmarks)
+	{
+		OutTable.LandmarkTileIDs.Add(TileIDs[LandmarkRow]);
+
+		TArray<uint16>& Distances = LandmarkDistances.AddDefaulted_GetRef();
+		CalcDistances(TileGraph, TileIDs, OutTable.TileRows, LandmarkRow, Distances);
+
+		LandmarkRow = INDEX_NONE;
+		uint16 BestMinDistance = 0;
+
+		for (int32 Row = 0; Row < NumTiles; ++Row)
+		{
+			MinDistances[Row] = FMath::Min(MinDistances[Row], Distances[Row]);
+
+			if (MinDistances[Row] != Unreachable && MinDistances[Row] > BestMinDistance)
+			{
+				BestMinDistance = MinDistances[Row];
+				LandmarkRow = Row;
+			}
+		}
+	}
+
+	// Interleave the landmarks so each tile's distances are next to each other
+	const int32 NumLandmarks = LandmarkDistances.Num();
+	OutTable.Distances.SetNumUninitialized(NumTiles * NumLandmarks);
+
+	for (int32 Row = 0; Row < NumTiles; ++Row)
+	{
+		for (int32 LandmarkIdx = 0; LandmarkIdx < NumLandmarks; ++LandmarkIdx)
+		{
+			OutTable.Distances[Row * NumLandmarks + LandmarkIdx] = LandmarkDistances[LandmarkIdx][Row];
+		}
+	}
+}
+
+int32 FSvoLandmarks::CalcDistances(const FSvoTileGraph& TileGraph, TArrayView<const uint32> TileIDs, const TMap<uint32, int32>& TileRows, int32 SourceRow, TArray<uint16>& OutDistances)
+{
+	OutDistances.Init(Unreachable, TileIDs.Num());
+	OutDistances[SourceRow] = 0;
+
+	int32 FurthestRow = SourceRow;
+
+	// Every step costs the same, so tiles come off the queue in order of distance
+	TArray<int32> Queue;
+	Queue.Add(FurthestRow);
+
+	TArray<uint32, TInlineAllocator<6>> ConnectedTileIDs;
+
+	for (int32 QueueIdx = 0; QueueIdx < Queue.Num(); ++QueueIdx)
+	{
+		const int32 Row = Queue[QueueIdx];
+		FurthestRow = Row;
+
+		// Distances saturate just below unreachable on graphs too large to count
+		const uint16 ConnectedDistance = FMath::Min<int32>(OutDistances[Row] + 1, Unreachable - 1);
+
+		TileGraph.GetConnectedTileIDs(TileIDs[Row], ConnectedTileIDs);
+		for (uint32 ConnectedTileID : ConnectedTileIDs)
+		{
+			const int32* ConnectedRow = TileRows.Find(ConnectedTileID);
+			if (ConnectedRow && OutDistances[*ConnectedRow] == Unreachable)
+			{
+				OutDistances[*ConnectedRow] = ConnectedDistance;
+				Queue.Add(*ConnectedRow);
+			}
+		}
+	}
+
+	return FurthestRow;
+}
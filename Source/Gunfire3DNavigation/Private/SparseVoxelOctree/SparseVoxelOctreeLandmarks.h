@@ -0,0 +1,81 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctreeCommon.h"
+
+class FSvoTileGraph;
+
+//
+// Landmark (ALT) distances over the tile graph, used to tighten the search heuristic.
+// A handful of landmark tiles are picked around the edges of the graph and the number
+// of steps from each of them to every tile is stored. For any two tiles, the largest
+// difference between their distances to a landmark can't be more than the distance
+// between them (triangle inequality), which unlike the straight line distance accounts
+// for the walls a path has to go around.
+//
+// The table is rebuilt lazily from the tile graph whenever the octree changes, and is
+// swapped out whole so searches holding the previous one can carry on with it.
+//
+// NOTE: Like the tile graph, connectivity within a tile isn't tracked. Steps are a lower
+// bound on the tiles a path needs to cross, not on the voxels within them.
+//
+class GUNFIRE3DNAVIGATION_API FSvoLandmarks
+{
+public:
+	static constexpr int32 MaxLandmarks = 8;
+
+	// Distance of a tile that can't be reached from a landmark
+	static constexpr uint16 Unreachable = MAX_uint16;
+
+	struct GUNFIRE3DNAVIGATION_API FTable
+	{
+		TArray<uint32> LandmarkTileIDs;
+
+		// Row in the distances for each tile in the graph
+		TMap<uint32, int32> TileRows;
+
+		// Steps from each landmark to each tile, a row of 'NumLandmarks' per tile
+		TArray<uint16> Distances;
+
+		int32 GetNumLandmarks() const { return LandmarkTileIDs.Num(); }
+
+		// Returns the distances from every landmark to a tile, or null if it's not in the
+		// table
+		const uint16* FindTileDistances(uint32 TileID) const
+		{
+			const int32* Row = TileRows.Find(TileID);
+			return Row ? &Distances[*Row * GetNumLandmarks()] : nullptr;
+		}
+
+		// Returns the lower bound on the steps between two tiles, given their distance rows
+		int32 GetStepsLowerBound(const uint16* DistancesA, const uint16* DistancesB) const;
+
+		uint32 GetMemUsed() const;
+	};
+
+	typedef TSharedPtr<const FTable, ESPMode::ThreadSafe> FTablePtr;
+
+	// Returns the table for the current state of the tile graph, rebuilding it first if
+	// the octree has been edited since it was built. Returns null if the graph is empty.
+	FTablePtr GetTable(const FSvoTileGraph& TileGraph, uint32 EditVersion) const;
+
+	// Discards the table
+	void Reset();
+
+	uint32 GetMemUsed() const;
+
+private:
+	static void BuildTable(const FSvoTileGraph& TileGraph, FTable& OutTable);
+
+	// Walks the graph breadth first from a tile, filling out the steps to every tile
+	// indexed by its row. Returns the row of the furthest tile reached.
+	static int32 CalcDistances(const FSvoTileGraph& TileGraph, TArrayView<const uint32> TileIDs, const TMap<uint32, int32>& TileRows, int32 SourceRow, TArray<uint16>& OutDistances);
+
+	mutable FRWLock Lock;
+
+	mutable FTablePtr Table;
+
+	mutable uint32 BuiltEditVersion = 0;
+	mutable bool bBuilt = false;
+};
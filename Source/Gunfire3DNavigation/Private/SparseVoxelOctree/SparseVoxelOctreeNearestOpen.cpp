@@ -0,0 +1,315 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeNearestOpen.h"
+
+#include "SparseVoxelOctree.h"
+
+DECLARE_CYCLE_STAT(TEXT("SvoNearestOpen Find"), STAT_SvoNearestOpen_Find, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("SvoNearestOpen BuildTileGrid"), STAT_SvoNearestOpen_BuildTileGrid, STATGROUP_Gunfire3DNavigation);
+
+namespace SvoNearestOpen
+{
+	// How far the closest point is pulled into the node, so it doesn't land right on its
+	// edge
+	constexpr float kEpsilon = 0.01f;
+}
+
+bool FSvoNearestOpen::FindNearestOpenLink(const FSparseVoxelOctree& Octree, const FVector& Origin, const FBox& QueryBounds, FSvoNodeLink& OutLink, FVector& OutClosestPoint) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SvoNearestOpen_Find);
+
+	const FSvoTile* Tile = Octree.GetTileAtLocation(Origin);
+	if (Tile == nullptr)
+	{
+		return false;
+	}
+
+	// Bring the grid for the tile up to date
+	bool bUpToDate = false;
+	{
+		FReadScopeLock ReadLock(Lock);
+
+		const FTileGrid* Grid = Tiles.Find(Tile->GetID());
+		bUpToDate = (Grid != nullptr && Grid->Version == Tile->GetVersion());
+	}
+
+	if (!bUpToDate)
+	{
+		FTileGrid NewGrid;
+		BuildTileGrid(Octree, *Tile, NewGrid);
+
+		FWriteScopeLock WriteLock(Lock);
+		Tiles.Add(Tile->GetID(), MoveTemp(NewGrid));
+	}
+
+	FReadScopeLock ReadLock(Lock);
+
+	const FTileGrid* Grid = Tiles.Find(Tile->GetID());
+	if (Grid == nullptr || Grid->Version != Tile->GetVersion())
+	{
+		return false;
+	}
+
+	const FSvoConfig& Config = Octree.GetConfig();
+	const FBox TileBounds = Config.GetTileBounds(Tile->GetCoord());
+	const FVector::FReal CellSize = Config.GetResolutionForLayer(0);
+	const int32 GridSize = 1 << Config.GetTileLayerIndex();
+	const FIntVector GridExtents(GridSize);
+
+	const FVector CellLocation = (Origin - TileBounds.Min) / CellSize;
+	const FIntVector OriginCell(
+		FMath::Clamp(FMath::FloorToInt(CellLocation.X), 0, GridSize - 1),
+		FMath::Clamp(FMath::FloorToInt(CellLocation.Y), 0, GridSize - 1),
+		FMath::Clamp(FMath::FloorToInt(CellLocation.Z), 0, GridSize - 1));
+
+	const uint8 StartDistance = Grid->OpenDistances[FSvoUtils::GetIndexForCoord(OriginCell, GridExtents)];
+	if (StartDistance == NoOpenDistance)
+	{
+		return false;
+	}
+
+	// Open space in a neighboring tile could be anything further than this away
+	const FVector::FReal TileEdgeDist = FMath::Min((Origin - TileBounds.Min).GetMin(), (TileBounds.Max - Origin).GetMin());
+
+	FVector::FReal BestDistSqrd = TNumericLimits<FVector::FReal>::Max();
+	FSvoNodeLink BestLink = SVO_INVALID_NODELINK;
+	FVector BestPoint = FVector::ZeroVector;
+	FBox BestBounds(ForceInit);
+
+	auto ConsiderBounds = [&](const FSvoNodeLink& Link, const FBox& Bounds)
+	{
+		const FVector ClosestPoint = Bounds.GetClosestPointTo(Origin);
+		const FVector::FReal DistSqrd = FVector::DistSquared(Origin, ClosestPoint);
+
+		if (DistSqrd < BestDistSqrd)
+		{
+			BestDistSqrd = DistSqrd;
+			BestLink = Link;
+			BestPoint = ClosestPoint;
+			BestBounds = Bounds;
+		}
+	};
+
+	auto ConsiderCell = [&](const FIntVector& Cell)
+	{
+		if (Grid->OpenDistances[FSvoUtils::GetIndexForCoord(Cell, GridExtents)] != 0)
+		{
+			return;
+		}
+
+		const FSvoNode* Node = FindNodeForCell(Octree, *Tile, Cell);
+		if (Node == nullptr)
+		{
+			return;
+		}
+
+		if (Node->GetNodeState() == ENodeState::Open)
+		{
+			ConsiderBounds(Node->GetSelfLink(), Octree.GetBoundsForNode(*Node));
+		}
+		else if (Node->GetNodeState() == ENodeState::PartiallyBlocked && Node->IsLeafNode())
+		{
+			FSvoNodeLink VoxelLink = Node->GetSelfLink();
+			for (FSvoVoxelIterator VoxelIter; VoxelIter; ++VoxelIter)
+			{
+				VoxelLink.VoxelIdx = VoxelIter.GetIndex();
+				if (!Node->IsVoxelBlocked(VoxelLink.VoxelIdx))
+				{
+					FBox VoxelBounds;
+					Octree.GetBoundsForLink(VoxelLink, VoxelBounds);
+					ConsiderBounds(VoxelLink, VoxelBounds);
+				}
+			}
+		}
+	};
+
+	// Search outward a ring of cells at a time, starting from the first ring with open
+	// space, until the rings are further away than the best so far.
+	for (int32 Ring = StartDistance; Ring < GridSize; ++Ring)
+	{
+		// The origin can be anywhere in its cell, so a ring is only known to be a cell
+		// closer than its distance
+		const FVector::FReal RingDist = FMath::Max(Ring - 1, 0) * CellSize;
+		if (FMath::Square(RingDist) >= BestDistSqrd || RingDist > TileEdgeDist)
+		{
+			break;
+		}
+
+		for (int32 DZ = -Ring; DZ <= Ring; ++DZ)
+		{
+			const int32 Z = OriginCell.Z + DZ;
+			if (Z < 0 || Z >= GridSize)
+			{
+				continue;
+			}
+
+			for (int32 DY = -Ring; DY <= Ring; ++DY)
+			{
+				const int32 Y = OriginCell.Y + DY;
+				if (Y < 0 || Y >= GridSize)
+				{
+					continue;
+				}
+
+				// Only the outside of the ring is visited, so rows through the middle
+				// only need their ends
+				const bool bFullRow = (Ring == 0 || FMath::Abs(DZ) == Ring || FMath::Abs(DY) == Ring);
+				const int32 StepX = bFullRow ? 1 : (2 * Ring);
+
+				for (int32 DX = -Ring; DX <= Ring; DX += StepX)
+				{
+					const int32 X = OriginCell.X + DX;
+					if (X >= 0 && X < GridSize)
+					{
+						ConsiderCell(FIntVector(X, Y, Z));
+					}
+				}
+			}
+		}
+	}
+
+	if (!BestLink.IsValid() ||
+		BestDistSqrd > FMath::Square(TileEdgeDist) ||
+		!QueryBounds.IsInsideOrOn(BestPoint))
+	{
+		return false;
+	}
+
+	OutLink = BestLink;
+	OutClosestPoint = BestPoint + (BestBounds.GetCenter() - BestPoint).GetSafeNormal() * SvoNearestOpen::kEpsilon;
+
+	return true;
+}
+
+void FSvoNearestOpen::Reset()
+{
+	FWriteScopeLock WriteLock(Lock);
+	Tiles.Empty();
+}
+
+uint32 FSvoNearestOpen::GetMemUsed() const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	uint32 MemUsed = Tiles.GetAllocatedSize();
+	for (const TPair<uint32, FTileGrid>& Tile : Tiles)
+	{
+		MemUsed += Tile.Value.OpenDistances.GetAllocatedSize();
+	}
+
+	return MemUsed;
+}
+
+void FSvoNearestOpen::BuildTileGrid(const FSparseVoxelOctree& Octree, const FSvoTile& Tile, FTileGrid& OutGrid)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SvoNearestOpen_BuildTileGrid);
+
+	const int32 GridSize = 1 << Octree.GetConfig().GetTileLayerIndex();
+	const FIntVector GridExtents(GridSize);
+
+	OutGrid.Version = Tile.GetVersion();
+	OutGrid.OpenDistances.Init(NoOpenDistance, GridSize * GridSize * GridSize);
+
+	// Cells with open space, which the distances are spread out from
+	TArray<int32> Frontier;
+
+	// Mark every cell with open space in it. Open nodes cover all of their cells, and
+	// partially blocked leaf nodes have some open voxels in theirs.
+	TArray<TPair<const FSvoNode*, FIntVector>, TInlineAllocator<64>> NodeStack;
+	NodeStack.Emplace(&Tile.GetNodeInfo(), FIntVector::ZeroValue);
+
+	while (NodeStack.Num() > 0)
+	{
+		const TPair<const FSvoNode*, FIntVector> Entry = NodeStack.Pop(false);
+		const FSvoNode* Node = Entry.Key;
+		const uint8 LayerIdx = Node->GetSelfLink().LayerIdx;
+		const int32 NodeCells = 1 << LayerIdx;
+
+		if (Node->GetNodeState() == ENodeState::Open || (Node->GetNodeState() == ENodeState::PartiallyBlocked && LayerIdx == 0))
+		{
+			for (int32 Z = 0; Z < NodeCells; ++Z)
+			{
+				for (int32 Y = 0; Y < NodeCells; ++Y)
+				{
+					for (int32 X = 0; X < NodeCells; ++X)
+					{
+						const int32 CellIdx = FSvoUtils::GetIndexForCoord(Entry.Value + FIntVector(X, Y, Z), GridExtents);
+						OutGrid.OpenDistances[CellIdx] = 0;
+						Frontier.Add(CellIdx);
+					}
+				}
+			}
+		}
+		else if (Node->GetNodeState() == ENodeState::PartiallyBlocked && Node->HasChildren())
+		{
+			const int32 ChildCells = NodeCells >> 1;
+
+			for (uint8 ChildIdx = 0; ChildIdx < 8; ++ChildIdx)
+			{
+				const FSvoNode* ChildNode = Octree.GetNodeFromLink(Node->GetChildLink(ChildIdx));
+				if (ensure(ChildNode) && ChildNode->GetNodeState() != ENodeState::Blocked)
+				{
+					const FIntVector ChildOffset((ChildIdx & 1) * ChildCells, ((ChildIdx >> 1) & 1) * ChildCells, ((ChildIdx >> 2) & 1) * ChildCells);
+					NodeStack.Emplace(ChildNode, Entry.Value + ChildOffset);
+				}
+			}
+		}
+	}
+
+	// Spread the distances out a cell at a time. Stepping to all 26 neighbors makes the
+	// distance the number of cells along the longest axis.
+	for (int32 FrontierIdx = 0; FrontierIdx < Frontier.Num(); ++FrontierIdx)
+	{
+		const int32 CellIdx = Frontier[FrontierIdx];
+		const uint8 NextDistance = OutGrid.OpenDistances[CellIdx] + 1;
+
+		FIntVector Cell;
+		FSvoUtils::GetCoordFromIndex(CellIdx, Cell, GridExtents);
+
+		for (int32 DZ = -1; DZ <= 1; ++DZ)
+		{
+			for (int32 DY = -1; DY <= 1; ++DY)
+			{
+				for (int32 DX = -1; DX <= 1; ++DX)
+				{
+					const FIntVector NeighborCell = Cell + FIntVector(DX, DY, DZ);
+					if (FSvoUtils::IsCoordValid(NeighborCell, GridExtents))
+					{
+						const int32 NeighborIdx = FSvoUtils::GetIndexForCoord(NeighborCell, GridExtents);
+						if (OutGrid.OpenDistances[NeighborIdx] > NextDistance)
+						{
+							OutGrid.OpenDistances[NeighborIdx] = NextDistance;
+							Frontier.Add(NeighborIdx);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+const FSvoNode* FSvoNearestOpen::FindNodeForCell(const FSparseVoxelOctree& Octree, const FSvoTile& Tile, const FIntVector& Cell)
+{
+	// Each layer down picks the child by the next bit of the cell coordinates, the same
+	// way the child index is built from a child coordinate (X first, then Y, then Z)
+	const FSvoNode* Node = &Tile.GetNodeInfo();
+
+	for (int32 LayerIdx = Octree.GetConfig().GetTileLayerIndex(); LayerIdx > 0; --LayerIdx)
+	{
+		if (Node->GetNodeState() != ENodeState::PartiallyBlocked || !Node->HasChildren())
+		{
+			break;
+		}
+
+		const int32 Shift = LayerIdx - 1;
+		const uint8 ChildIdx = ((Cell.X >> Shift) & 1) | (((Cell.Y >> Shift) & 1) << 1) | (((Cell.Z >> Shift) & 1) << 2);
+
+		Node = Octree.GetNodeFromLink(Node->GetChildLink(ChildIdx));
+		if (!ensure(Node))
+		{
+			return nullptr;
+		}
+	}
+
+	return Node;
+}
@@ -0,0 +1,55 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctreeNode.h"
+
+class FSparseVoxelOctree;
+class FSvoTile;
+
+//
+// Finds the closest open space to a point inside a blocked part of a tile. Each tile keeps
+// a distance transform over a grid of leaf sized cells, giving how many cells away the
+// nearest cell with any open space is, so the search can start at the right distance and
+// stop as soon as nothing closer can exist, instead of walking the tile's nodes.
+//
+// The grids are built lazily and rebuilt when the tile's version changes (see
+// FSvoTile::GetVersion).
+//
+// NOTE: Only open space within the tile containing the point is considered. If something
+// in a neighboring tile could be closer, the lookup fails and the caller is expected to
+// search for itself.
+//
+class GUNFIRE3DNAVIGATION_API FSvoNearestOpen
+{
+public:
+	// Finds the open node or voxel closest to 'Origin', filling out the closest point on
+	// it. Fails if the closest point isn't within 'QueryBounds'.
+	bool FindNearestOpenLink(const FSparseVoxelOctree& Octree, const FVector& Origin, const FBox& QueryBounds, FSvoNodeLink& OutLink, FVector& OutClosestPoint) const;
+
+	// Discards all grids
+	void Reset();
+
+	uint32 GetMemUsed() const;
+
+private:
+	// Distance of a cell with no open space anywhere in its tile
+	static constexpr uint8 NoOpenDistance = MAX_uint8;
+
+	struct FTileGrid
+	{
+		uint32 Version = 0;
+
+		// Chebyshev distance in cells from each cell to the closest cell with open space
+		TArray<uint8> OpenDistances;
+	};
+
+	static void BuildTileGrid(const FSparseVoxelOctree& Octree, const FSvoTile& Tile, FTileGrid& OutGrid);
+
+	// Finds the open node covering a cell, or the partially blocked leaf node for it
+	static const FSvoNode* FindNodeForCell(const FSparseVoxelOctree& Octree, const FSvoTile& Tile, const FIntVector& Cell);
+
+	mutable FRWLock Lock;
+
+	mutable TMap<uint32, FTileGrid> Tiles;
+};
@@ -184,6 +184,8 @@ public:
 	void SetVoxelBlocked(uint8 VoxelIdx) { ensure(IsLeafNode()); ensure(VoxelIdx < 64); Voxels |= (uint64(1) << VoxelIdx); }
 	void SetVoxelEmpty(uint8 VoxelIdx) { ensure(IsLeafNode()); ensure(VoxelIdx < 64); Voxels &= ~(uint64(1) << VoxelIdx); }
 	void ClearVoxels() { ensure(IsLeafNode()); Voxels = 0; }
+	bool AreAnyVoxelsBlocked(uint64 VoxelMask) const { ensure(IsLeafNode()); return ((Voxels & VoxelMask) != 0); }
+	uint64 GetOpenVoxels(uint64 VoxelMask) const { ensure(IsLeafNode()); return (~Voxels & VoxelMask); }
 
 	//////////////////////////////////////////////////////////////////////////////////////
 	//
@@ -201,6 +203,9 @@ public:
 
 	inline void SetNeighborLink(ESvoNeighbor Neighbor, FSvoNodeLink NeighborLink);
 
+	// Moves the node to another tile, for updating old data
+	void SetTileID(uint32 TileID) { SelfLink.TileID = TileID; }
+
 	// These shouldn't be normally used, they're just for serialization
 	uint64 GetVoxelsForSerialization() const { ensure(IsLeafNode()); return Voxels; }
 	void SetVoxelsForSerialization(uint64 VoxelsIn) { ensure(IsLeafNode()); Voxels |= VoxelsIn; }
@@ -214,18 +219,21 @@ public:
 	inline void Serialize(FArchive& Ar);
 	inline friend FArchive& operator<<(FArchive& Ar, FSvoNode& Node);
 
+	// Identifies the in-memory layout of a node (size, bit field order and endianness),
+	// so raw blocks of nodes are only read back by builds that lay them out the same way.
+	static inline uint32 GetLayoutSignature();
+
 	inline void UpdateOldNode();
 
 private:
 	// Our node info
 	FSvoNodeLink SelfLink;
 
-	// All neighbors to this node.
+	// All neighbors to this node. Neighbors only store their layer and node index, along
+	// with whether they're in the same tile or the one across the face in their direction,
+	// so the full link is rebuilt on access (see GetNeighborLink).
 	FSvoNodeLinkBase NeighborLinks[6];
 
-	// Retain padding to store additional data in the future
-	uint8 Padding[24];
-
 	// This is data that is relevant to the specific node.  Basically if it is a leaf node
 	// then this will be the voxel data otherwise it will be extra info about the node.
 	union
@@ -247,13 +255,13 @@ private:
 
 static_assert(sizeof(FSvoNodeLink) == 8, "Expected node link to be 64 bits");
 
-// This structure is optimized to fit in a cache line, so we should avoid bloating up the
-// size with extra data or a virtual function table. There should be plenty of space for
-// anything we need to add to non-leaf nodes in the voxel space, and there's extra space
-// in the neighbors user data if we needed it for leaf nodes (although would be a hassle
-// to use since we currently look for invalid nodes by checking for all the link data bits
-// being set (SVO_INVALID_NODELINK).
-static_assert(sizeof(FSvoNode) == 64, "Expected node to be 64 bytes");
+// Nodes make up nearly all of the memory used by the octree, so we should avoid bloating
+// up the size with extra data or a virtual function table. There's space for anything we
+// need to add to non-leaf nodes in the voxel space, and there's extra space in the
+// neighbors user data if we needed it for leaf nodes (although would be a hassle to use
+// since we currently look for invalid nodes by checking for all the link data bits being
+// set (SVO_INVALID_NODELINK).
+static_assert(sizeof(FSvoNode) == 40, "Expected node to be 40 bytes");
 
 FArchive& operator<<(FArchive& Ar, FSvoNodeLinkBase& NodeLinkBase)
 {
@@ -383,6 +391,12 @@ void FSvoNode::Serialize(FArchive& Ar)
 	Ar << Voxels;
 }
 
+uint32 FSvoNode::GetLayoutSignature()
+{
+	const FSvoNodeLinkBase TestLink(5, 0x2F0A5, 0x2A);
+	return HashCombine(HashCombine(TestLink.NodeID, sizeof(FSvoNode)), PLATFORM_LITTLE_ENDIAN);
+}
+
 FArchive& operator<<(FArchive& Ar, FSvoNode& Node)
 {
 	Node.Serialize(Ar);
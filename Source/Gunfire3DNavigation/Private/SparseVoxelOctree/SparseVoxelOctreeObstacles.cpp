@@ -0,0 +1,436 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeObstacles.h"
+
+#include "Gunfire3DNavigationUtils.h"
+
+// Profiling stats
+DECLARE_CYCLE_STAT(TEXT("OverlapsBox (FSvoObstacles)"), STAT_FSvoObstacles_OverlapsBox, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("CoversBox (FSvoObstacles)"), STAT_FSvoObstacles_CoversBox, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Raycast (FSvoObstacles)"), STAT_FSvoObstacles_Raycast, STATGROUP_Gunfire3DNavigation);
+
+FSvoObstacles::FSvoObstacles(float InCellSize)
+	: NumObstacles(0)
+	, CellSize(InCellSize)
+{
+	check(CellSize > 0.f);
+}
+
+uint32 FSvoObstacles::AddBox(const FBox& Box)
+{
+	if (!ensure(Box.IsValid))
+	{
+		return InvalidID;
+	}
+
+	return Add({ Box, Box.GetCenter(), 0.f, EShape::Box });
+}
+
+uint32 FSvoObstacles::AddSphere(const FVector& Center, float Radius)
+{
+	if (!ensure(Radius > 0.f))
+	{
+		return InvalidID;
+	}
+
+	return Add({ FBox(Center - FVector(Radius), Center + FVector(Radius)), Center, Radius, EShape::Sphere });
+}
+
+bool FSvoObstacles::UpdateBox(uint32 ObstacleID, const FBox& Box)
+{
+	if (!ensure(Box.IsValid))
+	{
+		return false;
+	}
+
+	return Update(ObstacleID, { Box, Box.GetCenter(), 0.f, EShape::Box });
+}
+
+bool FSvoObstacles::UpdateSphere(uint32 ObstacleID, const FVector& Center, float Radius)
+{
+	if (!ensure(Radius > 0.f))
+	{
+		return false;
+	}
+
+	return Update(ObstacleID, { FBox(Center - FVector(Radius), Center + FVector(Radius)), Center, Radius, EShape::Sphere });
+}
+
+bool FSvoObstacles::Remove(uint32 ObstacleID)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	FObstacle Obstacle;
+	if (!Obstacles.RemoveAndCopyValue(ObstacleID, Obstacle))
+	{
+		return false;
+	}
+
+	Unlink(ObstacleID, Obstacle);
+	NumObstacles.store(Obstacles.Num(), std::memory_order_relaxed);
+
+	return true;
+}
+
+void FSvoObstacles::Empty()
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	Obstacles.Empty();
+	Cells.Empty();
+	LargeObstacles.Empty();
+	NumObstacles.store(0, std::memory_order_relaxed);
+}
+
+bool FSvoObstacles::GetObstacleBounds(uint32 ObstacleID, FBox& OutBounds) const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	const FObstacle* Obstacle = Obstacles.Find(ObstacleID);
+	if (Obstacle == nullptr)
+	{
+		return false;
+	}
+
+	OutBounds = Obstacle->Bounds;
+	return true;
+}
+
+bool FSvoObstacles::OverlapsBox(const FBox& Box) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FSvoObstacles_OverlapsBox);
+
+	FReadScopeLock ReadLock(Lock);
+
+	bool bOverlaps = false;
+	ForEachObstacleInBounds(Box, [&](const FObstacle& Obstacle)
+	{
+		bOverlaps = OverlapsBox(Obstacle, Box);
+		return !bOverlaps;
+	});
+
+	return bOverlaps;
+}
+
+bool FSvoObstacles::CoversBox(const FBox& Box) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FSvoObstacles_CoversBox);
+
+	FReadScopeLock ReadLock(Lock);
+
+	bool bCovers = false;
+	ForEachObstacleInBounds(Box, [&](const FObstacle& Obstacle)
+	{
+		bCovers = CoversBox(Obstacle, Box);
+		return !bCovers;
+	});
+
+	return bCovers;
+}
+
+bool FSvoObstacles::Raycast(const FVector& RayStart, const FVector& RayEnd, float& OutHitTime) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FSvoObstacles_Raycast);
+
+	FReadScopeLock ReadLock(Lock);
+
+	const FVector RaySegment = (RayEnd - RayStart);
+	const FBox RayBounds = FBox(ForceInit) + RayStart + RayEnd;
+
+	OutHitTime = MAX_flt;
+	ForEachObstacleInBounds(RayBounds, [&](const FObstacle& Obstacle)
+	{
+		float HitTime;
+		if (Raycast(Obstacle, RayStart, RaySegment, HitTime))
+		{
+			OutHitTime = FMath::Min(OutHitTime, HitTime);
+		}
+
+		// Nothing can be hit before the start of the ray
+		return OutHitTime > 0.f;
+	});
+
+	return OutHitTime != MAX_flt;
+}
+
+uint32 FSvoObstacles::GetMemUsed() const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	uint32 MemUsed = sizeof(*this);
+	MemUsed += Obstacles.GetAllocatedSize();
+	MemUsed += Cells.GetAllocatedSize();
+	MemUsed += LargeObstacles.GetAllocatedSize();
+
+	for (const auto& Cell : Cells)
+	{
+		MemUsed += Cell.Value.GetAllocatedSize();
+	}
+
+	return MemUsed;
+}
+
+uint32 FSvoObstacles::Add(const FObstacle& Obstacle)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	uint32 ObstacleID = ++LastObstacleID;
+	if (ObstacleID == InvalidID)
+	{
+		ObstacleID = ++LastObstacleID;
+	}
+
+	Obstacles.Add(ObstacleID, Obstacle);
+	Link(ObstacleID, Obstacle);
+	NumObstacles.store(Obstacles.Num(), std::memory_order_relaxed);
+
+	return ObstacleID;
+}
+
+bool FSvoObstacles::Update(uint32 ObstacleID, const FObstacle& Obstacle)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	FObstacle* ExistingObstacle = Obstacles.Find(ObstacleID);
+	if (ExistingObstacle == nullptr)
+	{
+		return false;
+	}
+
+	// Obstacles that move every frame usually stay within the same cells, in which case
+	// the grid doesn't need to change.
+	FIntVector OldMin, OldMax, NewMin, NewMax;
+	GetCellRange(ExistingObstacle->Bounds, OldMin, OldMax);
+	GetCellRange(Obstacle.Bounds, NewMin, NewMax);
+
+	if (OldMin != NewMin || OldMax != NewMax)
+	{
+		Unlink(ObstacleID, *ExistingObstacle);
+		Link(ObstacleID, Obstacle);
+	}
+
+	*ExistingObstacle = Obstacle;
+	return true;
+}
+
+void FSvoObstacles::Link(uint32 ObstacleID, const FObstacle& Obstacle)
+{
+	FIntVector CellMin, CellMax;
+	GetCellRange(Obstacle.Bounds, CellMin, CellMax);
+
+	const FIntVector CellCount = (CellMax - CellMin) + FIntVector(1);
+	if ((int64)CellCount.X * CellCount.Y * CellCount.Z > MaxCellsPerObstacle)
+	{
+		LargeObstacles.Add(ObstacleID);
+		return;
+	}
+
+	for (int32 Z = CellMin.Z; Z <= CellMax.Z; ++Z)
+	{
+		for (int32 Y = CellMin.Y; Y <= CellMax.Y; ++Y)
+		{
+			for (int32 X = CellMin.X; X <= CellMax.X; ++X)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(ObstacleID);
+			}
+		}
+	}
+}
+
+void FSvoObstacles::Unlink(uint32 ObstacleID, const FObstacle& Obstacle)
+{
+	FIntVector CellMin, CellMax;
+	GetCellRange(Obstacle.Bounds, CellMin, CellMax);
+
+	const FIntVector CellCount = (CellMax - CellMin) + FIntVector(1);
+	if ((int64)CellCount.X * CellCount.Y * CellCount.Z > MaxCellsPerObstacle)
+	{
+		LargeObstacles.RemoveSingleSwap(ObstacleID, false);
+		return;
+	}
+
+	for (int32 Z = CellMin.Z; Z <= CellMax.Z; ++Z)
+	{
+		for (int32 Y = CellMin.Y; Y <= CellMax.Y; ++Y)
+		{
+			for (int32 X = CellMin.X; X <= CellMax.X; ++X)
+			{
+				const FIntVector CellCoord(X, Y, Z);
+				if (auto* CellObstacles = Cells.Find(CellCoord))
+				{
+					CellObstacles->RemoveSingleSwap(ObstacleID, false);
+					if (CellObstacles->Num() == 0)
+					{
+						Cells.Remove(CellCoord);
+					}
+				}
+			}
+		}
+	}
+}
+
+void FSvoObstacles::GetCellRange(const FBox& Bounds, FIntVector& OutMin, FIntVector& OutMax) const
+{
+	const float InvCellSize = 1.f / CellSize;
+	OutMin = FIntVector(
+		FMath::FloorToInt(Bounds.Min.X * InvCellSize),
+		FMath::FloorToInt(Bounds.Min.Y * InvCellSize),
+		FMath::FloorToInt(Bounds.Min.Z * InvCellSize));
+	OutMax = FIntVector(
+		FMath::FloorToInt(Bounds.Max.X * InvCellSize),
+		FMath::FloorToInt(Bounds.Max.Y * InvCellSize),
+		FMath::FloorToInt(Bounds.Max.Z * InvCellSize));
+}
+
+template<typename TFunc>
+void FSvoObstacles::ForEachObstacleInBounds(const FBox& Bounds, const TFunc& Func) const
+{
+	for (uint32 ObstacleID : LargeObstacles)
+	{
+		if (!Func(Obstacles.FindChecked(ObstacleID)))
+		{
+			return;
+		}
+	}
+
+	if (Cells.Num() == 0)
+	{
+		return;
+	}
+
+	FIntVector CellMin, CellMax;
+	GetCellRange(Bounds, CellMin, CellMax);
+
+	// Large query bounds (e.g. a long ray) would visit mostly empty cells, so just test
+	// every obstacle instead.
+	const FIntVector CellCount = (CellMax - CellMin) + FIntVector(1);
+	if ((int64)CellCount.X * CellCount.Y * CellCount.Z > Cells.Num())
+	{
+		for (const auto& Obstacle : Obstacles)
+		{
+			if (!Func(Obstacle.Value))
+			{
+				return;
+			}
+		}
+
+		return;
+	}
+
+	for (int32 Z = CellMin.Z; Z <= CellMax.Z; ++Z)
+	{
+		for (int32 Y = CellMin.Y; Y <= CellMax.Y; ++Y)
+		{
+			for (int32 X = CellMin.X; X <= CellMax.X; ++X)
+			{
+				if (const auto* CellObstacles = Cells.Find(FIntVector(X, Y, Z)))
+				{
+					for (uint32 ObstacleID : *CellObstacles)
+					{
+						if (!Func(Obstacles.FindChecked(ObstacleID)))
+						{
+							return;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+bool FSvoObstacles::OverlapsBox(const FObstacle& Obstacle, const FBox& Box)
+{
+	const FBox& Bounds = Obstacle.Bounds;
+	if (Bounds.Min.X >= Box.Max.X || Box.Min.X >= Bounds.Max.X ||
+		Bounds.Min.Y >= Box.Max.Y || Box.Min.Y >= Bounds.Max.Y ||
+		Bounds.Min.Z >= Box.Max.Z || Box.Min.Z >= Bounds.Max.Z)
+	{
+		return false;
+	}
+
+	if (Obstacle.Shape == EShape::Sphere)
+	{
+		const FVector ClosestPoint = Obstacle.Center.BoundToBox(Box.Min, Box.Max);
+		return FVector::DistSquared(ClosestPoint, Obstacle.Center) < FMath::Square(Obstacle.Radius);
+	}
+
+	return true;
+}
+
+bool FSvoObstacles::CoversBox(const FObstacle& Obstacle, const FBox& Box)
+{
+	const FBox& Bounds = Obstacle.Bounds;
+	if (Box.Min.X < Bounds.Min.X || Box.Max.X > Bounds.Max.X ||
+		Box.Min.Y < Bounds.Min.Y || Box.Max.Y > Bounds.Max.Y ||
+		Box.Min.Z < Bounds.Min.Z || Box.Max.Z > Bounds.Max.Z)
+	{
+		return false;
+	}
+
+	if (Obstacle.Shape == EShape::Sphere)
+	{
+		// The corner furthest from the center has to be inside
+		const FVector FurthestOffset = (Box.Min - Obstacle.Center).GetAbs().ComponentMax((Box.Max - Obstacle.Center).GetAbs());
+		return FurthestOffset.SizeSquared() <= FMath::Square(Obstacle.Radius);
+	}
+
+	return true;
+}
+
+bool FSvoObstacles::Raycast(const FObstacle& Obstacle, const FVector& RayStart, const FVector& RaySegment, float& OutHitTime)
+{
+	if (Obstacle.Shape == EShape::Sphere)
+	{
+		// Solve |RayStart + RaySegment * T - Center| = Radius for the first T
+		const FVector StartToCenter = (RayStart - Obstacle.Center);
+		const float C = StartToCenter.SizeSquared() - FMath::Square(Obstacle.Radius);
+		if (C <= 0.f)
+		{
+			OutHitTime = 0.f;
+			return true;
+		}
+
+		const float A = RaySegment.SizeSquared();
+		const float B = 2.f * FVector::DotProduct(StartToCenter, RaySegment);
+		const float Discriminant = FMath::Square(B) - 4.f * A * C;
+		if (A <= 0.f || Discriminant < 0.f)
+		{
+			return false;
+		}
+
+		OutHitTime = (-B - FMath::Sqrt(Discriminant)) / (2.f * A);
+		return (OutHitTime >= 0.f && OutHitTime <= 1.f);
+	}
+
+	if (Obstacle.Bounds.IsInside(RayStart))
+	{
+		OutHitTime = 0.f;
+		return true;
+	}
+
+	// Since the direction isn't normalized, the parameters are already relative to the
+	// length of the segment.
+	float MinT, MaxT;
+	if (FGunfire3DNavigationUtils::RayAABBIntersect(RayStart, RaySegment, Obstacle.Bounds, MinT, MaxT) && MinT <= 1.f)
+	{
+		OutHitTime = FMath::Max(MinT, 0.f);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,125 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+//
+// Runtime overlay of blocked shapes which queries treat as solid on top of the generated
+// octree. Moving or short-lived obstacles can be registered here instead of dirtying
+// and rebuilding the tiles they overlap.
+//
+// Obstacles are bucketed into a uniform grid so a query only needs to test the few near
+// the space it's checking.
+//
+// Searches close any leaf node or voxel an obstacle overlaps. Larger open nodes can be
+// far bigger than an obstacle in them, so they're only closed once one covers them
+// completely (see FSparseVoxelOctree::IsNodeClosedByObstacle). Otherwise only the
+// straight line between the portals a path crosses them through is tested, which means
+// a way around an obstacle inside the node is missed if that line is blocked.
+//
+// NOTE: Thread-safe, since queries may run on background threads while obstacles are
+// being moved on the game thread.
+//
+class GUNFIRE3DNAVIGATION_API FSvoObstacles
+{
+public:
+	// Zero is never used as an obstacle ID
+	static constexpr uint32 InvalidID = 0;
+
+	FSvoObstacles(float InCellSize);
+
+	// Adds an obstacle, returning the ID to update or remove it with
+	uint32 AddBox(const FBox& Box);
+	uint32 AddSphere(const FVector& Center, float Radius);
+
+	// Moves or resizes an existing obstacle. Returns false if the ID isn't registered.
+	bool UpdateBox(uint32 ObstacleID, const FBox& Box);
+	bool UpdateSphere(uint32 ObstacleID, const FVector& Center, float Radius);
+
+	// Removes an obstacle. Returns false if the ID isn't registered.
+	bool Remove(uint32 ObstacleID);
+
+	// Removes all obstacles
+	void Empty();
+
+	// Returns true if there are no obstacles, which lets queries skip testing against
+	// them entirely.
+	bool IsEmpty() const { return NumObstacles.load(std::memory_order_relaxed) == 0; }
+
+	// Returns the bounds of an obstacle, if it's registered
+	bool GetObstacleBounds(uint32 ObstacleID, FBox& OutBounds) const;
+
+	// Returns true if any obstacle overlaps the box. Touching the surface of the box
+	// isn't counted as overlapping, so nodes next to an obstacle stay open.
+	bool OverlapsBox(const FBox& Box) const;
+
+	// Returns true if a single obstacle covers the whole box
+	bool CoversBox(const FBox& Box) const;
+
+	// Finds the first obstacle hit by the segment, filling 'OutHitTime' with the
+	// parameter along the segment (0-1) of the hit.
+	bool Raycast(const FVector& RayStart, const FVector& RayEnd, float& OutHitTime) const;
+
+	// Returns the amount of memory used by the obstacles
+	uint32 GetMemUsed() const;
+
+private:
+	enum class EShape : uint8
+	{
+		Box,
+		Sphere,
+	};
+
+	struct FObstacle
+	{
+		FBox Bounds;
+		FVector Center;
+		float Radius;
+		EShape Shape;
+	};
+
+	// Obstacles covering more cells than this are kept in a separate list which is
+	// always tested, rather than being added to every cell.
+	static constexpr int32 MaxCellsPerObstacle = 64;
+
+	uint32 Add(const FObstacle& Obstacle);
+	bool Update(uint32 ObstacleID, const FObstacle& Obstacle);
+
+	// Adds or removes an obstacle from the grid. Must be called with the write lock held.
+	void Link(uint32 ObstacleID, const FObstacle& Obstacle);
+	void Unlink(uint32 ObstacleID, const FObstacle& Obstacle);
+
+	// Returns the range of cells overlapped by the bounds
+	void GetCellRange(const FBox& Bounds, FIntVector& OutMin, FIntVector& OutMax) const;
+
+	// Calls 'Func' with each obstacle whose cells overlap the bounds. Obstacles may be
+	// visited more than once. Return false from 'Func' to stop. Must be called with the
+	// read lock held.
+	template<typename TFunc>
+	void ForEachObstacleInBounds(const FBox& Bounds, const TFunc& Func) const;
+
+	static bool OverlapsBox(const FObstacle& Obstacle, const FBox& Box);
+	static bool CoversBox(const FObstacle& Obstacle, const FBox& Box);
+	static bool Raycast(const FObstacle& Obstacle, const FVector& RayStart, const FVector& RaySegment, float& OutHitTime);
+
+	mutable FRWLock Lock;
+
+	TMap<uint32, FObstacle> Obstacles;
+
+	// IDs of the obstacles overlapping each cell of the grid
+	TMap<FIntVector, TArray<uint32, TInlineAllocator<4>>> Cells;
+
+	// Obstacles too large to be added to the grid (see MaxCellsPerObstacle)
+	TArray<uint32> LargeObstacles;
+
+	std::atomic<int32> NumObstacles;
+
+	uint32 LastObstacleID = InvalidID;
+
+	const float CellSize;
+};
+
+typedef TSharedPtr<FSvoObstacles, ESPMode::ThreadSafe> FSvoObstaclesSharedPtr;
@@ -0,0 +1,362 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeRandomPoints.h"
+
+#include "SparseVoxelOctree.h"
+
+#include "Algo/BinarySearch.h"
+
+DECLARE_CYCLE_STAT(TEXT("SvoRandomPoints Update"), STAT_SvoRandomPoints_Update, STATGROUP_Gunfire3DNavigation);
+
+namespace SvoRandomPoints
+{
+	// How many points are picked within the tiles overlapping a radius before giving up
+	// on finding one inside it
+	constexpr int32 MaxRadiusAttempts = 16;
+
+	// FMath::Rand is only 15 bits on some platforms, which is nowhere near enough to pick
+	// between millions of cells, so each thread has its own stream.
+	FRandomStream& GetThreadStream()
+	{
+		thread_local FRandomStream ThreadStream(FPlatformTime::Cycles() ^ FPlatformTLS::GetCurrentThreadId());
+		return ThreadStream;
+	}
+
+	FVector RandPointInBox(FRandomStream& Stream, const FBox& Box)
+	{
+		return FVector(
+			FMath::Lerp(Box.Min.X, Box.Max.X, (double)Stream.GetFraction()),
+			FMath::Lerp(Box.Min.Y, Box.Max.Y, (double)Stream.GetFraction()),
+			FMath::Lerp(Box.Min.Z, Box.Max.Z, (double)Stream.GetFraction()));
+	}
+
+	// Returns the index of the Nth set bit
+	uint8 GetNthSetBit(uint64 Bits, int32 N)
+	{
+		for (uint8 BitIdx = 0; BitIdx < 64; ++BitIdx)
+		{
+			if ((Bits & (1ull << BitIdx)) != 0 && N-- == 0)
+			{
+				return BitIdx;
+			}
+		}
+
+		return 0;
+	}
+}
+
+void FSvoRandomPoints::FAliasTable::Build(TArrayView<const double> Weights)
+{
+	Reset();
+
+	double TotalWeight = 0.0;
+	for (double Weight : Weights)
+	{
+		TotalWeight += Weight;
+	}
+
+	const int32 NumWeights = Weights.Num();
+	if (NumWeights == 0 || TotalWeight <= 0.0)
+	{
+		return;
+	}
+
+	Probabilities.SetNumUninitialized(NumWeights);
+	Aliases.SetNumUninitialized(NumWeights);
+
+	// Scale the weights so they average to one, and split them into the entries under
+	// and over the average (Vose's method).
+	TArray<double> ScaledWeights;
+	ScaledWeights.SetNumUninitialized(NumWeights);
+
+	TArray<int32> Small;
+	TArray<int32> Large;
+
+	for (int32 WeightIdx = 0; WeightIdx < NumWeights; ++WeightIdx)
+	{
+		ScaledWeights[WeightIdx] = Weights[WeightIdx] * NumWeights / TotalWeight;
+		(ScaledWeights[WeightIdx] < 1.0 ? Small : Large).Add(WeightIdx);
+	}
+
+	// Top up each small entry from a large one, which then goes back into whichever list
+	// it now belongs in.
+	while (Small.Num() > 0 && Large.Num() > 0)
+	{
+		const int32 SmallIdx = Small.Pop(false);
+		const int32 LargeIdx = Large.Last();
+
+		Probabilities[SmallIdx] = (float)ScaledWeights[SmallIdx];
+		Aliases[SmallIdx] = LargeIdx;
+
+		ScaledWeights[LargeIdx] = (ScaledWeights[LargeIdx] + ScaledWeights[SmallIdx]) - 1.0;
+		if (ScaledWeights[LargeIdx] < 1.0)
+		{
+			Large.Pop(false);
+			Small.Add(LargeIdx);
+		}
+	}
+
+	// Anything left over is only off from one due to rounding
+	for (int32 WeightIdx : Large)
+	{
+		Probabilities[WeightIdx] = 1.f;
+		Aliases[WeightIdx] = WeightIdx;
+	}
+
+	for (int32 WeightIdx : Small)
+	{
+		Probabilities[WeightIdx] = 1.f;
+		Aliases[WeightIdx] = WeightIdx;
+	}
+}
+
+void FSvoRandomPoints::FAliasTable::Reset()
+{
+	Probabilities.Reset();
+	Aliases.Reset();
+}
+
+bool FSvoRandomPoints::GetRandomPoint(const FSparseVoxelOctree& Octree, uint32 EditVersion, FVector& OutLocation, FSvoNodeLink& OutLink) const
+{
+	Update(Octree, EditVersion);
+
+	FReadScopeLock ReadLock(Lock);
+
+	if (TileTable.Num() == 0)
+	{
+		return false;
+	}
+
+	FRandomStream& Stream = SvoRandomPoints::GetThreadStream();
+
+	const int32 OpenTileIdx = TileTable.Sample(Stream.GetUnsignedInt(), Stream.GetFraction());
+	const FTileSamples& Samples = Tiles.FindChecked(OpenTileIDs[OpenTileIdx]);
+
+	return SampleTile(Octree, Samples, Stream, OutLocation, OutLink);
+}
+
+bool FSvoRandomPoints::GetRandomPointInRadius(const FSparseVoxelOctree& Octree, uint32 EditVersion, const FVector& Origin, float Radius, TFunctionRef<bool(const FSvoNodeLink&)> Filter, FVector& OutLocation, FSvoNodeLink& OutLink) const
+{
+	Update(Octree, EditVersion);
+
+	FReadScopeLock ReadLock(Lock);
+
+	// Only the tiles overlapping the radius can be picked from, so pick between them
+	// with a running sum of their volumes.
+	TArray<const FTileSamples*, TInlineAllocator<64>> RadiusTiles;
+	TArray<double, TInlineAllocator<64>> VolumeSums;
+	double TotalVolume = 0.0;
+
+	Octree.GetTilesInBounds(FBox(Origin - FVector(Radius), Origin + FVector(Radius)), [&](const FSvoTile& Tile)
+	{
+		const FTileSamples* Samples = Tiles.Find(Tile.GetID());
+		if (Samples != nullptr && Samples->OpenVolume > 0.0)
+		{
+			TotalVolume += Samples->OpenVolume;
+			RadiusTiles.Add(Samples);
+			VolumeSums.Add(TotalVolume);
+		}
+
+		return true;
+	});
+
+	if (RadiusTiles.Num() == 0)
+	{
+		return false;
+	}
+
+	FRandomStream& Stream = SvoRandomPoints::GetThreadStream();
+	const double RadiusSqrd = FMath::Square((double)Radius);
+
+	// Points are picked over the whole of each tile and rejected if they're outside the
+	// radius, which keeps them uniform over the open space within it.
+	for (int32 Attempt = 0; Attempt < SvoRandomPoints::MaxRadiusAttempts; ++Attempt)
+	{
+		const double VolumeRand = Stream.GetFraction() * TotalVolume;
+		const int32 RadiusTileIdx = FMath::Min(Algo::UpperBound(VolumeSums, VolumeRand), RadiusTiles.Num() - 1);
+
+		FVector Location;
+		FSvoNodeLink Link;
+		if (SampleTile(Octree, *RadiusTiles[RadiusTileIdx], Stream, Location, Link) &&
+			FVector::DistSquared(Origin, Location) <= RadiusSqrd &&
+			Filter(Link))
+		{
+			OutLocation = Location;
+			OutLink = Link;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FSvoRandomPoints::Reset()
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	Tiles.Empty();
+	OpenTileIDs.Empty();
+	TileTable.Reset();
+	bBuilt = false;
+}
+
+uint32 FSvoRandomPoints::GetMemUsed() const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	uint32 MemUsed = Tiles.GetAllocatedSize() + OpenTileIDs.GetAllocatedSize() + TileTable.GetMemUsed();
+
+	for (const TPair<uint32, FTileSamples>& TileSamples : Tiles)
+	{
+		MemUsed += TileSamples.Value.Cells.GetAllocatedSize() + TileSamples.Value.Table.GetMemUsed();
+	}
+
+	return MemUsed;
+}
+
+void FSvoRandomPoints::Update(const FSparseVoxelOctree& Octree, uint32 EditVersion) const
+{
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (bBuilt && BuiltEditVersion == EditVersion)
+		{
+			return;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Lock);
+
+	// Another thread may have rebuilt the tables while we waited for the lock
+	if (bBuilt && BuiltEditVersion == EditVersion)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_SvoRandomPoints_Update);
+
+	TSet<uint32> ActiveTileIDs;
+	ActiveTileIDs.Reserve(Octree.GetNumTiles());
+
+	for (const FSvoTile& Tile : Octree.GetTiles())
+	{
+		ActiveTileIDs.Add(Tile.GetID());
+
+		FTileSamples* Samples = Tiles.Find(Tile.GetID());
+		if (Samples == nullptr || Samples->Version != Tile.GetVersion())
+		{
+			BuildTileSamples(Octree, Tile, Tiles.FindOrAdd(Tile.GetID()));
+		}
+	}
+
+	// Drop the tiles which have been removed
+	for (auto It = Tiles.CreateIterator(); It; ++It)
+	{
+		if (!ActiveTileIDs.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	OpenTileIDs.Reset();
+
+	TArray<double> TileVolumes;
+	TileVolumes.Reserve(Tiles.Num());
+
+	for (const TPair<uint32, FTileSamples>& TileSamples : Tiles)
+	{
+		if (TileSamples.Value.OpenVolume > 0.0)
+		{
+			OpenTileIDs.Add(TileSamples.Key);
+			TileVolumes.Add(TileSamples.Value.OpenVolume);
+		}
+	}
+
+	TileTable.Build(TileVolumes);
+
+	BuiltEditVersion = EditVersion;
+	bBuilt = true;
+}
+
+void FSvoRandomPoints::BuildTileSamples(const FSparseVoxelOctree& Octree, const FSvoTile& Tile, FTileSamples& OutSamples)
+{
+	const FSvoConfig& Config = Octree.GetConfig();
+	const uint8 TileLayerIdx = Config.GetTileLayerIndex();
+	const double VoxelVolume = FMath::Cube((double)Config.GetVoxelSize());
+
+	OutSamples.Version = Tile.GetVersion();
+	OutSamples.OpenVolume = 0.0;
+	OutSamples.Cells.Reset();
+	OutSamples.Table.Reset();
+
+	TArray<double> CellVolumes;
+
+	auto AddCell = [&OutSamples, &CellVolumes](FSvoNodeLink Link, uint64 OpenVoxels, double Volume)
+	{
+		OutSamples.Cells.Add({ Link, OpenVoxels });
+		CellVolumes.Add(Volume);
+		OutSamples.OpenVolume += Volume;
+	};
+
+	const FSvoNode& TileNode = Tile.GetNodeInfo();
+	if (TileNode.GetNodeState() == ENodeState::Open)
+	{
+		AddCell(Tile.GetSelfLink(), 0, FMath::Cube((double)Config.GetResolutionForLayer(TileLayerIdx)));
+	}
+	else if (Tile.HasNodesAllocated())
+	{
+		for (uint8 LayerIdx = 0; LayerIdx < TileLayerIdx; ++LayerIdx)
+		{
+			const double NodeVolume = FMath::Cube((double)Config.GetResolutionForLayer(LayerIdx));
+
+			for (const FSvoNode& Node : Tile.GetNodesForLayer(LayerIdx))
+			{
+				if (Node.IsLeafNode())
+				{
+					const uint64 OpenVoxels = ~Node.GetVoxelsForSerialization();
+					if (OpenVoxels != 0)
+					{
+						AddCell(Node.GetSelfLink(), (OpenVoxels == ~0ull) ? 0 : OpenVoxels, FMath::CountBits(OpenVoxels) * VoxelVolume);
+					}
+				}
+				else if (Node.GetNodeState() == ENodeState::Open)
+				{
+					AddCell(Node.GetSelfLink(), 0, NodeVolume);
+				}
+			}
+		}
+	}
+
+	OutSamples.Cells.Shrink();
+	OutSamples.Table.Build(CellVolumes);
+}
+
+bool FSvoRandomPoints::SampleTile(const FSparseVoxelOctree& Octree, const FTileSamples& Samples, FRandomStream& Stream, FVector& OutLocation, FSvoNodeLink& OutLink)
+{
+	if (Samples.Table.Num() == 0)
+	{
+		return false;
+	}
+
+	const FCell& Cell = Samples.Cells[Samples.Table.Sample(Stream.GetUnsignedInt(), Stream.GetFraction())];
+
+	OutLink = Cell.Link;
+
+	// Leaf nodes with blocked voxels pick one of their open voxels, which all have the
+	// same volume
+	if (Cell.OpenVoxels != 0)
+	{
+		const int32 NumOpenVoxels = FMath::CountBits(Cell.OpenVoxels);
+		const int32 OpenVoxelIdx = FMath::Min((int32)(Stream.GetFraction() * NumOpenVoxels), NumOpenVoxels - 1);
+
+		OutLink = FSvoNodeLink(Cell.Link.TileID, Cell.Link.LayerIdx, Cell.Link.NodeIdx, SvoRandomPoints::GetNthSetBit(Cell.OpenVoxels, OpenVoxelIdx));
+	}
+
+	FBox Bounds;
+	if (!Octree.GetBoundsForLink(OutLink, Bounds))
+	{
+		return false;
+	}
+
+	OutLocation = SvoRandomPoints::RandPointInBox(Stream, Bounds);
+	return true;
+}
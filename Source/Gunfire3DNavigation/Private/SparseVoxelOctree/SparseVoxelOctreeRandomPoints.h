@@ -0,0 +1,98 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctreeNode.h"
+
+class FSparseVoxelOctree;
+class FSvoTile;
+
+//
+// Samples random points uniformly over the open space of an octree. Every open node and
+// voxel is weighted by its volume in an alias table (Walker's method) for each tile, and
+// the tiles are weighted by their open volume in another, so picking a point is constant
+// time however large the octree is.
+//
+// The tables are rebuilt lazily, and only for the tiles whose version changed since they
+// were last built (see FSvoTile::GetVersion).
+//
+// NOTE: Safe to sample from multiple threads at once, as long as the octree isn't being
+// edited at the same time.
+//
+class GUNFIRE3DNAVIGATION_API FSvoRandomPoints
+{
+public:
+	// Picks a point anywhere in the open space of the octree
+	bool GetRandomPoint(const FSparseVoxelOctree& Octree, uint32 EditVersion, FVector& OutLocation, FSvoNodeLink& OutLink) const;
+
+	// Picks a point in the open space within 'Radius' of 'Origin'. Only tiles overlapping
+	// the radius are considered, but the points picked from them may still fall outside,
+	// so this gives up after a few tries. Points returned are also passed by 'Filter'.
+	bool GetRandomPointInRadius(const FSparseVoxelOctree& Octree, uint32 EditVersion, const FVector& Origin, float Radius, TFunctionRef<bool(const FSvoNodeLink&)> Filter, FVector& OutLocation, FSvoNodeLink& OutLink) const;
+
+	// Discards all tables
+	void Reset();
+
+	uint32 GetMemUsed() const;
+
+private:
+	// Walker's alias table. Each entry is either picked itself, or its alias, which lets
+	// a weighted pick be done with a single uniform index and coin flip.
+	struct FAliasTable
+	{
+		TArray<float> Probabilities;
+		TArray<int32> Aliases;
+
+		void Build(TArrayView<const double> Weights);
+		void Reset();
+
+		int32 Num() const { return Probabilities.Num(); }
+
+		// Takes a random 32-bit value for the index and a value in [0-1) for the coin
+		int32 Sample(uint32 IndexRand, float CoinRand) const
+		{
+			const int32 Idx = (int32)(((uint64)IndexRand * (uint64)Probabilities.Num()) >> 32);
+			return (CoinRand < Probabilities[Idx]) ? Idx : Aliases[Idx];
+		}
+
+		uint32 GetMemUsed() const { return Probabilities.GetAllocatedSize() + Aliases.GetAllocatedSize(); }
+	};
+
+	// An open node, or the open voxels of a leaf node
+	struct FCell
+	{
+		FSvoNodeLink Link;
+
+		// The open voxels, if this is a leaf node, or zero if the whole node is open
+		uint64 OpenVoxels;
+	};
+
+	struct FTileSamples
+	{
+		uint32 Version = 0;
+		double OpenVolume = 0.0;
+		TArray<FCell> Cells;
+		FAliasTable Table;
+	};
+
+	// Brings the tables up to date with the octree, if it's been edited since they were
+	// last built. Takes the write lock while anything is rebuilt, so it must be called
+	// without the lock held.
+	void Update(const FSparseVoxelOctree& Octree, uint32 EditVersion) const;
+
+	static void BuildTileSamples(const FSparseVoxelOctree& Octree, const FSvoTile& Tile, FTileSamples& OutSamples);
+
+	// Picks a point within a random cell of a tile
+	static bool SampleTile(const FSparseVoxelOctree& Octree, const FTileSamples& Samples, FRandomStream& Stream, FVector& OutLocation, FSvoNodeLink& OutLink);
+
+	mutable FRWLock Lock;
+
+	mutable TMap<uint32, FTileSamples> Tiles;
+
+	// The tiles with any open space and the table picking between them by volume
+	mutable TArray<uint32> OpenTileIDs;
+	mutable FAliasTable TileTable;
+
+	mutable uint32 BuiltEditVersion = 0;
+	mutable bool bBuilt = false;
+};
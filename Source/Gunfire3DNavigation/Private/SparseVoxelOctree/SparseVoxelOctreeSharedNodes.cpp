@@ -0,0 +1,82 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeSharedNodes.h"
+
+DECLARE_CYCLE_STAT(TEXT("Share (FSvoSharedNodePools)"), STAT_FSvoSharedNodePools_Share, STATGROUP_Gunfire3DNavigation);
+
+namespace SvoSharedNodes
+{
+	typedef TWeakPtr<const TArray<FSvoNode>, ESPMode::ThreadSafe> FWeakPoolPtr;
+
+	// Entries for pools nobody uses anymore are only removed when a pool with the same
+	// hash is shared, so every so often all of them are swept out.
+	constexpr int32 PurgeInterval = 1024;
+
+	FCriticalSection Lock;
+
+	// Pools keyed by a hash of their nodes
+	TMultiMap<uint32, FWeakPoolPtr> Pools;
+
+	int32 NumAddedSincePurge = 0;
+}
+
+FSvoSharedNodePools::FPoolPtr FSvoSharedNodePools::Share(TArray<FSvoNode>&& Nodes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoSharedNodePools_Share);
+
+	const int64 NumBytes = (int64)Nodes.Num() * sizeof(FSvoNode);
+	const uint32 Hash = FCrc::MemCrc32(Nodes.GetData(), NumBytes);
+
+	FScopeLock Lock(&SvoSharedNodes::Lock);
+
+	for (auto It = SvoSharedNodes::Pools.CreateKeyIterator(Hash); It; ++It)
+	{
+		FPoolPtr Pool = It.Value().Pin();
+		if (!Pool.IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		if (Pool->Num() == Nodes.Num() && FMemory::Memcmp(Pool->GetData(), Nodes.GetData(), NumBytes) == 0)
+		{
+			Nodes.Empty();
+			return Pool;
+		}
+	}
+
+	FPoolPtr NewPool = MakeShared<TArray<FSvoNode>, ESPMode::ThreadSafe>(MoveTemp(Nodes));
+	SvoSharedNodes::Pools.Add(Hash, NewPool);
+
+	if (++SvoSharedNodes::NumAddedSincePurge >= SvoSharedNodes::PurgeInterval)
+	{
+		SvoSharedNodes::NumAddedSincePurge = 0;
+
+		for (auto It = SvoSharedNodes::Pools.CreateIterator(); It; ++It)
+		{
+			if (!It.Value().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	return NewPool;
+}
+
+void FSvoSharedNodePools::GetStats(int32& OutNumPools, uint64& OutMemUsed)
+{
+	OutNumPools = 0;
+	OutMemUsed = 0;
+
+	FScopeLock Lock(&SvoSharedNodes::Lock);
+
+	for (const TPair<uint32, SvoSharedNodes::FWeakPoolPtr>& PoolPair : SvoSharedNodes::Pools)
+	{
+		if (FPoolPtr Pool = PoolPair.Value.Pin())
+		{
+			++OutNumPools;
+			OutMemUsed += Pool->GetAllocatedSize();
+		}
+	}
+}
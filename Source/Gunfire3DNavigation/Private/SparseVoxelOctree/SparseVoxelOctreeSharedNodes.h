@@ -0,0 +1,29 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctreeNode.h"
+
+//
+// Process-wide registry of read-only tile node pools. When the same octree is loaded more
+// than once (a level in several worlds, PIE duplicating the editor world, or multiple
+// server instances hosted in one process) the identical tiles end up sharing a single
+// copy of their nodes rather than each holding their own (see FSvoTile::ShareNodes).
+//
+// Pools are reference counted by the tiles using them and dropped from the registry
+// once the last one lets go.
+//
+// NOTE: Thread-safe.
+//
+class GUNFIRE3DNAVIGATION_API FSvoSharedNodePools
+{
+public:
+	typedef TSharedPtr<const TArray<FSvoNode>, ESPMode::ThreadSafe> FPoolPtr;
+
+	// Returns the shared pool holding the same nodes, adding 'Nodes' as a new one if
+	// there isn't one yet
+	static FPoolPtr Share(TArray<FSvoNode>&& Nodes);
+
+	// Returns the number of pools being shared and the memory used by their nodes
+	static void GetStats(int32& OutNumPools, uint64& OutMemUsed);
+};
@@ -4,10 +4,29 @@
 
 #include "Gunfire3DNavigationCustomVersion.h"
 #include "SparseVoxelOctree.h"
+#include "SparseVoxelOctreeSharedNodes.h"
+#include "SparseVoxelOctreeTileStore.h"
 #include "SparseVoxelOctreeUtils.h"
 
+#include "Algo/BinarySearch.h"
+#include "Misc/Compression.h"
+
 // Profiling stats
 DECLARE_CYCLE_STAT(TEXT("TrimExcessNodes (FSvoLayer)"), STAT_FSvoLayer_TrimExcessNodes, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("CompressNodes (FSvoTile)"), STAT_FSvoTile_CompressNodes, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("InflateNodes (FSvoTile)"), STAT_FSvoTile_InflateNodes, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("EvictNodes (FSvoTile)"), STAT_FSvoTile_EvictNodes, STATGROUP_Gunfire3DNavigation);
+
+namespace SvoColdTiles
+{
+	// Tiles are only kept compressed if it saves at least this fraction of their nodes'
+	// memory, since every inflation costs a stall on the thread that needed the nodes.
+	constexpr float MinSavings = 0.5f;
+
+	// Serializes inflation across all tiles. Inflating is rare enough that there's no
+	// need for a lock per tile.
+	FCriticalSection InflateLock;
+}
 
 FSvoTile::FSvoTile(uint32 TileID, uint8 TileLayerIdx, const FIntVector& TileCoord)
 	: Coord(TileCoord)
@@ -44,10 +63,251 @@ void FSvoTile::AllocateNodes(uint32 NumNodes, uint8 NumLayers)
 	}
 }
 
+void FSvoTile::AllocateNodes(TArrayView<const uint32> LayerMaxNodes)
+{
+	uint32 NumNodes = 0;
+	for (uint32 MaxNodes : LayerMaxNodes)
+	{
+		NumNodes += MaxNodes;
+	}
+
+	NodePool.Reset(NumNodes);
+	Layers.Reset(LayerMaxNodes.Num());
+
+	if (NumNodes > 0)
+	{
+		NodePool.AddDefaulted(NumNodes);
+		Layers.AddDefaulted(LayerMaxNodes.Num());
+
+		// Layers are laid out in the pool from the top down, same as the full allocation
+		int32 NodeStartIdx = 0;
+
+		for (int32 LayerIdx = Layers.Num() - 1; LayerIdx >= 0; --LayerIdx)
+		{
+			FSvoLayer& Layer = Layers[LayerIdx];
+
+			Layer.StartNode = NodeStartIdx;
+			Layer.MaxNodes = LayerMaxNodes[LayerIdx];
+
+			NodeStartIdx += Layer.MaxNodes;
+		}
+	}
+}
+
 void FSvoTile::ReleaseMemory()
 {
 	Layers.Empty();
 	NodePool.Empty();
+	SharedNodes.Reset();
+
+	CompressedNodes.Empty();
+	NumCompressedNodes = 0;
+	FPlatformAtomics::AtomicStore(&bNodesCompressed, 0);
+
+	Store = nullptr;
+	StoreOffset = INDEX_NONE;
+	StoreSize = 0;
+
+	ResetClearance();
+	ResetAreas();
+}
+
+void FSvoTile::ResetAreas()
+{
+	TileArea = SVO_NO_AREA;
+	NodeAreas.Empty();
+	bHasAreas = false;
+}
+
+void FSvoTile::ResetClearance()
+{
+	TileClearance = MAX_uint8;
+	NodeClearance.Empty();
+	LeafClearance.Empty();
+	bHasClearance = false;
+}
+
+uint8 FSvoTile::GetClearance(const FSvoNodeLink& Link) const
+{
+	if (!bHasClearance)
+	{
+		return MAX_uint8;
+	}
+
+	if (Link.LayerIdx == NodeInfo.GetSelfLink().LayerIdx)
+	{
+		return TileClearance;
+	}
+
+	if (!Layers.IsValidIndex(Link.LayerIdx))
+	{
+		return MAX_uint8;
+	}
+
+	if (Link.IsVoxelNode())
+	{
+		const int32 LeafIdx = Algo::BinarySearchBy(LeafClearance, (uint32)Link.NodeIdx, &FLeafClearance::LeafIdx);
+		if (LeafIdx != INDEX_NONE)
+		{
+			return LeafClearance[LeafIdx].Voxels[Link.VoxelIdx];
+		}
+	}
+
+	const int32 PoolIdx = Layers[Link.LayerIdx].StartNode + Link.NodeIdx;
+	return NodeClearance.IsValidIndex(PoolIdx) ? NodeClearance[PoolIdx] : MAX_uint8;
+}
+
+void FSvoTile::ShareNodes()
+{
+	if (AreNodesShared() || AreNodesCompressed() || NodePool.Num() == 0)
+	{
+		return;
+	}
+
+	SharedNodes = FSvoSharedNodePools::Share(MoveTemp(NodePool));
+	NodePool.Empty();
+}
+
+void FSvoTile::UnshareNodes()
+{
+	NodePool = *SharedNodes;
+	SharedNodes.Reset();
+}
+
+bool FSvoTile::CompressNodes()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTile_CompressNodes);
+
+	// Shared pools are only paid for once by every tile using them, so there's little to
+	// gain from compressing them
+	if (AreNodesCompressed() || AreNodesShared() || NodePool.Num() == 0)
+	{
+		return false;
+	}
+
+	TArray<uint8> Buffer;
+	if (!CompressNodePool(Buffer) || Buffer.Num() > NodePool.Num() * sizeof(FSvoNode) * (1.f - SvoColdTiles::MinSavings))
+	{
+		return false;
+	}
+
+	CompressedNodes = MoveTemp(Buffer);
+	NumCompressedNodes = NodePool.Num();
+	FPlatformAtomics::AtomicStore(&bNodesCompressed, 1);
+
+	NodePool.Empty();
+
+	return true;
+}
+
+bool FSvoTile::EvictNodes(FSvoTileStore& InStore)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTile_EvictNodes);
+
+	if (AreNodesEvicted() || AreNodesShared() || (!AreNodesCompressed() && NodePool.Num() == 0))
+	{
+		return false;
+	}
+
+	// Only write the nodes if they aren't already in the store
+	if (Store != &InStore || StoreOffset == INDEX_NONE)
+	{
+		TArray<uint8> Buffer;
+		if (AreNodesCompressed())
+		{
+			Buffer = CompressedNodes;
+		}
+		else if (!CompressNodePool(Buffer))
+		{
+			return false;
+		}
+
+		int64 Offset;
+		if (!InStore.Write(Buffer, Offset))
+		{
+			return false;
+		}
+
+		Store = &InStore;
+		StoreOffset = Offset;
+		StoreSize = Buffer.Num();
+	}
+
+	if (!AreNodesCompressed())
+	{
+		NumCompressedNodes = NodePool.Num();
+		FPlatformAtomics::AtomicStore(&bNodesCompressed, 1);
+
+		NodePool.Empty();
+	}
+
+	CompressedNodes.Empty();
+
+	return true;
+}
+
+bool FSvoTile::CompressNodePool(TArray<uint8>& OutCompressed) const
+{
+	const int32 UncompressedSize = NodePool.Num() * sizeof(FSvoNode);
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_LZ4, UncompressedSize);
+
+	OutCompressed.SetNumUninitialized(CompressedSize);
+
+	if (!FCompression::CompressMemory(NAME_LZ4, OutCompressed.GetData(), CompressedSize, NodePool.GetData(), UncompressedSize))
+	{
+		return false;
+	}
+
+	OutCompressed.SetNum(CompressedSize);
+	OutCompressed.Shrink();
+
+	return true;
+}
+
+void FSvoTile::InflateNodes() const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTile_InflateNodes);
+
+	FScopeLock Lock(&SvoColdTiles::InflateLock);
+
+	// Another thread may have inflated the nodes while we were waiting
+	if (!AreNodesCompressed())
+	{
+		return;
+	}
+
+	FSvoTile& MutableThis = const_cast<FSvoTile&>(*this);
+
+	// Evicted nodes need to be read back from the store first
+	TArray<uint8> StoredNodes;
+	TArrayView<const uint8> Source = CompressedNodes;
+	bool bInflated = true;
+
+	if (CompressedNodes.Num() == 0)
+	{
+		StoredNodes.SetNumUninitialized(StoreSize);
+		bInflated = (Store != nullptr && Store->Read(StoreOffset, StoredNodes));
+		Source = StoredNodes;
+	}
+
+	TArray<FSvoNode> Nodes;
+	Nodes.SetNumUninitialized(NumCompressedNodes);
+
+	bInflated = bInflated && FCompression::UncompressMemory(NAME_LZ4, Nodes.GetData(), NumCompressedNodes * sizeof(FSvoNode), Source.GetData(), Source.Num());
+	if (!ensureAlways(bInflated))
+	{
+		// Hand out empty nodes rather than garbage. The layers are left alone, since
+		// other threads may be looking nodes up through them while we're here.
+		Nodes.Reset();
+		Nodes.SetNum(NumCompressedNodes);
+	}
+
+	MutableThis.NodePool = MoveTemp(Nodes);
+	MutableThis.CompressedNodes.Empty();
+	MutableThis.NumCompressedNodes = 0;
+
+	// Only publish the nodes once they're in place
+	FPlatformAtomics::AtomicStore(&bNodesCompressed, 0);
 }
 
 void FSvoTile::TrimExcessNodes()
@@ -57,6 +317,9 @@ void FSvoTile::TrimExcessNodes()
 	// safely trim them off.
 	SCOPE_CYCLE_COUNTER(STAT_FSvoLayer_TrimExcessNodes);
 
+	EnsureNodesResident();
+	EnsureNodesUnique();
+
 	// If we're fully blocked or fully open we don't need any nodes, so free them all
 	if (NodeInfo.GetNodeState() != ENodeState::PartiallyBlocked)
 	{
@@ -96,6 +359,16 @@ void FSvoTile::TrimExcessNodes()
 		// multiple layers.
 		NodePool.RemoveAt(LayerEnd - NumNodesToRemove, NumNodesToRemove, false);
 
+		if (NodeClearance.Num() > 0)
+		{
+			NodeClearance.RemoveAt(LayerEnd - NumNodesToRemove, NumNodesToRemove, false);
+		}
+
+		if (NodeAreas.Num() > 0)
+		{
+			NodeAreas.RemoveAt(LayerEnd - NumNodesToRemove, NumNodesToRemove, false);
+		}
+
 		CurLayer.MaxNodes -= NumNodesToRemove;
 
 		// We should only be trimming off unused nodes, so NumNodes shouldn't need an
@@ -112,13 +385,18 @@ void FSvoTile::TrimExcessNodes()
 
 	// Now that we're done removing nodes, free any unused memory
 	NodePool.Shrink();
+	NodeClearance.Shrink();
+	NodeAreas.Shrink();
 }
 
-void FSvoTile::Serialize(FArchive& Ar)
+void FSvoTile::Serialize(FArchive& Ar, uint32 BulkNodeSize, bool bSkipBulkNodes, bool bDeferPostLoad)
 {
 	// Get the custom version from the archive
 	int32 Version = Ar.CustomVer(FGunfire3DNavigationCustomVersion::GUID);
 
+	// Cold tiles are always saved inflated
+	EnsureNodesResident();
+
 	Ar << NodeInfo;
 
 	if (Ar.IsLoading())
@@ -141,7 +419,32 @@ void FSvoTile::Serialize(FArchive& Ar)
 		Ar << Coord;
 	}
 
-	Ar << NodePool;
+	// Saving only reads the nodes, so a shared pool can be written as it is
+	TArray<FSvoNode>& SerializedNodes = (!Ar.IsLoading() && AreNodesShared()) ? const_cast<TArray<FSvoNode>&>(*SharedNodes) : NodePool;
+
+	if (BulkNodeSize > 0)
+	{
+		int32 NumNodes = SerializedNodes.Num();
+		Ar << NumNodes;
+
+		if (Ar.IsLoading() && bSkipBulkNodes)
+		{
+			Ar.Seek(Ar.Tell() + (int64)NumNodes * BulkNodeSize);
+		}
+		else
+		{
+			if (Ar.IsLoading())
+			{
+				SerializedNodes.SetNumUninitialized(NumNodes);
+			}
+
+			Ar.Serialize(SerializedNodes.GetData(), (int64)NumNodes * sizeof(FSvoNode));
+		}
+	}
+	else
+	{
+		Ar << SerializedNodes;
+	}
 
 	int32 NumLayers = Layers.Num();
 	Ar << NumLayers;
@@ -158,7 +461,57 @@ void FSvoTile::Serialize(FArchive& Ar)
 		Ar << Layer.MaxNodes;
 	}
 
-	if (Version < FGunfire3DNavigationCustomVersion::NodePropsChanged)
+	if (Version >= FGunfire3DNavigationCustomVersion::TileClearance)
+	{
+		Ar << bHasClearance;
+
+		if (bHasClearance)
+		{
+			Ar << TileClearance;
+			Ar << NodeClearance;
+
+			int32 NumLeaves = LeafClearance.Num();
+			Ar << NumLeaves;
+
+			if (Ar.IsLoading())
+			{
+				LeafClearance.SetNumUninitialized(NumLeaves);
+			}
+
+			for (FLeafClearance& Leaf : LeafClearance)
+			{
+				Ar << Leaf.LeafIdx;
+				Ar.Serialize(Leaf.Voxels, SVO_VOXELS_PER_LEAF);
+			}
+		}
+	}
+
+	if (Version >= FGunfire3DNavigationCustomVersion::TileAreas)
+	{
+		Ar << bHasAreas;
+
+		if (bHasAreas)
+		{
+			Ar << TileArea;
+			Ar << NodeAreas;
+		}
+	}
+
+	if (Ar.IsLoading() && !bDeferPostLoad)
+	{
+		PostLoad(Version);
+	}
+}
+
+void FSvoTile::PostLoad(int32 ArchiveVersion)
+{
+	// Older tile IDs were hashes of the coordinate
+	if (ArchiveVersion < FGunfire3DNavigationCustomVersion::PackedTileIDs)
+	{
+		SetTileID(CalcTileID(Coord));
+	}
+
+	if (ArchiveVersion < FGunfire3DNavigationCustomVersion::NodePropsChanged)
 	{
 		NodeInfo.UpdateOldNode();
 
@@ -174,11 +527,23 @@ void FSvoTile::Serialize(FArchive& Ar)
 	}
 
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
-	if (Ar.IsLoading())
+	Verify();
+#endif
+}
+
+void FSvoTile::SetTileID(uint32 TileID)
+{
+	EnsureNodesUnique();
+
+	NodeInfo.SetTileID(TileID);
+
+	for (FSvoNode& Node : NodePool)
 	{
-		Verify();
+		if (Node.IsActive())
+		{
+			Node.SetTileID(TileID);
+		}
 	}
-#endif
 }
 
 uint32 FSvoTile::GetMaxNodes(uint8 LayerIdx) const
@@ -203,12 +568,13 @@ uint32 FSvoTile::GetNumNodes(uint8 LayerIdx) const
 
 int32 FSvoTile::GetNodeIndex(const FSvoNode& Node) const
 {
-	if (NodePool.Num() > 0)
+	const TArrayView<const FSvoNode> Pool = GetNodePool();
+	if (Pool.Num() > 0)
 	{
-		check(&Node >= &NodePool[0] && &Node <= &NodePool[NodePool.Num() - 1]);
+		check(&Node >= &Pool[0] && &Node <= &Pool[Pool.Num() - 1]);
 
 		const uint8 NodeLayer = Node.GetSelfLink().LayerIdx;
-		const int32 PoolIndex = &Node - &NodePool[0];
+		const int32 PoolIndex = &Node - &Pool[0];
 		return PoolIndex - Layers[NodeLayer].StartNode;
 		
 	}
@@ -224,7 +590,7 @@ FConditionalRangeIterator<const FSvoNode> FSvoTile::GetNodesForLayer(uint8 Layer
 
 		if (Layer.NumNodes > 0)
 		{
-			const FSvoNode* StartNode = &NodePool[Layer.StartNode];
+			const FSvoNode* StartNode = &GetNodePool()[Layer.StartNode];
 			return FConditionalRangeIterator<const FSvoNode>(StartNode, StartNode + Layer.MaxNodes);
 		}
 	}
@@ -236,6 +602,9 @@ FConditionalRangeIterator<FSvoNode> FSvoTile::GetNodesForLayer(uint8 LayerIdx)
 {
 	if (Layers.IsValidIndex(LayerIdx))
 	{
+		EnsureNodesResident();
+		EnsureNodesUnique();
+
 		const FSvoLayer& Layer = Layers[LayerIdx];
 
 		if (Layer.NumNodes > 0)
@@ -280,17 +649,32 @@ void FSvoTile::Copy(const FSvoTile& SourceTile)
 	SourceTile.Verify();
 #endif
 
+	// Release any existing memory for this tile
+	ReleaseMemory();
+
+	SourceTile.EnsureNodesResident();
+
 	// Duplicate basic node information
 	NodeInfo = SourceTile.NodeInfo;
 
 	Coord = SourceTile.Coord;
 
-	// Duplicate the node pool
+	// Duplicate the node pool, or keep sharing it
 	NodePool = SourceTile.NodePool;
+	SharedNodes = SourceTile.SharedNodes;
 
 	// Create layers to point to the new node pool
 	Layers = SourceTile.Layers;
 
+	TileClearance = SourceTile.TileClearance;
+	NodeClearance = SourceTile.NodeClearance;
+	LeafClearance = SourceTile.LeafClearance;
+	bHasClearance = SourceTile.bHasClearance;
+
+	TileArea = SourceTile.TileArea;
+	NodeAreas = SourceTile.NodeAreas;
+	bHasAreas = SourceTile.bHasAreas;
+
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
 	Verify();
 #endif
@@ -305,6 +689,8 @@ void FSvoTile::Assume(FSvoTile& SourceTile)
 	// Release any existing memory for this tile
 	ReleaseMemory();
 
+	SourceTile.EnsureNodesResident();
+
 	// Duplicate basic node information
 	NodeInfo = SourceTile.NodeInfo;
 
@@ -312,13 +698,25 @@ void FSvoTile::Assume(FSvoTile& SourceTile)
 
 	// Take over the memory for the node pool and layers
 	NodePool = MoveTemp(SourceTile.NodePool);
+	SharedNodes = MoveTemp(SourceTile.SharedNodes);
 	Layers = MoveTemp(SourceTile.Layers);
 
+	TileClearance = SourceTile.TileClearance;
+	NodeClearance = MoveTemp(SourceTile.NodeClearance);
+	LeafClearance = MoveTemp(SourceTile.LeafClearance);
+	bHasClearance = SourceTile.bHasClearance;
+	SourceTile.ResetClearance();
+
+	TileArea = SourceTile.TileArea;
+	NodeAreas = MoveTemp(SourceTile.NodeAreas);
+	bHasAreas = SourceTile.bHasAreas;
+	SourceTile.ResetAreas();
+
 #if !UE_BUILD_SHIPPING && SVO_VERIFY_NODES
 	Verify();
 #endif
 
-	if (NodePool.Num() == 0)
+	if (NodePool.Num() == 0 && !AreNodesShared())
 	{
 		NodeInfo.SetNodeState(ENodeState::Open);
 	}
@@ -328,15 +726,34 @@ uint32 FSvoTile::GetMemUsed() const
 {
 	uint32 MemUsed = sizeof(this);
 
+	// Shared pools aren't counted against any one tile (see FSvoSharedNodePools::GetStats)
 	MemUsed += NodePool.GetAllocatedSize();
 	MemUsed += Layers.GetAllocatedSize();
+	MemUsed += CompressedNodes.GetAllocatedSize();
+	MemUsed += NodeClearance.GetAllocatedSize();
+	MemUsed += LeafClearance.GetAllocatedSize();
+	MemUsed += NodeAreas.GetAllocatedSize();
 
 	return MemUsed;
 }
 
+void FSvoTile::AddLayerMemUsed(uint32 (&InOutLayerMemUsed)[SVO_MAX_LAYERS]) const
+{
+	const bool bNodesResident = !AreNodesCompressed() && !AreNodesShared();
+	const uint32 NodeSize = (bNodesResident ? sizeof(FSvoNode) : 0) + (bHasClearance ? 1 : 0) + (bHasAreas ? 1 : 0);
+
+	for (int32 LayerIdx = 0; LayerIdx < Layers.Num() && LayerIdx < SVO_MAX_LAYERS; ++LayerIdx)
+	{
+		InOutLayerMemUsed[LayerIdx] += Layers[LayerIdx].MaxNodes * NodeSize;
+	}
+
+	InOutLayerMemUsed[SVO_LEAF_LAYER] += LeafClearance.GetAllocatedSize();
+}
+
 void FSvoTile::Reset()
 {
 	NodeInfo.Reset();
+	Version = 0;
 
 	// Release any existing memory for this tile
 	ReleaseMemory();
@@ -347,6 +764,8 @@ void FSvoTile::Verify(const FSparseVoxelOctree* Octree /* = nullptr */) const
 	// All tiles being verified should be active
 	ensureAlways(NodeInfo.IsActive());
 
+	EnsureNodesResident();
+
 	// A tile should never have a parent
 	ensureAlways(!NodeInfo.GetParentLink().IsValid());
 
@@ -366,7 +785,7 @@ void FSvoTile::Verify(const FSparseVoxelOctree* Octree /* = nullptr */) const
 		const FSvoLayer& CurLayer = Layers[i];
 
 		// Make sure that our range of nodes is in the pool
-		ensure(CurLayer.StartNode + CurLayer.MaxNodes <= (uint32)NodePool.Num());
+		ensure(CurLayer.StartNode + CurLayer.MaxNodes <= (uint32)GetNodePool().Num());
 
 		int32 NumActive = 0;
 
@@ -5,6 +5,10 @@
 #include "SparseVoxelOctreeNode.h"
 #include "IteratorHelpers.h"
 
+#include "CoreGlobals.h"
+
+class FSvoTileStore;
+
 //
 // A tile is our top level node. The navigable space is partitioned into a 3D grid of
 // tiles.
@@ -14,6 +18,7 @@ class FSvoTile
 	typedef FSvoTile ThisClass;
 	friend class FEditableSvo;
 	friend class FNavSvoTileGenerator;
+	friend class FSvoIslands;
 
 public:
 	FSvoTile() {}
@@ -22,6 +27,10 @@ public:
 	// Creates all nodes needed for this tile
 	void AllocateNodes(uint32 NumNodes, uint8 NumLayers);
 
+	// Creates only the first 'LayerMaxNodes[LayerIdx]' nodes of each layer, for tiles
+	// where it's known up front which nodes will be used.
+	void AllocateNodes(TArrayView<const uint32> LayerMaxNodes);
+
 	// Releases all memory held by the nodes of this tile
 	void ReleaseMemory();
 
@@ -30,8 +39,17 @@ public:
 	// memory.
 	void TrimExcessNodes();
 
-	// Serialize the tile to an archive
-	void Serialize(FArchive& Ar);
+	// Serialize the tile to an archive. If 'BulkNodeSize' is set, the node pool is
+	// written as a raw block of nodes of that size rather than node by node. Set
+	// 'bSkipBulkNodes' to skip over blocks written with a different node layout.
+	//
+	// If 'bDeferPostLoad' is set, a loaded tile is only read, and PostLoad needs to be
+	// called before it's used. That lets the fixups be done off the loading thread.
+	void Serialize(FArchive& Ar, uint32 BulkNodeSize = 0, bool bSkipBulkNodes = false, bool bDeferPostLoad = false);
+
+	// Upgrades the data of a tile loaded from an older version of the archive, and
+	// verifies it. Safe to call on different tiles from multiple threads at once.
+	void PostLoad(int32 ArchiveVersion);
 
 	friend FArchive& operator<<(FArchive& Ar, FSvoTile& Tile)
 	{
@@ -55,8 +73,79 @@ public:
 	// Returns the coordinate relative to the seed location used to generate this tile.
 	const FIntVector& GetCoord() const { return Coord; }
 
+	// Returns the version of the tile's data. This changes every time the tile is
+	// replaced in an editable octree, so anything derived from the tile can tell when
+	// it's out of date.
+	uint32 GetVersion() const { return Version; }
+	void SetVersion(uint32 InVersion) { Version = InVersion; }
+
 	// Determines whether this tile has any internal node memory
-	bool HasNodesAllocated() const { return NodePool.Num() > 0; }
+	bool HasNodesAllocated() const { return NodePool.Num() > 0 || AreNodesCompressed() || AreNodesShared(); }
+
+	// Returns the node pool, whether the tile holds it or it's shared
+	TArrayView<const FSvoNode> GetNodePool() const
+	{
+		EnsureNodesResident();
+		return SharedNodes.IsValid() ? TArrayView<const FSvoNode>(*SharedNodes) : TArrayView<const FSvoNode>(NodePool);
+	}
+
+	///> Shared Nodes
+
+	// Gives up the node pool in favor of one shared with every other tile in the process
+	// holding the same nodes, such as the same level loaded into more than one world (see
+	// FSvoSharedNodePools). Shared pools are read-only, so they're copied back into the
+	// tile the first time a node is accessed for writing.
+	//
+	// NOTE: Same restrictions as CompressNodes.
+	void ShareNodes();
+
+	// Returns true if the node pool is shared with other tiles
+	bool AreNodesShared() const { return SharedNodes.IsValid(); }
+
+	// Readies the node pool for its nodes to be modified. Cold nodes are read back in, a
+	// shared pool is copied, and any copy in the tile store is forgotten, since it won't
+	// match once the nodes change and evicting the tile again has to write them out.
+	//
+	// NOTE: Called by every accessor handing out nodes for writing.
+	void EnsureNodesUnique()
+	{
+		EnsureNodesResident();
+
+		if (SharedNodes.IsValid())
+		{
+			UnshareNodes();
+		}
+
+		Store = nullptr;
+		StoreOffset = INDEX_NONE;
+		StoreSize = 0;
+	}
+
+	///> Cold Storage
+
+	// Compresses the node pool of a read-only tile, freeing it until one of its nodes is
+	// next accessed. Returns false if the tile has no nodes or they don't compress well.
+	//
+	// NOTE: Nothing may be reading the tile's nodes while they're being compressed.
+	bool CompressNodes();
+
+	// Returns true if the node pool is compressed
+	bool AreNodesCompressed() const { return FPlatformAtomics::AtomicRead(&bNodesCompressed) != 0; }
+
+	// Moves the compressed node pool out to the store, freeing its memory until one of
+	// its nodes is next accessed, at which point it's read back on the accessing thread.
+	//
+	// NOTE: Same restrictions as CompressNodes.
+	bool EvictNodes(FSvoTileStore& InStore);
+
+	// Returns true if the node pool only lives in the tile store
+	bool AreNodesEvicted() const { return AreNodesCompressed() && CompressedNodes.Num() == 0 && Store != nullptr; }
+
+	// Inflates the node pool if it's compressed. Safe to call from any thread.
+	FORCEINLINE void EnsureNodesResident() const;
+
+	// Returns the last frame (GFrameCounter) a node of this tile was looked up
+	uint64 GetLastAccessFrame() const { return LastAccessFrame; }
 
 	// Returns the number of used nodes within the full allocation of nodes
 	uint32 GetNumNodes(uint8 LayerIdx) const;
@@ -81,13 +170,63 @@ public:
 	// Returns the link of the specified neighbor for this tile.
 	FSvoNodeLink GetNeighborLink(ESvoNeighbor Neighbor) const;
 
+	///> Clearance
+
+	// Returns true if the tile stores how far its open space is from the nearest geometry
+	// (see AGunfire3DNavData::MaxClearance)
+	bool HasClearance() const { return bHasClearance; }
+
+	// Returns the distance in voxels, measured along the axes, from an open node (or
+	// voxel) of this tile to the nearest blocked voxel, before the agent padding. Beyond
+	// the distance the tile was built to measure, or if it has no clearance, this returns
+	// MAX_uint8.
+	uint8 GetClearance(const FSvoNodeLink& Link) const;
+
+	///> Areas
+
+	// Returns true if any of the tile's open space is within a nav modifier area
+	bool HasAreas() const { return bHasAreas; }
+
+	// Returns the area code of an open node (or voxel) of this tile, which is the ID of
+	// the nav area it's in plus one, or SVO_NO_AREA if it isn't in one. Voxels are in the
+	// area of their leaf.
+	FORCEINLINE uint8 GetArea(const FSvoNodeLink& Link) const;
+
 	//> Utility
 
-	static uint32 CalcTileID(const FIntVector& TileCoord) { return GetTypeHash(TileCoord); }
+	// Tile IDs pack the biased coordinate into 11 bits for X and Y and 10 bits for Z, so
+	// every tile gets a unique ID and the coordinate can be recovered from it without a
+	// lookup. The bias keeps the ID from ever being SVO_INVALID_ID, and valid coordinates
+	// stop one short of the limits so the neighbors of any tile still have an ID.
+	static constexpr int32 MaxTileCoordXY = 1023;
+	static constexpr int32 MaxTileCoordZ = 511;
+
+	static bool IsValidTileCoord(const FIntVector& TileCoord)
+	{
+		return FMath::Abs(TileCoord.X) < MaxTileCoordXY && FMath::Abs(TileCoord.Y) < MaxTileCoordXY && FMath::Abs(TileCoord.Z) < MaxTileCoordZ;
+	}
+
+	static uint32 CalcTileID(const FIntVector& TileCoord)
+	{
+		return (uint32)(TileCoord.X + MaxTileCoordXY) | ((uint32)(TileCoord.Y + MaxTileCoordXY) << 11) | ((uint32)(TileCoord.Z + MaxTileCoordZ) << 22);
+	}
+
+	static FIntVector CalcTileCoord(uint32 TileID)
+	{
+		return FIntVector((int32)(TileID & 0x7FF) - MaxTileCoordXY, (int32)((TileID >> 11) & 0x7FF) - MaxTileCoordXY, (int32)(TileID >> 22) - MaxTileCoordZ);
+	}
 
 	// Counts the memory used by this tile
 	uint32 GetMemUsed() const;
 
+	// Adds the memory used by each layer of the node pool, and the data kept for its
+	// nodes, to 'InOutLayerMemUsed'. Node pools which aren't resident count as nothing,
+	// see GetCompressedMemUsed.
+	void AddLayerMemUsed(uint32 (&InOutLayerMemUsed)[SVO_MAX_LAYERS]) const;
+
+	// Returns the memory held by the compressed node pool, while the tile is cold
+	uint32 GetCompressedMemUsed() const { return CompressedNodes.GetAllocatedSize(); }
+
 	// Resets all data for this tile, making it invalid
 	void Reset();
 
@@ -98,6 +237,24 @@ public:
 	FSvoNode* EnsureNodeExists(uint8 LayerIdx, uint32 NodeIdx, bool& bCreated);
 
 protected:
+	// Decompresses the node pool
+	void InflateNodes() const;
+
+	// Copies the shared node pool back into the tile
+	void UnshareNodes();
+
+	// Compresses the node pool into 'OutCompressed'
+	bool CompressNodePool(TArray<uint8>& OutCompressed) const;
+
+	// Replaces the tile ID on the links of the tile and all its nodes
+	void SetTileID(uint32 TileID);
+
+	// Removes all clearance data
+	void ResetClearance();
+
+	// Removes all area data
+	void ResetAreas();
+
 	void VerifyChildren(const FSvoNode& NodeInfo, const class FSparseVoxelOctree* Octree) const;
 	void VerifyNeighbor(const FSvoNode* Node, ESvoNeighbor Neighbor, const class FSparseVoxelOctree* Octree) const;
 
@@ -115,24 +272,87 @@ protected:
 	// World location of the center of the tile
 	FIntVector Coord = FIntVector::ZeroValue;
 
+	// See GetVersion
+	uint32 Version = 0;
+
 	// List of nodes within the tile
 	TArray<FSvoNode> NodePool;
 
 	// Layer information within the tile
 	TArray<FSvoLayer> Layers;
+
+	// Read-only node pool shared with other tiles, in place of 'NodePool' (see ShareNodes)
+	TSharedPtr<const TArray<FSvoNode>, ESPMode::ThreadSafe> SharedNodes;
+
+	// LZ4 compressed node pool, while the tile is cold
+	TArray<uint8> CompressedNodes;
+	int32 NumCompressedNodes = 0;
+
+	// Set while the node pool lives in 'CompressedNodes'. Only accessed atomically, so
+	// threads looking up nodes see the pool once it's been inflated.
+	mutable int32 bNodesCompressed = 0;
+
+	// Where the compressed node pool was written in the tile store, once it's been
+	// evicted. It's kept after the tile is inflated again so evicting it again doesn't
+	// need another write, until the nodes are next modified (see EnsureNodesUnique).
+	FSvoTileStore* Store = nullptr;
+	int64 StoreOffset = INDEX_NONE;
+	int32 StoreSize = 0;
+
+	// See GetLastAccessFrame. Written by any thread looking up nodes, but it's only a
+	// hint for when to compress the tile, so races on it are harmless.
+	mutable uint64 LastAccessFrame = 0;
+
+	// Clearance of the tile node itself and of each node in the pool (see GetClearance).
+	// This isn't compressed with the nodes, since it's needed to decide whether to open
+	// them at all.
+	uint8 TileClearance = MAX_uint8;
+	TArray<uint8> NodeClearance;
+
+	// Clearance of each voxel in the partially blocked leaves, sorted by leaf index
+	struct FLeafClearance
+	{
+		uint32 LeafIdx;
+		uint8 Voxels[SVO_VOXELS_PER_LEAF];
+	};
+	TArray<FLeafClearance> LeafClearance;
+
+	bool bHasClearance = false;
+
+	// Area code of the tile node itself and of each node in the pool (see GetArea). Like
+	// clearance, this isn't compressed with the nodes.
+	uint8 TileArea = SVO_NO_AREA;
+	TArray<uint8> NodeAreas;
+
+	bool bHasAreas = false;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
+void FSvoTile::EnsureNodesResident() const
+{
+	if (AreNodesCompressed())
+	{
+		InflateNodes();
+	}
+}
+
 const FSvoNode* FSvoTile::GetNode(uint8 LayerIdx, uint32 NodeIdx, bool bActiveOnly) const
 {
 	if (Layers.IsValidIndex(LayerIdx))
 	{
+		EnsureNodesResident();
+
+		if (LastAccessFrame != GFrameCounter)
+		{
+			LastAccessFrame = GFrameCounter;
+		}
+
 		const FSvoLayer& Layer = Layers[LayerIdx];
 
 		if (NodeIdx < Layer.MaxNodes)
 		{
-			const FSvoNode& Node = NodePool[Layer.StartNode + NodeIdx];
+			const FSvoNode& Node = SharedNodes.IsValid() ? (*SharedNodes)[Layer.StartNode + NodeIdx] : NodePool[Layer.StartNode + NodeIdx];
 			if (!bActiveOnly || Node.IsActive())
 			{
 				return &Node;
@@ -151,5 +371,22 @@ const FSvoNode* FSvoTile::GetNode(uint8 LayerIdx, uint32 NodeIdx, bool bActiveOn
 
 FSvoNode* FSvoTile::GetNode(uint8 LayerIdx, uint32 NodeIdx, bool bActiveOnly)
 {
+	EnsureNodesUnique();
 	return MUTABLE_ACCESSOR(FSvoNode*, GetNode(LayerIdx, NodeIdx, bActiveOnly));
 }
+
+uint8 FSvoTile::GetArea(const FSvoNodeLink& Link) const
+{
+	if (!bHasAreas)
+	{
+		return SVO_NO_AREA;
+	}
+
+	if (!Layers.IsValidIndex(Link.LayerIdx))
+	{
+		return (Link.LayerIdx == NodeInfo.GetSelfLink().LayerIdx) ? TileArea : SVO_NO_AREA;
+	}
+
+	const uint32 PoolIdx = Layers[Link.LayerIdx].StartNode + Link.NodeIdx;
+	return (PoolIdx < (uint32)NodeAreas.Num()) ? NodeAreas[PoolIdx] : SVO_NO_AREA;
+}
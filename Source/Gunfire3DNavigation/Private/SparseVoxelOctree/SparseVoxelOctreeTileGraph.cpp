@@ -0,0 +1,388 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeTileGraph.h"
+
+#include "SparseVoxelOctreeConfig.h"
+#include "SparseVoxelOctreeTile.h"
+#include "SparseVoxelOctreeUtils.h"
+
+#include "Async/ParallelFor.h"
+
+// Profiling stats
+DECLARE_CYCLE_STAT(TEXT("AddTile (FSvoTileGraph)"), STAT_FSvoTileGraph_AddTile, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("AddTiles (FSvoTileGraph)"), STAT_FSvoTileGraph_AddTiles, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("RemoveTile (FSvoTileGraph)"), STAT_FSvoTileGraph_RemoveTile, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("FindCorridor (FSvoTileGraph)"), STAT_FSvoTileGraph_FindCorridor, STATGROUP_Gunfire3DNavigation);
+
+namespace SvoTileGraph
+{
+	// Returns the two axes spanning a face, so we can map a voxel to a cell in the mask.
+	// The axes are chosen so that opposing faces share the same layout.
+	FORCEINLINE void GetFaceAxes(ESvoNeighbor Face, int32& OutAxisU, int32& OutAxisV)
+	{
+		const int32 FaceAxis = (uint8)Face % 3;
+		OutAxisU = (FaceAxis + 1) % 3;
+		OutAxisV = (FaceAxis + 2) % 3;
+	}
+
+	FORCEINLINE ESvoNeighborFlags ToFlag(ESvoNeighbor Neighbor)
+	{
+		return (ESvoNeighborFlags)(1 << (uint8)Neighbor);
+	}
+}
+
+void FSvoTileGraph::Reset()
+{
+	Nodes.Empty();
+}
+
+void FSvoTileGraph::AddTile(const FSvoTile& Tile, const FSvoConfig& Config)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTileGraph_AddTile);
+
+	const uint32 TileID = Tile.GetID();
+	const int32 FaceResolution = SVO_VOXEL_GRID_EXTENT << Config.GetTileLayerIndex();
+
+	FTileNode& TileNode = Nodes.FindOrAdd(TileID);
+	GatherFaceMasks(Tile, FaceResolution, TileNode);
+	ConnectNeighbors(TileNode);
+}
+
+void FSvoTileGraph::AddTiles(TArrayView<const FSvoTile* const> Tiles, const FSvoConfig& Config)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTileGraph_AddTiles);
+
+	const int32 FaceResolution = SVO_VOXEL_GRID_EXTENT << Config.GetTileLayerIndex();
+
+	// Add all the nodes up front, since adding to the map can move the existing ones
+	Nodes.Reserve(Nodes.Num() + Tiles.Num());
+	for (const FSvoTile* Tile : Tiles)
+	{
+		Nodes.FindOrAdd(Tile->GetID());
+	}
+
+	TArray<FTileNode*> TileNodes;
+	TileNodes.Reserve(Tiles.Num());
+	for (const FSvoTile* Tile : Tiles)
+	{
+		TileNodes.Add(Nodes.Find(Tile->GetID()));
+	}
+
+	ParallelFor(Tiles.Num(), [&Tiles, &TileNodes, FaceResolution](int32 TileIdx)
+	{
+		GatherFaceMasks(*Tiles[TileIdx], FaceResolution, *TileNodes[TileIdx]);
+	}, (Tiles.Num() > 1) ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	// Connecting touches the neighbors too, so that's left to this thread
+	for (FTileNode* TileNode : TileNodes)
+	{
+		ConnectNeighbors(*TileNode);
+	}
+}
+
+void FSvoTileGraph::GatherFaceMasks(const FSvoTile& Tile, int32 FaceResolution, FTileNode& TileNode)
+{
+	TileNode.Coord = Tile.GetCoord();
+
+	for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+	{
+		TBitArray<>& FaceMask = TileNode.FaceMasks[(uint8)Face];
+		FaceMask.Init(false, FaceResolution * FaceResolution);
+		GatherFaceMask(Tile, Tile.GetNodeInfo(), Face, FaceResolution, FaceMask);
+	}
+}
+
+void FSvoTileGraph::ConnectNeighbors(FTileNode& TileNode)
+{
+	// Refresh the connections to any neighbors already in the graph
+	TileNode.Connections = ESvoNeighborFlags::None;
+
+	for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+	{
+		const FIntVector NeighborCoord = TileNode.Coord + FSvoUtils::GetNeighborDirection(Face);
+		FTileNode* NeighborNode = Nodes.Find(FSvoTile::CalcTileID(NeighborCoord));
+		if (NeighborNode == nullptr)
+		{
+			continue;
+		}
+
+		const ESvoNeighbor OppositeFace = FSvoUtils::GetOppositeNeighbor(Face);
+		const bool bConnected = AreFacesConnected(TileNode.FaceMasks[(uint8)Face], NeighborNode->FaceMasks[(uint8)OppositeFace]);
+
+		if (bConnected)
+		{
+			TileNode.Connections |= SvoTileGraph::ToFlag(Face);
+			NeighborNode->Connections |= SvoTileGraph::ToFlag(OppositeFace);
+		}
+		else
+		{
+			NeighborNode->Connections &= ~SvoTileGraph::ToFlag(OppositeFace);
+		}
+	}
+}
+
+void FSvoTileGraph::RemoveTile(uint32 TileID)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTileGraph_RemoveTile);
+
+	const FTileNode* TileNode = Nodes.Find(TileID);
+	if (TileNode == nullptr)
+	{
+		return;
+	}
+
+	for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+	{
+		const FIntVector NeighborCoord = TileNode->Coord + FSvoUtils::GetNeighborDirection(Face);
+		if (FTileNode* NeighborNode = Nodes.Find(FSvoTile::CalcTileID(NeighborCoord)))
+		{
+			NeighborNode->Connections &= ~SvoTileGraph::ToFlag(FSvoUtils::GetOppositeNeighbor(Face));
+		}
+	}
+
+	Nodes.Remove(TileID);
+}
+
+ESvoNeighborFlags FSvoTileGraph::GetConnections(uint32 TileID) const
+{
+	const FTileNode* TileNode = Nodes.Find(TileID);
+	return TileNode ? TileNode->Connections : ESvoNeighborFlags::None;
+}
+
+void FSvoTileGraph::GetTileIDs(TArray<uint32>& OutTileIDs) const
+{
+	Nodes.GetKeys(OutTileIDs);
+}
+
+void FSvoTileGraph::GetConnectedTileIDs(uint32 TileID, TArray<uint32, TInlineAllocator<6>>& OutTileIDs) const
+{
+	OutTileIDs.Reset();
+
+	const FTileNode* TileNode = Nodes.Find(TileID);
+	if (TileNode == nullptr)
+	{
+		return;
+	}
+
+	for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+	{
+		if (EnumHasAnyFlags(TileNode->Connections, SvoTileGraph::ToFlag(Face)))
+		{
+			OutTileIDs.Add(FSvoTile::CalcTileID(TileNode->Coord + FSvoUtils::GetNeighborDirection(Face)));
+		}
+	}
+}
+
+bool FSvoTileGraph::FindCorridor(uint32 StartTileID, uint32 GoalTileID, int32 Padding, TSet<uint32>& OutCorridor) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTileGraph_FindCorridor);
+
+	OutCorridor.Reset();
+
+	const FTileNode* StartNode = Nodes.Find(StartTileID);
+	const FTileNode* GoalNode = Nodes.Find(GoalTileID);
+	if (StartNode == nullptr || GoalNode == nullptr)
+	{
+		return false;
+	}
+
+	struct FOpenEntry
+	{
+		uint32 TileID;
+		int32 TotalCost;
+
+		bool operator<(const FOpenEntry& Other) const { return TotalCost < Other.TotalCost; }
+	};
+
+	struct FVisitedEntry
+	{
+		uint32 ParentID;
+		int32 Cost;
+	};
+
+	auto CalcHeuristic = [GoalNode](const FIntVector& Coord)
+	{
+		const FIntVector Delta = GoalNode->Coord - Coord;
+		return FMath::Abs(Delta.X) + FMath::Abs(Delta.Y) + FMath::Abs(Delta.Z);
+	};
+
+	// Tiles are uniform in size and every step costs the same, so the Manhattan distance
+	// between tile coords is an exact lower bound on the remaining cost.
+	TMap<uint32, FVisitedEntry> Visited;
+	TArray<FOpenEntry> OpenList;
+
+	Visited.Add(StartTileID, { StartTileID, 0 });
+	OpenList.HeapPush({ StartTileID, CalcHeuristic(StartNode->Coord) });
+
+	bool bFoundGoal = false;
+
+	while (OpenList.Num() > 0)
+	{
+		FOpenEntry Current;
+		OpenList.HeapPop(Current, false);
+
+		if (Current.TileID == GoalTileID)
+		{
+			bFoundGoal = true;
+			break;
+		}
+
+		const FTileNode& CurrentNode = Nodes.FindChecked(Current.TileID);
+		const int32 CurrentCost = Visited.FindChecked(Current.TileID).Cost;
+
+		// Skip stale entries that were superseded by a cheaper route
+		if (Current.TotalCost > CurrentCost + CalcHeuristic(CurrentNode.Coord))
+		{
+			continue;
+		}
+
+		for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+		{
+			if (!EnumHasAnyFlags(CurrentNode.Connections, SvoTileGraph::ToFlag(Face)))
+			{
+				continue;
+			}
+
+			const FIntVector NeighborCoord = CurrentNode.Coord + FSvoUtils::GetNeighborDirection(Face);
+			const uint32 NeighborID = FSvoTile::CalcTileID(NeighborCoord);
+			const int32 NeighborCost = CurrentCost + 1;
+
+			FVisitedEntry* NeighborEntry = Visited.Find(NeighborID);
+			if (NeighborEntry && NeighborEntry->Cost <= NeighborCost)
+			{
+				continue;
+			}
+
+			Visited.Add(NeighborID, { Current.TileID, NeighborCost });
+			OpenList.HeapPush({ NeighborID, NeighborCost + CalcHeuristic(NeighborCoord) });
+		}
+	}
+
+	if (!bFoundGoal)
+	{
+		return false;
+	}
+
+	// Walk back from the goal to collect the tiles along the route
+	TArray<uint32> Frontier;
+	for (uint32 TileID = GoalTileID; ; TileID = Visited.FindChecked(TileID).ParentID)
+	{
+		OutCorridor.Add(TileID);
+		Frontier.Add(TileID);
+
+		if (TileID == StartTileID)
+		{
+			break;
+		}
+	}
+
+	// Grow the corridor through connected neighbors
+	TArray<uint32> NextFrontier;
+	for (int32 Step = 0; Step < Padding && Frontier.Num() > 0; ++Step)
+	{
+		NextFrontier.Reset();
+
+		for (uint32 TileID : Frontier)
+		{
+			const FTileNode& TileNode = Nodes.FindChecked(TileID);
+
+			for (ESvoNeighbor Face : FSvoUtils::GetAllNeighbors())
+			{
+				if (EnumHasAnyFlags(TileNode.Connections, SvoTileGraph::ToFlag(Face)))
+				{
+					const uint32 NeighborID = FSvoTile::CalcTileID(TileNode.Coord + FSvoUtils::GetNeighborDirection(Face));
+
+					bool bAlreadyInCorridor = false;
+					OutCorridor.Add(NeighborID, &bAlreadyInCorridor);
+					if (!bAlreadyInCorridor)
+					{
+						NextFrontier.Add(NeighborID);
+					}
+				}
+			}
+		}
+
+		Swap(Frontier, NextFrontier);
+	}
+
+	return true;
+}
+
+uint32 FSvoTileGraph::GetMemUsed() const
+{
+	uint32 MemUsed = Nodes.GetAllocatedSize();
+
+	for (const TPair<uint32, FTileNode>& NodePair : Nodes)
+	{
+		for (const TBitArray<>& FaceMask : NodePair.Value.FaceMasks)
+		{
+			MemUsed += FaceMask.GetAllocatedSize();
+		}
+	}
+
+	return MemUsed;
+}
+
+void FSvoTileGraph::GatherFaceMask(const FSvoTile& Tile, const FSvoNode& Node, ESvoNeighbor Face, int32 FaceResolution, TBitArray<>& OutMask)
+{
+	const ENodeState NodeState = Node.GetNodeState();
+	if (NodeState == ENodeState::Blocked)
+	{
+		return;
+	}
+
+	const FSvoNodeLink NodeLink = Node.GetSelfLink();
+	const bool bIsTileNode = (NodeLink.LayerIdx == Tile.GetSelfLink().LayerIdx);
+
+	int32 AxisU, AxisV;
+	SvoTileGraph::GetFaceAxes(Face, AxisU, AxisV);
+
+	// Voxel extents and origin of this node within the tile
+	const int32 NodeExtent = SVO_VOXEL_GRID_EXTENT << NodeLink.LayerIdx;
+	const FIntVector NodeOrigin = bIsTileNode ? FIntVector::ZeroValue : FSvoUtils::MortonToCoord(NodeLink.NodeIdx) * NodeExtent;
+
+	if (NodeState == ENodeState::Open)
+	{
+		for (int32 V = 0; V < NodeExtent; ++V)
+		{
+			const int32 RowStart = (NodeOrigin[AxisV] + V) * FaceResolution + NodeOrigin[AxisU];
+			OutMask.SetRange(RowStart, NodeExtent, true);
+		}
+	}
+	else if (Node.IsLeafNode())
+	{
+		// The leaf face voxels are listed from the perspective of the opposite neighbor
+		for (uint8 VoxelIdx : FSvoUtils::GetTouchingNeighborVoxels(FSvoUtils::GetOppositeNeighbor(Face)))
+		{
+			if (!Node.IsVoxelBlocked(VoxelIdx))
+			{
+				FIntVector VoxelCoord;
+				FSvoUtils::GetVoxelCoordFromIndex(VoxelIdx, VoxelCoord);
+				VoxelCoord += NodeOrigin;
+
+				OutMask[VoxelCoord[AxisV] * FaceResolution + VoxelCoord[AxisU]] = true;
+			}
+		}
+	}
+	else
+	{
+		for (uint8 ChildIdx : FSvoUtils::GetChildrenTouchingNeighbor(Face))
+		{
+			const FSvoNodeLink ChildLink = Node.GetChildLink(ChildIdx);
+			if (const FSvoNode* ChildNode = Tile.GetNode(ChildLink.LayerIdx, ChildLink.NodeIdx))
+			{
+				GatherFaceMask(Tile, *ChildNode, Face, FaceResolution, OutMask);
+			}
+		}
+	}
+}
+
+bool FSvoTileGraph::AreFacesConnected(const TBitArray<>& FaceMask, const TBitArray<>& OppositeFaceMask)
+{
+	if (FaceMask.Num() != OppositeFaceMask.Num())
+	{
+		return false;
+	}
+
+	return TBitArray<>::BitwiseAND(FaceMask, OppositeFaceMask, EBitwiseOperatorFlags::MinSize).Contains(true);
+}
@@ -0,0 +1,85 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "SparseVoxelOctreeCommon.h"
+
+class FSvoTile;
+struct FSvoConfig;
+
+//
+// An abstract, tile-level graph of the octree. Two neighboring tiles are connected if
+// there is at least one pair of open voxels touching across their shared face.
+//
+// Connectivity within a tile isn't tracked, so the graph can only over-estimate what is
+// reachable. If no corridor exists between two tiles then there is no path between them,
+// but a corridor existing doesn't guarantee a voxel-level path through it.
+//
+class GUNFIRE3DNAVIGATION_API FSvoTileGraph
+{
+public:
+	// Destroys all graph data
+	void Reset();
+
+	// Adds (or refreshes) a tile in the graph and updates the connections to its
+	// neighbors.
+	void AddTile(const FSvoTile& Tile, const FSvoConfig& Config);
+
+	// Adds (or refreshes) a batch of tiles at once, like when an octree is loaded. The
+	// face masks are gathered on the workers, so tiles must not be modified until this
+	// returns.
+	void AddTiles(TArrayView<const FSvoTile* const> Tiles, const FSvoConfig& Config);
+
+	// Removes a tile from the graph, disconnecting it from all of its neighbors
+	void RemoveTile(uint32 TileID);
+
+	// Returns true if the tile has been added to the graph
+	bool HasTile(uint32 TileID) const { return Nodes.Contains(TileID); }
+
+	// Returns the neighbors of the tile that can be moved to directly
+	ESvoNeighborFlags GetConnections(uint32 TileID) const;
+
+	// Gathers the IDs of every tile in the graph
+	void GetTileIDs(TArray<uint32>& OutTileIDs) const;
+
+	// Gathers the IDs of the neighbors of a tile that can be moved to directly
+	void GetConnectedTileIDs(uint32 TileID, TArray<uint32, TInlineAllocator<6>>& OutTileIDs) const;
+
+	// Searches the graph for the shortest sequence of tiles from the start tile to the
+	// goal tile. The resulting corridor contains every tile along that sequence, plus any
+	// connected tiles within 'Padding' steps of it to give the detailed search some room
+	// to cut corners. Returns false if the goal isn't reachable.
+	bool FindCorridor(uint32 StartTileID, uint32 GoalTileID, int32 Padding, TSet<uint32>& OutCorridor) const;
+
+	// Returns the number of tiles in the graph
+	int32 GetNumTiles() const { return Nodes.Num(); }
+
+	// Returns the amount of memory used by the graph
+	uint32 GetMemUsed() const;
+
+private:
+	struct FTileNode
+	{
+		FIntVector Coord = FIntVector::ZeroValue;
+
+		// Open voxels on each face of the tile, indexed by ESvoNeighbor
+		TBitArray<> FaceMasks[6];
+
+		ESvoNeighborFlags Connections = ESvoNeighborFlags::None;
+	};
+
+	// Fills out the face masks of a tile node from the tile
+	static void GatherFaceMasks(const FSvoTile& Tile, int32 FaceResolution, FTileNode& TileNode);
+
+	// Refreshes the connections between a tile node and its neighbors in the graph
+	void ConnectNeighbors(FTileNode& TileNode);
+
+	// Marks the open voxels of a node that lie on the specified face of its tile
+	static void GatherFaceMask(const FSvoTile& Tile, const class FSvoNode& Node, ESvoNeighbor Face, int32 FaceResolution, TBitArray<>& OutMask);
+
+	// Returns true if any open voxel on the face of one tile touches an open voxel on the
+	// opposing face of the other.
+	static bool AreFacesConnected(const TBitArray<>& FaceMask, const TBitArray<>& OppositeFaceMask);
+
+	TMap<uint32, FTileNode> Nodes;
+};
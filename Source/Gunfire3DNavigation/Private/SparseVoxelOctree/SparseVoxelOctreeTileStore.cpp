@@ -0,0 +1,88 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "SparseVoxelOctreeTileStore.h"
+
+#include "Gunfire3DNavigationUtils.h"
+
+#include "AI/Navigation/NavigationTypes.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+// Profiling stats
+DECLARE_CYCLE_STAT(TEXT("Write (FSvoTileStore)"), STAT_FSvoTileStore_Write, STATGROUP_Gunfire3DNavigation);
+DECLARE_CYCLE_STAT(TEXT("Read (FSvoTileStore)"), STAT_FSvoTileStore_Read, STATGROUP_Gunfire3DNavigation);
+
+FSvoTileStore::FSvoTileStore()
+{
+}
+
+FSvoTileStore::~FSvoTileStore()
+{
+	if (FileHandle.IsValid())
+	{
+		FileHandle.Reset();
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*Filename);
+	}
+}
+
+bool FSvoTileStore::Write(TArrayView<const uint8> Data, int64& OutOffset)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTileStore_Write);
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (!EnsureFileOpen() || !FileHandle->SeekFromEnd(0) || !FileHandle->Write(Data.GetData(), Data.Num()))
+	{
+		return false;
+	}
+
+	OutOffset = Size;
+	Size += Data.Num();
+
+	return true;
+}
+
+bool FSvoTileStore::Read(int64 Offset, TArrayView<uint8> OutData) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSvoTileStore_Read);
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (!FileHandle.IsValid() || !ensure(Offset >= 0 && Offset + OutData.Num() <= Size))
+	{
+		return false;
+	}
+
+	return FileHandle->Seek(Offset) && FileHandle->Read(OutData.GetData(), OutData.Num());
+}
+
+int64 FSvoTileStore::GetSize() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Size;
+}
+
+bool FSvoTileStore::EnsureFileOpen()
+{
+	if (FileHandle.IsValid())
+	{
+		return true;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("NavSvo");
+	PlatformFile.CreateDirectoryTree(*Directory);
+
+	Filename = Directory / FString::Printf(TEXT("Tiles_%s.bin"), *FGuid::NewGuid().ToString());
+	FileHandle.Reset(PlatformFile.OpenWrite(*Filename, false, true /* bAllowRead */));
+
+	if (!FileHandle.IsValid())
+	{
+		UE_LOG(LogNavigation, Warning, TEXT("FSvoTileStore : Failed to open %s; tiles won't be evicted."), *Filename);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,46 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+//
+// Disk-backed storage for the compressed node pools of evicted tiles (see
+// FSvoTile::EvictNodes). Blocks are appended to a scratch file which is deleted along
+// with the store. Tile data is read-only once generated, so a block stays valid for as
+// long as its tile does and re-evicting a tile doesn't need to write it again.
+//
+// NOTE: Thread-safe, since tiles are faulted back in from whichever thread needs them.
+//
+class GUNFIRE3DNAVIGATION_API FSvoTileStore
+{
+public:
+	FSvoTileStore();
+	~FSvoTileStore();
+
+	FSvoTileStore(const FSvoTileStore&) = delete;
+	FSvoTileStore& operator=(const FSvoTileStore&) = delete;
+
+	// Appends a block to the store, filling 'OutOffset' with where it can be read from
+	bool Write(TArrayView<const uint8> Data, int64& OutOffset);
+
+	// Reads back a block written with Write
+	bool Read(int64 Offset, TArrayView<uint8> OutData) const;
+
+	// Returns the number of bytes written to the store
+	int64 GetSize() const;
+
+private:
+	// Opens the scratch file the first time a block is written
+	bool EnsureFileOpen();
+
+	mutable FCriticalSection Lock;
+
+	TUniquePtr<IFileHandle> FileHandle;
+	FString Filename;
+	int64 Size = 0;
+};
+
+typedef TSharedPtr<FSvoTileStore, ESPMode::ThreadSafe> FSvoTileStoreSharedPtr;
@@ -2,6 +2,20 @@
 
 #include "SparseVoxelOctreeUtils.h"
 
+#include "AI/NavigationSystemBase.h"
+
+#if SVO_MORTON_DISPATCH
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC lets us use the intrinsics without compiling the whole module for them
+#define SVO_TARGET_BMI2
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define SVO_TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+#endif // SVO_MORTON_DISPATCH
+
 const ESvoNeighbor FSvoUtils::AllNeighbors[] =
 {
 	ESvoNeighbor::Front, ESvoNeighbor::Right, ESvoNeighbor::Top, ESvoNeighbor::Back, ESvoNeighbor::Left, ESvoNeighbor::Bottom
@@ -111,6 +125,17 @@ const uint8 FSvoUtils::LeafFaceVoxelsLUT[6][16] =
 	}
 };
 
+// The voxels in LeafFaceVoxelsLUT as a mask for each face
+const uint64 FSvoUtils::LeafFaceVoxelMaskLUT[6] =
+{
+	0x8888888888888888ull, // Front
+	0xF000F000F000F000ull, // Right
+	0xFFFF000000000000ull, // Top
+	0x1111111111111111ull, // Back
+	0x000F000F000F000Full, // Left
+	0x000000000000FFFFull  // Bottom
+};
+
 const int8 FSvoUtils::OppositeLeafFaceVoxelOffsetLUT[] =
 {
 	-3, -12, -48, 3, 12, 48
@@ -118,6 +143,186 @@ const int8 FSvoUtils::OppositeLeafFaceVoxelOffsetLUT[] =
 
 FIntVector FSvoUtils::VoxelGridExtents(SVO_VOXEL_GRID_EXTENT);
 
+uint64 FSvoUtils::LeafLineMaskLUT[SVO_VOXELS_PER_LEAF][SVO_VOXELS_PER_LEAF];
+
+//////////////////////////////////////////////////////////////////////////
+// Leaf line masks
+//////////////////////////////////////////////////////////////////////////
+
+namespace SvoLeafLineMasks
+{
+	// Slack in voxels, to cover the epsilons the raycast steps with
+	constexpr float Slack = 0.05f;
+
+	// Returns true if the segment touches the box, using the slab method
+	bool SegmentTouchesBox(const FVector& Start, const FVector& End, const FVector& BoxMin, const FVector& BoxMax)
+	{
+		float MinT = 0.f;
+		float MaxT = 1.f;
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const float Delta = End[Axis] - Start[Axis];
+
+			if (Delta == 0.f)
+			{
+				if (Start[Axis] < BoxMin[Axis] || Start[Axis] > BoxMax[Axis])
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			float T0 = (BoxMin[Axis] - Start[Axis]) / Delta;
+			float T1 = (BoxMax[Axis] - Start[Axis]) / Delta;
+			if (T0 > T1)
+			{
+				Swap(T0, T1);
+			}
+
+			MinT = FMath::Max(MinT, T0);
+			MaxT = FMath::Min(MaxT, T1);
+
+			if (MinT > MaxT)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+void FSvoUtils::InitLeafLineMasks()
+{
+	// Any line from a point in the entry voxel to a point in the exit voxel stays within
+	// a voxel's half width of the line between their centers. So a voxel can only be
+	// crossed if the line between the centers passes within a full voxel width of its
+	// center.
+	for (uint8 EntryIdx = 0; EntryIdx < SVO_VOXELS_PER_LEAF; ++EntryIdx)
+	{
+		FIntVector EntryCoord;
+		GetVoxelCoordFromIndex(EntryIdx, EntryCoord);
+
+		for (uint8 ExitIdx = 0; ExitIdx < SVO_VOXELS_PER_LEAF; ++ExitIdx)
+		{
+			FIntVector ExitCoord;
+			GetVoxelCoordFromIndex(ExitIdx, ExitCoord);
+
+			uint64 Mask = 0;
+
+			for (uint8 VoxelIdx = 0; VoxelIdx < SVO_VOXELS_PER_LEAF; ++VoxelIdx)
+			{
+				FIntVector VoxelCoord;
+				GetVoxelCoordFromIndex(VoxelIdx, VoxelCoord);
+
+				const FVector Extent(1.f + SvoLeafLineMasks::Slack);
+				const FVector VoxelCenter(VoxelCoord);
+
+				if (SvoLeafLineMasks::SegmentTouchesBox(FVector(EntryCoord), FVector(ExitCoord), VoxelCenter - Extent, VoxelCenter + Extent))
+				{
+					Mask |= (1ull << VoxelIdx);
+				}
+			}
+
+			LeafLineMaskLUT[EntryIdx][ExitIdx] = Mask;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Morton backend
+//////////////////////////////////////////////////////////////////////////
+#if SVO_MORTON_DISPATCH
+
+bool FSvoUtils::bUseBMI2Morton = false;
+
+namespace SvoMortonDispatch
+{
+	void CpuId(uint32 Leaf, uint32 SubLeaf, uint32 OutRegs[4])
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		__cpuidex(reinterpret_cast<int*>(OutRegs), Leaf, SubLeaf);
+#else
+		__cpuid_count(Leaf, SubLeaf, OutRegs[0], OutRegs[1], OutRegs[2], OutRegs[3]);
+#endif
+	}
+
+	bool HasFastBMI2()
+	{
+		uint32 Regs[4];
+		CpuId(0, 0, Regs);
+
+		const uint32 MaxLeaf = Regs[0];
+		if (MaxLeaf < 7)
+		{
+			return false;
+		}
+
+		// Vendor string is EBX, EDX, ECX
+		const bool bIsAMD = (Regs[1] == 0x68747541 && Regs[3] == 0x69746e65 && Regs[2] == 0x444d4163);
+
+		CpuId(7, 0, Regs);
+		const bool bHasBMI2 = (Regs[1] & (1 << 8)) != 0;
+		if (!bHasBMI2)
+		{
+			return false;
+		}
+
+		// AMD processors before Zen 3 (family 19h) implement pdep/pext in microcode, and
+		// they're much slower than the lookup tables there.
+		if (bIsAMD)
+		{
+			CpuId(1, 0, Regs);
+			uint32 Family = (Regs[0] >> 8) & 0xF;
+			if (Family == 0xF)
+			{
+				Family += (Regs[0] >> 20) & 0xFF;
+			}
+
+			return Family >= 0x19;
+		}
+
+		return true;
+	}
+}
+
+SVO_TARGET_BMI2 uint32 FSvoUtils::CoordToMortonBMI2(uint32 X, uint32 Y, uint32 Z)
+{
+	return _pdep_u32(X, MORTON_X_MASK) | _pdep_u32(Y, MORTON_Y_MASK) | _pdep_u32(Z, MORTON_Z_MASK);
+}
+
+SVO_TARGET_BMI2 FIntVector FSvoUtils::MortonToCoordBMI2(uint32 MortonCode)
+{
+	return FIntVector(
+		_pext_u32(MortonCode, MORTON_X_MASK),
+		_pext_u32(MortonCode, MORTON_Y_MASK),
+		_pext_u32(MortonCode, MORTON_Z_MASK));
+}
+
+#endif // SVO_MORTON_DISPATCH
+
+void FSvoUtils::InitMortonBackend()
+{
+#if SVO_MORTON_DISPATCH
+	bUseBMI2Morton = SvoMortonDispatch::HasFastBMI2();
+#endif
+
+	UE_LOG(LogNavigation, Log, TEXT("NavSvo: Using %s Morton encoding"), GetMortonBackendName());
+}
+
+const TCHAR* FSvoUtils::GetMortonBackendName()
+{
+#if SVO_MORTON_DISPATCH
+	return bUseBMI2Morton ? TEXT("BMI2 (dispatched)") : TEXT("lookup table");
+#elif defined(__BMI2__) || defined(__AVX2__)
+	return TEXT("BMI2");
+#else
+	return TEXT("lookup table");
+#endif
+}
+
 uint32 FSvoUtils::NextMorton(uint32 Code, uint32 MinCode, uint32 MaxCode)
 {
 	// Based on "Multidimensional Range Search in Dynamically Balanced Trees"
@@ -175,3 +380,109 @@ uint32 FSvoUtils::NextMorton(uint32 Code, uint32 MinCode, uint32 MaxCode)
 	return BigMin;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Benchmarking
+//////////////////////////////////////////////////////////////////////////
+#if !UE_BUILD_SHIPPING
+
+namespace SvoMortonBenchmark
+{
+	// Runs the encode and decode functions over every coordinate in a cube (in linear
+	// order, like tile generation) and over random coordinates (like queries), the same
+	// way libmorton's test3D_performance does.
+	template<typename TEncode, typename TDecode>
+	void Measure(const TCHAR* Name, const TArray<FIntVector>& LinearCoords, const TArray<FIntVector>& RandomCoords, int32 NumIterations, const TEncode& Encode, const TDecode& Decode)
+	{
+		double LinearSeconds = 0.0;
+		double RandomSeconds = 0.0;
+		uint32 Checksum = 0;
+
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			double StartTime = FPlatformTime::Seconds();
+			for (const FIntVector& Coord : LinearCoords)
+			{
+				const FIntVector Decoded = Decode(Encode(Coord));
+				Checksum += Decoded.X ^ Decoded.Y ^ Decoded.Z;
+			}
+			LinearSeconds += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			for (const FIntVector& Coord : RandomCoords)
+			{
+				const FIntVector Decoded = Decode(Encode(Coord));
+				Checksum += Decoded.X ^ Decoded.Y ^ Decoded.Z;
+			}
+			RandomSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+
+		const double NumLinear = (double)LinearCoords.Num() * NumIterations;
+		const double NumRandom = (double)RandomCoords.Num() * NumIterations;
+		UE_LOG(LogNavigation, Display, TEXT("    %-20s linear: %7.2f M/s  random: %7.2f M/s  (checksum %u)"), Name,
+			NumLinear / FMath::Max(LinearSeconds, SMALL_NUMBER) / 1000000.0,
+			NumRandom / FMath::Max(RandomSeconds, SMALL_NUMBER) / 1000000.0,
+			Checksum);
+	}
+
+	void Run(const TArray<FString>& Args)
+	{
+		const int32 NumIterations = (Args.Num() > 0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20;
+
+		const int32 Extent = SVO_MAX_NODECOORD + 1;
+
+		TArray<FIntVector> LinearCoords;
+		LinearCoords.Reserve(Extent * Extent * Extent);
+		for (int32 Z = 0; Z < Extent; ++Z)
+		{
+			for (int32 Y = 0; Y < Extent; ++Y)
+			{
+				for (int32 X = 0; X < Extent; ++X)
+				{
+					LinearCoords.Emplace(X, Y, Z);
+				}
+			}
+		}
+
+		FRandomStream RandomStream(Extent);
+		TArray<FIntVector> RandomCoords;
+		RandomCoords.Reserve(LinearCoords.Num());
+		for (int32 CoordIdx = 0; CoordIdx < LinearCoords.Num(); ++CoordIdx)
+		{
+			RandomCoords.Emplace(
+				RandomStream.RandRange(0, Extent - 1),
+				RandomStream.RandRange(0, Extent - 1),
+				RandomStream.RandRange(0, Extent - 1));
+		}
+
+		UE_LOG(LogNavigation, Display, TEXT("NavSvo Morton: %d coords x %d iterations, using %s"), LinearCoords.Num(), NumIterations, FSvoUtils::GetMortonBackendName());
+
+		Measure(TEXT("Lookup table"), LinearCoords, RandomCoords, NumIterations,
+			[](const FIntVector& Coord) { return (uint32)libmorton::morton3D_32_encode(Coord.X, Coord.Y, Coord.Z); },
+			[](uint32 Code) { uint_fast16_t X, Y, Z; libmorton::morton3D_32_decode(Code, X, Y, Z); return FIntVector(X, Y, Z); });
+
+		Measure(TEXT("Magic bits"), LinearCoords, RandomCoords, NumIterations,
+			[](const FIntVector& Coord) { return (uint32)libmorton::m3D_e_magicbits<uint_fast32_t, uint_fast16_t>(Coord.X, Coord.Y, Coord.Z); },
+			[](uint32 Code) { uint_fast16_t X, Y, Z; libmorton::m3D_d_magicbits<uint_fast32_t, uint_fast16_t>(Code, X, Y, Z); return FIntVector(X, Y, Z); });
+
+#if SVO_MORTON_DISPATCH
+		if (FSvoUtils::IsUsingBMI2Morton())
+		{
+			Measure(TEXT("BMI2"), LinearCoords, RandomCoords, NumIterations,
+				[](const FIntVector& Coord) { return FSvoUtils::CoordToMortonBMI2(Coord.X, Coord.Y, Coord.Z); },
+				[](uint32 Code) { return FSvoUtils::MortonToCoordBMI2(Code); });
+		}
+#endif
+
+		// Benchmark the dispatched entry points too, so the cost of the branch shows up
+		Measure(TEXT("Dispatched"), LinearCoords, RandomCoords, NumIterations,
+			[](const FIntVector& Coord) { return FSvoUtils::CoordToMorton(Coord); },
+			[](uint32 Code) { return FSvoUtils::MortonToCoord(Code); });
+	}
+
+	static FAutoConsoleCommand CmdBenchmark(
+		TEXT("NavSvo.BenchmarkMorton"),
+		TEXT("Compares the Morton encode/decode variants. Usage: NavSvo.BenchmarkMorton [NumIterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -34,6 +34,13 @@ struct FSvoUtils
 	{
 		ensure(IsValidMortonCoord(Coord));
 
+#if SVO_MORTON_DISPATCH
+		if (bUseBMI2Morton)
+		{
+			return CoordToMortonBMI2(Coord.X, Coord.Y, Coord.Z);
+		}
+#endif
+
 		return libmorton::morton3D_32_encode(Coord.X, Coord.Y, Coord.Z);
 	}
 
@@ -41,11 +48,25 @@ struct FSvoUtils
 	{
 		ensure(IsValidMortonCode(MortonCode));
 
+#if SVO_MORTON_DISPATCH
+		if (bUseBMI2Morton)
+		{
+			return MortonToCoordBMI2(MortonCode);
+		}
+#endif
+
 		uint_fast16_t X, Y, Z;
 		libmorton::morton3D_32_decode(MortonCode, X, Y, Z);
 		return FIntVector(X, Y, Z);
 	}
 
+	// Picks the fastest Morton encoding the CPU supports. Called once at module startup,
+	// before any octrees are built or loaded.
+	static void InitMortonBackend();
+
+	// Returns the name of the Morton encoding in use, for logging
+	static const TCHAR* GetMortonBackendName();
+
 	// Gets the neighbor for a Morton code. This is significantly faster than converting
 	// back to a coordinate, offsetting, and converting back.
 	// This has error checking so if the neighbor would wrap around it returns the same
@@ -306,7 +327,37 @@ struct FSvoUtils
 		return LeafFaceVoxelsLUT[(uint8)GetOppositeNeighbor(Neighbor)];
 	}
 
+	// Same as GetTouchingNeighborVoxels, as a mask of voxel indices
+	static uint64 GetTouchingNeighborVoxelMask(ESvoNeighbor Neighbor)
+	{
+		return LeafFaceVoxelMaskLUT[(uint8)GetOppositeNeighbor(Neighbor)];
+	}
+
+	// Builds the leaf line masks. Called once at module startup.
+	static void InitLeafLineMasks();
+
+	// Returns the voxels of a leaf that a straight line entering it in one voxel and
+	// leaving it in another can pass through. This is conservative, so if none of them
+	// are blocked the line can't hit anything in the leaf.
+	static uint64 GetLeafLineMask(uint8 EntryVoxelIdx, uint8 ExitVoxelIdx)
+	{
+		return LeafLineMaskLUT[EntryVoxelIdx][ExitVoxelIdx];
+	}
+
+#if SVO_MORTON_DISPATCH
+	// Compiled for BMI2 separately from the rest of the module, so they must only be
+	// called if IsUsingBMI2Morton returns true.
+	static uint32 CoordToMortonBMI2(uint32 X, uint32 Y, uint32 Z);
+	static FIntVector MortonToCoordBMI2(uint32 MortonCode);
+
+	static bool IsUsingBMI2Morton() { return bUseBMI2Morton; }
+#endif
+
 private:
+#if SVO_MORTON_DISPATCH
+	static bool bUseBMI2Morton;
+#endif
+
 	static const ESvoNeighbor AllNeighbors[6];
 	static const FIntVector DirectionLUT[6];
 	static const uint32 MortonNeighborLUT[6][3];
@@ -314,6 +365,8 @@ private:
 	static const ESvoNeighbor NodeNeighborLUT[8][8];
 	static const int8 OppositeLeafFaceVoxelOffsetLUT[6];
 	static const uint8 LeafFaceVoxelsLUT[6][16];
+	static const uint64 LeafFaceVoxelMaskLUT[6];
+	static uint64 LeafLineMaskLUT[SVO_VOXELS_PER_LEAF][SVO_VOXELS_PER_LEAF];
 };
 
 // Iterator for moving an extent of coords
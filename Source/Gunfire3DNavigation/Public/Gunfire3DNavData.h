@@ -5,12 +5,23 @@
 #include "Gunfire3DNavPath.h"
 #include "Gunfire3DNavQueryFilter.h"
 
+#include "Containers/Ticker.h"
 #include "NavigationData.h"
 
 #include "Gunfire3DNavData.generated.h"
 
 class FEditableSvo;
 class FNavSvoGenerator;
+class FNavSvoFlowFieldCache;
+class FNavSvoNodeHints;
+class FNavSvoNodeQuery;
+class FNavSvoPathCache;
+class FNavSvoPathRequestManager;
+class FNavSvoTimeSlicedPathManager;
+class FSvoObstacles;
+struct FNavSvoPathCacheKey;
+struct FNavSvoPathEndpoints;
+struct FSvoNodeLink;
 
 UENUM()
 enum class ENav3DDrawType : uint8
@@ -26,6 +37,11 @@ class GUNFIRE3DNAVIGATION_API AGunfire3DNavData : public ANavigationData
 	friend class FNavSvoGenerator;
 	friend class ANavSvoDebugActor;
 	friend class FNavSvoSceneProxy;
+	friend class FNavSvoPathRequestManager;
+	friend class FNavSvoTimeSlicedPathManager;
+	friend class UGunfire3DNavBuildCommandlet;
+	friend class UGunfire3DNavQueryReplayCommandlet;
+class FSvoObstacles;
 
 	GENERATED_BODY()
 
@@ -87,6 +103,13 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Generation", config)
 	bool bFixedTilePoolSize = false;
 
+	// If greater than zero, the octree is kept within this many megabytes. Once it grows
+	// past it, the tiles farthest from every player are compressed, then evicted to disk
+	// if that isn't enough, and the tile pool isn't expanded until it fits again. See
+	// NavSvo.DumpMemory for where the memory is going.
+	UPROPERTY(EditDefaultsOnly, Category = "Generation", config, meta = (ClampMin = "0"))
+	int32 MemoryBudgetMB = 0;
+
 	// The maximum number of threads allowed to generate tiles at once.
 	UPROPERTY(EditDefaultsOnly, Category = "Generation", config, AdvancedDisplay, meta = (ClampMin = "1"), AdvancedDisplay)
 	int32 MaxTileGenerationJobs = 1024;
@@ -95,13 +118,30 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Generation", config, AdvancedDisplay, meta = (ClampMin = "1"), AdvancedDisplay)
 	int32 MaxTilesPerGenerationJob = 1;
 
-	// If true, geometry gathered for tile generation will be collected within the worker
-	// thread however this will limit the maximum number of tile generation jobs to only
-	// one at a time, essentially ignoring what was entered into 'Max Tile Generation
-	// Jobs'.
+	// If true, only the sources of the geometry for tile generation are collected on the
+	// game thread, and the geometry itself is extracted by each job on its worker thread.
+	// Any number of jobs can be gathering at once (see NavSvo.MaxTasks).
 	UPROPERTY(EditDefaultsOnly, Category = "Generation", config, AdvancedDisplay)
 	bool bDoAsyncGeometryGathering = false;
 
+	// Nav data in the same voxelization group share the geometry gathered and voxelized
+	// for each tile, so only the agent padding is done separately for each of them. This
+	// only happens when their voxel grids match (same voxel size and tile layer, and a
+	// similar enough agent size), otherwise each falls back to voxelizing on its own.
+	//
+	// Only group nav data whose geometry isn't filtered by agent, since the geometry is
+	// gathered for whichever of them builds a tile first.
+	UPROPERTY(EditDefaultsOnly, Category = "Generation", config, AdvancedDisplay)
+	FName VoxelizationGroup;
+
+	// If greater than zero, each open node stores how far it is from the nearest
+	// geometry, up to this distance. Queries can then require more clearance than the
+	// agent this was built for (see FGunfire3DNavQueryFilter::SetMinClearance), so one
+	// octree can serve larger agents too. Geometry is gathered this far around each tile,
+	// and it costs a byte for every node plus 64 for every partially blocked leaf.
+	UPROPERTY(EditDefaultsOnly, Category = "Generation", config, AdvancedDisplay, meta = (ClampMin = "0.0"))
+	float MaxClearance = 0.0f;
+
 	// Specifies default limit to nodes used when performing navigation queries.
 	// 
 	// Can be overridden by passing custom FNavigationQueryFilter
@@ -124,14 +164,32 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = "Query", config, AdvancedDisplay, meta = (ClampMin = "0.0"))
 	float DefaultBaseTraversalCost = NAVDATA_DEFAULT_BASE_TRAVERSAL_COST;
 
+	// The number of finished paths to keep around for reuse. Paths are cached by their
+	// start and end nodes and are thrown out when any tile they pass through changes.
+	// Useful when many agents path between the same locations. Zero disables the cache.
+	UPROPERTY(EditDefaultsOnly, Category = "Query", config, AdvancedDisplay, meta = (ClampMin = "0"))
+	int32 PathCacheSize = 0;
+
+	// The number of flow fields to keep around for reuse. Fields are cached by their goal
+	// node and are thrown out when any tile they cover changes. Zero disables the cache.
+	UPROPERTY(EditDefaultsOnly, Category = "Query", config, AdvancedDisplay, meta = (ClampMin = "0"))
+	int32 FlowFieldCacheSize = 8;
+
+	// The number of queriers to remember the last node of. Agents querying from about the
+	// same place every tick can then find their node again with a bounds check instead of
+	// a lookup from the tile. Zero disables the hints.
+	UPROPERTY(EditDefaultsOnly, Category = "Query", config, AdvancedDisplay, meta = (ClampMin = "0"))
+	int32 NodeHintCacheSize = 0;
+
 public:
 	// Tells the rendering component to redraw. If 'bForce' is true the redraw will occur
 	// regardless of whether navigation is flagged as drawing.
 	void RequestDrawingUpdate(bool bForce = false);
 
 	// A helper to get the supported area classes without duping off the whole array with
-	// strings and stuff, like GetSupportedAreas.
-	void GetSupportedAreaClasses(TArray<TWeakObjectPtr<UClass>>& AreaIDs) const;
+	// strings and stuff, like GetSupportedAreas. If 'OutAreaIDs' is set, it's filled with
+	// the ID of each area class.
+	void GetSupportedAreaClasses(TArray<TWeakObjectPtr<UClass>>& AreaIDs, TArray<int32>* OutAreaIDs = nullptr) const;
 	
 	///> Node Queries
 
@@ -148,7 +206,10 @@ public:
 	//
 	// NOTE: This will only return a valid node if it isn't blocked and exists within the
 	// generated bounds.
-	bool GetNodeAtLocation(const FVector& Location, NavNodeRef& OutNodeRef) const;
+	//
+	// If a querier is passed, the lookup starts from the node it was last found in (see
+	// NodeHintCacheSize).
+	bool GetNodeAtLocation(const FVector& Location, NavNodeRef& OutNodeRef, const UObject* Querier = nullptr) const;
 
 	// Finds the closest node within an extent from the supplied origin.
 	bool FindClosestNode(const FVector& Origin, const FVector& QueryExtent, NavNodeRef& OutNodeRef, FSharedConstNavQueryFilter QueryFilter = nullptr) const;
@@ -168,6 +229,138 @@ public:
 	// NOTE: If the lambda returns false, the search will be stopped.
 	bool ForEachReachableNode(const FVector& Origin, float MaxDistance, TFunction<bool(NavNodeRef)> Lambda, FSharedConstNavQueryFilter QueryFilter = nullptr) const;
 
+	// Same as ForEachReachableNode, but hands the nodes visited and their bounds to the
+	// lambda in chunks of up to 'ChunkSize', which is much cheaper when there are a lot
+	// of them.
+	//
+	// NOTE: If the lambda returns false, the search will be stopped.
+	bool ForEachReachableNodeChunk(const FVector& Origin, float MaxDistance, TFunctionRef<bool(TArrayView<const NavNodeRef> Nodes, TArrayView<const FBox> NodeBounds)> Lambda, FSharedConstNavQueryFilter QueryFilter = nullptr, int32 ChunkSize = 256) const;
+
+	///> Flow Fields
+
+	// Searches outward from the goal once and records, for every node reached, the next
+	// step to take toward the goal. When many agents share a goal each one only needs to
+	// look up its next step rather than running its own search. 'MaxCost' limits how far
+	// the field extends, zero for no limit.
+	//
+	// NOTE: Fields don't update as navigation changes, so call this again to pick up a
+	// rebuilt field. Unchanged fields come straight from the cache.
+	FGunfire3DNavFlowFieldPtr FindFlowField(const FVector& GoalLocation, float MaxCost = 0.f, FSharedConstNavQueryFilter QueryFilter = nullptr) const;
+
+	// Finds the next location to move to from 'Location' to follow the field toward its
+	// goal. Returns false if the field doesn't reach the location.
+	bool GetFlowFieldNextLocation(const FGunfire3DNavFlowField& FlowField, const FVector& Location, FVector& OutNextLocation) const;
+
+	// Finds the cost and length of the route the field takes from 'Location' to its goal,
+	// without running a search. The length follows the portals between nodes, so it's
+	// what the path would be before string pulling. Returns false if the field doesn't
+	// reach the location.
+	bool GetFlowFieldRoute(const FGunfire3DNavFlowField& FlowField, const FVector& Location, float& OutCost, float& OutLength) const;
+
+	///> Async Path Queries
+
+	// Submits a batch of path queries to be run on worker threads. Each query is
+	// processed exactly like FindPath, with results stored in the returned batch at the
+	// same index as their query. The batch can be polled, or 'OnComplete' will be called
+	// on the game thread once every path has been processed.
+	//
+	// NOTE: Must be called from the game thread.
+	FGunfire3DNavPathBatchRef RequestPathBatch(TArray<FPathFindingQuery> Queries, FGunfire3DNavPathBatchDelegate OnComplete = FGunfire3DNavPathBatchDelegate());
+
+	// Blocks until all in-flight path batches have finished reading the octree. Called
+	// before anything modifies or replaces the octree.
+	void WaitForPathBatches();
+
+	// Returns true if nothing is reading the octree in the background, so it can be
+	// modified right away. Otherwise new path batches are held back until EndOctreeWrite
+	// is called, so the writer only has to wait for the reads already in flight and can
+	// try again later rather than blocking.
+	//
+	// NOTE: Must be called from the game thread.
+	bool TryBeginOctreeWrite();
+
+	// Releases any path batches held back by TryBeginOctreeWrite
+	void EndOctreeWrite();
+
+	///> Time-Sliced Path Queries
+
+	// Submits a path query to be searched on the game thread a little at a time. All
+	// pending requests share a fixed per-frame budget (see NavSvo.TimeSlicedPathBudget),
+	// so an expensive search can't spike a single frame. The search is processed like
+	// FindPath, other than bidirectional searching being unavailable, and 'OnComplete'
+	// is called once it has finished.
+	//
+	// NOTE: Must be called from the game thread.
+	FGunfire3DNavTimeSlicedPathRef RequestTimeSlicedPath(const FPathFindingQuery& Query, FGunfire3DNavTimeSlicedPathDelegate OnComplete = FGunfire3DNavTimeSlicedPathDelegate());
+
+	// Stops a pending time-sliced path without calling its completion delegate
+	void CancelTimeSlicedPath(const FGunfire3DNavTimeSlicedPathRef& Request);
+
+	///> Coalesced Path Requests
+
+	// Submits a path query to be answered on worker threads, starting next tick. Requests
+	// made in the same tick for a path between the same start and goal nodes, with the
+	// same filter and flags, are answered by a single search, with each getting its own
+	// copy of the path. The highest priority requests are started first (up to
+	// NavSvo.PathRequestsPerTick a tick), and a request from a querier (the query's
+	// owner) which still has one waiting for an answer drops the older one. Otherwise
+	// the query is processed like FindPath, and 'OnComplete' is called once it's done.
+	//
+	// NOTE: Must be called from the game thread.
+	FGunfire3DNavPathRequestRef RequestPath(const FPathFindingQuery& Query, float Priority = 0.f, FGunfire3DNavPathRequestDelegate OnComplete = FGunfire3DNavPathRequestDelegate());
+
+	// Drops a path request without calling its completion delegate
+	void CancelPathRequest(const FGunfire3DNavPathRequestRef& Request);
+
+	///> Path Corridors
+	//
+	// Paths found with EGunfire3DNavPathFlags::IncrementalRepair keep the corridor of
+	// nodes they were searched through, which these use to follow small moves of the
+	// agent or its target without searching again. Each one fails, leaving the path
+	// untouched, if the move leaves the corridor, the corridor's tiles have changed, or
+	// there are dynamic obstacles, in which case the caller should find the path again.
+	//
+	// NOTE: The path's points are changed in place, so anything following the path
+	// should start again from its first segment.
+
+	// Moves the start of the path to 'NewStart', which must be in one of the corridor's
+	// nodes. The corridor behind it is dropped, along with the path points already
+	// passed. If the new start can't see the next path point, the path is rebuilt from
+	// the rest of the corridor.
+	bool AdvancePathStart(FGunfire3DNavPath& NavPath, const FVector& NewStart) const;
+
+	// Moves the end of the path to 'NewEnd', which must be in one of the last
+	// 'MaxEndNodes' nodes of the corridor. The corridor past it is dropped. If the end
+	// stays in the goal node and the path can still see it, only the last point moves,
+	// otherwise the path is rebuilt from the corridor.
+	bool RetargetPathEnd(FGunfire3DNavPath& NavPath, const FVector& NewEnd, int32 MaxEndNodes = 4) const;
+
+	///> Dynamic Obstacles
+
+	// Registers a blocked box or sphere which every query and raycast will avoid, without
+	// rebuilding the tiles it overlaps. Meant for obstacles which move or only exist for
+	// a short time, like moving platforms or force fields. Returns the ID to update or
+	// remove the obstacle with.
+	//
+	// NOTE: Active paths through the obstacle's new location are invalidated, so their
+	// owners will find them again.
+	uint32 AddObstacleBox(const FBox& Box);
+	uint32 AddObstacleSphere(const FVector& Center, float Radius);
+
+	// Moves or resizes a registered obstacle. Returns false if the ID isn't registered.
+	bool UpdateObstacleBox(uint32 ObstacleID, const FBox& Box);
+	bool UpdateObstacleSphere(uint32 ObstacleID, const FVector& Center, float Radius);
+
+	// Unregisters an obstacle. Returns false if the ID isn't registered.
+	bool RemoveObstacle(uint32 ObstacleID);
+
+	///> Clearance
+
+	// Sweeps an upright capsule from 'Start' to 'End', returning true if it hits anything.
+	// 'OutHitLocation' is set to the last location the capsule fit. This lets agents
+	// larger than the one this data was generated for check their clearance against it.
+	bool SweepCapsule(const FVector& Start, const FVector& End, float Radius, float HalfHeight, FVector& OutHitLocation) const;
+
 	// Returns true if the given point is within the bounds that are being used to
 	// generate this navigation data.
 	bool IsLocationWithinGenerationBounds(const FVector& Location) const;
@@ -224,6 +417,10 @@ public:
 	// rebuilt otherwise.
 	virtual void RestrictBuildingToActiveTiles(bool bInRestrictBuildingToActiveTiles) override;
 
+	// Keeps the area costs of the default filter in sync with the supported areas
+	virtual void OnNavAreaAdded(const UClass* NavAreaClass, int32 AgentIndex) override;
+	virtual void OnNavAreaRemoved(const UClass* NavAreaClass) override;
+
 protected:
 	virtual void FillConfig(FNavDataConfig& Dest) override;
 
@@ -239,6 +436,10 @@ public:
 
 #if !UE_BUILD_SHIPPING
 	virtual uint32 LogMemUsed() const override;
+
+	// Logs the memory used by each layer of the octree and the largest tiles, along with
+	// the caches and the scratch memory of queries and generation
+	void LogMemUsage(int32 NumLargestTiles) const;
 #endif // !UE_BUILD_SHIPPING
 
 	// Constructs the debug rendering component for this navigation area
@@ -247,6 +448,11 @@ public:
 	// Callback registered with ANavigationData to find a path
 	static FPathFindingResult FindPath(const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query);
 
+	// Callback registered with ANavigationData to find a path hierarchically. A coarse
+	// search over the tile graph first picks the tiles the path should pass through, and
+	// the detailed search is then restricted to those tiles.
+	static FPathFindingResult FindHierarchicalPath(const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query);
+
 	// Callback registered with ANavigationData for testing the path to a location
 	static bool TestPath(const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query, int32* NumVisitedNodes);
 
@@ -298,6 +504,7 @@ public:
 	//~ Begin AActor Interface
 protected:
 	virtual void PostInitProperties() override;
+	virtual void BeginDestroy() override;
 
 	virtual void Serialize(FArchive& Ar) override;
 
@@ -318,6 +525,12 @@ protected:
 	// Forces the default filter to be created
 	void RecreateDefaultFilter();
 
+	// Sets the cost of every supported area on the default filter from its defaults
+	void UpdateDefaultAreaCosts();
+
+	// Creates (or removes) the path and flow field caches based on their sizes
+	void RecreatePathCache();
+
 	// Will return the default query if the supplied query is invalid.
 	const FNavigationQueryFilter& ResolveFilterRef(FSharedConstNavQueryFilter Filter) const
 	{
@@ -330,6 +543,17 @@ protected:
 	// Called by the installed implementation's generator once it's finished generating.
 	void OnGenerationComplete();
 
+	// Invalidates all active paths passing through any of the tiles, so they're found
+	// again (or repaired) with the latest navigation. Called by the generator whenever
+	// tiles are rebuilt or removed.
+	void InvalidateAffectedPaths(TArrayView<const uint32> ChangedTileIDs);
+
+	// Invalidates all active paths with a segment passing through the bounds
+	void InvalidatePathsInBounds(const FBox& Bounds);
+
+	// Returns the runtime obstacles, creating them if needed
+	FSvoObstacles& EnsureObstacles();
+
 	// Informs the rendering component to refresh
 	void UpdateDrawing();
 
@@ -337,9 +561,142 @@ protected:
 	FNavSvoGenerator* GetNavSvoGenerator();
 	const FNavSvoGenerator* GetNavSvoGenerator() const;
 
+	// Shared implementation of FindPath and FindHierarchicalPath
+	static FPathFindingResult FindPathInternal(const FPathFindingQuery& Query, bool bHierarchical);
+
+	///> Path finding stages, shared between immediate and time-sliced queries
+
+	// Resolves the path a query should fill, creating one if the query didn't supply it
+	static FNavPathSharedPtr PreparePathInstance(const AGunfire3DNavData& Self, const FPathFindingQuery& Query);
+
+	// Finds the open nodes closest to the start and end of the query
+	static bool FindPathEndpoints(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, FNavSvoPathEndpoints& OutEndpoints);
+
+	// Fills the path from the path cache if it has a valid path between the endpoints
+	static bool FindCachedPath(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, bool bHierarchical, FGunfire3DNavPath& NavPath);
+
+	// Repairs the corridor a path was previously built from by searching again only
+	// around the tiles which have changed since, leaving the search results in the path
+	// ready to be finished. Returns false if the path needs a full search instead.
+	static bool RepairPath(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, FGunfire3DNavPath& NavPath);
+
+	// String pulls, cleans up and smooths the path points, as the path asks for
+	static void PostProcessPath(const AGunfire3DNavData& Self, FGunfire3DNavPath& NavPath);
+
+	// Returns true if the path's corridor still matches the octree, so the path can be
+	// moved along it
+	bool CanFollowCorridor(const FGunfire3DNavPath& NavPath) const;
+
+	// Builds the final path from the search results stored in the path
+	static ENavigationQueryResult::Type FinishPath(const AGunfire3DNavData& Self, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, bool bHierarchical, FGunfire3DNavPath& NavPath);
+
+	// Finds the closest node to a location, starting from the node the querier was last
+	// found in if there's a hint for it (see NodeHintCacheSize)
+	FSvoNodeLink FindClosestNodeForQuerier(FNavSvoNodeQuery& NodeQuery, const FVector& Location, const UObject* Querier, FVector* OutClosestPoint = nullptr) const;
+
+	// Returns the path cache and fills out the key if paths for the query can be cached
+	FNavSvoPathCache* GetPathCacheForQuery(const FGunfire3DNavQueryFilter& QueryFilter, const FPathFindingQuery& Query, const FNavSvoPathEndpoints& Endpoints, bool bHierarchical, FNavSvoPathCacheKey& OutKey) const;
+
 private:
 	// Generated octree for this implementation
 	TSharedPtr<FEditableSvo, ESPMode::ThreadSafe> Octree;
 
+	// Completion events for path batches (and tile reads, see UpdateTileResidency) that may
+	// still be reading the octree
+	FGraphEventArray PendingPathBatchEvents;
+
+	// While something is waiting to modify the octree (see TryBeginOctreeWrite), new reads
+	// are held back behind this event, and their completion events are kept separately
+	// so the writer doesn't wait on them.
+	FGraphEventRef OctreeWriteGate;
+	FGraphEventArray HeldPathBatchEvents;
+
+	// Returns the events a new background read of the octree needs to wait for
+	FGraphEventArray GetBackgroundReadPrerequisites() const;
+
+	// Tracks a background read of the octree, so nothing modifies it until it's done
+	void AddBackgroundRead(const FGraphEventRef& CompletionEvent);
+
+	// Finished paths kept for reuse (see PathCacheSize)
+	TSharedPtr<FNavSvoPathCache, ESPMode::ThreadSafe> PathCache;
+
+	// Finished flow fields kept for reuse (see FlowFieldCacheSize)
+	TSharedPtr<FNavSvoFlowFieldCache, ESPMode::ThreadSafe> FlowFieldCache;
+
+	// The last node of each querier (see NodeHintCacheSize)
+	TSharedPtr<FNavSvoNodeHints, ESPMode::ThreadSafe> NodeHints;
+
+	// Path requests being searched over multiple frames
+	TSharedPtr<FNavSvoTimeSlicedPathManager> TimeSlicedPaths;
+
+	// Coalesces path requests, created on the first one
+	TSharedPtr<FNavSvoPathRequestManager> PathRequests;
+
+	// Runtime obstacles shared with the octree (see AddObstacleBox)
+	TSharedPtr<FSvoObstacles, ESPMode::ThreadSafe> Obstacles;
+
+	// Compresses tiles which haven't been used for a while (see NavSvo.ColdTileIdleTime)
+	bool TickColdTiles(float DeltaTime);
+
+	// Evicts tiles far from every player to disk, and reads back the ones players are
+	// approaching (see NavSvo.ResidencyRadius)
+	void UpdateTileResidency();
+
+	// Frees tiles while the octree is over MemoryBudgetMB
+	void EnforceMemoryBudget();
+
+	// Returns true if any path batches or tile reads could still be reading the octree
+	bool HasPendingBackgroundReads() const;
+
+	// Path finding and path tests can be run on any thread without being tracked as a
+	// background read (e.g. the navigation system's async path queries), so they hold
+	// this for reading. Anything freeing nodes has to get it for writing first.
+	mutable FRWLock NodeReadersLock;
+
+	// Tries to lock out queries for freeing nodes, returning false if any reads could
+	// still be running. Call EndFreeingNodes when done.
+	bool TryBeginFreeingNodes() const;
+	void EndFreeingNodes() const;
+
+	FTSTicker::FDelegateHandle ColdTileTickerHandle;
+
+	// The read back of evicted tiles near players, while it's running. No more are started
+	// until it's done, so the same tiles aren't queued up again every tick.
+	FGraphEventRef TilePrefetchEvent;
+
+	// Tiles of a streamed level waiting to be added to (or removed from) the octree.
+	// They're merged a few at a time so streaming in a large level doesn't hitch.
+	struct FStreamingLevelMerge
+	{
+		TWeakObjectPtr<class UNavSvoStreamingData> StreamingData;
+
+		// Coordinates of the level's tiles, ordered so each batch stays compact
+		TArray<FIntVector> TileCoords;
+
+		// Index of the next tile to merge. Tiles before this are already in the octree.
+		int32 NextTileIdx = 0;
+
+		bool bRemove = false;
+
+		// Set while the level's octree is still being read in
+		bool bWaitingForLoad = false;
+	};
+
+	// Queues the tiles of a streamed level to be merged in or out of the octree
+	void QueueStreamingLevelMerge(class UNavSvoStreamingData* StreamingData, bool bRemove);
+
+	// Fills 'OutTileCoords' with the tiles of a streamed octree, in the order to merge them
+	static void GetStreamingMergeOrder(const FEditableSvo& StreamedSvo, TArray<FIntVector>& OutTileCoords);
+
+	// Merges pending streamed tiles until NavSvo.StreamingMergeTimePerTick is used up
+	bool TickStreamingLevelMerges(float DeltaTime);
+
+	TArray<FStreamingLevelMerge> PendingStreamingMerges;
+
+	FTSTicker::FDelegateHandle StreamingMergeTickerHandle;
+
+	// Frame counter at each of the last few cold tile ticks
+	TArray<uint64> ColdTileFrameHistory;
+
 	static bool bGenerationBoostMode;
 };
\ No newline at end of file
@@ -4,12 +4,14 @@
 
 #include "Gunfire3DNavQueryFilter.h"
 
+#include "Async/TaskGraphInterfaces.h"
 #include "NavigationData.h"
 
 enum class EGunfire3DNavPathFlags : uint8
 {
 	SkipStringPulling	= 1 << 0,
 	SkipSmoothing		= 1 << 1,
+	IncrementalRepair	= 1 << 2,
 };
 
 enum class EGunfire3DNavPathQueryFlags : uint8
@@ -27,6 +29,9 @@ struct FGunfire3DNavPathQueryResults : FGunfire3DNavQueryResults
 	float PathCost = 0.f;
 	TArray<FNavPathPoint> PathPortalPoints;
 
+	// Cost of the path up to each portal point
+	TArray<float> PathPortalCosts;
+
 	virtual void Reset() override
 	{
 		FGunfire3DNavQueryResults::Reset();
@@ -35,6 +40,7 @@ struct FGunfire3DNavPathQueryResults : FGunfire3DNavQueryResults
 		PathLength = 0.f;
 		PathCost = 0.f;
 		PathPortalPoints.Reset();
+		PathPortalCosts.Reset();
 	}
 
 	bool IsPartial()
@@ -48,6 +54,65 @@ struct FGunfire3DNavPathQueryResults : FGunfire3DNavQueryResults
 	}
 };
 
+// The route a path was built from, before any post-processing. Kept with the path so it
+// can be repaired when only some of the tiles it passes through are rebuilt, rather than
+// being searched again from scratch, and so small moves of its start and end can be
+// followed without a search at all. See EGunfire3DNavPathFlags::IncrementalRepair and
+// AGunfire3DNavData::AdvancePathStart.
+struct FGunfire3DNavPathCorridor
+{
+	struct FTileVersion
+	{
+		uint32 TileID;
+		uint32 Version;
+	};
+
+	// The start, the portal into each node along the path, then the end
+	TArray<FNavPathPoint> Points;
+
+	// Cost of the path up to each point
+	TArray<float> Costs;
+
+	// Versions of the tiles the corridor passes through when it was found
+	TArray<FTileVersion> TileVersions;
+
+	// The filter and flags the corridor was searched with
+	uint32 FilterHash = 0;
+	uint32 NavDataFlags = 0;
+
+	bool IsValid() const { return Points.Num() >= 2 && Points.Num() == Costs.Num(); }
+
+	// Index of the point the corridor enters the goal node at. The last point is the end
+	// location within the goal node, so only the points before it have a node of their
+	// own.
+	int32 GetGoalIdx() const { return Points.Num() - 2; }
+
+	// Returns the index of the last point entering 'NodeRef', searching back from the
+	// goal node no further than 'FirstIdx', or INDEX_NONE if the corridor doesn't pass
+	// through it there.
+	int32 FindNode(NavNodeRef NodeRef, int32 FirstIdx = 0) const
+	{
+		for (int32 PointIdx = GetGoalIdx(); PointIdx >= FirstIdx; --PointIdx)
+		{
+			if (Points[PointIdx].NodeRef == NodeRef)
+			{
+				return PointIdx;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+	void Reset()
+	{
+		Points.Reset();
+		Costs.Reset();
+		TileVersions.Reset();
+		FilterHash = 0;
+		NavDataFlags = 0;
+	}
+};
+
 struct GUNFIRE3DNAVIGATION_API FGunfire3DNavPath : public FNavigationPath
 {
 	typedef FNavigationPath Super;
@@ -62,6 +127,21 @@ struct GUNFIRE3DNAVIGATION_API FGunfire3DNavPath : public FNavigationPath
 	bool WantsSmoothing() const { return bSmooth; }
 	void SetWantsSmoothing(bool bValue) { bSmooth = bValue; }
 
+	// If true, the route the path was built from is kept so that when the path is
+	// invalidated by tiles being rebuilt, only the parts through those tiles need to be
+	// searched again. It also lets the start and end be moved along the route without a
+	// new search (see AGunfire3DNavData::AdvancePathStart and RetargetPathEnd).
+	bool WantsIncrementalRepair() const { return bIncrementalRepair; }
+	void SetWantsIncrementalRepair(bool bValue);
+
+	// The route kept for incremental repair and corridor following, empty unless it was
+	// requested
+	FGunfire3DNavPathCorridor& GetCorridor() { return Corridor; }
+	const FGunfire3DNavPathCorridor& GetCorridor() const { return Corridor; }
+
+	// Returns true if the path passes through any of the tiles
+	bool PassesThroughTiles(TArrayView<const uint32> TileIDs) const;
+
 	// Information about how the path was generated
 	FGunfire3DNavPathQueryResults& GetGenerationInfo() { return GenerationInfo; }
 	const FGunfire3DNavPathQueryResults& GetGenerationInfo() const { return GenerationInfo; }
@@ -73,7 +153,7 @@ struct GUNFIRE3DNAVIGATION_API FGunfire3DNavPath : public FNavigationPath
 
 	// Resets all variables describing generated path before attempting new path finding
 	// call. This function will NOT reset setup variables like goal actor, filter,
-	// observer, etc
+	// observer, etc. The corridor is kept so the new search can repair it.
 	virtual void ResetForRepath() override;
 
 	// This is a duplicate of FNavigationPath::DebugDraw less the
@@ -88,6 +168,181 @@ public:
 private:
 	bool bStringPull = true;
 	bool bSmooth = true;
+	bool bIncrementalRepair = false;
 
 	FGunfire3DNavPathQueryResults GenerationInfo;
-};
\ No newline at end of file
+	FGunfire3DNavPathCorridor Corridor;
+};
+
+// A set of path requests which are processed asynchronously on worker threads. See
+// AGunfire3DNavData::RequestPathBatch.
+class GUNFIRE3DNAVIGATION_API FGunfire3DNavPathBatch
+{
+	friend class AGunfire3DNavData;
+
+public:
+	// Returns true once every path in the batch has been processed.
+	bool IsComplete() const;
+
+	// Blocks the calling thread until every path in the batch has been processed.
+	void Wait() const;
+
+	int32 Num() const { return Queries.Num(); }
+
+	// The queries as submitted. Results are stored at the same index as their query.
+	const TArray<FPathFindingQuery>& GetQueries() const { return Queries; }
+
+	// NOTE: Results are only safe to read once the batch is complete.
+	const TArray<FPathFindingResult>& GetResults() const { return Results; }
+
+private:
+	TArray<FPathFindingQuery> Queries;
+	TArray<FPathFindingResult> Results;
+
+	// Signaled once every path task in the batch has finished
+	FGraphEventRef CompletionEvent;
+};
+
+typedef TSharedRef<FGunfire3DNavPathBatch, ESPMode::ThreadSafe> FGunfire3DNavPathBatchRef;
+
+// Called on the game thread once all paths in a batch have been processed
+DECLARE_DELEGATE_OneParam(FGunfire3DNavPathBatchDelegate, FGunfire3DNavPathBatchRef);
+class FGunfire3DNavTimeSlicedPath;
+typedef TSharedRef<FGunfire3DNavTimeSlicedPath, ESPMode::ThreadSafe> FGunfire3DNavTimeSlicedPathRef;
+
+// Called on the game thread once a time-sliced path has finished
+DECLARE_DELEGATE_OneParam(FGunfire3DNavTimeSlicedPathDelegate, FGunfire3DNavTimeSlicedPathRef);
+
+// A path request whose search is spread over multiple frames, sharing a fixed per-frame
+// budget with all other pending requests. See AGunfire3DNavData::RequestTimeSlicedPath.
+class GUNFIRE3DNAVIGATION_API FGunfire3DNavTimeSlicedPath
+{
+	friend class FNavSvoTimeSlicedPathManager;
+
+public:
+	FGunfire3DNavTimeSlicedPath(const FPathFindingQuery& InQuery, FGunfire3DNavTimeSlicedPathDelegate InOnComplete)
+		: Query(InQuery)
+		, OnComplete(InOnComplete)
+	{}
+
+	// Returns true once the path has been found (or failed to be)
+	bool IsComplete() const { return bComplete; }
+
+	// The query as submitted
+	const FPathFindingQuery& GetQuery() const { return Query; }
+
+	// NOTE: The result is only valid once the request is complete.
+	const FPathFindingResult& GetResult() const { return Result; }
+
+	// The number of frames the search has run over so far
+	int32 GetNumSlices() const { return NumSlices; }
+
+private:
+	FPathFindingQuery Query;
+	FPathFindingResult Result;
+	FGunfire3DNavTimeSlicedPathDelegate OnComplete;
+	int32 NumSlices = 0;
+	bool bComplete = false;
+};
+
+class FGunfire3DNavPathRequest;
+typedef TSharedRef<FGunfire3DNavPathRequest, ESPMode::ThreadSafe> FGunfire3DNavPathRequestRef;
+
+// Called on the game thread once a path request has been answered
+DECLARE_DELEGATE_OneParam(FGunfire3DNavPathRequestDelegate, FGunfire3DNavPathRequestRef);
+
+// A path request answered by the path request service, which shares one search between
+// requests for the same path and drops requests superseded by a newer one from the same
+// querier. See AGunfire3DNavData::RequestPath.
+class GUNFIRE3DNAVIGATION_API FGunfire3DNavPathRequest
+{
+	friend class FNavSvoPathRequestManager;
+
+public:
+	FGunfire3DNavPathRequest(const FPathFindingQuery& InQuery, float InPriority, FGunfire3DNavPathRequestDelegate InOnComplete)
+		: Query(InQuery)
+		, OnComplete(InOnComplete)
+		, Priority(InPriority)
+	{}
+
+	// Returns true once the path has been found (or failed to be)
+	bool IsComplete() const { return bComplete; }
+
+	// Returns true if the request was cancelled, or replaced by a newer request from
+	// the same querier before it was answered. Dropped requests never complete.
+	bool IsDropped() const { return bDropped; }
+
+	// Returns true if the path was copied from a search run for another request
+	bool WasShared() const { return bShared; }
+
+	// The query as submitted
+	const FPathFindingQuery& GetQuery() const { return Query; }
+
+	float GetPriority() const { return Priority; }
+
+	// NOTE: The result is only valid once the request is complete.
+	const FPathFindingResult& GetResult() const { return Result; }
+
+private:
+	FPathFindingQuery Query;
+	FPathFindingResult Result;
+	FGunfire3DNavPathRequestDelegate OnComplete;
+	float Priority = 0.f;
+
+	// Order the request was made in, for requests of the same priority
+	uint64 Sequence = 0;
+
+	bool bComplete = false;
+	bool bDropped = false;
+	bool bShared = false;
+};
+
+// The result of a one-to-many search outward from a goal. Every node the search reached
+// knows the next node to move into on the cheapest route to the goal, so any number of
+// agents heading to the same goal can share a single search. See
+// AGunfire3DNavData::FindFlowField.
+//
+// NOTE: Fields are read-only once built and don't update as the navigation changes.
+class GUNFIRE3DNAVIGATION_API FGunfire3DNavFlowField
+{
+	friend class FNavSvoFlowFieldQuery;
+
+public:
+	struct FStep
+	{
+		// The next node toward the goal. The goal node points at itself.
+		NavNodeRef NextNodeRef = 0;
+
+		// The location on the face shared with the next node to move through, or the
+		// goal location for the goal node.
+		FVector PortalLocation = FVector::ZeroVector;
+
+		// Cost of the route from this node to the goal
+		float Cost = 0.f;
+	};
+
+	NavNodeRef GetGoalNodeRef() const { return GoalNodeRef; }
+	const FVector& GetGoalLocation() const { return GoalLocation; }
+
+	// Returns the step to take from the specified node, or null if the field doesn't
+	// reach it.
+	const FStep* FindStep(NavNodeRef NodeRef) const { return Steps.Find(NodeRef); }
+
+	const TMap<NavNodeRef, FStep>& GetSteps() const { return Steps; }
+
+	int32 Num() const { return Steps.Num(); }
+
+	// True if the search ran out of nodes before covering everything within the cost
+	// limit.
+	bool IsTruncated() const { return bTruncated; }
+
+	uint32 GetMemUsed() const { return sizeof(*this) + Steps.GetAllocatedSize(); }
+
+private:
+	NavNodeRef GoalNodeRef = 0;
+	FVector GoalLocation = FVector::ZeroVector;
+	TMap<NavNodeRef, FStep> Steps;
+	bool bTruncated = false;
+};
+
+typedef TSharedPtr<const FGunfire3DNavFlowField, ESPMode::ThreadSafe> FGunfire3DNavFlowFieldPtr;
@@ -10,6 +10,10 @@
 #define NAVDATA_DEFAULT_HEURISTIC_SCALE 2.f
 #define NAVDATA_DEFAULT_BASE_TRAVERSAL_COST 1.f
 
+// Number of nav areas the filter can set costs for. Areas with higher IDs are treated as
+// having no area.
+#define NAVDATA_MAX_AREAS 32
+
 enum class EGunfire3DNavQueryFlags : uint8
 {
 	// Result flags
@@ -26,6 +30,22 @@ enum class EGunfire3DNavQueryFlags : uint8
 };
 ENUM_CLASS_FLAGS(EGunfire3DNavQueryFlags);
 
+// The priority queue used to order open nodes during a search
+UENUM()
+enum class EGunfire3DNavOpenListType : uint8
+{
+	// Binary heap of nodes
+	BinaryHeap,
+
+	// 4-ary heap which stores each node's cost inline, so reordering never has to touch
+	// the nodes themselves.
+	QuaternaryHeap,
+
+	// Nodes are grouped into buckets of similar cost. Cheapest to maintain, but nodes
+	// within a bucket aren't ordered, so paths may be slightly less optimal.
+	Buckets,
+};
+
 struct FGunfire3DNavQueryConstraints
 {
 public:
@@ -53,6 +73,34 @@ private:
 	TArray<FBox> Bounds;
 };
 
+// How long each stage of a query took, in milliseconds. These are only captured while
+// NavSvo.QueryTimings is enabled.
+struct FGunfire3DNavQueryTimings
+{
+	// Identifies the query in trace events. Zero if the query wasn't timed.
+	uint32 QueryID = 0;
+
+	// Finding the nodes for the query locations
+	float NodeLookupTime = 0.f;
+
+	// Searching the octree
+	float SearchTime = 0.f;
+
+	// Path post-processing
+	float StringPullTime = 0.f;
+	float SmoothingTime = 0.f;
+
+	float GetTotalTime() const
+	{
+		return NodeLookupTime + SearchTime + StringPullTime + SmoothingTime;
+	}
+
+	void Reset()
+	{
+		*this = FGunfire3DNavQueryTimings();
+	}
+};
+
 struct FGunfire3DNavQueryResults
 {
 	// The overall status of the query
@@ -73,6 +121,9 @@ struct FGunfire3DNavQueryResults
 	// How much memory was required to run the query.
 	uint32 MemUsed = 0;
 
+	// Per-stage timings, if enabled
+	FGunfire3DNavQueryTimings Timings;
+
 	virtual ~FGunfire3DNavQueryResults() {}
 	virtual void Reset()
 	{
@@ -82,6 +133,7 @@ struct FGunfire3DNavQueryResults
 		NumNodesReopened = 0;
 		NumNodesVisited = 0;
 		MemUsed = 0;
+		Timings.Reset();
 	}
 };
 
@@ -90,14 +142,16 @@ class GUNFIRE3DNAVIGATION_API FGunfire3DNavQueryFilter : public INavigationQuery
 	friend class AGunfire3DNavData;
 
 public:
+	FGunfire3DNavQueryFilter() { Reset(); }
+
 	//~ Begin INavigationQueryFilterInterface Interface
-	virtual void Reset() override {}
+	virtual void Reset() override;
 
-	virtual void SetAreaCost(uint8 AreaType, float Cost) override {}
-	virtual void SetFixedAreaEnteringCost(uint8 AreaType, float Cost) override {}
-	virtual void SetExcludedArea(uint8 AreaType) override {}
-	virtual void SetAllAreaCosts(const float* CostArray, const int32 Count) override {}
-	virtual void GetAllAreaCosts(float* CostArray, float* FixedCostArray, const int32 Count) const override {}
+	virtual void SetAreaCost(uint8 AreaType, float Cost) override;
+	virtual void SetFixedAreaEnteringCost(uint8 AreaType, float Cost) override;
+	virtual void SetExcludedArea(uint8 AreaType) override;
+	virtual void SetAllAreaCosts(const float* CostArray, const int32 Count) override;
+	virtual void GetAllAreaCosts(float* CostArray, float* FixedCostArray, const int32 Count) const override;
 	virtual void SetBacktrackingEnabled(const bool bBacktracking) override {}
 	virtual bool IsBacktrackingEnabled() const override { return false; }
 	virtual float GetHeuristicScale() const override { return HeuristicScale; }
@@ -111,6 +165,10 @@ public:
 	virtual INavigationQueryFilterInterface* CreateCopy() const override;
 	//~ End INavigationQueryFilterInterface Interface
 
+	// Returns a hash of the filter. Filters which are considered equal by IsEqual will
+	// always have the same hash.
+	uint32 GetHash() const;
+
 	// A scalar applied to the cost of nodes during path finding. The larger the scale,
 	// the more the path finding will favor choosing nodes that are closer to the
 	// destination, regardless of obstacles.
@@ -123,12 +181,73 @@ public:
 	float GetBaseTraversalCost() const { return BaseTraversalCost; }
 	void SetBaseTraversalCost(float Cost) { BaseTraversalCost = Cost; }
 
+	// Nodes closer than this to any geometry aren't searched, so agents larger than the
+	// one the nav data was built for can use it. Only has an effect on nav data built
+	// with clearance (see AGunfire3DNavData::MaxClearance), and clearance beyond what it
+	// was built with is treated as enough.
+	float GetMinClearance() const { return MinClearance; }
+	void SetMinClearance(float Clearance) { MinClearance = Clearance; }
+
+	// If set, partially blocked nodes on this octree layer or below are treated as
+	// blocked rather than searched through, except around the start and goal. This makes
+	// for a much smaller search for agents that don't need accurate paths (e.g. far away
+	// or off screen), at the cost of missing ways through cluttered space. Zero stops the
+	// search from going into leaf voxels, and INDEX_NONE searches at full detail.
+	int32 GetCoarseSearchLayer() const { return CoarseSearchLayer; }
+	void SetCoarseSearchLayer(int32 LayerIdx) { CoarseSearchLayer = LayerIdx; }
+
+	// If true, paths are searched for from both the start and the goal at the same time,
+	// joining where the two searches meet. This can visit far fewer nodes when the goal
+	// is enclosed, since the forward search won't need to flood the open space around
+	// the start before finding a way in.
+	//
+	// NOTE: Ignored when any areas have entering costs. Those are charged for the area on
+	// the far side of each change of area, which the reverse search sees the other way
+	// around, so they don't add up to the same cost along a path in both directions.
+	bool IsBidirectionalSearch() const { return bBidirectionalSearch; }
+	void SetBidirectionalSearch(bool bEnable) { bBidirectionalSearch = bEnable; }
+
+	// If true, the search heuristic also uses the distances between tiles to a few
+	// landmark tiles, which accounts for the walls a path has to go around. This can
+	// visit far fewer nodes when paths need to double back, at the cost of building the
+	// landmark distances the first time they're needed after the nav data changes.
+	bool IsLandmarkHeuristic() const { return bLandmarkHeuristic; }
+	void SetLandmarkHeuristic(bool bEnable) { bLandmarkHeuristic = bEnable; }
+
+	// The priority queue used to order open nodes during the search
+	EGunfire3DNavOpenListType GetOpenListType() const { return OpenListType; }
+	void SetOpenListType(EGunfire3DNavOpenListType Type) { OpenListType = Type; }
+
 	// All nodes queried must be within all constraints. Paths nodes will also be
 	// constrained to these bounds.
 	FGunfire3DNavQueryConstraints& GetConstraints() { return Constraints; }
 	const FGunfire3DNavQueryConstraints& GetConstraints() const { return Constraints; }
 	void SetConstraints(const FGunfire3DNavQueryConstraints& NewConstraints) { Constraints = NewConstraints; }
 
+	// Cost tables indexed by the area codes stored on nodes, which are the area ID plus
+	// one (see FSvoTile::GetArea). The first entry is for nodes that aren't in any area,
+	// which keeps a multiplier of one and no entering cost.
+	const float* GetAreaCostTable() const { return AreaCosts; }
+	const float* GetAreaEnteringCostTable() const { return AreaEnteringCosts; }
+
+	// Returns true if an area code is one queries can't enter
+	bool IsAreaCodeExcluded(uint8 AreaCode) const { return (ExcludedAreaCodes & (1ull << AreaCode)) != 0; }
+
+	// Returns true if any area has a cost or is excluded, otherwise the areas of nodes
+	// don't need to be looked up at all.
+	bool HasAreaCosts() const { return bHasAreaCosts; }
+
+	// Returns true if entering any area costs extra
+	bool HasAreaEnteringCosts() const;
+
+	// Takes the area costs and exclusions of another filter
+	void CopyAreaCosts(const FGunfire3DNavQueryFilter& Other);
+
+	// Reads or writes the search settings, area costs and constraints of the filter, so
+	// a query can be run again with the same filter (see FNavSvoQueryCapture).
+	// OnNodeVisited isn't included.
+	void Serialize(FArchive& Ar);
+
 	// If valid, called every time a node is visited. Returning false form this function
 	// will stop the search.
 	TFunction<bool(NavNodeRef)> OnNodeVisited;
@@ -136,6 +255,17 @@ public:
 private:
 	float HeuristicScale = NAVDATA_DEFAULT_HEURISTIC_SCALE;
 	float BaseTraversalCost = NAVDATA_DEFAULT_BASE_TRAVERSAL_COST;
+	float MinClearance = 0.f;
+	int32 CoarseSearchLayer = INDEX_NONE;
+	bool bBidirectionalSearch = false;
+	bool bLandmarkHeuristic = false;
+	EGunfire3DNavOpenListType OpenListType = EGunfire3DNavOpenListType::BinaryHeap;
+
+	// See GetAreaCostTable. These are set up by Reset.
+	float AreaCosts[NAVDATA_MAX_AREAS + 1];
+	float AreaEnteringCosts[NAVDATA_MAX_AREAS + 1];
+	uint64 ExcludedAreaCodes;
+	bool bHasAreaCosts;
 
 	FGunfire3DNavQueryConstraints Constraints;
 };
@@ -167,6 +297,37 @@ public:
 	UPROPERTY(EditDefaultsOnly)
 	float NodeBaseTraversalCost = NAVDATA_DEFAULT_BASE_TRAVERSAL_COST;
 
+	// How far from any geometry a path must stay. Lets larger agents path through nav
+	// data built for a smaller agent, if it was built with enough clearance (see
+	// AGunfire3DNavData::MaxClearance).
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.0"))
+	float MinClearance = 0.f;
+
+	// Caps how fine the search goes, for agents that don't need accurate paths (e.g. far
+	// away or off screen). Cluttered space on this octree layer or below is treated as
+	// blocked, except around the start and destination. Zero skips leaf voxels, and -1
+	// searches at full detail.
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay, meta = (ClampMin = "-1"))
+	int32 CoarseSearchLayer = INDEX_NONE;
+
+	// Searches for paths from both the start and the destination at once. This is
+	// usually faster when destinations are enclosed (e.g. rooms or caves), but paths may
+	// be slightly less optimal.
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay)
+	bool bBidirectionalPathSearch = false;
+
+	// Guides the search with distances to landmarks spread around the nav data, as well
+	// as the distance to the destination. This is usually faster when paths need to go
+	// a long way around walls, but the landmarks take memory and need to be rebuilt
+	// whenever the nav data changes.
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay)
+	bool bLandmarkPathHeuristic = false;
+
+	// The priority queue used to order nodes while searching. Mostly useful for
+	// profiling, since the best choice depends on how large the searches are.
+	UPROPERTY(EditDefaultsOnly, AdvancedDisplay)
+	EGunfire3DNavOpenListType OpenListType = EGunfire3DNavOpenListType::BinaryHeap;
+
 protected:
 	virtual void InitializeFilter(const class ANavigationData& NavData, const UObject* Querier, FNavigationQueryFilter& Filter) const override;
 };
\ No newline at end of file
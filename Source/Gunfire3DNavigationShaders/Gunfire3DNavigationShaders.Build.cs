@@ -0,0 +1,26 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+namespace UnrealBuildTool.Rules
+{
+	public class Gunfire3DNavigationShaders : ModuleRules
+	{
+		public Gunfire3DNavigationShaders(ReadOnlyTargetRules Target) : base(Target)
+		{
+			PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+			PublicDependencyModuleNames.AddRange(
+				new string[]
+				{
+					"Core",
+				});
+
+			PrivateDependencyModuleNames.AddRange(
+				new string[]
+				{
+					"Projects",
+					"RHI",
+					"RenderCore",
+				});
+		}
+	}
+}
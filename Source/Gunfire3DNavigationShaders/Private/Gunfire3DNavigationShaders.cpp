@@ -0,0 +1,26 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "ShaderCore.h"
+
+//
+// Holds the compute shaders used by the navigation generator. Global shaders have to be
+// registered before the engine starts compiling shaders, which is earlier than the main
+// module can load, so they live in a module of their own.
+//
+class FGunfire3DNavigationShaders : public IModuleInterface
+{
+	virtual void StartupModule() override
+	{
+		TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("Gunfire3DNavigation"));
+		if (ensure(Plugin.IsValid()))
+		{
+			const FString ShaderDir = FPaths::Combine(Plugin->GetBaseDir(), TEXT("Shaders"));
+			AddShaderSourceDirectoryMapping(TEXT("/Plugin/Gunfire3DNavigation"), ShaderDir);
+		}
+	}
+};
+
+IMPLEMENT_MODULE(FGunfire3DNavigationShaders, Gunfire3DNavigationShaders)
@@ -0,0 +1,225 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#include "NavSvoGPUVoxelizer.h"
+
+#include "Async/Future.h"
+#include "DataDrivenShaderPlatformInfo.h"
+#include "GlobalShader.h"
+#include "Misc/App.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RenderingThread.h"
+#include "RHIGPUReadback.h"
+#include "ShaderParameterStruct.h"
+
+namespace NavSvoGPUVoxelizer
+{
+	constexpr int32 ThreadGroupSize = 64;
+
+	// Triangles are spread over a 2D grid of groups, to get past the limit on the number
+	// of groups along one axis.
+	constexpr int32 MaxGroupsPerAxis = 65535;
+}
+
+// Rasterizes triangles into the voxels, one group per triangle
+class FNavSvoVoxelizeCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FNavSvoVoxelizeCS);
+	SHADER_USE_PARAMETER_STRUCT(FNavSvoVoxelizeCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<float3>, Vertices)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, Voxels)
+		SHADER_PARAMETER(FIntVector, FillMin)
+		SHADER_PARAMETER(FIntVector, FillMax)
+		SHADER_PARAMETER(int32, NumLeavesPerAxis)
+		SHADER_PARAMETER(uint32, NumTriangles)
+		SHADER_PARAMETER(uint32, NumGroupsX)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), NavSvoGPUVoxelizer::ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FNavSvoVoxelizeCS, "/Plugin/Gunfire3DNavigation/Private/NavSvoVoxelize.usf", "VoxelizeCS", SF_Compute);
+
+// Dilates the voxels by one step, one thread per leaf
+class FNavSvoPadCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FNavSvoPadCS);
+	SHADER_USE_PARAMETER_STRUCT(FNavSvoPadCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, SrcVoxels)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, DstVoxels)
+		SHADER_PARAMETER(FIntVector, PadLeafMin)
+		SHADER_PARAMETER(FIntVector, PadLeafMax)
+		SHADER_PARAMETER(int32, NumLeavesPerAxis)
+		SHADER_PARAMETER(uint32, bClipToPadRange)
+		SHADER_PARAMETER(uint32, bPadXY)
+		SHADER_PARAMETER(uint32, bPadZ)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), NavSvoGPUVoxelizer::ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FNavSvoPadCS, "/Plugin/Gunfire3DNavigation/Private/NavSvoVoxelize.usf", "PadCS", SF_Compute);
+
+bool FNavSvoGPUVoxelizer::IsSupported()
+{
+	return GIsRHIInitialized && FApp::CanEverRender() && IsFeatureLevelSupported(GMaxRHIShaderPlatform, ERHIFeatureLevel::SM5);
+}
+
+static bool VoxelizeRenderThread(FRHICommandListImmediate& RHICmdList, const FNavSvoGPUVoxelizeParams& Params, TArray<uint64>& OutVoxels, TArray<uint64>& OutPaddedVoxels)
+{
+	using namespace NavSvoGPUVoxelizer;
+
+	const uint32 NumLeaves = Params.NumLeavesPerAxis * Params.NumLeavesPerAxis * Params.NumLeavesPerAxis;
+	const uint32 NumBytes = NumLeaves * sizeof(uint64);
+	const uint32 NumTriangles = Params.Vertices.Num() / 3;
+
+	FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(GMaxRHIFeatureLevel);
+	TShaderMapRef<FNavSvoVoxelizeCS> VoxelizeShader(ShaderMap);
+	TShaderMapRef<FNavSvoPadCS> PadShader(ShaderMap);
+
+	if (!VoxelizeShader.IsValid() || !PadShader.IsValid())
+	{
+		return false;
+	}
+
+	TUniquePtr<FRHIGPUBufferReadback> VoxelsReadback = MakeUnique<FRHIGPUBufferReadback>(TEXT("NavSvo.VoxelsReadback"));
+	TUniquePtr<FRHIGPUBufferReadback> PaddedReadback = MakeUnique<FRHIGPUBufferReadback>(TEXT("NavSvo.PaddedVoxelsReadback"));
+
+	{
+		FRDGBuilder GraphBuilder(RHICmdList);
+
+		// Each leaf is stored as a pair of 32-bit words, since 64-bit integers aren't
+		// available on every platform we compile for.
+		const FRDGBufferDesc VoxelsDesc = FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), NumLeaves * 2);
+
+		FRDGBufferRef Voxels = GraphBuilder.CreateBuffer(VoxelsDesc, TEXT("NavSvo.Voxels"));
+		if (Params.BaseVoxels.Num() == (int32)NumLeaves)
+		{
+			GraphBuilder.QueueBufferUpload(Voxels, Params.BaseVoxels.GetData(), NumBytes, ERDGInitialDataFlags::NoCopy);
+		}
+		else
+		{
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(Voxels), 0u);
+		}
+
+		if (NumTriangles > 0)
+		{
+			FRDGBufferRef Vertices = CreateStructuredBuffer(GraphBuilder, TEXT("NavSvo.Vertices"), sizeof(FVector3f), Params.Vertices.Num(), Params.Vertices.GetData(), Params.Vertices.Num() * sizeof(FVector3f), ERDGInitialDataFlags::NoCopy);
+
+			FNavSvoVoxelizeCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FNavSvoVoxelizeCS::FParameters>();
+			PassParameters->Vertices = GraphBuilder.CreateSRV(Vertices);
+			PassParameters->Voxels = GraphBuilder.CreateUAV(Voxels);
+			PassParameters->FillMin = Params.FillMin;
+			PassParameters->FillMax = Params.FillMax;
+			PassParameters->NumLeavesPerAxis = Params.NumLeavesPerAxis;
+			PassParameters->NumTriangles = NumTriangles;
+
+			const FIntVector GroupCount(FMath::Min<int32>(NumTriangles, MaxGroupsPerAxis), FMath::DivideAndRoundUp<int32>(NumTriangles, MaxGroupsPerAxis), 1);
+			PassParameters->NumGroupsX = GroupCount.X;
+
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("NavSvoVoxelize"), VoxelizeShader, PassParameters, GroupCount);
+		}
+
+		// The first pass drops anything outside the padded range, and every pass after
+		// grows the voxels by one step.
+		FRDGBufferRef PadBuffers[2] =
+		{
+			GraphBuilder.CreateBuffer(VoxelsDesc, TEXT("NavSvo.PaddedVoxels0")),
+			GraphBuilder.CreateBuffer(VoxelsDesc, TEXT("NavSvo.PaddedVoxels1")),
+		};
+
+		const int32 NumPasses = FMath::Max(Params.PaddingXY, Params.PaddingZ);
+		const FIntVector PadGroupCount = FComputeShaderUtils::GetGroupCount((int32)NumLeaves, ThreadGroupSize);
+
+		FRDGBufferRef Src = Voxels;
+		for (int32 PassIdx = 0; PassIdx <= NumPasses; ++PassIdx)
+		{
+			FRDGBufferRef Dst = PadBuffers[PassIdx & 1];
+
+			FNavSvoPadCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FNavSvoPadCS::FParameters>();
+			PassParameters->SrcVoxels = GraphBuilder.CreateSRV(Src);
+			PassParameters->DstVoxels = GraphBuilder.CreateUAV(Dst);
+			PassParameters->PadLeafMin = Params.PadLeafMin;
+			PassParameters->PadLeafMax = Params.PadLeafMax;
+			PassParameters->NumLeavesPerAxis = Params.NumLeavesPerAxis;
+			PassParameters->bClipToPadRange = (PassIdx == 0);
+			PassParameters->bPadXY = (PassIdx > 0 && PassIdx <= Params.PaddingXY);
+			PassParameters->bPadZ = (PassIdx > 0 && PassIdx <= Params.PaddingZ);
+
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("NavSvoPad"), PadShader, PassParameters, PadGroupCount);
+
+			Src = Dst;
+		}
+
+		AddEnqueueCopyPass(GraphBuilder, VoxelsReadback.Get(), Voxels, NumBytes);
+		AddEnqueueCopyPass(GraphBuilder, PaddedReadback.Get(), Src, NumBytes);
+
+		GraphBuilder.Execute();
+	}
+
+	// The generator is waiting on us anyway, so there's nothing to gain from letting the
+	// readback finish in the background.
+	RHICmdList.SubmitCommandsAndFlushGPU();
+	RHICmdList.BlockUntilGPUIdle();
+
+	if (!VoxelsReadback->IsReady() || !PaddedReadback->IsReady())
+	{
+		return false;
+	}
+
+	OutVoxels.SetNumUninitialized(NumLeaves);
+	FMemory::Memcpy(OutVoxels.GetData(), VoxelsReadback->Lock(NumBytes), NumBytes);
+	VoxelsReadback->Unlock();
+
+	OutPaddedVoxels.SetNumUninitialized(NumLeaves);
+	FMemory::Memcpy(OutPaddedVoxels.GetData(), PaddedReadback->Lock(NumBytes), NumBytes);
+	PaddedReadback->Unlock();
+
+	return true;
+}
+
+bool FNavSvoGPUVoxelizer::Voxelize(const FNavSvoGPUVoxelizeParams& Params, TArray<uint64>& OutVoxels, TArray<uint64>& OutPaddedVoxels)
+{
+	check(!IsInRenderingThread());
+
+	if (!IsSupported() || Params.NumLeavesPerAxis <= 0)
+	{
+		return false;
+	}
+
+	TPromise<bool> Promise;
+	TFuture<bool> Future = Promise.GetFuture();
+
+	// Everything is captured by reference, since we wait for the command to finish
+	ENQUEUE_RENDER_COMMAND(NavSvoVoxelize)(
+		[&Params, &OutVoxels, &OutPaddedVoxels, &Promise](FRHICommandListImmediate& RHICmdList)
+		{
+			Promise.SetValue(VoxelizeRenderThread(RHICmdList, Params, OutVoxels, OutPaddedVoxels));
+		});
+
+	return Future.Get();
+}
@@ -0,0 +1,53 @@
+// Copyright Gunfire Games, LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//
+// Voxelizes and pads the triangles of a tile with compute shaders, for speeding up
+// builds in the editor.
+//
+// The voxel grid is made of leaves of 4x4x4 voxels, each stored as a 64-bit mask. Unlike
+// the generator's buffers, everything here is in linear order: leaves are indexed by
+// (x + y * N + z * N * N) for N leaves per axis, and voxels within a leaf by
+// (x + 4 * y + 16 * z), matching how leaf nodes store their voxels.
+//
+struct FNavSvoGPUVoxelizeParams
+{
+	// Three vertices per triangle, in voxel space (1 unit = 1 voxel from the grid's min)
+	TArray<FVector3f> Vertices;
+
+	// Voxels set before any triangles are added (e.g. from blockers). Either empty or
+	// one mask per leaf.
+	TArray<uint64> BaseVoxels;
+
+	// Leaves per axis of the grid
+	int32 NumLeavesPerAxis = 0;
+
+	// Range of voxels triangles may fill, inclusive
+	FIntVector FillMin = FIntVector::ZeroValue;
+	FIntVector FillMax = FIntVector::ZeroValue;
+
+	// Range of leaves whose voxels are padded out, inclusive. Anything outside of it is
+	// dropped before padding.
+	FIntVector PadLeafMin = FIntVector::ZeroValue;
+	FIntVector PadLeafMax = FIntVector::ZeroValue;
+
+	// How many voxels to pad out by horizontally and vertically. Like the CPU padding,
+	// each step grows the voxels by one along each axis that still has padding left.
+	int32 PaddingXY = 0;
+	int32 PaddingZ = 0;
+};
+
+class GUNFIRE3DNAVIGATIONSHADERS_API FNavSvoGPUVoxelizer
+{
+public:
+	// Returns true if the GPU can be used for voxelizing
+	static bool IsSupported();
+
+	// Voxelizes the triangles, filling 'OutVoxels' with the voxels before padding and
+	// 'OutPaddedVoxels' with them after. Blocks until the GPU is done, so it must not be
+	// called from the rendering thread. Returns false if the GPU couldn't be used.
+	static bool Voxelize(const FNavSvoGPUVoxelizeParams& Params, TArray<uint64>& OutVoxels, TArray<uint64>& OutPaddedVoxels);
+};